@@ -26,6 +26,15 @@ CFLAGS += -Wall
 #####################################################################
 # TinyGL configuration 
 
+# Draw triangles with a pool of threads (see ZB_setThreads() in
+# src/ztile.c). Needs pthreads.
+#TINYGL_USE_THREADS=y
+
+ifdef TINYGL_USE_THREADS
+CFLAGS += -DTGL_FEATURE_THREADS=1
+THREAD_LIBS= -lpthread
+endif
+
 #####################################################################
 # Select window API for TinyGL: 
 
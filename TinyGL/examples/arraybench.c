@@ -0,0 +1,281 @@
+/*
+ * Measures the vertex throughput of the three ways of drawing from vertex
+ * arrays: glArrayElement between glBegin / glEnd, which queues one op per
+ * vertex, glDrawElements on the indexed arrays, and glDrawArrays on an
+ * unindexed copy of them. The mesh is a 64x32 torus, drawn as lit
+ * triangles, as colored triangles and as textured, colored strips, so
+ * that the transform, lighting and rasterization costs differ. All three
+ * methods must produce the same frames as glArrayElement.
+ *
+ * Environment variables, besides those of benchutil.h:
+ *   BENCH_FRAMES   # of frames per scene (default 100)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <GL/gl.h>
+#include <GL/oscontext.h>
+#include <GL/zgl.h>
+#include "benchutil.h"
+
+#define NU 64			/* vertices around the torus */
+#define NV 32			/* vertices around its tube */
+#define NB_VERTICES (NU * NV)
+#define NB_TRIANGLE_ELEMENTS (NU * NV * 6)
+#define STRIP_LENGTH (2 * (NU + 1))
+#define NB_STRIP_ELEMENTS (NV * STRIP_LENGTH)
+
+enum { LIGHTING = 1, COLORS = 2, TEXTURE = 4 };
+
+typedef struct {
+    const char *name;
+    int mode;
+    int flags;
+} Scene;
+
+static Scene scenes[] = {
+    { "lit triangles", GL_TRIANGLES, LIGHTING },
+    { "colored triangles", GL_TRIANGLES, COLORS },
+    { "textured strips", GL_TRIANGLE_STRIP, TEXTURE | COLORS },
+};
+
+enum { ARRAY_ELEMENT, DRAW_ELEMENTS, DRAW_ARRAYS, NB_METHODS };
+
+static const char *method_names[NB_METHODS] = {
+    "glArrayElement", "glDrawElements", "glDrawArrays",
+};
+
+/* the torus, indexed */
+static GLfloat vertices[NB_VERTICES * 3];
+static GLfloat normals[NB_VERTICES * 3];
+static GLfloat colors[NB_VERTICES * 3];
+static GLfloat tex_coords[NB_VERTICES * 2];
+static GLushort triangles[NB_TRIANGLE_ELEMENTS];
+static GLushort strips[NB_STRIP_ELEMENTS];
+
+/* and unindexed, for glDrawArrays */
+static GLfloat flat_vertices[NB_TRIANGLE_ELEMENTS * 3];
+static GLfloat flat_normals[NB_TRIANGLE_ELEMENTS * 3];
+static GLfloat flat_colors[NB_TRIANGLE_ELEMENTS * 3];
+static GLfloat flat_tex_coords[NB_TRIANGLE_ELEMENTS * 2];
+
+static void init_torus(void)
+{
+    double u, v, r;
+    int i, j, k, n;
+
+    for (j = 0; j < NV; j++) {
+	for (i = 0; i < NU; i++) {
+	    k = j * NU + i;
+	    u = i * 2 * M_PI / NU;
+	    v = j * 2 * M_PI / NV;
+	    r = 1.0 + 0.4 * cos(v);
+	    vertices[k * 3] = r * cos(u);
+	    vertices[k * 3 + 1] = r * sin(u);
+	    vertices[k * 3 + 2] = 0.4 * sin(v);
+	    normals[k * 3] = cos(v) * cos(u);
+	    normals[k * 3 + 1] = cos(v) * sin(u);
+	    normals[k * 3 + 2] = sin(v);
+	    colors[k * 3] = 0.5 + 0.5 * cos(u);
+	    colors[k * 3 + 1] = 0.5 + 0.5 * sin(v);
+	    colors[k * 3 + 2] = 0.5 + 0.5 * sin(u);
+	    tex_coords[k * 2] = (double) i / NU;
+	    tex_coords[k * 2 + 1] = (double) j / NV;
+	}
+    }
+
+    n = 0;
+    for (j = 0; j < NV; j++) {
+	for (i = 0; i < NU; i++) {
+	    triangles[n++] = j * NU + i;
+	    triangles[n++] = j * NU + (i + 1) % NU;
+	    triangles[n++] = (j + 1) % NV * NU + i;
+	    triangles[n++] = (j + 1) % NV * NU + i;
+	    triangles[n++] = j * NU + (i + 1) % NU;
+	    triangles[n++] = (j + 1) % NV * NU + (i + 1) % NU;
+	}
+    }
+
+    n = 0;
+    for (j = 0; j < NV; j++) {
+	for (i = 0; i <= NU; i++) {
+	    strips[n++] = (j + 1) % NV * NU + i % NU;
+	    strips[n++] = j * NU + i % NU;
+	}
+    }
+}
+
+/* unindexed copy of the elements */
+static void init_flat(const GLushort *elements, int nb_elements)
+{
+    int k, i;
+
+    for (k = 0; k < nb_elements; k++) {
+	i = elements[k];
+	memcpy(&flat_vertices[k * 3], &vertices[i * 3], 3 * sizeof(GLfloat));
+	memcpy(&flat_normals[k * 3], &normals[i * 3], 3 * sizeof(GLfloat));
+	memcpy(&flat_colors[k * 3], &colors[i * 3], 3 * sizeof(GLfloat));
+	memcpy(&flat_tex_coords[k * 2], &tex_coords[i * 2],
+	       2 * sizeof(GLfloat));
+    }
+}
+
+static void set_arrays(int flat)
+{
+    glVertexPointer(3, GL_FLOAT, 0, flat ? flat_vertices : vertices);
+    glNormalPointer(GL_FLOAT, 0, flat ? flat_normals : normals);
+    glColorPointer(3, GL_FLOAT, 0, flat ? flat_colors : colors);
+    glTexCoordPointer(2, GL_FLOAT, 0, flat ? flat_tex_coords : tex_coords);
+}
+
+static void init_scene(Scene *s)
+{
+    static GLfloat pos[4] = { 5.0, 5.0, 10.0, 0.0 };
+    static GLubyte texture[64 * 64 * 3];
+    int i;
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glColor3f(1.0, 1.0, 1.0);
+
+    if (s->flags & LIGHTING) {
+	glLightfv(GL_LIGHT0, GL_POSITION, pos);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_LIGHTING);
+	glEnableClientState(GL_NORMAL_ARRAY);
+    }
+    if (s->flags & COLORS)
+	glEnableClientState(GL_COLOR_ARRAY);
+    if (s->flags & TEXTURE) {
+	for (i = 0; i < 64 * 64 * 3; i++)
+	    texture[i] = ((i / 3 / 8) ^ (i / 3 / 64 / 8)) & 1 ? 255 : 64;
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 64, 64, 0, GL_RGB,
+		     GL_UNSIGNED_BYTE, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glEnable(GL_TEXTURE_2D);
+    }
+}
+
+static void draw(Scene *s, int method, int frame)
+{
+    const GLushort *elements;
+    int nb_draws, length, i, j;
+
+    if (s->mode == GL_TRIANGLES) {
+	elements = triangles;
+	nb_draws = 1;
+	length = NB_TRIANGLE_ELEMENTS;
+    } else {
+	elements = strips;
+	nb_draws = NV;
+	length = STRIP_LENGTH;
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glPushMatrix();
+    glRotatef(frame * 3.0, 1.0, 0.0, 0.0);
+    glRotatef(frame * 2.0, 0.0, 1.0, 0.0);
+
+    for (i = 0; i < nb_draws; i++) {
+	switch (method) {
+	case ARRAY_ELEMENT:
+	    glBegin(s->mode);
+	    for (j = 0; j < length; j++)
+		glArrayElement(elements[i * length + j]);
+	    glEnd();
+	    break;
+	case DRAW_ELEMENTS:
+	    glDrawElements(s->mode, length, GL_UNSIGNED_SHORT,
+			   elements + i * length);
+	    break;
+	case DRAW_ARRAYS:
+	    glDrawArrays(s->mode, i * length, length);
+	    break;
+	}
+    }
+
+    glPopMatrix();
+    ZB_flush(gl_get_context()->zb);
+}
+
+int main(int argc, char **argv)
+{
+    ostgl_context *ctx;
+    double t0, t[NB_METHODS], nb_elements;
+    unsigned int sum[NB_METHODS];
+    void *fb;
+    int xsize, ysize, nb_frames, i, j, m, ok;
+
+    nb_frames = bench_frames(100);
+    bench_size(&xsize, &ysize);
+    xsize &= ~3;
+
+    fb = gl_malloc(xsize * ysize * 2);
+    ctx = ostgl_create_context(xsize, ysize, 16, &fb, 1);
+    ostgl_make_current(ctx, 0);
+    glViewport(0, 0, xsize, ysize);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glShadeModel(GL_SMOOTH);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glFrustum(-1.0, 1.0, -(double) ysize / xsize, (double) ysize / xsize,
+	      2.0, 20.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(0.0, 0.0, -4.0);
+
+    init_torus();
+
+    printf("arrays: %dx%d, %d vertices, %d frames\n",
+	   xsize, ysize, NB_VERTICES, nb_frames);
+    printf("scene              method          Mvert/s  speedup  checksum\n");
+
+    ok = 1;
+    for (i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+	if (scenes[i].mode == GL_TRIANGLES) {
+	    init_flat(triangles, NB_TRIANGLE_ELEMENTS);
+	    nb_elements = NB_TRIANGLE_ELEMENTS;
+	} else {
+	    init_flat(strips, NB_STRIP_ELEMENTS);
+	    nb_elements = NB_STRIP_ELEMENTS;
+	}
+	init_scene(&scenes[i]);
+
+	/* one frame of each in turn, so that all see the same machine */
+	for (m = 0; m < NB_METHODS; m++) {
+	    t[m] = 0;
+	    sum[m] = 0;
+	}
+	for (j = 0; j < nb_frames; j++) {
+	    for (m = 0; m < NB_METHODS; m++) {
+		set_arrays(m == DRAW_ARRAYS);
+		t0 = bench_time();
+		draw(&scenes[i], m, j);
+		t[m] += bench_time() - t0;
+		sum[m] = bench_checksum(sum[m], gl_get_context()->zb);
+	    }
+	}
+
+	for (m = 0; m < NB_METHODS; m++) {
+	    printf("%-18s %-14s %8.2f %7.2fx  %08x%s\n",
+		   m == 0 ? scenes[i].name : "", method_names[m],
+		   nb_elements * nb_frames / t[m] / 1e6, t[0] / t[m], sum[m],
+		   sum[m] == sum[0] ? "" : "  MISMATCH");
+	    if (sum[m] != sum[0])
+		ok = 0;
+	}
+    }
+
+    ostgl_delete_context(ctx);
+    gl_free(fb);
+    return ok ? 0 : 1;
+}
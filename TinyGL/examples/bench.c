@@ -0,0 +1,137 @@
+/*
+ * Headless ui for gears and mech, linked as gears-bench and mech-bench:
+ * measures how the frame rate of the example scales with the number of
+ * rasterizer threads (see ZB_setThreads()). The frames are drawn off
+ * screen, first with no threads, then with 1, 2, 4, ... threads, each
+ * run in a fresh child process so they all start from the same state.
+ * A thread count that draws different frames from the first run is
+ * reported as a mismatch.
+ *
+ * Environment variables, besides those of benchutil.h:
+ *   BENCH_FRAMES   default 300
+ *   BENCH_THREADS  max # of threads (default: # of processors)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <GL/gl.h>
+#include <GL/oscontext.h>
+#include <GL/zgl.h>
+#include "ui.h"
+#include "benchutil.h"
+
+static unsigned int checksum;
+
+void tkSwapBuffers(void)
+{
+    ZBuffer *zb = gl_get_context()->zb;
+
+    ZB_flush(zb);
+    checksum = bench_checksum(checksum, zb);
+}
+
+typedef struct {
+    double fps;
+    unsigned int checksum;
+} BenchResult;
+
+/* draw the frames in a child process, so that each run starts the same */
+static int run(int nb_threads, int nb_frames, BenchResult *r)
+{
+    double t0;
+    int fd[2], status, i;
+    pid_t pid;
+
+    if (pipe(fd) != 0) {
+	perror("pipe");
+	return -1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+	perror("fork");
+	return -1;
+    }
+    if (pid == 0) {
+	close(fd[0]);
+	ZB_setThreads(gl_get_context()->zb, nb_threads);
+	checksum = 0;
+	t0 = bench_time();
+	for (i = 0; i < nb_frames; i++)
+	    idle();
+	r->fps = nb_frames / (bench_time() - t0);
+	r->checksum = checksum;
+	write(fd[1], r, sizeof(*r));
+	_exit(0);
+    }
+
+    close(fd[1]);
+    i = read(fd[0], r, sizeof(*r));
+    close(fd[0]);
+    waitpid(pid, &status, 0);
+    return i == sizeof(*r) ? 0 : -1;
+}
+
+int ui_loop(int argc, char **argv, const char *name)
+{
+    ostgl_context *ctx;
+    BenchResult r, r0;
+    void *fb;
+    char *s, label[16];
+    int xsize, ysize, nb_frames, max_threads, n, ok;
+
+    nb_frames = bench_frames(300);
+    bench_size(&xsize, &ysize);
+    max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if ((s = getenv("BENCH_THREADS")) != NULL)
+	max_threads = atoi(s);
+    if (max_threads < 1)
+	max_threads = 1;
+    xsize &= ~3;
+
+    fb = gl_malloc(xsize * ysize * 2);
+    ctx = ostgl_create_context(xsize, ysize, 16, &fb, 1);
+    ostgl_make_current(ctx, 0);
+    glViewport(0, 0, xsize, ysize);
+
+    init();
+    reshape(xsize, ysize);
+
+    printf("%s: %dx%d, %d frames\n", name, xsize, ysize, nb_frames);
+    printf("threads      fps  speedup  checksum\n");
+
+    ok = 1;
+    n = 0;
+    for (;;) {
+	if (run(n, nb_frames, &r) != 0) {
+	    fprintf(stderr, "%s: run with %d threads failed\n", name, n);
+	    return 1;
+	}
+	if (n == 0) {
+	    r0 = r;
+	    strcpy(label, "-");
+	} else {
+	    sprintf(label, "%d", n);
+	}
+	printf("%7s %8.1f %7.2fx  %08x%s\n", label, r.fps, r.fps / r0.fps,
+	       r.checksum, r.checksum == r0.checksum ? "" : "  MISMATCH");
+	if (r.checksum != r0.checksum)
+	    ok = 0;
+
+	/* 1, 2, 4, ... and max_threads */
+	if (n == max_threads)
+	    break;
+	n = n == 0 ? 1 : n * 2;
+	if (n > max_threads)
+	    n = max_threads;
+    }
+
+    ostgl_delete_context(ctx);
+    gl_free(fb);
+    return ok ? 0 : 1;
+}
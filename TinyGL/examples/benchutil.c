@@ -0,0 +1,67 @@
+/*
+ * Helpers shared by the headless benchmarks (see benchutil.h)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "benchutil.h"
+
+/* BENCH_FRAMES, or nb_frames if it is not set */
+int bench_frames(int nb_frames)
+{
+    char *s;
+
+    if ((s = getenv("BENCH_FRAMES")) != NULL)
+	nb_frames = atoi(s);
+    return nb_frames;
+}
+
+void bench_size(int *xsize, int *ysize)
+{
+    char *s;
+
+    *xsize = 800;
+    *ysize = 600;
+    if ((s = getenv("BENCH_SIZE")) != NULL)
+	sscanf(s, "%dx%d", xsize, ysize);
+}
+
+/* wall clock time in seconds */
+double bench_time(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* adds the color and Z buffers to a running checksum */
+unsigned int bench_checksum(unsigned int sum, ZBuffer *zb)
+{
+    unsigned short *p;
+    int i, n;
+
+    p = (unsigned short *) zb->pbuf;
+    n = zb->ysize * zb->linesize / 2;
+    for (i = 0; i < n; i++)
+	sum = sum * 31 + p[i];
+    p = zb->zbuf;
+    n = zb->ysize * zb->xsize;
+    for (i = 0; i < n; i++)
+	sum = sum * 31 + p[i];
+    return sum;
+}
+
+/* adds 32 bit pixels in the precision of 5R6G5B, so that a display drawn
+   in 16 bits and one drawn in 32 bits can be compared */
+unsigned int bench_checksum_rgb565(unsigned int sum, unsigned int *pixels,
+				   int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+	sum = sum * 31 + (pixels[i] & 0xF8FCF8);
+    return sum;
+}
@@ -0,0 +1,15 @@
+/*
+ * Helpers shared by the headless benchmarks
+ *
+ * Environment variables:
+ *   BENCH_FRAMES   # of frames (the default depends on the benchmark)
+ *   BENCH_SIZE     size of the frame buffer, WxH (default 800x600)
+ */
+#include <GL/zbuffer.h>
+
+int bench_frames(int nb_frames);
+void bench_size(int *xsize, int *ysize);
+double bench_time(void);
+unsigned int bench_checksum(unsigned int sum, ZBuffer *zb);
+unsigned int bench_checksum_rgb565(unsigned int sum, unsigned int *pixels,
+				   int n);
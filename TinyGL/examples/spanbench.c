@@ -0,0 +1,155 @@
+/*
+ * Measures the fill rate, in pixels/sec, of each ZB_fillTriangle*
+ * rasterizer with the scalar inner loops and with the SIMD span fillers
+ * of src/zspan.c. A fixed set of random triangles, mostly small and one
+ * in ten large, is drawn straight into a 16 bit Z buffer with no GL
+ * state in between. The two versions of a rasterizer must leave
+ * identical color and Z buffers.
+ *
+ * Environment variables, besides those of benchutil.h:
+ *   BENCH_FRAMES   # of times the triangles are drawn (default 50)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/zbuffer.h>
+#include "benchutil.h"
+
+#define NB_TRIANGLES 2000
+
+typedef struct {
+    const char *name;
+    ZB_fillTriangleFunc fill;
+} SpanType;
+
+static SpanType span_types[] = {
+    { "flat", ZB_fillTriangleFlat },
+    { "smooth", ZB_fillTriangleSmooth },
+    { "mapping", ZB_fillTriangleMapping },
+    { "perspective", ZB_fillTriangleMappingPerspective },
+};
+
+static ZBufferPoint points[NB_TRIANGLES][3];
+static double nb_pixels;
+
+static unsigned int seed = 1;
+
+static int rnd(int min, int max)
+{
+    seed = seed * 1103515245 + 12345;
+    return min + (int) ((seed >> 8) % (unsigned int) (max - min + 1));
+}
+
+static void init_triangles(int xsize, int ysize)
+{
+    ZBufferPoint *p;
+    int i, j, cx, cy, r;
+
+    nb_pixels = 0;
+    for (i = 0; i < NB_TRIANGLES; i++) {
+	/* mostly small triangles, as in a real scene, a few big ones */
+	r = rnd(0, 9) == 0 ? ysize / 2 : rnd(4, 40);
+	cx = rnd(0, xsize - 1);
+	cy = rnd(0, ysize - 1);
+	for (j = 0; j < 3; j++) {
+	    p = &points[i][j];
+	    p->x = cx + rnd(-r, r);
+	    p->y = cy + rnd(-r, r);
+	    if (p->x < 0) p->x = 0;
+	    if (p->x >= xsize) p->x = xsize - 1;
+	    if (p->y < 0) p->y = 0;
+	    if (p->y >= ysize) p->y = ysize - 1;
+	    p->z = rnd(1 << ZB_POINT_Z_FRAC_BITS, (1 << 30) - 1);
+	    p->r = rnd(ZB_POINT_RED_MIN, ZB_POINT_RED_MAX);
+	    p->g = rnd(ZB_POINT_GREEN_MIN, ZB_POINT_GREEN_MAX);
+	    p->b = rnd(ZB_POINT_BLUE_MIN, ZB_POINT_BLUE_MAX);
+	    p->s = rnd(ZB_POINT_S_MIN, ZB_POINT_S_MAX);
+	    p->t = rnd(ZB_POINT_T_MIN, ZB_POINT_T_MAX);
+	}
+	p = points[i];
+	nb_pixels += abs((p[1].x - p[0].x) * (p[2].y - p[0].y) -
+			 (p[2].x - p[0].x) * (p[1].y - p[0].y)) / 2.0;
+    }
+}
+
+/* draws the triangles once, returns the time it took */
+static double draw(ZBuffer *zb, ZB_fillTriangleFunc fill)
+{
+    ZBufferPoint p0, p1, p2;
+    double t0;
+    int i;
+
+    ZB_clear(zb, 1, 0, 1, 0, 0, 0);
+    t0 = bench_time();
+    for (i = 0; i < NB_TRIANGLES; i++) {
+	/* the perspective mapping writes to the points */
+	p0 = points[i][0];
+	p1 = points[i][1];
+	p2 = points[i][2];
+	fill(zb, &p0, &p1, &p2);
+    }
+    return bench_time() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    ZBuffer *zb;
+    const ZBSpans *simd;
+    PIXEL *texture;
+    double t0, t1;
+    unsigned int sum;
+    int xsize, ysize, nb_frames, i, j, same, ok;
+
+    nb_frames = bench_frames(50);
+    bench_size(&xsize, &ysize);
+
+    zb = ZB_open(xsize, ysize, ZB_MODE_5R6G5B, 0, NULL, NULL, NULL);
+    if (zb == NULL) {
+	fprintf(stderr, "spanbench: could not open the Z buffer\n");
+	return 1;
+    }
+    simd = ZB_simdSpans();
+    if (simd == NULL) {
+	fprintf(stderr, "spanbench: no SIMD span fillers on this CPU\n");
+	return 1;
+    }
+
+    texture = (PIXEL *) gl_malloc(256 * 256 * sizeof(PIXEL));
+    for (i = 0; i < 256 * 256; i++)
+	texture[i] = rnd(0, 0xFFFF);
+    ZB_setTexture(zb, texture);
+
+    init_triangles(xsize, ysize);
+
+    printf("spans: %dx%d, %d triangles, %d frames\n",
+	   xsize, ysize, NB_TRIANGLES, nb_frames);
+    printf("span         scalar Mpix/s   simd Mpix/s  speedup\n");
+
+    ok = 1;
+    for (i = 0; i < sizeof(span_types) / sizeof(span_types[0]); i++) {
+	/* one frame of each in turn, so that both see the same machine */
+	t0 = t1 = 0;
+	same = 1;
+	for (j = 0; j < nb_frames; j++) {
+	    zb->spans = NULL;
+	    t0 += draw(zb, span_types[i].fill);
+	    sum = bench_checksum(0, zb);
+	    zb->spans = simd;
+	    t1 += draw(zb, span_types[i].fill);
+	    if (bench_checksum(0, zb) != sum)
+		same = 0;
+	}
+	printf("%-12s %14.1f %13.1f %7.2fx%s\n", span_types[i].name,
+	       nb_pixels * nb_frames / t0 / 1e6,
+	       nb_pixels * nb_frames / t1 / 1e6, t0 / t1,
+	       same ? "" : "  MISMATCH");
+	if (!same)
+	    ok = 0;
+    }
+
+    gl_free(texture);
+    ZB_close(zb);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+/*
+ * Measures the cost of texture mapping on a 32 bit display, per texture
+ * filter: frames/sec when rendering in 16 bits and converting each frame
+ * to 32 bits (ZB_MODE_RGBA), against rendering in 32 bits directly
+ * (ZB_MODE_ARGB32), so the conversion is included in the time. Two scenes
+ * load the texture fetch differently:
+ *
+ *   floor   a 1024x1024 texture on a plane going away from the eye,
+ *           mostly minified
+ *   wall    a 64x64 texture on a square turning in front of the eye,
+ *           magnified
+ *
+ * With GL_NEAREST both must show the same display in 5R6G5B precision,
+ * the filtered ones may round differently.
+ *
+ * Environment variables, besides those of benchutil.h:
+ *   BENCH_FRAMES   # of frames per scene and filter (default 100)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/gl.h>
+#include <GL/zgl.h>
+#include "benchutil.h"
+
+#define GRID 16			/* quads along each side of the floor */
+
+enum { FLOOR, WALL, NB_SCENES };
+
+static const char *scene_names[NB_SCENES] = { "floor", "wall" };
+
+typedef struct {
+    const char *name;
+    int min_filter, mag_filter;
+} Filter;
+
+static Filter filters[] = {
+    { "GL_NEAREST", GL_NEAREST, GL_NEAREST },
+    { "GL_LINEAR", GL_LINEAR, GL_LINEAR },
+    { "GL_NEAREST_MIPMAP_NEAREST", GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST },
+    { "GL_LINEAR_MIPMAP_NEAREST", GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR },
+};
+
+#define NB_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+enum { CONVERT, DIRECT, NB_FORMATS };
+
+static const int format_modes[NB_FORMATS] = {
+    ZB_MODE_RGBA, ZB_MODE_ARGB32,
+};
+
+static GLuint textures[NB_SCENES];
+
+static void make_texture(GLuint texture, int size, int square)
+{
+    GLubyte *pixels, *p;
+    int x, y, c;
+
+    pixels = (GLubyte *) gl_malloc(size * size * 3);
+    p = pixels;
+    for (y = 0; y < size; y++) {
+	for (x = 0; x < size; x++) {
+	    c = ((x / square) ^ (y / square)) & 1 ? 255 : 96;
+	    p[0] = c * x / size;
+	    p[1] = c;
+	    p[2] = c * y / size;
+	    p += 3;
+	}
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, 3, size, size, 0, GL_RGB,
+		 GL_UNSIGNED_BYTE, pixels);
+    gl_free(pixels);
+}
+
+static void draw(int scene, int frame)
+{
+    int i, j;
+    float x0, x1, z0, z1;
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindTexture(GL_TEXTURE_2D, textures[scene]);
+    glPushMatrix();
+    if (scene == FLOOR) {
+	glRotatef(frame * 0.5 - 25.0, 0.0, 1.0, 0.0);
+	glBegin(GL_QUADS);
+	for (j = 0; j < GRID; j++) {
+	    for (i = 0; i < GRID; i++) {
+		x0 = -20.0 + 40.0 * i / GRID;
+		x1 = -20.0 + 40.0 * (i + 1) / GRID;
+		z0 = 20.0 - 40.0 * j / GRID;
+		z1 = 20.0 - 40.0 * (j + 1) / GRID;
+		glTexCoord2f((float) i / GRID, (float) j / GRID);
+		glVertex3f(x0, -1.0, z0);
+		glTexCoord2f((float) (i + 1) / GRID, (float) j / GRID);
+		glVertex3f(x1, -1.0, z0);
+		glTexCoord2f((float) (i + 1) / GRID, (float) (j + 1) / GRID);
+		glVertex3f(x1, -1.0, z1);
+		glTexCoord2f((float) i / GRID, (float) (j + 1) / GRID);
+		glVertex3f(x0, -1.0, z1);
+	    }
+	}
+	glEnd();
+    } else {
+	glTranslatef(0.0, 0.0, -3.0);
+	glRotatef(frame * 2.0, 0.0, 0.0, 1.0);
+	glRotatef(30.0, 1.0, 0.0, 0.0);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0);
+	glVertex3f(-2.0, -2.0, 0.0);
+	glTexCoord2f(1.0, 0.0);
+	glVertex3f(2.0, -2.0, 0.0);
+	glTexCoord2f(1.0, 1.0);
+	glVertex3f(2.0, 2.0, 0.0);
+	glTexCoord2f(0.0, 1.0);
+	glVertex3f(-2.0, 2.0, 0.0);
+	glEnd();
+    }
+    glPopMatrix();
+}
+
+int main(int argc, char **argv)
+{
+    ZBuffer *zb;
+    double t0, t[NB_SCENES][NB_FILTERS][NB_FORMATS];
+    unsigned int sum[NB_SCENES][NB_FILTERS][NB_FORMATS];
+    unsigned int *display;
+    int xsize, ysize, nb_frames, i, j, k, f, ok;
+
+    nb_frames = bench_frames(100);
+    bench_size(&xsize, &ysize);
+    xsize &= ~3;
+
+    display = (unsigned int *) gl_malloc(xsize * ysize * 4);
+
+    /* the textures are in the format of the Z buffer: one context each */
+    for (f = 0; f < NB_FORMATS; f++) {
+	zb = ZB_open(xsize, ysize, format_modes[f], 0, NULL, NULL,
+		     f == DIRECT ? display : NULL);
+	if (zb == NULL) {
+	    fprintf(stderr, "texbench: cannot open the Z buffer\n");
+	    return 1;
+	}
+	glInit(zb);
+	glViewport(0, 0, xsize, ysize);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glFrustum(-1.0, 1.0, -(double) ysize / xsize, (double) ysize / xsize,
+		  1.0, 50.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	glGenTextures(NB_SCENES, textures);
+	make_texture(textures[FLOOR], 1024, 32);
+	make_texture(textures[WALL], 64, 8);
+
+	for (i = 0; i < NB_SCENES; i++) {
+	    for (j = 0; j < NB_FILTERS; j++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				filters[j].min_filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+				filters[j].mag_filter);
+		t[i][j][f] = 0;
+		sum[i][j][f] = 0;
+		for (k = 0; k < nb_frames; k++) {
+		    t0 = bench_time();
+		    draw(i, k);
+		    /* a 32 bit display: converted from 16 bits, or nothing
+		       to do */
+		    if (f == CONVERT)
+			ZB_copyFrameBuffer(zb, display, xsize * 2);
+		    else
+			ZB_copyFrameBuffer(zb, display, xsize * 4);
+		    t[i][j][f] += bench_time() - t0;
+		    sum[i][j][f] = bench_checksum_rgb565(sum[i][j][f], display,
+							 xsize * ysize);
+		}
+	    }
+	}
+
+	glDeleteTextures(NB_SCENES, textures);
+	glClose();
+	ZB_close(zb);
+    }
+
+    printf("textures: %dx%d, %d frames\n", xsize, ysize, nb_frames);
+    printf("scene  filter                     16 bit+copy    argb32  "
+	   "speedup  checksums\n");
+    ok = 1;
+    for (i = 0; i < NB_SCENES; i++) {
+	for (j = 0; j < NB_FILTERS; j++) {
+	    printf("%-6s %-26s %11.1f %9.1f %7.2fx  %08x %08x%s\n",
+		   j == 0 ? scene_names[i] : "", filters[j].name,
+		   nb_frames / t[i][j][CONVERT], nb_frames / t[i][j][DIRECT],
+		   t[i][j][CONVERT] / t[i][j][DIRECT],
+		   sum[i][j][CONVERT], sum[i][j][DIRECT],
+		   filters[j].min_filter == GL_NEAREST &&
+		   sum[i][j][CONVERT] != sum[i][j][DIRECT] ? "  MISMATCH" : "");
+	    if (filters[j].min_filter == GL_NEAREST &&
+		sum[i][j][CONVERT] != sum[i][j][DIRECT])
+		ok = 0;
+	}
+    }
+
+    gl_free(display);
+    return ok ? 0 : 1;
+}
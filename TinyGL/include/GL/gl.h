@@ -797,6 +797,9 @@ void glFrontFace(int mode);
 void glEnableClientState(GLenum array);
 void glDisableClientState(GLenum array);
 void glArrayElement(GLint i);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type,
+                    const GLvoid *indices);
 void glVertexPointer(GLint size, GLenum type, GLsizei stride, 
                      const GLvoid *pointer);
 void glColorPointer(GLint size, GLenum type, GLsizei stride, 
@@ -60,12 +60,15 @@ ADD_OP(NextBuffer,1,"%p")
 ADD_OP(ArrayElement, 1, "%d")
 ADD_OP(EnableClientState, 1, "%C")
 ADD_OP(DisableClientState, 1, "%C")
-ADD_OP(VertexPointer, 4, "%d %C %d %p")
-ADD_OP(ColorPointer, 4, "%d %C %d %p")
-ADD_OP(NormalPointer, 3, "%C %d %p")
-ADD_OP(TexCoordPointer, 4, "%d %C %d %p")
+ADD_OP(VertexPointer, 3, "%d %d %p")
+ADD_OP(ColorPointer, 3, "%d %d %p")
+ADD_OP(NormalPointer, 2, "%d %p")
+ADD_OP(TexCoordPointer, 3, "%d %d %p")
 
 /* opengl 1.1 polygon offset */
 ADD_OP(PolygonOffset, 2, "%f %f")
 
+/* compiled display lists */
+ADD_OP(DrawPacked, 1, "%p")
+
 #undef ADD_OP
@@ -25,6 +25,7 @@ extern sdl_swgl_Context *sdl_swgl_CreateContext ();
 extern void              sdl_swgl_DestroyContext( sdl_swgl_Context *ctx );
 extern int               sdl_swgl_MakeCurrent   ( SDL_Surface *surface, sdl_swgl_Context *ctx );
 extern void              sdl_swgl_SwapBuffers   ();
+extern int               sdl_swgl_SetThreads    ( int nb_threads );
 
 
 #ifdef __cplusplus
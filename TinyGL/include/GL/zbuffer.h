@@ -30,6 +30,7 @@
 #define ZB_MODE_INDEX   2  /* color index 8 bits */
 #define ZB_MODE_RGBA    3  /* 32 bit rgba mode */
 #define ZB_MODE_RGB24   4  /* 24 bit rgb mode */
+#define ZB_MODE_ARGB32  5  /* 32 bit ARGB rendering, no conversion */
 #define ZB_NB_COLORS    225 /* number of colors for 8 bit display */
 
 #if TGL_FEATURE_RENDER_BITS == 15
@@ -73,10 +74,48 @@ typedef unsigned int PIXEL;
 
 #endif
 
+/* pixels of ZB_MODE_ARGB32 */
+#if TGL_FEATURE_RENDER_BITS != 16
+#undef TGL_FEATURE_RENDER_32
+#define TGL_FEATURE_RENDER_32 0
+#endif
+
+#define RGB_TO_PIXEL32(r,g,b) \
+  ((((r) << 8) & 0xff0000) | ((g) & 0xff00) | ((b) >> 8))
+typedef unsigned int PIXEL32;
+
+/*
+ * A texture level of the mapping triangle functions: 2^wbits x 2^hbits
+ * texels (4 x 4 at least, the smaller levels are stretched), in the
+ * pixel format of the Z buffer. The texels are stored in tiles of 4 x 4,
+ * so that the texels around a pixel are in a few cache lines whatever
+ * the direction the texture is walked in.
+ */
+#define ZB_TEXTURE_MAX_BITS 10
+
+#define ZB_TILE_INDEX(x,y,wbits) \
+  ((((y) & ~3) << (wbits)) | (((x) & ~3) << 2) | (((y) & 3) << 2) | ((x) & 3))
+
+typedef struct ZBTexture {
+    void *pixmap;
+    int wbits,hbits;
+    int linear;               /* bilinear filtering */
+    /* ZB_TILE_INDEX() straight from s and t, see ZB_TEXEL() */
+    int shift[4];
+    unsigned int mask[4];
+} ZBTexture;
+
+#define ZB_TEXEL(tex,s,t) \
+  ((((s) >> (tex)->shift[0]) & (tex)->mask[0]) | \
+   (((s) >> (tex)->shift[1]) & (tex)->mask[1]) | \
+   (((t) >> (tex)->shift[2]) & (tex)->mask[2]) | \
+   (((t) >> (tex)->shift[3]) & (tex)->mask[3]))
+
 typedef struct {
     int xsize,ysize;
     int linesize; /* line size, in bytes */
     int mode;
+    int psize;    /* bytes per pixel: PSZB, or 4 in ZB_MODE_ARGB32 */
     
     unsigned short *zbuf;
     PIXEL *pbuf;
@@ -85,7 +124,14 @@ typedef struct {
     int nb_colors;
     unsigned char *dctable;
     int *ctable;
-    PIXEL *current_texture;
+    ZBTexture current_texture;
+
+    /* the triangle code only draws the scanlines ymin..ymax-1 */
+    int ymin,ymax;
+    /* deferred rendering state, NULL if triangles are drawn at once */
+    struct ZBTiles *tiles;
+    /* SIMD span fillers, NULL to use the scalar code */
+    const struct ZBSpans *spans;
 } ZBuffer;
 
 typedef struct {
@@ -130,6 +176,8 @@ void ZB_line_z(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2);
 /* ztriangle.c */
 
 void ZB_setTexture(ZBuffer *zb, PIXEL *texture);
+void ZB_setTextureLevel(ZBuffer *zb, void *pixmap, int wbits, int hbits,
+			int linear);
 
 void ZB_fillTriangleFlat(ZBuffer *zb,
 		 ZBufferPoint *p1,ZBufferPoint *p2,ZBufferPoint *p3);
@@ -147,6 +195,45 @@ void ZB_fillTriangleMappingPerspective(ZBuffer *zb,
 typedef void (*ZB_fillTriangleFunc)(ZBuffer  *,
 	    ZBufferPoint *,ZBufferPoint *,ZBufferPoint *);
 
+/* ztile.c */
+
+/* height of the bands of scanlines triangles are binned into */
+#define ZB_TILE_LINES 32
+/* max # of triangles waiting to be drawn */
+#define ZB_TILE_MAX_TRIANGLES 4096
+
+int ZB_setThreads(ZBuffer *zb, int nb_threads);
+void ZB_binTriangle(ZBuffer *zb, ZB_fillTriangleFunc fill,
+		    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_flush(ZBuffer *zb);
+
+/* zspan.c */
+
+/* x gradients of ZB_fillTriangleMappingPerspective(), 'n' for 8 pixels */
+typedef struct ZBSpanGradients {
+    ffp dszdx,dtzdx,ndszdx,ndtzdx;
+    GLfloat fdzdx,fndzdx;
+} ZBSpanGradients;
+
+/* draw n pixels of a scanline, see ztriangle.c for the arguments */
+typedef struct ZBSpans {
+    void (*flat)(PIXEL *pp, unsigned short *pz, int n,
+		 unsigned int z, int dzdx, PIXEL color);
+    void (*smooth)(PIXEL *pp, unsigned short *pz, int n,
+		   unsigned int z, int dzdx,
+		   unsigned int rgb, unsigned int drgbdx);
+    void (*mapping)(PIXEL *pp, unsigned short *pz, int n,
+		    unsigned int z, int dzdx,
+		    unsigned int s, int dsdx, unsigned int t, int dtdx,
+		    const ZBTexture *texture);
+    void (*perspective)(PIXEL *pp, unsigned short *pz, int n,
+			unsigned int z, int dzdx, ffp sz, ffp tz,
+			const ZBSpanGradients *g, const ZBTexture *texture);
+} ZBSpans;
+
+/* the span fillers the CPU can run, or NULL */
+const ZBSpans *ZB_simdSpans(void);
+
 /* memory.c */
 void gl_free(void *p);
 void *gl_malloc(int size);
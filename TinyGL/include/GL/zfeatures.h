@@ -8,6 +8,38 @@
 #define TGL_FEATURE_DISPLAYLISTS   1
 #define TGL_FEATURE_POLYGON_OFFSET 1
 
+/* display lists optimized at glEndList() (see listopt.c): faster
+   glCallList(), for some more memory per list. */
+#ifndef TGL_FEATURE_LIST_OPT
+#define TGL_FEATURE_LIST_OPT       1
+#endif
+
+/* deferred rendering: triangles are binned into bands of scanlines and
+   drawn by a pool of threads (see ZB_setThreads()). Needs pthreads, so
+   it is normally enabled from config.mk. */
+#ifndef TGL_FEATURE_THREADS
+#define TGL_FEATURE_THREADS        0
+#endif
+
+/* SIMD span fillers (see zspan.c). Only SSE2 for now, on x86-64 or
+   i386 with -msse2 -mfpmath=sse (x87 math would not give the same
+   perspective mapping as the scalar code). */
+#ifndef TGL_FEATURE_SIMD
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2_MATH__))
+#define TGL_FEATURE_SIMD           1
+#else
+#define TGL_FEATURE_SIMD           0
+#endif
+#endif
+
+/* 32 bit ARGB rendering, selected at run time by opening the Z buffer
+   in ZB_MODE_ARGB32 (see ZB_open()): the frame buffer can then be the
+   one of a 32 bit display, with nothing to convert. Only with
+   TGL_FEATURE_RENDER_BITS 16, which stays the default format. */
+#ifndef TGL_FEATURE_RENDER_32
+#define TGL_FEATURE_RENDER_32      1
+#endif
+
 /*
  * Matrix of internal and external pixel formats supported. 'Y' means
  * supported.
@@ -0,0 +1,420 @@
+/*
+ * The triangle functions for one pixel format, included by ztriangle.c
+ * with:
+ *
+ *   FILL(name)        name of the functions
+ *   PIXEL, PSZB, RGB_TO_PIXEL   the pixel format
+ *   ZB_FILL_BITS      16 (5R6G5B) or 32 (ARGB)
+ *   ZB_FILL_SPANS     defined if the SIMD span fillers can be used
+ */
+
+/*
+ * Bilinear filtering: the 4 texels around s, t (texel centers at
+ * half-integers, as the nearest texel is the one s, t fall in) are
+ * weighted by the fractions of s and t. The components are spread out in
+ * an int so that the 3 of them are weighted at once.
+ */
+#if ZB_FILL_BITS == 16
+
+#define TEXEL_FRAC(f) ((f) >> 3)
+#define TEXEL_SPREAD(c) (((c) | ((c) << 16)) & 0x07E0F81F)
+#define TEXEL_LERP(a,b,f) \
+  ((((a) * (32 - (f)) + (b) * (f)) >> 5) & 0x07E0F81F)
+#define TEXEL_PACK(c) ((c) | ((c) >> 16))
+
+#else
+
+#define TEXEL_FRAC(f) (f)
+#define TEXEL_SPREAD(c) (c)
+#define TEXEL_LERP(a,b,f) \
+  (((((a) & 0x00FF00FF) * (256 - (f)) + \
+     ((b) & 0x00FF00FF) * (f)) >> 8) & 0x00FF00FF) | \
+  (((((a) >> 8) & 0x00FF00FF) * (256 - (f)) + \
+    (((b) >> 8) & 0x00FF00FF) * (f)) & 0xFF00FF00)
+#define TEXEL_PACK(c) (c)
+
+#endif
+
+static inline PIXEL FILL(texel_linear)(const ZBTexture *tex,
+				       unsigned int s, unsigned int t)
+{
+    PIXEL *texture = (PIXEL *) tex->pixmap;
+    int wbits = tex->wbits, u, v, x0, x1, y0, y1, fu, fv;
+    unsigned int c00, c01, c10, c11;
+
+    /* 8 bits of fraction */
+    u = (int) (s >> (ZB_TEXTURE_MAX_BITS + 4 - wbits)) - 128;
+    v = (int) (t >> (ZB_TEXTURE_MAX_BITS + 12 - tex->hbits)) - 128;
+    x0 = (u >> 8) & ((1 << wbits) - 1);
+    x1 = (x0 + 1) & ((1 << wbits) - 1);
+    y0 = (v >> 8) & ((1 << tex->hbits) - 1);
+    y1 = (y0 + 1) & ((1 << tex->hbits) - 1);
+    fu = TEXEL_FRAC(u & 0xFF);
+    fv = TEXEL_FRAC(v & 0xFF);
+
+    c00 = TEXEL_SPREAD(texture[ZB_TILE_INDEX(x0, y0, wbits)]);
+    c01 = TEXEL_SPREAD(texture[ZB_TILE_INDEX(x1, y0, wbits)]);
+    c10 = TEXEL_SPREAD(texture[ZB_TILE_INDEX(x0, y1, wbits)]);
+    c11 = TEXEL_SPREAD(texture[ZB_TILE_INDEX(x1, y1, wbits)]);
+    c00 = TEXEL_LERP(c00, c01, fu);
+    c10 = TEXEL_LERP(c10, c11, fu);
+    c00 = TEXEL_LERP(c00, c10, fv);
+    return TEXEL_PACK(c00);
+}
+
+#undef TEXEL_FRAC
+#undef TEXEL_SPREAD
+#undef TEXEL_LERP
+#undef TEXEL_PACK
+
+static void FILL(flat)(ZBuffer *zb,
+		       ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+    PIXEL color;
+
+#define INTERP_Z
+
+#define DRAW_INIT()				\
+{						\
+  color=RGB_TO_PIXEL(p2->r,p2->g,p2->b);	\
+}
+
+#define PUT_PIXEL(_a)				\
+{						\
+    zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+    if (ZCMP(zz,pz[_a])) {				\
+      pp[_a]=color;				\
+      pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+}
+
+#ifdef ZB_FILL_SPANS
+#define DRAW_SPAN()						\
+{								\
+  ZB_SPANS(zb)->flat(pp1 + x1, pz1 + x1, (x2 >> 16) - x1 + 1,	\
+                     z1, dzdx, color);				\
+}
+#endif
+
+#include <GL/ztriangle.h>
+}
+
+/*
+ * Smooth filled triangle.
+ * The code below is very tricky :)
+ */
+
+static void FILL(smooth)(ZBuffer *zb,
+			 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+#if ZB_FILL_BITS == 16
+        int _drgbdx;
+#endif
+
+#define INTERP_Z
+#define INTERP_RGB
+
+#if ZB_FILL_BITS == 16
+
+#define SAR_RND_TO_ZERO(v,n) (v / (1<<n))
+
+#define DRAW_INIT() 				\
+{						\
+  _drgbdx=(SAR_RND_TO_ZERO(drdx,6) << 22) & 0xFFC00000;		\
+  _drgbdx|=SAR_RND_TO_ZERO(dgdx,5) & 0x000007FF;		\
+  _drgbdx|=(SAR_RND_TO_ZERO(dbdx,7) << 12) & 0x001FF000; 	\
+}
+
+
+#define PUT_PIXEL(_a)				\
+{						\
+    zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+    if (ZCMP(zz,pz[_a])) {				\
+      tmp=rgb & 0xF81F07E0;			\
+      pp[_a]=tmp | (tmp >> 16);			\
+      pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+    rgb=(rgb+drgbdx) & ( ~ 0x00200800);		\
+}
+
+#define DRAW_LINE()							   \
+{									   \
+  register unsigned short *pz;					   \
+  register PIXEL *pp;					   \
+  register unsigned int tmp,z,zz,rgb,drgbdx;				   \
+  register int n;							   \
+  n=(x2 >> 16) - x1;							   \
+  pp=pp1+x1;								   \
+  pz=pz1+x1;								   \
+  z=z1;									   \
+  rgb=(r1 << 16) & 0xFFC00000;						   \
+  rgb|=(g1 >> 5) & 0x000007FF;						   \
+  rgb|=(b1 << 5) & 0x001FF000;						   \
+  drgbdx=_drgbdx;							   \
+  while (n>=3) {							   \
+    PUT_PIXEL(0);							   \
+    PUT_PIXEL(1);							   \
+    PUT_PIXEL(2);							   \
+    PUT_PIXEL(3);							   \
+    pz+=4;								   \
+    pp+=4;								   \
+    n-=4;								   \
+  }									   \
+  while (n>=0) {							   \
+    PUT_PIXEL(0);							   \
+    pz+=1;								   \
+    pp+=1;								   \
+    n-=1;								   \
+  }									   \
+}
+
+#ifdef ZB_FILL_SPANS
+#define DRAW_SPAN()							   \
+{									   \
+  register unsigned int rgb;						   \
+  rgb=(r1 << 16) & 0xFFC00000;						   \
+  rgb|=(g1 >> 5) & 0x000007FF;						   \
+  rgb|=(b1 << 5) & 0x001FF000;						   \
+  ZB_SPANS(zb)->smooth(pp1 + x1, pz1 + x1, (x2 >> 16) - x1 + 1,	   \
+                       z1, dzdx, rgb, _drgbdx);			   \
+}
+#endif
+
+#else /* ZB_FILL_BITS == 32 */
+
+/* 8 bits per component: no room to step them packed */
+#define DRAW_INIT()
+
+#define PUT_PIXEL(_a)				\
+{						\
+    zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+    if (ZCMP(zz,pz[_a])) {				\
+      pp[_a]=RGB_TO_PIXEL(or1,og1,ob1);		\
+      pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+    or1+=drdx;					\
+    og1+=dgdx;					\
+    ob1+=dbdx;					\
+}
+
+#endif
+
+#include <GL/ztriangle.h>
+}
+
+static void FILL(mapping)(ZBuffer *zb,
+			  ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+    ZBTexture tex;
+    PIXEL *texture;
+
+#define INTERP_Z
+#define INTERP_ST
+
+#define DRAW_INIT()				\
+{						\
+  tex=zb->current_texture;			\
+  texture=(PIXEL *)tex.pixmap;			\
+}
+
+#define PUT_PIXEL(_a)				\
+{						\
+   zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+     if (ZCMP(zz,pz[_a])) {				\
+       pp[_a]=texture[ZB_TEXEL(&tex,s,t)];	\
+       pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+    s+=dsdx;					\
+    t+=dtdx;					\
+}
+
+#ifdef ZB_FILL_SPANS
+#define DRAW_SPAN()						\
+{								\
+  ZB_SPANS(zb)->mapping(pp1 + x1, pz1 + x1, (x2 >> 16) - x1 + 1,	\
+                        z1, dzdx, s1, dsdx, t1, dtdx, &tex);	\
+}
+#endif
+
+#include <GL/ztriangle.h>
+}
+
+/*
+ * Texture mapping with perspective correction.
+ * We use the gradient method to make less divisions.
+ * TODO: pipeline the division
+ */
+
+#define NB_INTERP 8
+#define SLL_NB_INTERP int2sll(8)
+#define SLLLL_NB_INTERP int2ffp(8)
+
+#define PERSPECTIVE_INIT()			\
+{						\
+  tex=zb->current_texture;			\
+  fdzdx=int2sll(dzdx);\
+  fndzdx=sllmul(SLL_NB_INTERP, fdzdx);\
+  ndszdx=ffpmul(SLLLL_NB_INTERP, dszdx);\
+  ndtzdx=ffpmul(SLLLL_NB_INTERP, dtzdx);\
+}
+
+#define PERSPECTIVE_LINE()			\
+{						\
+  register unsigned short *pz;		\
+  register PIXEL *pp;		\
+  register unsigned int s,t,z,zz;	\
+  register int n,dsdx,dtdx;		\
+  ffp sz,tz; \
+  GLfloat fz,zinv; \
+  n=(x2>>16)-x1;                             \
+  fz=int2sll(z1);\
+  zinv=slldiv(int2sll(1), fz);\
+  pp=(PIXEL *)((char *)pp1 + x1 * PSZB); \
+  pz=pz1+x1;					\
+  z=z1;						\
+  sz=sz1;\
+  tz=tz1;\
+  while (n>=(NB_INTERP-1)) {						   \
+    {\
+      ffp ss,tt;\
+      ss=ffpmul(sz, sll2ffp(zinv));\
+      tt=ffpmul(tz, sll2ffp(zinv));\
+      s=ffp2int(ss);\
+      t=ffp2int(tt);\
+      dsdx= ffp2int(ffpmul(ffpsub(dszdx, ffpmul(ss,sll2ffp(fdzdx))), sll2ffp(zinv)));\
+      dtdx= ffp2int(ffpmul(ffpsub(dtzdx, ffpmul(tt,sll2ffp(fdzdx))), sll2ffp(zinv)));\
+      fz=slladd(fz, fndzdx);\
+      zinv=slldiv(int2sll(1), fz);\
+    }\
+    PUT_PIXEL(0);							   \
+    PUT_PIXEL(1);							   \
+    PUT_PIXEL(2);							   \
+    PUT_PIXEL(3);							   \
+    PUT_PIXEL(4);							   \
+    PUT_PIXEL(5);							   \
+    PUT_PIXEL(6);							   \
+    PUT_PIXEL(7);							   \
+    pz+=NB_INTERP;							   \
+    pp=(PIXEL *)((char *)pp + NB_INTERP * PSZB);\
+    n-=NB_INTERP;							   \
+    sz=ffpadd(sz, ndszdx);\
+    tz=ffpadd(tz, ndtzdx);\
+  }									   \
+    {\
+      ffp ss,tt;\
+      ss=ffpmul(sz, sll2ffp(zinv));\
+      tt=ffpmul(tz, sll2ffp(zinv));\
+      s=ffp2int(ss);\
+      t=ffp2int(tt);\
+      dsdx= ffp2int(ffpmul(ffpsub(dszdx, ffpmul(ss,sll2ffp(fdzdx))), sll2ffp(zinv)));\
+      dtdx= ffp2int(ffpmul(ffpsub(dtzdx, ffpmul(tt,sll2ffp(fdzdx))), sll2ffp(zinv)));\
+    }\
+  while (n>=0) {							   \
+    PUT_PIXEL(0);							   \
+    pz+=1;								   \
+    pp=(PIXEL *)((char *)pp + PSZB);\
+    n-=1;								   \
+  }									   \
+}
+
+static void FILL(perspective)(ZBuffer *zb,
+			      ZBufferPoint *p0,ZBufferPoint *p1,
+			      ZBufferPoint *p2)
+{
+    ZBTexture tex;
+    PIXEL *texture;
+    GLfloat fdzdx,fndzdx;
+    ffp ndszdx,ndtzdx;
+#ifdef ZB_FILL_SPANS
+    ZBSpanGradients grad;
+#endif
+
+#define INTERP_Z
+#define INTERP_STZ
+
+#ifdef ZB_FILL_SPANS
+#define DRAW_INIT()				\
+{						\
+  PERSPECTIVE_INIT();				\
+  texture=(PIXEL *)tex.pixmap;			\
+  grad.dszdx=dszdx;\
+  grad.dtzdx=dtzdx;\
+  grad.ndszdx=ndszdx;\
+  grad.ndtzdx=ndtzdx;\
+  grad.fdzdx=fdzdx;\
+  grad.fndzdx=fndzdx;\
+}
+#else
+#define DRAW_INIT()				\
+{						\
+  PERSPECTIVE_INIT();				\
+  texture=(PIXEL *)tex.pixmap;			\
+}
+#endif
+
+#define PUT_PIXEL(_a)				\
+{						\
+   zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+     if (ZCMP(zz,pz[_a])) {				\
+       pp[_a]=texture[ZB_TEXEL(&tex,s,t)];	\
+       pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+    s+=dsdx;					\
+    t+=dtdx;					\
+}
+
+#define DRAW_LINE() PERSPECTIVE_LINE()
+
+#ifdef ZB_FILL_SPANS
+#define DRAW_SPAN()						\
+{								\
+  ZB_SPANS(zb)->perspective(pp1 + x1, pz1 + x1, (x2 >> 16) - x1 + 1,	\
+                            z1, dzdx, sz1, tz1, &grad, &tex);	\
+}
+#endif
+
+#include <GL/ztriangle.h>
+}
+
+/* the same with bilinear filtering */
+static void FILL(perspective_linear)(ZBuffer *zb,
+				     ZBufferPoint *p0,ZBufferPoint *p1,
+				     ZBufferPoint *p2)
+{
+    ZBTexture tex;
+    GLfloat fdzdx,fndzdx;
+    ffp ndszdx,ndtzdx;
+
+#define INTERP_Z
+#define INTERP_STZ
+
+#define DRAW_INIT() PERSPECTIVE_INIT()
+
+#define PUT_PIXEL(_a)				\
+{						\
+   zz=z >> ZB_POINT_Z_FRAC_BITS;		\
+     if (ZCMP(zz,pz[_a])) {				\
+       pp[_a]=FILL(texel_linear)(&tex,s,t);	\
+       pz[_a]=zz;				\
+    }						\
+    z+=dzdx;					\
+    s+=dsdx;					\
+    t+=dtdx;					\
+}
+
+#define DRAW_LINE() PERSPECTIVE_LINE()
+
+#include <GL/ztriangle.h>
+}
+
+#undef SAR_RND_TO_ZERO
+#undef NB_INTERP
+#undef SLL_NB_INTERP
+#undef SLLLL_NB_INTERP
+#undef PERSPECTIVE_INIT
+#undef PERSPECTIVE_LINE
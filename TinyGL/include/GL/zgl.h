@@ -114,8 +114,23 @@ typedef struct GLParamBuffer {
   struct GLParamBuffer *next;
 } GLParamBuffer;
 
+/* glBegin / glEnd blocks of a display list, packed at glEndList() and
+   drawn as with glDrawElements (see listopt.c) */
+typedef struct GLPacked {
+  int mode;
+  int nb_elements;
+  unsigned int *elements;
+  int stride;                   /* # of floats per vertex */
+  GLfloat *vertex;              /* X Y Z W */
+  GLfloat *color;               /* R G B A, or NULL */
+  GLfloat *normal;              /* X Y Z, or NULL */
+  GLfloat *tex_coord;           /* S T R Q, or NULL */
+  struct GLPacked *next;
+} GLPacked;
+
 typedef struct GLList {
   GLParamBuffer *first_op_buffer;
+  GLPacked *first_packed;
   /* TODO: extensions for an hash table or a better allocating scheme */
 } GLList;
 
@@ -133,9 +148,20 @@ typedef struct GLVertex {
   ZBufferPoint zp;      /* integer coordinates for the rasterization */
 } GLVertex;
 
+/* entry of the vertex cache of glDrawElements */
+typedef struct GLArrayCache {
+  int index;            /* element */
+  int slot;             /* its vertex in array_vertex */
+  int stamp;            /* batch of the entry */
+} GLArrayCache;
+
 typedef struct GLImage {
   void *pixmap;
   int xsize,ysize;
+  /* 2^wbits x 2^hbits texels, in tiles (see ZB_setTextureLevel()) */
+  int wbits,hbits;
+  int psize;          /* bytes per texel: the psize of the Z buffer */
+  int generated;      /* a mipmap level made from the level above */
 } GLImage;
 
 /* textures */
@@ -144,6 +170,8 @@ typedef struct GLImage {
 
 typedef struct GLTexture {
   GLImage images[MAX_TEXTURE_LEVELS];
+  int min_filter,mag_filter;
+  int nb_levels;      /* levels 0..nb_levels-1 are there, 0 if to do */
   int handle;
   struct GLTexture *next,*prev;
 } GLTexture;
@@ -189,6 +217,7 @@ typedef struct GLContext {
   GLSharedState shared_state;
 
   /* current list */
+  GLList *current_list;
   GLParamBuffer *current_op_buffer;
   int current_op_buffer_index;
   int exec_flag,compile_flag,print_flag;
@@ -263,6 +292,14 @@ typedef struct GLContext {
   int texcoord_array_size;
   int texcoord_array_stride;
   int client_states;
+
+  /* glDrawArrays / glDrawElements batches (see arrays.c) */
+  GLVertex *array_vertex;       /* transformed vertices of the batch */
+  int *array_fetch;             /* their index in the arrays */
+  int *array_slot;              /* vertex of each element of the batch */
+  int array_max;                /* size of the three above */
+  GLArrayCache *array_cache;
+  int array_stamp;
   
   /* opengl 1.1 polygon offset */
   GLfloat offset_factor;
@@ -287,6 +324,10 @@ typedef struct GLContext {
 extern GLContext *gl_ctx;
 
 void gl_add_op(GLParam *p);
+void gl_compile_op(GLContext *c,GLParam *p);
+
+/* listopt.c */
+void gl_optimize_list(GLContext *c,GLList *l);
 
 /* clip.c */
 void gl_transform_to_viewport(GLContext *c,GLVertex *v);
@@ -317,12 +358,16 @@ void gl_shade_vertex(GLContext *c,GLVertex *v);
 void glInitTextures(GLContext *c);
 void glEndTextures(GLContext *c);
 GLTexture *alloc_texture(GLContext *c,int h);
+int gl_set_texture_level(GLContext *c,GLVertex *p0,GLVertex *p1,
+                         GLVertex *p2);
 
 /* image_util.c */
 void gl_convertRGB_to_5R6G5B(unsigned short *pixmap,unsigned char *rgb,
                              int xsize,int ysize);
 void gl_convertRGB_to_8A8R8G8B(unsigned int *pixmap, unsigned char *rgb,
                                int xsize, int ysize);
+void gl_convertRGB_to_texture(void *pixmap,int psize,unsigned char *rgb,
+                              int wbits,int hbits);
 void gl_resizeImage(unsigned char *dest,int xsize_dest,int ysize_dest,
                     unsigned char *src,int xsize_src,int ysize_src);
 void gl_resizeImageNoInterpolate(unsigned char *dest,int xsize_dest,int ysize_dest,
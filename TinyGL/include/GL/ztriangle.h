@@ -9,7 +9,7 @@
   GLfloat fdx1, fdx2, fdy1, fdy2, fz, d1, d2;
   unsigned short *pz1;
   PIXEL *pp1;
-  int part,update_left,update_right;
+  int part,update_left,update_right,y;
 
   int nb_lines,dx1,dy1,tmp,dx2,dy2;
 
@@ -52,6 +52,10 @@
     p2 = t;
   }
 
+  /* nothing to draw in the scanlines we may touch ? */
+  if (p2->y < zb->ymin || p0->y >= zb->ymax)
+    return;
+
   /* we compute dXdx and dXdy for all interpolated values */
 
   fdx1 = int2sll(p1->x - p0->x);
@@ -136,6 +140,7 @@
 
   pp1 = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p0->y);
   pz1 = zb->zbuf + p0->y * zb->xsize;
+  y = p0->y;
 
   DRAW_INIT();
 
@@ -242,6 +247,17 @@
 
     while (nb_lines>0) {
       nb_lines--;
+      if (y >= zb->ymax)
+        return;
+      if (y < zb->ymin) {
+        /* not one of our scanlines */
+      }
+#ifdef DRAW_SPAN
+      else if (ZB_SPANS(zb) != NULL) {
+        DRAW_SPAN();
+      }
+#endif
+      else
 #ifndef DRAW_LINE
       /* generic draw line */
       {
@@ -351,6 +367,7 @@
       /* screen coordinates */
       pp1=(PIXEL *)((char *)pp1 + zb->linesize);
       pz1+=zb->xsize;
+      y++;
     }
   }
 }
@@ -362,4 +379,5 @@
 
 #undef DRAW_INIT
 #undef DRAW_LINE  
+#undef DRAW_SPAN
 #undef PUT_PIXEL
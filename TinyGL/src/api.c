@@ -672,7 +672,10 @@ void glCallList(unsigned int list)
 
 void glFlush(void)
 {
-  /* nothing to do */
+  GLContext *c=gl_get_context();
+
+  /* draw the triangles the deferred rasterizer is still holding */
+  ZB_flush(c->zb);
 }
 
 void glHint(int target,int mode)
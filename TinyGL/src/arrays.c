@@ -1,12 +1,60 @@
 #include <GL/zgl.h>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #define VERTEX_ARRAY   0x0001
 #define COLOR_ARRAY    0x0002
 #define NORMAL_ARRAY   0x0004
 #define TEXCOORD_ARRAY 0x0008
 
+/* current color from the color array, as glColor4f() */
+static void
+array_color(GLContext *c, int idx)
+{
+  GLParam p[8];
+  int size = c->color_array_size;
+  int i = idx * (size + c->color_array_stride);
+
+  p[1].f = c->color_array[i];
+  p[2].f = c->color_array[i+1];
+  p[3].f = c->color_array[i+2];
+  p[4].f = size > 3 ? c->color_array[i+3] : int2sll(1);
+  p[5].ui = (unsigned int) sll2int(slladd(sllmul(p[1].f,
+                 int2sll(ZB_POINT_RED_MAX - ZB_POINT_RED_MIN)),
+                 int2sll(ZB_POINT_RED_MIN)));
+  p[6].ui = (unsigned int) sll2int(slladd(sllmul(p[2].f,
+                 int2sll(ZB_POINT_GREEN_MAX - ZB_POINT_GREEN_MIN)),
+                 int2sll(ZB_POINT_GREEN_MIN)));
+  p[7].ui = (unsigned int) sll2int(slladd(sllmul(p[3].f,
+                 int2sll(ZB_POINT_BLUE_MAX - ZB_POINT_BLUE_MIN)),
+                 int2sll(ZB_POINT_BLUE_MIN)));
+  glopColor(c, p);
+}
+
+static void
+array_normal(GLContext *c, int idx)
+{
+  int i = idx * (3 + c->normal_array_stride);
+
+  c->current_normal.X = c->normal_array[i];
+  c->current_normal.Y = c->normal_array[i+1];
+  c->current_normal.Z = c->normal_array[i+2];
+  c->current_normal.W = int2sll(0);
+}
+
+static void
+array_tex_coord(GLContext *c, int idx)
+{
+  int size = c->texcoord_array_size;
+  int i = idx * (size + c->texcoord_array_stride);
+
+  c->current_tex_coord.X = c->texcoord_array[i];
+  c->current_tex_coord.Y = c->texcoord_array[i+1];
+  c->current_tex_coord.Z = size > 2 ? c->texcoord_array[i+2] : int2sll(0);
+  c->current_tex_coord.W = size > 3 ? c->texcoord_array[i+3] : int2sll(1);
+}
+
 void
 glopArrayElement(GLContext *c, GLParam *param)
 {
@@ -14,31 +62,12 @@ glopArrayElement(GLContext *c, GLParam *param)
   int states = c->client_states;
   int idx = param[1].i;
     
-  if (states & COLOR_ARRAY) {
-    GLParam p[5];
-    int size = c->color_array_size; 
-    i = idx * (size + c->color_array_stride);
-    p[1].f = c->color_array[i];
-    p[2].f = c->color_array[i+1];
-    p[3].f = c->color_array[i+2];
-    p[4].f = size > 3 ? c->color_array[i+3] : int2sll(1);
-    glopColor(c, p);  
-  }
-  if (states & NORMAL_ARRAY) {
-    i = idx * (3 + c->normal_array_stride);
-    c->current_normal.X = c->normal_array[i];
-    c->current_normal.Y = c->normal_array[i+1];
-    c->current_normal.Z = c->normal_array[i+2];
-    c->current_normal.Z = int2sll(0);
-  }
-  if (states & TEXCOORD_ARRAY) {
-    int size = c->texcoord_array_size;
-    i = idx * (size + c->texcoord_array_stride);
-    c->current_tex_coord.X = c->texcoord_array[i];
-    c->current_tex_coord.Y = c->texcoord_array[i+1];
-    c->current_tex_coord.Z = size > 2 ? c->texcoord_array[i+2] : int2sll(0);
-    c->current_tex_coord.W = size > 3 ? c->texcoord_array[i+3] : int2sll(1);
-  }
+  if (states & COLOR_ARRAY)
+    array_color(c, idx);
+  if (states & NORMAL_ARRAY)
+    array_normal(c, idx);
+  if (states & TEXCOORD_ARRAY)
+    array_tex_coord(c, idx);
   if (states & VERTEX_ARRAY) {
     GLParam p[5];
     int size = c->vertex_array_size;
@@ -60,6 +89,594 @@ glArrayElement(GLint i)
   gl_add_op(p);
 }
 
+/*
+ * glDrawArrays / glDrawElements
+ *
+ * Outside of a display list, the elements do not go through the op
+ * queue one glArrayElement at a time: they are drawn in batches of
+ * ARRAY_BATCH. The distinct vertices of a batch (glDrawElements looks
+ * each index up in a small hash table, so a vertex shared by several
+ * triangles is transformed and lit once) are transformed ARRAY_BLOCK at
+ * a time with the matrices held in locals, then lit and projected, and
+ * the primitives are assembled from pointers to them exactly as
+ * glopVertex() and glopEnd() do from c->vertex. The frames are the same
+ * as with glBegin / glArrayElement / glEnd.
+ */
+
+#define ARRAY_BATCH 1024
+#define ARRAY_BLOCK 64
+#define ARRAY_CACHE_SIZE (2 * ARRAY_BATCH)	/* power of two */
+
+typedef struct {
+  int mode;
+  int first;
+  GLenum type;
+  const GLvoid *indices;
+  /* the vertices kept from an element to the next, as c->vertex[] */
+  GLVertex *v[4];
+  int n, cnt;
+  GLVertex kept[4];
+} ArrayDraw;
+
+static inline int
+array_index(ArrayDraw *d, int k)
+{
+  switch (d->type) {
+  case GL_UNSIGNED_BYTE:
+    return ((const GLubyte *)d->indices)[k];
+  case GL_UNSIGNED_SHORT:
+    return ((const GLushort *)d->indices)[k];
+  case GL_UNSIGNED_INT:
+    return ((const GLuint *)d->indices)[k];
+  default:
+    return d->first + k;
+  }
+}
+
+static int
+array_reserve(GLContext *c, int n)
+{
+  if (n <= c->array_max)
+    return 0;
+  gl_free(c->array_vertex);
+  gl_free(c->array_fetch);
+  gl_free(c->array_slot);
+  c->array_vertex = (GLVertex *)gl_malloc(n * sizeof(GLVertex));
+  c->array_fetch = (int *)gl_malloc(n * sizeof(int));
+  c->array_slot = (int *)gl_malloc(n * sizeof(int));
+  if (c->array_cache == NULL)
+    c->array_cache = (GLArrayCache *)
+      gl_zalloc(ARRAY_CACHE_SIZE * sizeof(GLArrayCache));
+  if (c->array_vertex == NULL || c->array_fetch == NULL ||
+      c->array_slot == NULL || c->array_cache == NULL) {
+    gl_free(c->array_vertex);
+    gl_free(c->array_fetch);
+    gl_free(c->array_slot);
+    c->array_vertex = NULL;
+    c->array_fetch = NULL;
+    c->array_slot = NULL;
+    c->array_max = 0;
+    return -1;
+  }
+  c->array_max = n;
+  return 0;
+}
+
+/* vertex of each element of the batch, and the vertices to compute */
+static int
+array_fetch(GLContext *c, ArrayDraw *d, int start, int n)
+{
+  GLArrayCache *e;
+  int *slot = c->array_slot, *fetch = c->array_fetch;
+  int k, idx, h, nb;
+
+  if (d->indices == NULL || d->mode == GL_POLYGON) {
+    for (k = 0; k < n; k++) {
+      fetch[k] = array_index(d, start + k);
+      slot[k] = k;
+    }
+    return n;
+  }
+
+  if (++c->array_stamp <= 0) {
+    memset(c->array_cache, 0, ARRAY_CACHE_SIZE * sizeof(GLArrayCache));
+    c->array_stamp = 1;
+  }
+  nb = 0;
+  for (k = 0; k < n; k++) {
+    idx = array_index(d, start + k);
+    h = (unsigned int)idx * 2654435761u >> 16;
+    for (;;) {
+      e = &c->array_cache[h & (ARRAY_CACHE_SIZE - 1)];
+      if (e->stamp != c->array_stamp) {
+        e->stamp = c->array_stamp;
+        e->index = idx;
+        e->slot = nb;
+        fetch[nb++] = idx;
+        break;
+      }
+      if (e->index == idx)
+        break;
+      h++;
+    }
+    slot[k] = e->slot;
+  }
+  return nb;
+}
+
+/* coordinates, normal and clip code of n vertices, as gl_vertex_transform() */
+static void
+array_transform(GLContext *c, GLVertex *v, const int *fetch, int n)
+{
+  GLfloat x[ARRAY_BLOCK], y[ARRAY_BLOCK], z[ARRAY_BLOCK];
+  GLfloat m0, m1, m2, m3, m4, m5, m6, m7;
+  GLfloat m8, m9, m10, m11, m12, m13, m14, m15;
+  GLfloat *a, *m;
+  int size = c->vertex_array_size;
+  int stride = size + c->vertex_array_stride;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    a = c->vertex_array + fetch[i] * stride;
+    x[i] = a[0];
+    y[i] = a[1];
+    z[i] = size > 2 ? a[2] : int2sll(0);
+    v[i].coord.X = x[i];
+    v[i].coord.Y = y[i];
+    v[i].coord.Z = z[i];
+    v[i].coord.W = size > 3 ? a[3] : int2sll(1);
+  }
+
+  if (c->lighting_enabled) {
+    GLfloat nx[ARRAY_BLOCK], ny[ARRAY_BLOCK], nz[ARRAY_BLOCK];
+    V4 *ec;
+
+    /* eye coordinates needed for lighting */
+    m = &c->matrix_stack_ptr[0]->m[0][0];
+    m0 = m[0]; m1 = m[1]; m2 = m[2]; m3 = m[3];
+    m4 = m[4]; m5 = m[5]; m6 = m[6]; m7 = m[7];
+    m8 = m[8]; m9 = m[9]; m10 = m[10]; m11 = m[11];
+    m12 = m[12]; m13 = m[13]; m14 = m[14]; m15 = m[15];
+    for (i = 0; i < n; i++) {
+      ec = &v[i].ec;
+      ec->X = slladd(slladd(slladd(sllmul(x[i], m0), sllmul(y[i], m1)),
+                            sllmul(z[i], m2)), m3);
+      ec->Y = slladd(slladd(slladd(sllmul(x[i], m4), sllmul(y[i], m5)),
+                            sllmul(z[i], m6)), m7);
+      ec->Z = slladd(slladd(slladd(sllmul(x[i], m8), sllmul(y[i], m9)),
+                            sllmul(z[i], m10)), m11);
+      ec->W = slladd(slladd(slladd(sllmul(x[i], m12), sllmul(y[i], m13)),
+                            sllmul(z[i], m14)), m15);
+    }
+
+    /* projection coordinates */
+    m = &c->matrix_stack_ptr[1]->m[0][0];
+    m0 = m[0]; m1 = m[1]; m2 = m[2]; m3 = m[3];
+    m4 = m[4]; m5 = m[5]; m6 = m[6]; m7 = m[7];
+    m8 = m[8]; m9 = m[9]; m10 = m[10]; m11 = m[11];
+    m12 = m[12]; m13 = m[13]; m14 = m[14]; m15 = m[15];
+    for (i = 0; i < n; i++) {
+      ec = &v[i].ec;
+      v[i].pc.X = slladd(slladd(slladd(sllmul(ec->X, m0), sllmul(ec->Y, m1)),
+                                sllmul(ec->Z, m2)), sllmul(ec->W, m3));
+      v[i].pc.Y = slladd(slladd(slladd(sllmul(ec->X, m4), sllmul(ec->Y, m5)),
+                                sllmul(ec->Z, m6)), sllmul(ec->W, m7));
+      v[i].pc.Z = slladd(slladd(slladd(sllmul(ec->X, m8), sllmul(ec->Y, m9)),
+                                sllmul(ec->Z, m10)), sllmul(ec->W, m11));
+      v[i].pc.W = slladd(slladd(slladd(sllmul(ec->X, m12), sllmul(ec->Y, m13)),
+                                sllmul(ec->Z, m14)), sllmul(ec->W, m15));
+    }
+
+    /* normals */
+    if (c->client_states & NORMAL_ARRAY) {
+      stride = 3 + c->normal_array_stride;
+      for (i = 0; i < n; i++) {
+        a = c->normal_array + fetch[i] * stride;
+        nx[i] = a[0];
+        ny[i] = a[1];
+        nz[i] = a[2];
+      }
+    } else {
+      for (i = 0; i < n; i++) {
+        nx[i] = c->current_normal.X;
+        ny[i] = c->current_normal.Y;
+        nz[i] = c->current_normal.Z;
+      }
+    }
+    m = &c->matrix_model_view_inv.m[0][0];
+    m0 = m[0]; m1 = m[1]; m2 = m[2];
+    m4 = m[4]; m5 = m[5]; m6 = m[6];
+    m8 = m[8]; m9 = m[9]; m10 = m[10];
+    for (i = 0; i < n; i++) {
+      v[i].normal.X = slladd(slladd(sllmul(nx[i], m0), sllmul(ny[i], m1)),
+                             sllmul(nz[i], m2));
+      v[i].normal.Y = slladd(slladd(sllmul(nx[i], m4), sllmul(ny[i], m5)),
+                             sllmul(nz[i], m6));
+      v[i].normal.Z = slladd(slladd(sllmul(nx[i], m8), sllmul(ny[i], m9)),
+                             sllmul(nz[i], m10));
+    }
+    if (c->normalize_enabled) {
+      for (i = 0; i < n; i++)
+        gl_V3_Norm(&v[i].normal);
+    }
+  } else {
+    /* no eye coordinates needed, no normal */
+    /* NOTE: W = 1 is assumed */
+    m = &c->matrix_model_projection.m[0][0];
+    m0 = m[0]; m1 = m[1]; m2 = m[2]; m3 = m[3];
+    m4 = m[4]; m5 = m[5]; m6 = m[6]; m7 = m[7];
+    m8 = m[8]; m9 = m[9]; m10 = m[10]; m11 = m[11];
+    m12 = m[12]; m13 = m[13]; m14 = m[14]; m15 = m[15];
+    for (i = 0; i < n; i++) {
+      v[i].pc.X = slladd(slladd(slladd(sllmul(x[i], m0), sllmul(y[i], m1)),
+                                sllmul(z[i], m2)), m3);
+      v[i].pc.Y = slladd(slladd(slladd(sllmul(x[i], m4), sllmul(y[i], m5)),
+                                sllmul(z[i], m6)), m7);
+      v[i].pc.Z = slladd(slladd(slladd(sllmul(x[i], m8), sllmul(y[i], m9)),
+                                sllmul(z[i], m10)), m11);
+    }
+    if (c->matrix_model_projection_no_w_transform) {
+      for (i = 0; i < n; i++)
+        v[i].pc.W = m15;
+    } else {
+      for (i = 0; i < n; i++)
+        v[i].pc.W = slladd(slladd(slladd(sllmul(x[i], m12), sllmul(y[i], m13)),
+                                  sllmul(z[i], m14)), m15);
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    v[i].clip_code = gl_clipcode(v[i].pc.X, v[i].pc.Y, v[i].pc.Z, v[i].pc.W);
+}
+
+/* color, texture coordinates and window coordinates, as glopVertex() */
+static void
+array_finish(GLContext *c, GLVertex *v, const int *fetch, int n)
+{
+  int states = c->client_states;
+  int i;
+
+  for (i = 0; i < n; i++, v++) {
+    if (states & COLOR_ARRAY)
+      array_color(c, fetch[i]);
+    if (c->lighting_enabled) {
+      gl_shade_vertex(c, v);
+    } else {
+      v->color = c->current_color;
+    }
+
+    if (c->texture_2d_enabled) {
+      if (states & TEXCOORD_ARRAY)
+        array_tex_coord(c, fetch[i]);
+      if (c->apply_texture_matrix) {
+        gl_M4_MulV4(&v->tex_coord, c->matrix_stack_ptr[2], &c->current_tex_coord);
+      } else {
+        v->tex_coord = c->current_tex_coord;
+      }
+    }
+
+    if (v->clip_code == 0) {
+      gl_transform_to_viewport(c, v);
+    } else if (!c->lighting_enabled) {
+      /* the color of the vertex, for the clipping (see array_assemble()) */
+      v->zp.r = c->longcurrent_color[0];
+      v->zp.g = c->longcurrent_color[1];
+      v->zp.b = c->longcurrent_color[2];
+    }
+
+    v->edge_flag = c->current_edge_flag;
+  }
+}
+
+/* the primitives of the batch, as glopVertex() */
+static void
+array_assemble(GLContext *c, ArrayDraw *d, int n)
+{
+  GLVertex **v = d->v, *p;
+  int set_color = (c->client_states & COLOR_ARRAY) && !c->lighting_enabled;
+  int k, i, vn, cnt, e0, e2;
+
+  vn = d->n;
+  cnt = d->cnt;
+  for (k = 0; k < n; k++) {
+    p = &c->array_vertex[c->array_slot[k]];
+    /* the clipping takes the color of the last vertex if no lighting */
+    if (set_color) {
+      c->longcurrent_color[0] = p->zp.r;
+      c->longcurrent_color[1] = p->zp.g;
+      c->longcurrent_color[2] = p->zp.b;
+    }
+    cnt++;
+    v[vn++] = p;
+
+    switch (d->mode) {
+    case GL_POINTS:
+      gl_draw_point(c, v[0]);
+      vn = 0;
+      break;
+
+    case GL_LINES:
+      if (vn == 2) {
+        gl_draw_line(c, v[0], v[1]);
+        vn = 0;
+      }
+      break;
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+      if (vn == 1) {
+        v[2] = v[0];
+      } else if (vn == 2) {
+        gl_draw_line(c, v[0], v[1]);
+        v[0] = v[1];
+        vn = 1;
+      }
+      break;
+
+    case GL_TRIANGLES:
+      if (vn == 3) {
+        gl_draw_triangle(c, v[0], v[1], v[2]);
+        vn = 0;
+      }
+      break;
+    case GL_TRIANGLE_STRIP:
+      if (cnt >= 3) {
+        if (vn == 3)
+          vn = 0;
+        /* needed to respect triangle orientation */
+        if (cnt & 1)
+          gl_draw_triangle(c, v[0], v[1], v[2]);
+        else
+          gl_draw_triangle(c, v[2], v[1], v[0]);
+      }
+      break;
+    case GL_TRIANGLE_FAN:
+      if (vn == 3) {
+        gl_draw_triangle(c, v[0], v[1], v[2]);
+        v[1] = v[2];
+        vn = 2;
+      }
+      break;
+
+    case GL_QUADS:
+      if (vn == 4) {
+        /* the vertices may be shared with other quads */
+        e0 = v[0]->edge_flag;
+        e2 = v[2]->edge_flag;
+        v[2]->edge_flag = 0;
+        gl_draw_triangle(c, v[0], v[1], v[2]);
+        v[2]->edge_flag = 1;
+        v[0]->edge_flag = 0;
+        gl_draw_triangle(c, v[0], v[2], v[3]);
+        v[0]->edge_flag = e0;
+        v[2]->edge_flag = e2;
+        vn = 0;
+      }
+      break;
+
+    case GL_QUAD_STRIP:
+      if (vn == 4) {
+        gl_draw_triangle(c, v[0], v[1], v[2]);
+        gl_draw_triangle(c, v[1], v[3], v[2]);
+        for (i = 0; i < 2; i++)
+          v[i] = v[i + 2];
+        vn = 2;
+      }
+      break;
+    case GL_POLYGON:
+      /* drawn at the end, from c->array_vertex */
+      vn = 0;
+      break;
+    default:
+      gl_fatal_error("glBegin: type %x not handled\n", d->mode);
+    }
+  }
+  d->n = vn;
+  d->cnt = cnt;
+}
+
+/* copy the vertices still needed out of the batch, before the next one */
+static void
+array_keep(ArrayDraw *d)
+{
+  GLVertex tmp[4];
+  int i, j;
+
+  for (i = 0; i < 4; i++) {
+    if (d->v[i] != NULL)
+      tmp[i] = *d->v[i];
+  }
+  for (i = 0; i < 4; i++) {
+    if (d->v[i] == NULL)
+      continue;
+    /* several entries may point to the same vertex */
+    for (j = 0; j < i; j++) {
+      if (d->v[j] == d->v[i])
+        break;
+    }
+    d->kept[i] = tmp[i];
+    d->v[i] = j < i ? d->v[j] : &d->kept[i];
+  }
+}
+
+/* the last element sets the current color, normal and texture coordinates */
+static void
+array_current(GLContext *c, int idx)
+{
+  if (c->client_states & COLOR_ARRAY)
+    array_color(c, idx);
+  if (c->client_states & NORMAL_ARRAY)
+    array_normal(c, idx);
+  if (c->client_states & TEXCOORD_ARRAY)
+    array_tex_coord(c, idx);
+}
+
+static void
+array_draw(GLContext *c, ArrayDraw *d, int count)
+{
+  GLParam p[2];
+  int start, n, nb, i, batch;
+
+  if (!(c->client_states & VERTEX_ARRAY)) {
+    array_current(c, array_index(d, count - 1));
+    return;
+  }
+
+  /* a polygon is drawn at the end, from all its vertices */
+  batch = d->mode == GL_POLYGON ? count : ARRAY_BATCH;
+  if (array_reserve(c, batch) != 0)
+    gl_fatal_error("unable to allocate the vertex array buffers.\n");
+
+  p[1].i = d->mode;
+  glopBegin(c, p);
+  for (i = 0; i < 4; i++)
+    d->v[i] = NULL;
+  d->n = 0;
+  d->cnt = 0;
+
+  for (start = 0; start < count; start += n) {
+    n = count - start;
+    if (n > batch)
+      n = batch;
+    nb = array_fetch(c, d, start, n);
+    for (i = 0; i < nb; i += ARRAY_BLOCK) {
+      array_transform(c, c->array_vertex + i, c->array_fetch + i,
+                      nb - i < ARRAY_BLOCK ? nb - i : ARRAY_BLOCK);
+    }
+    array_finish(c, c->array_vertex, c->array_fetch, nb);
+    array_assemble(c, d, n);
+    if (start + n < count)
+      array_keep(d);
+  }
+
+  /* as glopEnd() */
+  if (d->mode == GL_LINE_LOOP) {
+    if (d->cnt >= 3)
+      gl_draw_line(c, d->v[0], d->v[2]);
+  } else if (d->mode == GL_POLYGON) {
+    GLVertex *v = c->array_vertex;
+    i = d->cnt;
+    while (i >= 3) {
+      i--;
+      gl_draw_triangle(c, &v[i], &v[0], &v[i - 1]);
+    }
+  }
+  c->in_begin = 0;
+
+  array_current(c, array_index(d, count - 1));
+}
+
+/* in a display list, the elements are recorded one by one */
+static void
+array_compile(ArrayDraw *d, int count)
+{
+  int i;
+
+  glBegin(d->mode);
+  for (i = 0; i < count; i++)
+    glArrayElement(array_index(d, i));
+  glEnd();
+}
+
+void
+glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+  GLContext *c = gl_get_context();
+  ArrayDraw d;
+
+  if (count <= 0)
+    return;
+  d.mode = mode;
+  d.first = first;
+  d.type = 0;
+  d.indices = NULL;
+  if (c->compile_flag || c->print_flag)
+    array_compile(&d, count);
+  else
+    array_draw(c, &d, count);
+}
+
+void
+glDrawElements(GLenum mode, GLsizei count, GLenum type,
+               const GLvoid *indices)
+{
+  GLContext *c = gl_get_context();
+  ArrayDraw d;
+
+  assert(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_SHORT ||
+         type == GL_UNSIGNED_INT);
+  if (count <= 0)
+    return;
+  d.mode = mode;
+  d.first = 0;
+  d.type = type;
+  d.indices = indices;
+  if (c->compile_flag || c->print_flag)
+    array_compile(&d, count);
+  else
+    array_draw(c, &d, count);
+}
+
+/* packed glBegin / glEnd blocks of a display list (see listopt.c) */
+void
+glopDrawPacked(GLContext *c, GLParam *param)
+{
+  GLPacked *pk = (GLPacked *)param[1].p;
+  GLfloat *vertex_array = c->vertex_array;
+  GLfloat *normal_array = c->normal_array;
+  GLfloat *color_array = c->color_array;
+  GLfloat *texcoord_array = c->texcoord_array;
+  int vertex_array_size = c->vertex_array_size;
+  int vertex_array_stride = c->vertex_array_stride;
+  int normal_array_stride = c->normal_array_stride;
+  int color_array_size = c->color_array_size;
+  int color_array_stride = c->color_array_stride;
+  int texcoord_array_size = c->texcoord_array_size;
+  int texcoord_array_stride = c->texcoord_array_stride;
+  int client_states = c->client_states;
+  ArrayDraw d;
+
+  c->client_states = VERTEX_ARRAY;
+  c->vertex_array = pk->vertex;
+  c->vertex_array_size = 4;
+  c->vertex_array_stride = pk->stride - 4;
+  if (pk->color != NULL) {
+    c->client_states |= COLOR_ARRAY;
+    c->color_array = pk->color;
+    c->color_array_size = 4;
+    c->color_array_stride = pk->stride - 4;
+  }
+  if (pk->normal != NULL) {
+    c->client_states |= NORMAL_ARRAY;
+    c->normal_array = pk->normal;
+    c->normal_array_stride = pk->stride - 3;
+  }
+  if (pk->tex_coord != NULL) {
+    c->client_states |= TEXCOORD_ARRAY;
+    c->texcoord_array = pk->tex_coord;
+    c->texcoord_array_size = 4;
+    c->texcoord_array_stride = pk->stride - 4;
+  }
+
+  d.mode = pk->mode;
+  d.first = 0;
+  d.type = GL_UNSIGNED_INT;
+  d.indices = pk->elements;
+  array_draw(c, &d, pk->nb_elements);
+
+  c->vertex_array = vertex_array;
+  c->normal_array = normal_array;
+  c->color_array = color_array;
+  c->texcoord_array = texcoord_array;
+  c->vertex_array_size = vertex_array_size;
+  c->vertex_array_stride = vertex_array_stride;
+  c->normal_array_stride = normal_array_stride;
+  c->color_array_size = color_array_size;
+  c->color_array_stride = color_array_stride;
+  c->texcoord_array_size = texcoord_array_size;
+  c->texcoord_array_stride = texcoord_array_stride;
+  c->client_states = client_states;
+}
+
 
 void
 glopEnableClientState(GLContext *c, GLParam *p)
@@ -183,6 +800,7 @@ glNormalPointer(GLenum type, GLsizei stride,
   p[0].op = OP_NormalPointer;
   p[1].i = stride;
   p[2].p = (void*)pointer;
+  gl_add_op(p);
 }
 
 void
@@ -203,4 +821,5 @@ glTexCoordPointer(GLint size, GLenum type, GLsizei stride,
   p[1].i = size;
   p[2].i = stride;
   p[3].p = (void*)pointer;
+  gl_add_op(p);
 }
@@ -444,14 +444,21 @@ void gl_draw_triangle_select(GLContext *c,
 void gl_draw_triangle_fill(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2)
 {
-  if (c->texture_2d_enabled) {
-    ZB_setTexture(c->zb,(PIXEL *)c->current_texture->images[0].pixmap);
-    ZB_fillTriangleMappingPerspective(c->zb,&p0->zp,&p1->zp,&p2->zp);
+  ZB_fillTriangleFunc fill;
+
+  if (c->texture_2d_enabled && gl_set_texture_level(c,p0,p1,p2)) {
+    fill=ZB_fillTriangleMappingPerspective;
   } else if (c->current_shade_model == GL_SMOOTH) {
-    ZB_fillTriangleSmooth(c->zb,&p0->zp,&p1->zp,&p2->zp);
+    fill=ZB_fillTriangleSmooth;
   } else {
-    ZB_fillTriangleFlat(c->zb,&p0->zp,&p1->zp,&p2->zp);
+    fill=ZB_fillTriangleFlat;
   }
+
+  /* deferred rendering: the triangle is drawn at the next ZB_flush() */
+  if (c->zb->tiles != NULL)
+    ZB_binTriangle(c->zb,fill,&p0->zp,&p1->zp,&p2->zp);
+  else
+    fill(c->zb,&p0->zp,&p1->zp,&p2->zp);
 }
 
 /* Render a clipped triangle in line mode */  
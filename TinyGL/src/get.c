@@ -21,7 +21,7 @@ void glGetIntegerv(int pname,int *params)
     *params = MAX_LIGHTS;
     break;
   case GL_MAX_TEXTURE_SIZE:
-    *params = 256; /* not completely true, but... */
+    *params = 1 << ZB_TEXTURE_MAX_BITS;
     break;
   case GL_MAX_TEXTURE_STACK_DEPTH:
     *params = MAX_TEXTURE_STACK_DEPTH;
@@ -34,6 +34,33 @@ void gl_convertRGB_to_8A8R8G8B(unsigned int *pixmap, unsigned char *rgb,
     }
 }
 
+/*
+ * texture level of 2^wbits x 2^hbits texels, in the tiles of
+ * ZB_TILE_INDEX(), 2 or 4 bytes per texel. The sizes smaller than 4
+ * are stretched to 4.
+ */
+void gl_convertRGB_to_texture(void *pixmap,int psize,unsigned char *rgb,
+                              int wbits,int hbits)
+{
+  int x,y,sw,sh,i;
+  unsigned char *p;
+
+  sw=wbits < 2 ? 2 : wbits;
+  sh=hbits < 2 ? 2 : hbits;
+  for(y=0;y<(1 << sh);y++) {
+    for(x=0;x<(1 << sw);x++) {
+      p=rgb+((((y >> (sh-hbits)) << wbits) + (x >> (sw-wbits)))*3);
+      i=ZB_TILE_INDEX(x,y,sw);
+      if (psize == 4)
+        ((unsigned int *)pixmap)[i]=(((unsigned int)p[0])<<16) |
+          (((unsigned int)p[1])<<8) | ((unsigned int)p[2]);
+      else
+        ((unsigned short *)pixmap)[i]=((p[0]&0xF8)<<8) | ((p[1]&0xFC)<<3) |
+          ((p[2]&0xF8)>>3);
+    }
+  }
+}
+
 /*
  * linear interpolation with xf,yf normalized to 2^16
  */
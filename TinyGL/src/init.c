@@ -185,5 +185,9 @@ void glClose(void)
 {
   GLContext *c=gl_get_context();
   endSharedState(c);
+  gl_free(c->array_vertex);
+  gl_free(c->array_fetch);
+  gl_free(c->array_slot);
+  gl_free(c->array_cache);
   gl_free(c);
 }
@@ -35,6 +35,7 @@ static GLList *find_list(GLContext *c,unsigned int list)
 static void delete_list(GLContext *c,int list)
 {
   GLParamBuffer *pb,*pb1;
+  GLPacked *pk,*pk1;
   GLList *l;
 
   l=find_list(c,list);
@@ -47,6 +48,16 @@ static void delete_list(GLContext *c,int list)
     gl_free(pb);
     pb=pb1;
   }
+
+  /* free packed geometry */
+  pk=l->first_packed;
+  while (pk!=NULL) {
+    pk1=pk->next;
+    gl_free(pk->elements);
+    gl_free(pk->vertex);
+    gl_free(pk);
+    pk=pk1;
+  }
   
   gl_free(l);
   c->shared_state.lists[list]=NULL;
@@ -197,6 +208,7 @@ void glNewList(unsigned int list,int mode)
   if (l!=NULL) delete_list(c,list);
   l=alloc_list(c,list);
 
+  c->current_list=l;
   c->current_op_buffer=l->first_op_buffer;
   c->current_op_buffer_index=0;
   
@@ -214,6 +226,9 @@ void glEndList(void)
   /* end of list */
   p[0].op=OP_EndList;
   gl_compile_op(c,p);
+
+  gl_optimize_list(c,c->current_list);
+  c->current_list=NULL;
   
   c->compile_flag=0;
   c->exec_flag=1;
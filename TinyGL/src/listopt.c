@@ -0,0 +1,510 @@
+/*
+ * Optimization of the display lists at glEndList().
+ *
+ * The ops of a list are recorded as they come (see list.c) and replayed
+ * one by one by glCallList(). Before the list is closed, they are
+ * rewritten:
+ *
+ * - in a run of state changes, the ones set again later in the run are
+ *   dropped (two glColor in a row, glEnable / glDisable of a flag...);
+ *
+ * - a run of matrix ops from a glLoadIdentity or a glLoadMatrix becomes
+ *   one glLoadMatrix, computed at compile time with the same functions,
+ *   and the matrix ops before the load are dropped;
+ *
+ * - the glBegin / glEnd blocks are packed into vertex arrays in object
+ *   space, with the identical vertices shared, and drawn by the
+ *   glDrawElements code (OP_DrawPacked, see arrays.c). The blocks of
+ *   independent points, lines, triangles or quads that follow each other
+ *   are merged. Only the attributes that change from a vertex to another
+ *   are stored, the others are set once before.
+ *
+ * The frames are exactly the same as with the ops replayed as recorded.
+ */
+#include <string.h>
+#include <GL/zgl.h>
+
+#if TGL_FEATURE_LIST_OPT
+
+static int op_size[]=
+{
+#define ADD_OP(a,b,c) b + 1 ,
+
+#include <GL/opinfo.h>
+};
+
+enum { ATTR_COLOR, ATTR_NORMAL, ATTR_TEX_COORD, ATTR_EDGE_FLAG, NB_ATTRS };
+
+/* op and # of values compared of each attribute */
+static const int attr_op[NB_ATTRS] = {
+  OP_Color, OP_Normal, OP_TexCoord, OP_EdgeFlag,
+};
+static const int attr_size[NB_ATTRS] = { 4, 3, 4, 1 };
+
+static int attr_index(int op)
+{
+  int a;
+
+  for(a=0;a<NB_ATTRS;a++) {
+    if (attr_op[a] == op) return a;
+  }
+  return -1;
+}
+
+static int same_attr(int a,GLParam *p1,GLParam *p2)
+{
+  int i;
+
+  if (a == ATTR_EDGE_FLAG) return p1[1].i == p2[1].i;
+  for(i=1;i<=attr_size[a];i++) {
+    if (memcmp(&p1[i].f,&p2[i].f,sizeof(GLfloat)) != 0) return 0;
+  }
+  return 1;
+}
+
+/*
+ * State changes whose only effect is to set a value: in a run of them,
+ * one with the same key as a later one can be dropped. The lights are
+ * not there (they are lit in the order they were enabled), nor
+ * GL_COLOR_MATERIAL (it changes what glColor does).
+ */
+static int state_key(GLParam *p)
+{
+  int op=p[0].op;
+
+  switch(op) {
+  case OP_Color:
+  case OP_Normal:
+  case OP_TexCoord:
+  case OP_EdgeFlag:
+  case OP_ShadeModel:
+  case OP_CullFace:
+  case OP_FrontFace:
+  case OP_MatrixMode:
+  case OP_PolygonOffset:
+    return (op + 1) << 16;
+  case OP_PolygonMode:
+    return ((op + 1) << 16) | (p[1].i & 0xffff);
+  case OP_EnableDisable:
+    switch(p[1].i) {
+    case GL_CULL_FACE:
+    case GL_LIGHTING:
+    case GL_TEXTURE_2D:
+    case GL_NORMALIZE:
+    case GL_DEPTH_TEST:
+    case GL_POLYGON_OFFSET_FILL:
+    case GL_POLYGON_OFFSET_POINT:
+    case GL_POLYGON_OFFSET_LINE:
+      return ((op + 1) << 16) | (p[1].i & 0xffff);
+    }
+    break;
+  }
+  return 0;
+}
+
+static int opt_state(GLContext *c,GLParam **ops,int nb_ops,int k)
+{
+  int e,i,j,key;
+
+  e=k;
+  while (e < nb_ops && state_key(ops[e]) != 0) e++;
+
+  for(i=k;i<e;i++) {
+    key=state_key(ops[i]);
+    for(j=i+1;j<e;j++) {
+      if (state_key(ops[j]) == key) break;
+    }
+    if (j == e) gl_compile_op(c,ops[i]);
+  }
+  return e;
+}
+
+static int matrix_op(int op)
+{
+  switch(op) {
+  case OP_LoadMatrix:
+  case OP_LoadIdentity:
+  case OP_MultMatrix:
+  case OP_Rotate:
+  case OP_Translate:
+  case OP_Scale:
+  case OP_Frustum:
+    return 1;
+  }
+  return 0;
+}
+
+static void run_matrix_op(GLContext *c,GLParam *p)
+{
+  switch(p[0].op) {
+  case OP_LoadMatrix: glopLoadMatrix(c,p); break;
+  case OP_LoadIdentity: glopLoadIdentity(c,p); break;
+  case OP_MultMatrix: glopMultMatrix(c,p); break;
+  case OP_Rotate: glopRotate(c,p); break;
+  case OP_Translate: glopTranslate(c,p); break;
+  case OP_Scale: glopScale(c,p); break;
+  case OP_Frustum: glopFrustum(c,p); break;
+  }
+}
+
+static int opt_matrix(GLContext *c,GLParam **ops,int nb_ops,int k)
+{
+  GLParam p[17];
+  M4 m,*saved;
+  int e,i,load,updated;
+
+  e=k;
+  load=-1;
+  while (e < nb_ops && matrix_op(ops[e][0].op)) {
+    if (ops[e][0].op == OP_LoadMatrix || ops[e][0].op == OP_LoadIdentity)
+      load=e;
+    e++;
+  }
+
+  if (load < 0) {
+    for(i=k;i<e;i++) gl_compile_op(c,ops[i]);
+    return e;
+  }
+  /* what is before the load is overwritten */
+  if (load == e - 1) {
+    gl_compile_op(c,ops[load]);
+    return e;
+  }
+
+  /* the ops from the load give a constant matrix */
+  saved=c->matrix_stack_ptr[c->matrix_mode];
+  updated=c->matrix_model_projection_updated;
+  c->matrix_stack_ptr[c->matrix_mode]=&m;
+  for(i=load;i<e;i++) run_matrix_op(c,ops[i]);
+  c->matrix_stack_ptr[c->matrix_mode]=saved;
+  c->matrix_model_projection_updated=updated;
+
+  p[0].op=OP_LoadMatrix;
+  for(i=0;i<16;i++) p[1 + i].f=m.m[i & 3][i >> 2];
+  gl_compile_op(c,p);
+  return e;
+}
+
+/* end of the glBegin / glEnd block at k, -1 if it cannot be packed */
+static int block_end(GLParam **ops,int nb_ops,int k,int *nb_vertices)
+{
+  int i;
+
+  for(i=k+1;i<nb_ops;i++) {
+    switch(ops[i][0].op) {
+    case OP_End:
+      return i;
+    case OP_Vertex:
+      (*nb_vertices)++;
+      break;
+    case OP_Color:
+    case OP_Normal:
+    case OP_TexCoord:
+    case OP_EdgeFlag:
+      break;
+    default:
+      return -1;
+    }
+  }
+  return -1;
+}
+
+/* # of vertices of the primitives which can be merged */
+static int primitive_size(int mode)
+{
+  switch(mode) {
+  case GL_POINTS: return 1;
+  case GL_LINES: return 2;
+  case GL_TRIANGLES: return 3;
+  case GL_QUADS: return 4;
+  }
+  return 0;
+}
+
+static unsigned int hash_vertex(GLfloat *v,int n)
+{
+  unsigned char *b=(unsigned char *)v;
+  unsigned int h=2166136261u;
+  int i;
+
+  for(i=0;i<n * (int)sizeof(GLfloat);i++)
+    h=(h ^ b[i]) * 16777619u;
+  return h;
+}
+
+/*
+ * Packs the vertices of the blocks from k to e, returns -1 if it cannot.
+ * 'known' are the attribute ops in effect before the blocks, NULL if
+ * not known at compile time.
+ */
+static int pack(GLContext *c,GLList *l,GLParam **ops,int k,int e,
+                int nb_vertices,GLParam **known)
+{
+  GLParam *cur[NB_ATTRS],*first[NB_ATTRS],*last[NB_ATTRS],*p,q[2];
+  int varies[NB_ATTRS],unknown[NB_ATTRS],after[NB_ATTRS];
+  int offset[NB_ATTRS];
+  GLfloat *tmp,*v;
+  int *table;
+  GLPacked *pk;
+  int a,i,j,n,stride,nb_unique,table_size,ret,color_set;
+  unsigned int h;
+
+  /* which attributes change from a vertex to another */
+  for(a=0;a<NB_ATTRS;a++) {
+    cur[a]=known[a];
+    first[a]=last[a]=NULL;
+    varies[a]=unknown[a]=after[a]=0;
+  }
+  color_set=0;
+  for(i=k;i<=e;i++) {
+    p=ops[i];
+    if (p[0].op == OP_Vertex) {
+      for(a=0;a<NB_ATTRS;a++) {
+        after[a]=0;
+        if (cur[a] == NULL)
+          unknown[a]=1;
+        else if (unknown[a])
+          /* the first vertices take the value it has at run time */
+          return -1;
+        else if (first[a] == NULL)
+          first[a]=cur[a];
+        else if (!same_attr(a,first[a],cur[a]))
+          varies[a]=1;
+      }
+      if (cur[ATTR_COLOR] != first[ATTR_COLOR])
+        color_set=1;
+    } else if ((a=attr_index(p[0].op)) >= 0) {
+      cur[a]=last[a]=p;
+      after[a]=1;
+    }
+  }
+  /* the arrays have no edge flags */
+  if (varies[ATTR_EDGE_FLAG]) return -1;
+  /* glColor() also sets the material if GL_COLOR_MATERIAL: a color set
+     between the vertices can only be moved to the array (or before) if
+     the first vertices had theirs set in the blocks too */
+  if (color_set && first[ATTR_COLOR] == known[ATTR_COLOR])
+    return -1;
+  /* a polygon or the end of a line loop is drawn at glEnd, clipped with
+     the current color if no lighting */
+  if ((ops[k][1].i == GL_POLYGON || ops[k][1].i == GL_LINE_LOOP) &&
+      after[ATTR_COLOR])
+    return -1;
+
+  stride=4;
+  for(a=0;a<ATTR_EDGE_FLAG;a++) {
+    offset[a]=stride;
+    if (varies[a]) stride+=attr_size[a];
+  }
+
+  ret=-1;
+  tmp=(GLfloat *)gl_malloc(nb_vertices * stride * sizeof(GLfloat));
+  table_size=1;
+  while (table_size < 2 * nb_vertices) table_size<<=1;
+  table=(int *)gl_malloc(table_size * sizeof(int));
+  pk=(GLPacked *)gl_zalloc(sizeof(GLPacked));
+  if (pk != NULL) {
+    pk->elements=(unsigned int *)
+      gl_malloc(nb_vertices * sizeof(unsigned int));
+  }
+  if (tmp == NULL || table == NULL || pk == NULL || pk->elements == NULL)
+    goto fail;
+
+  /* the vertices, the identical ones only once */
+  for(i=0;i<table_size;i++) table[i]=-1;
+  for(a=0;a<NB_ATTRS;a++) cur[a]=known[a];
+  nb_unique=0;
+  n=0;
+  for(i=k;i<=e;i++) {
+    p=ops[i];
+    if ((a=attr_index(p[0].op)) >= 0) {
+      cur[a]=p;
+      continue;
+    }
+    if (p[0].op != OP_Vertex)
+      continue;
+
+    v=tmp + nb_unique * stride;
+    for(j=0;j<4;j++) v[j]=p[1 + j].f;
+    for(a=0;a<ATTR_EDGE_FLAG;a++) {
+      if (varies[a]) {
+        for(j=0;j<attr_size[a];j++) v[offset[a] + j]=cur[a][1 + j].f;
+      }
+    }
+
+    h=hash_vertex(v,stride);
+    for(;;) {
+      j=table[h & (table_size - 1)];
+      if (j < 0) {
+        table[h & (table_size - 1)]=j=nb_unique++;
+        break;
+      }
+      if (memcmp(tmp + j * stride,v,stride * sizeof(GLfloat)) == 0)
+        break;
+      h++;
+    }
+    pk->elements[n++]=j;
+  }
+
+  pk->vertex=(GLfloat *)gl_malloc(nb_unique * stride * sizeof(GLfloat));
+  if (pk->vertex == NULL)
+    goto fail;
+  memcpy(pk->vertex,tmp,nb_unique * stride * sizeof(GLfloat));
+  pk->mode=ops[k][1].i;
+  pk->nb_elements=nb_vertices;
+  pk->stride=stride;
+  if (varies[ATTR_COLOR]) pk->color=pk->vertex + offset[ATTR_COLOR];
+  if (varies[ATTR_NORMAL]) pk->normal=pk->vertex + offset[ATTR_NORMAL];
+  if (varies[ATTR_TEX_COORD])
+    pk->tex_coord=pk->vertex + offset[ATTR_TEX_COORD];
+  pk->next=l->first_packed;
+  l->first_packed=pk;
+
+  /* the attributes which do not change are set before */
+  for(a=0;a<NB_ATTRS;a++) {
+    if (first[a] != NULL && first[a] != known[a] && !varies[a])
+      gl_compile_op(c,first[a]);
+  }
+  q[0].op=OP_DrawPacked;
+  q[1].p=pk;
+  gl_compile_op(c,q);
+  /* and the ones set after the last vertex after */
+  for(a=0;a<NB_ATTRS;a++) {
+    if (after[a]) gl_compile_op(c,last[a]);
+  }
+  pk=NULL;
+  ret=0;
+
+ fail:
+  if (pk != NULL) {
+    gl_free(pk->elements);
+    gl_free(pk);
+  }
+  gl_free(tmp);
+  gl_free(table);
+  return ret;
+}
+
+static int opt_begin(GLContext *c,GLList *l,GLParam **ops,int nb_ops,int k,
+                     GLParam **known)
+{
+  int mode,size,e,e1,i,j,nb_vertices,n;
+
+  mode=ops[k][1].i;
+  nb_vertices=0;
+  e=block_end(ops,nb_ops,k,&nb_vertices);
+  if (e < 0) {
+    gl_compile_op(c,ops[k]);
+    return k + 1;
+  }
+
+  /* merge the blocks which follow, with attributes in between */
+  size=primitive_size(mode);
+  while (size != 0 && nb_vertices % size == 0) {
+    j=e + 1;
+    while (j < nb_ops && attr_index(ops[j][0].op) >= 0) j++;
+    if (j == nb_ops || ops[j][0].op != OP_Begin || ops[j][1].i != mode)
+      break;
+    n=0;
+    e1=block_end(ops,nb_ops,j,&n);
+    if (e1 < 0)
+      break;
+    nb_vertices+=n;
+    e=e1;
+  }
+
+  if (nb_vertices == 0 || pack(c,l,ops,k,e,nb_vertices,known) != 0) {
+    for(i=k;i<=e;i++) gl_compile_op(c,ops[i]);
+  }
+  return e + 1;
+}
+
+void gl_optimize_list(GLContext *c,GLList *l)
+{
+  GLParamBuffer *old,*pb,*pb1;
+  GLParam **ops,**ops1,*p,*known[NB_ATTRS],q[1];
+  int nb_ops,max_ops,k,k1,op,a;
+
+  /* the ops of the list, until OP_EndList */
+  max_ops=256;
+  nb_ops=0;
+  ops=(GLParam **)gl_malloc(max_ops * sizeof(GLParam *));
+  if (ops == NULL) return;
+  p=l->first_op_buffer->ops;
+  for(;;) {
+    op=p[0].op;
+    if (op == OP_EndList) break;
+    if (op == OP_NextBuffer) {
+      p=(GLParam *)p[1].p;
+      continue;
+    }
+    if (nb_ops == max_ops) {
+      ops1=(GLParam **)gl_malloc(2 * max_ops * sizeof(GLParam *));
+      if (ops1 == NULL) {
+        gl_free(ops);
+        return;
+      }
+      memcpy(ops1,ops,nb_ops * sizeof(GLParam *));
+      gl_free(ops);
+      ops=ops1;
+      max_ops*=2;
+    }
+    ops[nb_ops++]=p;
+    p+=op_size[op];
+  }
+
+  /* written again in new buffers */
+  old=l->first_op_buffer;
+  l->first_op_buffer=(GLParamBuffer *)gl_zalloc(sizeof(GLParamBuffer));
+  if (l->first_op_buffer == NULL) {
+    l->first_op_buffer=old;
+    gl_free(ops);
+    return;
+  }
+  c->current_op_buffer=l->first_op_buffer;
+  c->current_op_buffer_index=0;
+
+  for(a=0;a<NB_ATTRS;a++) known[a]=NULL;
+  k=0;
+  while (k < nb_ops) {
+    p=ops[k];
+    if (p[0].op == OP_Begin) {
+      k1=opt_begin(c,l,ops,nb_ops,k,known);
+    } else if (matrix_op(p[0].op)) {
+      k1=opt_matrix(c,ops,nb_ops,k);
+    } else if (state_key(p) != 0) {
+      k1=opt_state(c,ops,nb_ops,k);
+    } else {
+      gl_compile_op(c,p);
+      k1=k + 1;
+    }
+
+    /* the current attributes after these ops */
+    for(;k<k1;k++) {
+      op=ops[k][0].op;
+      if ((a=attr_index(op)) >= 0) {
+        known[a]=ops[k];
+      } else if (op == OP_CallList || op == OP_ArrayElement) {
+        for(a=0;a<NB_ATTRS;a++) known[a]=NULL;
+      }
+    }
+  }
+  q[0].op=OP_EndList;
+  gl_compile_op(c,q);
+
+  pb=old;
+  while (pb != NULL) {
+    pb1=pb->next;
+    gl_free(pb);
+    pb=pb1;
+  }
+  gl_free(ops);
+}
+
+#else /* !TGL_FEATURE_LIST_OPT */
+
+void gl_optimize_list(GLContext *c,GLList *l)
+{
+}
+
+#endif /* TGL_FEATURE_LIST_OPT */
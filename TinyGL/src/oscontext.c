@@ -17,10 +17,16 @@ ostgl_create_context(const int xsize,
   ostgl_context *context;
   int i;
   ZBuffer *zb;
+  int mode;
    
-  assert(depth == 16); /* support for other depths must include bpp 
-                          convertion */
+  /* the frame buffers are drawn into: no conversion */
+#if TGL_FEATURE_RENDER_32
+  assert(depth == 16 || depth == 32);
+#else
+  assert(depth == 16);
+#endif
   assert(numbuffers >= 1);
+  mode = depth == 32 ? ZB_MODE_ARGB32 : ZB_MODE_5R6G5B;
   
   context = (ostgl_context *)gl_malloc(sizeof(ostgl_context));
   assert(context);
@@ -31,7 +37,7 @@ ostgl_create_context(const int xsize,
   
   for (i = 0; i < numbuffers; i++) {
     context->framebuffers[i] = framebuffers[i];
-    zb = ZB_open(xsize, ysize, ZB_MODE_5R6G5B, 0, NULL, NULL, framebuffers[i]);
+    zb = ZB_open(xsize, ysize, mode, 0, NULL, NULL, framebuffers[i]);
     if (zb == NULL) {
       fprintf(stderr, "Error while initializing Z buffer\n");
       exit(1);
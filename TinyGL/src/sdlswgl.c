@@ -42,6 +42,7 @@ int sdl_swgl_MakeCurrent( SDL_Surface *surface, sdl_swgl_Context *ctx ){
 	int	xsize;
 	int	ysize;
 	int	n_colors = 0;
+	void	*frame_buffer = NULL;
 	ZBuffer *zb;
 
 	if( ctx->gl_context == NULL ){
@@ -82,15 +83,24 @@ int sdl_swgl_MakeCurrent( SDL_Surface *surface, sdl_swgl_Context *ctx ){
 //				printf("TGL 24-bit\n");
 				break;
 			case 32:
+#if TGL_FEATURE_RENDER_32
+				/* drawn in the surface if the lines are
+				   contiguous, copied line by line otherwise */
+				ctx->pitch = surface->pitch;
+				mode = ZB_MODE_ARGB32;
+				if( surface->pitch == xsize * 4 )
+					frame_buffer = surface->pixels;
+#else
 				ctx->pitch = surface->pitch / 2;
 				mode = ZB_MODE_RGBA;
+#endif
 //				printf("TGL 32-bit\n");
 				break;
 			default:
 				return 0;
 				break;
 		}
-		zb = ZB_open( xsize, ysize, mode, n_colors, (unsigned char*)ctx->indexes, (int *)ctx->palette, NULL);
+		zb = ZB_open( xsize, ysize, mode, n_colors, (unsigned char*)ctx->indexes, (int *)ctx->palette, frame_buffer);
 		
 		if( zb == NULL ){
 //			fprintf( stderr, "Error while initializing Z buffer\n" ); 
@@ -166,6 +176,16 @@ void sdl_swgl_SwapBuffers(){
 }
 
 
+/*!  Draw triangles with a pool of threads (0: draw them at once)  */
+int sdl_swgl_SetThreads( int nb_threads ){
+	GLContext *gl_context;
+
+	gl_context = gl_get_context();
+	ZB_setThreads( gl_context->zb, nb_threads );
+	return gl_context->zb->tiles != NULL ? nb_threads : 0;
+}
+
+
 /*!  Resize context  */
 static int sdl_swgl_resize_viewport( GLContext *c, int *xsize_ptr, int *ysize_ptr ){
 	sdl_swgl_Context *ctx;
@@ -16,6 +16,15 @@ static GLTexture *find_texture(GLContext *c,int h)
   return NULL;
 }
 
+/* bits of the stored texels, at least 4 x 4 */
+#define STORED_BITS(bits) ((bits) < 2 ? 2 : (bits))
+
+static void free_image(GLImage *im)
+{
+  if (im->pixmap != NULL) gl_free(im->pixmap);
+  im->pixmap=NULL;
+}
+
 static void free_texture(GLContext *c,int h)
 {
   GLTexture *t,**ht;
@@ -32,9 +41,12 @@ static void free_texture(GLContext *c,int h)
   }
   if (t->next!=NULL) t->next->prev=t->prev;
 
+  /* triangles waiting to be drawn may use the texture */
+  ZB_flush(c->zb);
+
   for(i=0;i<MAX_TEXTURE_LEVELS;i++) {
     im=&t->images[i];
-    if (im->pixmap != NULL) gl_free(im->pixmap);
+    free_image(im);
   }
 
   gl_free(t);
@@ -54,10 +66,154 @@ GLTexture *alloc_texture(GLContext *c,int h)
   *ht=t;
 
   t->handle=h;
+  t->min_filter=GL_NEAREST;
+  t->mag_filter=GL_NEAREST;
   
   return t;
 }
 
+/* the power of 2 nearest to size, in bits */
+static int texture_bits(int size)
+{
+  int bits;
+
+  bits=0;
+  while (bits < ZB_TEXTURE_MAX_BITS && 2*size > (3 << bits)) bits++;
+  return bits;
+}
+
+/* the texel x, y of the level, which may be stretched */
+static unsigned int get_texel(GLImage *im,int x,int y)
+{
+  int wbits=STORED_BITS(im->wbits);
+  int i;
+
+  x<<=wbits - im->wbits;
+  y<<=STORED_BITS(im->hbits) - im->hbits;
+  i=ZB_TILE_INDEX(x,y,wbits);
+  if (im->psize == 4)
+    return ((unsigned int *)im->pixmap)[i];
+  else
+    return ((unsigned short *)im->pixmap)[i];
+}
+
+/* the mean of 4 texels, all the components at once */
+static unsigned int average_texels(int psize,unsigned int a,unsigned int b,
+                                   unsigned int c,unsigned int d)
+{
+  unsigned int v;
+
+  if (psize == 4) {
+    v=(((a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) +
+        (d & 0x00FF00FF) + 0x00020002) >> 2) & 0x00FF00FF;
+    v|=((((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) +
+         ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF) +
+         0x00020002) << 6) & 0xFF00FF00;
+    return v;
+  }
+#define SPREAD(c) (((c) | ((c) << 16)) & 0x07E0F81F)
+  v=((SPREAD(a) + SPREAD(b) + SPREAD(c) + SPREAD(d) + 0x00401002) >> 2) &
+    0x07E0F81F;
+#undef SPREAD
+  return (v | (v >> 16)) & 0xFFFF;
+}
+
+/*
+ * The missing levels of the mipmap, each one by a 2x2 box filter of the
+ * level above.
+ */
+static void make_mipmaps(GLTexture *t)
+{
+  GLImage *im,*im1;
+  int n,i,x,y,x1,y1,wbits,hbits,dx,dy,sw,sh,k;
+  unsigned int v;
+
+  im=&t->images[0];
+  n=(im->wbits > im->hbits ? im->wbits : im->hbits) + 1;
+  for(i=1;i<n;i++) {
+    im=&t->images[i];
+    if (im->pixmap != NULL) continue;
+    im1=&t->images[i-1];
+    wbits=im1->wbits > 0 ? im1->wbits - 1 : 0;
+    hbits=im1->hbits > 0 ? im1->hbits - 1 : 0;
+    dx=im1->wbits - wbits;
+    dy=im1->hbits - hbits;
+    sw=STORED_BITS(wbits);
+    sh=STORED_BITS(hbits);
+    im->pixmap=gl_malloc(im1->psize << (sw + sh));
+    if (im->pixmap == NULL) break;
+    im->xsize=1 << wbits;
+    im->ysize=1 << hbits;
+    im->wbits=wbits;
+    im->hbits=hbits;
+    im->psize=im1->psize;
+    im->generated=1;
+    for(y=0;y<(1 << sh);y++) {
+      for(x=0;x<(1 << sw);x++) {
+        x1=(x >> (sw - wbits)) << dx;
+        y1=(y >> (sh - hbits)) << dy;
+        v=average_texels(im->psize,
+                         get_texel(im1,x1,y1),get_texel(im1,x1+dx,y1),
+                         get_texel(im1,x1,y1+dy),
+                         get_texel(im1,x1+dx,y1+dy));
+        k=ZB_TILE_INDEX(x,y,sw);
+        if (im->psize == 4)
+          ((unsigned int *)im->pixmap)[k]=v;
+        else
+          ((unsigned short *)im->pixmap)[k]=v;
+      }
+    }
+  }
+  t->nb_levels=i;
+}
+
+/*
+ * Choose the level and the filter of the current texture for a triangle
+ * (for the whole triangle, from the ratio of its areas in the texture
+ * and on the screen), and give it to the Z buffer. Return 0 if there is
+ * no texture to draw the triangle with.
+ */
+int gl_set_texture_level(GLContext *c,GLVertex *p0,GLVertex *p1,
+                         GLVertex *p2)
+{
+  GLTexture *t=c->current_texture;
+  GLImage *im=&t->images[0];
+  int level,linear,mipmap;
+  float scr,tex;
+
+  if (im->pixmap == NULL || im->psize != c->zb->psize) return 0;
+
+  mipmap=(t->min_filter != GL_NEAREST && t->min_filter != GL_LINEAR);
+  linear=(t->min_filter == GL_LINEAR ||
+          t->min_filter == GL_LINEAR_MIPMAP_NEAREST ||
+          t->min_filter == GL_LINEAR_MIPMAP_LINEAR);
+  level=0;
+  if (mipmap || linear != (t->mag_filter == GL_LINEAR)) {
+    scr=(float)(p1->zp.x - p0->zp.x) * (float)(p2->zp.y - p0->zp.y) -
+        (float)(p2->zp.x - p0->zp.x) * (float)(p1->zp.y - p0->zp.y);
+    tex=((p1->tex_coord.X - p0->tex_coord.X) *
+         (p2->tex_coord.Y - p0->tex_coord.Y) -
+         (p2->tex_coord.X - p0->tex_coord.X) *
+         (p1->tex_coord.Y - p0->tex_coord.Y)) *
+        (float)(1 << (im->wbits + im->hbits));
+    if (scr < 0) scr=-scr;
+    if (tex < 0) tex=-tex;
+    if (tex <= scr) {
+      /* magnification */
+      linear=(t->mag_filter == GL_LINEAR);
+    } else if (mipmap) {
+      if (t->nb_levels == 0) make_mipmaps(t);
+      /* the level the nearest to a texel per pixel */
+      while (level < t->nb_levels - 1 && tex >= scr * (float)(2 << (2*level)))
+        level++;
+      im=&t->images[level];
+    }
+  }
+  ZB_setTextureLevel(c->zb,im->pixmap,
+                     STORED_BITS(im->wbits),STORED_BITS(im->hbits),linear);
+  return 1;
+}
+
 
 void glInitTextures(GLContext *c)
 {
@@ -132,35 +288,68 @@ void glopTexImage2D(GLContext *c,GLParam *p)
   int format=p[7].i;
   int type=p[8].i;
   void *pixels=p[9].p;
+  GLTexture *t;
   GLImage *im;
   unsigned char *pixels1;
-  int do_free;
+  int do_free,wbits,hbits,psize,i;
 
-  if (!(target == GL_TEXTURE_2D && level == 0 && components == 3 && 
+  if (!(target == GL_TEXTURE_2D && level >= 0 &&
+        level < MAX_TEXTURE_LEVELS && components == 3 &&
         border == 0 && format == GL_RGB &&
         type == GL_UNSIGNED_BYTE)) {
     gl_fatal_error("glTexImage2D: combinaison of parameters not handled");
   }
+
+  t=c->current_texture;
+  if (level == 0 || t->images[0].pixmap == NULL) {
+    wbits=texture_bits(width);
+    hbits=texture_bits(height);
+  } else {
+    /* the size of the level in the mipmap of level 0 */
+    wbits=t->images[0].wbits > level ? t->images[0].wbits - level : 0;
+    hbits=t->images[0].hbits > level ? t->images[0].hbits - level : 0;
+  }
   
   do_free=0;
-  if (width != 256 || height != 256) {
-    pixels1 = (unsigned char *)gl_malloc(256 * 256 * 3);
+  if (width != (1 << wbits) || height != (1 << hbits)) {
+    pixels1 = (unsigned char *)gl_malloc(3 << (wbits + hbits));
     /* no interpolation is done here to respect the original image aliasing ! */
-    gl_resizeImageNoInterpolate(pixels1,256,256,(unsigned char*)pixels,width,height);
+    gl_resizeImageNoInterpolate(pixels1,1 << wbits,1 << hbits,
+                                (unsigned char*)pixels,width,height);
     do_free=1;
-    width=256;
-    height=256;
+    width=1 << wbits;
+    height=1 << hbits;
   } else {
     pixels1=(unsigned char*)pixels;
   }
 
-  im=&c->current_texture->images[level];
+  ZB_flush(c->zb);
+  if (level == 0) {
+    /* the other levels are made again if they do not fit any more */
+    for(i=1;i<MAX_TEXTURE_LEVELS;i++) {
+      im=&t->images[i];
+      if (im->pixmap != NULL &&
+          (im->generated ||
+           im->wbits != (wbits > i ? wbits - i : 0) ||
+           im->hbits != (hbits > i ? hbits - i : 0)))
+        free_image(im);
+    }
+  }
+  t->nb_levels=0;
+
+  /* the texels are in the format of the Z buffer */
+  psize=c->zb->psize;
+  im=&t->images[level];
+  free_image(im);
   im->xsize=width;
   im->ysize=height;
-  if (im->pixmap!=NULL) gl_free(im->pixmap);
-  im->pixmap=gl_malloc(width*height*2);
+  im->wbits=wbits;
+  im->hbits=hbits;
+  im->psize=psize;
+  im->generated=0;
+  im->pixmap=gl_malloc(psize << (STORED_BITS(wbits) + STORED_BITS(hbits)));
   if(im->pixmap) {
-      gl_convertRGB_to_5R6G5B((unsigned short *)im->pixmap,pixels1,width,height);
+      gl_convertRGB_to_texture(im->pixmap,psize,pixels1,wbits,hbits);
   }
   if (do_free) gl_free(pixels1);
 }
@@ -200,6 +389,26 @@ void glopTexParameter(GLContext *c,GLParam *p)
   case GL_TEXTURE_WRAP_T:
     if (param != GL_REPEAT) goto error;
     break;
+  case GL_TEXTURE_MAG_FILTER:
+    if (param != GL_NEAREST && param != GL_LINEAR) goto error;
+    c->current_texture->mag_filter=param;
+    break;
+  case GL_TEXTURE_MIN_FILTER:
+    /* no filtering between two levels: the *_MIPMAP_LINEAR filters are
+       the *_MIPMAP_NEAREST ones */
+    switch(param) {
+    case GL_NEAREST:
+    case GL_LINEAR:
+    case GL_NEAREST_MIPMAP_NEAREST:
+    case GL_LINEAR_MIPMAP_NEAREST:
+    case GL_NEAREST_MIPMAP_LINEAR:
+    case GL_LINEAR_MIPMAP_LINEAR:
+      break;
+    default:
+      goto error;
+    }
+    c->current_texture->min_filter=param;
+    break;
   }
 }
 
@@ -25,7 +25,7 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
     zb->xsize = xsize;
     zb->ysize = ysize;
     zb->mode = mode;
-    zb->linesize = (xsize * PSZB + 3) & ~3;
+    zb->psize = PSZB;
 
     switch (mode) {
 #ifdef TGL_FEATURE_8_BITS
@@ -42,9 +42,16 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
     case ZB_MODE_5R6G5B:
 	zb->nb_colors = 0;
 	break;
+#if TGL_FEATURE_RENDER_32
+    case ZB_MODE_ARGB32:
+	zb->nb_colors = 0;
+	zb->psize = 4;
+	break;
+#endif
     default:
 	goto error;
     }
+    zb->linesize = (xsize * zb->psize + 3) & ~3;
 
     size = zb->xsize * zb->ysize * sizeof(unsigned short);
     zb->zbuf = (short unsigned int *)gl_malloc(size);
@@ -63,7 +70,11 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
 	zb->pbuf = (PIXEL *)frame_buffer;
     }
 
-    zb->current_texture = NULL;
+    memset(&zb->current_texture, 0, sizeof(zb->current_texture));
+    zb->ymin = 0;
+    zb->ymax = zb->ysize;
+    zb->tiles = NULL;
+    zb->spans = ZB_simdSpans();
 
     return zb;
   error:
@@ -73,6 +84,8 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
 
 void ZB_close(ZBuffer * zb)
 {
+    ZB_setThreads(zb, 0);
+
 #ifdef TGL_FEATURE_8_BITS
     if (zb->mode == ZB_MODE_INDEX)
 	ZB_closeDither(zb);
@@ -87,14 +100,19 @@ void ZB_close(ZBuffer * zb)
 
 void ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize)
 {
-    int size;
+    int size, nb_threads;
+
+    /* the bands depend on the size: start again with new ones */
+    nb_threads = ZB_setThreads(zb, 0);
 
     /* xsize must be a multiple of 4 */
     xsize = xsize & ~3;
 
     zb->xsize = xsize;
     zb->ysize = ysize;
-    zb->linesize = (xsize * PSZB + 3) & ~3;
+    zb->linesize = (xsize * zb->psize + 3) & ~3;
+    zb->ymin = 0;
+    zb->ymax = ysize;
 
     size = zb->xsize * zb->ysize * sizeof(unsigned short);
 
@@ -111,6 +129,8 @@ void ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize)
 	zb->pbuf = (PIXEL *)frame_buffer;
 	zb->frame_buffer_allocated = 0;
     }
+
+    ZB_setThreads(zb, nb_threads);
 }
 
 static void ZB_copyBuffer(ZBuffer * zb,
@@ -123,7 +143,7 @@ static void ZB_copyBuffer(ZBuffer * zb,
 
     q = zb->pbuf;
     p1 = (unsigned char *)buf;
-    n = zb->xsize * PSZB;
+    n = zb->xsize * zb->psize;
     for (y = 0; y < zb->ysize; y++) {
 	memcpy(p1, q, n);
 	p1 += linesize;
@@ -274,6 +294,8 @@ static void ZB_copyFrameBufferRGB24(ZBuffer * zb,
 void ZB_copyFrameBuffer(ZBuffer * zb, void *buf,
 			int linesize)
 {
+    ZB_flush(zb);
+
     switch (zb->mode) {
 #ifdef TGL_FEATURE_8_BITS
     case ZB_MODE_INDEX:
@@ -294,6 +316,13 @@ void ZB_copyFrameBuffer(ZBuffer * zb, void *buf,
     case ZB_MODE_RGB24:
 	ZB_copyFrameBufferRGB24(zb, buf, linesize >> 1);
 	break;
+#endif
+#if TGL_FEATURE_RENDER_32
+    case ZB_MODE_ARGB32:
+	/* nothing to do if the frame buffer is the display */
+	if (buf != zb->pbuf)
+	    ZB_copyBuffer(zb, buf, linesize);
+	break;
 #endif
     default:
 	assert(0);
@@ -387,11 +416,22 @@ void ZB_clear(ZBuffer * zb, int clear_z, int z,
     int y;
     PIXEL *pp;
 
+    ZB_flush(zb);
+
     if (clear_z) {
 	memset_s(zb->zbuf, z, zb->xsize * zb->ysize);
     }
     if (clear_color) {
 	pp = zb->pbuf;
+#if TGL_FEATURE_RENDER_32
+	if (zb->psize == 4) {
+	    for (y = 0; y < zb->ysize; y++) {
+		memset_l(pp, RGB_TO_PIXEL32(r, g, b), zb->xsize);
+		pp = (PIXEL *) ((char *) pp + zb->linesize);
+	    }
+	    return;
+	}
+#endif
 	for (y = 0; y < zb->ysize; y++) {
             color = RGB_TO_PIXEL(r, g, b);
 	    memset_s(pp, color, zb->xsize);
@@ -116,6 +116,8 @@ void ZB_ditherFrameBuffer(ZBuffer *zb,unsigned char *buf,
 
   assert( ((long)buf & 1) == 0 && (linesize & 1) == 0);
 
+  ZB_flush(zb);
+
   for(yk=0;yk<4;yk++) {
     for(xk=0;xk<4;xk+=2) {
 #if BYTE_ORDER == BIG_ENDIAN
@@ -3,12 +3,34 @@
 
 #define ZCMP(z,zpix) ((z) >= (zpix))
 
+#if TGL_FEATURE_RENDER_32
+/* ZB_MODE_ARGB32, at the end of the file */
+static void ZB_plot32(ZBuffer * zb, ZBufferPoint * p);
+static void ZB_line_flat_z32(ZBuffer * zb, ZBufferPoint * p1,
+                             ZBufferPoint * p2, int color);
+static void ZB_line_interp_z32(ZBuffer * zb, ZBufferPoint * p1,
+                               ZBufferPoint * p2);
+static void ZB_line_flat32(ZBuffer * zb, ZBufferPoint * p1,
+                           ZBufferPoint * p2, int color);
+static void ZB_line_interp32(ZBuffer * zb, ZBufferPoint * p1,
+                             ZBufferPoint * p2);
+#endif
+
 void ZB_plot(ZBuffer * zb, ZBufferPoint * p)
 {
     unsigned short *pz;
     PIXEL *pp;
     int zz;
 
+    ZB_flush(zb);
+
+#if TGL_FEATURE_RENDER_32
+    if (zb->psize == 4) {
+        ZB_plot32(zb, p);
+        return;
+    }
+#endif
+
     pz = zb->zbuf + (p->y * zb->xsize + p->x);
     pp = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p->y + p->x * PSZB);
     zz = p->z >> ZB_POINT_Z_FRAC_BITS;
@@ -51,6 +73,20 @@ void ZB_line_z(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2)
 {
     int color1, color2;
 
+    ZB_flush(zb);
+
+#if TGL_FEATURE_RENDER_32
+    if (zb->psize == 4) {
+        color1 = RGB_TO_PIXEL32(p1->r, p1->g, p1->b);
+        color2 = RGB_TO_PIXEL32(p2->r, p2->g, p2->b);
+        if (color1 == color2)
+            ZB_line_flat_z32(zb, p1, p2, color1);
+        else
+            ZB_line_interp_z32(zb, p1, p2);
+        return;
+    }
+#endif
+
     color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
     color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
 
@@ -66,6 +102,20 @@ void ZB_line(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2)
 {
     int color1, color2;
 
+    ZB_flush(zb);
+
+#if TGL_FEATURE_RENDER_32
+    if (zb->psize == 4) {
+        color1 = RGB_TO_PIXEL32(p1->r, p1->g, p1->b);
+        color2 = RGB_TO_PIXEL32(p2->r, p2->g, p2->b);
+        if (color1 == color2)
+            ZB_line_flat32(zb, p1, p2, color1);
+        else
+            ZB_line_interp32(zb, p1, p2);
+        return;
+    }
+#endif
+
     color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
     color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
 
@@ -77,3 +127,57 @@ void ZB_line(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2)
         ZB_line_interp(zb, p1, p2);
     }
 }
+
+#if TGL_FEATURE_RENDER_32
+
+/* the same in the pixel format of ZB_MODE_ARGB32 */
+#undef PSZB
+#define PSZB 4
+#define PIXEL PIXEL32
+#undef RGB_TO_PIXEL
+#define RGB_TO_PIXEL RGB_TO_PIXEL32
+
+static void ZB_plot32(ZBuffer * zb, ZBufferPoint * p)
+{
+    unsigned short *pz;
+    PIXEL *pp;
+    int zz;
+
+    pz = zb->zbuf + (p->y * zb->xsize + p->x);
+    pp = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p->y + p->x * PSZB);
+    zz = p->z >> ZB_POINT_Z_FRAC_BITS;
+    if (ZCMP(zz, *pz)) {
+	*pp = RGB_TO_PIXEL(p->r, p->g, p->b);
+	*pz = zz;
+    }
+}
+
+#define INTERP_Z
+static void ZB_line_flat_z32(ZBuffer * zb, ZBufferPoint * p1,
+                             ZBufferPoint * p2, int color)
+{
+#include <GL/zline.h>
+}
+
+#define INTERP_Z
+#define INTERP_RGB
+static void ZB_line_interp_z32(ZBuffer * zb, ZBufferPoint * p1,
+                               ZBufferPoint * p2)
+{
+#include <GL/zline.h>
+}
+
+static void ZB_line_flat32(ZBuffer * zb, ZBufferPoint * p1,
+                           ZBufferPoint * p2, int color)
+{
+#include <GL/zline.h>
+}
+
+#define INTERP_RGB
+static void ZB_line_interp32(ZBuffer * zb, ZBufferPoint * p1,
+                             ZBufferPoint * p2)
+{
+#include <GL/zline.h>
+}
+
+#endif
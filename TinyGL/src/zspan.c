@@ -0,0 +1,406 @@
+/*
+ * SIMD span fillers.
+ *
+ * The triangle functions of ztriangle.c draw their scanlines with these
+ * when zb->spans is not NULL (ZB_open() sets it to ZB_simdSpans(), it can
+ * be set back to NULL to use the scalar code). They draw 8 pixels at a
+ * time and give exactly the same pixels and Z values as the scalar code:
+ * the Z test and the Z/color stores are done with masks, and the color
+ * and the texture coordinates are stepped per lane the same way as
+ * PUT_PIXEL() does.
+ *
+ * Only the SSE2 version for 16 bit rendering (not ZB_MODE_ARGB32, nor
+ * the bilinear filtering) exists for now. The
+ * perspective mapping does the same float operations as the scalar
+ * code, so it needs the floating point (not USE_FIXED_POINT) build, with
+ * SSE math (see TGL_FEATURE_SIMD).
+ */
+#include <stdlib.h>
+#include <GL/zbuffer.h>
+
+#if TGL_FEATURE_SIMD && TGL_FEATURE_RENDER_BITS == 16 && \
+    !defined(USE_FIXED_POINT)
+
+#include <emmintrin.h>
+
+/* 4 lanes: v, v + d, v + 2 * d, v + 3 * d */
+static inline __m128i ramp(unsigned int v, unsigned int d)
+{
+    return _mm_setr_epi32(v, v + d, v + 2 * d, v + 3 * d);
+}
+
+/* 8 x 16 bits from the low 16 bits of two 4 x 32 bits */
+static inline __m128i pack_low16(__m128i a, __m128i b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+/*
+ * Z test of 8 pixels: 'zz' gets the 8 new Z values, and the result is
+ * 0xFFFF for the pixels which fail the test (ZCMP in ztriangle.c). The
+ * Z values are 18 bits at most, so signed compares are fine.
+ */
+static inline __m128i z_test(unsigned short *pz, __m128i z0, __m128i z1,
+				  __m128i *zz)
+{
+    __m128i zpix, zero, fail0, fail1;
+
+    z0 = _mm_srli_epi32(z0, ZB_POINT_Z_FRAC_BITS);
+    z1 = _mm_srli_epi32(z1, ZB_POINT_Z_FRAC_BITS);
+    zero = _mm_setzero_si128();
+    zpix = _mm_loadu_si128((__m128i *) pz);
+    fail0 = _mm_cmpgt_epi32(_mm_unpacklo_epi16(zpix, zero), z0);
+    fail1 = _mm_cmpgt_epi32(_mm_unpackhi_epi16(zpix, zero), z1);
+    *zz = pack_low16(z0, z1);
+    return _mm_packs_epi32(fail0, fail1);
+}
+
+/* store 'v' where 'fail' is 0 */
+static inline void store_masked(unsigned short *p, __m128i v, __m128i fail)
+{
+    __m128i old = _mm_loadu_si128((__m128i *) p);
+
+    v = _mm_or_si128(_mm_and_si128(fail, old), _mm_andnot_si128(fail, v));
+    _mm_storeu_si128((__m128i *) p, v);
+}
+
+static void span_flat_sse2(PIXEL *pp, unsigned short *pz, int n,
+				unsigned int z, int dzdx, PIXEL color)
+{
+    __m128i z0, z1, dz, zz, fail, c;
+    unsigned int zi;
+
+    z0 = ramp(z, dzdx);
+    z1 = ramp(z + 4 * dzdx, dzdx);
+    dz = _mm_set1_epi32(8 * dzdx);
+    c = _mm_set1_epi16(color);
+    while (n >= 8) {
+	fail = z_test(pz, z0, z1, &zz);
+	if (_mm_movemask_epi8(fail) != 0xFFFF) {
+	    store_masked(pz, zz, fail);
+	    store_masked(pp, c, fail);
+	}
+	z0 = _mm_add_epi32(z0, dz);
+	z1 = _mm_add_epi32(z1, dz);
+	z += 8 * dzdx;
+	pp += 8;
+	pz += 8;
+	n -= 8;
+    }
+    while (n > 0) {
+	zi = z >> ZB_POINT_Z_FRAC_BITS;
+	if (zi >= *pz) {
+	    *pp = color;
+	    *pz = zi;
+	}
+	z += dzdx;
+	pp++;
+	pz++;
+	n--;
+    }
+}
+
+/*
+ * 'rgb' is the packed color of ZB_fillTriangleSmooth(): red in bits
+ * 22-31, blue in 12-20 and green in 0-10, with the bits in between
+ * cleared after each step. This is the same as adding the deltas to the
+ * 3 fields separately, so k steps are one step with k times the deltas.
+ */
+#define RGB_GUARD 0x00200800
+
+static unsigned int rgb_delta(unsigned int drgbdx, int k)
+{
+    return ((drgbdx & 0xFFC00000) * k) |
+	(((drgbdx & 0x001FF000) * k) & 0x001FF000) |
+	(((drgbdx & 0x000007FF) * k) & 0x000007FF);
+}
+
+static inline __m128i rgb_to_pixel(__m128i rgb)
+{
+    __m128i tmp = _mm_and_si128(rgb, _mm_set1_epi32(0xF81F07E0));
+
+    return _mm_or_si128(tmp, _mm_srli_epi32(tmp, 16));
+}
+
+static void span_smooth_sse2(PIXEL *pp, unsigned short *pz, int n,
+				  unsigned int z, int dzdx,
+				  unsigned int rgb, unsigned int drgbdx)
+{
+    __m128i z0, z1, dz, c0, c1, drgb, guard, zz, fail;
+    unsigned int zi, tmp, d1, d4, d8;
+
+    d1 = drgbdx;
+    d4 = rgb_delta(drgbdx, 4);
+    d8 = rgb_delta(drgbdx, 8);
+    z0 = ramp(z, dzdx);
+    z1 = ramp(z + 4 * dzdx, dzdx);
+    dz = _mm_set1_epi32(8 * dzdx);
+    c0 = _mm_setr_epi32(rgb,
+			(rgb + d1) & ~RGB_GUARD,
+			(rgb + rgb_delta(d1, 2)) & ~RGB_GUARD,
+			(rgb + rgb_delta(d1, 3)) & ~RGB_GUARD);
+    guard = _mm_set1_epi32(RGB_GUARD);
+    c1 = _mm_andnot_si128(guard, _mm_add_epi32(c0, _mm_set1_epi32(d4)));
+    drgb = _mm_set1_epi32(d8);
+    while (n >= 8) {
+	fail = z_test(pz, z0, z1, &zz);
+	if (_mm_movemask_epi8(fail) != 0xFFFF) {
+	    store_masked(pz, zz, fail);
+	    store_masked(pp, pack_low16(rgb_to_pixel(c0), rgb_to_pixel(c1)),
+			 fail);
+	}
+	z0 = _mm_add_epi32(z0, dz);
+	z1 = _mm_add_epi32(z1, dz);
+	c0 = _mm_andnot_si128(guard, _mm_add_epi32(c0, drgb));
+	c1 = _mm_andnot_si128(guard, _mm_add_epi32(c1, drgb));
+	z += 8 * dzdx;
+	rgb = (rgb + d8) & ~RGB_GUARD;
+	pp += 8;
+	pz += 8;
+	n -= 8;
+    }
+    while (n > 0) {
+	zi = z >> ZB_POINT_Z_FRAC_BITS;
+	if (zi >= *pz) {
+	    tmp = rgb & 0xF81F07E0;
+	    *pp = tmp | (tmp >> 16);
+	    *pz = zi;
+	}
+	z += dzdx;
+	rgb = (rgb + d1) & ~RGB_GUARD;
+	pp++;
+	pz++;
+	n--;
+    }
+}
+
+/* 8 texels, 'index' is aligned */
+static inline __m128i fetch8(PIXEL *texture, unsigned int *index)
+{
+    __m128i v = _mm_cvtsi32_si128(texture[index[0]]);
+
+    v = _mm_insert_epi16(v, texture[index[1]], 1);
+    v = _mm_insert_epi16(v, texture[index[2]], 2);
+    v = _mm_insert_epi16(v, texture[index[3]], 3);
+    v = _mm_insert_epi16(v, texture[index[4]], 4);
+    v = _mm_insert_epi16(v, texture[index[5]], 5);
+    v = _mm_insert_epi16(v, texture[index[6]], 6);
+    v = _mm_insert_epi16(v, texture[index[7]], 7);
+    return v;
+}
+
+/* the shift counts and masks of ZB_TEXEL() */
+typedef struct TexelIndex {
+    __m128i shift[4], mask[4];
+} TexelIndex;
+
+static inline void texel_setup(TexelIndex *ti, const ZBTexture *tex)
+{
+    int k;
+
+    for (k = 0; k < 4; k++) {
+	ti->shift[k] = _mm_cvtsi32_si128(tex->shift[k]);
+	ti->mask[k] = _mm_set1_epi32(tex->mask[k]);
+    }
+}
+
+/* ZB_TEXEL() of 4 pixels */
+static inline __m128i texel_index(const TexelIndex *ti, __m128i s, __m128i t)
+{
+    __m128i i;
+
+    i = _mm_and_si128(_mm_srl_epi32(s, ti->shift[0]), ti->mask[0]);
+    i = _mm_or_si128(i, _mm_and_si128(_mm_srl_epi32(s, ti->shift[1]),
+				      ti->mask[1]));
+    i = _mm_or_si128(i, _mm_and_si128(_mm_srl_epi32(t, ti->shift[2]),
+				      ti->mask[2]));
+    return _mm_or_si128(i, _mm_and_si128(_mm_srl_epi32(t, ti->shift[3]),
+					 ti->mask[3]));
+}
+
+/*
+ * Affine mapping: the texel index is ZB_TEXEL(), always inside the
+ * texture. There is no gather in SSE2: the indexes are computed 8 at a
+ * time, and the texels read one by one.
+ */
+static void span_mapping_sse2(PIXEL *pp, unsigned short *pz, int n,
+				   unsigned int z, int dzdx,
+				   unsigned int s, int dsdx,
+				   unsigned int t, int dtdx,
+				   const ZBTexture *tex)
+{
+    __m128i z0, z1, dz, s0, s1, ds, t0, t1, dt, zz, fail;
+    unsigned int index[8] __attribute__((aligned(16)));
+    PIXEL *texture = (PIXEL *) tex->pixmap;
+    TexelIndex ti;
+    unsigned int zi;
+
+    z0 = ramp(z, dzdx);
+    z1 = ramp(z + 4 * dzdx, dzdx);
+    dz = _mm_set1_epi32(8 * dzdx);
+    s0 = ramp(s, dsdx);
+    s1 = ramp(s + 4 * dsdx, dsdx);
+    ds = _mm_set1_epi32(8 * dsdx);
+    t0 = ramp(t, dtdx);
+    t1 = ramp(t + 4 * dtdx, dtdx);
+    dt = _mm_set1_epi32(8 * dtdx);
+    texel_setup(&ti, tex);
+    while (n >= 8) {
+	fail = z_test(pz, z0, z1, &zz);
+	if (_mm_movemask_epi8(fail) != 0xFFFF) {
+	    _mm_store_si128((__m128i *) index, texel_index(&ti, s0, t0));
+	    _mm_store_si128((__m128i *) (index + 4), texel_index(&ti, s1, t1));
+	    store_masked(pz, zz, fail);
+	    store_masked(pp, fetch8(texture, index), fail);
+	}
+	z0 = _mm_add_epi32(z0, dz);
+	z1 = _mm_add_epi32(z1, dz);
+	s0 = _mm_add_epi32(s0, ds);
+	s1 = _mm_add_epi32(s1, ds);
+	t0 = _mm_add_epi32(t0, dt);
+	t1 = _mm_add_epi32(t1, dt);
+	z += 8 * dzdx;
+	s += 8 * dsdx;
+	t += 8 * dtdx;
+	pp += 8;
+	pz += 8;
+	n -= 8;
+    }
+    while (n > 0) {
+	zi = z >> ZB_POINT_Z_FRAC_BITS;
+	if (zi >= *pz) {
+	    *pp = texture[ZB_TEXEL(tex, s, t)];
+	    *pz = zi;
+	}
+	z += dzdx;
+	s += dsdx;
+	t += dtdx;
+	pp++;
+	pz++;
+	n--;
+    }
+}
+
+/*
+ * Perspective mapping: s and t are computed exactly every 8 pixels from
+ * s*z, t*z and 1/z, and interpolated in between. The 4 divisions of 4
+ * groups of 8 pixels are done together, then the s, t gradients, with the
+ * same float and double operations as DRAW_LINE() in ztriangle.c, so the
+ * results are the same.
+ */
+static void span_perspective_sse2(PIXEL *pp, unsigned short *pz, int n,
+				       unsigned int z, int dzdx,
+				       ffp sz, ffp tz, const ZBSpanGradients *g,
+				       const ZBTexture *tex)
+{
+    __m128i z0, z1, dz, s0, t0, zz, fail;
+    __m128 zinv, ss, tt;
+    __m128d one;
+    int st[16] __attribute__((aligned(16)));
+    unsigned int index[8] __attribute__((aligned(16)));
+    PIXEL *texture = (PIXEL *) tex->pixmap;
+    TexelIndex ti;
+    unsigned int s, t, zi;
+    double fz, f1, f2, f3;
+    ffp sz1, sz2, sz3, tz1, tz2, tz3;
+    int k, dsdx, dtdx;
+
+    z0 = ramp(z, dzdx);
+    z1 = ramp(z + 4 * dzdx, dzdx);
+    dz = _mm_set1_epi32(8 * dzdx);
+    texel_setup(&ti, tex);
+    one = _mm_set1_pd(1.0);
+    fz = (int) z;
+    while (n > 0) {
+	/* s, dsdx, t, dtdx of the next 4 groups */
+	f1 = fz + g->fndzdx;
+	f2 = f1 + g->fndzdx;
+	f3 = f2 + g->fndzdx;
+	sz1 = sz + g->ndszdx;
+	sz2 = sz1 + g->ndszdx;
+	sz3 = sz2 + g->ndszdx;
+	tz1 = tz + g->ndtzdx;
+	tz2 = tz1 + g->ndtzdx;
+	tz3 = tz2 + g->ndtzdx;
+	zinv = _mm_movelh_ps(
+	    _mm_cvtpd_ps(_mm_div_pd(one, _mm_setr_pd(fz, f1))),
+	    _mm_cvtpd_ps(_mm_div_pd(one, _mm_setr_pd(f2, f3))));
+	ss = _mm_mul_ps(_mm_setr_ps(sz, sz1, sz2, sz3), zinv);
+	tt = _mm_mul_ps(_mm_setr_ps(tz, tz1, tz2, tz3), zinv);
+	_mm_store_si128((__m128i *) st, _mm_cvttps_epi32(ss));
+	_mm_store_si128((__m128i *) (st + 4), _mm_cvttps_epi32(_mm_mul_ps(
+	    _mm_sub_ps(_mm_set1_ps(g->dszdx),
+		       _mm_mul_ps(ss, _mm_set1_ps((float) g->fdzdx))), zinv)));
+	_mm_store_si128((__m128i *) (st + 8), _mm_cvttps_epi32(tt));
+	_mm_store_si128((__m128i *) (st + 12), _mm_cvttps_epi32(_mm_mul_ps(
+	    _mm_sub_ps(_mm_set1_ps(g->dtzdx),
+		       _mm_mul_ps(tt, _mm_set1_ps((float) g->fdzdx))), zinv)));
+	fz = f3 + g->fndzdx;
+	sz = sz3 + g->ndszdx;
+	tz = tz3 + g->ndtzdx;
+
+	for (k = 0; k < 4 && n >= 8; k++) {
+	    fail = z_test(pz, z0, z1, &zz);
+	    if (_mm_movemask_epi8(fail) != 0xFFFF) {
+		s0 = ramp(st[k], st[4 + k]);
+		t0 = ramp(st[8 + k], st[12 + k]);
+		_mm_store_si128((__m128i *) index, texel_index(&ti, s0, t0));
+		s0 = _mm_add_epi32(s0, _mm_set1_epi32(4 * st[4 + k]));
+		t0 = _mm_add_epi32(t0, _mm_set1_epi32(4 * st[12 + k]));
+		_mm_store_si128((__m128i *) (index + 4),
+				texel_index(&ti, s0, t0));
+		store_masked(pz, zz, fail);
+		store_masked(pp, fetch8(texture, index), fail);
+	    }
+	    z0 = _mm_add_epi32(z0, dz);
+	    z1 = _mm_add_epi32(z1, dz);
+	    z += 8 * dzdx;
+	    pp += 8;
+	    pz += 8;
+	    n -= 8;
+	}
+	if (k < 4 && n > 0) {
+	    /* the last pixels */
+	    s = st[k];
+	    dsdx = st[4 + k];
+	    t = st[8 + k];
+	    dtdx = st[12 + k];
+	    while (n > 0) {
+		zi = z >> ZB_POINT_Z_FRAC_BITS;
+		if (zi >= *pz) {
+		    *pp = texture[ZB_TEXEL(tex, s, t)];
+		    *pz = zi;
+		}
+		z += dzdx;
+		s += dsdx;
+		t += dtdx;
+		pp++;
+		pz++;
+		n--;
+	    }
+	}
+    }
+}
+
+static const ZBSpans sse2_spans = {
+    span_flat_sse2,
+    span_smooth_sse2,
+    span_mapping_sse2,
+    span_perspective_sse2,
+};
+
+const ZBSpans *ZB_simdSpans(void)
+{
+    return &sse2_spans;
+}
+
+#else /* !TGL_FEATURE_SIMD */
+
+const ZBSpans *ZB_simdSpans(void)
+{
+    return NULL;
+}
+
+#endif /* TGL_FEATURE_SIMD */
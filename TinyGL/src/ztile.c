@@ -0,0 +1,256 @@
+/*
+ * Deferred, multithreaded triangle rendering.
+ *
+ * Instead of being drawn at once, triangles are binned into bands of
+ * ZB_TILE_LINES scanlines. At ZB_flush() (called before anything else
+ * touches the Z buffer or the frame buffer), a pool of threads draws the
+ * bands in parallel. Each band is drawn by one thread, with the usual
+ * ZB_fillTriangle* functions clipped to its scanlines, in the order the
+ * triangles were given, so the result is exactly the same as when drawing
+ * them at once.
+ */
+#include <stdlib.h>
+#include <GL/zbuffer.h>
+
+#if TGL_FEATURE_THREADS
+
+#include <pthread.h>
+
+#define ZB_TILE_MAX_THREADS 64
+
+typedef struct {
+    ZB_fillTriangleFunc fill;
+    ZBTexture texture;		/* the level and filter it is drawn with */
+    ZBufferPoint p[3];
+} ZBTriangle;
+
+typedef struct ZBTiles {
+    ZBuffer *zb;
+    int nb_threads;		/* including the caller of ZB_flush() */
+    pthread_t threads[ZB_TILE_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    int generation;		/* incremented at each flush */
+    int next_band;		/* next band to draw */
+    int nb_busy;		/* threads still drawing */
+    int quit;
+
+    ZBTriangle *triangles;
+    int nb_triangles;
+    int nb_bands;
+    /* for each band, the indexes of its triangles */
+    unsigned short *band_triangles;
+    int *band_size;
+} ZBTiles;
+
+static void draw_band(ZBTiles *t, int i)
+{
+    ZBuffer zb;
+    ZBTriangle *tr;
+    ZBufferPoint p0, p1, p2;
+    unsigned short *index;
+    int n;
+
+    /* the triangle functions only look at ymin/ymax and current_texture */
+    zb = *t->zb;
+    zb.ymin = i * ZB_TILE_LINES;
+    zb.ymax = zb.ymin + ZB_TILE_LINES;
+    if (zb.ymax > t->zb->ymax)
+	zb.ymax = t->zb->ymax;
+
+    index = t->band_triangles + i * ZB_TILE_MAX_TRIANGLES;
+    for (n = 0; n < t->band_size[i]; n++) {
+	tr = &t->triangles[index[n]];
+	/* the perspective mapping writes to the points */
+	p0 = tr->p[0];
+	p1 = tr->p[1];
+	p2 = tr->p[2];
+	zb.current_texture = tr->texture;
+	tr->fill(&zb, &p0, &p1, &p2);
+    }
+    t->band_size[i] = 0;
+}
+
+static void draw_bands(ZBTiles *t)
+{
+    int i;
+
+    for (;;) {
+	pthread_mutex_lock(&t->lock);
+	i = t->next_band++;
+	pthread_mutex_unlock(&t->lock);
+	if (i >= t->nb_bands)
+	    break;
+	if (t->band_size[i] > 0)
+	    draw_band(t, i);
+    }
+}
+
+static void *tile_thread(void *arg)
+{
+    ZBTiles *t = (ZBTiles *) arg;
+    int generation = 0;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+	while (t->generation == generation && !t->quit)
+	    pthread_cond_wait(&t->start, &t->lock);
+	if (t->quit)
+	    break;
+	generation = t->generation;
+	pthread_mutex_unlock(&t->lock);
+
+	draw_bands(t);
+
+	pthread_mutex_lock(&t->lock);
+	if (--t->nb_busy == 0)
+	    pthread_cond_signal(&t->done);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+void ZB_flush(ZBuffer *zb)
+{
+    ZBTiles *t = zb->tiles;
+
+    if (t == NULL || t->nb_triangles == 0)
+	return;
+
+    pthread_mutex_lock(&t->lock);
+    t->next_band = 0;
+    t->nb_busy = t->nb_threads - 1;
+    t->generation++;
+    pthread_cond_broadcast(&t->start);
+    pthread_mutex_unlock(&t->lock);
+
+    draw_bands(t);
+
+    pthread_mutex_lock(&t->lock);
+    while (t->nb_busy > 0)
+	pthread_cond_wait(&t->done, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+
+    t->nb_triangles = 0;
+}
+
+void ZB_binTriangle(ZBuffer *zb, ZB_fillTriangleFunc fill,
+		    ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2)
+{
+    ZBTiles *t = zb->tiles;
+    ZBTriangle *tr;
+    int ymin, ymax, i, n;
+
+    if (t->nb_triangles == ZB_TILE_MAX_TRIANGLES)
+	ZB_flush(zb);
+
+    ymin = ymax = p0->y;
+    if (p1->y < ymin) ymin = p1->y;
+    if (p1->y > ymax) ymax = p1->y;
+    if (p2->y < ymin) ymin = p2->y;
+    if (p2->y > ymax) ymax = p2->y;
+    if (ymin < zb->ymin) ymin = zb->ymin;
+    if (ymax >= zb->ymax) ymax = zb->ymax - 1;
+    if (ymin > ymax)
+	return;
+
+    n = t->nb_triangles++;
+    tr = &t->triangles[n];
+    tr->fill = fill;
+    tr->texture = zb->current_texture;
+    tr->p[0] = *p0;
+    tr->p[1] = *p1;
+    tr->p[2] = *p2;
+
+    for (i = ymin / ZB_TILE_LINES; i <= ymax / ZB_TILE_LINES; i++)
+	t->band_triangles[i * ZB_TILE_MAX_TRIANGLES + t->band_size[i]++] = n;
+}
+
+/*
+ * Draw triangles with 'nb_threads' threads (the calling one included),
+ * or at once if 'nb_threads' is 0. Returns the previous number of
+ * threads.
+ */
+int ZB_setThreads(ZBuffer *zb, int nb_threads)
+{
+    ZBTiles *t = zb->tiles;
+    int i, old;
+
+    old = 0;
+    if (t != NULL) {
+	ZB_flush(zb);
+	pthread_mutex_lock(&t->lock);
+	t->quit = 1;
+	pthread_cond_broadcast(&t->start);
+	pthread_mutex_unlock(&t->lock);
+	for (i = 1; i < t->nb_threads; i++)
+	    pthread_join(t->threads[i], NULL);
+	pthread_mutex_destroy(&t->lock);
+	pthread_cond_destroy(&t->start);
+	pthread_cond_destroy(&t->done);
+	old = t->nb_threads;
+	gl_free(t->triangles);
+	gl_free(t->band_triangles);
+	gl_free(t->band_size);
+	gl_free(t);
+	zb->tiles = NULL;
+    }
+
+    if (nb_threads <= 0)
+	return old;
+    if (nb_threads > ZB_TILE_MAX_THREADS)
+	nb_threads = ZB_TILE_MAX_THREADS;
+
+    t = (ZBTiles *) gl_zalloc(sizeof(ZBTiles));
+    if (t == NULL)
+	return old;
+    t->zb = zb;
+    t->nb_bands = (zb->ysize + ZB_TILE_LINES - 1) / ZB_TILE_LINES;
+    t->triangles = (ZBTriangle *)
+	gl_malloc(ZB_TILE_MAX_TRIANGLES * sizeof(ZBTriangle));
+    t->band_triangles = (unsigned short *)
+	gl_malloc(t->nb_bands * ZB_TILE_MAX_TRIANGLES * sizeof(unsigned short));
+    t->band_size = (int *) gl_zalloc(t->nb_bands * sizeof(int));
+    if (t->triangles == NULL || t->band_triangles == NULL ||
+	t->band_size == NULL) {
+	gl_free(t->triangles);
+	gl_free(t->band_triangles);
+	gl_free(t->band_size);
+	gl_free(t);
+	return old;
+    }
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->start, NULL);
+    pthread_cond_init(&t->done, NULL);
+    t->nb_threads = 1;
+    for (i = 1; i < nb_threads; i++) {
+	if (pthread_create(&t->threads[i], NULL, tile_thread, t) != 0)
+	    break;
+	t->nb_threads++;
+    }
+
+    zb->tiles = t;
+    return old;
+}
+
+#else /* !TGL_FEATURE_THREADS */
+
+/* without threads, triangles are always drawn at once */
+
+int ZB_setThreads(ZBuffer *zb, int nb_threads)
+{
+    return 0;
+}
+
+void ZB_binTriangle(ZBuffer *zb, ZB_fillTriangleFunc fill,
+		    ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2)
+{
+    fill(zb, p0, p1, p2);
+}
+
+void ZB_flush(ZBuffer *zb)
+{
+}
+
+#endif /* TGL_FEATURE_THREADS */
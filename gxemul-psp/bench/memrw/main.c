@@ -0,0 +1,112 @@
+/*
+ *  memrw - load/store microbenchmarks for gxemul-psp
+ *
+ *  Runs tight load and store loops over main RAM and VRAM, through the
+ *  cached, uncached (0x4xxxxxxx) and kernel (0x8xxxxxxx) views of the same
+ *  memory, and prints the time each one takes. The checksums must be the
+ *  same from run to run (and between emulator builds).
+ *
+ *  Run it with:  ./gxemul-psp -q -E psp -u psp bench/memrw/memrw.elf
+ */
+
+#include <pspkernel.h>
+#include <stdio.h>
+
+PSP_MODULE_INFO("memrw", 0, 1, 1);
+PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER);
+
+#define	BUFSIZE		(64 * 1024)
+#define	ROUNDS		64
+
+#define	UNCACHED(p)	((void *)((unsigned int)(p) | 0x40000000))
+#define	VRAM		((void *)0x04000000)
+
+static unsigned int buf[BUFSIZE / sizeof(unsigned int)]
+    __attribute__((aligned(64)));
+
+
+static unsigned int lw_sw(volatile unsigned int *p)
+{
+	unsigned int sum = 0;
+	int r, i;
+
+	for (r=0; r<ROUNDS; r++)
+		for (i=0; i<BUFSIZE/4; i++) {
+			sum += p[i];
+			p[i] = sum ^ i;
+		}
+	return sum;
+}
+
+
+static unsigned int lh_sh(volatile unsigned short *p)
+{
+	unsigned int sum = 0;
+	int r, i;
+
+	for (r=0; r<ROUNDS; r++)
+		for (i=0; i<BUFSIZE/2; i++) {
+			sum += p[i];
+			p[i] = sum;
+		}
+	return sum;
+}
+
+
+static unsigned int lb_sb(volatile unsigned char *p)
+{
+	unsigned int sum = 0;
+	int r, i;
+
+	for (r=0; r<ROUNDS / 2; r++)
+		for (i=0; i<BUFSIZE; i++) {
+			sum += p[i];
+			p[i] = sum;
+		}
+	return sum;
+}
+
+
+static unsigned int copy(volatile unsigned int *p)
+{
+	volatile unsigned int *q = p + BUFSIZE / 8;
+	int r, i;
+
+	for (r=0; r<ROUNDS; r++)
+		for (i=0; i<BUFSIZE/8; i++)
+			q[i] = p[i] + r;
+	return q[BUFSIZE/8 - 1];
+}
+
+
+static void run(const char *name, void *p)
+{
+	unsigned int t0, t1, t2, t3, t4, s1, s2, s3, s4;
+
+	t0 = sceKernelGetSystemTimeLow();
+	s1 = lw_sw(p);
+	t1 = sceKernelGetSystemTimeLow();
+	s2 = lh_sh(p);
+	t2 = sceKernelGetSystemTimeLow();
+	s3 = lb_sb(p);
+	t3 = sceKernelGetSystemTimeLow();
+	s4 = copy(p);
+	t4 = sceKernelGetSystemTimeLow();
+
+	printf("%-10s lw/sw %7u  lh/sh %7u  lb/sb %7u  copy %7u usec"
+	    "  [%08x %08x %08x %08x]\n", name, t1-t0, t2-t1, t3-t2, t4-t3,
+	    s1, s2, s3, s4);
+}
+
+
+int main(void)
+{
+	run("ram", buf);
+	run("uncached", UNCACHED(buf));
+	run("kernel", (void *)((unsigned int)buf | 0x80000000));
+	run("vram", VRAM);
+	run("vram-unc", UNCACHED(VRAM));
+
+	sceKernelExitGame();
+	return 0;
+}
@@ -0,0 +1,151 @@
+#! /bin/bash
+#
+#  Run every .elf file in a directory headless, several at a time, and write
+#  a JUnit style XML report.
+#
+#  For each test foo.elf, the output directory gets:
+#
+#	foo.log		the emulator's own messages
+#	foo.stdout	what the guest wrote to stdout (also .stderr, .uartN)
+#	foo.png		the framebuffer at the end of the run
+#
+#  A test passes if the emulator exits with status 0 (the guest called
+#  sceKernelExitGame), and, if there is a foo.expected file next to
+#  foo.elf, its stdout matches that file. A foo.args file can hold extra
+#  emulator options for the test (for example "-n 2").
+#
+#  Set GXEMUL to use another emulator binary than ./gxemul-psp.
+
+GXEMUL=${GXEMUL:-./gxemul-psp}
+JOBS=`getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1`
+SECONDS_LIMIT=60
+INSTRS=
+OUTDIR=testresults
+REPORT=
+
+usage()
+{
+	echo "usage: $0 [-j jobs] [-m instrs] [-w secs] [-o outdir]" \
+	    "[-x report.xml] dir" >&2
+	exit 1
+}
+
+while getopts "j:m:w:o:x:" opt; do
+	case $opt in
+	j)	JOBS=$OPTARG ;;
+	m)	INSTRS="-m $OPTARG" ;;
+	w)	SECONDS_LIMIT=$OPTARG ;;
+	o)	OUTDIR=$OPTARG ;;
+	x)	REPORT=$OPTARG ;;
+	*)	usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if test $# != 1 -o ! -d "$1"; then
+	usage
+fi
+TESTDIR=$1
+REPORT=${REPORT:-$OUTDIR/report.xml}
+
+mkdir -p "$OUTDIR" || exit 1
+
+#  run_one elf: runs one test, and writes "status seconds" to name.result
+run_one()
+{
+	ELF=$1
+	NAME=`basename "$ELF" .elf`
+	OUT=$OUTDIR/$NAME
+
+	ARGS=
+	if test -f "${ELF%.elf}.args"; then
+		ARGS=`cat "${ELF%.elf}.args"`
+	fi
+
+	rm -f "$OUT".*
+	START=`date +%s.%N`
+	"$GXEMUL" -q -a -E psp -u psp -w $SECONDS_LIMIT $INSTRS $ARGS \
+	    -F "$OUT.png" -f "$OUT" "$ELF" </dev/null >"$OUT.log" 2>&1
+	STATUS=$?
+	END=`date +%s.%N`
+	touch "$OUT.stdout"
+	echo $STATUS $START $END | awk '{ printf "%d %.3f\n", $1, $3 - $2 }' \
+	    > "$OUT.result"
+}
+export -f run_one
+export GXEMUL SECONDS_LIMIT INSTRS OUTDIR
+
+find "$TESTDIR" -maxdepth 1 -name "*.elf" -print0 | sort -z | \
+    xargs -0 -r -n 1 -P "$JOBS" bash -c 'run_one "$1"' run_one
+
+xml_escape()
+{
+	sed -e 's/&/\&amp;/g' -e 's/</\&lt;/g' -e 's/>/\&gt;/g' \
+	    -e 's/"/\&quot;/g' | tr -d '\000-\010\013\014\016-\037'
+}
+
+TESTS=0
+FAILURES=0
+ERRORS=0
+TOTAL=0
+CASES=$OUTDIR/cases.xml
+: > "$CASES"
+
+#  Not a pipe into the loop, so that the counters survive it:
+while IFS= read -r -d '' ELF; do
+	NAME=`basename "$ELF" .elf`
+	OUT=$OUTDIR/$NAME
+	read STATUS TIME < "$OUT.result"
+	TESTS=$((TESTS + 1))
+	TOTAL=`echo $TOTAL $TIME | awk '{ printf "%.3f", $1 + $2 }'`
+
+	echo "    <testcase classname=\"psp\" name=\"$NAME\"" \
+	    "time=\"$TIME\">" >> "$CASES"
+	if test $STATUS = 124; then
+		ERRORS=$((ERRORS + 1))
+		echo "      <error type=\"timeout\" message=\"time or" \
+		    "instruction limit reached\"/>" >> "$CASES"
+		RESULT=TIMEOUT
+	elif test $STATUS = 125; then
+		ERRORS=$((ERRORS + 1))
+		echo "      <error type=\"crash\" message=\"the emulator" \
+		    "tried to enter the debugger\"/>" >> "$CASES"
+		RESULT=CRASH
+	elif test $STATUS != 0; then
+		FAILURES=$((FAILURES + 1))
+		echo "      <failure message=\"exit status $STATUS\"/>" \
+		    >> "$CASES"
+		RESULT=FAIL
+	elif test -f "$TESTDIR/$NAME.expected" && \
+	    ! cmp -s "$TESTDIR/$NAME.expected" "$OUT.stdout"; then
+		FAILURES=$((FAILURES + 1))
+		echo "      <failure message=\"unexpected output\">" >> "$CASES"
+		diff "$TESTDIR/$NAME.expected" "$OUT.stdout" | xml_escape \
+		    >> "$CASES"
+		echo "      </failure>" >> "$CASES"
+		RESULT=FAIL
+	else
+		RESULT=ok
+	fi
+	echo "      <system-out>`xml_escape < "$OUT.stdout"`</system-out>" \
+	    >> "$CASES"
+	echo "      <system-err>`tail -n 50 "$OUT.log" | xml_escape`" \
+	    "</system-err>" >> "$CASES"
+	echo "    </testcase>" >> "$CASES"
+
+	printf "%-40s %-8s %s s\n" "$NAME" "$RESULT" "$TIME"
+done < <(find "$TESTDIR" -maxdepth 1 -name "*.elf" -print0 | sort -z)
+
+{
+	echo '<?xml version="1.0" encoding="UTF-8"?>'
+	echo "<testsuites>"
+	echo "  <testsuite name=\"gxemul-psp\" tests=\"$TESTS\"" \
+	    "failures=\"$FAILURES\" errors=\"$ERRORS\" time=\"$TOTAL\">"
+	cat "$CASES"
+	echo "  </testsuite>"
+	echo "</testsuites>"
+} > "$REPORT"
+rm -f "$CASES"
+
+echo "$TESTS tests, $FAILURES failures, $ERRORS errors (report in $REPORT)"
+test $FAILURES = 0 -a $ERRORS = 0
@@ -41,6 +41,10 @@
 #include "memory.h"
 #include "misc.h"
 
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 
 extern int quiet_mode;
 extern int show_opcode_statistics;
@@ -311,7 +315,8 @@ void cpu_create_or_reset_tc(struct cpu *cpu)
 			cpu->translation_cache = (unsigned char *) mmap(NULL,
 			    s, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON |
 			    MAP_PRIVATE, -1, 0);
-			if (cpu->translation_cache == NULL) {
+			if ((void *)cpu->translation_cache == MAP_FAILED) {
+				cpu->translation_cache = NULL;
 				dyntrans_backend_enable = 0;
 				fatal("%\n%  WARNING! Dyntrans backend disabled"
 				    ", because mmap() failed.\n%\n");
@@ -329,6 +334,11 @@ void cpu_create_or_reset_tc(struct cpu *cpu)
 	cpu->translation_cache_cur_ofs =
 	    N_BASE_TABLE_ENTRIES * sizeof(uint32_t);
 
+#ifdef DYNTRANS_BACKEND
+	/*  Any half-collected run of simple instructions is now stale:  */
+	cpu->translation_context.n_simple = 0;
+#endif
+
 	/*
 	 *  There might be other translation pointers that still point to
 	 *  within the translation_cache region. Let's invalidate those too:
@@ -416,6 +426,20 @@ void cpu_run_deinit(struct machine *machine)
 {
 	int te;
 
+#ifdef HAVE_PTHREADS
+	/*  Stop the CPUs which run on their own host threads:  */
+	if (machine->cpu_threads != NULL) {
+		pthread_t *threads = machine->cpu_threads;
+		int i;
+
+		machine->threaded_cpus_quit = 1;
+		for (i=1; i<machine->ncpus; i++)
+			pthread_join(threads[i], NULL);
+		free(threads);
+		machine->cpu_threads = NULL;
+	}
+#endif
+
 	/*
 	 *  Two last ticks of every hardware device.  This will allow
 	 *  framebuffers to draw the last updates to the screen before
@@ -585,7 +609,8 @@ void cpu_run_init(struct machine *machine)
 	if (machine->a_few_cycles < 1)
 		machine->a_few_cycles = 1;
 
-	if (ncpus > 1 && machine->max_random_cycles_per_chunk == 0)
+	if (ncpus > 1 && !machine->threaded_cpus &&
+	    machine->max_random_cycles_per_chunk == 0)
 		machine->a_few_cycles = 1;
 
 	/*  debug("cpu_run_init(): a_few_cycles = %i\n",
@@ -662,95 +687,6 @@ struct cpu_family *cpu_family_ptr_by_number(int arch)
 }
 
 
-#ifdef DYNTRANS_BACKEND
-/*
- *  cpu_dtb_add_fixup():
- *
- *  Add a fixup entry to a currently ongoing dyntrans backend translation.
- */
-void cpu_dtb_add_fixup(struct cpu *cpu, int type, void *addr, size_t data)
-{
-	struct dtb_fixup *fixup = malloc(sizeof (struct dtb_fixup));
-	if (fixup == NULL) {
-		fprintf(stderr, "out of memory\n"),
-		exit(1);
-	}
-
-	/*  memset(fixup, 0, sizeof(struct dtb_fixup));  */
-
-	fixup->next = cpu->translation_context.fixups;
-	cpu->translation_context.fixups = fixup;
-
-	fixup->type = type;
-	fixup->addr = addr;
-	fixup->data = data;
-
-	/*  printf("{ fixup added: host addr %p, data=%p }\n", addr,
-	    (void *)data);  */
-}
-
-
-/*
- *  cpu_dtb_do_fixups():
- *
- *  This function should be called when a chunk of code has been translated,
- *  and post-fixup is to be applied (i.e. add data which for some reason was
- *  not included in the generated code).
- *
- *  If no fixup is necessary for a specific host platform, then it still needs
- *  an empty do_fixups routine here (just set done = 1).
- */
-void cpu_dtb_do_fixups(struct cpu *cpu)
-{
-	for (;;) {
-		int done = 0;
-		size_t omit_addr;
-
-		struct dtb_fixup *fixup = cpu->translation_context.fixups;
-		if (fixup == NULL)
-			break;
-
-		cpu->translation_context.fixups = fixup->next;
-
-#ifdef DYNTRANS_BACKEND_ALPHA
-		/*  Add the data at the end of the new translation:  */
-/*printf("%p %p\n", fixup->addr, fixup->data);*/
-		omit_addr = (size_t)cpu->translation_context.p -
-		    (size_t)cpu->translation_context.translation_buffer;
-/*printf("omit_addr = %016llx\n", (long long)omit_addr);*/
-		omit_addr = ((omit_addr - 1) | (sizeof(uint64_t) - 1)) + 1;
-/*printf("omit_addr = %016llx\n", (long long)omit_addr);*/
-		{
-			uint64_t *x = (void *)(omit_addr + (size_t)cpu->
-			    translation_context.translation_buffer);
-			uint32_t *fixup_instr = (void *)fixup->addr;
-			size_t ofs = omit_addr;
-			if (ofs > 0x7fff) {
-				fatal("Alpha fixup > 0x7fff!\n");
-				exit(1);
-			}
-			*x = fixup->data;
-/*printf("orig instr = 0x%08x\n", *fixup_instr);*/
-			(*fixup_instr) &= ~0xffff;
-			(*fixup_instr) |= ofs;
-/*printf("new instr = 0x%08x\n", *fixup_instr);*/
-		}
-		omit_addr += sizeof(uint64_t);
-		cpu->translation_context.p = (void *)
-		    ((size_t)cpu->translation_context.translation_buffer
-		    + omit_addr);
-		done = 1;
-#endif	/*  DYNTRANS_BACKEND_ALPHA  */
-
-		if (!done)
-			fatal("!!! cpu_dtb_do_fixups() not implemented yet"
-			    " for this host architecture!\n");
-	}
-}
-
-#endif	/*  DYNTRANS_BACKEND  */
-
-
 /*
  *  cpu_init():
  *
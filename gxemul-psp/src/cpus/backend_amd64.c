@@ -0,0 +1,438 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Dyntrans backend for AMD64 hosts.
+ *
+ *  A block is a function with the same signature as any other instr_call
+ *  function, i.e. cpu in rdi and ic in rsi. The emulated registers are
+ *  32-bit values at [rdi + offset]; the most used ones in each block are
+ *  kept in host registers (rdx, rsi, r8..r11) for the duration of the block.
+ *  eax and ecx are used as scratch registers. No calls are made from native
+ *  code, and no callee-saved registers are touched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../config.h"
+
+#include "cpu.h"
+#include "misc.h"
+
+
+#ifdef DYNTRANS_BACKEND_AMD64
+
+#define	AMD64_EAX		0
+#define	AMD64_ECX		1
+#define	AMD64_EDX		2
+#define	AMD64_ESI		6
+#define	AMD64_EDI		7
+
+#define	N_HOSTREGS		6
+static const int hostregs[N_HOSTREGS] = { AMD64_EDX, AMD64_ESI, 8, 9, 10, 11 };
+
+/*  An operand is either a host register, or [rdi + disp]:  */
+struct operand {
+	int		hostreg;	/*  -1 for memory  */
+	int32_t		disp;
+};
+
+/*  Emulated registers used in the block being generated:  */
+struct regusage {
+	void		*ptr;
+	int		uses;
+	int		first_use_is_read;
+	int		dirty;
+	int		hostreg;
+};
+
+
+/*
+ *  emit_rm():
+ *
+ *  Emits an instruction with a ModRM byte: opc (1 or 2 bytes, 0x0f first
+ *  if 2), with reg in the reg field and the operand in r/m.
+ */
+static unsigned char *emit_rm(unsigned char *p, int rex_w, int opc,
+	int reg, struct operand *o)
+{
+	int rex = (rex_w? 0x48 : 0) | (reg >= 8? 0x44 : 0);
+
+	if (o->hostreg >= 0) {
+		if (o->hostreg >= 8)
+			rex |= 0x41;
+		if (rex)
+			*p++ = rex | 0x40;
+		if (opc > 0xff)
+			*p++ = opc >> 8;
+		*p++ = opc;
+		*p++ = 0xc0 | ((reg & 7) << 3) | (o->hostreg & 7);
+		return p;
+	}
+
+	if (rex)
+		*p++ = rex | 0x40;
+	if (opc > 0xff)
+		*p++ = opc >> 8;
+	*p++ = opc;
+	*p++ = 0x80 | ((reg & 7) << 3) | AMD64_EDI;
+	memcpy(p, &o->disp, sizeof(o->disp));
+	return p + sizeof(o->disp);
+}
+
+
+static unsigned char *emit_imm32(unsigned char *p, int32_t imm)
+{
+	memcpy(p, &imm, sizeof(imm));
+	return p + sizeof(imm);
+}
+
+
+/*  movabs rax/rdx, imm64:  */
+static unsigned char *emit_movabs(unsigned char *p, int reg, uint64_t imm)
+{
+	*p++ = 0x48;
+	*p++ = 0xb8 + reg;
+	memcpy(p, &imm, sizeof(imm));
+	return p + sizeof(imm);
+}
+
+
+/*
+ *  cpu_offset():
+ *
+ *  Returns 1 and sets *dispp if ptr points to a 32-bit value within the
+ *  cpu struct, 0 otherwise.
+ */
+static int cpu_offset(struct cpu *cpu, void *ptr, int32_t *dispp)
+{
+	size_t ofs = (size_t)ptr - (size_t)cpu;
+
+	if ((size_t)ptr < (size_t)cpu || ofs > sizeof(struct cpu) - 4)
+		return 0;
+
+	*dispp = ofs;
+	return 1;
+}
+
+
+/*
+ *  operand():
+ *
+ *  Fills in *o for an emulated register pointer.
+ */
+static void operand(struct cpu *cpu, struct regusage *regs, int n_regs,
+	void *ptr, struct operand *o)
+{
+	int i;
+
+	for (i=0; i<n_regs; i++)
+		if (regs[i].ptr == ptr)
+			break;
+
+	o->hostreg = i < n_regs? regs[i].hostreg : -1;
+	o->disp = 0;
+	if (ptr != NULL)
+		cpu_offset(cpu, ptr, &o->disp);
+}
+
+
+/*
+ *  add_use():
+ *
+ *  Registers a use of an emulated register. Returns 0 if the register
+ *  can't be addressed from native code.
+ */
+static int add_use(struct cpu *cpu, struct regusage *regs, int *n_regsp,
+	void *ptr, int write)
+{
+	int32_t disp;
+	int i;
+
+	if (ptr == NULL)
+		return 1;
+	if (!cpu_offset(cpu, ptr, &disp))
+		return 0;
+
+	for (i=0; i<*n_regsp; i++)
+		if (regs[i].ptr == ptr)
+			break;
+
+	if (i == *n_regsp) {
+		regs[i].ptr = ptr;
+		regs[i].uses = 0;
+		regs[i].first_use_is_read = !write;
+		regs[i].dirty = 0;
+		regs[i].hostreg = -1;
+		(*n_regsp) ++;
+	}
+
+	regs[i].uses ++;
+	if (write)
+		regs[i].dirty = 1;
+	return 1;
+}
+
+
+/*
+ *  dtb_host_cacheinvalidate():
+ *
+ *  AMD64 has coherent instruction and data caches, so nothing needs to be
+ *  done here.
+ */
+void dtb_host_cacheinvalidate(void *p, size_t len)
+{
+}
+
+
+/*
+ *  dtb_generate_block():
+ *
+ *  See cpu.h for a description of the arguments.
+ */
+int dtb_generate_block(struct cpu *cpu, struct dtb_op *ops, int n_ops,
+	unsigned char *buf, size_t *sizep, int *guard, size_t fallback_f,
+	void *next_icp, int *n_instrsp, size_t ic_size, size_t verify_f,
+	struct dtb_block *block)
+{
+	struct regusage regs[DTB_MAX_OPS * 3];
+	struct operand dst, src1, src2, next_ic_o, n_instrs_o, guard_o;
+	unsigned char *p = buf;
+	int n = n_ops, n_regs = 0, i, j, n_alloc;
+
+	guard_o.disp = 0;
+
+	/*  Collect the emulated registers which are used:  */
+	for (i=0; i<n; i++) {
+		struct dtb_op *op = &ops[i];
+		if (!add_use(cpu, regs, &n_regs, op->src1, 0) ||
+		    !add_use(cpu, regs, &n_regs, op->src2, 0) ||
+		    !add_use(cpu, regs, &n_regs, op->dst, 1))
+			return 0;
+	}
+
+	if (!cpu_offset(cpu, next_icp, &next_ic_o.disp) ||
+	    !cpu_offset(cpu, n_instrsp, &n_instrs_o.disp) ||
+	    (guard != NULL && !cpu_offset(cpu, guard, &guard_o.disp)))
+		return 0;
+	next_ic_o.hostreg = n_instrs_o.hostreg = guard_o.hostreg = -1;
+
+	/*
+	 *  Give the most used registers (which are used at least twice) a
+	 *  host register each:
+	 */
+	for (n_alloc=0; n_alloc<N_HOSTREGS; n_alloc++) {
+		int best = -1;
+		for (i=0; i<n_regs; i++)
+			if (regs[i].hostreg < 0 && regs[i].uses >= 2 &&
+			    (best < 0 || regs[i].uses > regs[best].uses))
+				best = i;
+		if (best < 0)
+			break;
+		regs[best].hostreg = hostregs[n_alloc];
+	}
+
+	/*
+	 *  Guard: If *guard is non-zero, then only the first instruction
+	 *  should be executed, so let the original function do that:
+	 *
+	 *	cmp dword [rdi+guard], 0
+	 *	je  1f
+	 *	movabs rax, fallback_f
+	 *	jmp rax
+	 *  1:
+	 */
+	if (guard != NULL) {
+		p = emit_rm(p, 0, 0x83, 7, &guard_o);
+		*p++ = 0x00;
+		*p++ = 0x74; *p++ = 12;
+		p = emit_movabs(p, AMD64_EAX, fallback_f);
+		*p++ = 0xff; *p++ = 0xe0;
+	}
+
+	/*  Verify mode: verify_f(cpu, ic, block):  */
+	if (verify_f != 0) {
+		p = emit_movabs(p, AMD64_EDX, (size_t)block);
+		p = emit_movabs(p, AMD64_EAX, verify_f);
+		*p++ = 0xff; *p++ = 0xe0;
+	}
+
+	block->native_f = p;
+
+	/*  Load the allocated registers which are read before written:  */
+	for (i=0; i<n_regs; i++)
+		if (regs[i].hostreg >= 0 && regs[i].first_use_is_read) {
+			struct operand o;
+			o.hostreg = -1;
+			o.disp = 0;
+			cpu_offset(cpu, regs[i].ptr, &o.disp);
+			p = emit_rm(p, 0, 0x8b, regs[i].hostreg, &o);
+		}
+
+	for (i=0; i<n; i++) {
+		struct dtb_op *op = &ops[i];
+		static const int alu_opc[] = { 0, 0, 0x03, 0x2b, 0x23, 0x0b,
+		    0x33, 0x0b };
+		static const int alu_ext[] = { 0, 0, 0, 5, 4, 1, 6, 1 };
+		static const int shift_ext[] = { 4, 5, 7 };
+
+		if (op->op == DTB_OP_NOP)
+			continue;
+
+		operand(cpu, regs, n_regs, op->dst, &dst);
+		operand(cpu, regs, n_regs, op->src1, &src1);
+		operand(cpu, regs, n_regs, op->src2, &src2);
+
+		switch (op->op) {
+
+		case DTB_OP_SET:
+			/*  mov dst, imm32  */
+			if (dst.hostreg >= 0) {
+				if (dst.hostreg >= 8)
+					*p++ = 0x41;
+				*p++ = 0xb8 + (dst.hostreg & 7);
+			} else
+				p = emit_rm(p, 0, 0xc7, 0, &dst);
+			p = emit_imm32(p, op->imm);
+			continue;
+
+		case DTB_OP_MOV:
+			if (dst.hostreg >= 0) {
+				/*  mov dstreg, src1  */
+				p = emit_rm(p, 0, 0x8b, dst.hostreg, &src1);
+				continue;
+			}
+			p = emit_rm(p, 0, 0x8b, AMD64_EAX, &src1);
+			break;
+
+		case DTB_OP_ADD:
+		case DTB_OP_SUB:
+		case DTB_OP_AND:
+		case DTB_OP_OR:
+		case DTB_OP_XOR:
+		case DTB_OP_NOR:
+			/*  mov eax, src1; op eax, src2/imm32  */
+			p = emit_rm(p, 0, 0x8b, AMD64_EAX, &src1);
+			if (op->src2 != NULL)
+				p = emit_rm(p, 0, alu_opc[op->op], AMD64_EAX,
+				    &src2);
+			else {
+				*p++ = 0x81;
+				*p++ = 0xc0 | (alu_ext[op->op] << 3);
+				p = emit_imm32(p, op->imm);
+			}
+			/*  not eax  */
+			if (op->op == DTB_OP_NOR) {
+				*p++ = 0xf7; *p++ = 0xd0;
+			}
+			break;
+
+		case DTB_OP_SLT:
+		case DTB_OP_SLTU:
+			/*  mov ecx, src1; xor eax, eax; cmp ecx, src2/imm32  */
+			p = emit_rm(p, 0, 0x8b, AMD64_ECX, &src1);
+			*p++ = 0x31; *p++ = 0xc0;
+			if (op->src2 != NULL)
+				p = emit_rm(p, 0, 0x3b, AMD64_ECX, &src2);
+			else {
+				*p++ = 0x81; *p++ = 0xf9;
+				p = emit_imm32(p, op->imm);
+			}
+			/*  setl al / setb al  */
+			*p++ = 0x0f;
+			*p++ = op->op == DTB_OP_SLT? 0x9c : 0x92;
+			*p++ = 0xc0;
+			break;
+
+		case DTB_OP_MUL:
+			/*  mov eax, src1; imul eax, src2  */
+			p = emit_rm(p, 0, 0x8b, AMD64_EAX, &src1);
+			p = emit_rm(p, 0, 0x0faf, AMD64_EAX, &src2);
+			break;
+
+		case DTB_OP_SLL:
+		case DTB_OP_SRL:
+		case DTB_OP_SRA:
+			j = shift_ext[op->op - DTB_OP_SLL];
+			if (op->src2 != NULL) {
+				/*  mov ecx, src2; mov eax, src1; shift eax, cl */
+				p = emit_rm(p, 0, 0x8b, AMD64_ECX, &src2);
+				p = emit_rm(p, 0, 0x8b, AMD64_EAX, &src1);
+				*p++ = 0xd3; *p++ = 0xc0 | (j << 3);
+			} else {
+				/*  mov eax, src1; shift eax, imm8  */
+				p = emit_rm(p, 0, 0x8b, AMD64_EAX, &src1);
+				if (op->imm != 0) {
+					*p++ = 0xc1; *p++ = 0xc0 | (j << 3);
+					*p++ = op->imm;
+				}
+			}
+			break;
+
+		default:fatal("dtb_generate_block(): unimplemented op %i\n",
+			    op->op);
+			exit(1);
+		}
+
+		/*  mov dst, eax  */
+		p = emit_rm(p, 0, 0x89, AMD64_EAX, &dst);
+	}
+
+	/*  Write back the allocated registers which were modified:  */
+	for (i=0; i<n_regs; i++)
+		if (regs[i].hostreg >= 0 && regs[i].dirty) {
+			struct operand o;
+			o.hostreg = -1;
+			o.disp = 0;
+			cpu_offset(cpu, regs[i].ptr, &o.disp);
+			p = emit_rm(p, 0, 0x89, regs[i].hostreg, &o);
+		}
+
+	/*
+	 *  The caller has already advanced next_ic and n_translated_instrs
+	 *  by one instruction:
+	 *
+	 *	add qword [rdi+next_ic], (n-1) * ic_size
+	 *	add dword [rdi+n_translated_instrs], n-1
+	 *	ret
+	 */
+	p = emit_rm(p, 1, 0x81, 0, &next_ic_o);
+	p = emit_imm32(p, (n - 1) * ic_size);
+	p = emit_rm(p, 0, 0x81, 0, &n_instrs_o);
+	p = emit_imm32(p, n - 1);
+	*p++ = 0xc3;
+
+	*sizep = p - buf;
+	if (*sizep > DTB_TRANSLATION_SIZE_MAX) {
+		fatal("dtb_generate_block(): too much code generated\n");
+		exit(1);
+	}
+
+	return 1;
+}
+
+
+#endif	/*  DYNTRANS_BACKEND_AMD64  */
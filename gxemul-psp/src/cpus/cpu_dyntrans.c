@@ -1383,116 +1383,124 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 
 #ifdef DYNTRANS_BACKEND
 	/*
-	 *  "Empty"/simple native dyntrans backend stuff:
+	 *  Native dyntrans backend:
 	 *
-	 *  1) If no translation is currently being done, but the translated
-	 *     instruction was simple enough, then let's start making a new
-	 *     native translation block.
+	 *  Runs of consecutive simple instructions on the same page are
+	 *  collected in cpu->translation_context. When an instruction which
+	 *  does not continue the current run is translated, the run is turned
+	 *  into one native function (if it is at least two instructions long),
+	 *  which replaces the f of the run's first instr_call.
 	 *
-	 *  2) If a native translation block is currently being constructed,
-	 *     but this instruction wasn't simple enough, then end the block
-	 *     (without including this instruction).
-	 *
-	 *  3) If a native translation block is currently being constructed,
-	 *     and this is a simple instruction, then add it.
+	 *  The instructions of the run have already been executed one by one
+	 *  at this point, so a run can safely be thrown away; this is done if
+	 *  any of its instr_calls have changed since they were translated (for
+	 *  example because the page was invalidated in the meantime).
 	 */
-	if (simple && cpu->translation_context.p == NULL &&
-	    dyntrans_backend_enable) {
-		size_t s = 0;
-
-		if (cpu->translation_context.translation_buffer == NULL) {
-			cpu->translation_context.translation_buffer =
-			    zeroed_alloc(DTB_TRANSLATION_SIZE_MAX +
-			    DTB_TRANSLATION_SIZE_MARGIN);
-		}
-
-		cpu->translation_context.p =
-		    cpu->translation_context.translation_buffer;
-
-		cpu->translation_context.ic_page =
-		    cpu->cd.DYNTRANS_ARCH.cur_ic_page;
-		cpu->translation_context.start_instr_call_index =
-		    ((size_t)ic - (size_t)cpu->cd.DYNTRANS_ARCH.cur_ic_page)
-		    / (sizeof(*ic));
-
-		dtb_function_prologue(&cpu->translation_context, &s);
-		cpu->translation_context.p += s;
-		cpu->translation_context.n_simple = 0;
-	}
+	if (dyntrans_backend_enable && !single_step &&
+	    !cpu->machine->instruction_trace) {
+		struct translation_context *ctx = &cpu->translation_context;
+		struct DYNTRANS_IC *start = (struct DYNTRANS_IC *)
+		    ctx->ic_page + ctx->start_instr_call_index;
+
+		if (sizeof(*ic) != sizeof(ctx->ic_copy[0]))
+			simple = 0;
+
+		if (ctx->n_simple > 0 && (!simple || ic != start +
+		    ctx->n_simple || ctx->n_simple >= DTB_MAX_OPS)) {
+			int i, n = ctx->n_simple, ok = 1, split = n;
+
+			for (i=0; i<n && ok; i++)
+				if (memcmp(&start[i], ctx->ic_copy[i],
+				    sizeof(ctx->ic_copy[i])) != 0)
+					ok = 0;
+			if (ic >= start && ic < start + n)
+				ok = 0;
+
+			/*
+			 *  A branch (usually the one ending a loop) into the
+			 *  middle of the run needs a block of its own starting
+			 *  at the branch target:
+			 */
+			if (!simple && ctx->branch_target != NULL &&
+			    (struct DYNTRANS_IC *)ctx->branch_target > start &&
+			    (struct DYNTRANS_IC *)ctx->branch_target < start+n)
+				split = (struct DYNTRANS_IC *)
+				    ctx->branch_target - start;
+
+			for (i=0; ok && i<n; i=split, split=n) {
+				struct dtb_block *block;
+				unsigned char *code;
+				size_t ofs, size = 0;
+				int len = split - i;
+
+				if (len < 2)
+					continue;
+
+				ofs = cpu->translation_cache_cur_ofs;
+				ofs = ((ofs - 1) | 31) + 1;
+				if (ofs + sizeof(struct dtb_block) +
+				    DTB_TRANSLATION_SIZE_MAX + len * sizeof(*ic)
+				    > DYNTRANS_CACHE_SIZE)
+					break;
+
+				block = (struct dtb_block *)
+				    (cpu->translation_cache + ofs);
+				code = (unsigned char *) (block + 1);
+				block->fallback_f = (size_t)start[i].f;
+				block->n_instrs = len;
+
+				if (!dtb_generate_block(cpu, &ctx->ops[i], len,
+				    code, &size,
+#ifdef DYNTRANS_DELAYSLOT
+				    &cpu->cd.DYNTRANS_ARCH.delay_slot,
+#else
+				    NULL,
+#endif
+				    (size_t)start[i].f,
+				    &cpu->cd.DYNTRANS_ARCH.next_ic,
+				    &cpu->n_translated_instrs, sizeof(*ic),
+				    dyntrans_backend_verify?
+				    (size_t)instr(dtb_verify) : 0, block))
+					continue;
+
+				size = ((size - 1) | 7) + 1;
+				block->ics = code + size;
+				memcpy(block->ics, ctx->ic_copy[i],
+				    len * sizeof(*ic));
+				dtb_host_cacheinvalidate(code, size);
+
+				start[i].f = (void *)code;
+
+				cpu->translation_cache_cur_ofs = ofs +
+				    sizeof(struct dtb_block) + size +
+				    len * sizeof(*ic);
+
+				/*  Flushed when single-stepping:  */
+				((struct DYNTRANS_TC_PHYSPAGE *)ctx->ic_page)
+				    ->flags |= COMBINATIONS;
+			}
 
-	/*  If this is not a continuation of a simple translation, then
-	    stop now!  */
-	if (cpu->translation_context.ic_page != cpu->cd.DYNTRANS_ARCH.
-	    cur_ic_page || ic != &cpu->cd.DYNTRANS_ARCH.cur_ic_page[
-	    cpu->translation_context.start_instr_call_index +
-	    cpu->translation_context.n_simple])
-		simple = 0;
-
-	if (cpu->translation_context.p != NULL && !simple) {
-		size_t s = 0, total;
-
-		if (cpu->translation_context.n_simple > 1) {
-			dtb_generate_ptr_inc(cpu, &cpu->translation_context,
-			    &s, &cpu->cd.DYNTRANS_ARCH.next_ic,
-			    (cpu->translation_context.n_simple - 1) *
-			    sizeof(*(cpu->cd.DYNTRANS_ARCH.next_ic)));
-			cpu->translation_context.p += s;
+			ctx->n_simple = 0;
 		}
 
-		dtb_function_epilogue(&cpu->translation_context, &s);
-		cpu->translation_context.p += s;
-
-		cpu_dtb_do_fixups(cpu);
-#if 0
-{
-int i;
-unsigned char *addr = cpu->translation_context.translation_buffer;
-printf("index = %i\n", cpu->translation_context.start_instr_call_index);
-quiet_mode = 0;
-for (i=0; i<4*32; i+=4)
-	alpha_cpu_disassemble_instr(cpu, (unsigned char *)addr + i,
-        0, i, 0);
-}
-#endif
-		total = (size_t)cpu->translation_context.p -
-		    (size_t)cpu->translation_context.translation_buffer;
-
-		/*  Copy the translated block to the translation cache:  */
-		/*  Align first:  */
-		cpu->translation_cache_cur_ofs --;
-		cpu->translation_cache_cur_ofs |= 31;
-		cpu->translation_cache_cur_ofs ++;
-
-		memcpy(cpu->translation_cache + cpu->translation_cache_cur_ofs,
-		    cpu->translation_context.translation_buffer, total);
-
-		/*  Set the ic pointer:  */
-		((struct DYNTRANS_IC *)cpu->translation_context.ic_page)
-		    [cpu->translation_context.start_instr_call_index].f =
-		    (void *)
-		    (cpu->translation_cache + cpu->translation_cache_cur_ofs);
-
-		/*  Align cur_ofs afterwards as well, just to be safe.  */
-		cpu->translation_cache_cur_ofs += total;
-		cpu->translation_cache_cur_ofs --;
-		cpu->translation_cache_cur_ofs |= 31;
-		cpu->translation_cache_cur_ofs ++;
-
-		/*  Set the "combined instruction" flag for this page:  */
-		cpu->cd.DYNTRANS_ARCH.cur_physpage = (void *)
-		    cpu->cd.DYNTRANS_ARCH.cur_ic_page;
-		cpu->cd.DYNTRANS_ARCH.cur_physpage->flags |= COMBINATIONS;
-
-		dtb_host_cacheinvalidate(0,0); /* p , size ... ); */
+		if (simple) {
+			if (ctx->n_simple == 0) {
+				ctx->ic_page =
+				    cpu->cd.DYNTRANS_ARCH.cur_ic_page;
+				ctx->start_instr_call_index = ((size_t)ic -
+				    (size_t)cpu->cd.DYNTRANS_ARCH.cur_ic_page)
+				    / sizeof(*ic);
+			} else {
+				/*  Combining with the previous instruction
+				    would break the run:  */
+				cpu->cd.DYNTRANS_ARCH.combination_check = NULL;
+			}
 
-		cpu->translation_context.p = NULL;
-	}
-	if (cpu->translation_context.p != NULL) {
-		size_t s = 0;
-		dtb_generate_fcall(cpu, &cpu->translation_context,
-		    &s, (size_t)ic->f, (size_t)ic);
-		cpu->translation_context.p += s;
-		cpu->translation_context.n_simple ++;
+			ctx->ops[ctx->n_simple] = ctx->op;
+			memcpy(ctx->ic_copy[ctx->n_simple], ic,
+			    sizeof(ctx->ic_copy[0]));
+			ctx->n_simple ++;
+		}
 	}
 #endif	/*  DYNTRANS_BACKEND  */
 
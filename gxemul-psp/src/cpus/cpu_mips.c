@@ -80,6 +80,7 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 #include "memory.h"
 #include "mips_cpu_types.h"
 #include "opcodes_mips.h"
+#include "snapshot.h"
 #include "symbol.h"
 
 
@@ -192,6 +193,19 @@ int mips_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 	    cpu->cd.mips.cpu_type.isa_level == 32)
 		cpu->is_32bit = 1;
 
+#ifdef EXPERIMENTAL_NEWMIPS
+	/*  Let dyntrans fill in host_load/host_store and phys_page, so that
+	    loads/stores and jumps to other pages avoid the slow path:  */
+	if (cpu->is_32bit) {
+		cpu->update_translation_table =
+		    mips32_update_translation_table;
+		cpu->invalidate_translation_caches =
+		    mips32_invalidate_translation_caches;
+		cpu->invalidate_code_translation =
+		    mips32_invalidate_code_translation;
+	}
+#endif
+
 	if (cpu_id == 0)
 		debug("%s", cpu->cd.mips.cpu_type.name);
 
@@ -337,6 +351,8 @@ int mips_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 	cpu->cd.mips.coproc[1] = mips_coproc_new(cpu, 1);
 	// PSP VFPU is cop2
 	cpu->cd.mips.coproc[2] = mips_coproc_new(cpu, 2);
+	if (strcmp(cpu->cd.mips.cpu_type.name, "Allegrex") == 0)
+		cpu->cd.mips.vfpu = mips_vfpu_new(cpu);
 
 	/*
 	 *  Initialize the cpu->cd.mips.pc_last_* cache (a 1-entry cache of the
@@ -451,6 +467,194 @@ void mips_cpu_dumpinfo(struct cpu *cpu)
 }
 
 
+/*
+ *  mips_cpu_snapshot():
+ *
+ *  Save or restore the MIPS-specific registers, the coprocessors (with
+ *  the TLB), and the VFPU. The generic part of the CPU is handled by
+ *  snapshot.c, which also throws away dyntrans translations on restore.
+ */
+void mips_cpu_snapshot(struct cpu *cpu, struct snapshot *s)
+{
+	int i;
+
+	snapshot_data(s, cpu->cd.mips.gpr, sizeof(cpu->cd.mips.gpr));
+	SNAPSHOT_VAR(s, cpu->cd.mips.hi);
+	SNAPSHOT_VAR(s, cpu->cd.mips.lo);
+	SNAPSHOT_VAR(s, cpu->cd.mips.pc_last);
+	SNAPSHOT_VAR(s, cpu->cd.mips.ic);
+	SNAPSHOT_VAR(s, cpu->cd.mips.compare_register_set);
+	SNAPSHOT_VAR(s, cpu->cd.mips.delay_slot);
+	SNAPSHOT_VAR(s, cpu->cd.mips.delay_jmpaddr);
+	SNAPSHOT_VAR(s, cpu->cd.mips.nullify_next);
+	SNAPSHOT_VAR(s, cpu->cd.mips.last_was_jumptoself);
+	SNAPSHOT_VAR(s, cpu->cd.mips.jump_to_self_reg);
+	SNAPSHOT_VAR(s, cpu->cd.mips.rmw);
+	SNAPSHOT_VAR(s, cpu->cd.mips.rmw_len);
+	SNAPSHOT_VAR(s, cpu->cd.mips.rmw_addr);
+	snapshot_data(s, cpu->cd.mips.gpr_quadhi,
+	    sizeof(cpu->cd.mips.gpr_quadhi));
+
+	for (i=0; i<N_MIPS_COPROCS; i++) {
+		struct mips_coproc *cp = cpu->cd.mips.coproc[i];
+		if (cp == NULL)
+			continue;
+		snapshot_data(s, cp->reg, sizeof(cp->reg));
+		snapshot_data(s, cp->fcr, sizeof(cp->fcr));
+		if (cp->tlbs != NULL)
+			snapshot_data(s, cp->tlbs,
+			    cp->nr_of_tlbs * sizeof(struct mips_tlb));
+	}
+
+	/*  The VFPU instruction cache only depends on the instruction
+	    words, so it stays valid:  */
+	if (cpu->cd.mips.vfpu != NULL) {
+		SNAPSHOT_VAR(s, cpu->cd.mips.vfpu->vpr);
+		SNAPSHOT_VAR(s, cpu->cd.mips.vfpu->ctrl);
+		SNAPSHOT_VAR(s, cpu->cd.mips.vfpu->pfx_active);
+	}
+
+	if (!snapshot_restoring(s))
+		return;
+
+	/*  The old interpreter's translation caches:  */
+	cpu->cd.mips.pc_last_virtual_page = PC_LAST_PAGE_IMPOSSIBLE_VALUE;
+	for (i=0; i<N_BINTRANS_VADDR_TO_HOST; i++)
+		cpu->cd.mips.bintrans_data_hostpage[i] = NULL;
+#ifdef USE_TINY_CACHE
+	for (i=0; i<N_TRANSLATION_CACHE_INSTR; i++)
+		cpu->cd.mips.translation_cache_instr[i].wf = 0;
+	for (i=0; i<N_TRANSLATION_CACHE_DATA; i++)
+		cpu->cd.mips.translation_cache_data[i].wf = 0;
+#endif
+	if (cpu->machine->old_bintrans_enable)
+		clear_all_chunks_from_all_tables(cpu);
+}
+
+
+/*
+ *  mips_cpu_unwind_read():
+ *
+ *  Read a word from emulated RAM for mips_cpu_unwind(), without side
+ *  effects: addresses which don't map to RAM (devices, or garbage found
+ *  on the stack) fail, instead of being read.
+ */
+static int mips_cpu_unwind_read(struct cpu *cpu, uint64_t vaddr,
+	uint32_t *wordp)
+{
+	struct machine *machine = cpu->machine;
+	uint64_t paddr, ram_start, ram_end;
+	unsigned char *host;
+
+	if (vaddr & 3)
+		return 0;
+	if (!cpu->translate_address(cpu, vaddr, &paddr, FLAG_NOEXCEPTIONS))
+		return 0;
+
+	ram_start = (uint64_t)machine->memory_offset_in_mb << 20;
+	ram_end = ram_start + ((uint64_t)machine->physical_ram_in_mb << 20);
+	if (paddr < ram_start || paddr >= ram_end)
+		return 0;
+
+	host = memory_paddr_to_hostaddr(cpu->mem, paddr, MEM_READ);
+	if (host == NULL) {
+		*wordp = 0;
+		return 1;
+	}
+	host += paddr & ((1 << BITS_PER_MEMBLOCK) - 1);
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		*wordp = host[0] + (host[1] << 8) + (host[2] << 16) +
+		    ((uint32_t)host[3] << 24);
+	else
+		*wordp = host[3] + (host[2] << 8) + (host[1] << 16) +
+		    ((uint32_t)host[0] << 24);
+	return 1;
+}
+
+
+/*  Max nr of instructions to scan backwards for a function's prologue:  */
+#define	MIPS_UNWIND_MAX_SCAN	4096
+
+/*
+ *  mips_cpu_unwind():
+ *
+ *  Fill in frames[] with the pc, followed by the return addresses into
+ *  each calling function, and return the number of frames found. (Used by
+ *  the profiler.)
+ *
+ *  There are no frame pointers to follow, so the code before each pc is
+ *  scanned backwards for the function's prologue, the way debuggers do it:
+ *  "addiu sp,sp,-n" allocates the frame, and "sw ra,ofs(sp)" saves the
+ *  return address. A "jr ra" or "addiu sp,sp,n" on the way means that pc
+ *  is in a leaf function (or past the epilogue), which returns to ra.
+ */
+int mips_cpu_unwind(struct cpu *cpu, uint64_t *frames, int max_frames)
+{
+	uint64_t pc = cpu->pc, sp = cpu->cd.mips.gpr[MIPS_GPR_SP];
+	uint64_t ra = cpu->cd.mips.gpr[MIPS_GPR_RA], addr;
+	int n = 0, i, frame_size, ra_ofs;
+	uint32_t iword, ra_word;
+
+	if (cpu->is_32bit) {
+		pc = (uint32_t) pc;
+		sp = (uint32_t) sp;
+		ra = (uint32_t) ra;
+	}
+
+	frames[n++] = pc;
+	while (n < max_frames) {
+		frame_size = 0;
+		ra_ofs = -1;
+
+		for (i=0, addr=pc; i<MIPS_UNWIND_MAX_SCAN; i++, addr-=4) {
+			if (!mips_cpu_unwind_read(cpu, addr, &iword))
+				return n;
+			/*  The instruction at pc hasn't been executed yet:  */
+			if (addr == pc)
+				continue;
+			if (iword == 0x03e00008)		/*  jr ra  */
+				break;
+			if ((iword & 0xffff0000) == 0xafbf0000)	/*  sw ra  */
+				ra_ofs = (int16_t) iword;
+			if ((iword & 0xffff0000) == 0x27bd0000) {
+				/*  addiu sp,sp,imm  */
+				if ((int16_t) iword < 0)
+					frame_size = -(int16_t) iword;
+				else
+					ra_ofs = -1;
+				break;
+			}
+		}
+		if (i == MIPS_UNWIND_MAX_SCAN)
+			return n;
+
+		if (frame_size == 0 || ra_ofs < 0) {
+			/*  Only the innermost function can return to ra:  */
+			if (n > 1 || ra == 0)
+				return n;
+		} else {
+			if (!mips_cpu_unwind_read(cpu, sp + ra_ofs, &ra_word))
+				return n;
+			ra = ra_word;
+		}
+		sp += frame_size;
+
+		if (ra < 8 || (ra & 3))
+			return n;
+		frames[n++] = ra;
+
+		/*  Continue from the call (jal + delay slot):  */
+		pc = ra - 8;
+		if (cpu->is_32bit)
+			pc = (uint32_t) pc;
+		ra = 0;
+	}
+
+	return n;
+}
+
+
 /*
  *  mips_cpu_list_available_types():
  *
@@ -923,6 +1127,14 @@ int mips_cpu_disassemble_instr(struct cpu *cpu, unsigned char *originstr,
 
 	hi6 = (instr[3] >> 2) & 0x3f;
 
+	if (cpu->cd.mips.vfpu != NULL && MIPS_VFPU_HI6(hi6)) {
+		instrword = (instr[3] << 24) + (instr[2] << 16) +
+		    (instr[1] << 8) + instr[0];
+		if (mips_vfpu_disassemble_instr(cpu, instrword, dumpaddr,
+		    running))
+			return sizeof(instrword);
+	}
+
 	switch (hi6) {
 	case HI6_SPECIAL:
 		special6 = instr[0] & 0x3f;
@@ -1523,6 +1735,12 @@ void mips_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 			continue;
 		}
 
+		/*  The Allegrex VFPU has its own register file:  */
+		if (coprocnr == 2 && cpu->cd.mips.vfpu != NULL) {
+			mips_vfpu_register_dump(cpu);
+			continue;
+		}
+
 		/*  Coprocessor registers:  */
 		/*  TODO: multiple selections per register?  */
 		for (i=0; i<32; i++) {
@@ -1678,6 +1896,11 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 	uint64_t *reg = &cpu->cd.mips.coproc[0]->reg[0];
 	int exc_model = cpu->cd.mips.cpu_type.exc_model;
 
+#ifdef EXPERIMENTAL_NEWMIPS
+	/*  Translated instructions sync cpu->pc before causing exceptions:  */
+	cpu->cd.mips.pc_last = cpu->pc;
+#endif
+
 	if (!quiet_mode) {
 		uint64_t offset;
 		int x;
@@ -1834,7 +2057,13 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 		}
 	}
 
+#ifdef EXPERIMENTAL_NEWMIPS
+	/*  Tell the branch instruction not to overwrite next_ic:  */
+	cpu->cd.mips.delay_slot = cpu->cd.mips.delay_slot?
+	    EXCEPTION_IN_DELAY_SLOT : NOT_DELAYED;
+#else
 	cpu->cd.mips.delay_slot = NOT_DELAYED;
+#endif
 	cpu->cd.mips.nullify_next = 0;
 
 	/*  TODO: This is true for MIPS64, but how about others?  */
@@ -1892,6 +2121,14 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 	/*  Sign-extend:  */
 	reg[COP0_CAUSE] = (int64_t)(int32_t)reg[COP0_CAUSE];
 	reg[COP0_STATUS] = (int64_t)(int32_t)reg[COP0_STATUS];
+
+#ifdef EXPERIMENTAL_NEWMIPS
+	/*  Continue with the translated exception handler:  */
+	if (cpu->is_32bit)
+		mips32_pc_to_pointers(cpu);
+	else
+		mips_pc_to_pointers(cpu);
+#endif
 }
 
 
@@ -2419,6 +2656,52 @@ int mips_OLD_cpu_run_instr(struct emul *emul, struct cpu *cpu)
 
 	hi6 = instr[3] >> 2;  	/*  & 0x3f  */
 
+	/*
+	 *  Allegrex VFPU instructions reuse 64-bit and coprocessor opcodes,
+	 *  so they are picked out before the main switch. Anything on COP2
+	 *  which isn't a VFPU instruction goes on to coproc_function().
+	 */
+	if (cpu->cd.mips.vfpu != NULL && MIPS_VFPU_HI6(hi6)) {
+		instrword = (instr[3] << 24) + (instr[2] << 16) +
+		    (instr[1] << 8) + instr[0];
+
+		if (MIPS_VFPU_IS_BRANCH(instrword)) {
+			if (cpu->cd.mips.delay_slot) {
+				fatal("bv*: jump inside a jump's delay slot, or similar. TODO\n");
+				cpu->running = 0;
+				return 1;
+			}
+			imm = (int16_t)instrword;
+			likely = (instrword >> 17) & 1;
+			cond = ((cpu->cd.mips.vfpu->ctrl[VFPU_CTRL_CC] >>
+			    ((instrword >> 18) & 7)) & 1) ==
+			    ((instrword >> 16) & 1);
+			if (cond) {
+				cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+				cpu->cd.mips.delay_jmpaddr = cached_pc + (imm << 2);
+			} else {
+				if (likely)
+					cpu->cd.mips.nullify_next = 1;		/*  nullify delay slot  */
+			}
+			return 1;
+		}
+
+		if (mips_vfpu_run_instr(cpu, instrword))
+			return 1;
+
+		if (hi6 != HI6_COP2) {
+			if (!instruction_trace_cached) {
+				fatal("cpu%i @ %016llx: %02x%02x%02x%02x%s\t",
+				    cpu->cpu_id, (long long)cpu->cd.mips.pc_last,
+				    instr[3], instr[2], instr[1], instr[0], cpu_flags(cpu));
+			}
+			fatal("unimplemented VFPU instruction 0x%08x\n",
+			    (int)instrword);
+			cpu->running = 0;
+			return 1;
+		}
+	}
+
 	switch (hi6) {
 	case HI6_SPECIAL:
 		special6 = instr[0] & 0x3f;
@@ -3043,7 +3326,9 @@ int mips_OLD_cpu_run_instr(struct emul *emul, struct cpu *cpu)
 			    (instr[1] << 8) + instr[0]) >> 6;
 			imm &= 0xfffff;
 
-			if (cpu->machine->userland_emul != NULL)
+			/*  (Only the cpu which userland emulation was
+			    set up for handles syscalls itself.)  */
+			if (cpu->useremul_syscall != NULL)
 				useremul_syscall(cpu, imm);
 			else
 				mips_cpu_exception(cpu, EXCEPTION_SYS,
@@ -3570,6 +3855,74 @@ fatal("unsupported HI6_SQ: %02x %02x %02x %02x\n",instr[3],instr[2],instr[1],ins
 				cpu->cd.mips.rmw = 0;
 			}
 
+			/*
+			 *  Fast path for machines with direct-mapped memory
+			 *  (the PSP): plain integer loads and stores to RAM or
+			 *  VRAM need only a single bounds check, and go
+			 *  straight to host memory instead of memory_rw().
+			 *  (The address is naturally aligned, and limit is a
+			 *  multiple of 4, so the whole access is inside.)
+			 */
+			if (cpu->mem->fastmem != NULL && !linked &&
+			    !instruction_trace_cached) {
+				uint32_t p = addr & FASTMEM_ADDR_MASK;
+				struct fastmem_slice *s = &cpu->mem->fastmem[
+				    p >> FASTMEM_SLICE_SHIFT];
+				uint32_t ofs = p & (FASTMEM_SLICE_SIZE - 1);
+				uint32_t v = cpu->cd.mips.gpr[rt];
+
+				if (ofs < s->limit) {
+					unsigned char *h = s->host + ofs;
+
+					switch (hi6) {
+					case HI6_LW:
+						value = (int32_t) LE32_TO_HOST(
+						    *(uint32_t *)h);
+						break;
+					case HI6_LH:
+						value = (int16_t)
+						    (h[0] | (h[1] << 8));
+						break;
+					case HI6_LHU:
+						value = h[0] | (h[1] << 8);
+						break;
+					case HI6_LB:
+						value = (int8_t) h[0];
+						break;
+					case HI6_LBU:
+						value = h[0];
+						break;
+					case HI6_SW:
+						*(uint32_t *)h = LE32_TO_HOST(v);
+						break;
+					case HI6_SH:
+						h[0] = v; h[1] = v >> 8;
+						break;
+					case HI6_SB:
+						h[0] = v;
+						break;
+					default:h = NULL;
+					}
+
+					if (h != NULL) {
+						if (!st) {
+							if (rt != 0)
+								cpu->cd.mips.
+								    gpr[rt] =
+								    value;
+						} else if (s->track_writes) {
+							if (ofs < s->write_low)
+								s->write_low =
+								    ofs;
+							if (ofs > s->write_high)
+								s->write_high =
+								    ofs;
+						}
+						return 1;
+					}
+				}
+			}
+
 			value_hi = 0;
 
 			if (st) {
@@ -4124,6 +4477,10 @@ fatal("unsupported HI6_SQ: %02x %02x %02x %02x\n",instr[3],instr[2],instr[1],ins
 		 */
 		cpu->cd.mips.rmw = 0;
 
+		/*  On the PSP, this is a sync point with the other CPU:  */
+		if (cpu->machine->machine_type == MACHINE_PSP)
+			dev_psp_me_cache_sync(cpu);
+
 		return 1;
 	case HI6_SPECIAL2:
 		special6 = instr[0] & 0x3f;
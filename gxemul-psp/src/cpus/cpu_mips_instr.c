@@ -159,12 +159,138 @@ X(b_samepage)
 }
 
 
+/*
+ *  blez:  Branch if less than or equal to zero
+ *  bgtz:  Branch if greater than zero
+ *  bltz:  Branch if less than zero
+ *  bgez:  Branch if greater than or equal to zero
+ *
+ *  arg[0] = pointer to rs
+ *  arg[2] = (int32_t) relative offset from the next instruction
+ */
+#define	ONE_REG_BRANCH(name, cond)					\
+X(name)									\
+{									\
+	MODE_uint_t old_pc = cpu->pc;					\
+	MODE_int_t rs = reg(ic->arg[0]);				\
+	int x = cond;							\
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;			\
+	ic[1].f(cpu, ic+1);						\
+	cpu->n_translated_instrs ++;					\
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {	\
+		if (x) {						\
+			old_pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<	\
+			    MIPS_INSTR_ALIGNMENT_SHIFT);		\
+			cpu->pc = old_pc + (int32_t)ic->arg[2];		\
+			quick_pc_to_pointers(cpu);			\
+		} else							\
+			cpu->cd.mips.next_ic ++;			\
+	}								\
+	cpu->cd.mips.delay_slot = NOT_DELAYED;				\
+}									\
+X(name ## _samepage)							\
+{									\
+	MODE_int_t rs = reg(ic->arg[0]);				\
+	int x = cond;							\
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;			\
+	ic[1].f(cpu, ic+1);						\
+	cpu->n_translated_instrs ++;					\
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {	\
+		if (x)							\
+			cpu->cd.mips.next_ic = (struct mips_instr_call *)\
+			    ic->arg[2];					\
+		else							\
+			cpu->cd.mips.next_ic ++;			\
+	}								\
+	cpu->cd.mips.delay_slot = NOT_DELAYED;				\
+}
+ONE_REG_BRANCH(blez, rs <= 0)
+ONE_REG_BRANCH(bgtz, rs > 0)
+ONE_REG_BRANCH(bltz, rs < 0)
+ONE_REG_BRANCH(bgez, rs >= 0)
+#undef ONE_REG_BRANCH
+
+
+/*
+ *  j, jal:  Jump [and link].
+ *
+ *  arg[0] = lowest 28 bits of the new pc
+ *  arg[1] = offset of the return address within the page (jal)
+ *
+ *  The _samepage variants are used when the target is within the same page,
+ *  and then arg[0] = pointer to the new instr_call. (This is only valid
+ *  because the Allegrex segments only differ in the top 3 address bits,
+ *  which a jump never changes.)
+ */
+X(j)
+{
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = (cpu->pc & ~0x0fffffff) | ic->arg[0];
+		quick_pc_to_pointers(cpu);
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(j_samepage)
+{
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT))
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[0];
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(jal)
+{
+	MODE_uint_t rd = cpu->pc & ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+	    MIPS_INSTR_ALIGNMENT_SHIFT);
+	reg(&cpu->cd.mips.gpr[MIPS_GPR_RA]) = rd + (int32_t)ic->arg[1];
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = (cpu->pc & ~0x0fffffff) | ic->arg[0];
+		quick_pc_to_pointers(cpu);
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(jal_trace)
+{
+	MODE_uint_t rd = cpu->pc & ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+	    MIPS_INSTR_ALIGNMENT_SHIFT);
+	reg(&cpu->cd.mips.gpr[MIPS_GPR_RA]) = rd + (int32_t)ic->arg[1];
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = (cpu->pc & ~0x0fffffff) | ic->arg[0];
+		cpu_functioncall_trace(cpu, cpu->pc);
+		quick_pc_to_pointers(cpu);
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(jal_samepage)
+{
+	MODE_uint_t rd = cpu->pc & ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+	    MIPS_INSTR_ALIGNMENT_SHIFT);
+	reg(&cpu->cd.mips.gpr[MIPS_GPR_RA]) = rd + (int32_t)ic->arg[1];
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT))
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[0];
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+
+
 /*
  *  jr, jalr: Jump to a register [and link].
  *
  *  arg[0] = ptr to rs
  *  arg[1] = ptr to rd (for jalr)
- *  arg[2] = (int32_t) relative offset of the next instruction
+ *  arg[2] = (int32_t) relative offset of the return address (for jalr)
  */
 X(jr)
 {
@@ -238,6 +364,58 @@ X(jalr_trace)
 }
 
 
+/*
+ *  syscall:  Userland (HLE) syscall, or a SYSCALL exception.
+ *
+ *  arg[0] = the 20-bit code field
+ *
+ *  The HLE layer may halt the cpu or move the pc somewhere else (to start
+ *  or leave a thread). Both are treated like an exception, so that a
+ *  branch whose delay slot held the syscall doesn't overwrite next_ic.
+ */
+X(syscall)
+{
+	int low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
+	    / sizeof(struct mips_instr_call);
+	MODE_uint_t old_pc;
+
+	if (low_pc < MIPS_IC_ENTRIES_PER_PAGE) {
+		cpu->pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+		    MIPS_INSTR_ALIGNMENT_SHIFT);
+		cpu->pc += (low_pc << MIPS_INSTR_ALIGNMENT_SHIFT);
+	}
+	cpu->cd.mips.pc_last = cpu->pc;
+
+	if (cpu->useremul_syscall == NULL) {
+		mips_cpu_exception(cpu, EXCEPTION_SYS, 0, 0, 0, 0, 0, 0);
+		return;
+	}
+
+	old_pc = cpu->pc;
+	useremul_syscall(cpu, ic->arg[0]);
+	if (cpu->running && cpu->pc == old_pc)
+		return;
+
+	cpu->cd.mips.delay_slot = cpu->cd.mips.delay_slot?
+	    EXCEPTION_IN_DELAY_SLOT : NOT_DELAYED;
+	if (!cpu->running) {
+		cpu->running_translated = 0;
+		cpu->cd.mips.next_ic = &nothing_call;
+	} else
+		quick_pc_to_pointers(cpu);
+}
+
+
+/*
+ *  cache:  There are no caches to maintain. On the PSP, a cache op is a
+ *          sync point with the other CPU (see dev_psp_me.c).
+ */
+X(cache)
+{
+	dev_psp_me_cache_sync(cpu);
+}
+
+
 /*
  *  2-register + immediate:
  *
@@ -248,6 +426,22 @@ X(jalr_trace)
 X(andi) { reg(ic->arg[1]) = reg(ic->arg[0]) & (int32_t)ic->arg[2]; }
 X(ori)  { reg(ic->arg[1]) = reg(ic->arg[0]) | (int32_t)ic->arg[2]; }
 X(xori) { reg(ic->arg[1]) = reg(ic->arg[0]) ^ (int32_t)ic->arg[2]; }
+X(slti) {
+#ifdef MODE32
+	reg(ic->arg[1]) = (int32_t)reg(ic->arg[0]) < (int32_t)ic->arg[2];
+#else
+	reg(ic->arg[1]) = (int64_t)reg(ic->arg[0]) < (int64_t)(int32_t)ic->arg[2];
+#endif
+}
+X(sltiu) {
+#ifdef MODE32
+	reg(ic->arg[1]) = (uint32_t)reg(ic->arg[0]) <
+	    (uint32_t)(int32_t)ic->arg[2];
+#else
+	reg(ic->arg[1]) = (uint64_t)reg(ic->arg[0]) <
+	    (uint64_t)(int64_t)(int32_t)ic->arg[2];
+#endif
+}
 
 
 /*
@@ -290,12 +484,19 @@ X(sltu) {
 	reg(ic->arg[2]) = (uint64_t)reg(ic->arg[0]) < (uint64_t)reg(ic->arg[1]);
 #endif
 }
+X(and) { reg(ic->arg[2]) = reg(ic->arg[0]) & reg(ic->arg[1]); }
 X(or) { reg(ic->arg[2]) = reg(ic->arg[0]) | reg(ic->arg[1]); }
 X(xor) { reg(ic->arg[2]) = reg(ic->arg[0]) ^ reg(ic->arg[1]); }
 X(nor) { reg(ic->arg[2]) = ~(reg(ic->arg[0]) | reg(ic->arg[1])); }
 X(sll) { reg(ic->arg[2]) = (int32_t)(reg(ic->arg[0]) << ic->arg[1]); }
 X(srl) { reg(ic->arg[2]) = (int32_t)((uint32_t)reg(ic->arg[0]) >> ic->arg[1]); }
 X(sra) { reg(ic->arg[2]) = (int32_t)((int32_t)reg(ic->arg[0]) >> ic->arg[1]); }
+X(sllv) { int sa = reg(ic->arg[1]) & 31;
+	reg(ic->arg[2]) = (int32_t)(reg(ic->arg[0]) << sa); }
+X(srlv) { int sa = reg(ic->arg[1]) & 31;
+	reg(ic->arg[2]) = (int32_t)((uint32_t)reg(ic->arg[0]) >> sa); }
+X(srav) { int sa = reg(ic->arg[1]) & 31;
+	reg(ic->arg[2]) = (int32_t)((int32_t)reg(ic->arg[0]) >> sa); }
 X(mul) { reg(ic->arg[2]) = (int32_t)
 	( (int32_t)reg(ic->arg[0]) * (int32_t)reg(ic->arg[1]) ); }
 
@@ -400,6 +601,246 @@ X(set)
 }
 
 
+/*
+ *  Load/store:  lb, lbu, lh, lhu, lw, sb, sh, sw
+ *
+ *  arg[0] = pointer to rs (base register)
+ *  arg[1] = pointer to rt
+ *  arg[2] = (int32_t) offset
+ *
+ *  Naturally aligned accesses to pages which are in the host_load/host_store
+ *  arrays are done directly. Everything else goes through memop(), which
+ *  syncs the pc first so that exceptions get the correct EPC.
+ *  (Little-endian emulation only.)
+ */
+static void instr(memop)(struct cpu *cpu, struct mips_instr_call *ic,
+	int len, int writeflag, int signedness)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	int low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
+	    / sizeof(struct mips_instr_call);
+	unsigned char data[4];
+	uint32_t x = 0;
+	int i;
+
+	/*  (A delay slot on the next page already has the correct pc.)  */
+	if (low_pc < MIPS_IC_ENTRIES_PER_PAGE) {
+		cpu->pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+		    MIPS_INSTR_ALIGNMENT_SHIFT);
+		cpu->pc += (low_pc << MIPS_INSTR_ALIGNMENT_SHIFT);
+	}
+	cpu->cd.mips.pc_last = cpu->pc;
+
+	if (addr & (len - 1)) {
+		mips_cpu_exception(cpu, writeflag == MEM_WRITE?
+		    EXCEPTION_ADES : EXCEPTION_ADEL, 0, addr, 0, 0, 0, 0);
+		return;
+	}
+
+	if (writeflag == MEM_WRITE) {
+		x = reg(ic->arg[1]);
+		for (i=0; i<len; i++)
+			data[i] = x >> (i * 8);
+		cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_WRITE,
+		    CACHE_DATA);
+		return;
+	}
+
+	if (!cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_READ,
+	    CACHE_DATA))
+		return;
+
+	for (i=len-1; i>=0; i--)
+		x = (x << 8) | data[i];
+	if (signedness)
+		x = len == 1? (int8_t)x : len == 2? (int16_t)x : x;
+	reg(ic->arg[1]) = (int32_t)x;
+}
+X(lb)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	if (p == NULL)
+		instr(memop)(cpu, ic, 1, MEM_READ, 1);
+	else
+		reg(ic->arg[1]) = (int8_t)p[addr & 0xfff];
+}
+X(lbu)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	if (p == NULL)
+		instr(memop)(cpu, ic, 1, MEM_READ, 0);
+	else
+		reg(ic->arg[1]) = p[addr & 0xfff];
+}
+X(lh)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	if (p == NULL || addr & 1)
+		instr(memop)(cpu, ic, 2, MEM_READ, 1);
+	else {
+		p += (addr & 0xfff);
+		reg(ic->arg[1]) = (int16_t)(p[0] + (p[1] << 8));
+	}
+}
+X(lhu)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	if (p == NULL || addr & 1)
+		instr(memop)(cpu, ic, 2, MEM_READ, 0);
+	else {
+		p += (addr & 0xfff);
+		reg(ic->arg[1]) = p[0] + (p[1] << 8);
+	}
+}
+X(lw)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	if (p == NULL || addr & 3)
+		instr(memop)(cpu, ic, 4, MEM_READ, 1);
+	else {
+		uint32_t x = *(uint32_t *)(p + (addr & 0xfff));
+		reg(ic->arg[1]) = (int32_t)LE32_TO_HOST(x);
+	}
+}
+X(sb)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_store[(uint32_t)addr >> 12];
+	if (p == NULL)
+		instr(memop)(cpu, ic, 1, MEM_WRITE, 0);
+	else
+		p[addr & 0xfff] = reg(ic->arg[1]);
+}
+X(sh)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_store[(uint32_t)addr >> 12];
+	if (p == NULL || addr & 1)
+		instr(memop)(cpu, ic, 2, MEM_WRITE, 0);
+	else {
+		uint32_t x = reg(ic->arg[1]);
+		p += (addr & 0xfff);
+		p[0] = x; p[1] = x >> 8;
+	}
+}
+X(sw)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + (int32_t)ic->arg[2];
+	unsigned char *p = cpu->cd.mips.host_store[(uint32_t)addr >> 12];
+	if (p == NULL || addr & 3)
+		instr(memop)(cpu, ic, 4, MEM_WRITE, 0);
+	else {
+		uint32_t x = reg(ic->arg[1]);
+		*(uint32_t *)(p + (addr & 0xfff)) = LE32_TO_HOST(x);
+	}
+}
+
+
+/*
+ *  bv:  Allegrex VFPU branch on a CC bit (bvf, bvt)
+ *  bvl:  Likely variant (bvfl, bvtl)
+ *
+ *  arg[0] = CC bit number
+ *  arg[1] = value of the CC bit which makes the branch taken
+ *  arg[2] = (int32_t) relative offset from the next instruction
+ */
+X(bv)
+{
+	MODE_uint_t old_pc = cpu->pc;
+	int x = ((cpu->cd.mips.vfpu->ctrl[VFPU_CTRL_CC] >> ic->arg[0]) & 1)
+	    == ic->arg[1];
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		if (x) {
+			old_pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+			    MIPS_INSTR_ALIGNMENT_SHIFT);
+			cpu->pc = old_pc + (int32_t)ic->arg[2];
+			quick_pc_to_pointers(cpu);
+		} else
+			cpu->cd.mips.next_ic ++;
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(bv_samepage)
+{
+	int x = ((cpu->cd.mips.vfpu->ctrl[VFPU_CTRL_CC] >> ic->arg[0]) & 1)
+	    == ic->arg[1];
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		if (x)
+			cpu->cd.mips.next_ic = (struct mips_instr_call *)
+			    ic->arg[2];
+		else
+			cpu->cd.mips.next_ic ++;
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(bvl)
+{
+	MODE_uint_t old_pc = cpu->pc;
+	int x = ((cpu->cd.mips.vfpu->ctrl[VFPU_CTRL_CC] >> ic->arg[0]) & 1)
+	    == ic->arg[1];
+	if (!x) {
+		/*  Not taken: the delay slot is nullified.  */
+		cpu->n_translated_instrs ++;
+		cpu->cd.mips.next_ic ++;
+		return;
+	}
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		old_pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+		    MIPS_INSTR_ALIGNMENT_SHIFT);
+		cpu->pc = old_pc + (int32_t)ic->arg[2];
+		quick_pc_to_pointers(cpu);
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+X(bvl_samepage)
+{
+	int x = ((cpu->cd.mips.vfpu->ctrl[VFPU_CTRL_CC] >> ic->arg[0]) & 1)
+	    == ic->arg[1];
+	if (!x) {
+		cpu->n_translated_instrs ++;
+		cpu->cd.mips.next_ic ++;
+		return;
+	}
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT))
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[2];
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+
+
+/*
+ *  vfpu_mem:  Allegrex VFPU load or store, which may cause an exception.
+ *
+ *  The pc is synched before the handler from cpu_mips_vfpu.c is called.
+ *
+ *  arg[0] = instruction word
+ *  arg[1] = the handler
+ *  arg[2] = offset of the instruction within the page
+ */
+X(vfpu_mem)
+{
+	cpu->pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1)<<MIPS_INSTR_ALIGNMENT_SHIFT);
+	cpu->pc |= ic->arg[2];
+	((void (*)(struct cpu *, struct mips_instr_call *))ic->arg[1])(cpu, ic);
+}
+
+
 /*
  *  mfc0, dmfc0:  Move from Coprocessor 0.
  *  mtc0, dmtc0:  Move to Coprocessor 0.
@@ -471,6 +912,120 @@ X(b_samepage_addiu)
 }
 
 
+/*
+ *  b_samepage_nop, beq_samepage_nop, bne_samepage_nop:
+ *
+ *  [Conditional] branch within the same page, with a nop in the delay slot.
+ */
+X(beq_samepage_nop)
+{
+	cpu->n_translated_instrs ++;
+	if (reg(ic->arg[0]) == reg(ic->arg[1]))
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[2];
+	else
+		cpu->cd.mips.next_ic ++;
+}
+X(b_samepage_nop)
+{
+	cpu->n_translated_instrs ++;
+	cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[2];
+}
+X(bne_samepage_nop)
+{
+	cpu->n_translated_instrs ++;
+	if (reg(ic->arg[0]) != reg(ic->arg[1]))
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[2];
+	else
+		cpu->cd.mips.next_ic ++;
+}
+
+
+/*
+ *  The combinations below start with an instruction which may itself be in
+ *  the delay slot of a branch. The branch then owns next_ic, so only the
+ *  first instruction is executed in that case.
+ */
+
+
+/*
+ *  set_set:  lui followed by addiu or ori, using the register just set.
+ *
+ *  ic[0].arg[2] = (int32_t) the value of the second instruction's rt
+ */
+X(set_set)
+{
+	if (cpu->cd.mips.delay_slot != NOT_DELAYED) {
+		instr(set)(cpu, ic);
+		return;
+	}
+	reg(ic[0].arg[0]) = (int32_t)ic[0].arg[1];
+	reg(ic[1].arg[1]) = (int32_t)ic[0].arg[2];
+	cpu->n_translated_instrs ++;
+	cpu->cd.mips.next_ic ++;
+}
+
+
+/*
+ *  lw_lw:  Two loads using the same base register, where the first load
+ *          doesn't overwrite the base register.
+ */
+X(lw_lw)
+{
+	MODE_uint_t base = reg(ic[0].arg[0]);
+	MODE_uint_t addr0 = base + (int32_t)ic[0].arg[2];
+	MODE_uint_t addr1 = base + (int32_t)ic[1].arg[2];
+	unsigned char *p0 = cpu->cd.mips.host_load[(uint32_t)addr0 >> 12];
+	unsigned char *p1 = cpu->cd.mips.host_load[(uint32_t)addr1 >> 12];
+	uint32_t x0, x1;
+
+	if (cpu->cd.mips.delay_slot != NOT_DELAYED || p0 == NULL ||
+	    p1 == NULL || (addr0 | addr1) & 3) {
+		instr(lw)(cpu, ic);
+		return;
+	}
+	x0 = *(uint32_t *)(p0 + (addr0 & 0xfff));
+	x1 = *(uint32_t *)(p1 + (addr1 & 0xfff));
+	reg(ic[0].arg[1]) = (int32_t)LE32_TO_HOST(x0);
+	reg(ic[1].arg[1]) = (int32_t)LE32_TO_HOST(x1);
+	cpu->n_translated_instrs ++;
+	cpu->cd.mips.next_ic ++;
+}
+
+
+/*
+ *  addiu_bne_samepage:  Loop counter update, followed by a conditional
+ *                       branch backwards within the same page.
+ *
+ *  ic[0] is the addiu, ic[1] the bne_samepage, ic[2] the delay slot.
+ */
+X(addiu_bne_samepage)
+{
+	MODE_uint_t rs, rt;
+
+	if (cpu->cd.mips.delay_slot != NOT_DELAYED) {
+		instr(addiu)(cpu, ic);
+		return;
+	}
+	reg(ic[0].arg[1]) = (int32_t)
+	    ((int32_t)reg(ic[0].arg[0]) + (int32_t)ic[0].arg[2]);
+	rs = reg(ic[1].arg[0]);
+	rt = reg(ic[1].arg[1]);
+	cpu->n_translated_instrs ++;
+
+	cpu->cd.mips.delay_slot = TO_BE_DELAYED;
+	ic[2].f(cpu, ic+2);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->cd.mips.delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		if (rs != rt)
+			cpu->cd.mips.next_ic = (struct mips_instr_call *)
+			    ic[1].arg[2];
+		else
+			cpu->cd.mips.next_ic += 2;
+	}
+	cpu->cd.mips.delay_slot = NOT_DELAYED;
+}
+
+
 /*****************************************************************************/
 
 
@@ -546,8 +1101,9 @@ exit(1);
 
 /*
  *  Combine: [Conditional] branch, followed by addiu.
+ *           lui, followed by addiu.
  */
-void COMBINE(b_addiu)(struct cpu *cpu, struct mips_instr_call *ic,
+void COMBINE(addiu)(struct cpu *cpu, struct mips_instr_call *ic,
 	int low_addr)
 {
 	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
@@ -561,10 +1117,281 @@ void COMBINE(b_addiu)(struct cpu *cpu, struct mips_instr_call *ic,
 		combined;
 	}
 
+	if (ic[-1].f == instr(set) && ic[-1].arg[0] == ic[0].arg[0]) {
+		ic[-1].arg[2] = (int32_t)
+		    ((int32_t)ic[-1].arg[1] + (int32_t)ic[0].arg[2]);
+		ic[-1].f = instr(set_set);
+		combined;
+	}
+
 	/*  TODO: other branches that are followed by addiu should be here  */
 }
 
 
+/*
+ *  Combine: lui, followed by ori.
+ */
+void COMBINE(ori)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 1)
+		return;
+
+	if (ic[-1].f == instr(set) && ic[-1].arg[0] == ic[0].arg[0]) {
+		ic[-1].arg[2] = (int32_t)(ic[-1].arg[1] | ic[0].arg[2]);
+		ic[-1].f = instr(set_set);
+		combined;
+	}
+}
+
+
+/*
+ *  Combine: lw, followed by lw using the same base register.
+ */
+void COMBINE(lw)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 1)
+		return;
+
+	if (ic[-1].f == instr(lw) && ic[-1].arg[0] == ic[0].arg[0] &&
+	    ic[-1].arg[1] != ic[-1].arg[0]) {
+		ic[-1].f = instr(lw_lw);
+		combined;
+	}
+}
+
+
+/*
+ *  Combine: addiu, followed by bne within the same page (a loop counter).
+ */
+void COMBINE(bne)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 1 || ic[0].f != instr(bne_samepage))
+		return;
+
+	if (ic[-1].f == instr(addiu)) {
+		ic[-1].f = instr(addiu_bne_samepage);
+		combined;
+	}
+}
+
+
+/*
+ *  Combine: [Conditional] branch within the same page, followed by nop.
+ */
+void COMBINE(b_nop)(struct cpu *cpu, struct mips_instr_call *ic,
+	int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 1)
+		return;
+
+	if (ic[-1].f == instr(b_samepage)) {
+		ic[-1].f = instr(b_samepage_nop);
+		combined;
+	}
+	if (ic[-1].f == instr(beq_samepage)) {
+		ic[-1].f = instr(beq_samepage_nop);
+		combined;
+	}
+	if (ic[-1].f == instr(bne_samepage)) {
+		ic[-1].f = instr(bne_samepage_nop);
+		combined;
+	}
+}
+
+
+/*****************************************************************************/
+
+
+#ifdef DYNTRANS_BACKEND
+/*
+ *  dtb_describe():
+ *
+ *  Describes a translated instruction as a dtb_op for the native dyntrans
+ *  backend. Returns 1 if the instruction is simple enough (a 32-bit ALU
+ *  operation which cannot cause an exception), 0 otherwise.
+ */
+static int instr(dtb_describe)(struct cpu *cpu, struct mips_instr_call *ic,
+	struct dtb_op *op)
+{
+#ifdef MODE32
+	static const struct {
+		void	(*f)(struct cpu *, struct mips_instr_call *);
+		int	op;
+	} three_reg[] = {
+		{ instr(addu), DTB_OP_ADD },	{ instr(subu), DTB_OP_SUB },
+		{ instr(and), DTB_OP_AND },	{ instr(or), DTB_OP_OR },
+		{ instr(xor), DTB_OP_XOR },	{ instr(nor), DTB_OP_NOR },
+		{ instr(slt), DTB_OP_SLT },	{ instr(sltu), DTB_OP_SLTU },
+		{ instr(mul), DTB_OP_MUL },	{ instr(sllv), DTB_OP_SLL },
+		{ instr(srlv), DTB_OP_SRL },	{ instr(srav), DTB_OP_SRA },
+		{ NULL, 0 } }, reg_imm[] = {
+		{ instr(addiu), DTB_OP_ADD },	{ instr(andi), DTB_OP_AND },
+		{ instr(ori), DTB_OP_OR },	{ instr(xori), DTB_OP_XOR },
+		{ instr(slti), DTB_OP_SLT },	{ instr(sltiu), DTB_OP_SLTU },
+		{ NULL, 0 } }, shift_imm[] = {
+		{ instr(sll), DTB_OP_SLL },	{ instr(srl), DTB_OP_SRL },
+		{ instr(sra), DTB_OP_SRA },	{ NULL, 0 } };
+	int i;
+
+	op->dst = op->src1 = op->src2 = NULL;
+	op->imm = 0;
+
+	if (ic->f == instr(nop)) {
+		op->op = DTB_OP_NOP;
+		return 1;
+	}
+	if (ic->f == instr(set)) {
+		op->op = DTB_OP_SET;
+		op->dst = (void *)ic->arg[0];
+		op->imm = (int32_t)ic->arg[1];
+		return 1;
+	}
+	if (ic->f == instr(mov)) {
+		op->op = DTB_OP_MOV;
+		op->dst = (void *)ic->arg[2];
+		op->src1 = (void *)ic->arg[0];
+		return 1;
+	}
+
+	/*  arg[0] = rs, arg[1] = rt, arg[2] = rd:  */
+	for (i=0; three_reg[i].f != NULL; i++)
+		if (ic->f == three_reg[i].f) {
+			op->op = three_reg[i].op;
+			op->dst = (void *)ic->arg[2];
+			op->src1 = (void *)ic->arg[0];
+			op->src2 = (void *)ic->arg[1];
+			return 1;
+		}
+
+	/*  arg[0] = rs, arg[1] = rt, arg[2] = immediate:  */
+	for (i=0; reg_imm[i].f != NULL; i++)
+		if (ic->f == reg_imm[i].f) {
+			op->op = reg_imm[i].op;
+			op->dst = (void *)ic->arg[1];
+			op->src1 = (void *)ic->arg[0];
+			op->imm = (int32_t)ic->arg[2];
+			return 1;
+		}
+
+	/*  arg[0] = rt, arg[1] = sa, arg[2] = rd:  */
+	for (i=0; shift_imm[i].f != NULL; i++)
+		if (ic->f == shift_imm[i].f) {
+			op->op = shift_imm[i].op;
+			op->dst = (void *)ic->arg[2];
+			op->src1 = (void *)ic->arg[0];
+			op->imm = ic->arg[1] & 31;
+			return 1;
+		}
+#endif
+
+	return 0;
+}
+
+
+/*
+ *  dtb_branch_target():
+ *
+ *  Returns the target instr_call of a translated branch within the same
+ *  page, or NULL.
+ */
+static void *instr(dtb_branch_target)(struct mips_instr_call *ic)
+{
+	if (ic->f == instr(beq_samepage) || ic->f == instr(bne_samepage) ||
+	    ic->f == instr(b_samepage) || ic->f == instr(blez_samepage) ||
+	    ic->f == instr(bgtz_samepage) || ic->f == instr(bltz_samepage) ||
+	    ic->f == instr(bgez_samepage) || ic->f == instr(bv_samepage) ||
+	    ic->f == instr(bvl_samepage))
+		return (void *)ic->arg[2];
+	if (ic->f == instr(j_samepage) || ic->f == instr(jal_samepage))
+		return (void *)ic->arg[0];
+	return NULL;
+}
+
+
+/*
+ *  dtb_verify():
+ *
+ *  Called instead of a native block's code when verifying the dyntrans
+ *  backend (the -b command line option). The block is run natively, and then
+ *  again using copies of the original instr_calls; the interpreted result is
+ *  kept. Any difference in register state is a bug in the backend.
+ */
+static void instr(dtb_verify)(struct cpu *cpu, struct mips_instr_call *ic,
+	struct dtb_block *block)
+{
+	void (*native_f)(struct cpu *, struct mips_instr_call *) =
+	    (void (*)(struct cpu *, struct mips_instr_call *))block->native_f;
+	struct mips_instr_call *ics = block->ics;
+	struct mips_instr_call *next_ic = cpu->cd.mips.next_ic, *native_next_ic;
+	uint64_t gpr[N_MIPS_GPRS], native_gpr[N_MIPS_GPRS];
+	uint64_t hi = cpu->cd.mips.hi, lo = cpu->cd.mips.lo;
+	uint64_t native_hi, native_lo;
+	int n_instrs = cpu->n_translated_instrs, native_n_instrs, i;
+	int low_pc;
+
+	memcpy(gpr, cpu->cd.mips.gpr, sizeof(gpr));
+
+	native_f(cpu, ic);
+
+	memcpy(native_gpr, cpu->cd.mips.gpr, sizeof(native_gpr));
+	native_hi = cpu->cd.mips.hi;
+	native_lo = cpu->cd.mips.lo;
+	native_next_ic = cpu->cd.mips.next_ic;
+	native_n_instrs = cpu->n_translated_instrs;
+
+	memcpy(cpu->cd.mips.gpr, gpr, sizeof(gpr));
+	cpu->cd.mips.hi = hi;
+	cpu->cd.mips.lo = lo;
+
+	for (i=0; i<block->n_instrs; i++)
+		ics[i].f(cpu, &ics[i]);
+	cpu->cd.mips.next_ic = next_ic + block->n_instrs - 1;
+	cpu->n_translated_instrs = n_instrs + block->n_instrs - 1;
+
+	if (memcmp(native_gpr, cpu->cd.mips.gpr, sizeof(gpr)) == 0 &&
+	    native_hi == cpu->cd.mips.hi && native_lo == cpu->cd.mips.lo &&
+	    native_next_ic == cpu->cd.mips.next_ic &&
+	    native_n_instrs == cpu->n_translated_instrs)
+		return;
+
+	low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
+	    / sizeof(struct mips_instr_call);
+	fatal("dyntrans backend: native block (%i instructions) at 0x%llx "
+	    "differs from the interpreter:\n", block->n_instrs, (long long)
+	    ((cpu->pc & ~((MIPS_IC_ENTRIES_PER_PAGE-1) <<
+	    MIPS_INSTR_ALIGNMENT_SHIFT)) + (low_pc <<
+	    MIPS_INSTR_ALIGNMENT_SHIFT)));
+	for (i=0; i<N_MIPS_GPRS; i++)
+		if (native_gpr[i] != cpu->cd.mips.gpr[i])
+			fatal("  %-4s native 0x%016llx, interpreted 0x%016llx\n",
+			    regnames[i], (long long)native_gpr[i],
+			    (long long)cpu->cd.mips.gpr[i]);
+	if (native_hi != cpu->cd.mips.hi)
+		fatal("  hi   native 0x%016llx, interpreted 0x%016llx\n",
+		    (long long)native_hi, (long long)cpu->cd.mips.hi);
+	if (native_lo != cpu->cd.mips.lo)
+		fatal("  lo   native 0x%016llx, interpreted 0x%016llx\n",
+		    (long long)native_lo, (long long)cpu->cd.mips.lo);
+	if (native_next_ic != cpu->cd.mips.next_ic ||
+	    native_n_instrs != cpu->n_translated_instrs)
+		fatal("  next_ic/n_translated_instrs differ\n");
+	exit(1);
+}
+#endif	/*  DYNTRANS_BACKEND  */
+
+
 /*****************************************************************************/
 
 
@@ -585,7 +1412,7 @@ X(to_be_translated)
 #ifdef DYNTRANS_BACKEND
 	int simple = 0;
 #endif
-	int main_opcode, rt, rs, rd, sa, s6, x64 = 0;
+	int main_opcode, rt, rs, rd, sa, s6, x64 = 0, vfpu_flags;
 	int in_crosspage_delayslot = 0;
 	int delay_slot_danger = 1;
 	void (*samepage_function)(struct cpu *, struct mips_instr_call *);
@@ -657,7 +1484,46 @@ X(to_be_translated)
 	imm = (int16_t)iword;
 	s6 = iword & 63;
 
-	switch (main_opcode) {
+	/*
+	 *  Allegrex VFPU instructions reuse 64-bit and coprocessor opcodes,
+	 *  so they are picked out first:
+	 */
+	if (cpu->cd.mips.vfpu != NULL && MIPS_VFPU_HI6(main_opcode) &&
+	    MIPS_VFPU_IS_BRANCH(iword)) {
+		if ((iword >> 17) & 1) {
+			ic->f = instr(bvl);
+			samepage_function = instr(bvl_samepage);
+		} else {
+			ic->f = instr(bv);
+			samepage_function = instr(bv_samepage);
+		}
+		ic->arg[0] = (iword >> 18) & 7;
+		ic->arg[1] = (iword >> 16) & 1;
+		ic->arg[2] = (imm << MIPS_INSTR_ALIGNMENT_SHIFT)
+		    + (addr & 0xffc) + 4;
+		if ((uint32_t)ic->arg[2] < ((MIPS_IC_ENTRIES_PER_PAGE - 1)
+		    << MIPS_INSTR_ALIGNMENT_SHIFT) && (addr & 0xffc) < 0xffc) {
+			ic->arg[2] = (size_t) (cpu->cd.mips.cur_ic_page +
+			    ((ic->arg[2] >> MIPS_INSTR_ALIGNMENT_SHIFT)
+			    & (MIPS_IC_ENTRIES_PER_PAGE - 1)));
+			ic->f = samepage_function;
+		}
+		if (in_crosspage_delayslot) {
+			fatal("[ WARNING: branch in delay slot? ]\n");
+			ic->f = instr(nop);
+		}
+	} else if (cpu->cd.mips.vfpu != NULL && MIPS_VFPU_HI6(main_opcode) &&
+	    (vfpu_flags = mips_vfpu_translate(cpu, iword, ic)) != 0) {
+		if (vfpu_flags & MIPS_VFPU_NEEDS_PC) {
+			ic->arg[1] = (size_t)ic->f;
+			ic->arg[2] = addr & 0xffc;
+			ic->f = instr(vfpu_mem);
+		}
+	} else if (cpu->cd.mips.vfpu != NULL && MIPS_VFPU_HI6(main_opcode) &&
+	    main_opcode != HI6_COP2) {
+		fatal("UNIMPLEMENTED VFPU instruction 0x%08x\n", (int)iword);
+		goto bad;
+	} else switch (main_opcode) {
 
 	case HI6_SPECIAL:
 		switch (s6) {
@@ -673,6 +1539,23 @@ X(to_be_translated)
 			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rt];
 			ic->arg[1] = sa;
 			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[rd];
+			if (rd == MIPS_GPR_ZERO) {
+				ic->f = instr(nop);
+				cpu->cd.mips.combination_check = COMBINE(b_nop);
+			}
+			break;
+
+		case SPECIAL_SLLV:
+		case SPECIAL_SRLV:
+		case SPECIAL_SRAV:
+			switch (s6) {
+			case SPECIAL_SLLV: ic->f = instr(sllv); break;
+			case SPECIAL_SRLV: ic->f = instr(srlv); break;
+			case SPECIAL_SRAV: ic->f = instr(srav); break;
+			}
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rt];
+			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rs];
+			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[rd];
 			if (rd == MIPS_GPR_ZERO)
 				ic->f = instr(nop);
 			break;
@@ -683,6 +1566,7 @@ X(to_be_translated)
 		case SPECIAL_DSUBU:
 		case SPECIAL_SLT:
 		case SPECIAL_SLTU:
+		case SPECIAL_AND:
 		case SPECIAL_OR:
 		case SPECIAL_XOR:
 		case SPECIAL_NOR:
@@ -697,6 +1581,7 @@ X(to_be_translated)
 			case SPECIAL_DSUBU: ic->f = instr(dsubu); x64=1; break;
 			case SPECIAL_SLT:   ic->f = instr(slt); break;
 			case SPECIAL_SLTU:  ic->f = instr(sltu); break;
+			case SPECIAL_AND:   ic->f = instr(and); break;
 			case SPECIAL_OR:    ic->f = instr(or); break;
 			case SPECIAL_XOR:   ic->f = instr(xor); break;
 			case SPECIAL_NOR:   ic->f = instr(nor); break;
@@ -761,10 +1646,10 @@ X(to_be_translated)
 		case SPECIAL_JALR:
 			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rs];
 			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rd];
-			if (main_opcode == SPECIAL_JALR && rd == MIPS_GPR_ZERO)
-				main_opcode = SPECIAL_JR;
-			ic->arg[2] = (addr & 0xffc) + 4;
-			switch (main_opcode) {
+			if (s6 == SPECIAL_JALR && rd == MIPS_GPR_ZERO)
+				s6 = SPECIAL_JR;
+			ic->arg[2] = (addr & 0xffc) + 8;
+			switch (s6) {
 			case SPECIAL_JR:
 				if (rs == MIPS_GPR_RA) {
 					if (cpu->machine->show_trace_tree)
@@ -792,6 +1677,11 @@ X(to_be_translated)
 			ic->f = instr(nop);
 			break;
 
+		case SPECIAL_SYSCALL:
+			ic->f = instr(syscall);
+			ic->arg[0] = (iword >> 6) & 0xfffff;
+			break;
+
 		default:goto bad;
 		}
 		break;
@@ -826,6 +1716,83 @@ X(to_be_translated)
 			    & (MIPS_IC_ENTRIES_PER_PAGE - 1)));
 			ic->f = samepage_function;
 		}
+		if (ic->f == instr(bne_samepage))
+			cpu->cd.mips.combination_check = COMBINE(bne);
+		if (in_crosspage_delayslot) {
+			fatal("[ WARNING: branch in delay slot? ]\n");
+			ic->f = instr(nop);
+		}
+		break;
+
+	case HI6_REGIMM:
+	case HI6_BLEZ:
+	case HI6_BGTZ:
+		samepage_function = NULL;  /*  get rid of a compiler warning  */
+		switch (main_opcode) {
+		case HI6_REGIMM:
+			switch (rt) {
+			case REGIMM_BLTZ:
+				ic->f = instr(bltz);
+				samepage_function = instr(bltz_samepage);
+				break;
+			case REGIMM_BGEZ:
+				ic->f = instr(bgez);
+				samepage_function = instr(bgez_samepage);
+				break;
+			default:goto bad;
+			}
+			break;
+		case HI6_BLEZ:
+			ic->f = instr(blez);
+			samepage_function = instr(blez_samepage);
+			break;
+		case HI6_BGTZ:
+			ic->f = instr(bgtz);
+			samepage_function = instr(bgtz_samepage);
+			break;
+		}
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rs];
+		ic->arg[2] = (imm << MIPS_INSTR_ALIGNMENT_SHIFT)
+		    + (addr & 0xffc) + 4;
+		if ((uint32_t)ic->arg[2] < ((MIPS_IC_ENTRIES_PER_PAGE - 1)
+		    << MIPS_INSTR_ALIGNMENT_SHIFT) && (addr & 0xffc) < 0xffc) {
+			ic->arg[2] = (size_t) (cpu->cd.mips.cur_ic_page +
+			    ((ic->arg[2] >> MIPS_INSTR_ALIGNMENT_SHIFT)
+			    & (MIPS_IC_ENTRIES_PER_PAGE - 1)));
+			ic->f = samepage_function;
+		}
+		if (in_crosspage_delayslot) {
+			fatal("[ WARNING: branch in delay slot? ]\n");
+			ic->f = instr(nop);
+		}
+		break;
+
+	case HI6_J:
+	case HI6_JAL:
+		switch (main_opcode) {
+		case HI6_J:
+			ic->f = instr(j);
+			samepage_function = instr(j_samepage);
+			break;
+		case HI6_JAL:
+			if (cpu->machine->show_trace_tree)
+				ic->f = instr(jal_trace);
+			else
+				ic->f = instr(jal);
+			samepage_function = instr(jal_samepage);
+			break;
+		}
+		ic->arg[0] = (iword & 0x03ffffff) << 2;
+		ic->arg[1] = (addr & 0xffc) + 8;
+		/*  A jump within the same page (with the delay slot also
+		    on this page) can go directly to the target instr_call:  */
+		if (((addr ^ ic->arg[0]) & 0x0ffff000) == 0 &&
+		    (addr & 0xffc) < 0xffc && ic->f != instr(jal_trace)) {
+			ic->arg[0] = (size_t) (cpu->cd.mips.cur_ic_page +
+			    ((ic->arg[0] >> MIPS_INSTR_ALIGNMENT_SHIFT)
+			    & (MIPS_IC_ENTRIES_PER_PAGE - 1)));
+			ic->f = samepage_function;
+		}
 		if (in_crosspage_delayslot) {
 			fatal("[ WARNING: branch in delay slot? ]\n");
 			ic->f = instr(nop);
@@ -833,6 +1800,8 @@ X(to_be_translated)
 		break;
 
 	case HI6_ADDIU:
+	case HI6_SLTI:
+	case HI6_SLTIU:
 	case HI6_DADDIU:
 	case HI6_ANDI:
 	case HI6_ORI:
@@ -841,6 +1810,8 @@ X(to_be_translated)
 		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rt];
 		if (main_opcode == HI6_ADDI ||
 		    main_opcode == HI6_ADDIU ||
+		    main_opcode == HI6_SLTI ||
+		    main_opcode == HI6_SLTIU ||
 		    main_opcode == HI6_DADDI ||
 		    main_opcode == HI6_DADDIU)
 			ic->arg[2] = (int16_t)iword;
@@ -848,6 +1819,8 @@ X(to_be_translated)
 			ic->arg[2] = (uint16_t)iword;
 		switch (main_opcode) {
 		case HI6_ADDIU:   ic->f = instr(addiu); break;
+		case HI6_SLTI:    ic->f = instr(slti); break;
+		case HI6_SLTIU:   ic->f = instr(sltiu); break;
 		case HI6_DADDIU:  ic->f = instr(daddiu); x64 = 1; break;
 		case HI6_ANDI:    ic->f = instr(andi); break;
 		case HI6_ORI:     ic->f = instr(ori); break;
@@ -857,7 +1830,9 @@ X(to_be_translated)
 			ic->f = instr(nop);
 
 		if (ic->f == instr(addiu))
-			cpu->cd.mips.combination_check = COMBINE(b_addiu);
+			cpu->cd.mips.combination_check = COMBINE(addiu);
+		if (ic->f == instr(ori))
+			cpu->cd.mips.combination_check = COMBINE(ori);
 		break;
 
 	case HI6_LUI:
@@ -868,6 +1843,46 @@ X(to_be_translated)
 			ic->f = instr(nop);
 		break;
 
+	case HI6_LB:
+	case HI6_LBU:
+	case HI6_LH:
+	case HI6_LHU:
+	case HI6_LW:
+	case HI6_SB:
+	case HI6_SH:
+	case HI6_SW:
+		if (cpu->byte_order != EMUL_LITTLE_ENDIAN) {
+			fatal("TODO: big-endian load/store\n");
+			goto bad;
+		}
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rs];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rt];
+		ic->arg[2] = (int16_t)iword;
+		switch (main_opcode) {
+		case HI6_LB:  ic->f = instr(lb); break;
+		case HI6_LBU: ic->f = instr(lbu); break;
+		case HI6_LH:  ic->f = instr(lh); break;
+		case HI6_LHU: ic->f = instr(lhu); break;
+		case HI6_LW:  ic->f = instr(lw); break;
+		case HI6_SB:  ic->f = instr(sb); break;
+		case HI6_SH:  ic->f = instr(sh); break;
+		case HI6_SW:  ic->f = instr(sw); break;
+		}
+		/*  Loads to the zero register are nops:  */
+		if (rt == MIPS_GPR_ZERO && main_opcode != HI6_SB &&
+		    main_opcode != HI6_SH && main_opcode != HI6_SW)
+			ic->f = instr(nop);
+
+		if (ic->f == instr(lw))
+			cpu->cd.mips.combination_check = COMBINE(lw);
+		break;
+
+	case HI6_CACHE:
+		ic->f = instr(nop);
+		if (cpu->machine->machine_type == MACHINE_PSP)
+			ic->f = instr(cache);
+		break;
+
 	case HI6_COP0:
 		/*  rs contains the coprocessor opcode!  */
 		switch (rs) {
@@ -949,6 +1964,13 @@ X(to_be_translated)
 	if (in_crosspage_delayslot)
 		cpu->cd.mips.combination_check = NULL;
 
+#ifdef DYNTRANS_BACKEND
+	simple = !in_crosspage_delayslot &&
+	    instr(dtb_describe)(cpu, ic, &cpu->translation_context.op);
+	cpu->translation_context.branch_target =
+	    instr(dtb_branch_target)(ic);
+#endif
+
 #define	DYNTRANS_TO_BE_TRANSLATED_TAIL
 #include "cpu_dyntrans.c" 
 #undef	DYNTRANS_TO_BE_TRANSLATED_TAIL
@@ -0,0 +1,2317 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Allegrex VFPU (coprocessor 2) emulation.
+ *
+ *  Every instruction is decoded once into a struct mips_instr_call. arg[0]
+ *  is the instruction word, arg[1] the generic handler, and arg[2] is free
+ *  for the handler variant picked by vfpu_specialize(). Quad and 4x4 matrix
+ *  instructions whose operands are whole columns get handlers which work
+ *  on the register file directly (with SSE when the host has it), and fall
+ *  back to the generic handler whenever a prefix is pending.
+ *
+ *  The same decoded form is used by the old interpreter (through the cache
+ *  in mips_vfpu_run_instr()) and by the dyntrans core.
+ *
+ *  The "vfputest" debugger command runs mips_vfpu_selftest(), which checks
+ *  the handlers against known results.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../../config.h"
+
+#include "cpu.h"
+#include "cpu_mips.h"
+#include "machine.h"
+#include "memory.h"
+#include "misc.h"
+#include "symbol.h"
+
+
+#ifndef ENABLE_MIPS
+
+
+int mips_vfpu_selftest(struct cpu *cpu)
+{ return 0; }
+
+
+#else	/*  ENABLE_MIPS  */
+
+
+#if defined(__SSE__) || defined(__x86_64__)
+#define	VFPU_SSE
+#include <xmmintrin.h>
+#endif
+
+#define	VFPU_OFS(mtx,col,row)	((mtx)*16 + (col)*4 + (row))
+
+#define	VFPU_N(op)	((((op) >> 7) & 1) + (((op) >> 14) & 2) + 1)
+#define	VFPU_VD(op)	((op) & 0x7f)
+#define	VFPU_VS(op)	(((op) >> 8) & 0x7f)
+#define	VFPU_VT(op)	(((op) >> 16) & 0x7f)
+
+#define	VFPU_PI_2	1.57079632679489661923f
+
+typedef void (*vfpu_fn)(struct cpu *, struct mips_instr_call *);
+
+#define	V(n)		static void vfpu_instr_ ## n(struct cpu *cpu, \
+			    struct mips_instr_call *ic)
+#define	vinstr(n)	vfpu_instr_ ## n
+
+/*
+ *  Register number to vpr[] offsets, for each vector size 1..4. Built once
+ *  by vfpu_init_tables().
+ */
+static int vfpu_tables_initialized = 0;
+static uint8_t vfpu_vec_ofs[5][128][4];
+static uint8_t vfpu_mtx_ofs[5][128][16];
+
+static const float vfpu_prefix_const[8] = {
+	0.0f, 1.0f, 2.0f, 0.5f, 3.0f, 1.0f/3.0f, 0.25f, 1.0f/6.0f };
+
+static const char *vfpu_prefix_const_names[8] = {
+	"0", "1", "2", "1/2", "3", "1/3", "1/4", "1/6" };
+
+static const float vfpu_cst[32] = {
+	0.0f,
+	3.402823466e+38f,		/*  VFPU_HUGE  */
+	1.41421356237309504880f,	/*  VFPU_SQRT2  */
+	0.70710678118654752440f,	/*  VFPU_SQRT1_2  */
+	1.12837916709551257390f,	/*  VFPU_2_SQRTPI  */
+	0.63661977236758134308f,	/*  VFPU_2_PI  */
+	0.31830988618379067154f,	/*  VFPU_1_PI  */
+	0.78539816339744830962f,	/*  VFPU_PI_4  */
+	1.57079632679489661923f,	/*  VFPU_PI_2  */
+	3.14159265358979323846f,	/*  VFPU_PI  */
+	2.71828182845904523536f,	/*  VFPU_E  */
+	1.44269504088896340736f,	/*  VFPU_LOG2E  */
+	0.43429448190325182765f,	/*  VFPU_LOG10E  */
+	0.69314718055994530942f,	/*  VFPU_LN2  */
+	2.30258509299404568402f,	/*  VFPU_LN10  */
+	6.28318530717958647692f,	/*  VFPU_2PI  */
+	0.52359877559829887307f,	/*  VFPU_PI_6  */
+	0.30102999566398119521f,	/*  VFPU_LOG10TWO  */
+	3.32192809488736234787f,	/*  VFPU_LOG2TEN  */
+	0.86602540378443864676f		/*  VFPU_SQRT3_2  */
+	};
+
+static const char *vfpu_cst_names[32] = {
+	"(undef)", "MaxFloat", "Sqrt(2)", "Sqrt(1/2)", "2/Sqrt(PI)", "2/PI",
+	"1/PI", "PI/4", "PI/2", "PI", "e", "Log2(e)", "Log10(e)", "Ln(2)",
+	"Ln(10)", "2*PI", "PI/6", "Log10(2)", "Log2(10)", "Sqrt(3)/2",
+	"(undef)", "(undef)", "(undef)", "(undef)", "(undef)", "(undef)",
+	"(undef)", "(undef)", "(undef)", "(undef)", "(undef)", "(undef)" };
+
+static const char *vfpu_cond_names[16] = {
+	"FL", "EQ", "LT", "LE", "TR", "NE", "GE", "GT",
+	"EZ", "EN", "EI", "ES", "NZ", "NN", "NI", "NS" };
+
+static char *regnames[] = MIPS_REGISTER_NAMES;
+
+static const char *vfpu_ctrl_names[16] = {
+	"SPFX", "TPFX", "DPFX", "CC", "INF4", "RSV5", "RSV6", "REV",
+	"RCX0", "RCX1", "RCX2", "RCX3", "RCX4", "RCX5", "RCX6", "RCX7" };
+
+
+static void vfpu_init_tables(void)
+{
+	int n, r, i, j, mtx, col, row, tr;
+
+	for (n=1; n<=4; n++)
+		for (r=0; r<128; r++) {
+			mtx = (r >> 2) & 7;
+			col = r & 3;
+			tr = (r >> 5) & 1;
+			switch (n) {
+			case 1:	row = (r >> 5) & 3; tr = 0; break;
+			case 3:	row = (r >> 6) & 1; break;
+			default:row = (r >> 5) & 2;
+			}
+
+			for (i=0; i<n; i++)
+				vfpu_vec_ofs[n][r][i] = tr?
+				    VFPU_OFS(mtx, (row+i) & 3, col) :
+				    VFPU_OFS(mtx, col, (row+i) & 3);
+
+			for (j=0; j<n; j++)
+				for (i=0; i<n; i++)
+					vfpu_mtx_ofs[n][r][j*4+i] = tr?
+					    VFPU_OFS(mtx, (row+i)&3, (col+j)&3) :
+					    VFPU_OFS(mtx, (col+j)&3, (row+i)&3);
+		}
+
+	vfpu_tables_initialized = 1;
+}
+
+
+static inline uint32_t vfpu_f2u(float f)
+{
+	union { float f; uint32_t u; } x;
+	x.f = f;
+	return x.u;
+}
+
+
+static inline float vfpu_u2f(uint32_t u)
+{
+	union { float f; uint32_t u; } x;
+	x.u = u;
+	return x.f;
+}
+
+
+static float vfpu_half_to_float(uint32_t h)
+{
+	uint32_t sign = (h & 0x8000) << 16, m = h & 0x3ff;
+	int e = (h >> 10) & 0x1f;
+
+	if (e == 0x1f)
+		return vfpu_u2f(sign | 0x7f800000 | (m << 13));
+	if (e == 0) {
+		if (m == 0)
+			return vfpu_u2f(sign);
+		/*  Denormal:  */
+		e = 1;
+		while (!(m & 0x400)) {
+			m <<= 1;
+			e --;
+		}
+		m &= 0x3ff;
+	}
+	return vfpu_u2f(sign | ((e + 127 - 15) << 23) | (m << 13));
+}
+
+
+static uint32_t vfpu_float_to_half(float f)
+{
+	uint32_t x = vfpu_f2u(f), sign = (x >> 16) & 0x8000;
+	uint32_t m = x & 0x7fffff, h;
+	int e = (int)((x >> 23) & 0xff) - 127 + 15, shift;
+
+	if (((x >> 23) & 0xff) == 0xff)
+		return sign | 0x7c00 | (m? 0x200 : 0);
+	if (e >= 31)
+		return sign | 0x7c00;
+	if (e <= 0) {
+		if (e < -10)
+			return sign;
+		m |= 0x800000;
+		shift = 14 - e;
+		h = m >> shift;
+		if ((m >> (shift - 1)) & 1)
+			h ++;
+		return sign | h;
+	}
+	h = sign | (e << 10) | (m >> 13);
+	if (m & 0x1000)
+		h ++;
+	return h;
+}
+
+
+/*
+ *  Register access with prefixes:
+ *
+ *  The S and T prefixes hold, for each lane, a 2-bit swizzle (bits 0-7), an
+ *  abs flag (8-11), a constant flag (12-15) and a negate flag (16-19). The
+ *  D prefix holds a 2-bit saturation mode per lane (bits 0-7) and a write
+ *  mask (bits 8-11). All three are reset after the next instruction.
+ */
+static void vfpu_read_raw(struct mips_vfpu *v, float *d, int n, int reg)
+{
+	const uint8_t *ofs = vfpu_vec_ofs[n][reg];
+	int i;
+
+	for (i=0; i<n; i++)
+		d[i] = v->vpr.f[ofs[i]];
+}
+
+
+static void vfpu_read_src(struct mips_vfpu *v, float *d, int n, int reg,
+	int which)
+{
+	uint32_t pfx = v->ctrl[VFPU_CTRL_SPREFIX + which];
+	float src[4];
+	int i;
+
+	if (pfx == 0xe4) {
+		vfpu_read_raw(v, d, n, reg);
+		return;
+	}
+
+	vfpu_read_raw(v, src, n, reg);
+	for (i=0; i<n; i++) {
+		int swz = (pfx >> (i*2)) & 3, absf = (pfx >> (8+i)) & 1;
+		float f;
+
+		if ((pfx >> (12+i)) & 1)
+			f = vfpu_prefix_const[swz + absf*4];
+		else {
+			f = swz < n? src[swz] : 0.0f;
+			if (absf)
+				f = fabsf(f);
+		}
+		if ((pfx >> (16+i)) & 1)
+			f = -f;
+		d[i] = f;
+	}
+}
+
+
+static void vfpu_write_dst(struct mips_vfpu *v, const float *s, int n, int reg)
+{
+	const uint8_t *ofs = vfpu_vec_ofs[n][reg];
+	uint32_t pfx = v->ctrl[VFPU_CTRL_DPREFIX];
+	int i;
+
+	if (pfx == 0) {
+		for (i=0; i<n; i++)
+			v->vpr.f[ofs[i]] = s[i];
+		return;
+	}
+
+	for (i=0; i<n; i++) {
+		float f = s[i];
+		if ((pfx >> (8+i)) & 1)
+			continue;
+		switch ((pfx >> (i*2)) & 3) {
+		case 1:	f = f < 0.0f? 0.0f : (f > 1.0f? 1.0f : f);
+			break;
+		case 3:	f = f < -1.0f? -1.0f : (f > 1.0f? 1.0f : f);
+			break;
+		}
+		v->vpr.f[ofs[i]] = f;
+	}
+}
+
+
+/*  Integer results are only masked, never saturated:  */
+static void vfpu_write_dst_u32(struct mips_vfpu *v, const uint32_t *s, int n,
+	int reg)
+{
+	const uint8_t *ofs = vfpu_vec_ofs[n][reg];
+	uint32_t pfx = v->ctrl[VFPU_CTRL_DPREFIX];
+	int i;
+
+	for (i=0; i<n; i++)
+		if (!((pfx >> (8+i)) & 1))
+			v->vpr.u[ofs[i]] = s[i];
+}
+
+
+static void vfpu_read_mtx(struct mips_vfpu *v, float *d, int n, int reg)
+{
+	const uint8_t *ofs = vfpu_mtx_ofs[n][reg];
+	int i, j;
+
+	for (j=0; j<n; j++)
+		for (i=0; i<n; i++)
+			d[j*4+i] = v->vpr.f[ofs[j*4+i]];
+}
+
+
+static void vfpu_write_mtx(struct mips_vfpu *v, const float *s, int n, int reg)
+{
+	const uint8_t *ofs = vfpu_mtx_ofs[n][reg];
+	int i, j;
+
+	for (j=0; j<n; j++)
+		for (i=0; i<n; i++)
+			v->vpr.f[ofs[j*4+i]] = s[j*4+i];
+}
+
+
+static inline void vfpu_eat_prefixes(struct mips_vfpu *v)
+{
+	if (v->pfx_active) {
+		v->ctrl[VFPU_CTRL_SPREFIX] = 0xe4;
+		v->ctrl[VFPU_CTRL_TPREFIX] = 0xe4;
+		v->ctrl[VFPU_CTRL_DPREFIX] = 0;
+		v->pfx_active = 0;
+	}
+}
+
+
+static void vfpu_write_ctrl(struct mips_vfpu *v, int nr, uint32_t value)
+{
+	nr &= (MIPS_VFPU_N_CTRL - 1);
+	switch (nr) {
+	case VFPU_CTRL_SPREFIX:
+	case VFPU_CTRL_TPREFIX:
+	case VFPU_CTRL_DPREFIX:
+		v->ctrl[nr] = value & (nr == VFPU_CTRL_DPREFIX? 0xfff : 0xfffff);
+		v->pfx_active = 1;
+		break;
+	case VFPU_CTRL_CC:
+		v->ctrl[nr] = value & 0x3f;
+		break;
+	case VFPU_CTRL_REV:
+		/*  Read-only.  */
+		break;
+	default:v->ctrl[nr] = value;
+	}
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Element-wise instructions on two vectors:
+ */
+#define	VFPU_BINOP(name, expr)						\
+V(name)									\
+{									\
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;			\
+	uint32_t op = ic->arg[0];					\
+	int i, n = VFPU_N(op);						\
+	float s[4], t[4], d[4];						\
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);				\
+	vfpu_read_src(v, t, n, VFPU_VT(op), 1);				\
+	for (i=0; i<n; i++)						\
+		d[i] = (expr);						\
+	vfpu_write_dst(v, d, n, VFPU_VD(op));				\
+	vfpu_eat_prefixes(v);						\
+}
+
+VFPU_BINOP(vadd, s[i] + t[i])
+VFPU_BINOP(vsub, s[i] - t[i])
+VFPU_BINOP(vsbn, ldexpf(s[i], (int32_t)vfpu_f2u(t[i])))
+VFPU_BINOP(vdiv, s[i] / t[i])
+VFPU_BINOP(vmul, s[i] * t[i])
+VFPU_BINOP(vmin, s[i] < t[i]? s[i] : t[i])
+VFPU_BINOP(vmax, s[i] > t[i]? s[i] : t[i])
+VFPU_BINOP(vscmp, s[i] > t[i]? 1.0f : (s[i] < t[i]? -1.0f : 0.0f))
+VFPU_BINOP(vsge, s[i] >= t[i]? 1.0f : 0.0f)
+VFPU_BINOP(vslt, s[i] < t[i]? 1.0f : 0.0f)
+
+
+/*
+ *  Element-wise instructions on one vector:
+ */
+#define	VFPU_UNOP(name, expr)						\
+V(name)									\
+{									\
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;			\
+	uint32_t op = ic->arg[0];					\
+	int i, n = VFPU_N(op);						\
+	float s[4], d[4];						\
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);				\
+	for (i=0; i<n; i++)						\
+		d[i] = (expr);						\
+	vfpu_write_dst(v, d, n, VFPU_VD(op));				\
+	vfpu_eat_prefixes(v);						\
+}
+
+VFPU_UNOP(vmov, s[i])
+VFPU_UNOP(vabs, fabsf(s[i]))
+VFPU_UNOP(vneg, -s[i])
+VFPU_UNOP(vsat0, s[i] < 0.0f? 0.0f : (s[i] > 1.0f? 1.0f : s[i]))
+VFPU_UNOP(vsat1, s[i] < -1.0f? -1.0f : (s[i] > 1.0f? 1.0f : s[i]))
+VFPU_UNOP(vzero, 0.0f)
+VFPU_UNOP(vone, 1.0f)
+VFPU_UNOP(vrcp, 1.0f / s[i])
+VFPU_UNOP(vrsq, 1.0f / sqrtf(s[i]))
+VFPU_UNOP(vsin, sinf(s[i] * VFPU_PI_2))
+VFPU_UNOP(vcos, cosf(s[i] * VFPU_PI_2))
+VFPU_UNOP(vexp2, powf(2.0f, s[i]))
+VFPU_UNOP(vlog2, logf(s[i]) / logf(2.0f))
+VFPU_UNOP(vsqrt, sqrtf(s[i]))
+VFPU_UNOP(vasin, asinf(s[i]) / VFPU_PI_2)
+VFPU_UNOP(vnrcp, -1.0f / s[i])
+VFPU_UNOP(vnsin, -sinf(s[i] * VFPU_PI_2))
+VFPU_UNOP(vrexp2, 1.0f / powf(2.0f, s[i]))
+VFPU_UNOP(vocp, 1.0f - s[i])
+VFPU_UNOP(vsgn, s[i] > 0.0f? 1.0f : (s[i] < 0.0f? -1.0f : 0.0f))
+
+
+/*
+ *  vidt:  One row of the identity matrix, picked by the register number.
+ */
+V(vidt)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op), id = VFPU_VD(op) & (n == 2? 1 : 3);
+	float d[4];
+
+	for (i=0; i<n; i++)
+		d[i] = i == id? 1.0f : 0.0f;
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  Reductions, the result is a single:
+ *
+ *  vdot:  s . t
+ *  vhdp:  homogeneous dot product, the last lane of s counts as 1
+ *  vdet:  2x2 determinant
+ *  vfad:  sum of lanes
+ *  vavg:  average of lanes
+ */
+V(vdot)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], t[4], d;
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, n, VFPU_VT(op), 1);
+	d = s[0] * t[0];
+	for (i=1; i<n; i++)
+		d += s[i] * t[i];
+	vfpu_write_dst(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vhdp)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], t[4], d;
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, n, VFPU_VT(op), 1);
+	d = 0.0f;
+	for (i=0; i<n-1; i++)
+		d += s[i] * t[i];
+	d += t[n-1];
+	vfpu_write_dst(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vdet)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], t[4], d;
+
+	vfpu_read_src(v, s, 2, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, 2, VFPU_VT(op), 1);
+	d = s[0] * t[1] - s[1] * t[0];
+	vfpu_write_dst(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vfad)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], d = 0.0f;
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++)
+		d += s[i];
+	vfpu_write_dst(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vavg)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], d = 0.0f;
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++)
+		d += s[i];
+	d /= (float)n;
+	vfpu_write_dst(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vscl:   s * t[0]
+ *  vcrs:   half of a cross product (.t only)
+ *  vcrsp:  cross product (.t only)
+ *  vqmul:  quaternion product (.q only)
+ */
+V(vscl)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], t, d[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	vfpu_read_src(v, &t, 1, VFPU_VT(op), 1);
+	for (i=0; i<n; i++)
+		d[i] = s[i] * t;
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vcrs)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], t[4], d[4];
+
+	vfpu_read_src(v, s, 3, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, 3, VFPU_VT(op), 1);
+	d[0] = s[1] * t[2];
+	d[1] = s[2] * t[0];
+	d[2] = s[0] * t[1];
+	vfpu_write_dst(v, d, 3, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vcrsp)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], t[4], d[4];
+
+	vfpu_read_src(v, s, 3, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, 3, VFPU_VT(op), 1);
+	d[0] = s[1] * t[2] - s[2] * t[1];
+	d[1] = s[2] * t[0] - s[0] * t[2];
+	d[2] = s[0] * t[1] - s[1] * t[0];
+	vfpu_write_dst(v, d, 3, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vqmul)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], t[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, 4, VFPU_VT(op), 1);
+	d[0] =  s[0]*t[3] + s[1]*t[2] - s[2]*t[1] + s[3]*t[0];
+	d[1] = -s[0]*t[2] + s[1]*t[3] + s[2]*t[0] + s[3]*t[1];
+	d[2] =  s[0]*t[1] - s[1]*t[0] + s[2]*t[3] + s[3]*t[2];
+	d[3] = -s[0]*t[0] - s[1]*t[1] - s[2]*t[2] + s[3]*t[3];
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vcmp:  Compare, setting one CC bit per lane, plus "any" (bit 4) and
+ *         "all" (bit 5).
+ */
+V(vcmp)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op), c, cc = 0, any = 0, all = 1;
+	int affected = 0x30;
+	float s[4], t[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	vfpu_read_src(v, t, n, VFPU_VT(op), 1);
+
+	for (i=0; i<n; i++) {
+		switch (op & 15) {
+		case 0:	c = 0; break;
+		case 1:	c = s[i] == t[i]; break;
+		case 2:	c = s[i] < t[i]; break;
+		case 3:	c = s[i] <= t[i]; break;
+		case 4:	c = 1; break;
+		case 5:	c = s[i] != t[i]; break;
+		case 6:	c = s[i] >= t[i]; break;
+		case 7:	c = s[i] > t[i]; break;
+		case 8:	c = s[i] == 0.0f; break;
+		case 9:	c = isnan(s[i]); break;
+		case 10:c = isinf(s[i]); break;
+		case 11:c = isnan(s[i]) || isinf(s[i]); break;
+		case 12:c = s[i] != 0.0f; break;
+		case 13:c = !isnan(s[i]); break;
+		case 14:c = !isinf(s[i]); break;
+		default:c = !(isnan(s[i]) || isinf(s[i]));
+		}
+		c = c? 1 : 0;
+		cc |= c << i;
+		any |= c;
+		all &= c;
+		affected |= 1 << i;
+	}
+
+	cc |= (any << 4) | (all << 5);
+	v->ctrl[VFPU_CTRL_CC] = (v->ctrl[VFPU_CTRL_CC] & ~affected)
+	    | (cc & affected);
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vcmovt, vcmovf:  Conditional move on one CC bit, or per lane if the
+ *                   bit number is 6.
+ */
+V(vcmov)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op), tf = (op >> 19) & 1, imm3 = (op >> 16) & 7;
+	uint32_t cc = v->ctrl[VFPU_CTRL_CC];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	vfpu_read_raw(v, d, n, VFPU_VD(op));
+
+	if (imm3 < 6) {
+		if (((cc >> imm3) & 1) == !tf)
+			for (i=0; i<n; i++)
+				d[i] = s[i];
+	} else if (imm3 == 6) {
+		for (i=0; i<n; i++)
+			if (((cc >> i) & 1) == !tf)
+				d[i] = s[i];
+	}
+
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vsrt1..4, vbfy1..2:  Sorting and butterfly steps.
+ */
+V(vsrt1)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	d[0] = fminf(s[0], s[1]); d[1] = fmaxf(s[0], s[1]);
+	d[2] = fminf(s[2], s[3]); d[3] = fmaxf(s[2], s[3]);
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vsrt2)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	d[0] = fminf(s[0], s[3]); d[1] = fminf(s[1], s[2]);
+	d[2] = fmaxf(s[1], s[2]); d[3] = fmaxf(s[0], s[3]);
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vsrt3)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	d[0] = fmaxf(s[0], s[1]); d[1] = fminf(s[0], s[1]);
+	d[2] = fmaxf(s[2], s[3]); d[3] = fminf(s[2], s[3]);
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vsrt4)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	d[0] = fmaxf(s[0], s[3]); d[1] = fmaxf(s[1], s[2]);
+	d[2] = fminf(s[1], s[2]); d[3] = fminf(s[0], s[3]);
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vbfy1)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int n = VFPU_N(op);
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	d[0] = s[0] + s[1]; d[1] = s[0] - s[1];
+	d[2] = s[2] + s[3]; d[3] = s[2] - s[3];
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vbfy2)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[4], d[4];
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	d[0] = s[0] + s[2]; d[1] = s[1] + s[3];
+	d[2] = s[0] - s[2]; d[3] = s[1] - s[3];
+	vfpu_write_dst(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vcst:  Load a constant.
+ */
+V(vcst)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float d[4];
+
+	for (i=0; i<n; i++)
+		d[i] = vfpu_cst[(op >> 16) & 0x1f];
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vf2in, vf2iz, vf2iu, vf2id:  Float to fixed point, rounding to nearest,
+ *                               towards zero, up, or down.
+ *  vi2f:  Fixed point to float.
+ */
+V(vf2i)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d[4];
+	int i, n = VFPU_N(op);
+	double scale = (double)(1 << ((op >> 16) & 0x1f)), x;
+	float s[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++) {
+		if (isnan(s[i])) {
+			d[i] = 0x7fffffff;
+			continue;
+		}
+		x = (double)s[i] * scale;
+		switch ((op >> 21) & 3) {
+		case 0:	x = rint(x); break;
+		case 1:	x = x >= 0.0? floor(x) : ceil(x); break;
+		case 2:	x = ceil(x); break;
+		default:x = floor(x);
+		}
+		if (x >= 2147483647.0)
+			d[i] = 0x7fffffff;
+		else if (x <= -2147483648.0)
+			d[i] = 0x80000000;
+		else
+			d[i] = (uint32_t)(int32_t)x;
+	}
+	vfpu_write_dst_u32(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vi2f)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op);
+	float s[4], d[4], scale = 1.0f / (float)(1 << ((op >> 16) & 0x1f));
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++)
+		d[i] = (float)(int32_t)vfpu_f2u(s[i]) * scale;
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  Packing and unpacking of integers and half floats. The output has a
+ *  different number of lanes than the input.
+ */
+V(vi2uc)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d = 0;
+	float s[4];
+	int i;
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	for (i=0; i<4; i++) {
+		int32_t x = vfpu_f2u(s[i]);
+		d |= (uint32_t)(x < 0? 0 : (x >> 23) & 0xff) << (i*8);
+	}
+	vfpu_write_dst_u32(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vi2c)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d = 0;
+	float s[4];
+	int i;
+
+	vfpu_read_src(v, s, 4, VFPU_VS(op), 0);
+	for (i=0; i<4; i++)
+		d |= (vfpu_f2u(s[i]) >> 24) << (i*8);
+	vfpu_write_dst_u32(v, &d, 1, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vi2us)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d[2];
+	int i, n = VFPU_N(op);
+	float s[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n/2; i++) {
+		int32_t lo = vfpu_f2u(s[i*2]), hi = vfpu_f2u(s[i*2+1]);
+		d[i] = (uint32_t)(lo < 0? 0 : lo >> 15)
+		    | ((uint32_t)(hi < 0? 0 : hi >> 15) << 16);
+	}
+	vfpu_write_dst_u32(v, d, n/2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vi2s)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d[2];
+	int i, n = VFPU_N(op);
+	float s[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n/2; i++)
+		d[i] = (vfpu_f2u(s[i*2]) >> 16)
+		    | (vfpu_f2u(s[i*2+1]) & 0xffff0000);
+	vfpu_write_dst_u32(v, d, n/2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vuc2i)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], x, d[4];
+	float s;
+	int i;
+
+	vfpu_read_src(v, &s, 1, VFPU_VS(op), 0);
+	x = vfpu_f2u(s);
+	for (i=0; i<4; i++)
+		d[i] = (((x >> (i*8)) & 0xff) * 0x01010101) >> 1;
+	vfpu_write_dst_u32(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vc2i)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], x, d[4];
+	float s;
+	int i;
+
+	vfpu_read_src(v, &s, 1, VFPU_VS(op), 0);
+	x = vfpu_f2u(s);
+	for (i=0; i<4; i++)
+		d[i] = ((x >> (i*8)) & 0xff) << 24;
+	vfpu_write_dst_u32(v, d, 4, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vus2i)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], x, d[4];
+	int i, n = VFPU_N(op);
+	float s[2];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++) {
+		x = vfpu_f2u(s[i]);
+		d[i*2] = (x & 0xffff) << 15;
+		d[i*2+1] = (x & 0xffff0000) >> 1;
+	}
+	vfpu_write_dst_u32(v, d, n*2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vs2i)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], x, d[4];
+	int i, n = VFPU_N(op);
+	float s[2];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++) {
+		x = vfpu_f2u(s[i]);
+		d[i*2] = x << 16;
+		d[i*2+1] = x & 0xffff0000;
+	}
+	vfpu_write_dst_u32(v, d, n*2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vf2h)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], d[2];
+	int i, n = VFPU_N(op);
+	float s[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n/2; i++)
+		d[i] = vfpu_float_to_half(s[i*2])
+		    | (vfpu_float_to_half(s[i*2+1]) << 16);
+	vfpu_write_dst_u32(v, d, n/2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vh2f)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], x;
+	int i, n = VFPU_N(op);
+	float s[2], d[4];
+
+	vfpu_read_src(v, s, n, VFPU_VS(op), 0);
+	for (i=0; i<n; i++) {
+		x = vfpu_f2u(s[i]);
+		d[i*2] = vfpu_half_to_float(x & 0xffff);
+		d[i*2+1] = vfpu_half_to_float(x >> 16);
+	}
+	vfpu_write_dst(v, d, n*2, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  Prefixes and immediates:
+ */
+V(vpfxs)
+{
+	vfpu_write_ctrl(cpu->cd.mips.vfpu, VFPU_CTRL_SPREFIX, ic->arg[0]);
+}
+V(vpfxt)
+{
+	vfpu_write_ctrl(cpu->cd.mips.vfpu, VFPU_CTRL_TPREFIX, ic->arg[0]);
+}
+V(vpfxd)
+{
+	vfpu_write_ctrl(cpu->cd.mips.vfpu, VFPU_CTRL_DPREFIX, ic->arg[0]);
+}
+V(viim)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float d = (float)(int16_t)op;
+
+	vfpu_write_dst(v, &d, 1, VFPU_VT(op));
+	vfpu_eat_prefixes(v);
+}
+V(vfim)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float d = vfpu_half_to_float(op & 0xffff);
+
+	vfpu_write_dst(v, &d, 1, VFPU_VT(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  Transfers to and from the integer registers and the control registers:
+ */
+V(mfv)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int rt = (op >> 16) & 31;
+
+	if (rt != MIPS_GPR_ZERO)
+		cpu->cd.mips.gpr[rt] = (int32_t)v->vpr.u[vfpu_vec_ofs[1]
+		    [VFPU_VD(op)][0]];
+}
+V(mfvc)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int rt = (op >> 16) & 31;
+
+	if (rt != MIPS_GPR_ZERO)
+		cpu->cd.mips.gpr[rt] = (int32_t)v->ctrl[op & 15];
+}
+V(mtv)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+
+	v->vpr.u[vfpu_vec_ofs[1][VFPU_VD(op)][0]] =
+	    cpu->cd.mips.gpr[(op >> 16) & 31];
+}
+V(mtvc)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+
+	vfpu_write_ctrl(v, op & 15, cpu->cd.mips.gpr[(op >> 16) & 31]);
+}
+V(vmfvc)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+
+	v->vpr.u[vfpu_vec_ofs[1][VFPU_VD(op)][0]] = v->ctrl[(op >> 8) & 15];
+	vfpu_eat_prefixes(v);
+}
+V(vmtvc)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+
+	vfpu_write_ctrl(v, op & 15, v->vpr.u[vfpu_vec_ofs[1][VFPU_VS(op)][0]]);
+}
+
+
+/*
+ *  Loads and stores. These may cause exceptions; memory_rw() has then
+ *  already set things up, and the register file is left untouched.
+ */
+static int vfpu_mem(struct cpu *cpu, uint64_t addr, uint32_t *words, int n,
+	int writeflag)
+{
+	unsigned char buf[16];
+	int i;
+
+	if (writeflag == MEM_WRITE)
+		for (i=0; i<n; i++) {
+			buf[i*4+0] = words[i];
+			buf[i*4+1] = words[i] >> 8;
+			buf[i*4+2] = words[i] >> 16;
+			buf[i*4+3] = words[i] >> 24;
+		}
+
+	if (!cpu->memory_rw(cpu, cpu->mem, addr, buf, n * 4, writeflag,
+	    CACHE_DATA))
+		return 0;
+
+	if (writeflag == MEM_READ)
+		for (i=0; i<n; i++)
+			words[i] = buf[i*4] | (buf[i*4+1] << 8) |
+			    (buf[i*4+2] << 16) | ((uint32_t)buf[i*4+3] << 24);
+	return 1;
+}
+
+#define	VFPU_MEM_ADDR(op)	((uint32_t)(cpu->cd.mips.gpr[((op) >> 21) & 31]\
+				    + (int16_t)((op) & 0xfffc)))
+
+V(lv_s)
+{
+	uint32_t op = ic->arg[0], w;
+	int vt = ((op >> 16) & 0x1f) | ((op & 3) << 5);
+
+	if (vfpu_mem(cpu, VFPU_MEM_ADDR(op), &w, 1, MEM_READ))
+		cpu->cd.mips.vfpu->vpr.u[vfpu_vec_ofs[1][vt][0]] = w;
+}
+V(sv_s)
+{
+	uint32_t op = ic->arg[0], w;
+	int vt = ((op >> 16) & 0x1f) | ((op & 3) << 5);
+
+	w = cpu->cd.mips.vfpu->vpr.u[vfpu_vec_ofs[1][vt][0]];
+	vfpu_mem(cpu, VFPU_MEM_ADDR(op), &w, 1, MEM_WRITE);
+}
+V(lv_q)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], w[4];
+	const uint8_t *ofs = vfpu_vec_ofs[4][((op >> 16) & 0x1f) |
+	    ((op & 1) << 5)];
+	int i;
+
+	if (vfpu_mem(cpu, VFPU_MEM_ADDR(op), w, 4, MEM_READ))
+		for (i=0; i<4; i++)
+			v->vpr.u[ofs[i]] = w[i];
+}
+V(sv_q)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], w[4];
+	const uint8_t *ofs = vfpu_vec_ofs[4][((op >> 16) & 0x1f) |
+	    ((op & 1) << 5)];
+	int i;
+
+	for (i=0; i<4; i++)
+		w[i] = v->vpr.u[ofs[i]];
+	vfpu_mem(cpu, VFPU_MEM_ADDR(op), w, 4, MEM_WRITE);
+}
+
+/*
+ *  lvl.q, lvr.q, svl.q, svr.q:  The two halves of an unaligned quad access
+ *  (ulv.q and usv.q). The left part covers the words up to and including
+ *  addr within its 16-byte block, the right part the words from addr on.
+ */
+V(lvlr_q)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], addr = VFPU_MEM_ADDR(op), w[4];
+	const uint8_t *ofs = vfpu_vec_ofs[4][((op >> 16) & 0x1f) |
+	    ((op & 1) << 5)];
+	int i, k = (addr >> 2) & 3;
+
+	if (!(op & 2)) {
+		if (!vfpu_mem(cpu, addr - k*4, w, k + 1, MEM_READ))
+			return;
+		for (i=0; i<=k; i++)
+			v->vpr.u[ofs[3-i]] = w[k-i];
+	} else {
+		if (!vfpu_mem(cpu, addr, w, 4 - k, MEM_READ))
+			return;
+		for (i=0; i<4-k; i++)
+			v->vpr.u[ofs[i]] = w[i];
+	}
+}
+V(svlr_q)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0], addr = VFPU_MEM_ADDR(op), w[4];
+	const uint8_t *ofs = vfpu_vec_ofs[4][((op >> 16) & 0x1f) |
+	    ((op & 1) << 5)];
+	int i, k = (addr >> 2) & 3;
+
+	if (!(op & 2)) {
+		for (i=0; i<=k; i++)
+			w[k-i] = v->vpr.u[ofs[3-i]];
+		vfpu_mem(cpu, addr - k*4, w, k + 1, MEM_WRITE);
+	} else {
+		for (i=0; i<4-k; i++)
+			w[i] = v->vpr.u[ofs[i]];
+		vfpu_mem(cpu, addr, w, 4 - k, MEM_WRITE);
+	}
+}
+
+
+/*
+ *  Matrix instructions. Element j*4+i is row i of column j.
+ *
+ *  vmmul:  d = transpose(s) * t
+ *  vtfm:   d = transpose(s) * t, for vectors; vhtfm is the homogeneous
+ *          variant where t is one lane short and counts as 1 there.
+ */
+V(vmmul)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int a, b, c, n = VFPU_N(op);
+	float s[16], t[16], d[16], sum;
+
+	vfpu_read_mtx(v, s, n, VFPU_VS(op));
+	vfpu_read_mtx(v, t, n, VFPU_VT(op));
+	for (a=0; a<n; a++)
+		for (b=0; b<n; b++) {
+			sum = s[b*4] * t[a*4];
+			for (c=1; c<n; c++)
+				sum += s[b*4+c] * t[a*4+c];
+			d[a*4+b] = sum;
+		}
+	vfpu_write_mtx(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vtfm)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, j, n = VFPU_N(op), m = ((op >> 23) & 7) + 1;
+	float s[16], t[4], d[4], sum;
+
+	vfpu_read_mtx(v, s, m, VFPU_VS(op));
+	vfpu_read_src(v, t, n, VFPU_VT(op), 1);
+	for (i=0; i<m; i++) {
+		sum = s[i*4] * t[0];
+		for (j=1; j<n; j++)
+			sum += s[i*4+j] * t[j];
+		if (n < m)
+			sum += s[i*4+m-1];
+		d[i] = sum;
+	}
+	vfpu_write_dst(v, d, m, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vmscl)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, j, n = VFPU_N(op);
+	float s[16], t;
+
+	vfpu_read_mtx(v, s, n, VFPU_VS(op));
+	vfpu_read_src(v, &t, 1, VFPU_VT(op), 1);
+	for (j=0; j<n; j++)
+		for (i=0; i<n; i++)
+			s[j*4+i] *= t;
+	vfpu_write_mtx(v, s, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vmmov)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float s[16];
+
+	vfpu_read_mtx(v, s, VFPU_N(op), VFPU_VS(op));
+	vfpu_write_mtx(v, s, VFPU_N(op), VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vmidt)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, j, n = VFPU_N(op);
+	float d[16];
+
+	for (j=0; j<n; j++)
+		for (i=0; i<n; i++)
+			d[j*4+i] = i == j? 1.0f : 0.0f;
+	vfpu_write_mtx(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vmzero)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float d[16];
+
+	memset(d, 0, sizeof(d));
+	vfpu_write_mtx(v, d, VFPU_N(op), VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+V(vmone)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	float d[16];
+	int i;
+
+	for (i=0; i<16; i++)
+		d[i] = 1.0f;
+	vfpu_write_mtx(v, d, VFPU_N(op), VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+/*
+ *  vrot:  Build a rotation row. Bits 0-1 of the immediate pick the cosine
+ *         lane, bits 2-3 the sine lane (all other lanes if they are the
+ *         same), and bit 4 negates the sine.
+ */
+V(vrot)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	uint32_t op = ic->arg[0];
+	int i, n = VFPU_N(op), imm = (op >> 16) & 0x1f;
+	float s, sine, cosine, d[4];
+
+	vfpu_read_src(v, &s, 1, VFPU_VS(op), 0);
+	sine = sinf(s * VFPU_PI_2);
+	cosine = cosf(s * VFPU_PI_2);
+	if (imm & 0x10)
+		sine = -sine;
+
+	for (i=0; i<n; i++)
+		d[i] = 0.0f;
+	if (((imm >> 2) & 3) == (imm & 3))
+		for (i=0; i<n; i++)
+			d[i] = sine;
+	else
+		d[(imm >> 2) & 3] = sine;
+	d[imm & 3] = cosine;
+
+	vfpu_write_dst(v, d, n, VFPU_VD(op));
+	vfpu_eat_prefixes(v);
+}
+
+
+V(vnop)
+{
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Specialized handlers for quad and 4x4 matrix operands which are whole
+ *  columns. arg[2] holds the vpr[] offsets of vd (bits 0-7), vs (8-15) and
+ *  vt (16-23); for matrices these are the offsets of the first column, the
+ *  other columns following at (col+j)&3.
+ */
+#ifdef VFPU_SSE
+typedef __m128 vfpu_v4;
+#define	V4_LOAD(p)		_mm_loadu_ps(p)
+#define	V4_STORE(p,x)		_mm_storeu_ps(p, x)
+#define	V4_SET1(f)		_mm_set1_ps(f)
+#define	V4_ADD(a,b)		_mm_add_ps(a, b)
+#define	V4_SUB(a,b)		_mm_sub_ps(a, b)
+#define	V4_MUL(a,b)		_mm_mul_ps(a, b)
+#define	V4_TRANSPOSE(a,b,c,d)	_MM_TRANSPOSE4_PS(a, b, c, d)
+#else
+typedef struct { float f[4]; } vfpu_v4;
+static inline vfpu_v4 v4_load(const float *p)
+{ vfpu_v4 x; memcpy(x.f, p, sizeof(x.f)); return x; }
+static inline vfpu_v4 v4_set1(float f)
+{ vfpu_v4 x; x.f[0] = x.f[1] = x.f[2] = x.f[3] = f; return x; }
+static inline vfpu_v4 v4_add(vfpu_v4 a, vfpu_v4 b)
+{ int i; for (i=0; i<4; i++) a.f[i] += b.f[i]; return a; }
+static inline vfpu_v4 v4_sub(vfpu_v4 a, vfpu_v4 b)
+{ int i; for (i=0; i<4; i++) a.f[i] -= b.f[i]; return a; }
+static inline vfpu_v4 v4_mul(vfpu_v4 a, vfpu_v4 b)
+{ int i; for (i=0; i<4; i++) a.f[i] *= b.f[i]; return a; }
+#define	V4_LOAD(p)		v4_load(p)
+#define	V4_STORE(p,x)		memcpy((p), (x).f, sizeof((x).f))
+#define	V4_SET1(f)		v4_set1(f)
+#define	V4_ADD(a,b)		v4_add(a, b)
+#define	V4_SUB(a,b)		v4_sub(a, b)
+#define	V4_MUL(a,b)		v4_mul(a, b)
+static inline void v4_transpose(vfpu_v4 *a, vfpu_v4 *b, vfpu_v4 *c,
+	vfpu_v4 *d)
+{
+	vfpu_v4 *r[4], t[4];
+	int i, j;
+	r[0] = a; r[1] = b; r[2] = c; r[3] = d;
+	for (i=0; i<4; i++)
+		t[i] = *r[i];
+	for (i=0; i<4; i++)
+		for (j=0; j<4; j++)
+			r[i]->f[j] = t[j].f[i];
+}
+#define	V4_TRANSPOSE(a,b,c,d)	v4_transpose(&(a), &(b), &(c), &(d))
+#endif
+
+#define	FAST_D(ic)	((ic)->arg[2] & 0xff)
+#define	FAST_S(ic)	(((ic)->arg[2] >> 8) & 0xff)
+#define	FAST_T(ic)	(((ic)->arg[2] >> 16) & 0xff)
+#define	FAST_COL(o,j)	(((o) & ~15) + ((((o) >> 2) + (j)) & 3) * 4)
+
+#define	FAST_FALLBACK(cpu,ic)						\
+	if ((cpu)->cd.mips.vfpu->pfx_active) {				\
+		((vfpu_fn)(ic)->arg[1])(cpu, ic);			\
+		return;							\
+	}
+
+#define	VFPU_FAST_BINOP(name, V4OP)					\
+V(name ## _fast)							\
+{									\
+	float *r = cpu->cd.mips.vfpu->vpr.f;				\
+	FAST_FALLBACK(cpu, ic);						\
+	V4_STORE(r + FAST_D(ic), V4OP(V4_LOAD(r + FAST_S(ic)),		\
+	    V4_LOAD(r + FAST_T(ic))));					\
+}
+
+VFPU_FAST_BINOP(vadd, V4_ADD)
+VFPU_FAST_BINOP(vsub, V4_SUB)
+VFPU_FAST_BINOP(vmul, V4_MUL)
+
+V(vmov_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f;
+	FAST_FALLBACK(cpu, ic);
+	V4_STORE(r + FAST_D(ic), V4_LOAD(r + FAST_S(ic)));
+}
+V(vscl_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f;
+	FAST_FALLBACK(cpu, ic);
+	V4_STORE(r + FAST_D(ic), V4_MUL(V4_LOAD(r + FAST_S(ic)),
+	    V4_SET1(r[FAST_T(ic)])));
+}
+V(vdot_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f, p[4];
+	FAST_FALLBACK(cpu, ic);
+	/*  Summed in the same order as the generic handler:  */
+	V4_STORE(p, V4_MUL(V4_LOAD(r + FAST_S(ic)), V4_LOAD(r + FAST_T(ic))));
+	r[FAST_D(ic)] = p[0] + p[1] + p[2] + p[3];
+}
+V(vmmul_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f, *t;
+	int so = FAST_S(ic), to = FAST_T(ic), dout = FAST_D(ic), a;
+	vfpu_v4 s0, s1, s2, s3, d[4];
+
+	FAST_FALLBACK(cpu, ic);
+	s0 = V4_LOAD(r + FAST_COL(so, 0));
+	s1 = V4_LOAD(r + FAST_COL(so, 1));
+	s2 = V4_LOAD(r + FAST_COL(so, 2));
+	s3 = V4_LOAD(r + FAST_COL(so, 3));
+	V4_TRANSPOSE(s0, s1, s2, s3);
+	for (a=0; a<4; a++) {
+		t = r + FAST_COL(to, a);
+		d[a] = V4_ADD(V4_ADD(V4_ADD(V4_MUL(s0, V4_SET1(t[0])),
+		    V4_MUL(s1, V4_SET1(t[1]))), V4_MUL(s2, V4_SET1(t[2]))),
+		    V4_MUL(s3, V4_SET1(t[3])));
+	}
+	/*  Stored last, as vd may overlap vs or vt:  */
+	for (a=0; a<4; a++)
+		V4_STORE(r + FAST_COL(dout, a), d[a]);
+}
+V(vtfm4_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f, *t;
+	int so = FAST_S(ic);
+	vfpu_v4 s0, s1, s2, s3;
+
+	FAST_FALLBACK(cpu, ic);
+	s0 = V4_LOAD(r + FAST_COL(so, 0));
+	s1 = V4_LOAD(r + FAST_COL(so, 1));
+	s2 = V4_LOAD(r + FAST_COL(so, 2));
+	s3 = V4_LOAD(r + FAST_COL(so, 3));
+	V4_TRANSPOSE(s0, s1, s2, s3);
+	t = r + FAST_T(ic);
+	V4_STORE(r + FAST_D(ic), V4_ADD(V4_ADD(V4_ADD(V4_MUL(s0,
+	    V4_SET1(t[0])), V4_MUL(s1, V4_SET1(t[1]))), V4_MUL(s2,
+	    V4_SET1(t[2]))), V4_MUL(s3, V4_SET1(t[3]))));
+}
+V(vmmov_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f;
+	int so = FAST_S(ic), dout = FAST_D(ic), j;
+	vfpu_v4 d[4];
+
+	FAST_FALLBACK(cpu, ic);
+	for (j=0; j<4; j++)
+		d[j] = V4_LOAD(r + FAST_COL(so, j));
+	for (j=0; j<4; j++)
+		V4_STORE(r + FAST_COL(dout, j), d[j]);
+}
+V(vmscl_fast)
+{
+	float *r = cpu->cd.mips.vfpu->vpr.f;
+	int so = FAST_S(ic), dout = FAST_D(ic), j;
+	vfpu_v4 d[4], t;
+
+	FAST_FALLBACK(cpu, ic);
+	t = V4_SET1(r[FAST_T(ic)]);
+	for (j=0; j<4; j++)
+		d[j] = V4_MUL(V4_LOAD(r + FAST_COL(so, j)), t);
+	for (j=0; j<4; j++)
+		V4_STORE(r + FAST_COL(dout, j), d[j]);
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Opcode table, used both for decoding and for disassembly.
+ *
+ *  Operand letters:
+ *
+ *	d s t	vd, vs, vt, of the instruction's vector size
+ *	D S T	vd, vs, vt, single
+ *	h w Q	vd of half, twice, or four times the vector size
+ *	X	vd of the vtfm/vhtfm matrix size
+ *	M N O	vd, vs, vt as matrices of the instruction's size
+ *	Y	vs as a matrix of the vtfm/vhtfm size
+ *	m n	lv.s/sv.s and quad load/store operands
+ *	r	integer register rt
+ *	x y	vfpu register (mfv/mtv) or control register (mfvc/mtvc)
+ *	C q	vfpu control register in bits 8-14 (vmfvc) or 0-6 (vmtvc)
+ *	c	vcmp condition
+ *	i	5-bit immediate (bits 16-20)
+ *	e	CC bit (vcmov)
+ *	k	vcst constant
+ *	I F	viim integer, vfim half float immediate
+ *	p	prefix
+ *	R	vrot pattern
+ *	B b	CC bit (bits 18-20), and the branch target
+ */
+#define	VF_SIZED	1	/*  add .s/.p/.t/.q  */
+#define	VF_MEM		2	/*  may cause an exception  */
+#define	VF_TFM		4	/*  vtfm/vhtfm naming  */
+
+struct vfpu_opcode {
+	uint32_t	match;
+	uint32_t	mask;
+	const char	*name;
+	const char	*args;
+	vfpu_fn		f;
+	int		flags;
+};
+
+static const struct vfpu_opcode vfpu_opcodes[] = {
+	/*  Loads and stores:  */
+	{ 0xc8000000, 0xfc000000, "lv.s",   "m",     vinstr(lv_s),   VF_MEM },
+	{ 0xe8000000, 0xfc000000, "sv.s",   "m",     vinstr(sv_s),   VF_MEM },
+	{ 0xd8000000, 0xfc000002, "lv.q",   "n",     vinstr(lv_q),   VF_MEM },
+	{ 0xf8000000, 0xfc000000, "sv.q",   "n",     vinstr(sv_q),   VF_MEM },
+	{ 0xd4000000, 0xfc000002, "lvl.q",  "n",     vinstr(lvlr_q), VF_MEM },
+	{ 0xd4000002, 0xfc000002, "lvr.q",  "n",     vinstr(lvlr_q), VF_MEM },
+	{ 0xf4000000, 0xfc000002, "svl.q",  "n",     vinstr(svlr_q), VF_MEM },
+	{ 0xf4000002, 0xfc000002, "svr.q",  "n",     vinstr(svlr_q), VF_MEM },
+
+	/*  COP2:  */
+	{ 0x48600080, 0xffe0ff80, "mfvc",   "r,x",   vinstr(mfvc),   0 },
+	{ 0x48600000, 0xffe0ff80, "mfv",    "r,x",   vinstr(mfv),    0 },
+	{ 0x48e00080, 0xffe0ff80, "mtvc",   "r,x",   vinstr(mtvc),   0 },
+	{ 0x48e00000, 0xffe0ff80, "mtv",    "r,x",   vinstr(mtv),    0 },
+	{ 0x49000000, 0xffe30000, "bvf",    "B,b",   NULL,           0 },
+	{ 0x49010000, 0xffe30000, "bvt",    "B,b",   NULL,           0 },
+	{ 0x49020000, 0xffe30000, "bvfl",   "B,b",   NULL,           0 },
+	{ 0x49030000, 0xffe30000, "bvtl",   "B,b",   NULL,           0 },
+
+	/*  VFPU0, VFPU1, VFPU3:  */
+	{ 0x60000000, 0xff800000, "vadd",   "d,s,t", vinstr(vadd),   VF_SIZED },
+	{ 0x60800000, 0xff800000, "vsub",   "d,s,t", vinstr(vsub),   VF_SIZED },
+	{ 0x61000000, 0xff800000, "vsbn",   "d,s,t", vinstr(vsbn),   VF_SIZED },
+	{ 0x63800000, 0xff800000, "vdiv",   "d,s,t", vinstr(vdiv),   VF_SIZED },
+	{ 0x64000000, 0xff800000, "vmul",   "d,s,t", vinstr(vmul),   VF_SIZED },
+	{ 0x64800000, 0xff800000, "vdot",   "D,s,t", vinstr(vdot),   VF_SIZED },
+	{ 0x65000000, 0xff800000, "vscl",   "d,s,T", vinstr(vscl),   VF_SIZED },
+	{ 0x66000000, 0xff800000, "vhdp",   "D,s,t", vinstr(vhdp),   VF_SIZED },
+	{ 0x66800000, 0xff800000, "vcrs",   "d,s,t", vinstr(vcrs),   VF_SIZED },
+	{ 0x67000000, 0xff800000, "vdet",   "D,s,t", vinstr(vdet),   VF_SIZED },
+	{ 0x6c000000, 0xff800000, "vcmp",   "c,s,t", vinstr(vcmp),   VF_SIZED },
+	{ 0x6d000000, 0xff800000, "vmin",   "d,s,t", vinstr(vmin),   VF_SIZED },
+	{ 0x6d800000, 0xff800000, "vmax",   "d,s,t", vinstr(vmax),   VF_SIZED },
+	{ 0x6e800000, 0xff800000, "vscmp",  "d,s,t", vinstr(vscmp),  VF_SIZED },
+	{ 0x6f000000, 0xff800000, "vsge",   "d,s,t", vinstr(vsge),   VF_SIZED },
+	{ 0x6f800000, 0xff800000, "vslt",   "d,s,t", vinstr(vslt),   VF_SIZED },
+
+	/*  VFPU4:  */
+	{ 0xd0000000, 0xffff0000, "vmov",   "d,s",   vinstr(vmov),   VF_SIZED },
+	{ 0xd0010000, 0xffff0000, "vabs",   "d,s",   vinstr(vabs),   VF_SIZED },
+	{ 0xd0020000, 0xffff0000, "vneg",   "d,s",   vinstr(vneg),   VF_SIZED },
+	{ 0xd0030000, 0xffff0000, "vidt",   "d",     vinstr(vidt),   VF_SIZED },
+	{ 0xd0040000, 0xffff0000, "vsat0",  "d,s",   vinstr(vsat0),  VF_SIZED },
+	{ 0xd0050000, 0xffff0000, "vsat1",  "d,s",   vinstr(vsat1),  VF_SIZED },
+	{ 0xd0060000, 0xffff0000, "vzero",  "d",     vinstr(vzero),  VF_SIZED },
+	{ 0xd0070000, 0xffff0000, "vone",   "d",     vinstr(vone),   VF_SIZED },
+	{ 0xd0100000, 0xffff0000, "vrcp",   "d,s",   vinstr(vrcp),   VF_SIZED },
+	{ 0xd0110000, 0xffff0000, "vrsq",   "d,s",   vinstr(vrsq),   VF_SIZED },
+	{ 0xd0120000, 0xffff0000, "vsin",   "d,s",   vinstr(vsin),   VF_SIZED },
+	{ 0xd0130000, 0xffff0000, "vcos",   "d,s",   vinstr(vcos),   VF_SIZED },
+	{ 0xd0140000, 0xffff0000, "vexp2",  "d,s",   vinstr(vexp2),  VF_SIZED },
+	{ 0xd0150000, 0xffff0000, "vlog2",  "d,s",   vinstr(vlog2),  VF_SIZED },
+	{ 0xd0160000, 0xffff0000, "vsqrt",  "d,s",   vinstr(vsqrt),  VF_SIZED },
+	{ 0xd0170000, 0xffff0000, "vasin",  "d,s",   vinstr(vasin),  VF_SIZED },
+	{ 0xd0180000, 0xffff0000, "vnrcp",  "d,s",   vinstr(vnrcp),  VF_SIZED },
+	{ 0xd01a0000, 0xffff0000, "vnsin",  "d,s",   vinstr(vnsin),  VF_SIZED },
+	{ 0xd01c0000, 0xffff0000, "vrexp2", "d,s",   vinstr(vrexp2), VF_SIZED },
+
+	/*  VFPU7:  */
+	{ 0xd0320000, 0xffff0000, "vf2h",   "h,s",   vinstr(vf2h),   VF_SIZED },
+	{ 0xd0330000, 0xffff0000, "vh2f",   "w,s",   vinstr(vh2f),   VF_SIZED },
+	{ 0xd0380000, 0xffff0000, "vuc2i",  "Q,S",   vinstr(vuc2i),  VF_SIZED },
+	{ 0xd0390000, 0xffff0000, "vc2i",   "Q,S",   vinstr(vc2i),   VF_SIZED },
+	{ 0xd03a0000, 0xffff0000, "vus2i",  "w,s",   vinstr(vus2i),  VF_SIZED },
+	{ 0xd03b0000, 0xffff0000, "vs2i",   "w,s",   vinstr(vs2i),   VF_SIZED },
+	{ 0xd03c0000, 0xffff0000, "vi2uc",  "D,s",   vinstr(vi2uc),  VF_SIZED },
+	{ 0xd03d0000, 0xffff0000, "vi2c",   "D,s",   vinstr(vi2c),   VF_SIZED },
+	{ 0xd03e0000, 0xffff0000, "vi2us",  "h,s",   vinstr(vi2us),  VF_SIZED },
+	{ 0xd03f0000, 0xffff0000, "vi2s",   "h,s",   vinstr(vi2s),   VF_SIZED },
+
+	/*  VFPU9:  */
+	{ 0xd0400000, 0xffff0000, "vsrt1",  "d,s",   vinstr(vsrt1),  VF_SIZED },
+	{ 0xd0410000, 0xffff0000, "vsrt2",  "d,s",   vinstr(vsrt2),  VF_SIZED },
+	{ 0xd0420000, 0xffff0000, "vbfy1",  "d,s",   vinstr(vbfy1),  VF_SIZED },
+	{ 0xd0430000, 0xffff0000, "vbfy2",  "d,s",   vinstr(vbfy2),  VF_SIZED },
+	{ 0xd0440000, 0xffff0000, "vocp",   "d,s",   vinstr(vocp),   VF_SIZED },
+	{ 0xd0460000, 0xffff0000, "vfad",   "D,s",   vinstr(vfad),   VF_SIZED },
+	{ 0xd0470000, 0xffff0000, "vavg",   "D,s",   vinstr(vavg),   VF_SIZED },
+	{ 0xd0480000, 0xffff0000, "vsrt3",  "d,s",   vinstr(vsrt3),  VF_SIZED },
+	{ 0xd0490000, 0xffff0000, "vsrt4",  "d,s",   vinstr(vsrt4),  VF_SIZED },
+	{ 0xd04a0000, 0xffff0000, "vsgn",   "d,s",   vinstr(vsgn),   VF_SIZED },
+	{ 0xd0500000, 0xffff0000, "vmfvc",  "D,C",   vinstr(vmfvc),  0 },
+	{ 0xd0510000, 0xffff0000, "vmtvc",  "q,S",   vinstr(vmtvc),  0 },
+
+	{ 0xd0600000, 0xffe00000, "vcst",   "d,k",   vinstr(vcst),   VF_SIZED },
+	{ 0xd2000000, 0xffe00000, "vf2in",  "d,s,i", vinstr(vf2i),   VF_SIZED },
+	{ 0xd2200000, 0xffe00000, "vf2iz",  "d,s,i", vinstr(vf2i),   VF_SIZED },
+	{ 0xd2400000, 0xffe00000, "vf2iu",  "d,s,i", vinstr(vf2i),   VF_SIZED },
+	{ 0xd2600000, 0xffe00000, "vf2id",  "d,s,i", vinstr(vf2i),   VF_SIZED },
+	{ 0xd2800000, 0xffe00000, "vi2f",   "d,s,i", vinstr(vi2f),   VF_SIZED },
+	{ 0xd2a00000, 0xfff80000, "vcmovt", "d,s,e", vinstr(vcmov),  VF_SIZED },
+	{ 0xd2a80000, 0xfff80000, "vcmovf", "d,s,e", vinstr(vcmov),  VF_SIZED },
+
+	/*  VFPU5:  */
+	{ 0xdc000000, 0xff000000, "vpfxs",  "p",     vinstr(vpfxs),  0 },
+	{ 0xdd000000, 0xff000000, "vpfxt",  "p",     vinstr(vpfxt),  0 },
+	{ 0xde000000, 0xff000000, "vpfxd",  "p",     vinstr(vpfxd),  0 },
+	{ 0xdf000000, 0xff800000, "viim.s", "T,I",   vinstr(viim),   0 },
+	{ 0xdf800000, 0xff800000, "vfim.s", "T,F",   vinstr(vfim),   0 },
+
+	/*  VFPU6:  */
+	{ 0xf0000000, 0xff800000, "vmmul",  "M,N,O", vinstr(vmmul),  VF_SIZED },
+	{ 0xf0800000, 0xff800000, "tfm2",   "X,Y,t", vinstr(vtfm),   VF_TFM },
+	{ 0xf1000000, 0xff800000, "tfm3",   "X,Y,t", vinstr(vtfm),   VF_TFM },
+	{ 0xf1800000, 0xff800000, "tfm4",   "X,Y,t", vinstr(vtfm),   VF_TFM },
+	{ 0xf2000000, 0xff800000, "vmscl",  "M,N,T", vinstr(vmscl),  VF_SIZED },
+	{ 0xf2808000, 0xff808080, "vcrsp",  "d,s,t", vinstr(vcrsp),  VF_SIZED },
+	{ 0xf2808080, 0xff808080, "vqmul",  "d,s,t", vinstr(vqmul),  VF_SIZED },
+	{ 0xf3800000, 0xffff0000, "vmmov",  "M,N",   vinstr(vmmov),  VF_SIZED },
+	{ 0xf3830000, 0xffff0000, "vmidt",  "M",     vinstr(vmidt),  VF_SIZED },
+	{ 0xf3860000, 0xffff0000, "vmzero", "M",     vinstr(vmzero), VF_SIZED },
+	{ 0xf3870000, 0xffff0000, "vmone",  "M",     vinstr(vmone),  VF_SIZED },
+	{ 0xf3a00000, 0xffe00000, "vrot",   "d,S,R", vinstr(vrot),   VF_SIZED },
+
+	/*  VFPU special:  */
+	{ 0xffff0000, 0xffffffff, "vnop",   "",      vinstr(vnop),   0 },
+	{ 0xffff0320, 0xffffffff, "vsync",  "",      vinstr(vnop),   0 },
+	{ 0xffff040d, 0xffffffff, "vflush", "",      vinstr(vnop),   0 },
+	{ 0xffff0000, 0xffff0000, "vsync",  "i",     vinstr(vnop),   0 },
+
+	{ 0, 0, NULL, NULL, NULL, 0 }
+};
+
+
+static const struct vfpu_opcode *vfpu_lookup(uint32_t iword)
+{
+	const struct vfpu_opcode *o;
+
+	for (o = vfpu_opcodes; o->name != NULL; o++)
+		if ((iword & o->mask) == o->match)
+			return o;
+	return NULL;
+}
+
+
+/*
+ *  vfpu_specialize():
+ *
+ *  Pick a handler which works on the register file directly, if the
+ *  instruction is a quad or 4x4 instruction with whole columns as operands.
+ */
+static void vfpu_specialize(struct mips_instr_call *ic)
+{
+	uint32_t op = ic->arg[0];
+	int vd = VFPU_VD(op), vs = VFPU_VS(op), vt = VFPU_VT(op);
+	vfpu_fn f = NULL;
+
+#define	COLUMN(r)	(!((r) & 0x60))		/*  C<m><c>0  */
+#define	PACK(d,s,t)	((d) | ((s) << 8) | ((t) << 16))
+
+	if (VFPU_N(op) != 4)
+		return;
+
+	if (ic->f == vinstr(vadd)) f = vinstr(vadd_fast);
+	if (ic->f == vinstr(vsub)) f = vinstr(vsub_fast);
+	if (ic->f == vinstr(vmul)) f = vinstr(vmul_fast);
+	if (ic->f == vinstr(vmov)) f = vinstr(vmov_fast);
+	if (ic->f == vinstr(vdot)) f = vinstr(vdot_fast);
+	if (ic->f == vinstr(vscl)) f = vinstr(vscl_fast);
+
+	if (f != NULL) {
+		int single_t = f == vinstr(vscl_fast);
+		int single_d = f == vinstr(vdot_fast);
+		if ((!single_d && !COLUMN(vd)) || !COLUMN(vs) ||
+		    (!single_t && f != vinstr(vmov_fast) && !COLUMN(vt)))
+			return;
+		ic->f = f;
+		ic->arg[2] = PACK(single_d? vfpu_vec_ofs[1][vd][0] :
+		    vfpu_vec_ofs[4][vd][0], vfpu_vec_ofs[4][vs][0],
+		    single_t? vfpu_vec_ofs[1][vt][0] : vfpu_vec_ofs[4][vt][0]);
+		return;
+	}
+
+	/*  Matrices: M<m><c>0, column j at (c+j)&3.  */
+	if (ic->f == vinstr(vmmul)) f = vinstr(vmmul_fast);
+	if (ic->f == vinstr(vmmov)) f = vinstr(vmmov_fast);
+	if (ic->f == vinstr(vmscl)) f = vinstr(vmscl_fast);
+	if (ic->f == vinstr(vtfm) && ((op >> 23) & 7) == 3)
+		f = vinstr(vtfm4_fast);
+	if (f == NULL)
+		return;
+
+	if (!COLUMN(vs))
+		return;
+	if (f == vinstr(vtfm4_fast)) {
+		if (!COLUMN(vd) || !COLUMN(vt))
+			return;
+		ic->arg[2] = PACK(vfpu_vec_ofs[4][vd][0],
+		    vfpu_mtx_ofs[4][vs][0], vfpu_vec_ofs[4][vt][0]);
+	} else {
+		if (!COLUMN(vd))
+			return;
+		if (f == vinstr(vmmul_fast) && !COLUMN(vt))
+			return;
+		ic->arg[2] = PACK(vfpu_mtx_ofs[4][vd][0],
+		    vfpu_mtx_ofs[4][vs][0], f == vinstr(vmscl_fast)?
+		    vfpu_vec_ofs[1][vt][0] : vfpu_mtx_ofs[4][vt][0]);
+	}
+	ic->f = f;
+
+#undef COLUMN
+#undef PACK
+}
+
+
+/*
+ *  mips_vfpu_translate():
+ *
+ *  Decode a VFPU instruction into ic. Returns 0 if the instruction is not
+ *  a VFPU instruction (or is a branch, which the cores handle themselves),
+ *  otherwise MIPS_VFPU_TRANSLATED, with MIPS_VFPU_NEEDS_PC or'ed in for
+ *  instructions which may cause exceptions.
+ */
+int mips_vfpu_translate(struct cpu *cpu, uint32_t iword,
+	struct mips_instr_call *ic)
+{
+	const struct vfpu_opcode *o = vfpu_lookup(iword);
+
+	if (o == NULL || o->f == NULL)
+		return 0;
+
+	ic->f = o->f;
+	ic->arg[0] = iword;
+	ic->arg[1] = (size_t)o->f;
+	ic->arg[2] = 0;
+	vfpu_specialize(ic);
+
+	return MIPS_VFPU_TRANSLATED | (o->flags & VF_MEM? MIPS_VFPU_NEEDS_PC:0);
+}
+
+
+/*
+ *  mips_vfpu_run_instr():
+ *
+ *  Execute one VFPU instruction, for the old interpreter. Decoded
+ *  instructions are kept in a direct mapped cache, keyed on the instruction
+ *  word. Returns 0 if the instruction is not known.
+ */
+int mips_vfpu_run_instr(struct cpu *cpu, uint32_t iword)
+{
+	struct mips_vfpu_icache *e =
+	    &cpu->cd.mips.vfpu->icache[MIPS_VFPU_ICACHE_HASH(iword)];
+
+	if (e->iword != iword || e->ic.f == NULL) {
+		if (!mips_vfpu_translate(cpu, iword, &e->ic)) {
+			e->ic.f = NULL;
+			return 0;
+		}
+		e->iword = iword;
+	}
+
+	e->ic.f(cpu, &e->ic);
+	return 1;
+}
+
+
+/*****************************************************************************/
+
+
+static const char vfpu_size_suffix[5] = { '?', 's', 'p', 't', 'q' };
+
+
+static void vfpu_print_vreg(int reg, int n)
+{
+	int mtx = (reg >> 2) & 7, col = reg & 3, row, tr = (reg >> 5) & 1;
+
+	switch (n) {
+	case 1:	debug("S%i%i%i", mtx, col, (reg >> 5) & 3);
+		return;
+	case 3:	row = (reg >> 6) & 1; break;
+	default:row = (reg >> 5) & 2;
+	}
+	if (tr)
+		debug("R%i%i%i", mtx, col, row);
+	else
+		debug("C%i%i%i", mtx, col, row);
+}
+
+
+static void vfpu_print_mreg(int reg, int n)
+{
+	int mtx = (reg >> 2) & 7, col = reg & 3, row, tr = (reg >> 5) & 1;
+
+	row = n == 3? (reg >> 6) & 1 : (reg >> 5) & 2;
+	if (tr)
+		debug("E%i%i%i", mtx, row, col);
+	else
+		debug("M%i%i%i", mtx, col, row);
+}
+
+
+static void vfpu_print_prefix(uint32_t pfx, int dst)
+{
+	static const char *lanes = "xyzw";
+	int i;
+
+	debug("[");
+	for (i=0; i<4; i++) {
+		if (i)
+			debug(",");
+		if (dst) {
+			if ((pfx >> (8+i)) & 1)
+				debug("m");
+			else
+				debug("%s", ((pfx >> (i*2)) & 3) == 1? "0:1" :
+				    ((pfx >> (i*2)) & 3) == 3? "-1:1" : "");
+			continue;
+		}
+		if ((pfx >> (16+i)) & 1)
+			debug("-");
+		if ((pfx >> (12+i)) & 1)
+			debug("%s", vfpu_prefix_const_names[((pfx >> (i*2)) & 3)
+			    + ((pfx >> (8+i)) & 1) * 4]);
+		else if ((pfx >> (8+i)) & 1)
+			debug("|%c|", lanes[(pfx >> (i*2)) & 3]);
+		else
+			debug("%c", lanes[(pfx >> (i*2)) & 3]);
+	}
+	debug("]");
+}
+
+
+/*
+ *  mips_vfpu_disassemble_instr():
+ *
+ *  Disassemble a VFPU instruction (without the address and instruction
+ *  word, which mips_cpu_disassemble_instr() has already printed). Returns 0
+ *  if iword is not a VFPU instruction.
+ */
+int mips_vfpu_disassemble_instr(struct cpu *cpu, uint32_t iword,
+	uint64_t dumpaddr, int running)
+{
+	const struct vfpu_opcode *o = vfpu_lookup(iword);
+	int n = VFPU_N(iword), m = ((iword >> 23) & 7) + 1;
+	int rt = (iword >> 16) & 31;
+	const char *p;
+
+	if (o == NULL)
+		return 0;
+
+	if (!vfpu_tables_initialized)
+		vfpu_init_tables();
+
+	if (o->flags & VF_TFM)
+		debug("%s%s.%c", n < m? "vh" : "v", o->name,
+		    vfpu_size_suffix[m]);
+	else if (o->flags & VF_SIZED)
+		debug("%s.%c", o->name, vfpu_size_suffix[n]);
+	else
+		debug("%s", o->name);
+	if (o->args[0])
+		debug("\t");
+
+	for (p = o->args; *p; p++) {
+		switch (*p) {
+		case 'd': vfpu_print_vreg(VFPU_VD(iword), n); break;
+		case 's': vfpu_print_vreg(VFPU_VS(iword), n); break;
+		case 't': vfpu_print_vreg(VFPU_VT(iword), n); break;
+		case 'D': vfpu_print_vreg(VFPU_VD(iword), 1); break;
+		case 'S': vfpu_print_vreg(VFPU_VS(iword), 1); break;
+		case 'T': vfpu_print_vreg(VFPU_VT(iword), 1); break;
+		case 'h': vfpu_print_vreg(VFPU_VD(iword), n > 1? n/2 : 1);
+			break;
+		case 'w': vfpu_print_vreg(VFPU_VD(iword), n < 2? n*2 : 4);
+			break;
+		case 'Q': vfpu_print_vreg(VFPU_VD(iword), 4); break;
+		case 'X': vfpu_print_vreg(VFPU_VD(iword), m); break;
+		case 'M': vfpu_print_mreg(VFPU_VD(iword), n); break;
+		case 'N': vfpu_print_mreg(VFPU_VS(iword), n); break;
+		case 'O': vfpu_print_mreg(VFPU_VT(iword), n); break;
+		case 'Y': vfpu_print_mreg(VFPU_VS(iword), m); break;
+		case 'm':
+		case 'n':
+			vfpu_print_vreg(((iword >> 16) & 0x1f) | (*p == 'm'?
+			    (iword & 3) << 5 : (iword & 1) << 5),
+			    *p == 'm'? 1 : 4);
+			debug(",%i(%s)", (int16_t)(iword & 0xfffc),
+			    regnames[(iword >> 21) & 31]);
+			if (running)
+				debug("\t\t[0x%08x]", (int)(uint32_t)
+				    (cpu->cd.mips.gpr[(iword >> 21) & 31] +
+				    (int16_t)(iword & 0xfffc)));
+			break;
+		case 'r': debug("%s", regnames[rt]); break;
+		case 'x': if (iword & 0x80)
+				debug("%s", vfpu_ctrl_names[iword & 15]);
+			  else
+				vfpu_print_vreg(iword & 0x7f, 1);
+			  break;
+		case 'C': debug("%s", vfpu_ctrl_names[(iword >> 8) & 15]);
+			  break;
+		case 'q': debug("%s", vfpu_ctrl_names[iword & 15]); break;
+		case 'c': debug("%s", vfpu_cond_names[iword & 15]); break;
+		case 'i': debug("%i", (int)((iword >> 16) & 0x1f)); break;
+		case 'e': debug("%i", (int)((iword >> 16) & 7)); break;
+		case 'k': debug("%s", vfpu_cst_names[(iword >> 16) & 0x1f]);
+			  break;
+		case 'I': debug("%i", (int)(int16_t)iword); break;
+		case 'F': debug("%f", (double)vfpu_half_to_float(iword
+			      & 0xffff));
+			  break;
+		case 'p': vfpu_print_prefix(iword & 0xfffff,
+			      (iword >> 24) == 0xde);
+			  break;
+		case 'R': {
+			static const char *l = "csn0";
+			int i, imm = (iword >> 16) & 0x1f;
+			int si = (imm >> 2) & 3, ci = imm & 3;
+			debug("[");
+			for (i=0; i<n; i++) {
+				char c = l[3];
+				if (i == ci)
+					c = l[0];
+				else if (i == si || si == ci)
+					c = l[1];
+				debug("%s%s%c", i? "," : "",
+				    c == 's' && (imm & 0x10)? "-" : "", c);
+			}
+			debug("]");
+			break;
+			}
+		case 'B': debug("%i", (int)((iword >> 18) & 7)); break;
+		case 'b': {
+			uint64_t addr = dumpaddr + 4 + ((int16_t)iword << 2);
+			uint64_t offset;
+			char *symbol;
+			if (cpu->is_32bit)
+				debug("0x%08x", (int)addr);
+			else
+				debug("0x%016llx", (long long)addr);
+			symbol = get_symbol_name(&cpu->machine->symbol_context,
+			    addr, &offset);
+			if (symbol != NULL && offset == 0)
+				debug("\t<%s>", symbol);
+			break;
+			}
+		default:debug("%c", *p);
+		}
+	}
+
+	debug("\n");
+	return 1;
+}
+
+
+/*
+ *  mips_vfpu_register_dump():
+ *
+ *  Dump the 8 matrices, with one row per line, and the control registers.
+ */
+void mips_vfpu_register_dump(struct cpu *cpu)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	int mtx, row, col, i;
+
+	if (v == NULL)
+		return;
+
+	for (mtx=0; mtx<8; mtx++)
+		for (row=0; row<4; row++) {
+			debug("cpu%i: %s", cpu->cpu_id, row? "    " : "");
+			if (!row)
+				debug("M%i00", mtx);
+			for (col=0; col<4; col++)
+				debug(" %14g", (double)v->vpr.f[VFPU_OFS(mtx,
+				    col, row)]);
+			debug("\n");
+		}
+
+	for (i=0; i<MIPS_VFPU_N_CTRL; i++) {
+		if ((i & 3) == 0)
+			debug("cpu%i:", cpu->cpu_id);
+		debug(" %5s = 0x%08x", vfpu_ctrl_names[i], (int)v->ctrl[i]);
+		if ((i & 3) == 3)
+			debug("\n");
+	}
+}
+
+
+/*
+ *  mips_vfpu_reset():
+ *
+ *  Set the VFPU to its power on state, and forget all decoded instructions.
+ */
+void mips_vfpu_reset(struct mips_vfpu *v)
+{
+	int i;
+
+	memset(v, 0, sizeof(struct mips_vfpu));
+	v->ctrl[VFPU_CTRL_SPREFIX] = 0xe4;
+	v->ctrl[VFPU_CTRL_TPREFIX] = 0xe4;
+	v->ctrl[VFPU_CTRL_INF4] = 0;
+	v->ctrl[VFPU_CTRL_REV] = 0x7772ceab;
+	for (i=0; i<8; i++)
+		v->ctrl[VFPU_CTRL_RCX0 + i] = 0x3f800000 | (i < 4? 1 << i : 0);
+}
+
+
+/*
+ *  mips_vfpu_new():
+ */
+struct mips_vfpu *mips_vfpu_new(struct cpu *cpu)
+{
+	struct mips_vfpu *v = malloc(sizeof(struct mips_vfpu));
+
+	if (v == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	if (!vfpu_tables_initialized)
+		vfpu_init_tables();
+
+	mips_vfpu_reset(v);
+	return v;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Conformance tests. Each test starts with vpr[i] = i+1 in matrices 0..3
+ *  and zeros in 4..7, default prefixes and CC = 0, runs the instructions,
+ *  and checks one register (or CC).
+ */
+#define	T_SZ(n)		(((((n)-1) & 1) << 7) | ((((n)-1) >> 1) << 15))
+#define	T_OP3(op,n,d,s,t) ((op) | T_SZ(n) | ((t) << 16) | ((s) << 8) | (d))
+#define	T_C(m,c)	(((m) << 2) | (c))		/*  C<m><c>0  */
+#define	T_R(m,r)	(((m) << 2) | (r) | 0x20)	/*  R<m><r>0  */
+#define	T_S(m,c,r)	(((m) << 2) | (c) | ((r) << 5))	/*  S<m><c><r>  */
+
+#define	CHK_FLOAT	0
+#define	CHK_APPROX	1
+#define	CHK_INT		2
+#define	CHK_CC		3
+
+#define	T_SCRATCH	0x88000000ULL	/*  16-byte aligned, in RAM  */
+
+struct vfpu_test {
+	const char	*name;
+	uint32_t	iword[5];	/*  zero terminated  */
+	int		kind;
+	int		n;		/*  size of the checked register  */
+	int		reg;
+	double		expect[4];
+};
+
+static const struct vfpu_test vfpu_tests[] = {
+	{ "vadd.q", { T_OP3(0x60000000, 4, T_C(4,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 6, 8, 10, 12 } },
+	{ "vadd.q rows", { T_OP3(0x60000000, 4, T_R(4,0), T_R(0,0),
+	    T_R(0,1)) }, CHK_FLOAT, 4, T_R(4,0), { 3, 11, 19, 27 } },
+	{ "vsub.t", { T_OP3(0x60800000, 3, T_C(4,0), T_C(0,1), T_C(0,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 4, 4, 4, 0 } },
+	{ "vmul.p", { T_OP3(0x64000000, 2, T_C(4,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 2, T_C(4,0), { 5, 12 } },
+	{ "vdiv.q", { T_OP3(0x63800000, 4, T_C(4,0), T_C(0,1), T_C(0,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 5, 3, 7.0f/3.0f, 2 } },
+	{ "vdot.q", { T_OP3(0x64800000, 4, T_S(4,0,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 70 } },
+	{ "vdot.q rows", { T_OP3(0x64800000, 4, T_S(4,0,0), T_R(0,0),
+	    T_R(0,1)) }, CHK_FLOAT, 1, T_S(4,0,0), { 2+30+90+182 } },
+	{ "vhdp.q", { T_OP3(0x66000000, 4, T_S(4,0,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 46 } },
+	{ "vscl.q", { T_OP3(0x65000000, 4, T_C(4,0), T_C(0,0), T_S(0,1,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 5, 10, 15, 20 } },
+	{ "vcrs.t", { T_OP3(0x66800000, 3, T_C(4,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 3, T_C(4,0), { 14, 15, 6 } },
+	{ "vcrsp.t", { T_OP3(0xf2800000, 3, T_C(4,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 3, T_C(4,0), { -4, 8, -4 } },
+	{ "vdet.p", { T_OP3(0x67000000, 2, T_S(4,0,0), T_C(0,0), T_C(0,1)) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 1*6 - 2*5 } },
+	{ "vmin.q", { T_OP3(0x6d000000, 4, T_C(4,0), T_C(0,1), T_R(0,1)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 2, 6, 7, 8 } },
+	{ "vmax.q", { T_OP3(0x6d800000, 4, T_C(4,0), T_C(0,1), T_R(0,1)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 5, 6, 10, 14 } },
+	{ "vneg.q", { 0xd0020000 | T_SZ(4) | (T_C(0,0) << 8) | T_C(4,0) },
+	    CHK_FLOAT, 4, T_C(4,0), { -1, -2, -3, -4 } },
+	{ "vidt.q", { 0xd0030000 | T_SZ(4) | T_C(4,1) },
+	    CHK_FLOAT, 4, T_C(4,1), { 0, 1, 0, 0 } },
+	{ "vfad.q", { 0xd0460000 | T_SZ(4) | (T_C(0,0) << 8) | T_S(4,0,0) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 10 } },
+	{ "vavg.q", { 0xd0470000 | T_SZ(4) | (T_C(0,0) << 8) | T_S(4,0,0) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 2.5 } },
+	{ "vrcp.s", { 0xd0100000 | (T_S(0,1,0) << 8) | T_S(4,0,0) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 1.0f/5.0f } },
+	{ "vsqrt.s", { 0xd0160000 | (T_S(0,3,3) << 8) | T_S(4,0,0) },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 4 } },
+	{ "vsin.s", { 0xd0120000 | (T_S(0,0,0) << 8) | T_S(4,0,0) },
+	    CHK_APPROX, 1, T_S(4,0,0), { 1 } },
+	{ "vcos.s", { 0xd0130000 | (T_S(0,0,0) << 8) | T_S(4,0,0) },
+	    CHK_APPROX, 1, T_S(4,0,0), { 0 } },
+	{ "vexp2.s", { 0xd0140000 | (T_S(0,0,0) << 8) | T_S(4,0,0) },
+	    CHK_APPROX, 1, T_S(4,0,0), { 2 } },
+	{ "vlog2.s", { 0xd0150000 | (T_S(0,1,3) << 8) | T_S(4,0,0) },
+	    CHK_APPROX, 1, T_S(4,0,0), { 3 } },
+	{ "vcst.s", { 0xd0600000 | (9 << 16) | T_S(4,0,0) },
+	    CHK_APPROX, 1, T_S(4,0,0), { 3.14159265358979 } },
+	{ "vf2iz.q", { 0xd2200000 | (1 << 16) | T_SZ(4) | (T_C(0,0) << 8)
+	    | T_C(4,0) }, CHK_INT, 4, T_C(4,0), { 2, 4, 6, 8 } },
+	{ "vf2in/vi2f", { 0xd2000000 | (3 << 16) | T_SZ(4) | (T_C(0,0) << 8)
+	    | T_C(4,0), 0xd2800000 | (3 << 16) | T_SZ(4) | (T_C(4,0) << 8)
+	    | T_C(4,1) }, CHK_FLOAT, 4, T_C(4,1), { 1, 2, 3, 4 } },
+	{ "viim.s", { 0xdf000000 | (T_S(4,0,0) << 16) | 0xfffd },
+	    CHK_FLOAT, 1, T_S(4,0,0), { -3 } },
+	{ "vfim.s", { 0xdf800000 | (T_S(4,0,0) << 16) | 0x3e00 },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 1.5 } },
+	{ "vcmp.q lt", { T_OP3(0x6c000000 | 2, 4, 0, T_C(0,0), T_C(0,1)) },
+	    CHK_CC, 0, 0, { 0x3f } },
+	{ "vcmp.q eq", { T_OP3(0x6c000000 | 1, 4, 0, T_C(0,0), T_R(0,0)) },
+	    CHK_CC, 0, 0, { 0x11 } },
+	{ "vcmovt.q", { T_OP3(0x6c000000 | 1, 4, 0, T_C(0,0), T_R(0,0)),
+	    0xd2a00000 | (6 << 16) | T_SZ(4) | (T_C(0,1) << 8) | T_C(0,0) },
+	    CHK_FLOAT, 4, T_C(0,0), { 5, 2, 3, 4 } },
+	{ "vpfxs swizzle", { 0xdc000000 | 0x1b,
+	    0xd0000000 | T_SZ(4) | (T_C(0,0) << 8) | T_C(4,0) },
+	    CHK_FLOAT, 4, T_C(4,0), { 4, 3, 2, 1 } },
+	{ "vpfxs consumed", { 0xdc000000 | 0x1b,
+	    0xd0000000 | T_SZ(4) | (T_C(0,0) << 8) | T_C(4,0),
+	    0xd0000000 | T_SZ(4) | (T_C(0,0) << 8) | T_C(4,1) },
+	    CHK_FLOAT, 4, T_C(4,1), { 1, 2, 3, 4 } },
+	{ "vpfxs neg/cst/abs", { 0xdc000000 | 0x248f4,
+	    0xd0000000 | T_SZ(4) | (T_C(0,0) << 8) | T_C(4,0) },
+	    CHK_FLOAT, 4, T_C(4,0), { 1, -2, 0.5, 4 } },
+	{ "vpfxd sat/mask", { 0xde000000 | 0x2c1,
+	    0xd0000000 | T_SZ(4) | (T_C(0,1) << 8) | T_C(4,0) },
+	    CHK_FLOAT, 4, T_C(4,0), { 1, 0, 7, 1 } },
+	{ "vmidt/vmmul.q", { 0xf3830000 | T_SZ(4) | T_C(5,0),
+	    T_OP3(0xf0000000, 4, T_C(4,0), T_C(0,0), T_C(5,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 1, 5, 9, 13 } },
+	{ "vmmul.q E", { 0xf3830000 | T_SZ(4) | T_C(5,0),
+	    T_OP3(0xf0000000, 4, T_C(4,0), T_R(0,0), T_C(5,0)) },
+	    CHK_FLOAT, 4, T_C(4,2), { 9, 10, 11, 12 } },
+	{ "vmmul.q", { T_OP3(0xf0000000, 4, T_C(4,0), T_C(0,0), T_C(1,0)) },
+	    CHK_FLOAT, 4, T_C(4,1), { 230, 590, 950, 1310 } },
+	{ "vtfm4.q", { T_OP3(0xf1800000, 4, T_C(4,0), T_C(0,0), T_C(1,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 190, 486, 782, 1078 } },
+	{ "vtfm4.q rows", { T_OP3(0xf1800000, 4, T_C(4,0), T_R(0,0),
+	    T_C(1,0)) }, CHK_FLOAT, 4, T_C(4,0),
+	    { 538, 612, 686, 760 } },
+	{ "vhtfm4.q", { T_OP3(0xf1800000, 3, T_C(4,0), T_C(0,0), T_C(1,0)) },
+	    CHK_FLOAT, 4, T_C(4,0), { 114, 334, 554, 774 } },
+	{ "vmscl.q", { T_OP3(0xf2000000, 4, T_C(4,0), T_C(0,0), T_S(0,1,0)) },
+	    CHK_FLOAT, 4, T_C(4,3), { 65, 70, 75, 80 } },
+	{ "vrot.q", { 0xf3a00000 | (4 << 16) | T_SZ(4) | (T_S(0,0,0) << 8)
+	    | T_C(4,0) }, CHK_APPROX, 4, T_C(4,0), { 0, 1, 0, 0 } },
+	{ "vi2uc.q", { 0xd03c0000 | T_SZ(4) | (T_C(0,0) << 8) | T_S(4,0,0) },
+	    CHK_INT, 1, T_S(4,0,0), { (double)(int32_t)0x8180807f } },
+	{ "mtv/mfv", { 0x48e00000 | (MIPS_GPR_A0 << 16) | T_S(4,2,1),
+	    0x48600000 | (MIPS_GPR_T0 << 16) | T_S(4,2,1),
+	    0x48e00000 | (MIPS_GPR_T0 << 16) | T_S(4,0,0) },
+	    CHK_INT, 1, T_S(4,0,0), { (double)(int32_t)T_SCRATCH } },
+	{ "sv.q/lv.q", { 0xf8000000 | (MIPS_GPR_A0 << 21) | (T_C(0,1) << 16)
+	    | 16, 0xd8000000 | (MIPS_GPR_A0 << 21) | (T_C(4,0) << 16) | 16 },
+	    CHK_FLOAT, 4, T_C(4,0), { 5, 6, 7, 8 } },
+	{ "sv.s/lv.s", { 0xe8000000 | (MIPS_GPR_A0 << 21) | (2 << 16) | 3
+	    | 8, 0xc8000000 | (MIPS_GPR_A0 << 21) | (16 << 16) | 8 },
+	    CHK_FLOAT, 1, T_S(4,0,0), { 12 } },
+	{ "ulv.q", { 0xf8000000 | (MIPS_GPR_A0 << 21) | (T_C(0,0) << 16),
+	    0xf8000000 | (MIPS_GPR_A0 << 21) | (T_C(0,1) << 16) | 16,
+	    0xd4000000 | (MIPS_GPR_A0 << 21) | (T_C(4,0) << 16) | 16,
+	    0xd4000002 | (MIPS_GPR_A0 << 21) | (T_C(4,0) << 16) | 4 },
+	    CHK_FLOAT, 4, T_C(4,0), { 2, 3, 4, 5 } },
+	{ NULL }
+};
+
+
+static int vfpu_run_test(struct cpu *cpu, const struct vfpu_test *t)
+{
+	struct mips_vfpu *v = cpu->cd.mips.vfpu;
+	struct mips_instr_call ic;
+	float got[4];
+	int i, ok = 1;
+
+	mips_vfpu_reset(v);
+	for (i=0; i<64; i++)
+		v->vpr.f[i] = (float)(i + 1);
+	cpu->cd.mips.gpr[MIPS_GPR_A0] = (int32_t)T_SCRATCH;
+
+	for (i=0; i<5 && t->iword[i] != 0; i++) {
+		if (!mips_vfpu_translate(cpu, t->iword[i], &ic)) {
+			debug("  %-20s not decoded: %08x\n", t->name,
+			    (int)t->iword[i]);
+			return 0;
+		}
+		ic.f(cpu, &ic);
+	}
+
+	if (t->kind == CHK_CC) {
+		ok = (v->ctrl[VFPU_CTRL_CC] & 0x3f) == (uint32_t)t->expect[0];
+		if (!ok)
+			debug("  %-20s CC = 0x%02x, expected 0x%02x\n", t->name,
+			    (int)v->ctrl[VFPU_CTRL_CC], (int)t->expect[0]);
+		return ok;
+	}
+
+	vfpu_read_raw(v, got, t->n, t->reg);
+	for (i=0; i<t->n; i++) {
+		switch (t->kind) {
+		case CHK_INT:
+			if ((int32_t)vfpu_f2u(got[i]) != (int32_t)t->expect[i])
+				ok = 0;
+			break;
+		case CHK_APPROX:
+			if (fabs(got[i] - t->expect[i]) > 1e-5)
+				ok = 0;
+			break;
+		default:if (got[i] != (float)t->expect[i])
+				ok = 0;
+		}
+	}
+
+	if (!ok) {
+		debug("  %-20s got", t->name);
+		for (i=0; i<t->n; i++)
+			debug(" %g", (double)got[i]);
+		debug(", expected");
+		for (i=0; i<t->n; i++)
+			debug(" %g", t->expect[i]);
+		debug("\n");
+	}
+	return ok;
+}
+
+
+/*
+ *  mips_vfpu_selftest():
+ *
+ *  Run the conformance tests on cpu's VFPU. The VFPU state, the integer
+ *  registers, and the scratch memory are restored afterwards. Returns the number of failed
+ *  tests.
+ */
+int mips_vfpu_selftest(struct cpu *cpu)
+{
+	struct mips_vfpu *saved;
+	unsigned char mem[32];
+	uint64_t gpr[N_MIPS_GPRS];
+	int i, failed = 0;
+
+	if (cpu->cd.mips.vfpu == NULL) {
+		debug("cpu%i has no VFPU\n", cpu->cpu_id);
+		return 0;
+	}
+
+	memcpy(gpr, cpu->cd.mips.gpr, sizeof(gpr));
+	saved = mips_vfpu_new(cpu);
+	memcpy(saved, cpu->cd.mips.vfpu, sizeof(struct mips_vfpu));
+	cpu->memory_rw(cpu, cpu->mem, T_SCRATCH, mem, sizeof(mem), MEM_READ,
+	    CACHE_DATA | NO_EXCEPTIONS);
+
+	for (i=0; vfpu_tests[i].name != NULL; i++)
+		if (!vfpu_run_test(cpu, &vfpu_tests[i]))
+			failed ++;
+
+	cpu->memory_rw(cpu, cpu->mem, T_SCRATCH, mem, sizeof(mem), MEM_WRITE,
+	    CACHE_DATA | NO_EXCEPTIONS);
+	memcpy(cpu->cd.mips.vfpu, saved, sizeof(struct mips_vfpu));
+	free(saved);
+	memcpy(cpu->cd.mips.gpr, gpr, sizeof(gpr));
+
+	debug("vfpu: %i tests, %i failed\n", i, failed);
+	return failed;
+}
+
+
+#endif	/*  ENABLE_MIPS  */
@@ -36,9 +36,16 @@
  *        lot simpler.
  */
 
+#include <time.h>
+
 #include "console.h"
 #include "debugger.h"
 
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 
 static int instrs_per_cycle(struct cpu *cpu) {
 #ifdef CPU_RUN_MIPS
@@ -49,6 +56,91 @@ static int instrs_per_cycle(struct cpu *cpu) {
 }
 
 
+#ifdef HAVE_PTHREADS
+/*  Nr of instructions between calls to the machine's cpu_sync_func:  */
+#define	CPU_THREAD_CHUNK	16384
+
+struct cpu_thread_args {
+	struct emul	*emul;
+	struct cpu	*cpu;
+};
+
+
+/*
+ *  cpu_run_thread():
+ *
+ *  Host thread for one of the CPUs which are not stepped by CPU_RUN (see
+ *  machine->threaded_cpus). A CPU which is not running is polled until it
+ *  is started, or until the machine shuts down.
+ */
+static void *cpu_run_thread(void *arg)
+{
+	struct cpu_thread_args *args = arg;
+	struct cpu *cpu = args->cpu;
+	struct machine *machine = cpu->machine;
+
+	while (!machine->threaded_cpus_quit) {
+		int j = 0;
+
+		if (machine->cpu_sync_func != NULL)
+			machine->cpu_sync_func(cpu, machine->cpu_sync_extra);
+
+		if (!cpu->running || cpu->dead || single_step) {
+			usleep(1000);
+			continue;
+		}
+
+		while (j < CPU_THREAD_CHUNK && cpu->running && !single_step) {
+			int instrs_run = CPU_RINSTR(args->emul, cpu);
+			if (instrs_run == 0)
+				break;
+			j += instrs_run;
+		}
+	}
+
+	free(args);
+	return NULL;
+}
+
+
+/*
+ *  cpu_run_start_threads():
+ *
+ *  Start one host thread for each of CPU 1 and up. The threads are stopped
+ *  and joined by cpu_run_deinit().
+ */
+static void cpu_run_start_threads(struct emul *emul, struct machine *machine)
+{
+	pthread_t *threads;
+	int i;
+
+	threads = malloc(sizeof(pthread_t) * machine->ncpus);
+	if (threads == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	machine->threaded_cpus_quit = 0;
+
+	for (i=1; i<machine->ncpus; i++) {
+		struct cpu_thread_args *args = malloc(sizeof(*args));
+		if (args == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		args->emul = emul;
+		args->cpu = machine->cpus[i];
+		if (pthread_create(&threads[i], NULL, cpu_run_thread, args)) {
+			fprintf(stderr, "could not start a host thread for "
+			    "cpu%i\n", i);
+			exit(1);
+		}
+	}
+
+	machine->cpu_threads = threads;
+}
+#endif	/*  HAVE_PTHREADS  */
+
+
 /*
  *  CPU_RUN():
  *
@@ -67,6 +159,15 @@ int CPU_RUN(struct emul *emul, struct machine *machine)
 	int64_t ncycles_chunk_end;
 	int running, rounds;
 
+	/*  CPUs on their own host threads are not stepped from here:  */
+	if (machine->threaded_cpus) {
+#ifdef HAVE_PTHREADS
+		if (machine->cpu_threads == NULL)
+			cpu_run_start_threads(emul, machine);
+#endif
+		ncpus = 1;
+	}
+
 	/*  The main loop:  */
 	running = 1;
 	rounds = 0;
@@ -251,8 +352,19 @@ int CPU_RUN(struct emul *emul, struct machine *machine)
 		}
 
 		if (max_instructions_cached != 0 &&
-		    machine->ncycles >= max_instructions_cached)
+		    machine->ncycles >= max_instructions_cached) {
+			machine->exit_status = MACHINE_EXIT_BUDGET;
 			running = 0;
+		}
+
+		/*  Out of (wall clock) time?  */
+		if (machine->max_seconds != 0 &&
+		    time(NULL) >= machine->deadline) {
+			fatal("[ %i second time limit reached ]\n",
+			    machine->max_seconds);
+			machine->exit_status = MACHINE_EXIT_BUDGET;
+			running = 0;
+		}
 
 		/*  Let's allow other machines to run.  */
 		rounds ++;
@@ -105,6 +105,7 @@ int main(int argc, char *argv[])
 	    "extern int old_quiet_mode;\n"
 	    "extern int show_opcode_statistics;\n"
 	    "extern int dyntrans_backend_enable;\n"
+	    "extern int dyntrans_backend_verify;\n"
 	    "extern int quiet_mode;\n");
 
 	printf("\n/* instr uses the same names as in "
@@ -116,8 +117,8 @@ int main(int argc, char *argv[])
 
 	printf("/*  This is for marking a physical page as containing"
 	    "\n    combined instructions:  */\n");
-	printf("#define combined (cpu->cd.%s.cur_physpage->flags "
-	    "|= COMBINATIONS)\n", a);
+	printf("#define combined (((struct %s_tc_physpage *)"
+	    "cpu->cd.%s.cur_ic_page)->flags |= COMBINATIONS)\n", a, a);
 
 	printf("\n#define X(n) void %s_instr_ ## n(struct cpu *cpu, \\\n"
 	    " struct %s_instr_call *ic)\n", a, a);
@@ -31,6 +31,7 @@ extern int old_instruction_trace;
 extern int old_quiet_mode;
 extern int show_opcode_statistics;
 extern int dyntrans_backend_enable;
+extern int dyntrans_backend_verify;
 extern int quiet_mode;
 
 /* instr uses the same names as in cpu_mips_instr.c */
@@ -43,7 +44,7 @@ extern int quiet_mode;
 
 /*  This is for marking a physical page as containing
     combined instructions:  */
-#define combined (cpu->cd.mips.cur_physpage->flags |= COMBINATIONS)
+#define combined (((struct mips_tc_physpage *)cpu->cd.mips.cur_ic_page)->flags |= COMBINATIONS)
 
 #define X(n) void mips_instr_ ## n(struct cpu *cpu, \
  struct mips_instr_call *ic)
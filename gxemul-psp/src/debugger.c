@@ -60,6 +60,7 @@
 #include "console.h"
 #include "cpu.h"
 #include "device.h"
+#include "devices.h"
 #include "debugger.h"
 #include "diskimage.h"
 #include "emul.h"
@@ -67,6 +68,7 @@
 #include "memory.h"
 #include "misc.h"
 #include "net.h"
+#include "snapshot.h"
 #include "x11.h"
 
 
@@ -82,6 +84,7 @@ extern int quiet_mode;
 
 volatile int single_step = 0;
 int force_debugger_at_exit = 0;
+int batch_mode = 0;
 int show_opcode_statistics = 0;
 
 volatile int single_step_breakpoint = 0;
@@ -774,6 +777,28 @@ print_current_focus_and_return:
 static void debugger_cmd_help(struct machine *m, char *cmd_line);
 
 
+/*
+ *  debugger_cmd_grab():
+ *
+ *  Write the machine's framebuffer to a PNG file.
+ */
+static void debugger_cmd_grab(struct machine *m, char *cmd_line)
+{
+	if (cmd_line[0] == '\0') {
+		printf("syntax: grab file.png\n");
+		return;
+	}
+
+	if (m->main_fb == NULL) {
+		printf("This machine has no framebuffer.\n");
+		return;
+	}
+
+	if (dev_fb_save_png(m->main_fb, cmd_line))
+		printf("framebuffer written to %s\n", cmd_line);
+}
+
+
 /*
  *  debugger_cmd_itrace():
  */
@@ -792,6 +817,37 @@ static void debugger_cmd_itrace(struct machine *m, char *cmd_line)
 }
 
 
+/*
+ *  debugger_cmd_loadsnap():
+ *
+ *  Restore the machine from a snapshot file written by writesnap (or -k).
+ */
+static void debugger_cmd_loadsnap(struct machine *m, char *cmd_line)
+{
+	char *p, filename[1000];
+	int nr = -1;
+
+	if (cmd_line[0] == '\0') {
+		printf("syntax: loadsnap file [n]\n");
+		return;
+	}
+
+	strlcpy(filename, cmd_line, sizeof(filename));
+	p = strchr(filename, ' ');
+	if (p != NULL) {
+		*p++ = '\0';
+		while (*p == ' ')
+			p++;
+		if (*p != '\0')
+			nr = strtoull(p, NULL, 0);
+	}
+
+	nr = snapshot_restore(m, filename, nr);
+	if (nr >= 0)
+		printf("snapshot %i restored from %s\n", nr, filename);
+}
+
+
 /*
  *  debugger_cmd_lookup():
  */
@@ -1527,6 +1583,60 @@ static void debugger_cmd_version(struct machine *m, char *cmd_line)
 }
 
 
+/*
+ *  debugger_cmd_vfputest():
+ *
+ *  Run the VFPU conformance tests on the Allegrex cpus.
+ */
+static void debugger_cmd_vfputest(struct machine *m, char *cmd_line)
+{
+	int i, tested = 0, failed = 0;
+
+	if (*cmd_line) {
+		printf("syntax: vfputest\n");
+		return;
+	}
+
+	if (m->arch != ARCH_MIPS) {
+		printf("No VFPU on this machine.\n");
+		return;
+	}
+
+	for (i=0; i<m->ncpus; i++)
+		if (m->cpus[i]->cd.mips.vfpu != NULL) {
+			failed += mips_vfpu_selftest(m->cpus[i]);
+			tested ++;
+		}
+
+	if (!tested) {
+		printf("No VFPU on this machine.\n");
+		return;
+	}
+
+	printf("vfputest: %s\n", failed? "FAILED" : "ok");
+}
+
+
+/*
+ *  debugger_cmd_writesnap():
+ *
+ *  Append a snapshot of the machine to a file.
+ */
+static void debugger_cmd_writesnap(struct machine *m, char *cmd_line)
+{
+	int nr;
+
+	if (cmd_line[0] == '\0') {
+		printf("syntax: writesnap file\n");
+		return;
+	}
+
+	nr = snapshot_save(m, cmd_line);
+	if (nr >= 0)
+		printf("snapshot %i written to %s\n", nr, cmd_line);
+}
+
+
 struct cmd {
 	char	*name;
 	char	*args;
@@ -1560,12 +1670,18 @@ static struct cmd cmds[] = {
 	{ "focus", "x[,y]", 0, debugger_cmd_focus,
 		"changes focus to machine x (in emul y)" },
 
+	{ "grab", "file.png", 0, debugger_cmd_grab,
+		"write the framebuffer to a PNG file" },
+
 	{ "help", "", 0, debugger_cmd_help,
 		"print this help message" },
 
 	{ "itrace", "", 0, debugger_cmd_itrace,
 		"toggle instruction_trace on or off" },
 
+	{ "loadsnap", "file [n]", 0, debugger_cmd_loadsnap,
+		"restore snapshot n (default: the last one) from file" },
+
 	{ "lookup", "name|addr", 0, debugger_cmd_lookup,
 		"lookup a symbol by name or address" },
 
@@ -1614,6 +1730,12 @@ static struct cmd cmds[] = {
 	{ "version", "", 0, debugger_cmd_version,
 		"print version information" },
 
+	{ "vfputest", "", 0, debugger_cmd_vfputest,
+		"run the VFPU conformance tests" },
+
+	{ "writesnap", "file", 0, debugger_cmd_writesnap,
+		"append a snapshot of the machine to file" },
+
 	/*  Note: NULL handler.  */
 	{ "x = expr", "", 0, NULL, "generic assignment" },
 
@@ -2164,6 +2286,19 @@ void debugger(void)
 		return;
 	}
 
+	/*
+	 *  In batch mode (-a), there is nobody to talk to. Stop everything,
+	 *  the same way as the quit command does, and let the exit status
+	 *  tell the caller what happened.
+	 */
+	if (batch_mode) {
+		fatal("[ batch mode: not entering the debugger ]\n");
+		if (debugger_machine->exit_status == 0)
+			debugger_machine->exit_status = MACHINE_EXIT_DEBUGGER;
+		debugger_cmd_quit(debugger_machine, "");
+		return;
+	}
+
 	/*
 	 *  Clear all dyntrans translations, because otherwise things would
 	 *  become to complex to keep in sync.
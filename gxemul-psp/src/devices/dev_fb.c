@@ -55,6 +55,7 @@
 #include "machine.h"
 #include "memory.h"
 #include "misc.h"
+#include "snapshot.h"
 #include "x11.h"
 
 #ifdef WITH_X11
@@ -598,6 +599,171 @@ DEVICE_ACCESS(fb)
 }
 
 
+/*
+ *  PNG output helpers. The image data is stored uncompressed (in "stored"
+ *  deflate blocks), so no zlib is needed.
+ */
+static uint32_t png_crc_table[256];
+
+static uint32_t png_crc(uint32_t crc, unsigned char *buf, size_t len)
+{
+	size_t i;
+
+	if (png_crc_table[1] == 0) {
+		uint32_t c;
+		int n, k;
+		for (n=0; n<256; n++) {
+			c = n;
+			for (k=0; k<8; k++)
+				c = c & 1? 0xedb88320 ^ (c >> 1) : c >> 1;
+			png_crc_table[n] = c;
+		}
+	}
+
+	crc ^= 0xffffffff;
+	for (i=0; i<len; i++)
+		crc = png_crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+	return crc ^ 0xffffffff;
+}
+
+static void png_put32(unsigned char *p, uint32_t x)
+{
+	p[0] = x >> 24; p[1] = x >> 16; p[2] = x >> 8; p[3] = x;
+}
+
+static void png_chunk(FILE *f, char *type, unsigned char *data, size_t len)
+{
+	unsigned char buf[8];
+	uint32_t crc;
+
+	png_put32(buf, len);
+	memcpy(buf + 4, type, 4);
+	fwrite(buf, 1, 8, f);
+	if (len > 0)
+		fwrite(data, 1, len, f);
+	crc = png_crc(png_crc(0, (unsigned char *)type, 4), data, len);
+	png_put32(buf, crc);
+	fwrite(buf, 1, 4, f);
+}
+
+
+/*
+ *  dev_fb_save_png():
+ *
+ *  Write the visible part of a framebuffer to a PNG file, with the pixels
+ *  decoded the same way as for the X11 window. Returns 1 on success, 0 on
+ *  failure.
+ */
+int dev_fb_save_png(struct vfb_data *d, char *filename)
+{
+	int w = d->visible_xsize, h = d->visible_ysize, x, y;
+	size_t rowlen = 1 + 3 * w, rawlen = rowlen * h, zlen, ofs, n;
+	uint32_t s1 = 1, s2 = 0;
+	unsigned char *raw, *z, *p, hdr[13];
+	FILE *f;
+
+	raw = malloc(rawlen);
+	zlen = 2 + rawlen + 5 * (rawlen / 65535 + 1) + 4;
+	z = malloc(zlen);
+	if (raw == NULL || z == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	/*  Scanlines, each with filter type 0 (none):  */
+	for (y=0; y<h; y++) {
+		p = raw + y * rowlen;
+		*p++ = 0;
+		for (x=0; x<w; x++) {
+			size_t a = y * d->bytes_per_line + x * d->bit_depth / 8;
+			unsigned char *fb = d->framebuffer + a;
+			int r, g, b;
+
+			if (a + 4 > d->framebuffer_size) {
+				r = g = b = 0;
+			} else if (d->bit_depth == 32 || d->bit_depth == 24) {
+				r = fb[0]; g = fb[1]; b = fb[2];
+			} else if (d->bit_depth == 16) {
+				int c = fb[0] + (fb[1] << 8);
+				r = (c & 0x1f) << 3;
+				g = ((c >> 5) & 0x1f) << 3;
+				b = ((c >> 10) & 0x1f) << 3;
+			} else {
+				r = d->rgb_palette[fb[0] * 3 + 0];
+				g = d->rgb_palette[fb[0] * 3 + 1];
+				b = d->rgb_palette[fb[0] * 3 + 2];
+			}
+			*p++ = r; *p++ = g; *p++ = b;
+		}
+	}
+
+	/*  zlib stream of stored blocks, and its adler32:  */
+	p = z;
+	*p++ = 0x78; *p++ = 0x01;
+	for (ofs = 0; ofs < rawlen; ofs += n) {
+		n = rawlen - ofs > 65535? 65535 : rawlen - ofs;
+		*p++ = ofs + n == rawlen? 1 : 0;
+		*p++ = n; *p++ = n >> 8;
+		*p++ = ~n; *p++ = ~n >> 8;
+		memcpy(p, raw + ofs, n);
+		p += n;
+	}
+	for (ofs = 0; ofs < rawlen; ofs++) {
+		s1 = (s1 + raw[ofs]) % 65521;
+		s2 = (s2 + s1) % 65521;
+	}
+	png_put32(p, (s2 << 16) | s1);
+	p += 4;
+
+	f = fopen(filename, "wb");
+	if (f == NULL) {
+		perror(filename);
+		free(raw);
+		free(z);
+		return 0;
+	}
+
+	fwrite("\211PNG\r\n\032\n", 1, 8, f);
+	png_put32(hdr, w);
+	png_put32(hdr + 4, h);
+	hdr[8] = 8;		/*  bits per sample  */
+	hdr[9] = 2;		/*  RGB  */
+	hdr[10] = hdr[11] = hdr[12] = 0;
+	png_chunk(f, "IHDR", hdr, sizeof(hdr));
+	png_chunk(f, "IDAT", z, p - z);
+	png_chunk(f, "IEND", NULL, 0);
+	fclose(f);
+
+	free(raw);
+	free(z);
+	return 1;
+}
+
+
+/*
+ *  dev_fb_snapshot():
+ *
+ *  The framebuffer memory itself is a snapshot region. A restore redraws
+ *  the whole window.
+ */
+static void dev_fb_snapshot(struct snapshot *s, void *extra)
+{
+	struct vfb_data *d = extra;
+
+	SNAPSHOT_VAR(s, d->bit_depth);
+	SNAPSHOT_VAR(s, d->color32k);
+	SNAPSHOT_VAR(s, d->psp_15bit);
+	SNAPSHOT_VAR(s, d->bytes_per_line);
+	SNAPSHOT_VAR(s, d->rgb_palette);
+
+	if (snapshot_restoring(s)) {
+		d->update_x1 = d->update_y1 = 0;
+		d->update_x2 = d->xsize - 1;
+		d->update_y2 = d->ysize - 1;
+	}
+}
+
+
 /*
  *  dev_fb_init():
  *
@@ -770,6 +936,9 @@ struct vfb_data *dev_fb_init(struct machine *machine, struct memory *mem,
 	memory_device_register(mem, name2, baseaddr, size, dev_fb_access,
 	    d, flags, d->framebuffer);
 
+	snapshot_register(machine, name2, dev_fb_snapshot, d);
+	snapshot_register_memory(machine, name2, d->framebuffer, size);
+
 	machine_add_tickfunction(machine, dev_fb_tick, d, FB_TICK_SHIFT);
 	return d;
 }
@@ -0,0 +1,2835 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  PSP GE (graphics engine): display list processor and software rasterizer.
+ *
+ *  Display lists are handed to the GE by the sceGe* HLE calls (see
+ *  promemul/psp_hle_ge.c), and are executed right away, up to the list's
+ *  stall address or its end. Each command is 8 bits of opcode and 24 bits of
+ *  parameter; the last parameter of every command is kept in cmd[], and the
+ *  few commands which do something (PRIM, JUMP, CALL, LOADCLUT, matrix
+ *  uploads, block transfers, ...) are handled in ge_command().
+ *
+ *  Rendering is done in two steps:
+ *
+ *	o)  PRIM runs the vertex pipeline (skinning, morphing, transform,
+ *	    lighting, texture coordinate generation, fog, near plane
+ *	    clipping, culling) on the main thread. The resulting screen space
+ *	    primitives are set up (edge functions and attribute gradients)
+ *	    and binned into GE_TILE_SIZE x GE_TILE_SIZE screen tiles. The
+ *	    per-pixel state (framebuffer, tests, blending, the decoded
+ *	    texture, ...) is snapshotted into a ge_rstate when it changes.
+ *
+ *	o)  ge_flush() rasterizes all binned primitives. Each tile is drawn
+ *	    by one thread, in submission order, so the tiles can be drawn in
+ *	    parallel by a small pool of host threads without any locking.
+ *
+ *  The batch is flushed at the end of each list run, before block
+ *  transfers and CLUT loads, and before a texture in VRAM is decoded (it
+ *  may be the target of primitives which haven't been drawn yet).
+ *
+ *  Textures are decoded into 32-bit RGBA (and unswizzled) once, and kept in
+ *  a small cache for the duration of a list run. Only the first mipmap level
+ *  is used. Bezier and spline patches are not implemented, and the GE
+ *  signal and finish callbacks are never called (like other HLE callbacks).
+ *
+ *  Per-list command, primitive, vertex and pixel counts are reported with
+ *  debug() when a list completes.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cpu.h"
+#include "devices.h"
+#include "machine.h"
+#include "memory.h"
+#include "misc.h"
+#include "snapshot.h"
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+
+/*  #define GE_DEBUG  */
+
+#define	GE_MAX_LISTS		64
+#define	GE_STACK_DEPTH		32
+#define	GE_MAX_THREADS		8
+#define	GE_TILE_SHIFT		5
+#define	GE_TILE_SIZE		(1 << GE_TILE_SHIFT)
+#define	GE_TILES_X		(1024 >> GE_TILE_SHIFT)
+#define	GE_TILES_Y		(1024 >> GE_TILE_SHIFT)
+#define	GE_MAX_BATCH_PRIMS	65536
+#define	GE_TEXCACHE_SIZE	16
+#define	GE_CLUT_SIZE		2048
+
+#define	GE_VRAM_BASE		0x04000000
+#define	GE_VRAM_MASK		0x001fffff
+
+/*  Display list commands:  */
+#define	GE_CMD_NOP		0x00
+#define	GE_CMD_VADDR		0x01
+#define	GE_CMD_IADDR		0x02
+#define	GE_CMD_PRIM		0x04
+#define	GE_CMD_BEZIER		0x05
+#define	GE_CMD_SPLINE		0x06
+#define	GE_CMD_BBOX		0x07
+#define	GE_CMD_JUMP		0x08
+#define	GE_CMD_BJUMP		0x09
+#define	GE_CMD_CALL		0x0a
+#define	GE_CMD_RET		0x0b
+#define	GE_CMD_END		0x0c
+#define	GE_CMD_SIGNAL		0x0e
+#define	GE_CMD_FINISH		0x0f
+#define	GE_CMD_BASE		0x10
+#define	GE_CMD_VTYPE		0x12
+#define	GE_CMD_OFFSET_ADDR	0x13
+#define	GE_CMD_ORIGIN		0x14
+#define	GE_CMD_LIGHTING_ENABLE	0x17
+#define	GE_CMD_LIGHT_ENABLE0	0x18
+#define	GE_CMD_CULL_ENABLE	0x1d
+#define	GE_CMD_TEXTURE_ENABLE	0x1e
+#define	GE_CMD_FOG_ENABLE	0x1f
+#define	GE_CMD_BLEND_ENABLE	0x21
+#define	GE_CMD_ATEST_ENABLE	0x22
+#define	GE_CMD_ZTEST_ENABLE	0x23
+#define	GE_CMD_STEST_ENABLE	0x24
+#define	GE_CMD_CTEST_ENABLE	0x27
+#define	GE_CMD_LOGICOP_ENABLE	0x28
+#define	GE_CMD_BONE_NUM		0x2a
+#define	GE_CMD_BONE_DATA	0x2b
+#define	GE_CMD_MORPH_WEIGHT0	0x2c
+#define	GE_CMD_WORLD_NUM	0x3a
+#define	GE_CMD_WORLD_DATA	0x3b
+#define	GE_CMD_VIEW_NUM		0x3c
+#define	GE_CMD_VIEW_DATA	0x3d
+#define	GE_CMD_PROJ_NUM		0x3e
+#define	GE_CMD_PROJ_DATA	0x3f
+#define	GE_CMD_TGEN_NUM		0x40
+#define	GE_CMD_TGEN_DATA	0x41
+#define	GE_CMD_VP_XSCALE	0x42
+#define	GE_CMD_VP_YSCALE	0x43
+#define	GE_CMD_VP_ZSCALE	0x44
+#define	GE_CMD_VP_XCENTER	0x45
+#define	GE_CMD_VP_YCENTER	0x46
+#define	GE_CMD_VP_ZCENTER	0x47
+#define	GE_CMD_TEX_SCALE_U	0x48
+#define	GE_CMD_TEX_SCALE_V	0x49
+#define	GE_CMD_TEX_OFFSET_U	0x4a
+#define	GE_CMD_TEX_OFFSET_V	0x4b
+#define	GE_CMD_OFFSET_X		0x4c
+#define	GE_CMD_OFFSET_Y		0x4d
+#define	GE_CMD_SHADE		0x50
+#define	GE_CMD_REVERSE_NORMAL	0x51
+#define	GE_CMD_MATERIAL_UPDATE	0x53
+#define	GE_CMD_MATERIAL_EMISSIVE 0x54
+#define	GE_CMD_MATERIAL_AMBIENT	0x55
+#define	GE_CMD_MATERIAL_DIFFUSE	0x56
+#define	GE_CMD_MATERIAL_SPECULAR 0x57
+#define	GE_CMD_MATERIAL_ALPHA	0x58
+#define	GE_CMD_MATERIAL_SPECCOEF 0x5b
+#define	GE_CMD_AMBIENT_COLOR	0x5c
+#define	GE_CMD_AMBIENT_ALPHA	0x5d
+#define	GE_CMD_LIGHT_TYPE0	0x5f
+#define	GE_CMD_LIGHT_POS0	0x63
+#define	GE_CMD_LIGHT_DIR0	0x6f
+#define	GE_CMD_LIGHT_ATT0	0x7b
+#define	GE_CMD_LIGHT_EXP0	0x87
+#define	GE_CMD_LIGHT_CUTOFF0	0x8b
+#define	GE_CMD_LIGHT_COLOR0	0x8f
+#define	GE_CMD_CULL		0x9b
+#define	GE_CMD_FB_PTR		0x9c
+#define	GE_CMD_FB_WIDTH		0x9d
+#define	GE_CMD_Z_PTR		0x9e
+#define	GE_CMD_Z_WIDTH		0x9f
+#define	GE_CMD_TEX_ADDR0	0xa0
+#define	GE_CMD_TEX_BUFWIDTH0	0xa8
+#define	GE_CMD_CLUT_ADDR	0xb0
+#define	GE_CMD_CLUT_ADDR_UPPER	0xb1
+#define	GE_CMD_XFER_SRC		0xb2
+#define	GE_CMD_XFER_SRC_WIDTH	0xb3
+#define	GE_CMD_XFER_DST		0xb4
+#define	GE_CMD_XFER_DST_WIDTH	0xb5
+#define	GE_CMD_TEX_SIZE0	0xb8
+#define	GE_CMD_TEX_MAP_MODE	0xc0
+#define	GE_CMD_TEX_SHADE_LS	0xc1
+#define	GE_CMD_TEX_MODE		0xc2
+#define	GE_CMD_TEX_FORMAT	0xc3
+#define	GE_CMD_LOAD_CLUT	0xc4
+#define	GE_CMD_CLUT_FORMAT	0xc5
+#define	GE_CMD_TEX_FILTER	0xc6
+#define	GE_CMD_TEX_WRAP		0xc7
+#define	GE_CMD_TEX_FUNC		0xc9
+#define	GE_CMD_TEX_ENV_COLOR	0xca
+#define	GE_CMD_TEX_FLUSH	0xcb
+#define	GE_CMD_TEX_SYNC		0xcc
+#define	GE_CMD_FOG1		0xcd
+#define	GE_CMD_FOG2		0xce
+#define	GE_CMD_FOG_COLOR	0xcf
+#define	GE_CMD_FB_FORMAT	0xd2
+#define	GE_CMD_CLEAR_MODE	0xd3
+#define	GE_CMD_SCISSOR1		0xd4
+#define	GE_CMD_SCISSOR2		0xd5
+#define	GE_CMD_CTEST		0xd8
+#define	GE_CMD_CREF		0xd9
+#define	GE_CMD_CMASK		0xda
+#define	GE_CMD_ATEST		0xdb
+#define	GE_CMD_STEST		0xdc
+#define	GE_CMD_SOP		0xdd
+#define	GE_CMD_ZTEST		0xde
+#define	GE_CMD_BLEND		0xdf
+#define	GE_CMD_BLEND_FIXA	0xe0
+#define	GE_CMD_BLEND_FIXB	0xe1
+#define	GE_CMD_LOGICOP		0xe6
+#define	GE_CMD_ZWRITE_DISABLE	0xe7
+#define	GE_CMD_MASK_RGB		0xe8
+#define	GE_CMD_MASK_ALPHA	0xe9
+#define	GE_CMD_XFER_START	0xea
+#define	GE_CMD_XFER_SRC_POS	0xeb
+#define	GE_CMD_XFER_DST_POS	0xec
+#define	GE_CMD_XFER_SIZE	0xee
+
+/*  Primitive types (PRIM parameter bits 16..18):  */
+#define	GE_PRIM_POINTS		0
+#define	GE_PRIM_LINES		1
+#define	GE_PRIM_LINE_STRIP	2
+#define	GE_PRIM_TRIANGLES	3
+#define	GE_PRIM_TRIANGLE_STRIP	4
+#define	GE_PRIM_TRIANGLE_FAN	5
+#define	GE_PRIM_SPRITES		6
+
+/*  Pixel formats:  */
+#define	GE_PSM_5650		0
+#define	GE_PSM_5551		1
+#define	GE_PSM_4444		2
+#define	GE_PSM_8888		3
+#define	GE_PSM_T4		4
+#define	GE_PSM_T8		5
+#define	GE_PSM_T16		6
+#define	GE_PSM_T32		7
+#define	GE_PSM_DXT1		8
+#define	GE_PSM_DXT3		9
+#define	GE_PSM_DXT5		10
+
+/*  List states, as returned by sceGeListSync():  */
+#define	GE_LIST_DONE		0
+#define	GE_LIST_QUEUED		1
+#define	GE_LIST_DRAWING		2
+#define	GE_LIST_STALLING	3
+#define	GE_LIST_FREE		-1
+
+/*  Attributes interpolated across primitives:  */
+#define	A_Z		0
+#define	A_W		1	/*  1/w  */
+#define	A_U		2	/*  u/w  */
+#define	A_V		3	/*  v/w  */
+#define	A_R		4
+#define	A_G		5
+#define	A_B		6
+#define	A_A		7
+#define	A_FOG		8
+#define	GE_NATTR	9
+
+/*  Screen space primitives, as binned:  */
+#define	GE_RPRIM_TRIANGLE	0
+#define	GE_RPRIM_SPRITE		1
+#define	GE_RPRIM_LINE		2
+#define	GE_RPRIM_POINT		3
+
+
+struct ge_list {
+	int		state;
+	uint32_t	start;
+	uint32_t	pc;
+	uint32_t	stall;
+	uint32_t	base;
+	uint32_t	offset;
+	uint32_t	stack[GE_STACK_DEPTH];
+	int		stack_ptr;
+	int		finished;	/*  FINISH seen, END completes  */
+	int		signal;		/*  SIGNAL seen, END acts on it  */
+	uint32_t	signal_param;
+
+	/*  Statistics:  */
+	int64_t		ncommands;
+	int64_t		nprims;
+	int64_t		nvertices;
+	int64_t		npixels;
+};
+
+/*  A decoded texture (level 0 only), 32-bit RGBA with red in bits 0..7:  */
+struct ge_texture {
+	uint32_t	addr;
+	int		psm, width, height, bufw, swizzle;
+	uint32_t	clut_format;
+	uint32_t	clut_version;
+	int		in_vram;
+	uint64_t	vram_epoch;
+	uint64_t	batch;		/*  last used by this batch  */
+	uint64_t	lru;
+	uint32_t	*data;
+};
+
+/*  Per-pixel state, snapshotted when it changes:  */
+struct ge_rstate {
+	unsigned char	*fb;
+	int		fb_stride;
+	int		fb_psm;
+	unsigned char	*zb;
+	int		zb_stride;
+	int		x1, y1, x2, y2;		/*  scissor, inclusive  */
+
+	int		clear;			/*  clear mode flags + 1  */
+	int		flat;
+
+	struct ge_texture *tex;
+	int		tex_clamp_u, tex_clamp_v;
+	int		tex_linear;
+	int		tex_func, tex_alpha, tex_double;
+	uint32_t	tex_env;
+
+	int		fog;
+	uint32_t	fog_color;
+
+	int		ctest;
+	uint32_t	cref, cmask;
+	int		atest, afunc, aref, amask;
+	int		stest, sfunc, sref, smask, sfail, szfail, szpass;
+	int		ztest, zfunc, zwrite;
+	int		blend, blend_op, blend_src, blend_dst;
+	uint32_t	blend_fixa, blend_fixb;
+	int		logicop;
+	uint32_t	write_mask;		/*  1 bits are not written  */
+};
+
+/*  A vertex after the vertex pipeline, in clip space:  */
+struct ge_xvert {
+	float		clip[4];
+	float		uv[2];
+	float		color[4];
+	float		fog;
+};
+#define	GE_XVERT_NFLOATS	(sizeof(struct ge_xvert) / sizeof(float))
+
+/*  A vertex in screen space:  */
+struct ge_rvert {
+	float		x, y;
+	float		a[GE_NATTR];
+};
+
+struct ge_prim {
+	int		type;
+	int		state;
+	int		x1, y1, x2, y2;		/*  pixel bounding box  */
+
+	/*  Triangles: edge functions in 1/16 pixels at pixel centers, and
+	    attribute planes at pixel centers:  */
+	int64_t		ea[3], eb[3], ec[3];
+	float		a0[GE_NATTR], dadx[GE_NATTR], dady[GE_NATTR];
+
+	/*  Sprites, lines and points:  */
+	struct ge_rvert	v[2];
+};
+
+struct ge_bin {
+	int		*prims;
+	int		n, max;
+};
+
+struct psp_ge_data {
+	struct machine	*machine;
+	struct vfb_data	*fb;
+	unsigned char	*vram;
+	uint32_t	vram_size;
+	uint32_t	ram_start, ram_end;
+
+	struct ge_list	lists[GE_MAX_LISTS];
+	int		queue[GE_MAX_LISTS];
+	int		nqueued;
+	struct ge_list	*cur;
+
+	/*  Last parameter of each command, and the matrices:  */
+	uint32_t	cmd[256];
+	uint32_t	vaddr, iaddr;
+	float		world[12], view[12], proj[16], tgen[12];
+	float		bone[8 * 12];
+	int		world_n, view_n, proj_n, tgen_n, bone_n;
+
+	unsigned char	clut[GE_CLUT_SIZE];
+	uint32_t	clut_version;
+
+	struct ge_texture texcache[GE_TEXCACHE_SIZE];
+	uint64_t	tex_lru;
+	uint64_t	vram_epoch;
+
+	/*  The current batch of binned primitives:  */
+	struct ge_prim	*prims;
+	int		nprims, max_prims;
+	struct ge_rstate *states;
+	int		nstates, max_states;
+	int		rstate_dirty;
+	uint64_t	batch;
+	struct ge_bin	bins[GE_TILES_X * GE_TILES_Y];
+	int		active[GE_TILES_X * GE_TILES_Y];
+	int		nactive;
+
+	int		nthreads;
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t	work_lock;
+	pthread_cond_t	work_cond;
+	pthread_cond_t	done_cond;
+	int		work_serial;
+	int		next_tile;
+	int		workers_busy;
+#endif
+	int64_t		batch_pixels;
+	int		warned_patches;
+};
+
+static struct psp_ge_data *psp_ge = NULL;
+
+
+static float ge_float(uint32_t param)
+{
+	union {
+		uint32_t	i;
+		float		f;
+	} u;
+	u.i = param << 8;
+	return u.f;
+}
+
+static int ge_clamp255(int x)
+{
+	return x < 0? 0 : (x > 255? 255 : x);
+}
+
+
+/*****************************************************************************
+ *
+ *  Memory access.
+ */
+
+/*
+ *  ge_ptr():
+ *
+ *  Returns a host pointer to len bytes at a GE address, or NULL if the range
+ *  is outside RAM and VRAM, or crosses a memblock boundary.
+ */
+static unsigned char *ge_ptr(struct psp_ge_data *d, uint32_t addr,
+	uint32_t len, int writeflag)
+{
+	unsigned char *p;
+	uint32_t ofs;
+
+	addr &= 0x1fffffff;
+
+	if ((addr & 0x1f000000) == GE_VRAM_BASE) {
+		ofs = addr & GE_VRAM_MASK;
+		if (ofs + len > d->vram_size)
+			return NULL;
+		return d->vram + ofs;
+	}
+
+	if (addr < d->ram_start || addr + len > d->ram_end)
+		return NULL;
+
+	ofs = addr & ((1 << BITS_PER_MEMBLOCK) - 1);
+	if (ofs + len > (1 << BITS_PER_MEMBLOCK))
+		return NULL;
+
+	p = memory_paddr_to_hostaddr(d->machine->memory, addr, writeflag);
+	return p == NULL? NULL : p + ofs;
+}
+
+static int ge_in_vram(uint32_t addr)
+{
+	return ((addr & 0x1f000000) == GE_VRAM_BASE);
+}
+
+/*  Read len bytes, which may cross memblocks. Unmapped memory reads as 0.  */
+static void ge_read(struct psp_ge_data *d, uint32_t addr, unsigned char *buf,
+	uint32_t len)
+{
+	while (len > 0) {
+		uint32_t chunk = (1 << BITS_PER_MEMBLOCK) -
+		    (addr & ((1 << BITS_PER_MEMBLOCK) - 1));
+		unsigned char *p;
+
+		if (chunk > len)
+			chunk = len;
+		if (ge_in_vram(addr & 0x1fffffff)) {
+			uint32_t left = GE_VRAM_MASK + 1 - (addr & GE_VRAM_MASK);
+			if (chunk > left)
+				chunk = left;
+		}
+
+		p = ge_ptr(d, addr, chunk, MEM_READ);
+		if (p != NULL)
+			memcpy(buf, p, chunk);
+		else
+			memset(buf, 0, chunk);
+
+		addr += chunk; buf += chunk; len -= chunk;
+	}
+}
+
+static void ge_write(struct psp_ge_data *d, uint32_t addr,
+	const unsigned char *buf, uint32_t len)
+{
+	while (len > 0) {
+		uint32_t chunk = (1 << BITS_PER_MEMBLOCK) -
+		    (addr & ((1 << BITS_PER_MEMBLOCK) - 1));
+		unsigned char *p;
+
+		if (chunk > len)
+			chunk = len;
+		if (ge_in_vram(addr & 0x1fffffff)) {
+			uint32_t left = GE_VRAM_MASK + 1 - (addr & GE_VRAM_MASK);
+			if (chunk > left)
+				chunk = left;
+		}
+
+		p = ge_ptr(d, addr, chunk, MEM_WRITE);
+		if (p != NULL)
+			memcpy(p, buf, chunk);
+
+		addr += chunk; buf += chunk; len -= chunk;
+	}
+}
+
+static uint32_t ge_read32(struct psp_ge_data *d, uint32_t addr)
+{
+	unsigned char *p = ge_ptr(d, addr, 4, MEM_READ);
+
+	if (p == NULL)
+		return 0;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/*****************************************************************************
+ *
+ *  Pixel formats.
+ */
+
+static uint32_t ge_rgba(int r, int g, int b, int a)
+{
+	return r | (g << 8) | (b << 16) | ((uint32_t)a << 24);
+}
+
+static uint32_t ge_from_16(uint32_t p, int psm)
+{
+	int r, g, b, a;
+
+	switch (psm) {
+	case GE_PSM_5650:
+		r = p & 0x1f; g = (p >> 5) & 0x3f; b = (p >> 11) & 0x1f;
+		return ge_rgba((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+		    (b << 3) | (b >> 2), 255);
+	case GE_PSM_5551:
+		r = p & 0x1f; g = (p >> 5) & 0x1f; b = (p >> 10) & 0x1f;
+		return ge_rgba((r << 3) | (r >> 2), (g << 3) | (g >> 2),
+		    (b << 3) | (b >> 2), (p & 0x8000)? 255 : 0);
+	default:
+		r = p & 0xf; g = (p >> 4) & 0xf; b = (p >> 8) & 0xf;
+		a = (p >> 12) & 0xf;
+		return ge_rgba(r * 17, g * 17, b * 17, a * 17);
+	}
+}
+
+static uint32_t ge_to_16(uint32_t c, int psm)
+{
+	int r = c & 0xff, g = (c >> 8) & 0xff, b = (c >> 16) & 0xff;
+	int a = c >> 24;
+
+	switch (psm) {
+	case GE_PSM_5650:
+		return (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11);
+	case GE_PSM_5551:
+		return (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10) |
+		    ((a >> 7) << 15);
+	default:
+		return (r >> 4) | ((g >> 4) << 4) | ((b >> 4) << 8) |
+		    ((a >> 4) << 12);
+	}
+}
+
+static uint32_t ge_get_pixel(const unsigned char *p, int psm)
+{
+	if (psm == GE_PSM_8888)
+		return p[0] | (p[1] << 8) | (p[2] << 16) |
+		    ((uint32_t)p[3] << 24);
+	return ge_from_16(p[0] | (p[1] << 8), psm);
+}
+
+static void ge_put_pixel(unsigned char *p, int psm, uint32_t c)
+{
+	if (psm == GE_PSM_8888) {
+		p[0] = c; p[1] = c >> 8; p[2] = c >> 16; p[3] = c >> 24;
+	} else {
+		uint32_t x = ge_to_16(c, psm);
+		p[0] = x; p[1] = x >> 8;
+	}
+}
+
+
+/*****************************************************************************
+ *
+ *  Textures.
+ */
+
+static int ge_psm_bits(int psm)
+{
+	switch (psm) {
+	case GE_PSM_8888:
+	case GE_PSM_T32:	return 32;
+	case GE_PSM_T4:
+	case GE_PSM_DXT1:	return 4;
+	case GE_PSM_T8:
+	case GE_PSM_DXT3:
+	case GE_PSM_DXT5:	return 8;
+	default:		return 16;
+	}
+}
+
+static uint32_t ge_clut_lookup(struct psp_ge_data *d, uint32_t index)
+{
+	uint32_t fmt = d->cmd[GE_CMD_CLUT_FORMAT];
+	int cpsm = fmt & 3, shift = (fmt >> 2) & 0x1f;
+	uint32_t mask = (fmt >> 8) & 0xff, start = (fmt >> 16) & 0x1f;
+	const unsigned char *p;
+
+	index = ((index >> shift) & mask) | (start << 4);
+
+	if (cpsm == GE_PSM_8888) {
+		p = d->clut + (index & (GE_CLUT_SIZE / 4 - 1)) * 4;
+		return p[0] | (p[1] << 8) | (p[2] << 16) |
+		    ((uint32_t)p[3] << 24);
+	}
+
+	p = d->clut + (index & (GE_CLUT_SIZE / 2 - 1)) * 2;
+	return ge_from_16(p[0] | (p[1] << 8), cpsm);
+}
+
+/*  DXT blocks, in the PSP's layout (color indices first):  */
+static void ge_dxt_colors(const unsigned char *b, uint32_t *colors,
+	int force4)
+{
+	int c1 = b[4] | (b[5] << 8), c2 = b[6] | (b[7] << 8);
+	int r1 = (c1 >> 8) & 0xf8, g1 = (c1 >> 3) & 0xfc, b1 = (c1 << 3) & 0xf8;
+	int r2 = (c2 >> 8) & 0xf8, g2 = (c2 >> 3) & 0xfc, b2 = (c2 << 3) & 0xf8;
+
+	colors[0] = ge_rgba(r1, g1, b1, 255);
+	colors[1] = ge_rgba(r2, g2, b2, 255);
+	if (c1 > c2 || force4) {
+		colors[2] = ge_rgba((2*r1 + r2) / 3, (2*g1 + g2) / 3,
+		    (2*b1 + b2) / 3, 255);
+		colors[3] = ge_rgba((r1 + 2*r2) / 3, (g1 + 2*g2) / 3,
+		    (b1 + 2*b2) / 3, 255);
+	} else {
+		colors[2] = ge_rgba((r1 + r2) / 2, (g1 + g2) / 2,
+		    (b1 + b2) / 2, 255);
+		colors[3] = 0;
+	}
+}
+
+static void ge_decode_dxt(int psm, const unsigned char *src, int bx,
+	uint32_t *dst, int dst_stride, int w, int h)
+{
+	int blocksize = psm == GE_PSM_DXT1? 8 : 16;
+	int x, y, i, j;
+
+	if (psm != GE_PSM_DXT1 && psm != GE_PSM_DXT3 && psm != GE_PSM_DXT5) {
+		fatal("[ psp_ge: invalid DXT texture format %i ]\n", psm);
+		return;
+	}
+
+	for (y = 0; y < h; y += 4)
+		for (x = 0; x < w; x += 4) {
+			const unsigned char *b = src +
+			    ((y / 4) * bx + x / 4) * blocksize;
+			uint32_t colors[4];
+			unsigned char alpha[16] = { 0 };
+
+			ge_dxt_colors(b, colors, psm != GE_PSM_DXT1);
+
+			if (psm == GE_PSM_DXT3) {
+				for (i = 0; i < 16; i++) {
+					int n = (b[8 + i / 2] >> ((i & 1) * 4))
+					    & 0xf;
+					alpha[i] = n * 17;
+				}
+			} else if (psm == GE_PSM_DXT5) {
+				int a1 = b[14], a2 = b[15], pal[8];
+				uint64_t bits = b[8] | (b[9] << 8) |
+				    (b[10] << 16) | ((uint64_t)b[11] << 24) |
+				    ((uint64_t)b[12] << 32) |
+				    ((uint64_t)b[13] << 40);
+				pal[0] = a1; pal[1] = a2;
+				if (a1 > a2) {
+					for (i = 1; i < 7; i++)
+						pal[i + 1] = ((7-i)*a1 + i*a2)/7;
+				} else {
+					for (i = 1; i < 5; i++)
+						pal[i + 1] = ((5-i)*a1 + i*a2)/5;
+					pal[6] = 0; pal[7] = 255;
+				}
+				for (i = 0; i < 16; i++)
+					alpha[i] = pal[(bits >> (3 * i)) & 7];
+			}
+
+			for (j = 0; j < 4 && y + j < h; j++)
+				for (i = 0; i < 4 && x + i < w; i++) {
+					uint32_t c = colors[(b[j] >> (2*i))&3];
+					if (psm != GE_PSM_DXT1)
+						c = (c & 0xffffff) | ((uint32_t)
+						    alpha[j*4 + i] << 24);
+					dst[(y + j) * dst_stride + x + i] = c;
+				}
+		}
+}
+
+/*
+ *  ge_texture_decode():
+ *
+ *  Reads, unswizzles and decodes level 0 of the current texture into t.
+ */
+static void ge_texture_decode(struct psp_ge_data *d, struct ge_texture *t)
+{
+	int bits = ge_psm_bits(t->psm), w = t->width, h = t->height;
+	int rowpixels = t->bufw < w? w : t->bufw;
+	uint32_t rowbytes, size;
+	unsigned char *src;
+	int x, y;
+
+	if (t->psm >= GE_PSM_DXT1) {
+		int bx = (rowpixels + 3) / 4, by = (h + 3) / 4;
+		size = bx * by * (t->psm == GE_PSM_DXT1? 8 : 16);
+		src = malloc(size);
+		if (src == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		ge_read(d, t->addr, src, size);
+		ge_decode_dxt(t->psm, src, bx, t->data, w, w, h);
+		free(src);
+		return;
+	}
+
+	rowbytes = (rowpixels * bits + 7) / 8;
+	if (t->swizzle)
+		rowbytes = (rowbytes + 15) & ~15;
+	size = rowbytes * ((h + 7) & ~7);
+
+	src = malloc(size);
+	if (src == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	ge_read(d, t->addr, src, size);
+
+	if (t->swizzle) {
+		/*  16 bytes x 8 rows blocks, left to right, top to bottom:  */
+		unsigned char *lin = malloc(size);
+		int bpr = rowbytes / 16, bx, by, r;
+
+		if (lin == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		for (by = 0; by < (h + 7) / 8; by++)
+			for (bx = 0; bx < bpr; bx++) {
+				const unsigned char *blk = src +
+				    (by * bpr + bx) * 128;
+				for (r = 0; r < 8; r++)
+					memcpy(lin + (by * 8 + r) * rowbytes +
+					    bx * 16, blk + r * 16, 16);
+			}
+		free(src);
+		src = lin;
+	}
+
+	for (y = 0; y < h; y++) {
+		const unsigned char *row = src + y * rowbytes;
+		uint32_t *out = t->data + y * w;
+
+		for (x = 0; x < w; x++) {
+			const unsigned char *p;
+			uint32_t c;
+
+			switch (t->psm) {
+			case GE_PSM_8888:
+				p = row + x * 4;
+				c = p[0] | (p[1] << 8) | (p[2] << 16) |
+				    ((uint32_t)p[3] << 24);
+				break;
+			case GE_PSM_T4:
+				c = ge_clut_lookup(d, (row[x / 2] >>
+				    ((x & 1) * 4)) & 0xf);
+				break;
+			case GE_PSM_T8:
+				c = ge_clut_lookup(d, row[x]);
+				break;
+			case GE_PSM_T16:
+				p = row + x * 2;
+				c = ge_clut_lookup(d, p[0] | (p[1] << 8));
+				break;
+			case GE_PSM_T32:
+				p = row + x * 4;
+				c = ge_clut_lookup(d, p[0] | (p[1] << 8) |
+				    (p[2] << 16) | ((uint32_t)p[3] << 24));
+				break;
+			default:
+				p = row + x * 2;
+				c = ge_from_16(p[0] | (p[1] << 8), t->psm);
+			}
+			out[x] = c;
+		}
+	}
+
+	free(src);
+}
+
+static void ge_flush(struct psp_ge_data *d);
+
+/*
+ *  ge_texture():
+ *
+ *  Returns the decoded current texture, from the cache if possible.
+ */
+static struct ge_texture *ge_texture(struct psp_ge_data *d)
+{
+	struct ge_texture *t, *victim = NULL;
+	uint32_t addr, size = d->cmd[GE_CMD_TEX_SIZE0];
+	int psm = d->cmd[GE_CMD_TEX_FORMAT] & 0xf;
+	int w = 1 << (size & 0xf), h = 1 << ((size >> 8) & 0xf);
+	int bufw = d->cmd[GE_CMD_TEX_BUFWIDTH0] & 0x7ff;
+	int swizzle = d->cmd[GE_CMD_TEX_MODE] & 1;
+	int i, is_clut;
+
+	addr = (d->cmd[GE_CMD_TEX_ADDR0] & 0xfffff0) |
+	    ((d->cmd[GE_CMD_TEX_BUFWIDTH0] << 8) & 0x0f000000);
+	if (w > 512)
+		w = 512;
+	if (h > 512)
+		h = 512;
+	if (psm > GE_PSM_DXT5)
+		psm = GE_PSM_8888;
+	is_clut = psm >= GE_PSM_T4 && psm <= GE_PSM_T32;
+
+	for (i = 0; i < GE_TEXCACHE_SIZE; i++) {
+		t = &d->texcache[i];
+		if (t->data == NULL || t->addr != addr || t->psm != psm ||
+		    t->width != w || t->height != h || t->bufw != bufw ||
+		    t->swizzle != swizzle)
+			continue;
+		if (is_clut && (t->clut_version != d->clut_version ||
+		    t->clut_format != d->cmd[GE_CMD_CLUT_FORMAT]))
+			continue;
+		if (t->in_vram && t->vram_epoch != d->vram_epoch)
+			continue;
+		t->lru = ++ d->tex_lru;
+		t->batch = d->batch;
+		return t;
+	}
+
+	/*  Primitives which have not been drawn yet may render to it:  */
+	if (ge_in_vram(addr) && d->nprims > 0)
+		ge_flush(d);
+
+	/*  Replace the least recently used entry not needed by the batch:  */
+	for (i = 0; i < GE_TEXCACHE_SIZE; i++) {
+		t = &d->texcache[i];
+		if (t->data != NULL && t->batch == d->batch && d->nprims > 0)
+			continue;
+		if (victim == NULL || t->data == NULL || t->lru < victim->lru)
+			victim = t;
+		if (t->data == NULL)
+			break;
+	}
+	if (victim == NULL) {
+		ge_flush(d);
+		victim = &d->texcache[0];
+	}
+
+	t = victim;
+	free(t->data);
+	t->data = malloc(sizeof(uint32_t) * w * h);
+	if (t->data == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	t->addr = addr; t->psm = psm; t->width = w; t->height = h;
+	t->bufw = bufw; t->swizzle = swizzle;
+	t->clut_version = d->clut_version;
+	t->clut_format = d->cmd[GE_CMD_CLUT_FORMAT];
+	t->in_vram = ge_in_vram(addr);
+	t->vram_epoch = d->vram_epoch;
+	t->lru = ++ d->tex_lru;
+	t->batch = d->batch;
+
+	ge_texture_decode(d, t);
+	return t;
+}
+
+static void ge_texcache_clear(struct psp_ge_data *d)
+{
+	int i;
+
+	for (i = 0; i < GE_TEXCACHE_SIZE; i++) {
+		free(d->texcache[i].data);
+		d->texcache[i].data = NULL;
+	}
+}
+
+static uint32_t ge_texel(const struct ge_texture *t, const struct ge_rstate *s,
+	int x, int y)
+{
+	if (s->tex_clamp_u)
+		x = x < 0? 0 : (x >= t->width? t->width - 1 : x);
+	else
+		x &= t->width - 1;
+	if (s->tex_clamp_v)
+		y = y < 0? 0 : (y >= t->height? t->height - 1 : y);
+	else
+		y &= t->height - 1;
+	return t->data[y * t->width + x];
+}
+
+static uint32_t ge_sample(const struct ge_rstate *s, float u, float v)
+{
+	const struct ge_texture *t = s->tex;
+	float fu = u * t->width, fv = v * t->height;
+	uint32_t c00, c01, c10, c11, out = 0;
+	int x, y, fx, fy, sh;
+
+	if (!s->tex_linear)
+		return ge_texel(t, s, (int)floorf(fu), (int)floorf(fv));
+
+	fu -= 0.5f; fv -= 0.5f;
+	x = (int)floorf(fu); y = (int)floorf(fv);
+	fx = (int)((fu - x) * 256); fy = (int)((fv - y) * 256);
+
+	c00 = ge_texel(t, s, x, y);	c01 = ge_texel(t, s, x + 1, y);
+	c10 = ge_texel(t, s, x, y + 1);	c11 = ge_texel(t, s, x + 1, y + 1);
+
+	for (sh = 0; sh < 32; sh += 8) {
+		int top = ((c00 >> sh) & 0xff) * (256 - fx) +
+		    ((c01 >> sh) & 0xff) * fx;
+		int bot = ((c10 >> sh) & 0xff) * (256 - fx) +
+		    ((c11 >> sh) & 0xff) * fx;
+		out |= (uint32_t)(((top * (256 - fy) + bot * fy) >> 16)
+		    & 0xff) << sh;
+	}
+	return out;
+}
+
+
+/*****************************************************************************
+ *
+ *  Fragments.
+ */
+
+static int ge_compare(int func, int a, int b)
+{
+	switch (func) {
+	case 0:	return 0;
+	case 1:	return 1;
+	case 2:	return a == b;
+	case 3:	return a != b;
+	case 4:	return a < b;
+	case 5:	return a <= b;
+	case 6:	return a > b;
+	default:return a >= b;
+	}
+}
+
+static int ge_stencil_op(int op, int stencil, int ref)
+{
+	switch (op) {
+	case 1:	return 0;
+	case 2:	return ref;
+	case 3:	return (~stencil) & 0xff;
+	case 4:	return stencil < 255? stencil + 1 : 255;
+	case 5:	return stencil > 0? stencil - 1 : 0;
+	default:return stencil;
+	}
+}
+
+static int ge_blend_factor(int f, int fix, int src_a, int dst_a, int other)
+{
+	switch (f) {
+	case 0:	return other;
+	case 1:	return 255 - other;
+	case 2:	return src_a;
+	case 3:	return 255 - src_a;
+	case 4:	return dst_a;
+	case 5:	return 255 - dst_a;
+	case 6:	return 2 * src_a;
+	case 7:	return 255 - 2 * src_a < 0? 0 : 255 - 2 * src_a;
+	case 8:	return 2 * dst_a;
+	case 9:	return 255 - 2 * dst_a < 0? 0 : 255 - 2 * dst_a;
+	default:return fix;
+	}
+}
+
+static uint32_t ge_blend(const struct ge_rstate *s, uint32_t src,
+	uint32_t dst)
+{
+	int src_a = src >> 24, dst_a = dst >> 24, sh;
+	uint32_t out = src & 0xff000000;
+
+	for (sh = 0; sh < 24; sh += 8) {
+		int cs = (src >> sh) & 0xff, cd = (dst >> sh) & 0xff, c;
+		int fa = ge_blend_factor(s->blend_src,
+		    (s->blend_fixa >> sh) & 0xff, src_a, dst_a, cd);
+		int fb = ge_blend_factor(s->blend_dst,
+		    (s->blend_fixb >> sh) & 0xff, src_a, dst_a, cs);
+
+		switch (s->blend_op) {
+		case 1:	c = (cs * fa - cd * fb) / 255; break;
+		case 2:	c = (cd * fb - cs * fa) / 255; break;
+		case 3:	c = cs < cd? cs : cd; break;
+		case 4:	c = cs > cd? cs : cd; break;
+		case 5:	c = cs > cd? cs - cd : cd - cs; break;
+		default:c = (cs * fa + cd * fb) / 255;
+		}
+		out |= (uint32_t)ge_clamp255(c) << sh;
+	}
+	return out;
+}
+
+static uint32_t ge_logicop(int op, uint32_t src, uint32_t dst)
+{
+	switch (op) {
+	case 0:	return 0;
+	case 1:	return src & dst;
+	case 2:	return src & ~dst;
+	case 3:	return src;
+	case 4:	return ~src & dst;
+	case 5:	return dst;
+	case 6:	return src ^ dst;
+	case 7:	return src | dst;
+	case 8:	return ~(src | dst);
+	case 9:	return ~(src ^ dst);
+	case 10:return ~dst;
+	case 11:return src | ~dst;
+	case 12:return ~src;
+	case 13:return ~src | dst;
+	case 14:return ~(src & dst);
+	default:return 0xffffffff;
+	}
+}
+
+/*  The framebuffer's alpha bits hold the stencil value:  */
+static int ge_stencil_of(uint32_t c, int psm)
+{
+	return psm == GE_PSM_5650? 0 : (int)(c >> 24);
+}
+
+/*
+ *  ge_fragment():
+ *
+ *  Runs one fragment through texturing, fog, the tests, blending and the
+ *  write mask. Returns 1 if the color buffer was written.
+ */
+static int ge_fragment(const struct ge_rstate *s, int x, int y,
+	const float *a)
+{
+	int bpp = s->fb_psm == GE_PSM_8888? 4 : 2;
+	unsigned char *fbp = s->fb + (y * s->fb_stride + x) * bpp;
+	unsigned char *zbp = s->zb == NULL? NULL :
+	    s->zb + (y * s->zb_stride + x) * 2;
+	int r, g, b, al, z, stencil, st;
+	uint32_t color, dst;
+
+	z = (int)a[A_Z];
+	z = z < 0? 0 : (z > 65535? 65535 : z);
+	r = ge_clamp255((int)a[A_R]);
+	g = ge_clamp255((int)a[A_G]);
+	b = ge_clamp255((int)a[A_B]);
+	al = ge_clamp255((int)a[A_A]);
+
+	if (s->clear) {
+		int flags = s->clear - 1;
+		dst = ge_get_pixel(fbp, s->fb_psm);
+		color = dst;
+		if (flags & 1)
+			color = (color & 0xff000000) | ge_rgba(r, g, b, 0);
+		if (flags & 2)
+			color = (color & 0xffffff) | ((uint32_t)al << 24);
+		ge_put_pixel(fbp, s->fb_psm, color);
+		if ((flags & 4) && s->zb != NULL) {
+			zbp[0] = z; zbp[1] = z >> 8;
+		}
+		return 1;
+	}
+
+	if (s->tex != NULL) {
+		float w = a[A_W] != 0? 1.0f / a[A_W] : 1.0f;
+		uint32_t t = ge_sample(s, a[A_U] * w, a[A_V] * w);
+		int tr = t & 0xff, tg = (t >> 8) & 0xff, tb = (t >> 16) & 0xff;
+		int ta = s->tex_alpha? (int)(t >> 24) : 255;
+
+		switch (s->tex_func) {
+		case 0:	/*  modulate  */
+			r = r * tr / 255; g = g * tg / 255; b = b * tb / 255;
+			al = al * ta / 255;
+			break;
+		case 1:	/*  decal  */
+			r = (r * (255 - ta) + tr * ta) / 255;
+			g = (g * (255 - ta) + tg * ta) / 255;
+			b = (b * (255 - ta) + tb * ta) / 255;
+			break;
+		case 2:	/*  blend  */
+			r = (r * (255 - tr) + (s->tex_env & 0xff) * tr) / 255;
+			g = (g * (255 - tg) + ((s->tex_env >> 8) & 0xff) * tg)
+			    / 255;
+			b = (b * (255 - tb) + ((s->tex_env >> 16) & 0xff) * tb)
+			    / 255;
+			al = al * ta / 255;
+			break;
+		case 3:	/*  replace  */
+			r = tr; g = tg; b = tb;
+			if (s->tex_alpha)
+				al = ta;
+			break;
+		default:/*  add  */
+			r += tr; g += tg; b += tb;
+			al = al * ta / 255;
+		}
+		if (s->tex_double) {
+			r *= 2; g *= 2; b *= 2;
+		}
+		r = ge_clamp255(r); g = ge_clamp255(g); b = ge_clamp255(b);
+	}
+
+	if (s->fog) {
+		float f = a[A_FOG];
+		f = f < 0? 0 : (f > 1? 1 : f);
+		r = (int)(r * f + (s->fog_color & 0xff) * (1 - f));
+		g = (int)(g * f + ((s->fog_color >> 8) & 0xff) * (1 - f));
+		b = (int)(b * f + ((s->fog_color >> 16) & 0xff) * (1 - f));
+	}
+
+	color = ge_rgba(r, g, b, al);
+
+	if (s->ctest && !ge_compare(s->ctest,
+	    (color & s->cmask) & 0xffffff, (s->cref & s->cmask) & 0xffffff))
+		return 0;
+	if (s->atest && !ge_compare(s->afunc, al & s->amask,
+	    s->aref & s->amask))
+		return 0;
+
+	dst = ge_get_pixel(fbp, s->fb_psm);
+	stencil = st = ge_stencil_of(dst, s->fb_psm);
+
+	if (s->stest && !ge_compare(s->sfunc, s->sref & s->smask,
+	    stencil & s->smask)) {
+		st = ge_stencil_op(s->sfail, stencil, s->sref);
+		ge_put_pixel(fbp, s->fb_psm,
+		    (dst & 0xffffff) | ((uint32_t)st << 24));
+		return 0;
+	}
+
+	if (s->ztest) {
+		int zb = zbp[0] | (zbp[1] << 8);
+		if (!ge_compare(s->zfunc, z, zb)) {
+			if (s->stest) {
+				st = ge_stencil_op(s->szfail, stencil, s->sref);
+				ge_put_pixel(fbp, s->fb_psm, (dst & 0xffffff) |
+				    ((uint32_t)st << 24));
+			}
+			return 0;
+		}
+		if (s->zwrite) {
+			zbp[0] = z; zbp[1] = z >> 8;
+		}
+	}
+	if (s->stest)
+		st = ge_stencil_op(s->szpass, stencil, s->sref);
+
+	if (s->blend)
+		color = ge_blend(s, color, dst);
+	if (s->logicop >= 0)
+		color = ge_logicop(s->logicop, color, dst);
+
+	color = (color & 0xffffff) | ((uint32_t)st << 24);
+	color = (color & ~s->write_mask) | (dst & s->write_mask);
+	ge_put_pixel(fbp, s->fb_psm, color);
+	return 1;
+}
+
+
+/*****************************************************************************
+ *
+ *  Rasterization of binned primitives.
+ */
+
+static int64_t ge_draw_triangle(const struct ge_prim *p,
+	const struct ge_rstate *s, int x1, int y1, int x2, int y2)
+{
+	int64_t pixels = 0;
+	int x, y, k;
+
+	for (y = y1; y <= y2; y++) {
+		int64_t e0 = p->ea[0] * x1 + p->eb[0] * y + p->ec[0];
+		int64_t e1 = p->ea[1] * x1 + p->eb[1] * y + p->ec[1];
+		int64_t e2 = p->ea[2] * x1 + p->eb[2] * y + p->ec[2];
+		float a[GE_NATTR];
+
+		for (k = 0; k < GE_NATTR; k++)
+			a[k] = p->a0[k] + p->dadx[k] * x1 + p->dady[k] * y;
+
+		for (x = x1; x <= x2; x++) {
+			if ((e0 | e1 | e2) >= 0)
+				pixels += ge_fragment(s, x, y, a);
+			e0 += p->ea[0]; e1 += p->ea[1]; e2 += p->ea[2];
+			for (k = 0; k < GE_NATTR; k++)
+				a[k] += p->dadx[k];
+		}
+	}
+	return pixels;
+}
+
+static int64_t ge_draw_sprite(const struct ge_prim *p,
+	const struct ge_rstate *s, int x1, int y1, int x2, int y2)
+{
+	const struct ge_rvert *v0 = &p->v[0], *v1 = &p->v[1];
+	float dx = v1->x - v0->x, dy = v1->y - v0->y;
+	float dudx = dx != 0? (v1->a[A_U] - v0->a[A_U]) / dx : 0;
+	float dvdy = dy != 0? (v1->a[A_V] - v0->a[A_V]) / dy : 0;
+	int64_t pixels = 0;
+	float a[GE_NATTR];
+	int x, y;
+
+	memcpy(a, v1->a, sizeof(a));
+	a[A_W] = 1;
+	for (y = y1; y <= y2; y++) {
+		a[A_V] = v0->a[A_V] + (y + 0.5f - v0->y) * dvdy;
+		for (x = x1; x <= x2; x++) {
+			a[A_U] = v0->a[A_U] + (x + 0.5f - v0->x) * dudx;
+			pixels += ge_fragment(s, x, y, a);
+		}
+	}
+	return pixels;
+}
+
+static int64_t ge_draw_line(const struct ge_prim *p,
+	const struct ge_rstate *s, int x1, int y1, int x2, int y2)
+{
+	const struct ge_rvert *v0 = &p->v[0], *v1 = &p->v[1];
+	float dx = v1->x - v0->x, dy = v1->y - v0->y;
+	int steps = (int)ceilf(fabsf(dx) > fabsf(dy)? fabsf(dx) : fabsf(dy));
+	int64_t pixels = 0;
+	int i, k;
+
+	if (p->type == GE_RPRIM_POINT)
+		steps = 0;
+
+	for (i = 0; i <= steps; i++) {
+		float t = steps? (float)i / steps : 0, a[GE_NATTR];
+		int x = (int)floorf(v0->x + dx * t);
+		int y = (int)floorf(v0->y + dy * t);
+
+		if (steps && i == steps)
+			break;
+		if (x < x1 || x > x2 || y < y1 || y > y2)
+			continue;
+		for (k = 0; k < GE_NATTR; k++)
+			a[k] = v0->a[k] + (v1->a[k] - v0->a[k]) * t;
+		if (s->flat) {
+			a[A_R] = v1->a[A_R]; a[A_G] = v1->a[A_G];
+			a[A_B] = v1->a[A_B]; a[A_A] = v1->a[A_A];
+		}
+		pixels += ge_fragment(s, x, y, a);
+	}
+	return pixels;
+}
+
+/*  Draw all primitives binned to one tile, in order:  */
+static int64_t ge_draw_tile(struct psp_ge_data *d, int tile)
+{
+	struct ge_bin *bin = &d->bins[tile];
+	int tx1 = (tile % GE_TILES_X) << GE_TILE_SHIFT;
+	int ty1 = (tile / GE_TILES_X) << GE_TILE_SHIFT;
+	int tx2 = tx1 + GE_TILE_SIZE - 1, ty2 = ty1 + GE_TILE_SIZE - 1;
+	int64_t pixels = 0;
+	int i;
+
+	for (i = 0; i < bin->n; i++) {
+		const struct ge_prim *p = &d->prims[bin->prims[i]];
+		const struct ge_rstate *s = &d->states[p->state];
+		int x1 = p->x1 > tx1? p->x1 : tx1, x2 = p->x2 < tx2? p->x2 : tx2;
+		int y1 = p->y1 > ty1? p->y1 : ty1, y2 = p->y2 < ty2? p->y2 : ty2;
+
+		if (x1 > x2 || y1 > y2)
+			continue;
+
+		switch (p->type) {
+		case GE_RPRIM_TRIANGLE:
+			pixels += ge_draw_triangle(p, s, x1, y1, x2, y2);
+			break;
+		case GE_RPRIM_SPRITE:
+			pixels += ge_draw_sprite(p, s, x1, y1, x2, y2);
+			break;
+		default:
+			pixels += ge_draw_line(p, s, x1, y1, x2, y2);
+		}
+	}
+	return pixels;
+}
+
+#ifdef HAVE_PTHREADS
+/*  Draw tiles until there are none left. Called with work_lock held.  */
+static int64_t ge_draw_tiles(struct psp_ge_data *d)
+{
+	int64_t pixels = 0;
+
+	while (d->next_tile < d->nactive) {
+		int tile = d->active[d->next_tile ++];
+		pthread_mutex_unlock(&d->work_lock);
+		pixels += ge_draw_tile(d, tile);
+		pthread_mutex_lock(&d->work_lock);
+	}
+	return pixels;
+}
+
+static void *ge_worker(void *arg)
+{
+	struct psp_ge_data *d = arg;
+	int serial = 0;
+
+	pthread_mutex_lock(&d->work_lock);
+	for (;;) {
+		while (d->work_serial == serial)
+			pthread_cond_wait(&d->work_cond, &d->work_lock);
+		serial = d->work_serial;
+
+		d->batch_pixels += ge_draw_tiles(d);
+
+		if (-- d->workers_busy == 0)
+			pthread_cond_signal(&d->done_cond);
+	}
+	return NULL;
+}
+#endif
+
+/*
+ *  ge_flush():
+ *
+ *  Rasterizes the current batch, and starts a new one.
+ */
+static void ge_flush(struct psp_ge_data *d)
+{
+	int i;
+
+	if (d->nprims == 0)
+		return;
+
+	d->nactive = 0;
+	for (i = 0; i < GE_TILES_X * GE_TILES_Y; i++)
+		if (d->bins[i].n > 0)
+			d->active[d->nactive ++] = i;
+
+	d->batch_pixels = 0;
+#ifdef HAVE_PTHREADS
+	if (d->nthreads > 1 && d->nactive > 1) {
+		pthread_mutex_lock(&d->work_lock);
+		d->next_tile = 0;
+		d->workers_busy = d->nthreads - 1;
+		d->work_serial ++;
+		pthread_cond_broadcast(&d->work_cond);
+		d->batch_pixels += ge_draw_tiles(d);
+		while (d->workers_busy > 0)
+			pthread_cond_wait(&d->done_cond, &d->work_lock);
+		pthread_mutex_unlock(&d->work_lock);
+	} else
+#endif
+		for (i = 0; i < d->nactive; i++)
+			d->batch_pixels += ge_draw_tile(d, d->active[i]);
+
+	if (d->cur != NULL)
+		d->cur->npixels += d->batch_pixels;
+
+	for (i = 0; i < d->nactive; i++)
+		d->bins[d->active[i]].n = 0;
+	d->nprims = 0;
+	d->nstates = 0;
+	d->rstate_dirty = 1;
+	d->batch ++;
+	d->vram_epoch ++;
+
+	/*  Let the framebuffer device redraw the screen:  */
+	if (d->fb != NULL && d->batch_pixels > 0) {
+		d->fb->update_x1 = d->fb->update_y1 = 0;
+		d->fb->update_x2 = d->fb->xsize - 1;
+		d->fb->update_y2 = d->fb->ysize - 1;
+	}
+}
+
+
+/*****************************************************************************
+ *
+ *  Primitive setup and binning.
+ */
+
+/*
+ *  ge_rstate():
+ *
+ *  Returns the index of the per-pixel state for the next primitive, making
+ *  a new snapshot if any state has changed.
+ */
+static int ge_rstate(struct psp_ge_data *d)
+{
+	struct ge_rstate *s;
+	struct ge_texture *tex = NULL;
+	uint32_t *c = d->cmd, fb_ofs, zb_ofs;
+	int bpp, max_y;
+
+	if (!d->rstate_dirty && d->nstates > 0)
+		return d->nstates - 1;
+
+	/*  (This may flush the batch, so it has to be done first.)  */
+	if (!(c[GE_CMD_CLEAR_MODE] & 1) && (c[GE_CMD_TEXTURE_ENABLE] & 1))
+		tex = ge_texture(d);
+
+	if (d->nstates >= d->max_states) {
+		d->max_states = d->max_states? d->max_states * 2 : 64;
+		d->states = realloc(d->states,
+		    sizeof(struct ge_rstate) * d->max_states);
+		if (d->states == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	s = &d->states[d->nstates];
+	memset(s, 0, sizeof(struct ge_rstate));
+
+	s->fb_psm = c[GE_CMD_FB_FORMAT] & 3;
+	s->fb_stride = c[GE_CMD_FB_WIDTH] & 0x7ff;
+	fb_ofs = c[GE_CMD_FB_PTR] & 0x1ffff0;
+	zb_ofs = c[GE_CMD_Z_PTR] & 0x1ffff0;
+	s->zb_stride = c[GE_CMD_Z_WIDTH] & 0x7ff;
+	s->fb = d->vram + fb_ofs;
+	s->zb = d->vram + zb_ofs;
+
+	s->x1 = c[GE_CMD_SCISSOR1] & 0x3ff;
+	s->y1 = (c[GE_CMD_SCISSOR1] >> 10) & 0x3ff;
+	s->x2 = c[GE_CMD_SCISSOR2] & 0x3ff;
+	s->y2 = (c[GE_CMD_SCISSOR2] >> 10) & 0x3ff;
+
+	/*  Keep all pixels (and depth values) inside VRAM:  */
+	bpp = s->fb_psm == GE_PSM_8888? 4 : 2;
+	if (s->x2 >= s->fb_stride)
+		s->x2 = s->fb_stride - 1;
+	max_y = s->fb_stride == 0? -1 : (int)((d->vram_size - fb_ofs) /
+	    (s->fb_stride * bpp)) - 1;
+	if (s->y2 > max_y)
+		s->y2 = max_y;
+
+	if (c[GE_CMD_CLEAR_MODE] & 1)
+		s->clear = ((c[GE_CMD_CLEAR_MODE] >> 8) & 7) + 1;
+
+	if (s->clear? ((s->clear - 1) & 4) : (c[GE_CMD_ZTEST_ENABLE] & 1)) {
+		if (s->x2 >= s->zb_stride)
+			s->x2 = s->zb_stride - 1;
+		max_y = s->zb_stride == 0? -1 : (int)((d->vram_size - zb_ofs)
+		    / (s->zb_stride * 2)) - 1;
+		if (s->y2 > max_y)
+			s->y2 = max_y;
+	} else
+		s->zb = NULL;
+
+	s->flat = !(c[GE_CMD_SHADE] & 1);
+
+	if (tex != NULL) {
+		s->tex = tex;
+		s->tex_clamp_u = c[GE_CMD_TEX_WRAP] & 1;
+		s->tex_clamp_v = (c[GE_CMD_TEX_WRAP] >> 8) & 1;
+		s->tex_linear = (c[GE_CMD_TEX_FILTER] >> 8) & 1;
+		s->tex_func = c[GE_CMD_TEX_FUNC] & 7;
+		s->tex_alpha = (c[GE_CMD_TEX_FUNC] >> 8) & 1;
+		s->tex_double = (c[GE_CMD_TEX_FUNC] >> 16) & 1;
+		s->tex_env = c[GE_CMD_TEX_ENV_COLOR];
+	}
+
+	if (!s->clear) {
+		s->fog = (c[GE_CMD_FOG_ENABLE] & 1) &&
+		    !(c[GE_CMD_VTYPE] & (1 << 23));
+		s->fog_color = c[GE_CMD_FOG_COLOR];
+
+		if (c[GE_CMD_CTEST_ENABLE] & 1)
+			s->ctest = c[GE_CMD_CTEST] & 3;
+		s->cref = c[GE_CMD_CREF];
+		s->cmask = c[GE_CMD_CMASK];
+
+		s->atest = c[GE_CMD_ATEST_ENABLE] & 1;
+		s->afunc = c[GE_CMD_ATEST] & 7;
+		s->aref = (c[GE_CMD_ATEST] >> 8) & 0xff;
+		s->amask = (c[GE_CMD_ATEST] >> 16) & 0xff;
+
+		s->stest = (c[GE_CMD_STEST_ENABLE] & 1) &&
+		    s->fb_psm != GE_PSM_5650;
+		s->sfunc = c[GE_CMD_STEST] & 7;
+		s->sref = (c[GE_CMD_STEST] >> 8) & 0xff;
+		s->smask = (c[GE_CMD_STEST] >> 16) & 0xff;
+		s->sfail = c[GE_CMD_SOP] & 7;
+		s->szfail = (c[GE_CMD_SOP] >> 8) & 7;
+		s->szpass = (c[GE_CMD_SOP] >> 16) & 7;
+
+		s->ztest = c[GE_CMD_ZTEST_ENABLE] & 1;
+		s->zfunc = c[GE_CMD_ZTEST] & 7;
+		s->zwrite = !(c[GE_CMD_ZWRITE_DISABLE] & 1);
+
+		s->blend = c[GE_CMD_BLEND_ENABLE] & 1;
+		s->blend_src = c[GE_CMD_BLEND] & 0xf;
+		s->blend_dst = (c[GE_CMD_BLEND] >> 4) & 0xf;
+		s->blend_op = (c[GE_CMD_BLEND] >> 8) & 7;
+		s->blend_fixa = c[GE_CMD_BLEND_FIXA];
+		s->blend_fixb = c[GE_CMD_BLEND_FIXB];
+
+		s->logicop = (c[GE_CMD_LOGICOP_ENABLE] & 1)?
+		    (int)(c[GE_CMD_LOGICOP] & 0xf) : -1;
+		s->write_mask = (c[GE_CMD_MASK_RGB] & 0xffffff) |
+		    ((c[GE_CMD_MASK_ALPHA] & 0xff) << 24);
+	}
+
+	d->rstate_dirty = 0;
+	return d->nstates ++;
+}
+
+/*  Returns a new primitive, with the current per-pixel state:  */
+static struct ge_prim *ge_new_prim(struct psp_ge_data *d)
+{
+	int state;
+
+	if (d->nprims >= GE_MAX_BATCH_PRIMS)
+		ge_flush(d);
+	state = ge_rstate(d);
+
+	if (d->nprims >= d->max_prims) {
+		d->max_prims = d->max_prims? d->max_prims * 2 : 256;
+		d->prims = realloc(d->prims,
+		    sizeof(struct ge_prim) * d->max_prims);
+		if (d->prims == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	d->prims[d->nprims].state = state;
+	return &d->prims[d->nprims];
+}
+
+/*  Clip the bounding box against the scissor, and bin the primitive:  */
+static void ge_bin_prim(struct psp_ge_data *d, struct ge_prim *p)
+{
+	const struct ge_rstate *s = &d->states[p->state];
+	int tx, ty, n = d->nprims;
+
+	if (p->x1 < s->x1)	p->x1 = s->x1;
+	if (p->y1 < s->y1)	p->y1 = s->y1;
+	if (p->x2 > s->x2)	p->x2 = s->x2;
+	if (p->y2 > s->y2)	p->y2 = s->y2;
+	if (p->x1 > p->x2 || p->y1 > p->y2)
+		return;
+
+	for (ty = p->y1 >> GE_TILE_SHIFT; ty <= p->y2 >> GE_TILE_SHIFT; ty++)
+		for (tx = p->x1 >> GE_TILE_SHIFT;
+		    tx <= p->x2 >> GE_TILE_SHIFT; tx++) {
+			struct ge_bin *bin = &d->bins[ty * GE_TILES_X + tx];
+			if (bin->n >= bin->max) {
+				bin->max = bin->max? bin->max * 2 : 64;
+				bin->prims = realloc(bin->prims,
+				    sizeof(int) * bin->max);
+				if (bin->prims == NULL) {
+					fprintf(stderr, "out of memory\n");
+					exit(1);
+				}
+			}
+			bin->prims[bin->n ++] = n;
+		}
+
+	d->nprims ++;
+}
+
+static int ge_fixed(float x)
+{
+	return (int)floorf(x * 16.0f + 0.5f);
+}
+
+static void ge_setup_triangle(struct psp_ge_data *d, struct ge_rvert *v0,
+	struct ge_rvert *v1, struct ge_rvert *v2, int cull)
+{
+	struct ge_rvert *v[3];
+	struct ge_prim *p;
+	int64_t X[3], Y[3], area;
+	float det, fx[3], fy[3];
+	int i, k;
+
+	v[0] = v0; v[1] = v1; v[2] = v2;
+	for (i = 0; i < 3; i++) {
+		if (fabsf(v[i]->x) > 8192 || fabsf(v[i]->y) > 8192)
+			return;
+		X[i] = ge_fixed(v[i]->x);
+		Y[i] = ge_fixed(v[i]->y);
+	}
+
+	area = (X[1] - X[0]) * (Y[2] - Y[0]) - (Y[1] - Y[0]) * (X[2] - X[0]);
+	if (area == 0)
+		return;
+	if ((cull > 0 && area < 0) || (cull < 0 && area > 0))
+		return;
+
+	p = ge_new_prim(d);
+	p->type = GE_RPRIM_TRIANGLE;
+
+	/*  Flat shading uses the last vertex's color:  */
+	if (d->states[p->state].flat)
+		for (k = A_R; k <= A_A; k++)
+			v[0]->a[k] = v[1]->a[k] = v[2]->a[k];
+
+	if (area < 0) {
+		struct ge_rvert *tmp = v[1];
+		int64_t t;
+		v[1] = v[2]; v[2] = tmp;
+		t = X[1]; X[1] = X[2]; X[2] = t;
+		t = Y[1]; Y[1] = Y[2]; Y[2] = t;
+	}
+
+	/*  Edge i is opposite vertex i, and >= 0 inside (top-left rule):  */
+	for (i = 0; i < 3; i++) {
+		int a = (i + 1) % 3, b = (i + 2) % 3;
+		int64_t dx = X[b] - X[a], dy = Y[b] - Y[a];
+
+		p->ea[i] = -dy * 16;
+		p->eb[i] = dx * 16;
+		p->ec[i] = dx * (8 - Y[a]) - dy * (8 - X[a]);
+		if (!(dy < 0 || (dy == 0 && dx > 0)))
+			p->ec[i] --;
+	}
+
+	p->x1 = (int)(X[0] < X[1]? (X[0] < X[2]? X[0] : X[2]) :
+	    (X[1] < X[2]? X[1] : X[2])) >> 4;
+	p->x2 = (int)(X[0] > X[1]? (X[0] > X[2]? X[0] : X[2]) :
+	    (X[1] > X[2]? X[1] : X[2])) >> 4;
+	p->y1 = (int)(Y[0] < Y[1]? (Y[0] < Y[2]? Y[0] : Y[2]) :
+	    (Y[1] < Y[2]? Y[1] : Y[2])) >> 4;
+	p->y2 = (int)(Y[0] > Y[1]? (Y[0] > Y[2]? Y[0] : Y[2]) :
+	    (Y[1] > Y[2]? Y[1] : Y[2])) >> 4;
+
+	/*  Attribute planes, evaluated at pixel centers:  */
+	for (i = 0; i < 3; i++) {
+		fx[i] = X[i] / 16.0f;
+		fy[i] = Y[i] / 16.0f;
+	}
+	det = (fx[1] - fx[0]) * (fy[2] - fy[0]) -
+	    (fx[2] - fx[0]) * (fy[1] - fy[0]);
+	for (k = 0; k < GE_NATTR; k++) {
+		float a0 = v[0]->a[k], d1 = v[1]->a[k] - a0,
+		    d2 = v[2]->a[k] - a0;
+		p->dadx[k] = (d1 * (fy[2] - fy[0]) - d2 * (fy[1] - fy[0]))
+		    / det;
+		p->dady[k] = (d2 * (fx[1] - fx[0]) - d1 * (fx[2] - fx[0]))
+		    / det;
+		p->a0[k] = a0 + p->dadx[k] * (0.5f - fx[0]) +
+		    p->dady[k] * (0.5f - fy[0]);
+	}
+
+	ge_bin_prim(d, p);
+}
+
+static void ge_setup_sprite(struct psp_ge_data *d, struct ge_rvert *v0,
+	struct ge_rvert *v1)
+{
+	struct ge_prim *p;
+	int X0 = ge_fixed(v0->x), X1 = ge_fixed(v1->x);
+	int Y0 = ge_fixed(v0->y), Y1 = ge_fixed(v1->y);
+	int xmin = X0 < X1? X0 : X1, xmax = X0 < X1? X1 : X0;
+	int ymin = Y0 < Y1? Y0 : Y1, ymax = Y0 < Y1? Y1 : Y0;
+
+	p = ge_new_prim(d);
+	p->type = GE_RPRIM_SPRITE;
+	p->v[0] = *v0;
+	p->v[1] = *v1;
+
+	/*  Pixels whose centers are inside [min, max):  */
+	p->x1 = (xmin + 7) >> 4;	p->x2 = ((xmax + 7) >> 4) - 1;
+	p->y1 = (ymin + 7) >> 4;	p->y2 = ((ymax + 7) >> 4) - 1;
+
+	ge_bin_prim(d, p);
+}
+
+static void ge_setup_line(struct psp_ge_data *d, struct ge_rvert *v0,
+	struct ge_rvert *v1, int point)
+{
+	struct ge_prim *p = ge_new_prim(d);
+
+	p->type = point? GE_RPRIM_POINT : GE_RPRIM_LINE;
+	p->v[0] = *v0;
+	p->v[1] = *v1;
+	p->x1 = (int)floorf(v0->x < v1->x? v0->x : v1->x);
+	p->x2 = (int)floorf(v0->x < v1->x? v1->x : v0->x);
+	p->y1 = (int)floorf(v0->y < v1->y? v0->y : v1->y);
+	p->y2 = (int)floorf(v0->y < v1->y? v1->y : v0->y);
+
+	ge_bin_prim(d, p);
+}
+
+
+/*****************************************************************************
+ *
+ *  The vertex pipeline.
+ */
+
+struct ge_vfmt {
+	int		tc, col, nrm, pos, weight, idx;
+	int		nweights, nmorph, through;
+	int		tc_off, col_off, nrm_off, pos_off, weight_off;
+	int		size;
+};
+
+/*  Decoded input vertex:  */
+struct ge_invert {
+	float		pos[3], nrm[3], uv[2], color[4], w[8];
+};
+
+static int ge_align(int x, int a)
+{
+	return (x + a - 1) & ~(a - 1);
+}
+
+static void ge_vertex_format(uint32_t vtype, struct ge_vfmt *f)
+{
+	static const int esize[4] = { 0, 1, 2, 4 };
+	int size = 0, biggest = 1, e;
+
+	memset(f, 0, sizeof(struct ge_vfmt));
+	f->tc = vtype & 3;
+	f->col = (vtype >> 2) & 7;
+	f->nrm = (vtype >> 5) & 3;
+	f->pos = (vtype >> 7) & 3;
+	f->weight = (vtype >> 9) & 3;
+	f->idx = (vtype >> 11) & 3;
+	f->nweights = ((vtype >> 14) & 7) + 1;
+	f->nmorph = ((vtype >> 18) & 7) + 1;
+	f->through = (vtype >> 23) & 1;
+
+	if (f->weight) {
+		e = esize[f->weight];
+		size = ge_align(size, e);
+		f->weight_off = size;
+		size += e * f->nweights;
+		if (e > biggest) biggest = e;
+	}
+	if (f->tc) {
+		e = esize[f->tc];
+		size = ge_align(size, e);
+		f->tc_off = size;
+		size += e * 2;
+		if (e > biggest) biggest = e;
+	}
+	if (f->col >= 4) {
+		e = f->col == 7? 4 : 2;
+		size = ge_align(size, e);
+		f->col_off = size;
+		size += e;
+		if (e > biggest) biggest = e;
+	} else
+		f->col = 0;
+	if (f->nrm) {
+		e = esize[f->nrm];
+		size = ge_align(size, e);
+		f->nrm_off = size;
+		size += e * 3;
+		if (e > biggest) biggest = e;
+	}
+	if (f->pos) {
+		e = esize[f->pos];
+		size = ge_align(size, e);
+		f->pos_off = size;
+		size += e * 3;
+		if (e > biggest) biggest = e;
+	}
+	f->size = ge_align(size, biggest);
+}
+
+/*  Read one component. scale is used for the integer formats.  */
+static float ge_component(const unsigned char *p, int type, int is_signed,
+	float scale)
+{
+	union {
+		uint32_t	i;
+		float		f;
+	} u;
+
+	switch (type) {
+	case 1:
+		return (is_signed? (float)(int8_t)p[0] : (float)p[0]) * scale;
+	case 2:
+		return (is_signed? (float)(int16_t)(p[0] | (p[1] << 8)) :
+		    (float)(p[0] | (p[1] << 8))) * scale;
+	default:
+		u.i = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+		return u.f;
+	}
+}
+
+static void ge_decode_one(const struct ge_vfmt *f, const unsigned char *p,
+	float weight, struct ge_invert *v)
+{
+	static const int esize[4] = { 0, 1, 2, 4 };
+	static const float sscale[4] = { 0, 1/128.0f, 1/32768.0f, 1 };
+	int i;
+
+	for (i = 0; f->weight && i < f->nweights; i++)
+		v->w[i] += weight * ge_component(p + f->weight_off +
+		    i * esize[f->weight], f->weight, 0, f->weight == 1?
+		    1/128.0f : 1/32768.0f);
+
+	for (i = 0; f->tc && i < 2; i++)
+		v->uv[i] += weight * ge_component(p + f->tc_off +
+		    i * esize[f->tc], f->tc, 0, f->through? 1 :
+		    (f->tc == 1? 1/128.0f : 1/32768.0f));
+
+	if (f->col) {
+		const unsigned char *c = p + f->col_off;
+		uint32_t rgba;
+		if (f->col == 7)
+			rgba = c[0] | (c[1] << 8) | (c[2] << 16) |
+			    ((uint32_t)c[3] << 24);
+		else
+			rgba = ge_from_16(c[0] | (c[1] << 8), f->col - 4);
+		for (i = 0; i < 4; i++)
+			v->color[i] += weight * ((rgba >> (8 * i)) & 0xff);
+	}
+
+	for (i = 0; f->nrm && i < 3; i++)
+		v->nrm[i] += weight * ge_component(p + f->nrm_off +
+		    i * esize[f->nrm], f->nrm, 1, sscale[f->nrm]);
+
+	for (i = 0; f->pos && i < 3; i++) {
+		/*  In through mode, 16-bit z is unsigned, and nothing is
+		    scaled:  */
+		int is_signed = !(f->through && i == 2);
+		v->pos[i] += weight * ge_component(p + f->pos_off +
+		    i * esize[f->pos], f->pos, is_signed, f->through? 1 :
+		    sscale[f->pos]);
+	}
+}
+
+/*  Decode a (possibly morphed) vertex:  */
+static void ge_decode_vertex(struct psp_ge_data *d, const struct ge_vfmt *f,
+	uint32_t addr, struct ge_invert *v)
+{
+	unsigned char buf[8 * 64];
+	int i, stride = f->size * f->nmorph;
+
+	memset(v, 0, sizeof(struct ge_invert));
+	if (stride > (int)sizeof(buf))
+		stride = sizeof(buf);
+	ge_read(d, addr, buf, stride);
+
+	for (i = 0; i < f->nmorph; i++)
+		ge_decode_one(f, buf + i * f->size, f->nmorph == 1? 1.0f :
+		    ge_float(d->cmd[GE_CMD_MORPH_WEIGHT0 + i]), v);
+}
+
+static void ge_mul43(const float *m, const float *v, float w, float *out)
+{
+	out[0] = v[0] * m[0] + v[1] * m[3] + v[2] * m[6] + w * m[9];
+	out[1] = v[0] * m[1] + v[1] * m[4] + v[2] * m[7] + w * m[10];
+	out[2] = v[0] * m[2] + v[1] * m[5] + v[2] * m[8] + w * m[11];
+}
+
+static void ge_color_of(uint32_t rgb, uint32_t alpha, float *c)
+{
+	c[0] = rgb & 0xff;
+	c[1] = (rgb >> 8) & 0xff;
+	c[2] = (rgb >> 16) & 0xff;
+	c[3] = alpha & 0xff;
+}
+
+static void ge_normalize(float *v)
+{
+	float l = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if (l > 0) {
+		v[0] /= l; v[1] /= l; v[2] /= l;
+	}
+}
+
+/*  Vertex lighting, in world space:  */
+static void ge_light(struct psp_ge_data *d, const float *pos,
+	const float *nrm, const float *vcolor, float *out)
+{
+	uint32_t *c = d->cmd, upd = c[GE_CMD_MATERIAL_UPDATE];
+	float mamb[4], mdif[4], mspec[4], amb[4], n[3];
+	float specpow = ge_float(c[GE_CMD_MATERIAL_SPECCOEF]);
+	int i, l;
+
+	ge_color_of(c[GE_CMD_MATERIAL_AMBIENT], c[GE_CMD_MATERIAL_ALPHA],
+	    mamb);
+	ge_color_of(c[GE_CMD_MATERIAL_DIFFUSE], 255, mdif);
+	ge_color_of(c[GE_CMD_MATERIAL_SPECULAR], 255, mspec);
+	if (upd & 1)
+		memcpy(mamb, vcolor, sizeof(mamb));
+	if (upd & 2)
+		memcpy(mdif, vcolor, sizeof(mdif));
+	if (upd & 4)
+		memcpy(mspec, vcolor, sizeof(mspec));
+
+	ge_color_of(c[GE_CMD_AMBIENT_COLOR], c[GE_CMD_AMBIENT_ALPHA], amb);
+	ge_color_of(c[GE_CMD_MATERIAL_EMISSIVE], 0, out);
+	for (i = 0; i < 3; i++)
+		out[i] += amb[i] * mamb[i] / 255;
+	out[3] = amb[3] * mamb[3] / 255;
+
+	memcpy(n, nrm, sizeof(n));
+	if (c[GE_CMD_REVERSE_NORMAL] & 1) {
+		n[0] = -n[0]; n[1] = -n[1]; n[2] = -n[2];
+	}
+	ge_normalize(n);
+
+	for (l = 0; l < 4; l++) {
+		uint32_t type = c[GE_CMD_LIGHT_TYPE0 + l];
+		int kind = type & 3, ltype = (type >> 8) & 3;
+		float L[3], lamb[4], ldif[4], lspec[4], att = 1, ndotl;
+
+		if (!(c[GE_CMD_LIGHT_ENABLE0 + l] & 1))
+			continue;
+
+		for (i = 0; i < 3; i++)
+			L[i] = ge_float(c[GE_CMD_LIGHT_POS0 + 3*l + i]);
+		if (ltype != 0) {
+			float dist;
+			for (i = 0; i < 3; i++)
+				L[i] -= pos[i];
+			dist = sqrtf(L[0]*L[0] + L[1]*L[1] + L[2]*L[2]);
+			att = ge_float(c[GE_CMD_LIGHT_ATT0 + 3*l]) +
+			    ge_float(c[GE_CMD_LIGHT_ATT0 + 3*l + 1]) * dist +
+			    ge_float(c[GE_CMD_LIGHT_ATT0 + 3*l + 2]) *
+			    dist * dist;
+			att = att > 0? 1.0f / att : 1;
+			if (att > 1)
+				att = 1;
+		}
+		ge_normalize(L);
+
+		if (ltype == 2) {
+			float dir[3], cosang;
+			for (i = 0; i < 3; i++)
+				dir[i] = ge_float(c[GE_CMD_LIGHT_DIR0 + 3*l+i]);
+			ge_normalize(dir);
+			cosang = -(L[0]*dir[0] + L[1]*dir[1] + L[2]*dir[2]);
+			if (cosang < ge_float(c[GE_CMD_LIGHT_CUTOFF0 + l]))
+				att = 0;
+			else
+				att *= powf(cosang,
+				    ge_float(c[GE_CMD_LIGHT_EXP0 + l]));
+		}
+
+		ge_color_of(c[GE_CMD_LIGHT_COLOR0 + 3*l], 0, lamb);
+		ge_color_of(c[GE_CMD_LIGHT_COLOR0 + 3*l + 1], 0, ldif);
+		ge_color_of(c[GE_CMD_LIGHT_COLOR0 + 3*l + 2], 0, lspec);
+
+		ndotl = n[0] * L[0] + n[1] * L[1] + n[2] * L[2];
+		if (ndotl < 0)
+			ndotl = 0;
+		if (kind == 2)
+			ndotl = powf(ndotl, specpow);
+
+		for (i = 0; i < 3; i++)
+			out[i] += att * (lamb[i] * mamb[i] +
+			    ldif[i] * mdif[i] * ndotl) / 255;
+
+		if (kind == 1 && ndotl > 0) {
+			float h[3], ndoth;
+			h[0] = L[0]; h[1] = L[1]; h[2] = L[2] + 1;
+			ge_normalize(h);
+			ndoth = n[0] * h[0] + n[1] * h[1] + n[2] * h[2];
+			if (ndoth > 0) {
+				float sp = powf(ndoth, specpow);
+				for (i = 0; i < 3; i++)
+					out[i] += att * lspec[i] * mspec[i] *
+					    sp / 255;
+			}
+		}
+	}
+}
+
+/*
+ *  ge_transform():
+ *
+ *  Runs a decoded vertex through skinning, the world, view and projection
+ *  matrices, lighting, texture coordinate generation and fog.
+ */
+static void ge_transform(struct psp_ge_data *d, const struct ge_vfmt *f,
+	struct ge_invert *in, struct ge_xvert *out)
+{
+	uint32_t *c = d->cmd;
+	float pos[3], nrm[3], wpos[3], wnrm[3], vpos[3], color[4];
+	int i, j;
+
+	if (f->col)
+		memcpy(color, in->color, sizeof(color));
+	else
+		ge_color_of(c[GE_CMD_MATERIAL_AMBIENT],
+		    c[GE_CMD_MATERIAL_ALPHA], color);
+
+	if (f->through) {
+		for (i = 0; i < 3; i++)
+			out->clip[i] = in->pos[i];
+		out->clip[3] = 1;
+		out->uv[0] = in->uv[0];
+		out->uv[1] = in->uv[1];
+		memcpy(out->color, color, sizeof(color));
+		out->fog = 1;
+		return;
+	}
+
+	/*  Skinning:  */
+	if (f->weight) {
+		memset(pos, 0, sizeof(pos));
+		memset(nrm, 0, sizeof(nrm));
+		for (i = 0; i < f->nweights; i++) {
+			float tp[3], tn[3];
+			if (in->w[i] == 0)
+				continue;
+			ge_mul43(&d->bone[i * 12], in->pos, 1, tp);
+			ge_mul43(&d->bone[i * 12], in->nrm, 0, tn);
+			for (j = 0; j < 3; j++) {
+				pos[j] += tp[j] * in->w[i];
+				nrm[j] += tn[j] * in->w[i];
+			}
+		}
+	} else {
+		memcpy(pos, in->pos, sizeof(pos));
+		memcpy(nrm, in->nrm, sizeof(nrm));
+	}
+
+	ge_mul43(d->world, pos, 1, wpos);
+	ge_mul43(d->world, nrm, 0, wnrm);
+	ge_mul43(d->view, wpos, 1, vpos);
+	for (j = 0; j < 4; j++)
+		out->clip[j] = vpos[0] * d->proj[j] + vpos[1] * d->proj[4+j] +
+		    vpos[2] * d->proj[8 + j] + d->proj[12 + j];
+
+	if (c[GE_CMD_LIGHTING_ENABLE] & 1)
+		ge_light(d, wpos, wnrm, color, out->color);
+	else
+		memcpy(out->color, color, sizeof(color));
+
+	/*  Texture coordinates:  */
+	switch (c[GE_CMD_TEX_MAP_MODE] & 3) {
+	case 1: {
+		float src[3], uvw[3];
+		switch ((c[GE_CMD_TEX_MAP_MODE] >> 8) & 3) {
+		case 0:	memcpy(src, pos, sizeof(src)); break;
+		case 1:	src[0] = in->uv[0]; src[1] = in->uv[1]; src[2] = 0;
+			break;
+		case 2:	memcpy(src, nrm, sizeof(src)); ge_normalize(src);
+			break;
+		default:memcpy(src, nrm, sizeof(src));
+		}
+		ge_mul43(d->tgen, src, 1, uvw);
+		if (uvw[2] == 0)
+			uvw[2] = 1;
+		out->uv[0] = uvw[0] / uvw[2];
+		out->uv[1] = uvw[1] / uvw[2];
+		break;
+		}
+	case 2: {
+		int ls;
+		float n[3];
+		memcpy(n, wnrm, sizeof(n));
+		ge_normalize(n);
+		for (i = 0; i < 2; i++) {
+			float L[3];
+			ls = (c[GE_CMD_TEX_SHADE_LS] >> (8 * i)) & 3;
+			for (j = 0; j < 3; j++)
+				L[j] = ge_float(c[GE_CMD_LIGHT_POS0 + 3*ls+j]);
+			ge_normalize(L);
+			out->uv[i] = (1 + n[0]*L[0] + n[1]*L[1] + n[2]*L[2])
+			    / 2;
+		}
+		break;
+		}
+	default:
+		out->uv[0] = in->uv[0] * ge_float(c[GE_CMD_TEX_SCALE_U]) +
+		    ge_float(c[GE_CMD_TEX_OFFSET_U]);
+		out->uv[1] = in->uv[1] * ge_float(c[GE_CMD_TEX_SCALE_V]) +
+		    ge_float(c[GE_CMD_TEX_OFFSET_V]);
+	}
+
+	out->fog = (ge_float(c[GE_CMD_FOG1]) + vpos[2]) *
+	    ge_float(c[GE_CMD_FOG2]);
+}
+
+/*  Clip space to screen space:  */
+static void ge_project(struct psp_ge_data *d, const struct ge_xvert *x,
+	int through, struct ge_rvert *r)
+{
+	uint32_t *c = d->cmd;
+	float invw = 1, z;
+	int k;
+
+	if (through) {
+		r->x = x->clip[0];
+		r->y = x->clip[1];
+		z = x->clip[2];
+		if (c[GE_CMD_TEXTURE_ENABLE] & 1) {
+			uint32_t size = c[GE_CMD_TEX_SIZE0];
+			r->a[A_U] = x->uv[0] / (1 << (size & 0xf));
+			r->a[A_V] = x->uv[1] / (1 << ((size >> 8) & 0xf));
+		} else
+			r->a[A_U] = r->a[A_V] = 0;
+	} else {
+		invw = 1.0f / x->clip[3];
+		r->x = x->clip[0] * invw * ge_float(c[GE_CMD_VP_XSCALE]) +
+		    ge_float(c[GE_CMD_VP_XCENTER]) -
+		    (c[GE_CMD_OFFSET_X] & 0xffff) / 16.0f;
+		r->y = x->clip[1] * invw * ge_float(c[GE_CMD_VP_YSCALE]) +
+		    ge_float(c[GE_CMD_VP_YCENTER]) -
+		    (c[GE_CMD_OFFSET_Y] & 0xffff) / 16.0f;
+		z = x->clip[2] * invw * ge_float(c[GE_CMD_VP_ZSCALE]) +
+		    ge_float(c[GE_CMD_VP_ZCENTER]);
+		r->a[A_U] = x->uv[0] * invw;
+		r->a[A_V] = x->uv[1] * invw;
+	}
+
+	r->a[A_Z] = z;
+	r->a[A_W] = invw;
+	for (k = 0; k < 4; k++)
+		r->a[A_R + k] = x->color[k];
+	r->a[A_FOG] = x->fog;
+}
+
+static void ge_xvert_lerp(const struct ge_xvert *a, const struct ge_xvert *b,
+	float t, struct ge_xvert *out)
+{
+	const float *fa = (const float *)a, *fb = (const float *)b;
+	float *fo = (float *)out;
+	unsigned int i;
+
+	for (i = 0; i < GE_XVERT_NFLOATS; i++)
+		fo[i] = fa[i] + (fb[i] - fa[i]) * t;
+}
+
+/*  Clip a polygon against the near plane (z >= -w), and w > 0:  */
+static int ge_clip_near(struct ge_xvert *in, int n, struct ge_xvert *out)
+{
+	struct ge_xvert tmp[8];
+	int plane, i, m;
+
+	for (plane = 0; plane < 2; plane++) {
+		struct ge_xvert *src = plane? tmp : in;
+		struct ge_xvert *dst = plane? out : tmp;
+		m = 0;
+		for (i = 0; i < n; i++) {
+			struct ge_xvert *a = &src[i], *b = &src[(i + 1) % n];
+			float da = plane? a->clip[3] - 1e-5f :
+			    a->clip[2] + a->clip[3];
+			float db = plane? b->clip[3] - 1e-5f :
+			    b->clip[2] + b->clip[3];
+			if (da >= 0)
+				dst[m ++] = *a;
+			if ((da >= 0) != (db >= 0))
+				ge_xvert_lerp(a, b, da / (da - db), &dst[m ++]);
+		}
+		n = m;
+		if (n < 3)
+			return 0;
+	}
+	return n;
+}
+
+static void ge_triangle(struct psp_ge_data *d, struct ge_xvert *x0,
+	struct ge_xvert *x1, struct ge_xvert *x2, int through)
+{
+	struct ge_xvert in[3], poly[8];
+	struct ge_rvert r[8];
+	int cull = 0, n = 3, i;
+
+	if (!through && (d->cmd[GE_CMD_CULL_ENABLE] & 1) &&
+	    !(d->cmd[GE_CMD_CLEAR_MODE] & 1))
+		cull = (d->cmd[GE_CMD_CULL] & 1)? 1 : -1;
+
+	in[0] = *x0; in[1] = *x1; in[2] = *x2;
+	if (through)
+		memcpy(poly, in, sizeof(in));
+	else if ((n = ge_clip_near(in, 3, poly)) == 0)
+		return;
+
+	for (i = 0; i < n; i++)
+		ge_project(d, &poly[i], through, &r[i]);
+	for (i = 1; i + 1 < n; i++) {
+		/*  (setup may modify the vertices, for flat shading)  */
+		struct ge_rvert a = r[0], b = r[i], c = r[i + 1];
+		ge_setup_triangle(d, &a, &b, &c, cull);
+	}
+}
+
+static void ge_sprite(struct psp_ge_data *d, struct ge_xvert *x0,
+	struct ge_xvert *x1, int through)
+{
+	struct ge_rvert r0, r1;
+
+	if (!through && (x0->clip[3] <= 0 || x1->clip[3] <= 0))
+		return;
+	ge_project(d, x0, through, &r0);
+	ge_project(d, x1, through, &r1);
+
+	/*  The texture coordinates are not perspective corrected:  */
+	if (!through) {
+		r0.a[A_U] /= r0.a[A_W]; r0.a[A_V] /= r0.a[A_W];
+		r1.a[A_U] /= r1.a[A_W]; r1.a[A_V] /= r1.a[A_W];
+	}
+	ge_setup_sprite(d, &r0, &r1);
+}
+
+static void ge_line(struct psp_ge_data *d, struct ge_xvert *x0,
+	struct ge_xvert *x1, int through, int point)
+{
+	struct ge_rvert r0, r1;
+
+	if (!through && (x0->clip[3] <= 0 || x1->clip[3] <= 0 ||
+	    x0->clip[2] < -x0->clip[3] || x1->clip[2] < -x1->clip[3]))
+		return;
+	ge_project(d, x0, through, &r0);
+	ge_project(d, x1, through, &r1);
+	ge_setup_line(d, &r0, &r1, point);
+}
+
+/*
+ *  ge_prim():
+ *
+ *  Executes a PRIM command: fetch, transform and assemble count vertices.
+ */
+static void ge_prim(struct psp_ge_data *d, uint32_t param)
+{
+	int type = (param >> 16) & 7, count = param & 0xffff;
+	struct ge_xvert *xv;
+	struct ge_vfmt f;
+	int i, isize = 0;
+
+	ge_vertex_format(d->cmd[GE_CMD_VTYPE], &f);
+	if (f.idx)
+		isize = f.idx == 1? 1 : (f.idx == 2? 2 : 4);
+
+	if (d->cur != NULL) {
+		d->cur->nprims ++;
+		d->cur->nvertices += count;
+	}
+	if (count == 0 || f.pos == 0)
+		return;
+
+	xv = malloc(sizeof(struct ge_xvert) * count);
+	if (xv == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	for (i = 0; i < count; i++) {
+		struct ge_invert in;
+		uint32_t index = i;
+
+		if (isize) {
+			unsigned char b[4];
+			ge_read(d, d->iaddr + i * isize, b, isize);
+			index = b[0];
+			if (isize > 1)
+				index |= b[1] << 8;
+			if (isize > 2)
+				index |= (b[2] << 16) | ((uint32_t)b[3] << 24);
+		}
+		ge_decode_vertex(d, &f, d->vaddr + index * f.size * f.nmorph,
+		    &in);
+		ge_transform(d, &f, &in, &xv[i]);
+	}
+
+	if (isize)
+		d->iaddr += count * isize;
+	else
+		d->vaddr += count * f.size * f.nmorph;
+
+	switch (type) {
+	case GE_PRIM_POINTS:
+		for (i = 0; i < count; i++)
+			ge_line(d, &xv[i], &xv[i], f.through, 1);
+		break;
+	case GE_PRIM_LINES:
+		for (i = 0; i + 1 < count; i += 2)
+			ge_line(d, &xv[i], &xv[i + 1], f.through, 0);
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (i = 0; i + 1 < count; i++)
+			ge_line(d, &xv[i], &xv[i + 1], f.through, 0);
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (i = 0; i + 2 < count; i += 3)
+			ge_triangle(d, &xv[i], &xv[i+1], &xv[i+2], f.through);
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (i = 0; i + 2 < count; i++) {
+			if (i & 1)
+				ge_triangle(d, &xv[i + 1], &xv[i], &xv[i + 2],
+				    f.through);
+			else
+				ge_triangle(d, &xv[i], &xv[i + 1], &xv[i + 2],
+				    f.through);
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (i = 1; i + 1 < count; i++)
+			ge_triangle(d, &xv[0], &xv[i], &xv[i+1], f.through);
+		break;
+	case GE_PRIM_SPRITES:
+		for (i = 0; i + 1 < count; i += 2)
+			ge_sprite(d, &xv[i], &xv[i + 1], f.through);
+		break;
+	}
+
+	free(xv);
+}
+
+
+/*****************************************************************************
+ *
+ *  Display list processing.
+ */
+
+static void ge_transfer(struct psp_ge_data *d, uint32_t param)
+{
+	uint32_t *c = d->cmd;
+	uint32_t src = (c[GE_CMD_XFER_SRC] & 0xfffff0) |
+	    ((c[GE_CMD_XFER_SRC_WIDTH] & 0xff0000) << 8);
+	uint32_t dst = (c[GE_CMD_XFER_DST] & 0xfffff0) |
+	    ((c[GE_CMD_XFER_DST_WIDTH] & 0xff0000) << 8);
+	int srcw = c[GE_CMD_XFER_SRC_WIDTH] & 0x7f8;
+	int dstw = c[GE_CMD_XFER_DST_WIDTH] & 0x7f8;
+	int sx = c[GE_CMD_XFER_SRC_POS] & 0x3ff;
+	int sy = (c[GE_CMD_XFER_SRC_POS] >> 10) & 0x3ff;
+	int dx = c[GE_CMD_XFER_DST_POS] & 0x3ff;
+	int dy = (c[GE_CMD_XFER_DST_POS] >> 10) & 0x3ff;
+	int w = (c[GE_CMD_XFER_SIZE] & 0x3ff) + 1;
+	int h = ((c[GE_CMD_XFER_SIZE] >> 10) & 0x3ff) + 1;
+	int bpp = (param & 1)? 4 : 2, y;
+	unsigned char *row = malloc(w * bpp);
+
+	if (row == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	ge_flush(d);
+	for (y = 0; y < h; y++) {
+		ge_read(d, src + ((sy + y) * srcw + sx) * bpp, row, w * bpp);
+		ge_write(d, dst + ((dy + y) * dstw + dx) * bpp, row, w * bpp);
+	}
+	free(row);
+
+	/*  Decoded textures may be stale now:  */
+	ge_texcache_clear(d);
+	d->rstate_dirty = 1;
+}
+
+static void ge_load_clut(struct psp_ge_data *d, uint32_t param)
+{
+	uint32_t addr = (d->cmd[GE_CMD_CLUT_ADDR] & 0xfffff0) |
+	    ((d->cmd[GE_CMD_CLUT_ADDR_UPPER] & 0xff0000) << 8);
+	uint32_t len = (param & 0x3f) * 32;
+
+	if (len > GE_CLUT_SIZE)
+		len = GE_CLUT_SIZE;
+	if (ge_in_vram(addr))
+		ge_flush(d);
+	ge_read(d, addr, d->clut, len);
+	d->clut_version ++;
+	d->rstate_dirty = 1;
+}
+
+/*
+ *  ge_command():
+ *
+ *  Executes one command of list l. Returns 0 when the list has ended.
+ */
+static int ge_command(struct psp_ge_data *d, struct ge_list *l, uint32_t op,
+	uint32_t param)
+{
+	uint32_t target;
+
+	switch (op) {
+
+	case GE_CMD_NOP:
+		break;
+
+	case GE_CMD_VADDR:
+		d->vaddr = (l->base | param) + l->offset;
+		break;
+
+	case GE_CMD_IADDR:
+		d->iaddr = (l->base | param) + l->offset;
+		break;
+
+	case GE_CMD_PRIM:
+		ge_prim(d, param);
+		break;
+
+	case GE_CMD_BEZIER:
+	case GE_CMD_SPLINE:
+		if (!d->warned_patches) {
+			debug("[ psp_ge: bezier/spline patches are not "
+			    "implemented ]\n");
+			d->warned_patches = 1;
+		}
+		break;
+
+	case GE_CMD_BBOX:
+	case GE_CMD_BJUMP:
+		/*  Everything is assumed to be inside the bounding box.  */
+		break;
+
+	case GE_CMD_JUMP:
+		l->pc = ((l->base | param) + l->offset) & 0x0ffffffc;
+		return 1;
+
+	case GE_CMD_CALL:
+		target = ((l->base | param) + l->offset) & 0x0ffffffc;
+		if (l->stack_ptr + 2 > GE_STACK_DEPTH) {
+			fatal("[ psp_ge: call stack overflow ]\n");
+			break;
+		}
+		l->stack[l->stack_ptr ++] = l->pc + 4;
+		l->stack[l->stack_ptr ++] = l->offset;
+		l->pc = target;
+		return 1;
+
+	case GE_CMD_RET:
+		if (l->stack_ptr < 2) {
+			fatal("[ psp_ge: call stack underflow ]\n");
+			break;
+		}
+		l->offset = l->stack[-- l->stack_ptr];
+		l->pc = l->stack[-- l->stack_ptr];
+		return 1;
+
+	case GE_CMD_SIGNAL:
+		l->signal = 1;
+		l->signal_param = param;
+		break;
+
+	case GE_CMD_FINISH:
+		l->finished = 1;
+		break;
+
+	case GE_CMD_END:
+		if (l->signal) {
+			/*  The "jump", "call" and "return" signals are
+			    carried out here; the others only call the
+			    (not implemented) signal callback.  */
+			int sig = (l->signal_param >> 16) & 0xff;
+			target = ((l->signal_param & 0xffff) << 16) |
+			    (param & 0xffff);
+			l->signal = 0;
+			switch (sig) {
+			case 0x10:
+				l->pc = target & 0x0ffffffc;
+				return 1;
+			case 0x11:
+				if (l->stack_ptr + 2 <= GE_STACK_DEPTH) {
+					l->stack[l->stack_ptr ++] = l->pc + 4;
+					l->stack[l->stack_ptr ++] = l->offset;
+					l->pc = target & 0x0ffffffc;
+					return 1;
+				}
+				break;
+			case 0x12:
+				if (l->stack_ptr >= 2) {
+					l->offset = l->stack[-- l->stack_ptr];
+					l->pc = l->stack[-- l->stack_ptr];
+					return 1;
+				}
+				break;
+			}
+			if (!l->finished)
+				break;
+		}
+		return 0;
+
+	case GE_CMD_BASE:
+		l->base = (param << 8) & 0x0f000000;
+		break;
+
+	case GE_CMD_OFFSET_ADDR:
+		l->offset = param << 8;
+		break;
+
+	case GE_CMD_ORIGIN:
+		l->offset = l->pc;
+		break;
+
+	case GE_CMD_BONE_NUM:
+		d->bone_n = param & 0x7f;
+		break;
+	case GE_CMD_BONE_DATA:
+		if (d->bone_n < 8 * 12)
+			d->bone[d->bone_n ++] = ge_float(param);
+		break;
+	case GE_CMD_WORLD_NUM:
+		d->world_n = param & 0xf;
+		break;
+	case GE_CMD_WORLD_DATA:
+		if (d->world_n < 12)
+			d->world[d->world_n ++] = ge_float(param);
+		break;
+	case GE_CMD_VIEW_NUM:
+		d->view_n = param & 0xf;
+		break;
+	case GE_CMD_VIEW_DATA:
+		if (d->view_n < 12)
+			d->view[d->view_n ++] = ge_float(param);
+		break;
+	case GE_CMD_PROJ_NUM:
+		d->proj_n = param & 0xf;
+		break;
+	case GE_CMD_PROJ_DATA:
+		if (d->proj_n < 16)
+			d->proj[d->proj_n ++] = ge_float(param);
+		break;
+	case GE_CMD_TGEN_NUM:
+		d->tgen_n = param & 0xf;
+		break;
+	case GE_CMD_TGEN_DATA:
+		if (d->tgen_n < 12)
+			d->tgen[d->tgen_n ++] = ge_float(param);
+		break;
+
+	case GE_CMD_LOAD_CLUT:
+		ge_load_clut(d, param);
+		break;
+
+	case GE_CMD_TEX_FLUSH:
+	case GE_CMD_TEX_SYNC:
+		d->rstate_dirty = 1;
+		break;
+
+	case GE_CMD_XFER_START:
+		ge_transfer(d, param);
+		break;
+
+	default:
+		if (d->cmd[op] != param)
+			d->rstate_dirty = 1;
+	}
+
+	d->cmd[op] = param;
+	l->pc += 4;
+	return 1;
+}
+
+/*
+ *  ge_list_run():
+ *
+ *  Runs a list until it ends (returns 1) or reaches its stall address
+ *  (returns 0).
+ */
+static int ge_list_run(struct psp_ge_data *d, struct ge_list *l)
+{
+	d->cur = l;
+	l->state = GE_LIST_DRAWING;
+
+	for (;;) {
+		uint32_t word;
+
+		if (l->stall != 0 && (l->pc & 0x1fffffff) ==
+		    (l->stall & 0x1fffffff)) {
+			ge_flush(d);
+			l->state = GE_LIST_STALLING;
+			d->cur = NULL;
+			return 0;
+		}
+
+		word = ge_read32(d, l->pc);
+		l->ncommands ++;
+		if (!ge_command(d, l, word >> 24, word & 0xffffff))
+			break;
+	}
+
+	ge_flush(d);
+	l->state = GE_LIST_DONE;
+	d->cur = NULL;
+
+	debug("[ psp_ge: list %i (0x%08x) done: %lli commands, %lli "
+	    "primitives, %lli vertices, %lli pixels ]\n", (int)(l - d->lists),
+	    (int)l->start, (long long)l->ncommands, (long long)l->nprims,
+	    (long long)l->nvertices, (long long)l->npixels);
+	return 1;
+}
+
+/*  Run queued lists, in order, until one stalls or the queue is empty:  */
+static void ge_run(struct psp_ge_data *d)
+{
+	while (d->nqueued > 0) {
+		struct ge_list *l = &d->lists[d->queue[0]];
+
+		if (!ge_list_run(d, l))
+			break;
+
+		d->nqueued --;
+		memmove(&d->queue[0], &d->queue[1], sizeof(int) * d->nqueued);
+	}
+
+	/*  The CPU may change any texture before the next run:  */
+	ge_texcache_clear(d);
+	d->rstate_dirty = 1;
+}
+
+
+/*****************************************************************************
+ *
+ *  Interface for the sceGe* HLE calls.
+ */
+
+/*
+ *  dev_psp_ge_enqueue():
+ *
+ *  Adds a display list to the queue (at the head, if head is set), and runs
+ *  the queue. Returns the list id, or -1 if there are too many lists.
+ */
+int dev_psp_ge_enqueue(uint32_t list, uint32_t stall, int head)
+{
+	struct psp_ge_data *d = psp_ge;
+	struct ge_list *l;
+	int i;
+
+	if (d == NULL)
+		return -1;
+
+	for (i = 0; i < GE_MAX_LISTS; i++)
+		if (d->lists[i].state == GE_LIST_FREE ||
+		    d->lists[i].state == GE_LIST_DONE)
+			break;
+	if (i == GE_MAX_LISTS)
+		return -1;
+
+	l = &d->lists[i];
+	memset(l, 0, sizeof(struct ge_list));
+	l->state = GE_LIST_QUEUED;
+	l->start = l->pc = list & 0x0ffffffc;
+	l->stall = stall & 0x0fffffff;
+
+	if (head) {
+		memmove(&d->queue[1], &d->queue[0], sizeof(int) * d->nqueued);
+		d->queue[0] = i;
+	} else
+		d->queue[d->nqueued] = i;
+	d->nqueued ++;
+
+	ge_run(d);
+	return i;
+}
+
+int dev_psp_ge_dequeue(int id)
+{
+	struct psp_ge_data *d = psp_ge;
+	int i;
+
+	if (d == NULL || id < 0 || id >= GE_MAX_LISTS)
+		return -1;
+
+	for (i = 0; i < d->nqueued; i++)
+		if (d->queue[i] == id) {
+			d->nqueued --;
+			memmove(&d->queue[i], &d->queue[i + 1],
+			    sizeof(int) * (d->nqueued - i));
+			d->lists[id].state = GE_LIST_FREE;
+			return 0;
+		}
+	return -1;
+}
+
+int dev_psp_ge_update_stall(int id, uint32_t stall)
+{
+	struct psp_ge_data *d = psp_ge;
+
+	if (d == NULL || id < 0 || id >= GE_MAX_LISTS ||
+	    d->lists[id].state == GE_LIST_FREE)
+		return -1;
+
+	d->lists[id].stall = stall & 0x0fffffff;
+	ge_run(d);
+	return 0;
+}
+
+int dev_psp_ge_list_sync(int id)
+{
+	struct psp_ge_data *d = psp_ge;
+
+	if (d == NULL || id < 0 || id >= GE_MAX_LISTS ||
+	    d->lists[id].state == GE_LIST_FREE)
+		return -1;
+	return d->lists[id].state;
+}
+
+/*  Lists are drawn as they are queued, so only a stalled list is left:  */
+int dev_psp_ge_draw_sync(void)
+{
+	struct psp_ge_data *d = psp_ge;
+
+	if (d == NULL || d->nqueued == 0)
+		return GE_LIST_DONE;
+	return GE_LIST_STALLING;
+}
+
+uint32_t dev_psp_ge_get_cmd(int cmd)
+{
+	return psp_ge == NULL? 0 : psp_ge->cmd[cmd & 0xff];
+}
+
+/*
+ *  dev_psp_ge_get_matrix():
+ *
+ *  Returns the number of floats copied to out (which must have room for
+ *  16), or 0 for an unknown matrix type.
+ */
+int dev_psp_ge_get_matrix(int type, float *out)
+{
+	struct psp_ge_data *d = psp_ge;
+
+	if (d == NULL)
+		return 0;
+
+	switch (type) {
+	case 0: case 1: case 2: case 3: case 4: case 5: case 6: case 7:
+		memcpy(out, &d->bone[type * 12], 12 * sizeof(float));
+		return 12;
+	case 8:	memcpy(out, d->world, sizeof(d->world)); return 12;
+	case 9:	memcpy(out, d->view, sizeof(d->view)); return 12;
+	case 10:memcpy(out, d->proj, sizeof(d->proj)); return 16;
+	case 11:memcpy(out, d->tgen, sizeof(d->tgen)); return 12;
+	}
+	return 0;
+}
+
+
+/*
+ *  dev_psp_ge_snapshot():
+ *
+ *  Lists only run from within the sceGe* calls, and always end with the
+ *  batch flushed and the texture cache cleared, so between instructions
+ *  the GE is just its registers, matrices, CLUT and list queue.
+ */
+static void dev_psp_ge_snapshot(struct snapshot *s, void *extra)
+{
+	struct psp_ge_data *d = extra;
+
+	SNAPSHOT_VAR(s, d->lists);
+	SNAPSHOT_VAR(s, d->queue);
+	SNAPSHOT_VAR(s, d->nqueued);
+	SNAPSHOT_VAR(s, d->cmd);
+	SNAPSHOT_VAR(s, d->vaddr);
+	SNAPSHOT_VAR(s, d->iaddr);
+	SNAPSHOT_VAR(s, d->world);
+	SNAPSHOT_VAR(s, d->view);
+	SNAPSHOT_VAR(s, d->proj);
+	SNAPSHOT_VAR(s, d->tgen);
+	SNAPSHOT_VAR(s, d->bone);
+	SNAPSHOT_VAR(s, d->world_n);
+	SNAPSHOT_VAR(s, d->view_n);
+	SNAPSHOT_VAR(s, d->proj_n);
+	SNAPSHOT_VAR(s, d->tgen_n);
+	SNAPSHOT_VAR(s, d->bone_n);
+	SNAPSHOT_VAR(s, d->clut);
+	SNAPSHOT_VAR(s, d->clut_version);
+
+	if (snapshot_restoring(s)) {
+		ge_texcache_clear(d);
+		d->rstate_dirty = 1;
+	}
+}
+
+
+/*
+ *  dev_psp_ge_init():
+ *
+ *  Sets up the GE, rendering into the VRAM of framebuffer device fb.
+ */
+void dev_psp_ge_init(struct machine *machine, struct vfb_data *fb)
+{
+	struct psp_ge_data *d;
+	int i;
+
+	d = malloc(sizeof(struct psp_ge_data));
+	if (d == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memset(d, 0, sizeof(struct psp_ge_data));
+
+	d->machine = machine;
+	d->fb = fb;
+	d->vram = fb->framebuffer;
+	d->vram_size = fb->framebuffer_size;
+	if (d->vram_size > GE_VRAM_MASK + 1)
+		d->vram_size = GE_VRAM_MASK + 1;
+	d->ram_start = (uint32_t)machine->memory_offset_in_mb << 20;
+	d->ram_end = d->ram_start +
+	    ((uint32_t)machine->physical_ram_in_mb << 20);
+	d->rstate_dirty = 1;
+
+	for (i = 0; i < GE_MAX_LISTS; i++)
+		d->lists[i].state = GE_LIST_FREE;
+
+	d->nthreads = 1;
+#ifdef HAVE_PTHREADS
+	{
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		pthread_t thread;
+
+		pthread_mutex_init(&d->work_lock, NULL);
+		pthread_cond_init(&d->work_cond, NULL);
+		pthread_cond_init(&d->done_cond, NULL);
+
+		d->nthreads = ncpus < 1? 1 : (ncpus > GE_MAX_THREADS?
+		    GE_MAX_THREADS : (int)ncpus);
+		for (i = 1; i < d->nthreads; i++)
+			if (pthread_create(&thread, NULL, ge_worker, d)) {
+				d->nthreads = i;
+				break;
+			}
+	}
+#endif
+
+	snapshot_register(machine, "psp_ge", dev_psp_ge_snapshot, d);
+
+	psp_ge = d;
+}
+
@@ -0,0 +1,418 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  PSP Media Engine control, mailbox and interrupt registers.
+ *
+ *  The Media Engine is cpu1. It is held in reset until the main CPU (cpu0)
+ *  releases it, and then starts at the boot address (0xbfc00000 by default,
+ *  where a small RAM for the boot code is mapped).
+ *
+ *  When the machine has threaded_cpus set, the ME runs on its own host
+ *  thread with its own translation cache. The two CPUs share RAM, but only
+ *  see each other at these sync points:
+ *
+ *	o)  any access to the registers below, and
+ *	o)  cache writeback/invalidate ops (the cache instruction, and the
+ *	    HLE sceKernelDcache* and sceKernelIcache* calls).
+ *
+ *  A cache op on one CPU asks the other CPU to drop its code translations.
+ *  Each CPU picks up such requests (and ME start/stop and interrupts) in
+ *  psp_me_cpu_sync(), between chunks of instructions in its own thread:
+ *  the main CPU from a tick function, the ME from cpu_run_thread().
+ *
+ *  Registers (32-bit):
+ *
+ *	0x00  RESET	1 = ME held in reset, 0 = ME running
+ *	0x04  BOOT	ME start address
+ *	0x10  MBOX_ME	mailbox, main CPU to ME
+ *	0x14  MBOX_MAIN	mailbox, ME to main CPU
+ *	0x20  IRQ_ME	non-zero raises the ME's interrupt, 0 acks it
+ *	0x24  IRQ_MAIN	non-zero raises the main CPU's interrupt, 0 acks it
+ *	0x30  SYNC	writes are a sync point, just like a cache writeback
+ *
+ *  The interrupts are wired to MIPS hardware interrupt line PSP_ME_IRQ.
+ */
+
+//#define PSP_ME_DEBUG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "device.h"
+#include "devices.h"
+#include "machine.h"
+#include "memory.h"
+#include "misc.h"
+#include "snapshot.h"
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+
+#define	PSP_ME_REG_RESET	0x00
+#define	PSP_ME_REG_BOOT		0x04
+#define	PSP_ME_REG_MBOX_ME	0x10
+#define	PSP_ME_REG_MBOX_MAIN	0x14
+#define	PSP_ME_REG_IRQ_ME	0x20
+#define	PSP_ME_REG_IRQ_MAIN	0x24
+#define	PSP_ME_REG_SYNC		0x30
+
+#define	PSP_ME_LENGTH		0x100
+#define	PSP_ME_IRQ		2
+
+#define	PSP_ME_BOOT_PADDR	0x1fc00000
+#define	PSP_ME_BOOT_LENGTH	0x1000
+#define	PSP_ME_BOOT_VADDR	0xbfc00000
+
+/*  Every 2^x cycles, the main CPU looks for requests from the ME:  */
+#define	PSP_ME_TICK_SHIFT	14
+
+/*  Index into the per-CPU arrays:  */
+#define	PSP_CPU_MAIN		0
+#define	PSP_CPU_ME		1
+
+struct psp_me_data {
+	struct machine	*machine;
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t	lock;
+#endif
+
+	uint32_t	reset;
+	uint32_t	boot;
+	uint32_t	mbox[2];
+	uint32_t	irq[2];
+
+	/*  Requests, picked up by the CPU in psp_me_cpu_sync():  */
+	int		start_pending;
+	int		stop_pending;
+	int		flush_pending[2];
+
+	/*  Only touched by the CPU itself:  */
+	int		irq_asserted[2];
+
+	unsigned char	*boot_ram;
+};
+
+/*  NULL if the machine has no ME, which makes cache ops cheap:  */
+static struct psp_me_data *psp_me = NULL;
+
+
+static void psp_me_lock(struct psp_me_data *d)
+{
+#ifdef HAVE_PTHREADS
+	pthread_mutex_lock(&d->lock);
+#endif
+}
+
+static void psp_me_unlock(struct psp_me_data *d)
+{
+#ifdef HAVE_PTHREADS
+	pthread_mutex_unlock(&d->lock);
+#endif
+}
+
+
+/*
+ *  psp_me_request_flush():
+ *
+ *  Ask every CPU except cpu_id to drop its code translations. (Called
+ *  with the lock held.)
+ */
+static void psp_me_request_flush(struct psp_me_data *d, int cpu_id)
+{
+	int i;
+
+	for (i=0; i<2; i++)
+		if (i != cpu_id)
+			d->flush_pending[i] = 1;
+}
+
+
+/*
+ *  psp_me_cpu_sync():
+ *
+ *  Sync point for one CPU: apply the requests the other CPU has left for
+ *  it. This must be called from the thread which runs the CPU, and not
+ *  from within a chunk of translated instructions.
+ */
+static void psp_me_cpu_sync(struct cpu *cpu, void *extra)
+{
+	struct psp_me_data *d = extra;
+	int id = cpu->cpu_id == 0? PSP_CPU_MAIN : PSP_CPU_ME;
+	int flush, start = 0, stop = 0, irq;
+
+	psp_me_lock(d);
+	flush = d->flush_pending[id];
+	d->flush_pending[id] = 0;
+	if (id == PSP_CPU_ME) {
+		start = d->start_pending;
+		stop = d->stop_pending;
+		d->start_pending = d->stop_pending = 0;
+	}
+	irq = d->irq[id] != 0;
+	psp_me_unlock(d);
+
+	if (stop)
+		cpu->running = 0;
+	if (start) {
+#ifdef PSP_ME_DEBUG
+		debug("[ psp_me: starting the ME at 0x%08x ]\n", d->boot);
+#endif
+		cpu->pc = (int32_t) d->boot;
+		cpu->cd.mips.delay_slot = NOT_DELAYED;
+		cpu->running = 1;
+		flush = 1;
+	}
+
+	/*  The interpreter has no translation cache to flush:  */
+	if (flush && cpu->translation_cache != NULL)
+		cpu_create_or_reset_tc(cpu);
+
+	if (irq != d->irq_asserted[id]) {
+		if (irq)
+			cpu_interrupt(cpu, PSP_ME_IRQ);
+		else
+			cpu_interrupt_ack(cpu, PSP_ME_IRQ);
+		d->irq_asserted[id] = irq;
+	}
+}
+
+
+/*
+ *  dev_psp_me_tick():
+ *
+ *  Sync point for the main CPU. When the ME is not on its own host thread,
+ *  it runs in the same loop as the main CPU and is synced from here too; it
+ *  then also stops when the main CPU stops, so that the machine can halt.
+ */
+void dev_psp_me_tick(struct cpu *cpu, void *extra)
+{
+	struct psp_me_data *d = extra;
+	struct machine *machine = d->machine;
+
+	psp_me_cpu_sync(machine->cpus[0], d);
+
+	if (!machine->threaded_cpus) {
+		psp_me_cpu_sync(machine->cpus[1], d);
+		if (!machine->cpus[0]->running)
+			machine->cpus[1]->running = 0;
+	}
+}
+
+
+/*
+ *  dev_psp_me_snapshot():
+ *
+ *  Snapshots are only taken while the ME runs in lockstep with the main
+ *  CPU, so no locking is needed here.
+ */
+static void dev_psp_me_snapshot(struct snapshot *s, void *extra)
+{
+	struct psp_me_data *d = extra;
+
+	SNAPSHOT_VAR(s, d->reset);
+	SNAPSHOT_VAR(s, d->boot);
+	SNAPSHOT_VAR(s, d->mbox);
+	SNAPSHOT_VAR(s, d->irq);
+	SNAPSHOT_VAR(s, d->start_pending);
+	SNAPSHOT_VAR(s, d->stop_pending);
+	SNAPSHOT_VAR(s, d->flush_pending);
+	SNAPSHOT_VAR(s, d->irq_asserted);
+}
+
+
+/*
+ *  dev_psp_me_cache_sync():
+ *
+ *  Called for cache writeback/invalidate ops on the PSP. Whatever this CPU
+ *  has written may be code for the other CPU, so the other CPU drops its
+ *  translations at its next sync point.
+ */
+void dev_psp_me_cache_sync(struct cpu *cpu)
+{
+	struct psp_me_data *d = psp_me;
+
+	if (d == NULL)
+		return;
+
+	psp_me_lock(d);
+	psp_me_request_flush(d, cpu->cpu_id == 0? PSP_CPU_MAIN : PSP_CPU_ME);
+	psp_me_unlock(d);
+}
+
+
+DEVICE_ACCESS(psp_me)
+{
+	struct psp_me_data *d = extra;
+	int id = cpu->cpu_id == 0? PSP_CPU_MAIN : PSP_CPU_ME;
+	uint64_t idata = 0, odata = 0;
+
+	if (writeflag == MEM_WRITE)
+		idata = memory_readmax64(cpu, data, len);
+
+	psp_me_lock(d);
+
+	switch (relative_addr) {
+
+	case PSP_ME_REG_RESET:
+		if (writeflag == MEM_READ) {
+			odata = d->reset;
+			break;
+		}
+		if (d->reset && idata == 0) {
+			d->start_pending = 1;
+			d->stop_pending = 0;
+		} else if (!d->reset && idata != 0) {
+			d->stop_pending = 1;
+			d->start_pending = 0;
+		}
+		d->reset = idata != 0;
+		break;
+
+	case PSP_ME_REG_BOOT:
+		if (writeflag == MEM_READ)
+			odata = d->boot;
+		else
+			d->boot = idata;
+		break;
+
+	case PSP_ME_REG_MBOX_ME:
+	case PSP_ME_REG_MBOX_MAIN:
+		if (writeflag == MEM_READ)
+			odata = d->mbox[relative_addr == PSP_ME_REG_MBOX_ME?
+			    PSP_CPU_ME : PSP_CPU_MAIN];
+		else
+			d->mbox[relative_addr == PSP_ME_REG_MBOX_ME?
+			    PSP_CPU_ME : PSP_CPU_MAIN] = idata;
+		break;
+
+	case PSP_ME_REG_IRQ_ME:
+	case PSP_ME_REG_IRQ_MAIN:
+		if (writeflag == MEM_READ)
+			odata = d->irq[relative_addr == PSP_ME_REG_IRQ_ME?
+			    PSP_CPU_ME : PSP_CPU_MAIN];
+		else
+			d->irq[relative_addr == PSP_ME_REG_IRQ_ME?
+			    PSP_CPU_ME : PSP_CPU_MAIN] = idata;
+		break;
+
+	case PSP_ME_REG_SYNC:
+		if (writeflag == MEM_WRITE)
+			psp_me_request_flush(d, id);
+		break;
+
+	default:
+		if (writeflag == MEM_WRITE)
+			fatal("[ psp_me: unimplemented write to offset 0x%x: "
+			    "0x%llx ]\n", (int)relative_addr,
+			    (long long)idata);
+		else
+			fatal("[ psp_me: unimplemented read from offset "
+			    "0x%x ]\n", (int)relative_addr);
+	}
+
+	psp_me_unlock(d);
+
+#ifdef PSP_ME_DEBUG
+	debug("[ psp_me: cpu%i %s reg 0x%02x: 0x%08llx ]\n", cpu->cpu_id,
+	    writeflag == MEM_WRITE? "write" : "read", (int)relative_addr,
+	    (long long)(writeflag == MEM_WRITE? idata : odata));
+#endif
+
+	if (writeflag == MEM_READ)
+		memory_writemax64(cpu, data, len, odata);
+
+	return 1;
+}
+
+
+/*
+ *  The ME boot RAM. Accesses normally go directly to boot_ram.
+ */
+DEVICE_ACCESS(psp_me_boot)
+{
+	struct psp_me_data *d = extra;
+
+	if (relative_addr + len > PSP_ME_BOOT_LENGTH)
+		return 0;
+
+	if (writeflag == MEM_WRITE)
+		memcpy(d->boot_ram + relative_addr, data, len);
+	else
+		memcpy(data, d->boot_ram + relative_addr, len);
+
+	return 1;
+}
+
+
+/*
+ *  dev_psp_me_init():
+ *
+ *  Registers the ME control block at baseaddr, and the ME boot RAM. The
+ *  machine must already have two CPUs, cpu1 being the ME.
+ */
+void dev_psp_me_init(struct machine *machine, uint64_t baseaddr)
+{
+	struct psp_me_data *d;
+
+	d = malloc(sizeof(struct psp_me_data));
+	if (d == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memset(d, 0, sizeof(struct psp_me_data));
+#ifdef HAVE_PTHREADS
+	pthread_mutex_init(&d->lock, NULL);
+#endif
+
+	d->machine = machine;
+	d->reset = 1;
+	d->boot = PSP_ME_BOOT_VADDR;
+
+	memory_device_register(machine->memory, "psp_me", baseaddr,
+	    PSP_ME_LENGTH, dev_psp_me_access, d, DM_DEFAULT, NULL);
+
+	d->boot_ram = zeroed_alloc(PSP_ME_BOOT_LENGTH);
+	memory_device_register(machine->memory, "psp_me_boot",
+	    PSP_ME_BOOT_PADDR, PSP_ME_BOOT_LENGTH, dev_psp_me_boot_access, d,
+	    DM_DYNTRANS_OK | DM_DYNTRANS_WRITE_OK |
+	    DM_READS_HAVE_NO_SIDE_EFFECTS, d->boot_ram);
+
+	machine_add_tickfunction(machine, dev_psp_me_tick, d,
+	    PSP_ME_TICK_SHIFT);
+
+	snapshot_register(machine, "psp_me", dev_psp_me_snapshot, d);
+	snapshot_register_memory(machine, "psp_me_boot", d->boot_ram,
+	    PSP_ME_BOOT_LENGTH);
+
+	machine->cpu_sync_func = psp_me_cpu_sync;
+	machine->cpu_sync_extra = d;
+
+	psp_me = d;
+}
+
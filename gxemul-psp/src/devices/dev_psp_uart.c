@@ -33,6 +33,7 @@
 #include "machine.h"
 #include "memory.h"
 #include "misc.h"
+#include "snapshot.h"
 
 struct psp_uart_data {
 	unsigned char	*name;
@@ -51,6 +52,11 @@ struct psp_uart_data {
 	uint32_t	baud;	// pseudo register
 
 	uint32_t	control;
+
+	/*  Transmitted bytes go here, with -f:  */
+	struct machine	*machine;
+	FILE		*out;
+	int		out_opened;
 };
 
 #define	PSP_UART_TICK_SHIFT		5
@@ -69,6 +75,21 @@ void dev_psp_uart_tick(struct cpu *cpu, void *extra)
 	}
 }
 
+static void dev_psp_uart_snapshot(struct snapshot *s, void *extra)
+{
+	struct psp_uart_data *d = extra;
+
+	snapshot_data(s, d->data, d->length);
+	snapshot_data(s, d->dataold, d->length);
+	SNAPSHOT_VAR(s, d->fifoin);
+	SNAPSHOT_VAR(s, d->fifoout);
+	SNAPSHOT_VAR(s, d->status);
+	SNAPSHOT_VAR(s, d->div1);
+	SNAPSHOT_VAR(s, d->div2);
+	SNAPSHOT_VAR(s, d->baud);
+	SNAPSHOT_VAR(s, d->control);
+}
+
 DEVICE_ACCESS(psp_uart)
 {
 	int i;
@@ -104,6 +125,16 @@ DEVICE_ACCESS(psp_uart)
 					d->status|=(1<<5);
 					d->fifoout=(data[3]<<24)+(data[2]<<16)+(data[1]<<8)+(data[0]<<0);
 					debug(" 0x%08x",d->fifoout);
+					if(!d->out_opened)
+					{
+						char *channel=(char *)d->name;
+						if(strncmp(channel,"io_",3)==0)
+							channel+=3;
+						d->out=machine_output_file(d->machine,channel);
+						d->out_opened=1;
+					}
+					if(d->out!=NULL)
+						fputc(d->fifoout&0xff,d->out);
 				}
 				break;
 			case 0x04:
@@ -253,11 +284,13 @@ void dev_psp_uart_init(struct machine *machine, uint64_t baseaddr, uint64_t leng
 	strcpy(d->name,name);
 	d->vaddr= baseaddr;
 	d->length= length;
+	d->machine= machine;
 
 	memory_device_register(machine->memory, name, d->vaddr,
 	    d->length, dev_psp_uart_access, d, DM_DEFAULT, d->data);
 
 	machine_add_tickfunction(machine, dev_psp_uart_tick, d, PSP_UART_TICK_SHIFT);
+	snapshot_register(machine, (char *)d->name, dev_psp_uart_snapshot, d);
 
 	return 1;
 }
@@ -36,6 +36,7 @@
 #include <limits.h>
 #include <stdarg.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 //#include "arcbios.h"
@@ -49,6 +50,7 @@
 #include "console.h"
 #include "debugger.h"
 #include "device.h"
+#include "devices.h"
 #include "diskimage.h"
 #include "exec_elf.h"
 #include "machine.h"
@@ -56,11 +58,14 @@
 #include "mips_cpu_types.h"
 #include "misc.h"
 #include "net.h"
+#include "profiler.h"
+#include "snapshot.h"
 //#include "sgi_arcbios.h"
 #include "x11.h"
 
 
 extern int force_debugger_at_exit;
+extern int batch_mode;
 
 extern int extra_argc;
 extern char **extra_argv;
@@ -73,6 +78,8 @@ extern struct diskimage *diskimages[];
 
 static char *diskimage_types[] = DISKIMAGE_TYPES;
 
+static volatile sig_atomic_t screenshot_requested = 0;
+
 
 static void print_separator(void)
 {
@@ -1027,19 +1034,8 @@ void emul_machine_setup(struct machine *m, int n_load, char **load_names,
 	}
 	debug("\n");
 
-#if 0
-	/*  Special case: The Playstation Portable has an additional CPU:  */
-	if (m->machine_type == MACHINE_PSP) {
-		debug("cpu%i: ", m->ncpus);
-		m->cpus[m->ncpus] = cpu_new(m->memory, m,
-		    0  /*  use 0 here to show info with debug()  */,
-		    "Allegrex" /*  TODO  */);
-		if (m->bintrans_enable)
-			bintrans_init_cpu(m->cpus[m->ncpus]);
-		debug("\n");
-		m->ncpus ++;
-	}
-#endif
+	/*  (The Playstation Portable's Media Engine is cpu1, if -n 2 is
+	    used; see machine_psp.c.)  */
 
 	if (m->use_random_bootstrap_cpu)
 		m->bootstrap_cpu = random() % m->ncpus;
@@ -1301,6 +1297,9 @@ void emul_machine_setup(struct machine *m, int n_load, char **load_names,
 
 	symbol_recalc_sizes(&m->symbol_context);
 
+	/*  The profiler's tick function must be there before cpu_run_init():  */
+	profiler_init(m);
+
 	if (m->max_random_cycles_per_chunk > 0)
 		debug("using random cycle chunks (1 to %i cycles)\n",
 		    m->max_random_cycles_per_chunk);
@@ -1448,6 +1447,42 @@ struct emul *emul_create_from_configfile(char *fname)
 }
 
 
+/*
+ *  emul_sigusr1():
+ *
+ *  SIGUSR1 asks for a new -F screenshot. It is written from the main loop,
+ *  between two runs of cpu_run().
+ */
+static void emul_sigusr1(int x)
+{
+	screenshot_requested = 1;
+	signal(SIGUSR1, emul_sigusr1);
+}
+
+
+/*
+ *  emul_screenshots():
+ *
+ *  Write the framebuffer of each machine which was started with -F.
+ */
+static void emul_screenshots(struct emul **emuls, int n_emuls)
+{
+	int i, j;
+
+	for (i=0; i<n_emuls; i++) {
+		if (emuls[i] == NULL)
+			continue;
+		for (j=0; j<emuls[i]->n_machines; j++) {
+			struct machine *m = emuls[i]->machines[j];
+			if (m->screenshot_filename != NULL &&
+			    m->main_fb != NULL)
+				dev_fb_save_png(m->main_fb,
+				    m->screenshot_filename);
+		}
+	}
+}
+
+
 /*
  *  emul_run():
  *
@@ -1456,15 +1491,18 @@ struct emul *emul_create_from_configfile(char *fname)
  *	o)  Run emulations (one or more, in parallel).
  *
  *	o)  De-initialize things.
+ *
+ *  The return value is the exit status of the first machine, i.e. the
+ *  guest's own exit status, or one of the MACHINE_EXIT_* codes.
  */
-void emul_run(struct emul **emuls, int n_emuls)
+int emul_run(struct emul **emuls, int n_emuls)
 {
 	struct emul *e;
 	int i = 0, j, go = 1, n, anything;
 
 	if (n_emuls < 1) {
 		fprintf(stderr, "emul_run(): no thing to do\n");
-		return;
+		return 1;
 	}
 
 	atexit(fix_console);
@@ -1472,6 +1510,22 @@ void emul_run(struct emul **emuls, int n_emuls)
 	/*  Initialize the interactive debugger:  */
 	debugger_init(emuls, n_emuls);
 
+	/*
+	 *  Initialize all CPUs in all machines in all emulations, and open
+	 *  any record/replay logs. This is done before running the debugger
+	 *  commands, so that a snapshot restored from the command line
+	 *  (-c "loadsnap file") is not overwritten afterwards.
+	 */
+	for (i=0; i<n_emuls; i++) {
+		e = emuls[i];
+		if (e == NULL)
+			continue;
+		for (j=0; j<e->n_machines; j++) {
+			cpu_run_init(e->machines[j]);
+			replay_init(e->machines[j]);
+		}
+	}
+
 	/*  Run any additional debugger commands before starting:  */
 	for (i=0; i<n_emuls; i++) {
 		struct emul *emul = emuls[i];
@@ -1504,25 +1558,23 @@ void emul_run(struct emul **emuls, int n_emuls)
 	console_init_main(emuls[0]);	/*  TODO: what is a good argument?  */
 	signal(SIGINT, debugger_activate);
 	signal(SIGCONT, console_sigcont);
+	signal(SIGUSR1, emul_sigusr1);
 
 	/*  Not in verbose mode? Then set quiet_mode.  */
 	if (!verbose)
 		quiet_mode = 1;
 
-	/*  Initialize all CPUs in all machines in all emulations:  */
-	for (i=0; i<n_emuls; i++) {
-		e = emuls[i];
-		if (e == NULL)
-			continue;
-		for (j=0; j<e->n_machines; j++)
-			cpu_run_init(e->machines[j]);
-	}
-
 	/*  TODO: Generalize:  */
 	if (emuls[0]->machines[0]->show_trace_tree)
 		cpu_functioncall_trace(emuls[0]->machines[0]->cpus[0],
 		    emuls[0]->machines[0]->cpus[0]->pc);
 
+	/*  The -w time limits count from here:  */
+	for (i=0; i<n_emuls; i++)
+		for (j=0; j<emuls[i]->n_machines; j++)
+			emuls[i]->machines[j]->deadline = time(NULL) +
+			    emuls[i]->machines[j]->max_seconds;
+
 	/*
 	 *  MAIN LOOP:
 	 *
@@ -1545,8 +1597,14 @@ void emul_run(struct emul **emuls, int n_emuls)
 				anything = cpu_run(e, e->machines[j]);
 				if (anything)
 					go = 1;
+				snapshot_checkpoint(e->machines[j]);
 			}
 		}
+
+		if (screenshot_requested) {
+			screenshot_requested = 0;
+			emul_screenshots(emuls, n_emuls);
+		}
 	}
 
 	/*  Deinitialize all CPUs in all machines in all emulations:  */
@@ -1554,12 +1612,17 @@ void emul_run(struct emul **emuls, int n_emuls)
 		e = emuls[i];
 		if (e == NULL)
 			continue;
-		for (j=0; j<e->n_machines; j++)
+		for (j=0; j<e->n_machines; j++) {
 			cpu_run_deinit(e->machines[j]);
+			profiler_report(e->machines[j]);
+			replay_deinit(e->machines[j]);
+		}
 	}
 
+	emul_screenshots(emuls, n_emuls);
+
 	/*  force_debugger_at_exit flag set? Then enter the debugger:  */
-	if (force_debugger_at_exit) {
+	if (force_debugger_at_exit && !batch_mode) {
 		quiet_mode = 0;
 		debugger_reset();
 		debugger();
@@ -1582,5 +1645,7 @@ void emul_run(struct emul **emuls, int n_emuls)
 	}
 
 	console_deinit();
+
+	return emuls[0]->machines[0]->exit_status;
 }
 
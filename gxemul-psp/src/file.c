@@ -211,8 +211,22 @@ static void file_load_raw(struct machine *m, struct memory *mem,
 		}							\
 	}
 
-Elf32_Phdr _phdr32[10];
-Elf32_Shdr _shdr32[50];
+/*  PRX modules are relocated to the start of the user partition:  */
+#define	ET_SCE_PRX		0xffa0
+#define	SHT_PSP_REL		0x700000a0
+#define	PSP_PRX_LOAD_BASE	0x08804000
+
+#define	R_MIPS_NONE		0
+#define	R_MIPS_32		2
+#define	R_MIPS_26		4
+#define	R_MIPS_HI16		5
+#define	R_MIPS_LO16		6
+
+#define	PSP_MAX_PHDRS		10
+#define	PSP_MAX_SHDRS		100
+
+Elf32_Phdr _phdr32[PSP_MAX_PHDRS];
+Elf32_Shdr _shdr32[PSP_MAX_SHDRS];
 char *_stringtable[10];
 int _lenstringtable[10];;
 int _numstringtables;
@@ -392,6 +406,181 @@ int i;
 	debug(" lib_stub_btm  : %08x\n",info->lib_stub_btm);
 }
 
+/*
+ *  file_psp_relocate_prx():
+ *
+ *  Applies the SHT_PSP_REL relocations of a PRX loaded at base. Each entry
+ *  names the segment its offset is relative to (bits 8..15 of r_info) and
+ *  the segment it points into (bits 16..23).
+ */
+static void file_psp_relocate_prx(struct machine *m, struct memory *mem,
+	FILE *f, int ephnum, int eshnum, uint32_t base)
+{
+	struct cpu *cpu = m->cpus[0];
+	uint32_t segaddr[PSP_MAX_PHDRS];
+	Elf32_Rel *rel;
+	int i, r, j, n;
+
+	for (i=0; i<ephnum; i++)
+		segaddr[i] = base + _phdr32[i].p_vaddr;
+
+	for (i=0; i<eshnum; i++) {
+		if (_shdr32[i].sh_type != SHT_PSP_REL)
+			continue;
+
+		n = _shdr32[i].sh_size / sizeof(Elf32_Rel);
+		rel = malloc(_shdr32[i].sh_size);
+		if (rel == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		fseek(f, _shdr32[i].sh_offset, SEEK_SET);
+		if (fread(rel, sizeof(Elf32_Rel), n, f) != n) {
+			fprintf(stderr, "could not read relocations\n");
+			exit(1);
+		}
+#ifdef DEBUG_PSP_LOADER
+		debug("applying %d relocations\n", n);
+#endif
+		for (r=0; r<n; r++) {
+			int type = rel[r].r_info & 0xff;
+			int ofsbase = (rel[r].r_info >> 8) & 0xff;
+			int addrbase = (rel[r].r_info >> 16) & 0xff;
+			uint32_t addr, to, op, lo, full;
+
+			if (ofsbase >= ephnum || addrbase >= ephnum) {
+				fatal("[ psp: bad relocation %08x %08x ]\n",
+				    rel[r].r_offset, rel[r].r_info);
+				continue;
+			}
+			addr = segaddr[ofsbase] + rel[r].r_offset;
+			to = segaddr[addrbase];
+
+			cpu->memory_rw(cpu, mem, addr, (unsigned char *)&op, 4, MEM_READ,
+			    NO_EXCEPTIONS);
+			switch (type) {
+			case R_MIPS_NONE:
+				break;
+			case R_MIPS_32:
+				op += to;
+				break;
+			case R_MIPS_26:
+				op = (op & 0xfc000000) | (((((op & 0x03ffffff)
+				    << 2) + to) >> 2) & 0x03ffffff);
+				break;
+			case R_MIPS_HI16:
+				/*  The carry depends on the matching LO16:  */
+				lo = 0;
+				for (j=r+1; j<n; j++)
+					if ((rel[j].r_info & 0xff) ==
+					    R_MIPS_LO16) {
+						cpu->memory_rw(cpu, mem,
+						    segaddr[(rel[j].r_info >> 8)
+						    & 0xff] + rel[j].r_offset,
+						    (unsigned char *)&lo, 4, MEM_READ,
+						    NO_EXCEPTIONS);
+						break;
+					}
+				full = (op << 16) + (int16_t)lo + to;
+				op = (op & 0xffff0000) |
+				    (((full + 0x8000) >> 16) & 0xffff);
+				break;
+			case R_MIPS_LO16:
+				op = (op & 0xffff0000) | ((op + to) & 0xffff);
+				break;
+			default:
+				fatal("[ psp: unimplemented relocation type "
+				    "%d at 0x%08x ]\n", type, addr);
+			}
+			cpu->memory_rw(cpu, mem, addr, (unsigned char *)&op, 4, MEM_WRITE,
+			    NO_EXCEPTIONS);
+		}
+		free(rel);
+	}
+}
+
+
+/*
+ *  file_psp_bind_stubs():
+ *
+ *  Reads the import table (start..end, already relocated in emulated
+ *  memory) and writes a syscall to the HLE function with the matching NID
+ *  into the delay slot of each import stub.
+ */
+static void file_psp_bind_stubs(struct machine *m, struct memory *mem,
+	uint32_t start, uint32_t end)
+{
+	struct cpu *cpu = m->cpus[0];
+	uint32_t addr;
+	int i, ii, entlen, unresolved = 0;
+
+	_numstubs = 0;
+	for (addr=start; addr<end && _numstubs<0x100; addr+=entlen*4) {
+		cpu->memory_rw(cpu, mem, addr,
+		    (unsigned char *)&stub_info[_numstubs],
+		    sizeof(PSP_sceStubInfo), MEM_READ, NO_EXCEPTIONS);
+		/*  entry length in words, at least the 5 we know about  */
+		entlen = stub_info[_numstubs].w02 & 0xff;
+		if (entlen < 5)
+			entlen = 5;
+		_numstubs++;
+	}
+
+	for (i=0; i<_numstubs; i++) 
+	{
+		int32_t offs=stub_info[i].stub;
+		int32_t num =(stub_info[i].w02>>16)&0x0000ffff;
+		int32_t nids=stub_info[i].nidtable;
+		char *libname=(char *)get_userland_string(cpu, stub_info[i].modulestr);
+
+#ifdef DEBUG_PSP_LOADER
+		debug("fixing up %d stubs of %s at %08x (nids at:%08x)\n",num,libname,offs,nids);
+#endif
+		for (ii=0; ii<num; ii++) 
+		{
+			int32_t thisnid=0xdeadbeaf;
+			int32_t syscall;
+
+			// read nid from memory
+			cpu->memory_rw(cpu, mem, nids,
+			    (unsigned char *)&thisnid, 4, MEM_READ, NO_EXCEPTIONS);
+
+			syscall=PSP_findsyscall_bynid(thisnid);
+			if(syscall==0)
+			{
+				fatal("[ psp: unresolved import %s 0x%08x ]\n",libname,thisnid);
+				unresolved++;
+			}
+			else
+			{
+				/*  name the stub, for traces and profiles  */
+				add_symbol_name(&m->symbol_context, offs,
+				    sizeof(PSP_Stub), PSP_syscall_getname(syscall),
+				    0, PSP_syscall_getargn(syscall));
+			}
+
+#ifdef DEBUG_PSP_LOADER
+			debug("fixing up stub #%d at %08x (nid:%08x, name:%s)\n",ii,offs,thisnid,PSP_syscall_getname(syscall));
+#endif
+			syscall<<=6;	// shift up to fit into opcode
+			syscall|=0x0c;  // syscall opcode
+
+			// write syscall to memory
+			cpu->memory_rw(cpu, mem, offs+4,
+			    (unsigned char *)&syscall, 4, MEM_WRITE, NO_EXCEPTIONS);
+
+			offs+=sizeof(PSP_Stub);
+			nids+=4;
+		}
+		free(libname);
+	}
+
+	if (unresolved)
+		fatal("[ psp: %d imports are not implemented by the HLE layer ]\n",
+		    unresolved);
+}
+
+
 static void file_load_elf(struct machine *m, struct memory *mem,
 	char *filename, uint64_t *entrypointp, int arch, uint64_t *gpp,
 	int *byte_order, uint64_t *tocp)
@@ -413,6 +602,9 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 	char *symbol_strings = NULL; size_t symbol_length = 0;
 	char *s;
 	Elf32_Sym *symbols_sym32 = NULL;  int n_symbols = 0;
+	uint32_t prx_base = 0, image_end = 0;
+	uint32_t stubs_start = 0, stubs_end = 0;
+	int have_module_info = 0;
 
 	/*
 		try to open file
@@ -489,11 +681,20 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 		    (int)eshentsize, (int)sizeof(Elf32_Shdr));
 		exit(1);
 	}
-	if ( etype != ET_EXEC ) {
+	if ( etype != ET_EXEC && etype != ET_SCE_PRX ) {
 		fprintf(stderr, "%s is not an ELF Executable file, type = %i\n",
 		    filename, etype);
 		exit(1);
 	}
+	if ( etype == ET_SCE_PRX ) {
+		prx_base = PSP_PRX_LOAD_BASE;
+		eentry += prx_base;
+	}
+	if ( ephnum > PSP_MAX_PHDRS || eshnum > PSP_MAX_SHDRS ) {
+		fprintf(stderr, "%s: too many program or section headers\n",
+		    filename);
+		exit(1);
+	}
 	ok = 0;
 	switch (arch) {
 	case ARCH_MIPS:
@@ -559,7 +760,7 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 		memcpy(&phdr32,&_phdr32[i], sizeof(Elf32_Phdr));
 		p_type=phdr32.p_type;
 		p_offset=phdr32.p_offset;
-		p_vaddr=phdr32.p_vaddr;
+		p_vaddr=phdr32.p_vaddr + prx_base;
 		p_paddr=phdr32.p_paddr;
 		p_filesz=phdr32.p_filesz;
 		p_memsz=phdr32.p_memsz;
@@ -581,7 +782,8 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 
 			debug(" len=0x%llx\n", (long long)p_memsz);
 #endif
-			if (p_vaddr != p_paddr) {
+			/*  (A PRX keeps the module info offset in paddr.)  */
+			if (p_vaddr != p_paddr && !prx_base) {
 				fatal("NOTE: vaddr (0x%08x) and "
 				    "paddr (0x%08x) differ; using vaddr"
 				    "\n", (int)p_vaddr, (int)p_paddr);
@@ -595,6 +797,9 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 				exit(1);
 			}
 
+			if (p_vaddr + p_memsz > image_end)
+				image_end = p_vaddr + p_memsz;
+
 			fseek(f, p_offset, SEEK_SET);
 			align_len = 1;
 			if ((p_vaddr & 0xf)==0)		align_len = 0x10;
@@ -807,6 +1012,9 @@ char *symbol_strings=_stringtable[1];
 			if (size == 0)
 				size ++;
 
+			if (addr != 0)
+				addr += prx_base;
+
 			if (addr != 0) /* && ((st_info >> 4) & 0xf)
 			    >= STB_GLOBAL) */ {
 #ifdef DEBUG_PSP_LOADER
@@ -841,7 +1049,14 @@ char *symbol_strings=_stringtable[1];
 #endif
 
 	/*
-		read sceModuleInfo
+		relocate a PRX
+	*/
+
+	if (prx_base)
+		file_psp_relocate_prx(m, mem, f, ephnum, eshnum, prx_base);
+
+	/*
+		read sceModuleInfo (from memory, so that it is relocated)
 	*/
 
 #ifdef DEBUG_PSP_LOADER
@@ -849,50 +1064,46 @@ char *symbol_strings=_stringtable[1];
 #endif 
 	for (i=0; i<eshnum; i++) 
 	{
-//fprintf(stderr,">%s\n",_stringtable[0]+_shdr32[i].sh_name);
-		if(!strcmp(".rodata.sceModuleInfo",_stringtable[0]+_shdr32[i].sh_name))
+		if(!strcmp(".rodata.sceModuleInfo",_stringtable[0]+_shdr32[i].sh_name) ||
+		   !strcmp(".xodata.sceModuleInfo",_stringtable[0]+_shdr32[i].sh_name))
 		{ 
-			fseek(f, _shdr32[i].sh_offset, SEEK_SET);
-			fread(&module_info, 1, sizeof(PSP_sceModuleInfo), f);
-			file_dump_sceModuleInfo(&module_info);
-
-			
-			debug("found _gp address: 0x");
-				debug("%08x\n", (int)module_info.w08);
-			*gpp = module_info.w08;
-
+			m->cpus[0]->memory_rw(m->cpus[0], mem,
+			    _shdr32[i].sh_addr + prx_base, (unsigned char *)&module_info,
+			    sizeof(PSP_sceModuleInfo), MEM_READ, NO_EXCEPTIONS);
+			have_module_info = 1;
 			break;
 		}
-		if(!strcmp(".xodata.sceModuleInfo",_stringtable[0]+_shdr32[i].sh_name))
-		{ 
-			fseek(f, _shdr32[i].sh_offset, SEEK_SET);
-			fread(&module_info, 1, sizeof(PSP_sceModuleInfo), f);
-			file_dump_sceModuleInfo(&module_info);
+	}
+	/*  A stripped PRX still has it, at the file offset in paddr:  */
+	if (!have_module_info && prx_base && ephnum > 0)
+	{
+		m->cpus[0]->memory_rw(m->cpus[0], mem, prx_base +
+		    _phdr32[0].p_vaddr + (_phdr32[0].p_paddr & 0x7fffffff) -
+		    _phdr32[0].p_offset, (unsigned char *)&module_info,
+		    sizeof(PSP_sceModuleInfo), MEM_READ, NO_EXCEPTIONS);
+		have_module_info = 1;
+	}
+	if (have_module_info)
+	{
+		file_dump_sceModuleInfo(&module_info);
 
-			
-			debug("found _gp address: 0x");
-				debug("%08x\n", (int)module_info.w08);
-			*gpp = module_info.w08;
+		debug("found _gp address: 0x");
+			debug("%08x\n", (int)module_info.w08);
+		*gpp = module_info.w08;
 
-			break;
-		}
+		stubs_start = module_info.lib_stub;
+		stubs_end = module_info.lib_stub_btm;
 	}
 
 #ifdef DEBUG_PSP_LOADER
 	debug("reading .lib.stub\n");
 #endif
-	_numstubs=0;
-
 	for (i=0; i<eshnum; i++) 
 	{
 		if(!strcmp(".lib.stub",_stringtable[0]+_shdr32[i].sh_name))
 		{ 
-			fseek(f, _shdr32[i].sh_offset, SEEK_SET);
-			for(ii=0;ii<(_shdr32[i].sh_size/sizeof(PSP_sceStubInfo));ii++)
-			{
-			fread(&stub_info[_numstubs], 1, sizeof(PSP_sceStubInfo), f);
-			_numstubs++;
-			}
+			stubs_start = _shdr32[i].sh_addr + prx_base;
+			stubs_end = stubs_start + _shdr32[i].sh_size;
 		}
 	}
 
@@ -907,7 +1118,7 @@ char *symbol_strings=_stringtable[1];
 			for(ii=0;ii<(_shdr32[i].sh_size);ii++)
 			{
 				m->cpus[0]->memory_rw(m->cpus[0], mem,
-			    		(_shdr32[i].sh_addr+ii), &zeroint, 1,MEM_WRITE, NO_EXCEPTIONS);
+			    		(_shdr32[i].sh_addr+prx_base+ii), &zeroint, 1,MEM_WRITE, NO_EXCEPTIONS);
 			}
 		}
 	}
@@ -919,54 +1130,10 @@ char *symbol_strings=_stringtable[1];
 #ifdef DEBUG_PSP_LOADER
 	debug("fixing up .sceStub.text\n");
 #endif
-/*
-	for (i=0; i<eshnum; i++) 
-	{
-		if(!strcmp(".sceStub.text",_stringtable[0]+_shdr32[i].sh_name))
-		{ 
-fprintf(stderr,".sceStub.text at: %08x offs: %08x size: %08x\n",_shdr32[i].sh_addr,_shdr32[i].sh_offset,_shdr32[i].sh_size);
-			break;
-		}
-	}
-*/
-	for (i=0; i<_numstubs; i++) 
-	{
-		int32_t offs=stub_info[i].stub;
-		int32_t num =(stub_info[i].w02>>16)&0x0000ffff;
-		int32_t nids=stub_info[i].nidtable;
-
-		int32_t syscall=0x0000000c;
-		int32_t thisnid=0xdeadbeaf;
-
-#ifdef DEBUG_PSP_LOADER
-		debug("fixing up %d stubs at %08x (nids at:%08x)\n",num,offs,nids);
-#endif
-		for (ii=0; ii<num; ii++) 
-		{
-
-			// read nid from memory
-			m->cpus[0]->memory_rw(m->cpus[0], mem,
-			    nids, &thisnid, 4,
-			    MEM_READ, NO_EXCEPTIONS);
-
-			syscall=PSP_findsyscall_bynid(thisnid);
+	file_psp_bind_stubs(m, mem, stubs_start, stubs_end);
 
-#ifdef DEBUG_PSP_LOADER
-			debug("fixing up stub #%d at %08x (nid:%08x, name:%s)\n",ii,offs,thisnid,PSP_syscall_getname(syscall));
-#endif
-			syscall<<=6;	// shift up to fit into opcode
-			syscall|=0x0c;  // syscall opcode
-
-			// write syscall to memory
-			m->cpus[0]->memory_rw(m->cpus[0], mem,
-			    offs+4, &syscall, 4,
-			    MEM_WRITE, NO_EXCEPTIONS);
-
-
-		offs+=sizeof(PSP_Stub);
-		nids+=4;
-		}
-	}
+	/*  The HLE memory manager hands out memory above the image:  */
+	hle_partition_base = (image_end + 0xff) & ~0xff;
 
 	*entrypointp = eentry;
 	*byte_order = EMUL_LITTLE_ENDIAN;
@@ -155,6 +155,7 @@ struct cpu;
 struct emul;
 struct machine;
 struct memory;
+struct snapshot;
 
 
 struct cpu_family {
@@ -186,6 +187,10 @@ struct cpu_family {
 				    uint64_t irq_nr);
 	void			(*functioncall_trace)(struct cpu *,
 				    uint64_t f, int n_args);
+	void			(*snapshot)(struct cpu *cpu,
+				    struct snapshot *s);
+	int			(*unwind)(struct cpu *cpu,
+				    uint64_t *frames, int max_frames);
 };
 
 
@@ -209,48 +214,92 @@ struct cpu_family {
 
 #ifdef DYNTRANS_BACKEND
 
-/*  TODO: convert this into a fixed-size array? Might increase performace.  */
-struct dtb_fixup {
-	struct dtb_fixup	*next;
-	int			type;	/*  Fixup type [optional]  */
-	void			*addr;	/*  Address of the instruction
-					    (in host memory)  */
-	size_t			data;	/*  Emulation data.  */
+/*
+ *  Dyntrans backend (native code generation):
+ *
+ *  While translating, runs of consecutive "simple" instructions (register-
+ *  to-register ALU operations which cannot cause exceptions) are described
+ *  as dtb_ops. When the run ends, the host backend turns the whole run into
+ *  one native function, which replaces the first instr_call's f.
+ *
+ *  The operands are pointers to emulated registers, which must lie within
+ *  the cpu struct. src2 is NULL for operations using imm.
+ */
+#define	DTB_OP_MOV		0	/*  dst = src1  */
+#define	DTB_OP_SET		1	/*  dst = imm  */
+#define	DTB_OP_ADD		2	/*  dst = src1 + src2/imm  */
+#define	DTB_OP_SUB		3
+#define	DTB_OP_AND		4
+#define	DTB_OP_OR		5
+#define	DTB_OP_XOR		6
+#define	DTB_OP_NOR		7
+#define	DTB_OP_SLT		8	/*  dst = src1 < src2/imm (signed)  */
+#define	DTB_OP_SLTU		9
+#define	DTB_OP_MUL		10
+#define	DTB_OP_SLL		11	/*  dst = src1 << (src2/imm & 31)  */
+#define	DTB_OP_SRL		12
+#define	DTB_OP_SRA		13
+#define	DTB_OP_NOP		14
+
+struct dtb_op {
+	int			op;
+	void			*dst;
+	void			*src1;
+	void			*src2;
+	int32_t			imm;
 };
 
-struct translation_context {
-	/*  Current address of where to emit host instructions:  */
-	/*  (NULL means no translation is currently being done.)  */
-	void			*p;
+#define	DTB_MAX_OPS			64
 
-	/*  index of the instr_call of the first translated instruction:  */
+struct translation_context {
+	/*  The run of simple instructions currently being collected:  */
 	void			*ic_page;
 	int			start_instr_call_index;
-
-	/*  Fixups needed after first translation pass:  */
-	struct dtb_fixup	*fixups;
-
 	int			n_simple;
+	struct dtb_op		ops[DTB_MAX_OPS];
 
-	/*  translation_buffer should have room for max_size bytes,
-	    plus some margin.  */
-	unsigned char		*translation_buffer;
-	size_t			cur_size;
+	/*  Copies of the instr_calls (f + args), so that the run can be
+	    thrown away if any of them changes before it is compiled:  */
+	size_t			ic_copy[DTB_MAX_OPS][4];
+
+	/*  The op describing the instruction just translated, and its
+	    branch target instr_call (for branches within the page):  */
+	struct dtb_op		op;
+	void			*branch_target;
 };
 
-#define	DTB_TRANSLATION_SIZE_MAX	3072
-#define	DTB_TRANSLATION_SIZE_MARGIN	1024
+/*
+ *  Header in front of each native block in the translation cache. The
+ *  block's code follows the header, and a copy of the original instr_calls
+ *  (used when verifying) follows the code.
+ */
+struct dtb_block {
+	void			*native_f;
+	size_t			fallback_f;
+	int			n_instrs;
+	void			*ics;
+};
 
-void cpu_dtb_add_fixup(struct cpu *cpu, int type, void *addr, size_t data);
-void cpu_dtb_do_fixups(struct cpu *cpu);
+/*  Max size of the native code for one block:  */
+#define	DTB_TRANSLATION_SIZE_MAX	(DTB_MAX_OPS * 48 + 256)
 
+/*
+ *  dtb_generate_block() generates code for n_ops ops into buf, and returns 1
+ *  on success (0 if the ops can't be handled). Other arguments:
+ *
+ *  guard         if *guard is non-zero on entry (for example while in a
+ *                delay slot), only the first instruction may be executed,
+ *                and the native code jumps to fallback_f instead
+ *  next_icp      the cpu's next_ic pointer, incremented by the native code
+ *  n_instrsp     the cpu's n_translated_instrs counter
+ *  verify_f      if non-zero, the native code calls verify_f(cpu, ic, block)
+ *                instead, which runs and compares both implementations
+ */
 void dtb_host_cacheinvalidate(void *p, size_t len);
-int dtb_function_prologue(struct translation_context *ctx, size_t *sizep);
-int dtb_function_epilogue(struct translation_context *ctx, size_t *sizep);
-int dtb_generate_fcall(struct cpu *cpu, struct translation_context *ctx,
-	size_t *sizep, size_t f, size_t instr_call_ptr);
-int dtb_generate_ptr_inc(struct cpu *cpu, struct translation_context *ctx,
-	size_t *sizep, void *ptr, int amount);
+int dtb_generate_block(struct cpu *cpu, struct dtb_op *ops, int n_ops,
+	unsigned char *buf, size_t *sizep, int *guard, size_t fallback_f,
+	void *next_icp, int *n_instrsp, size_t ic_size, size_t verify_f,
+	struct dtb_block *block);
 
 #endif	/*  DYNTRANS_BACKEND  */
 
@@ -367,6 +416,8 @@ void cpu_init(void);
 	fp->interrupt = n ## _cpu_interrupt; 				\
 	fp->interrupt_ack = n ## _cpu_interrupt_ack;			\
 	fp->functioncall_trace = n ## _cpu_functioncall_trace;		\
+	fp->snapshot = n ## _cpu_snapshot;				\
+	fp->unwind = n ## _cpu_unwind;					\
 	return 1;							\
 	}
 
@@ -386,6 +437,8 @@ void cpu_init(void);
 	fp->interrupt = n ## _cpu_interrupt; 				\
 	fp->interrupt_ack = n ## _cpu_interrupt_ack;			\
 	fp->functioncall_trace = n ## _cpu_functioncall_trace;		\
+	fp->snapshot = n ## _cpu_snapshot;				\
+	fp->unwind = n ## _cpu_unwind;					\
 	return 1;							\
 	}
 
@@ -42,6 +42,7 @@
 struct cpu_family;
 struct emul;
 struct machine;
+struct snapshot;
 
 /*
  *  CPU type definitions:  See mips_cpu_types.h.
@@ -239,6 +240,58 @@ struct mips_vpg_tlb_entry {
 };
 
 
+/*
+ *  Coproc 2 on the Allegrex:  The VFPU.
+ *
+ *  128 single precision registers, seen as 8 matrices of 4x4. Register
+ *  vpr[mtx*16 + col*4 + row] is named S<mtx><col><row>. Instructions are
+ *  predecoded into mips_instr_call structs, the same way as for the
+ *  dyntrans core; the old interpreter keeps them in a small cache keyed
+ *  on the instruction word.
+ */
+#define	MIPS_VFPU_N_VPRS		128
+#define	MIPS_VFPU_N_CTRL		16
+
+#define	VFPU_CTRL_SPREFIX		0
+#define	VFPU_CTRL_TPREFIX		1
+#define	VFPU_CTRL_DPREFIX		2
+#define	VFPU_CTRL_CC			3
+#define	VFPU_CTRL_INF4			4
+#define	VFPU_CTRL_REV			7
+#define	VFPU_CTRL_RCX0			8
+
+/*  Major opcodes (hi6) which belong to the VFPU:  */
+#define	MIPS_VFPU_HI6_MASK		0xf4f400000b040000ULL
+#define	MIPS_VFPU_HI6(hi6)		((MIPS_VFPU_HI6_MASK >> (hi6)) & 1)
+
+/*  bvf, bvt, bvfl, bvtl:  */
+#define	MIPS_VFPU_IS_BRANCH(iword)	(((iword) & 0xffe00000) == 0x49000000)
+
+/*  Return values from mips_vfpu_translate():  */
+#define	MIPS_VFPU_TRANSLATED		1
+#define	MIPS_VFPU_NEEDS_PC		2	/*  may cause an exception  */
+
+#define	MIPS_VFPU_ICACHE_SIZE		1024
+#define	MIPS_VFPU_ICACHE_HASH(iword)	(((iword) ^ ((iword) >> 10) ^ \
+					((iword) >> 20)) & (MIPS_VFPU_ICACHE_SIZE-1))
+
+struct mips_vfpu_icache {
+	uint32_t		iword;
+	struct mips_instr_call	ic;
+};
+
+struct mips_vfpu {
+	union {
+		float		f[MIPS_VFPU_N_VPRS];
+		uint32_t	u[MIPS_VFPU_N_VPRS];
+	}		vpr;
+	uint32_t	ctrl[MIPS_VFPU_N_CTRL];
+	int		pfx_active;	/*  non-zero if a prefix is pending  */
+
+	struct mips_vfpu_icache icache[MIPS_VFPU_ICACHE_SIZE];
+};
+
+
 /*******************************  OLD:  *****************************/
 
 #define	BINTRANS_DONT_RUN_NEXT		0x1000000
@@ -277,6 +330,9 @@ struct mips_cpu {
 
 	uint64_t	ic; /* allegrex special irq register ? */
 
+	/*  Allegrex VFPU, or NULL on other cpus:  */
+	struct mips_vfpu *vfpu;
+
 	/*
 	 *  The translation_cached stuff is used to speed up the
 	 *  most recent lookups into the TLB.  Whenever the TLB is
@@ -454,6 +510,8 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 void mips_cpu_cause_simple_exception(struct cpu *cpu, int exc_code);
 int mips_cpu_run(struct emul *emul, struct machine *machine);
 void mips_cpu_dumpinfo(struct cpu *cpu);
+void mips_cpu_snapshot(struct cpu *cpu, struct snapshot *s);
+int mips_cpu_unwind(struct cpu *cpu, uint64_t *frames, int max_frames);
 void mips_cpu_list_available_types(void);
 int mips_cpu_family_init(struct cpu_family *);
 
@@ -481,6 +539,18 @@ void coproc_function(struct cpu *cpu, struct mips_coproc *cp, int cpnr,
         uint32_t function, int unassemble_only, int running);
 
 
+/*  cpu_mips_vfpu.c:  */
+struct mips_vfpu *mips_vfpu_new(struct cpu *cpu);
+void mips_vfpu_reset(struct mips_vfpu *v);
+int mips_vfpu_translate(struct cpu *cpu, uint32_t iword,
+	struct mips_instr_call *ic);
+int mips_vfpu_run_instr(struct cpu *cpu, uint32_t iword);
+int mips_vfpu_disassemble_instr(struct cpu *cpu, uint32_t iword,
+	uint64_t dumpaddr, int running);
+void mips_vfpu_register_dump(struct cpu *cpu);
+int mips_vfpu_selftest(struct cpu *cpu);
+
+
 /*  memory_mips.c:  */
 int memory_cache_R3000(struct cpu *cpu, int cache, uint64_t paddr,
 	int writeflag, size_t len, unsigned char *data);
@@ -497,6 +567,12 @@ void mips_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
 	unsigned char *host_page, int writeflag, uint64_t paddr_page);
 void mips_invalidate_translation_caches(struct cpu *cpu, uint64_t, int);
 void mips_invalidate_code_translation(struct cpu *cpu, uint64_t, int);
+void mips_pc_to_pointers(struct cpu *);
+void mips32_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
+	unsigned char *host_page, int writeflag, uint64_t paddr_page);
+void mips32_invalidate_translation_caches(struct cpu *cpu, uint64_t, int);
+void mips32_invalidate_code_translation(struct cpu *cpu, uint64_t, int);
+void mips32_pc_to_pointers(struct cpu *);
 
 
 #endif	/*  CPU_MIPS_H  */
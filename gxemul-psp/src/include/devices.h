@@ -129,6 +129,7 @@ int dev_fb_access(struct cpu *cpu, struct memory *mem, uint64_t relative_addr,
 struct vfb_data *dev_fb_init(struct machine *machine, struct memory *mem,
 	uint64_t baseaddr, int vfb_type, int visible_xsize, int visible_ysize,
 	int xsize, int ysize, int bit_depth, char *name);
+int dev_fb_save_png(struct vfb_data *d, char *filename);
 
 /*  dev_ram.c:  */
 #define	DEV_RAM_RAM				0
@@ -142,6 +143,20 @@ void dev_ram_init(struct machine *machine, uint64_t baseaddr, uint64_t length,
 /* dev_psp_uart.c */
 void dev_psp_uart_init(struct machine *machine, uint64_t baseaddr, uint64_t length,char *name);
 
+/* dev_psp_me.c */
+void dev_psp_me_cache_sync(struct cpu *cpu);
+void dev_psp_me_init(struct machine *machine, uint64_t baseaddr);
+
+/* dev_psp_ge.c */
+int dev_psp_ge_enqueue(uint32_t list, uint32_t stall, int head);
+int dev_psp_ge_dequeue(int id);
+int dev_psp_ge_update_stall(int id, uint32_t stall);
+int dev_psp_ge_list_sync(int id);
+int dev_psp_ge_draw_sync(void);
+uint32_t dev_psp_ge_get_cmd(int cmd);
+int dev_psp_ge_get_matrix(int type, float *out);
+void dev_psp_ge_init(struct machine *machine, struct vfb_data *fb);
+
 
 #endif	/*  DEVICES_H  */
 
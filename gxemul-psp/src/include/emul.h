@@ -60,7 +60,7 @@ void emul_machine_setup(struct machine *machine, int n_load, char **load_names,
 void emul_dumpinfo(struct emul *e);
 void emul_simple_init(struct emul *emul);
 struct emul *emul_create_from_configfile(char *fname);
-void emul_run(struct emul **emuls, int n_emuls);
+int emul_run(struct emul **emuls, int n_emuls);
 
 
 /*  emul_parse.c:  */
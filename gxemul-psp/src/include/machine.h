@@ -31,6 +31,7 @@
  *  $Id: machine.h,v 1.105 2006/02/18 13:42:39 debug Exp $
  */
 
+#include <stdio.h>
 #include <sys/types.h>
 #include <sys/time.h>
 
@@ -46,12 +47,20 @@
 
 #define	MAX_TICK_FUNCTIONS	14
 
+#define	MAX_SNAPSHOT_ENTRIES	24
+#define	MAX_SNAPSHOT_REGIONS	8
+
 struct cpu_family;
 struct diskimage;
 struct emul;
 struct fb_window;
 struct memory;
 struct of_data;
+struct profiler;
+struct replay_log;
+struct snapshot;
+struct snapshot_shadow;
+struct vfb_data;
 
 /*  Ugly:  */
 struct kn230_csr;
@@ -89,6 +98,10 @@ struct machine_bus {
 
 #define	MACHINE_NAME_MAXBUF		150
 
+/*  Emulator exit codes, other than the guest's own exit status:  */
+#define	MACHINE_EXIT_BUDGET		124	/*  -m or -w ran out  */
+#define	MACHINE_EXIT_DEBUGGER		125	/*  -a: debugger entered  */
+
 struct machine {
 	/*  Pointer back to the emul struct we are in:  */
 	struct emul *emul;
@@ -133,6 +146,19 @@ struct machine {
 	void	(*tick_func[MAX_TICK_FUNCTIONS])(struct cpu *, void *);
 	void	*tick_extra[MAX_TICK_FUNCTIONS];
 
+	/*  Device and HLE state saved in snapshots (besides the CPUs and
+	    RAM, which snapshot.c handles itself), and extra memory regions
+	    which are not RAM, such as VRAM:  */
+	int	n_snapshot_entries;
+	char	*snapshot_name[MAX_SNAPSHOT_ENTRIES];
+	void	(*snapshot_func[MAX_SNAPSHOT_ENTRIES])(struct snapshot *,
+		    void *);
+	void	*snapshot_extra[MAX_SNAPSHOT_ENTRIES];
+	int	n_snapshot_regions;
+	char	*snapshot_region_name[MAX_SNAPSHOT_REGIONS];
+	unsigned char *snapshot_region_data[MAX_SNAPSHOT_REGIONS];
+	size_t	snapshot_region_len[MAX_SNAPSHOT_REGIONS];
+
 	void	(*md_interrupt)(struct machine *m, struct cpu *cpu,
 		    int irq_nr, int assert);
 
@@ -145,6 +171,16 @@ struct machine {
 	int	ncpus;
 	struct cpu **cpus;
 
+	/*  If threaded_cpus is set, CPUs 1 and up run on their own host
+	    threads instead of in the CPU_RUN loop. cpu_sync_func is called
+	    by each such CPU from its own thread, between chunks of
+	    instructions:  */
+	int	threaded_cpus;
+	volatile int threaded_cpus_quit;
+	void	*cpu_threads;
+	void	(*cpu_sync_func)(struct cpu *, void *);
+	void	*cpu_sync_extra;
+
 	/*  Registered busses:  */
 	struct machine_bus *first_bus;
 	int	n_busses;
@@ -211,6 +247,27 @@ struct machine {
 
 	int	automatic_clock_adjustment;
 	int	exit_without_entering_debugger;
+
+	/*  Periodic checkpoints (-k) and record/replay (-L, -l):  */
+	char	*checkpoint_filename;
+	int	checkpoint_interval;		/*  seconds  */
+	struct timeval checkpoint_last;
+	struct snapshot_shadow *snapshot_shadow;
+	char	*replay_filename;
+	int	replay_mode;
+	struct replay_log *replay_log;
+	char	*profile_folded_filename;	/*  -P  */
+	char	*profile_pprof_filename;	/*  -G  */
+	struct profiler *profiler;
+
+	/*  Headless runs:  */
+	int	max_seconds;			/*  -w, 0 = no limit  */
+	time_t	deadline;
+	char	*screenshot_filename;		/*  -F  */
+	char	*output_prefix;			/*  -f  */
+	int	exit_status;
+	struct vfb_data *main_fb;		/*  for -F  */
+
 	int	show_trace_tree;
 
 	int	n_gfx_cards;
@@ -512,6 +569,7 @@ void automachine_init(void);
 struct machine *machine_new(char *name, struct emul *emul);
 int machine_name_to_type(char *stype, char *ssubtype,
 	int *type, int *subtype, int *arch);
+FILE *machine_output_file(struct machine *machine, char *channel);
 void machine_add_tickfunction(struct machine *machine,
 	void (*func)(struct cpu *, void *), void *extra, int clockshift);
 void machine_register(char *name, MACHINE_SETUP_TYPE(setup));
@@ -49,6 +49,30 @@ struct translation_page_entry;
 /*  For bintrans:  */
 #define	MAX_QUICK_JUMPS			8
 
+/*
+ *  Direct-mapped host memory, for machines with fixed segments and no TLB
+ *  (the PSP). The table is indexed by the low 29 bits of a virtual address,
+ *  so all the cached/uncached/kernel mirrors of a segment hit the same
+ *  slice. An access is direct if its offset within the slice is below
+ *  limit; otherwise it has to go through memory_rw().
+ */
+#define	FASTMEM_ADDR_MASK		0x1fffffff
+#define	FASTMEM_SLICE_SHIFT		22
+#define	FASTMEM_SLICE_SIZE		(1 << FASTMEM_SLICE_SHIFT)
+#define	N_FASTMEM_SLICES		((FASTMEM_ADDR_MASK >> \
+					    FASTMEM_SLICE_SHIFT) + 1)
+
+struct fastmem_slice {
+	unsigned char	*host;
+	uint32_t	limit;
+
+	/*  Device memory (VRAM): the range written to since the device
+	    last asked, see memory_device_dyntrans_access().  */
+	int		track_writes;
+	uint32_t	write_low;
+	uint32_t	write_high;
+};
+
 struct memory {
 	uint64_t	physical_max;
 	void		*pagetable;
@@ -75,6 +99,9 @@ struct memory {
 
 	int		dev_dyntrans_alignment;
 
+	/*  NULL, unless the machine has set up direct-mapped memory:  */
+	struct fastmem_slice *fastmem;
+
 
 	/*
 	 *  NOTE/TODO: This bintrans was for MIPS only. Ugly. :-/
@@ -128,6 +155,11 @@ char *memory_conv_to_string(struct cpu *cpu, struct memory *mem,
 unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 	uint64_t paddr, int writeflag);
 
+void memory_fastmem_map(struct memory *mem, uint64_t paddr, uint64_t len,
+	unsigned char *host, int track_writes);
+unsigned char *memory_fastmem_ram(struct memory *mem, uint64_t paddr,
+	uint64_t len);
+
 /*  memory_fast_v2h.c:  */
 unsigned char *fast_vaddr_to_hostaddr(struct cpu *cpu, uint64_t vaddr,
 	int writeflag);
@@ -0,0 +1,80 @@
+#ifndef	SNAPSHOT_H
+#define	SNAPSHOT_H
+
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Machine snapshots and record/replay.  (See snapshot.c for more info.)
+ */
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+struct machine;
+
+/*
+ *  A handler registered with snapshot_register() is called with a
+ *  struct snapshot both when saving and when restoring. It should pass
+ *  each piece of its state to snapshot_data() (or SNAPSHOT_VAR), in the
+ *  same order both times; snapshot_data() copies in the direction given
+ *  by snapshot_restoring(). Anything derived from that state (caches,
+ *  host pointers) should be rebuilt when snapshot_restoring() is true.
+ */
+struct snapshot;
+
+int snapshot_restoring(struct snapshot *s);
+void snapshot_data(struct snapshot *s, void *p, size_t len);
+void snapshot_string(struct snapshot *s, char **strp);
+#define	SNAPSHOT_VAR(s,x)	snapshot_data((s), &(x), sizeof(x))
+
+void snapshot_register(struct machine *machine, char *name,
+	void (*func)(struct snapshot *, void *), void *extra);
+void snapshot_register_memory(struct machine *machine, char *name,
+	unsigned char *data, size_t len);
+
+int snapshot_save(struct machine *machine, char *filename);
+int snapshot_restore(struct machine *machine, char *filename, int nr);
+void snapshot_checkpoint(struct machine *machine);
+
+
+/*
+ *  Record/replay of everything that comes from outside the emulated
+ *  machine. replay_event() returns the live value when recording (after
+ *  logging it), and the logged value when replaying.
+ */
+#define	REPLAY_NONE		0
+#define	REPLAY_RECORD		1
+#define	REPLAY_PLAY		2
+
+#define	REPLAY_SYSTIME		1	/*  usecs since start  */
+#define	REPLAY_HOSTTIME		2	/*  usecs since 1970  */
+#define	REPLAY_CTRL_BUTTONS	3
+
+void replay_init(struct machine *machine);
+void replay_deinit(struct machine *machine);
+uint64_t replay_event(struct machine *machine, int type, uint64_t value);
+
+
+#endif	/*  SNAPSHOT_H  */
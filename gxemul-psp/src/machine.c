@@ -214,6 +214,42 @@ int machine_name_to_type(char *stype, char *ssubtype,
 }
 
 
+/*
+ *  machine_output_file():
+ *
+ *  Opens the file that guest output on a channel (such as "stdout", or the
+ *  name of a serial port) is captured to, when running with -f prefix. The
+ *  file is called prefix.channel. Returns NULL if output isn't captured, or
+ *  if the file could not be created.
+ */
+FILE *machine_output_file(struct machine *machine, char *channel)
+{
+	size_t len;
+	char *name;
+	FILE *f;
+
+	if (machine->output_prefix == NULL)
+		return NULL;
+
+	len = strlen(machine->output_prefix) + strlen(channel) + 2;
+	name = malloc(len);
+	if (name == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	snprintf(name, len, "%s.%s", machine->output_prefix, channel);
+
+	f = fopen(name, "w");
+	if (f == NULL)
+		perror(name);
+	else
+		setvbuf(f, NULL, _IOLBF, 0);
+
+	free(name);
+	return f;
+}
+
+
 /*
  *  machine_add_tickfunction():
  *
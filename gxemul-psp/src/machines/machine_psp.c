@@ -29,6 +29,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "cpu.h"
@@ -37,11 +38,16 @@
 #include "machine.h"
 #include "memory.h"
 #include "misc.h"
+#include "snapshot.h"
 
 struct vfb_data *fb;
 //struct unimplemented_data *io;
 
 #define MEG16	(1024 * 1024 * 16)
+
+/*  Media Engine control registers, see dev_psp_me.c:  */
+#define	PSP_ME_BASE	0x1cc00000
+
 MACHINE_SETUP(psp)
 {
 
@@ -50,7 +56,8 @@ MACHINE_SETUP(psp)
 	machine->machine_name = "Playstation Portable";
 	cpu->byte_order = EMUL_LITTLE_ENDIAN;
 
-	if (!machine->use_x11)
+	if (!machine->use_x11 && machine->screenshot_filename == NULL &&
+	    machine->output_prefix == NULL)
 		fprintf(stderr, "-------------------------------------"
 		    "------------------------------------------\n"
 		    "\n  WARNING! You are emulating a PSP without -X. "
@@ -61,8 +68,48 @@ MACHINE_SETUP(psp)
 	/*  480 x 272 pixels framebuffer (512 bytes per line)  */
 //	fb = dev_fb_init(machine, machine->memory, 0x04000000, VFB_PSP, 480,272, 512,1088, -15, "Playstation Portable");
 	fb = dev_fb_init(machine, machine->memory, 0x04000000, VFB_PSP, 480,272, 512,1088, 8, "Playstation Portable");
+	machine->main_fb = fb;
 //	io = dev_unimplemented_init(machine, machine->memory, 0xbf000000, VFB_PSP, 480,272, 512,1088, 8, "io at bf000000");
 
+	/*  The GE renders display lists into the framebuffer's VRAM:  */
+	dev_psp_ge_init(machine, fb);
+
+	/*
+	 *  RAM and VRAM are at fixed physical addresses, and every segment
+	 *  (user, uncached, kernel) maps them the same way, so plain loads
+	 *  and stores can go directly to host memory. RAM is allocated as
+	 *  one block up front, instead of one memblock per first write.
+	 *  (It is anonymous mmap()ed memory, so untouched pages still cost
+	 *  nothing, and two CPU threads can never race to allocate it.)
+	 */
+	memory_fastmem_ram(machine->memory,
+	    (uint64_t)machine->memory_offset_in_mb << 20,
+	    (uint64_t)machine->physical_ram_in_mb << 20);
+	memory_fastmem_map(machine->memory, 0x04000000,
+	    fb->framebuffer_size, fb->framebuffer, 1);
+
+	/*
+	 *  The second CPU (-n 2) is the Media Engine. With pthreads, it
+	 *  runs on its own host thread.
+	 */
+	if (machine->ncpus > 2) {
+		fatal("The PSP has two CPUs (use -n 2 to add the "
+		    "Media Engine).\n");
+		exit(1);
+	}
+	if (machine->ncpus == 2) {
+		dev_psp_me_init(machine, PSP_ME_BASE);
+#ifdef HAVE_PTHREADS
+		/*
+		 *  Snapshots and record/replay need both CPUs stopped at
+		 *  the same point, so the ME runs in lockstep with them.
+		 */
+		if (machine->checkpoint_filename == NULL &&
+		    machine->replay_mode == REPLAY_NONE)
+			machine->threaded_cpus = 1;
+#endif
+	}
+
 /*
 	note:	lots of devices is really painfully slow later in memory_rw
 		this should be heavily optimized
@@ -42,10 +42,12 @@
 #include "emul.h"
 #include "machine.h"
 #include "misc.h"
+#include "snapshot.h"
 
 
 extern volatile int single_step;
 extern int force_debugger_at_exit;
+extern int batch_mode;
 extern int show_opcode_statistics;
 
 extern int optind;
@@ -57,6 +59,7 @@ char *progname;
 
 int fully_deterministic = 0;
 int dyntrans_backend_enable = 1;
+int dyntrans_backend_verify = 0;
 
 
 /*****************************************************************************
@@ -226,6 +229,11 @@ static void usage(int longusage)
 	printf("  -B        disable native translation backends. (translation"
 	    " is turned on\n            by default, if it is supposed for "
 	    "the particular host)\n");
+#endif
+#ifdef DYNTRANS_BACKEND
+	printf("  -b        verify the native translation backend: run each "
+	    "native block\n            and the interpreter side by side, "
+	    "and stop on any difference\n");
 #endif
 	printf("  -C x      try to emulate a specific CPU. (Use -H to get a "
 	    "list of types.)\n");
@@ -245,6 +253,13 @@ static void usage(int longusage)
 	printf("                s      SCSI\n");
 	printf("                t      tape\n");
 	printf("                0-7    force a specific ID\n");
+	printf("  -F file   write the framebuffer to file as a PNG image at"
+	    " the end of the\n            simulation (and on SIGUSR1)\n");
+	printf("  -f pfx    write the guest's stdout, stderr and serial output"
+	    " to pfx.stdout,\n            pfx.stderr, pfx.uart1 etc."
+	    " instead of to the terminal\n");
+	printf("  -G file   profile the guest, and write a pprof profile to"
+	    " file\n");
 	printf("  -I x      emulate clock interrupts at x Hz (affects"
 	    " rtc devices only, not\n");
 	printf("            actual runtime speed) (this disables automatic"
@@ -255,17 +270,25 @@ static void usage(int longusage)
 	printf("                -j netbsd          for NetBSD/pmax\n");
 	printf("                -j bsd             for OpenBSD/pmax\n");
 	printf("                -j vmunix          for Ultrix/RISC\n");
+	printf("  -k f[:s]  append an incremental snapshot to file f every"
+	    " s seconds (default 5)\n");
+	printf("  -L file   record timer and input events to file\n");
+	printf("  -l file   replay timer and input events from file (as"
+	    " recorded with -L)\n");
 	printf("  -M m      emulate m MBs of physical RAM\n");
 	printf("  -m nr     run at most nr instructions (on any cpu)\n");
 	printf("  -N        display nr of instructions/second average, at"
 	    " regular intervals\n");
-	printf("  -n nr     set nr of CPUs (for SMP experiments)\n");
+	printf("  -n nr     set nr of CPUs (for SMP experiments, or -n 2 for the\n"
+	    "            PSP's Media Engine)\n");
 	printf("  -O        force netboot (tftp instead of disk), even when"
 	    " a disk image is\n"
 	    "            present (for DECstation, SGI, and ARC emulation)\n");
 	printf("  -o arg    set the boot argument (for DEC, ARC, or SGI"
 	    " emulation).\n");
 	printf("            Default arg for DEC is '-a', for ARC '-aN'.\n");
+	printf("  -P file   profile the guest, and write folded stacks (for"
+	    " flame graphs)\n            to file\n");
 	printf("  -p pc     add a breakpoint (remember to use the '0x' "
 	    "prefix for hex!)\n");
 	printf("  -Q        no built-in PROM emulation  (use this for "
@@ -278,6 +301,7 @@ static void usage(int longusage)
 	    "unimplemented memory accesses\n");
 	printf("  -t        show function trace tree\n");
 	printf("  -U        enable slow_serial_interrupts_hack_for_linux\n");
+	printf("  -w secs   run for at most secs seconds of host time\n");
 #ifdef WITH_X11
 	printf("  -X        use X11\n");
 #endif /*  WITH_X11  */
@@ -300,6 +324,9 @@ static void usage(int longusage)
 	    " get a list of\n            available emulation modes)\n");
 
 	printf("\nGeneral options:\n");
+	printf("  -a        batch mode: never enter the interactive debugger;"
+	    " exit with\n            status %i instead\n",
+	    MACHINE_EXIT_DEBUGGER);
 	printf("  -c cmd    add cmd as a command to run before starting "
 	    "the simulation\n");
 	printf("  -D        guarantee fully deterministic behaviour\n");
@@ -345,9 +372,12 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 	int msopts = 0;		/*  Machine-specific options used  */
 	struct machine *m = emul_add_machine(emul, "psp");
 
-	while ((ch = getopt(argc, argv, "ABC:c:Dd:E:e:HhI:iJj:KM:m:"
-	    "Nn:Oo:p:QqRrSsTtUu:VvW:XxY:y:Z:z:")) != -1) {
+	while ((ch = getopt(argc, argv, "aABbC:c:Dd:E:e:F:f:G:HhI:iJj:Kk:"
+	    "L:l:M:m:Nn:Oo:P:p:QqRrSsTtUu:VvW:w:XxY:y:Z:z:")) != -1) {
 		switch (ch) {
+		case 'a':
+			batch_mode = 1;
+			break;
 		case 'A':
 			m->dyntrans_alignment_check = 0;
 			msopts = 1;
@@ -358,6 +388,10 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 			dyntrans_backend_enable = 0;
 			msopts = 1;
 			break;
+		case 'b':
+			dyntrans_backend_verify = 1;
+			msopts = 1;
+			break;
 		case 'C':
 			m->cpu_name = strdup(optarg);
 			msopts = 1;
@@ -397,6 +431,30 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 			subtype = optarg;
 			msopts = 1;
 			break;
+		case 'F':
+			m->screenshot_filename = strdup(optarg);
+			if (m->screenshot_filename == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			msopts = 1;
+			break;
+		case 'f':
+			m->output_prefix = strdup(optarg);
+			if (m->output_prefix == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			msopts = 1;
+			break;
+		case 'G':
+			m->profile_pprof_filename = strdup(optarg);
+			if (m->profile_pprof_filename == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			msopts = 1;
+			break;
 		case 'H':
 			machine_list_available_types_and_cpus();
 			exit(1);
@@ -427,6 +485,32 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 		case 'K':
 			force_debugger_at_exit = 1;
 			break;
+		case 'k':
+			m->checkpoint_filename = strdup(optarg);
+			if (m->checkpoint_filename == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			m->checkpoint_interval = 5;
+			if (strchr(m->checkpoint_filename, ':') != NULL) {
+				char *p = strchr(m->checkpoint_filename, ':');
+				*p = '\0';
+				m->checkpoint_interval = atoi(p + 1);
+				if (m->checkpoint_interval < 1)
+					m->checkpoint_interval = 1;
+			}
+			msopts = 1;
+			break;
+		case 'L':
+		case 'l':
+			m->replay_filename = strdup(optarg);
+			if (m->replay_filename == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			m->replay_mode = ch == 'L'? REPLAY_RECORD : REPLAY_PLAY;
+			msopts = 1;
+			break;
 		case 'M':
 			m->physical_ram_in_mb = atoi(optarg);
 			msopts = 1;
@@ -456,6 +540,14 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 			}
 			msopts = 1;
 			break;
+		case 'P':
+			m->profile_folded_filename = strdup(optarg);
+			if (m->profile_folded_filename == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			msopts = 1;
+			break;
 		case 'p':
 			if (m->n_breakpoints >= MAX_BREAKPOINTS) {
 				fprintf(stderr, "too many breakpoints\n");
@@ -523,6 +615,14 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 		case 'W':
 			internal_w(optarg);
 			exit(0);
+		case 'w':
+			m->max_seconds = atoi(optarg);
+			if (m->max_seconds < 0) {
+				fprintf(stderr, "Invalid time limit.\n");
+				exit(1);
+			}
+			msopts = 1;
+			break;
 		case 'X':
 			m->use_x11 = 1;
 			// why ?!
@@ -834,8 +934,6 @@ int main(int argc, char *argv[])
 	console_warn_if_slaves_are_needed(1);
 
 	/*  Run all emulations:  */
-	emul_run(emuls, n_emuls);
-
-	return 0;
+	return emul_run(emuls, n_emuls);
 }
 
@@ -262,6 +262,37 @@ char *memory_conv_to_string(struct cpu *cpu, struct memory *mem, uint64_t addr,
 }
 
 
+/*
+ *  memory_fastmem_writes():
+ *
+ *  Merge the writes that went directly to device i's memory, through the
+ *  fastmem table, into the device's dyntrans write range.
+ */
+static void memory_fastmem_writes(struct memory *mem, int i)
+{
+	unsigned char *data = mem->dev_dyntrans_data[i];
+	uint64_t ofs;
+	int k;
+
+	for (k=0; k<N_FASTMEM_SLICES; k++) {
+		struct fastmem_slice *s = &mem->fastmem[k];
+
+		if (!s->track_writes || s->write_low > s->write_high ||
+		    s->host < data || s->host >= data + mem->dev_length[i])
+			continue;
+
+		ofs = s->host - data;
+		if (ofs + s->write_low < mem->dev_dyntrans_write_low[i])
+			mem->dev_dyntrans_write_low[i] = ofs + s->write_low;
+		if (ofs + s->write_high >= mem->dev_dyntrans_write_high[i])
+			mem->dev_dyntrans_write_high[i] = ofs + s->write_high;
+
+		s->write_low = (uint32_t) -1;
+		s->write_high = 0;
+	}
+}
+
+
 /*
  *  memory_device_dyntrans_access():
  *
@@ -282,6 +313,9 @@ void memory_device_dyntrans_access(struct cpu *cpu, struct memory *mem,
 		if (mem->dev_extra[i] == extra &&
 		    mem->dev_flags[i] & DM_DYNTRANS_WRITE_OK &&
 		    mem->dev_dyntrans_data[i] != NULL) {
+			if (mem->fastmem != NULL)
+				memory_fastmem_writes(mem, i);
+
 			if (mem->dev_dyntrans_write_low[i] != (uint64_t) -1)
 				need_inval = 1;
 			if (low != NULL)
@@ -593,3 +627,80 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 	return (unsigned char *) table[entry];
 }
 
+
+/*
+ *  memory_fastmem_map():
+ *
+ *  Map len bytes of physical memory at paddr (which must be at the start of
+ *  a fastmem slice) directly to host memory. If track_writes is set, then
+ *  the memory belongs to a device which wants to know where it has been
+ *  written to (see memory_device_dyntrans_access()).
+ */
+void memory_fastmem_map(struct memory *mem, uint64_t paddr, uint64_t len,
+	unsigned char *host, int track_writes)
+{
+	struct fastmem_slice *s;
+
+	if ((paddr & (FASTMEM_SLICE_SIZE - 1)) != 0 ||
+	    paddr + len > (uint64_t)FASTMEM_ADDR_MASK + 1) {
+		fatal("memory_fastmem_map(): bad range 0x%llx, len 0x%llx\n",
+		    (long long)paddr, (long long)len);
+		exit(1);
+	}
+
+	if (mem->fastmem == NULL)
+		mem->fastmem = zeroed_alloc(N_FASTMEM_SLICES *
+		    sizeof(struct fastmem_slice));
+
+	while (len > 0) {
+		s = &mem->fastmem[paddr >> FASTMEM_SLICE_SHIFT];
+		s->host = host;
+		s->limit = len < FASTMEM_SLICE_SIZE? len : FASTMEM_SLICE_SIZE;
+		s->track_writes = track_writes;
+		s->write_low = (uint32_t) -1;
+		s->write_high = 0;
+
+		host += s->limit;
+		paddr += s->limit;
+		len -= s->limit;
+	}
+}
+
+
+/*
+ *  memory_fastmem_ram():
+ *
+ *  Allocate len bytes of RAM at paddr as one contiguous host block, instead
+ *  of memblocks allocated on first write, and map it with
+ *  memory_fastmem_map(). Any memblock already in the range is copied in.
+ *  Returns a pointer to the host block.
+ */
+unsigned char *memory_fastmem_ram(struct memory *mem, uint64_t paddr,
+	uint64_t len)
+{
+	const int shrcount = MAX_BITS - BITS_PER_PAGETABLE;
+	const uint64_t blocksize = (uint64_t)1 << BITS_PER_MEMBLOCK;
+	void **table = mem->pagetable;
+	unsigned char *host;
+	uint64_t ofs;
+
+	if ((paddr | len) & (blocksize - 1)) {
+		fatal("memory_fastmem_ram(): 0x%llx, len 0x%llx is not "
+		    "memblock aligned\n", (long long)paddr, (long long)len);
+		exit(1);
+	}
+
+	host = zeroed_alloc(len);
+
+	for (ofs = 0; ofs < len; ofs += blocksize) {
+		int entry = ((paddr + ofs) >> shrcount) &
+		    ((1 << BITS_PER_PAGETABLE) - 1);
+		if (table[entry] != NULL)
+			memcpy(host + ofs, table[entry], blocksize);
+		table[entry] = host + ofs;
+	}
+
+	memory_fastmem_map(mem, paddr, len, host, 0);
+	return host;
+}
+
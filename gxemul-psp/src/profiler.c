@@ -0,0 +1,554 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Sampling profiler.
+ *
+ *  A tick function takes a sample of each running CPU every
+ *  1 << PROFILER_TICK_SHIFT cycles: the pc, and the return addresses into
+ *  the functions it was called from, as found by the CPU family's unwind
+ *  function. Identical stacks are counted in a hash table, so sampling is
+ *  cheap and the run is not slowed down noticeably; addresses are only
+ *  translated into symbol names (from the ELF symtab, the PSP bios and the
+ *  HLE import stubs) when the profile is written at the end of the run.
+ *
+ *  The profile is written as a flat list of the hottest functions on
+ *  stdout, and optionally to files:
+ *
+ *	-P file		folded stacks ("main;foo;bar 123" per line), the
+ *			input format of flamegraph.pl and speedscope
+ *
+ *	-G file		a pprof profile (profile.proto, not compressed),
+ *			with the function names included, so that no
+ *			binary is needed: "pprof -top file", "pprof -web
+ *			file", etc.
+ *
+ *  CPUs running on their own host threads (the PSP's Media Engine) can't
+ *  be unwound from the main thread, so only their pc is sampled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "machine.h"
+#include "misc.h"
+#include "profiler.h"
+#include "symbol.h"
+
+
+#define	PROFILER_HASH_SIZE	65536
+#define	PROFILER_N_TOP		25
+
+/*  Each distinct stack which has been sampled:  */
+struct profiler_stack {
+	struct profiler_stack	*next;
+	uint64_t		count;
+	int			cpu_id;
+	int			n_frames;
+	uint64_t		frames[1];	/*  pc first  */
+};
+
+/*  Symbolized functions and addresses, used when writing the profile:  */
+struct profiler_func {
+	struct profiler_func	*next;
+	char			*name;
+	int			id;
+	uint64_t		self;
+	uint64_t		total;
+	struct profiler_stack	*last_stack;
+};
+
+struct profiler_loc {
+	struct profiler_loc	*next;
+	uint64_t		addr;
+	int			id;
+	struct profiler_func	*func;
+};
+
+struct profiler {
+	struct machine		*machine;
+	uint64_t		n_samples;
+	struct profiler_stack	*stacks[PROFILER_HASH_SIZE];
+
+	struct profiler_func	*funcs[PROFILER_HASH_SIZE];
+	struct profiler_func	**func_list;
+	int			n_funcs;
+	struct profiler_loc	*locs[PROFILER_HASH_SIZE];
+	struct profiler_loc	**loc_list;
+	int			n_locs;
+};
+
+
+static unsigned int profiler_hash(uint64_t *frames, int n, int cpu_id)
+{
+	uint64_t h = 14695981039346656037ULL ^ cpu_id;
+	int i;
+
+	for (i=0; i<n; i++)
+		h = (h ^ frames[i]) * 1099511628211ULL;
+
+	return (h ^ (h >> 32)) & (PROFILER_HASH_SIZE - 1);
+}
+
+
+/*
+ *  profiler_tick():
+ *
+ *  Take one sample of each running CPU.
+ */
+static void profiler_tick(struct cpu *cpu0, void *extra)
+{
+	struct profiler *p = extra;
+	struct machine *machine = p->machine;
+	struct profiler_stack *s;
+	uint64_t frames[PROFILER_MAX_FRAMES];
+	unsigned int h;
+	int i, n;
+
+	for (i=0; i<machine->ncpus; i++) {
+		struct cpu *cpu = machine->cpus[i];
+
+		if (!cpu->running)
+			continue;
+
+		if ((i > 0 && machine->threaded_cpus) ||
+		    machine->cpu_family->unwind == NULL) {
+			frames[0] = cpu->pc;
+			if (cpu->is_32bit)
+				frames[0] = (uint32_t) frames[0];
+			n = 1;
+		} else
+			n = machine->cpu_family->unwind(cpu, frames,
+			    PROFILER_MAX_FRAMES);
+
+		h = profiler_hash(frames, n, i);
+		for (s = p->stacks[h]; s != NULL; s = s->next)
+			if (s->cpu_id == i && s->n_frames == n && memcmp(
+			    s->frames, frames, n * sizeof(uint64_t)) == 0)
+				break;
+
+		if (s == NULL) {
+			s = malloc(sizeof(struct profiler_stack) +
+			    (n - 1) * sizeof(uint64_t));
+			if (s == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			s->count = 0;
+			s->cpu_id = i;
+			s->n_frames = n;
+			memcpy(s->frames, frames, n * sizeof(uint64_t));
+			s->next = p->stacks[h];
+			p->stacks[h] = s;
+		}
+
+		s->count ++;
+		p->n_samples ++;
+	}
+}
+
+
+/*
+ *  profiler_init():
+ *
+ *  Start profiling, if -P or -G was used.
+ */
+void profiler_init(struct machine *machine)
+{
+	struct profiler *p;
+
+	if (machine->profile_folded_filename == NULL &&
+	    machine->profile_pprof_filename == NULL)
+		return;
+
+	p = malloc(sizeof(struct profiler));
+	if (p == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memset(p, 0, sizeof(struct profiler));
+	p->machine = machine;
+	machine->profiler = p;
+
+	machine_add_tickfunction(machine, profiler_tick, p,
+	    PROFILER_TICK_SHIFT);
+}
+
+
+/*
+ *  profiler_func():
+ *
+ *  Return the function called name, adding it if it's new.
+ */
+static struct profiler_func *profiler_func(struct profiler *p, char *name)
+{
+	struct profiler_func *f;
+	unsigned int h = 0;
+	char *q;
+
+	for (q=name; *q; q++)
+		h = h * 31 + (unsigned char) *q;
+	h &= PROFILER_HASH_SIZE - 1;
+
+	for (f = p->funcs[h]; f != NULL; f = f->next)
+		if (strcmp(f->name, name) == 0)
+			return f;
+
+	f = malloc(sizeof(struct profiler_func));
+	p->func_list = realloc(p->func_list,
+	    sizeof(struct profiler_func *) * (p->n_funcs + 1));
+	if (f == NULL || p->func_list == NULL ||
+	    (f->name = strdup(name)) == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	f->id = p->n_funcs + 1;
+	f->self = f->total = 0;
+	f->last_stack = NULL;
+	f->next = p->funcs[h];
+	p->funcs[h] = f;
+	p->func_list[p->n_funcs ++] = f;
+
+	return f;
+}
+
+
+/*
+ *  profiler_loc():
+ *
+ *  Return the location for an address, looking up its function's name if
+ *  the address is new.
+ */
+static struct profiler_loc *profiler_loc(struct profiler *p, uint64_t addr)
+{
+	struct symbol_context *sc = &p->machine->symbol_context;
+	struct profiler_loc *l;
+	uint64_t offset;
+	char *symbol, name[300];
+	unsigned int h = profiler_hash(&addr, 1, 0);
+
+	for (l = p->locs[h]; l != NULL; l = l->next)
+		if (l->addr == addr)
+			return l;
+
+	/*  The same psp hack as in cpu_functioncall_trace():  */
+	symbol = get_symbol_name(sc, addr, &offset);
+	if (symbol == NULL)
+		symbol = get_symbol_name(sc, addr & ~0xc0000000ULL, &offset);
+
+	if (symbol != NULL) {
+		snprintf(name, sizeof(name), "%s", symbol);
+		/*  Only the function, not "+0x..." within it:  */
+		if (offset != 0 && strrchr(name, '+') != NULL)
+			*strrchr(name, '+') = '\0';
+	} else
+		snprintf(name, sizeof(name), "0x%llx", (long long)addr);
+
+	l = malloc(sizeof(struct profiler_loc));
+	p->loc_list = realloc(p->loc_list,
+	    sizeof(struct profiler_loc *) * (p->n_locs + 1));
+	if (l == NULL || p->loc_list == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	l->addr = addr;
+	l->id = p->n_locs + 1;
+	l->func = profiler_func(p, name);
+	l->next = p->locs[h];
+	p->locs[h] = l;
+	p->loc_list[p->n_locs ++] = l;
+
+	return l;
+}
+
+
+static int profiler_func_compare(const void *a, const void *b)
+{
+	struct profiler_func *fa = *(struct profiler_func **)a;
+	struct profiler_func *fb = *(struct profiler_func **)b;
+
+	if (fa->self != fb->self)
+		return fa->self < fb->self? 1 : -1;
+	if (fa->total != fb->total)
+		return fa->total < fb->total? 1 : -1;
+	return strcmp(fa->name, fb->name);
+}
+
+
+/*
+ *  profiler_write_folded():
+ *
+ *  One line per stack: the function names, outermost first, separated by
+ *  semicolons, followed by the number of samples. On machines with more
+ *  than one CPU, the CPU is the outermost "function".
+ */
+static void profiler_write_folded(struct profiler *p, char *filename)
+{
+	struct profiler_stack *s;
+	FILE *f;
+	int h, i;
+
+	f = fopen(filename, "w");
+	if (f == NULL) {
+		perror(filename);
+		return;
+	}
+
+	for (h=0; h<PROFILER_HASH_SIZE; h++)
+		for (s = p->stacks[h]; s != NULL; s = s->next) {
+			if (p->machine->ncpus > 1)
+				fprintf(f, "cpu%i;", s->cpu_id);
+			for (i=s->n_frames-1; i>=0; i--)
+				fprintf(f, "%s%s", profiler_loc(p,
+				    s->frames[i])->func->name, i? ";" : "");
+			fprintf(f, " %llu\n", (unsigned long long)s->count);
+		}
+
+	fclose(f);
+}
+
+
+/*
+ *  A minimal protocol buffer writer, for profiler_write_pprof():
+ */
+struct pbuf {
+	unsigned char	*data;
+	size_t		len;
+	size_t		size;
+};
+
+static void pb_raw(struct pbuf *b, void *data, size_t len)
+{
+	if (b->len + len > b->size) {
+		b->size = (b->len + len) * 2 + 256;
+		b->data = realloc(b->data, b->size);
+		if (b->data == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+}
+
+static void pb_varint(struct pbuf *b, uint64_t x)
+{
+	unsigned char buf[10];
+	int n = 0;
+
+	do {
+		buf[n] = x & 0x7f;
+		x >>= 7;
+		if (x != 0)
+			buf[n] |= 0x80;
+		n ++;
+	} while (x != 0);
+
+	pb_raw(b, buf, n);
+}
+
+static void pb_uint(struct pbuf *b, int field, uint64_t x)
+{
+	pb_varint(b, field << 3);
+	pb_varint(b, x);
+}
+
+static void pb_bytes(struct pbuf *b, int field, void *data, size_t len)
+{
+	pb_varint(b, (field << 3) | 2);
+	pb_varint(b, len);
+	pb_raw(b, data, len);
+}
+
+/*  Append the message m as field, and empty m for reuse:  */
+static void pb_message(struct pbuf *b, int field, struct pbuf *m)
+{
+	pb_bytes(b, field, m->data, m->len);
+	m->len = 0;
+}
+
+
+/*
+ *  profiler_write_pprof():
+ *
+ *  Write the profile in pprof's format (see profile.proto in the pprof
+ *  sources). The string table starts with the fixed strings below, and
+ *  function i's name is string PPROF_FIRST_NAME + i - 1.
+ */
+#define	PPROF_SAMPLES		1
+#define	PPROF_COUNT		2
+#define	PPROF_INSTRUCTIONS	3
+#define	PPROF_CPU		4
+#define	PPROF_FIRST_NAME	5
+static char *pprof_strings[PPROF_FIRST_NAME] =
+    { "", "samples", "count", "instructions", "cpu" };
+
+static void profiler_write_pprof(struct profiler *p, char *filename)
+{
+	struct pbuf b, m, sub;
+	struct profiler_stack *s;
+	FILE *f;
+	int h, i;
+
+	memset(&b, 0, sizeof(b));
+	memset(&m, 0, sizeof(m));
+	memset(&sub, 0, sizeof(sub));
+
+	/*  sample_type: samples/count and instructions/count  */
+	pb_uint(&m, 1, PPROF_SAMPLES);
+	pb_uint(&m, 2, PPROF_COUNT);
+	pb_message(&b, 1, &m);
+	pb_uint(&m, 1, PPROF_INSTRUCTIONS);
+	pb_uint(&m, 2, PPROF_COUNT);
+	pb_message(&b, 1, &m);
+
+	/*  samples (this also symbolizes all locations):  */
+	for (h=0; h<PROFILER_HASH_SIZE; h++)
+		for (s = p->stacks[h]; s != NULL; s = s->next) {
+			for (i=0; i<s->n_frames; i++)
+				pb_varint(&sub, profiler_loc(p,
+				    s->frames[i])->id);
+			pb_message(&m, 1, &sub);
+			pb_varint(&sub, s->count);
+			pb_varint(&sub, s->count << PROFILER_TICK_SHIFT);
+			pb_message(&m, 2, &sub);
+			if (p->machine->ncpus > 1) {
+				pb_uint(&sub, 1, PPROF_CPU);
+				pb_uint(&sub, 3, s->cpu_id);
+				pb_message(&m, 3, &sub);
+			}
+			pb_message(&b, 2, &m);
+		}
+
+	/*  One mapping, covering everything, with the functions known:  */
+	pb_uint(&m, 1, 1);
+	pb_uint(&m, 3, (uint64_t) -1);
+	pb_uint(&m, 7, 1);
+	pb_message(&b, 3, &m);
+
+	for (i=0; i<p->n_locs; i++) {
+		pb_uint(&m, 1, p->loc_list[i]->id);
+		pb_uint(&m, 2, 1);
+		pb_uint(&m, 3, p->loc_list[i]->addr);
+		pb_uint(&sub, 1, p->loc_list[i]->func->id);
+		pb_message(&m, 4, &sub);
+		pb_message(&b, 4, &m);
+	}
+
+	for (i=0; i<p->n_funcs; i++) {
+		pb_uint(&m, 1, p->func_list[i]->id);
+		pb_uint(&m, 2, PPROF_FIRST_NAME + i);
+		pb_uint(&m, 3, PPROF_FIRST_NAME + i);
+		pb_message(&b, 5, &m);
+	}
+
+	for (i=0; i<PPROF_FIRST_NAME; i++)
+		pb_bytes(&b, 6, pprof_strings[i], strlen(pprof_strings[i]));
+	for (i=0; i<p->n_funcs; i++)
+		pb_bytes(&b, 6, p->func_list[i]->name,
+		    strlen(p->func_list[i]->name));
+
+	/*  period_type and period:  */
+	pb_uint(&m, 1, PPROF_INSTRUCTIONS);
+	pb_uint(&m, 2, PPROF_COUNT);
+	pb_message(&b, 11, &m);
+	pb_uint(&b, 12, 1 << PROFILER_TICK_SHIFT);
+
+	f = fopen(filename, "wb");
+	if (f == NULL)
+		perror(filename);
+	else {
+		if (fwrite(b.data, 1, b.len, f) != b.len)
+			perror(filename);
+		fclose(f);
+	}
+
+	free(b.data);
+	free(m.data);
+	free(sub.data);
+}
+
+
+/*
+ *  profiler_report():
+ *
+ *  Called at the end of the run: print the flat profile, and write the
+ *  -P and -G files.
+ */
+void profiler_report(struct machine *machine)
+{
+	struct profiler *p = machine->profiler;
+	struct profiler_stack *s;
+	struct profiler_func *f, **sorted;
+	int h, i;
+
+	if (p == NULL)
+		return;
+
+	if (p->n_samples == 0) {
+		printf("profile: no samples\n");
+		return;
+	}
+
+	for (h=0; h<PROFILER_HASH_SIZE; h++)
+		for (s = p->stacks[h]; s != NULL; s = s->next)
+			for (i=0; i<s->n_frames; i++) {
+				f = profiler_loc(p, s->frames[i])->func;
+				if (i == 0)
+					f->self += s->count;
+				/*  Count recursive functions only once:  */
+				if (f->last_stack != s) {
+					f->total += s->count;
+					f->last_stack = s;
+				}
+			}
+
+	sorted = malloc(sizeof(struct profiler_func *) * p->n_funcs);
+	if (sorted == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memcpy(sorted, p->func_list,
+	    sizeof(struct profiler_func *) * p->n_funcs);
+	qsort(sorted, p->n_funcs, sizeof(struct profiler_func *),
+	    profiler_func_compare);
+
+	printf("profile: %llu samples, one every %i cycles\n",
+	    (unsigned long long)p->n_samples, 1 << PROFILER_TICK_SHIFT);
+	printf("   self   total  function\n");
+	for (i=0; i<p->n_funcs && i<PROFILER_N_TOP; i++) {
+		f = sorted[i];
+		printf(" %5.1f%%  %5.1f%%  %s\n",
+		    100.0 * f->self / p->n_samples,
+		    100.0 * f->total / p->n_samples, f->name);
+	}
+	free(sorted);
+
+	if (machine->profile_folded_filename != NULL)
+		profiler_write_folded(p, machine->profile_folded_filename);
+	if (machine->profile_pprof_filename != NULL)
+		profiler_write_pprof(p, machine->profile_pprof_filename);
+}
@@ -12,40 +12,40 @@ PSP_Syscall pspsyscalls[]={
 {0x200a,0x0c106e53,0x00000000,"sceKernelRegisterThreadEventHandler",HLE_unknown,4},
 {0x200b,0x72f3c145,0x00000000,"sceKernelReleaseThreadEventHandler",HLE_unknown,4},
 {0x200c,0x369eeb6b,0x00000000,"sceKernelReferThreadEventHandlerStatus",HLE_unknown,4},
-{0x200d,0xe81caf8f,0x00000000,"sceKernelCreateCallback",HLE_unknown,4},
-{0x200e,0xedba5844,0x00000000,"sceKernelDeleteCallback",HLE_unknown,4},
+{0x200d,0xe81caf8f,0x00000000,"sceKernelCreateCallback",HLE_sceKernelCreateCallback,3},
+{0x200e,0xedba5844,0x00000000,"sceKernelDeleteCallback",HLE_sceKernelDeleteCallback,1},
 {0x200f,0xc11ba8c4,0x00000000,"sceKernelNotifyCallback",HLE_unknown,4},
 {0x2010,0xba4051d6,0x00000000,"sceKernelCancelCallback",HLE_unknown,4},
 {0x2011,0x2a3d44ff,0x00000000,"sceKernelGetCallbackCount",HLE_unknown,4},
-{0x2012,0x349d6d6c,0x00000000,"sceKernelCheckCallback",HLE_unknown,4},
+{0x2012,0x349d6d6c,0x00000000,"sceKernelCheckCallback",HLE_sceKernelCheckCallback,0},
 {0x2013,0x730ed8bc,0x00000000,"sceKernelReferCallbackStatus",HLE_unknown,4},
-{0x2014,0x9ace131e,0x00000000,"sceKernelSleepThread",HLE_unknown,4},
-{0x2015,0x82826f70,0x00000000,"sceKernelSleepThreadCB",HLE_unknown,4},
-{0x2016,0xd59ead2f,0x00000000,"sceKernelWakeupThread",HLE_unknown,4},
+{0x2014,0x9ace131e,0x00000000,"sceKernelSleepThread",HLE_sceKernelSleepThread,0},
+{0x2015,0x82826f70,0x00000000,"sceKernelSleepThreadCB",HLE_sceKernelSleepThread,0},
+{0x2016,0xd59ead2f,0x00000000,"sceKernelWakeupThread",HLE_sceKernelWakeupThread,1},
 {0x2017,0xfccfad26,0x00000000,"sceKernelCancelWakeupThread",HLE_unknown,4},
 {0x2018,0x9944f31f,0x00000000,"sceKernelSuspendThread",HLE_unknown,4},
 {0x2019,0x75156e8f,0x00000000,"sceKernelResumeThread",HLE_unknown,4},
-{0x201a,0x278c0df5,0x00000000,"sceKernelWaitThreadEnd",HLE_unknown,4},
-{0x201b,0x840e8133,0x00000000,"sceKernelWaitThreadEndCB",HLE_unknown,4},
-{0x201c,0xceadeb47,0x00000000,"sceKernelDelayThread",HLE_unknown,4},
-{0x201d,0x68da9e36,0x00000000,"sceKernelDelayThreadCB",HLE_unknown,4},
+{0x201a,0x278c0df5,0x00000000,"sceKernelWaitThreadEnd",HLE_sceKernelWaitThreadEnd,2},
+{0x201b,0x840e8133,0x00000000,"sceKernelWaitThreadEndCB",HLE_sceKernelWaitThreadEnd,2},
+{0x201c,0xceadeb47,0x00000000,"sceKernelDelayThread",HLE_sceKernelDelayThread,1},
+{0x201d,0x68da9e36,0x00000000,"sceKernelDelayThreadCB",HLE_sceKernelDelayThread,1},
 {0x201e,0xbd123d9e,0x00000000,"sceKernelDelaySysClockThread",HLE_unknown,4},
 {0x201f,0x1181e963,0x00000000,"sceKernelDelaySysClockThreadCB",HLE_unknown,4},
-{0x2020,0xd6da4ba1,0x00000000,"sceKernelCreateSema",HLE_unknown,4},
-{0x2021,0x28b6489c,0x00000000,"sceKernelDeleteSema",HLE_unknown,4},
-{0x2022,0x3f53e640,0x00000000,"sceKernelSignalSema",HLE_unknown,4},
-{0x2023,0x4e3a1105,0x00000000,"sceKernelWaitSema",HLE_unknown,4},
-{0x2024,0x6d212bac,0x00000000,"sceKernelWaitSemaCB",HLE_unknown,4},
-{0x2025,0x58b1f937,0x00000000,"sceKernelPollSema",HLE_unknown,4},
+{0x2020,0xd6da4ba1,0x00000000,"sceKernelCreateSema",HLE_sceKernelCreateSema,5},
+{0x2021,0x28b6489c,0x00000000,"sceKernelDeleteSema",HLE_sceKernelDeleteSema,1},
+{0x2022,0x3f53e640,0x00000000,"sceKernelSignalSema",HLE_sceKernelSignalSema,2},
+{0x2023,0x4e3a1105,0x00000000,"sceKernelWaitSema",HLE_sceKernelWaitSema,3},
+{0x2024,0x6d212bac,0x00000000,"sceKernelWaitSemaCB",HLE_sceKernelWaitSema,3},
+{0x2025,0x58b1f937,0x00000000,"sceKernelPollSema",HLE_sceKernelPollSema,2},
 {0x2026,0x8ffdf9a2,0x00000000,"sceKernelCancelSema",HLE_unknown,4},
-{0x2027,0xbc6febc5,0x00000000,"sceKernelReferSemaStatus",HLE_unknown,4},
-{0x2028,0x55c20a00,0x00000000,"sceKernelCreateEventFlag",HLE_unknown,4},
-{0x2029,0xef9e4c70,0x00000000,"sceKernelDeleteEventFlag",HLE_unknown,4},
-{0x202a,0x1fb15a32,0x00000000,"sceKernelSetEventFlag",HLE_unknown,4},
-{0x202b,0x812346e4,0x00000000,"sceKernelClearEventFlag",HLE_unknown,4},
-{0x202c,0x402fcf22,0x00000000,"sceKernelWaitEventFlag",HLE_unknown,4},
-{0x202d,0x328c546a,0x00000000,"sceKernelWaitEventFlagCB",HLE_unknown,4},
-{0x202e,0x30fd48f0,0x00000000,"sceKernelPollEventFlag",HLE_unknown,4},
+{0x2027,0xbc6febc5,0x00000000,"sceKernelReferSemaStatus",HLE_sceKernelReferSemaStatus,2},
+{0x2028,0x55c20a00,0x00000000,"sceKernelCreateEventFlag",HLE_sceKernelCreateEventFlag,4},
+{0x2029,0xef9e4c70,0x00000000,"sceKernelDeleteEventFlag",HLE_sceKernelDeleteEventFlag,1},
+{0x202a,0x1fb15a32,0x00000000,"sceKernelSetEventFlag",HLE_sceKernelSetEventFlag,2},
+{0x202b,0x812346e4,0x00000000,"sceKernelClearEventFlag",HLE_sceKernelClearEventFlag,2},
+{0x202c,0x402fcf22,0x00000000,"sceKernelWaitEventFlag",HLE_sceKernelWaitEventFlag,5},
+{0x202d,0x328c546a,0x00000000,"sceKernelWaitEventFlagCB",HLE_sceKernelWaitEventFlag,5},
+{0x202e,0x30fd48f0,0x00000000,"sceKernelPollEventFlag",HLE_sceKernelPollEventFlag,4},
 {0x202f,0xcd203292,0x00000000,"sceKernelCancelEventFlag",HLE_unknown,4},
 {0x2030,0xa66b0120,0x00000000,"sceKernelReferEventFlagStatus",HLE_unknown,4},
 {0x2031,0x8125221d,0x00000000,"sceKernelCreateMbx",HLE_unknown,4},
@@ -87,9 +87,9 @@ PSP_Syscall pspsyscalls[]={
 {0x2055,0xc8cd158c,0x00000000,"sceKernelUSec2SysClockWide",HLE_unknown,4},
 {0x2056,0xba6b92e2,0x00000000,"sceKernelSysClock2USec",HLE_unknown,4},
 {0x2057,0xe1619d7c,0x00000000,"sceKernelSysClock2USecWide",HLE_unknown,4},
-{0x2058,0xdb738f35,0x00000000,"sceKernelGetSystemTime",HLE_unknown,4},
-{0x2059,0x82bc5777,0x00000000,"sceKernelGetSystemTimeWide",HLE_unknown,4},
-{0x205a,0x369ed59d,0x00000000,"sceKernelGetSystemTimeLow",HLE_unknown,4},
+{0x2058,0xdb738f35,0x00000000,"sceKernelGetSystemTime",HLE_sceKernelGetSystemTime,1},
+{0x2059,0x82bc5777,0x00000000,"sceKernelGetSystemTimeWide",HLE_sceKernelGetSystemTimeWide,0},
+{0x205a,0x369ed59d,0x00000000,"sceKernelGetSystemTimeLow",HLE_sceKernelGetSystemTimeLow,0},
 {0x205b,0x6652b8ca,0x00000000,"sceKernelSetAlarm",HLE_unknown,4},
 {0x205c,0xb2c25152,0x00000000,"sceKernelSetSysClockAlarm",HLE_unknown,4},
 {0x205d,0x7e65b999,0x00000000,"sceKernelCancelAlarm",HLE_unknown,4},
@@ -109,10 +109,10 @@ PSP_Syscall pspsyscalls[]={
 {0x206b,0xd2d615ef,0x00000000,"sceKernelCancelVTimerHandler",HLE_unknown,4},
 {0x206c,0x5f32beaa,0x00000000,"sceKernelReferVTimerStatus",HLE_unknown,4},
 {0x206d,0x446d8de6,0x00000000,"sceKernelCreateThread",HLE_sceKernelCreateThread,4},
-{0x206e,0x9fa03cd3,0x00000000,"sceKernelDeleteThread",HLE_unknown,4},
+{0x206e,0x9fa03cd3,0x00000000,"sceKernelDeleteThread",HLE_sceKernelDeleteThread,1},
 {0x206f,0xf475845d,0x00000000,"sceKernelStartThread",HLE_sceKernelStartThread,3},
-{0x2070,0x532a522e,0x00000000,"_sceKernelExitThread",HLE_unknown,4},
-{0x2071,0xaa73c935,0x00000000,"sceKernelExitThread",HLE_unknown,4},
+{0x2070,0x532a522e,0x00000000,"_sceKernelExitThread",HLE_sceKernelExitThread,1},
+{0x2071,0xaa73c935,0x00000000,"sceKernelExitThread",HLE_sceKernelExitThread,1},
 {0x2072,0x809ce29b,0x00000000,"sceKernelExitDeleteThread",HLE_sceKernelExitDeleteThread,1},
 {0x2073,0x616403ba,0x00000000,"sceKernelTerminateThread",HLE_unknown,4},
 {0x2074,0x383f7bcc,0x00000000,"sceKernelTerminateDeleteThread",HLE_unknown,4},
@@ -122,7 +122,7 @@ PSP_Syscall pspsyscalls[]={
 {0x2078,0x71bc9871,0x00000000,"sceKernelChangeThreadPriority",HLE_unknown,4},
 {0x2079,0x912354a7,0x00000000,"sceKernelRotateThreadReadyQueue",HLE_unknown,4},
 {0x207a,0x2c34e053,0x00000000,"sceKernelReleaseWaitThread",HLE_unknown,4},
-{0x207b,0x293b45b8,0x00000000,"sceKernelGetThreadId",HLE_unknown,4},
+{0x207b,0x293b45b8,0x00000000,"sceKernelGetThreadId",HLE_sceKernelGetThreadId,0},
 {0x207c,0x94aa61ee,0x00000000,"sceKernelGetThreadCurrentPriority",HLE_unknown,4},
 {0x207d,0x3b183e26,0x00000000,"sceKernelGetThreadExitStatus",HLE_unknown,4},
 {0x207e,0xd13bde95,0x00000000,"sceKernelCheckThreadStack",HLE_unknown,4},
@@ -148,23 +148,23 @@ PSP_Syscall pspsyscalls[]={
 {0x2092,0xa0b5a7c2,0x00000000,"sceIoReadAsync",HLE_unknown,4},
 {0x2093,0x42ec03ac,0x00000000,"sceIoWrite",HLE_sceIoWrite,3},
 {0x2094,0x0facab19,0x00000000,"sceIoWriteAsync",HLE_unknown,4},
-{0x2095,0x27eb27b8,0x00000000,"sceIoLseek",HLE_unknown,4},
+{0x2095,0x27eb27b8,0x00000000,"sceIoLseek",HLE_sceIoLseek,5},
 {0x2096,0x71b19e77,0x00000000,"sceIoLseekAsync",HLE_unknown,4},
-{0x2097,0x68963324,0x00000000,"sceIoLseek32",HLE_unknown,4},
+{0x2097,0x68963324,0x00000000,"sceIoLseek32",HLE_sceIoLseek32,3},
 {0x2098,0x1b385d8f,0x00000000,"sceIoLseek32Async",HLE_unknown,4},
 {0x2099,0x63632449,0x00000000,"sceIoIoctl",HLE_unknown,4},
 {0x209a,0xe95a012b,0x00000000,"sceIoIoctlAsync",HLE_unknown,4},
 {0x209b,0xb29ddf9c,0x00000000,"sceIoDopen",HLE_sceIoDopen,1},
 {0x209c,0xe3eb004c,0x00000000,"sceIoDread",HLE_sceIoDread,2},
 {0x209d,0xeb092469,0x00000000,"sceIoDclose",HLE_sceIoDclose,1},
-{0x209e,0xf27a9c51,0x00000000,"sceIoRemove",HLE_unknown,4},
-{0x209f,0x06a70004,0x00000000,"sceIoMkdir",HLE_unknown,4},
-{0x20a0,0x1117c65f,0x00000000,"sceIoRmdir",HLE_unknown,4},
+{0x209e,0xf27a9c51,0x00000000,"sceIoRemove",HLE_sceIoRemove,1},
+{0x209f,0x06a70004,0x00000000,"sceIoMkdir",HLE_sceIoMkdir,2},
+{0x20a0,0x1117c65f,0x00000000,"sceIoRmdir",HLE_sceIoRmdir,1},
 {0x20a1,0x55f4717d,0x00000000,"sceIoChdir",HLE_sceIoChdir,1},
 {0x20a2,0xab96437f,0x00000000,"sceIoSync",HLE_unknown,4},
 {0x20a3,0xace946e8,0x00000000,"sceIoGetstat",HLE_sceIoGetstat,2},
 {0x20a4,0xb8a740f4,0x00000000,"sceIoChstat",HLE_unknown,4},
-{0x20a5,0x779103a0,0x00000000,"sceIoRename",HLE_unknown,4},
+{0x20a5,0x779103a0,0x00000000,"sceIoRename",HLE_sceIoRename,2},
 {0x20a6,0x54f5fb11,0x00000000,"sceIoDevctl",HLE_unknown,4},
 {0x20a7,0x08bd7374,0x00000000,"sceIoGetDevType",HLE_unknown,4},
 {0x20a8,0xb2a628c1,0x00000000,"sceIoAssign",HLE_unknown,4},
@@ -179,7 +179,7 @@ PSP_Syscall pspsyscalls[]={
 {0x20b1,0x172d316e,0x00000000,"sceKernelStdin",HLE_sceKernelStdin,0},
 {0x20b2,0xa6bab2e9,0x00000000,"sceKernelStdout",HLE_sceKernelStdout,0},
 {0x20b3,0xf78ba90a,0x00000000,"sceKernelStderr",HLE_sceKernelStderr,0},
-{0x20b4,0xbfa98062,0x00000000,"sceKernelDcacheInvalidateRange",HLE_unknown,4},
+{0x20b4,0xbfa98062,0x00000000,"sceKernelDcacheInvalidateRange",HLE_sceKernelCacheNop,0},
 {0x20b5,0xc8186a58,0x00000000,"sceKernelUtilsMd5Digest",HLE_unknown,4},
 {0x20b6,0x9e5c5086,0x00000000,"sceKernelUtilsMd5BlockInit",HLE_unknown,4},
 {0x20b7,0x61e1e525,0x00000000,"sceKernelUtilsMd5BlockUpdate",HLE_unknown,4},
@@ -192,13 +192,13 @@ PSP_Syscall pspsyscalls[]={
 {0x20be,0x06fb8a63,0x00000000,"sceKernelUtilsMt19937UInt",HLE_unknown,4},
 {0x20bf,0x37fb5c42,0x00000000,"sceKernelGetGPI",HLE_unknown,4},
 {0x20c0,0x6ad345d7,0x00000000,"sceKernelSetGPO",HLE_unknown,4},
-{0x20c1,0x91e4f6a7,0x00000000,"sceKernelLibcClock",HLE_unknown,4},
-{0x20c2,0x27cc57f0,0x00000000,"sceKernelLibcTime",HLE_unknown,4},
-{0x20c3,0x71ec4271,0x00000000,"sceKernelLibcGettimeofday",HLE_unknown,4},
-{0x20c4,0x79d1c3fa,0x00000000,"sceKernelDcacheWritebackAll",HLE_unknown,4},
-{0x20c5,0xb435dec5,0x00000000,"sceKernelDcacheWritebackInvalidateAll",HLE_unknown,4},
-{0x20c6,0x3ee30821,0x00000000,"sceKernelDcacheWritebackRange",HLE_unknown,4},
-{0x20c7,0x34b9fa9e,0x00000000,"sceKernelDcacheWritebackInvalidateRange",HLE_unknown,4},
+{0x20c1,0x91e4f6a7,0x00000000,"sceKernelLibcClock",HLE_sceKernelLibcClock,0},
+{0x20c2,0x27cc57f0,0x00000000,"sceKernelLibcTime",HLE_sceKernelLibcTime,1},
+{0x20c3,0x71ec4271,0x00000000,"sceKernelLibcGettimeofday",HLE_sceKernelLibcGettimeofday,2},
+{0x20c4,0x79d1c3fa,0x00000000,"sceKernelDcacheWritebackAll",HLE_sceKernelCacheNop,0},
+{0x20c5,0xb435dec5,0x00000000,"sceKernelDcacheWritebackInvalidateAll",HLE_sceKernelCacheNop,0},
+{0x20c6,0x3ee30821,0x00000000,"sceKernelDcacheWritebackRange",HLE_sceKernelCacheNop,0},
+{0x20c7,0x34b9fa9e,0x00000000,"sceKernelDcacheWritebackInvalidateRange",HLE_sceKernelCacheNop,0},
 {0x20c8,0x80001c4c,0x00000000,"sceKernelDcacheProbe",HLE_unknown,4},
 {0x20c9,0x16641d70,0x00000000,"sceKernelDcacheReadTag",HLE_unknown,4},
 {0x20ca,0x4fd31c9d,0x00000000,"sceKernelIcacheProbe",HLE_unknown,4},
@@ -223,38 +223,38 @@ PSP_Syscall pspsyscalls[]={
 {0x20dd,0x3aee7261,0x00000000,"sceKernelPowerUnlock",HLE_unknown,4},
 {0x20de,0x090ccb3f,0x00000000,"sceKernelPowerTick",HLE_unknown,4},
 {0x20df,0xbd2f1094,0x00000000,"sceKernelLoadExec",HLE_unknown,4},
-{0x20e0,0x2ac9954b,0x00000000,"sceKernelExitGameWithStatus",HLE_unknown,4},
-{0x20e1,0x05572a5f,0x00000000,"sceKernelExitGame",HLE_unknown,4},
-{0x20e2,0x4ac57943,0x00000000,"sceKernelRegisterExitCallback",HLE_unknown,4},
+{0x20e0,0x2ac9954b,0x00000000,"sceKernelExitGameWithStatus",HLE_sceKernelExitGameWithStatus,1},
+{0x20e1,0x05572a5f,0x00000000,"sceKernelExitGame",HLE_sceKernelExitGame,0},
+{0x20e2,0x4ac57943,0x00000000,"sceKernelRegisterExitCallback",HLE_sceKernelRegisterExitCallback,1},
 {0x20e3,0x617f3fe6,0x00000000,"sceDmacMemcpy",HLE_unknown,4},
 {0x20e4,0xd97f94d8,0x00000000,"sceDmacTryMemcpy",HLE_unknown,4},
-{0x20e5,0x1f6752ad,0x00000000,"sceGeEdramGetSize",HLE_unknown,4},
+{0x20e5,0x1f6752ad,0x00000000,"sceGeEdramGetSize",HLE_sceGeEdramGetSize,0},
 {0x20e6,0xe47e40e4,0x00000000,"sceGeEdramGetAddr",HLE_sceGeEdramGetAddr,0},
 {0x20e7,0xb77905ea,0x00000000,"sceGeEdramSetAddrTranslation",HLE_unknown,4},
-{0x20e8,0xdc93cfef,0x00000000,"sceGeGetCmd",HLE_unknown,4},
-{0x20e9,0x57c8945b,0x00000000,"sceGeGetMtx",HLE_unknown,4},
+{0x20e8,0xdc93cfef,0x00000000,"sceGeGetCmd",HLE_sceGeGetCmd,1},
+{0x20e9,0x57c8945b,0x00000000,"sceGeGetMtx",HLE_sceGeGetMtx,2},
 {0x20ea,0x438a385a,0x00000000,"sceGeSaveContext",HLE_unknown,4},
 {0x20eb,0x0bf608fb,0x00000000,"sceGeRestoreContext",HLE_unknown,4},
-{0x20ec,0xab49e76a,0x00000000,"sceGeListEnQueue",HLE_unknown,4},
-{0x20ed,0x1c0d95a6,0x00000000,"sceGeListEnQueueHead",HLE_unknown,4},
-{0x20ee,0x5fb86ab0,0x00000000,"sceGeListDeQueue",HLE_unknown,4},
-{0x20ef,0xe0d68148,0x00000000,"sceGeListUpdateStallAddr",HLE_unknown,4},
-{0x20f0,0x03444eb4,0x00000000,"sceGeListSync",HLE_unknown,4},
-{0x20f1,0xb287bd61,0x00000000,"sceGeDrawSync",HLE_unknown,4},
+{0x20ec,0xab49e76a,0x00000000,"sceGeListEnQueue",HLE_sceGeListEnQueue,4},
+{0x20ed,0x1c0d95a6,0x00000000,"sceGeListEnQueueHead",HLE_sceGeListEnQueueHead,4},
+{0x20ee,0x5fb86ab0,0x00000000,"sceGeListDeQueue",HLE_sceGeListDeQueue,1},
+{0x20ef,0xe0d68148,0x00000000,"sceGeListUpdateStallAddr",HLE_sceGeListUpdateStallAddr,2},
+{0x20f0,0x03444eb4,0x00000000,"sceGeListSync",HLE_sceGeListSync,2},
+{0x20f1,0xb287bd61,0x00000000,"sceGeDrawSync",HLE_sceGeDrawSync,1},
 {0x20f2,0xb448ec0d,0x00000000,"sceGeBreak",HLE_unknown,4},
 {0x20f3,0x4c06e472,0x00000000,"sceGeContinue",HLE_unknown,4},
-{0x20f4,0xa4fc06a4,0x00000000,"sceGeSetCallback",HLE_unknown,4},
-{0x20f5,0x05db22ce,0x00000000,"sceGeUnsetCallback",HLE_unknown,4},
-{0x20f6,0xc41c2853,0x00000000,"sceRtcGetTickResolution",HLE_unknown,4},
-{0x20f7,0x3f7ad767,0x00000000,"sceRtcGetCurrentTick",HLE_unknown,4},
+{0x20f4,0xa4fc06a4,0x00000000,"sceGeSetCallback",HLE_sceGeSetCallback,1},
+{0x20f5,0x05db22ce,0x00000000,"sceGeUnsetCallback",HLE_sceGeUnsetCallback,1},
+{0x20f6,0xc41c2853,0x00000000,"sceRtcGetTickResolution",HLE_sceRtcGetTickResolution,0},
+{0x20f7,0x3f7ad767,0x00000000,"sceRtcGetCurrentTick",HLE_sceRtcGetCurrentTick,1},
 {0x20f8,0x029ca3b3,0x00000000,"sceRtc_029CA3B3",HLE_unknown,4},
-{0x20f9,0x4cfa57b0,0x00000000,"sceRtcGetCurrentClock",HLE_unknown,4},
-{0x20fa,0xe7c27d1b,0x00000000,"sceRtcGetCurrentClockLocalTime",HLE_unknown,4},
+{0x20f9,0x4cfa57b0,0x00000000,"sceRtcGetCurrentClock",HLE_sceRtcGetCurrentClock,2},
+{0x20fa,0xe7c27d1b,0x00000000,"sceRtcGetCurrentClockLocalTime",HLE_sceRtcGetCurrentClockLocalTime,1},
 {0x20fb,0x34885e0d,0x00000000,"sceRtcConvertUtcToLocalTime",HLE_unknown,4},
 {0x20fc,0x779242a2,0x00000000,"sceRtcConvertLocalTimeToUTC",HLE_unknown,4},
-{0x20fd,0x42307a17,0x00000000,"sceRtcIsLeapYear",HLE_unknown,4},
-{0x20fe,0x05ef322c,0x00000000,"sceRtcGetDaysInMonth",HLE_unknown,4},
-{0x20ff,0x57726bc1,0x00000000,"sceRtcGetDayOfWeek",HLE_unknown,4},
+{0x20fd,0x42307a17,0x00000000,"sceRtcIsLeapYear",HLE_sceRtcIsLeapYear,1},
+{0x20fe,0x05ef322c,0x00000000,"sceRtcGetDaysInMonth",HLE_sceRtcGetDaysInMonth,2},
+{0x20ff,0x57726bc1,0x00000000,"sceRtcGetDayOfWeek",HLE_sceRtcGetDayOfWeek,3},
 {0x2100,0x4b1b5e82,0x00000000,"sceRtcCheckValid",HLE_unknown,4},
 {0x2101,0x3a807cc8,0x00000000,"sceRtcSetTime_t",HLE_unknown,4},
 {0x2102,0x27c4594c,0x00000000,"sceRtcGetTime_t",HLE_unknown,4},
@@ -262,8 +262,8 @@ PSP_Syscall pspsyscalls[]={
 {0x2104,0x36075567,0x00000000,"sceRtcGetDosTime",HLE_unknown,4},
 {0x2105,0x7ace4c04,0x00000000,"sceRtcSetWin32FileTime",HLE_unknown,4},
 {0x2106,0xcf561893,0x00000000,"sceRtcGetWin32FileTime",HLE_unknown,4},
-{0x2107,0x7ed29e40,0x00000000,"sceRtcSetTick",HLE_unknown,4},
-{0x2108,0x6ff40acc,0x00000000,"sceRtcGetTick",HLE_unknown,4},
+{0x2107,0x7ed29e40,0x00000000,"sceRtcSetTick",HLE_sceRtcSetTick,2},
+{0x2108,0x6ff40acc,0x00000000,"sceRtcGetTick",HLE_sceRtcGetTick,2},
 {0x2109,0x9ed0ae87,0x00000000,"sceRtcCompareTick",HLE_unknown,4},
 {0x210a,0x44f45e05,0x00000000,"sceRtcTickAddTicks",HLE_unknown,4},
 {0x210b,0x26d25a5d,0x00000000,"sceRtcTickAddMicroseconds",HLE_unknown,4},
@@ -300,20 +300,20 @@ PSP_Syscall pspsyscalls[]={
 {0x212a,0x87b2e651,0x00000000,"sceAudioWaitInputEnd",HLE_unknown,4},
 {0x212b,0x7de61688,0x00000000,"sceAudioInputInit",HLE_unknown,4},
 {0x212c,0x0e20f177,0x00000000,"sceDisplaySetMode",HLE_sceDisplaySetMode,3},
-{0x212d,0xdea197d4,0x00000000,"sceDisplayGetMode",HLE_unknown,4},
+{0x212d,0xdea197d4,0x00000000,"sceDisplayGetMode",HLE_sceDisplayGetMode,3},
 {0x212e,0xdba6c4c4,0x00000000,"sceDisplayGetFramePerSec",HLE_unknown,4},
 {0x212f,0x7ed59bc4,0x00000000,"sceDisplaySetHoldMode",HLE_unknown,4},
 {0x2130,0xa544c486,0x00000000,"sceDisplaySetResumeMode",HLE_unknown,4},
 {0x2131,0x289d82fe,0x00000000,"sceDisplaySetFrameBuf",HLE_sceDisplaySetFrameBuf,4},
-{0x2132,0xeeda2e54,0x00000000,"sceDisplayGetFrameBuf",HLE_unknown,4},
+{0x2132,0xeeda2e54,0x00000000,"sceDisplayGetFrameBuf",HLE_sceDisplayGetFrameBuf,4},
 {0x2133,0xb4f378fa,0x00000000,"sceDisplayIsForeground",HLE_unknown,4},
 {0x2134,0x31c4baa8,0x00000000,"sceDisplayGetBrightness",HLE_unknown,4},
-{0x2135,0x9c6eaad7,0x00000000,"sceDisplayGetVcount",HLE_unknown,4},
-{0x2136,0x4d4e10ec,0x00000000,"sceDisplayIsVblank",HLE_unknown,4},
-{0x2137,0x36cdfade,0x00000000,"sceDisplayWaitVblank",HLE_unknown,4},
-{0x2138,0x8eb9ec49,0x00000000,"sceDisplayWaitVblankCB",HLE_unknown,4},
+{0x2135,0x9c6eaad7,0x00000000,"sceDisplayGetVcount",HLE_sceDisplayGetVcount,0},
+{0x2136,0x4d4e10ec,0x00000000,"sceDisplayIsVblank",HLE_sceDisplayIsVblank,0},
+{0x2137,0x36cdfade,0x00000000,"sceDisplayWaitVblank",HLE_sceDisplayWaitVblankStart,0},
+{0x2138,0x8eb9ec49,0x00000000,"sceDisplayWaitVblankCB",HLE_sceDisplayWaitVblankStart,0},
 {0x2139,0x984c27e7,0x00000000,"sceDisplayWaitVblankStart",HLE_sceDisplayWaitVblankStart,0},
-{0x213a,0x46f186c3,0x00000000,"sceDisplayWaitVblankStartCB",HLE_unknown,4},
+{0x213a,0x46f186c3,0x00000000,"sceDisplayWaitVblankStartCB",HLE_sceDisplayWaitVblankStart,0},
 {0x213b,0x773dd3a3,0x00000000,"sceDisplayGetCurrentHcount",HLE_unknown,4},
 {0x213c,0x210eab3a,0x00000000,"sceDisplayGetAccumulatedHcount",HLE_unknown,4},
 {0x213d,0x6a2774f3,0x00000000,"sceCtrlSetSamplingCycle",HLE_sceCtrlSetSamplingCycle,1},
@@ -321,11 +321,11 @@ PSP_Syscall pspsyscalls[]={
 {0x213f,0x1f4011e6,0x00000000,"sceCtrlSetSamplingMode",HLE_sceCtrlSetSamplingMode,1},
 {0x2140,0xda6b76a1,0x00000000,"sceCtrlGetSamplingMode",HLE_sceCtrlGetSamplingMode,1},
 {0x2141,0x3a622550,0x00000000,"sceCtrlPeekBufferPositive",HLE_sceCtrlPeekBufferPositive,2},
-{0x2142,0xc152080a,0x00000000,"sceCtrlPeekBufferNegative",HLE_unknown,4},
-{0x2143,0x1f803938,0x00000000,"sceCtrlReadBufferPositive",HLE_sceCtrlReadBufferPositive,2},
-{0x2144,0x60b81f86,0x00000000,"sceCtrlReadBufferNegative",HLE_unknown,4},
-{0x2145,0xb1d0e5cd,0x00000000,"sceCtrlPeekLatch",HLE_unknown,4},
-{0x2146,0x0b588501,0x00000000,"sceCtrlReadLatch",HLE_unknown,4},
+{0x2142,0xc152080a,0x00000000,"sceCtrlPeekBufferNegative",HLE_sceCtrlPeekBufferNegative,2},
+{0x2143,0x1f803938,0x00000000,"sceCtrlReadBufferPositive",HLE_sceCtrlPeekBufferPositive,2},
+{0x2144,0x60b81f86,0x00000000,"sceCtrlReadBufferNegative",HLE_sceCtrlPeekBufferNegative,2},
+{0x2145,0xb1d0e5cd,0x00000000,"sceCtrlPeekLatch",HLE_sceCtrlPeekLatch,1},
+{0x2146,0x0b588501,0x00000000,"sceCtrlReadLatch",HLE_sceCtrlPeekLatch,1},
 {0x2147,0x348d99d4,0x00000000,"sceCtrl_348D99D4",HLE_unknown,4},
 {0x2148,0xaf5960f3,0x00000000,"sceCtrl_AF5960F3",HLE_unknown,4},
 {0x2149,0xa68fd260,0x00000000,"sceCtrl_A68FD260",HLE_unknown,4},
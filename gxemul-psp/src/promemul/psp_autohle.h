@@ -47,7 +47,6 @@ void HLE_sceCtrlGetSamplingCycle(int32_t arg0);
 void HLE_sceCtrlSetSamplingMode(int32_t arg0);
 void HLE_sceCtrlGetSamplingMode(int32_t arg0);
 void HLE_sceCtrlPeekBufferPositive(int32_t arg0,int32_t arg1);
-void HLE_sceCtrlReadBufferPositive(int32_t arg0,int32_t arg1);
 void HLE_strlen(int32_t arg0);
 void HLE_strcpy(int32_t arg0,int32_t arg1);
 void HLE_strchr(int32_t arg0,int32_t arg1);
@@ -59,3 +58,67 @@ void HLE_vsprintf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t ar
 void HLE_vsnprintf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4,int32_t arg5);
 void HLE_sprintf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4,int32_t arg5);
 void HLE_sceKernelCheckExecFile(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceCtrlPeekBufferNegative(int32_t arg0,int32_t arg1);
+void HLE_sceCtrlPeekLatch(int32_t arg0);
+void HLE_sceDisplayGetFrameBuf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceDisplayGetMode(int32_t arg0,int32_t arg1,int32_t arg2);
+void HLE_sceDisplayGetVcount(void);
+void HLE_sceDisplayIsVblank(void);
+void HLE_sceIoLseek(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4);
+void HLE_sceIoLseek32(int32_t arg0,int32_t arg1,int32_t arg2);
+void HLE_sceIoMkdir(int32_t arg0,int32_t arg1);
+void HLE_sceIoRemove(int32_t arg0);
+void HLE_sceIoRename(int32_t arg0,int32_t arg1);
+void HLE_sceIoRmdir(int32_t arg0);
+void HLE_sceKernelCacheNop(void);
+void HLE_sceKernelCheckCallback(void);
+void HLE_sceKernelClearEventFlag(int32_t arg0,int32_t arg1);
+void HLE_sceKernelCreateCallback(int32_t arg0,int32_t arg1,int32_t arg2);
+void HLE_sceKernelCreateEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceKernelCreateSema(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4);
+void HLE_sceKernelDelayThread(int32_t arg0);
+void HLE_sceKernelDeleteCallback(int32_t arg0);
+void HLE_sceKernelDeleteEventFlag(int32_t arg0);
+void HLE_sceKernelDeleteSema(int32_t arg0);
+void HLE_sceKernelDeleteThread(int32_t arg0);
+void HLE_sceKernelExitGame(void);
+void HLE_sceKernelExitGameWithStatus(int32_t arg0);
+void HLE_sceKernelExitThread(int32_t arg0);
+void HLE_sceKernelGetSystemTime(int32_t arg0);
+void HLE_sceKernelGetSystemTimeLow(void);
+void HLE_sceKernelGetSystemTimeWide(void);
+void HLE_sceKernelGetThreadId(void);
+void HLE_sceKernelLibcClock(void);
+void HLE_sceKernelLibcGettimeofday(int32_t arg0,int32_t arg1);
+void HLE_sceKernelLibcTime(int32_t arg0);
+void HLE_sceKernelPollEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceKernelPollSema(int32_t arg0,int32_t arg1);
+void HLE_sceKernelReferSemaStatus(int32_t arg0,int32_t arg1);
+void HLE_sceKernelRegisterExitCallback(int32_t arg0);
+void HLE_sceKernelSetEventFlag(int32_t arg0,int32_t arg1);
+void HLE_sceKernelSignalSema(int32_t arg0,int32_t arg1);
+void HLE_sceKernelSleepThread(void);
+void HLE_sceKernelWaitEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4);
+void HLE_sceKernelWaitSema(int32_t arg0,int32_t arg1,int32_t arg2);
+void HLE_sceKernelWaitThreadEnd(int32_t arg0,int32_t arg1);
+void HLE_sceKernelWakeupThread(int32_t arg0);
+void HLE_sceRtcGetCurrentClock(int32_t arg0,int32_t arg1);
+void HLE_sceRtcGetCurrentClockLocalTime(int32_t arg0);
+void HLE_sceRtcGetCurrentTick(int32_t arg0);
+void HLE_sceRtcGetDayOfWeek(int32_t arg0,int32_t arg1,int32_t arg2);
+void HLE_sceRtcGetDaysInMonth(int32_t arg0,int32_t arg1);
+void HLE_sceRtcGetTick(int32_t arg0,int32_t arg1);
+void HLE_sceRtcGetTickResolution(void);
+void HLE_sceRtcIsLeapYear(int32_t arg0);
+void HLE_sceRtcSetTick(int32_t arg0,int32_t arg1);
+void HLE_sceGeEdramGetSize(void);
+void HLE_sceGeGetCmd(int32_t arg0);
+void HLE_sceGeGetMtx(int32_t arg0,int32_t arg1);
+void HLE_sceGeListEnQueue(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceGeListEnQueueHead(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
+void HLE_sceGeListDeQueue(int32_t arg0);
+void HLE_sceGeListUpdateStallAddr(int32_t arg0,int32_t arg1);
+void HLE_sceGeListSync(int32_t arg0,int32_t arg1);
+void HLE_sceGeDrawSync(int32_t arg0);
+void HLE_sceGeSetCallback(int32_t arg0);
+void HLE_sceGeUnsetCallback(int32_t arg0);
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "cpu.h"
 #include "cpu_mips.h"
@@ -8,6 +9,7 @@
 #include "machine.h"
 #include "memory.h"
 #include "misc.h"
+#include "snapshot.h"
 
 typedef struct
 {
@@ -56,6 +58,12 @@ extern PSP_Syscall pspsyscalls[];
 
 void HLE_unknown(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3);
 char *PSP_syscall_getname(int32_t idx);
+int32_t PSP_syscall_getargn(int32_t idx);
+int32_t PSP_findsyscall_bynid(int32_t nid);
+int32_t PSP_findsyscall_byname(char *s);
+void PSP_syscall_halt(int32_t status);
+
+extern int32_t hle_exit_status;
 
 // functions in psp_hooks.c
 typedef struct
@@ -79,6 +87,25 @@ int hookemul__psp(struct cpu *cpu,uint32_t idx);
 // functions from useremul.c
 extern unsigned char *get_userland_string(struct cpu *cpu, uint64_t baseaddr);
 extern unsigned char *get_userland_buf(struct cpu *cpu,	uint64_t baseaddr, uint64_t len);
+extern void put_userland_buf(struct cpu *cpu, uint64_t baseaddr, unsigned char *buf, uint64_t len);
+
+// functions in psp_hle_threadmanager.c
+void PSP_thread_setup(struct cpu *cpu);
+uint64_t PSP_systime_usec(void);
+uint64_t PSP_hosttime_usec(void);
+
+// snapshot handlers, registered by PSP_snapshot_setup() in psp_syscalls.c
+void PSP_snapshot_setup(struct machine *machine);
+void PSP_thread_snapshot(struct snapshot *s,void *extra);
+void PSP_mem_snapshot(struct snapshot *s,void *extra);
+void PSP_module_snapshot(struct snapshot *s,void *extra);
+void PSP_io_snapshot(struct snapshot *s,void *extra);
+void PSP_ctrl_snapshot(struct snapshot *s,void *extra);
+void PSP_display_snapshot(struct snapshot *s,void *extra);
+void PSP_ge_snapshot(struct snapshot *s,void *extra);
+
+// data in psp_hle_memorymanager.c
+extern uint32_t hle_partition_base;
 
 // data in psp_syscalls.c
 extern struct cpu *hle_cpu;
@@ -124,3 +151,21 @@ extern int32_t hle_arg10;
 	hle_cpu->pc=_a;                        \
         }
 //		hle_cpu->cd.mips.pc_last=_a;
+
+/*
+	kernel error codes (pspkerror.h)
+*/
+#define SCE_KERNEL_ERROR_UNKNOWN_UID			0x800200cb
+#define SCE_KERNEL_ERROR_ILLEGAL_PARTITION		0x800200d6
+#define SCE_KERNEL_ERROR_ILLEGAL_MEMBLOCK_ALLOC_TYPE	0x800200d8
+#define SCE_KERNEL_ERROR_FAILED_ALLOC_MEMBLOCK		0x800200d9
+#define SCE_KERNEL_ERROR_NO_MEMORY			0x80020190
+#define SCE_KERNEL_ERROR_UNKNOWN_THID			0x80020198
+#define SCE_KERNEL_ERROR_UNKNOWN_SEMID			0x80020199
+#define SCE_KERNEL_ERROR_UNKNOWN_EVFID			0x8002019a
+#define SCE_KERNEL_ERROR_NOT_DORMANT			0x800201a4
+#define SCE_KERNEL_ERROR_WAIT_TIMEOUT			0x800201a8
+#define SCE_KERNEL_ERROR_SEMA_ZERO			0x800201ad
+#define SCE_KERNEL_ERROR_SEMA_OVF			0x800201ae
+#define SCE_KERNEL_ERROR_EVF_COND			0x800201af
+#define SCE_KERNEL_ERROR_EVF_ILPAT			0x800201b1
@@ -5,11 +5,11 @@ SYSCALL(0x213e,0x02baad91,0x00000000,"sceCtrlGetSamplingCycle",HLE_sceCtrlGetSam
 SYSCALL(0x213f,0x1f4011e6,0x00000000,"sceCtrlSetSamplingMode",HLE_sceCtrlSetSamplingMode,1);
 SYSCALL(0x2140,0xda6b76a1,0x00000000,"sceCtrlGetSamplingMode",HLE_sceCtrlGetSamplingMode,1);
 SYSCALL(0x2141,0x3a622550,0x00000000,"sceCtrlPeekBufferPositive",HLE_sceCtrlPeekBufferPositive,2);
-SYSCALL(0x2142,0xc152080a,0x00000000,"sceCtrlPeekBufferNegative",HLE_unknown,4);
-SYSCALL(0x2143,0x1f803938,0x00000000,"sceCtrlReadBufferPositive",HLE_sceCtrlReadBufferPositive,2);
-SYSCALL(0x2144,0x60b81f86,0x00000000,"sceCtrlReadBufferNegative",HLE_unknown,4);
-SYSCALL(0x2145,0xb1d0e5cd,0x00000000,"sceCtrlPeekLatch",HLE_unknown,4);
-SYSCALL(0x2146,0x0b588501,0x00000000,"sceCtrlReadLatch",HLE_unknown,4);
+SYSCALL(0x2142,0xc152080a,0x00000000,"sceCtrlPeekBufferNegative",HLE_sceCtrlPeekBufferNegative,2);
+SYSCALL(0x2143,0x1f803938,0x00000000,"sceCtrlReadBufferPositive",HLE_sceCtrlPeekBufferPositive,2);
+SYSCALL(0x2144,0x60b81f86,0x00000000,"sceCtrlReadBufferNegative",HLE_sceCtrlPeekBufferNegative,2);
+SYSCALL(0x2145,0xb1d0e5cd,0x00000000,"sceCtrlPeekLatch",HLE_sceCtrlPeekLatch,1);
+SYSCALL(0x2146,0x0b588501,0x00000000,"sceCtrlReadLatch",HLE_sceCtrlPeekLatch,1);
 SYSCALL(0x2147,0x348d99d4,0x00000000,"sceCtrl_348D99D4",HLE_unknown,4);
 SYSCALL(0x2148,0xaf5960f3,0x00000000,"sceCtrl_AF5960F3",HLE_unknown,4);
 SYSCALL(0x2149,0xa68fd260,0x00000000,"sceCtrl_A68FD260",HLE_unknown,4);
@@ -96,11 +96,21 @@ typedef struct SceCtrlLatch {
  *
  * @returns The previous cycle setting.
  */
+static int32_t ctrl_cycle=0, ctrl_mode=PSP_CTRL_MODE_DIGITAL;
+
+void PSP_ctrl_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,ctrl_cycle);
+	SNAPSHOT_VAR(s,ctrl_mode);
+}
+
 //int sceCtrlSetSamplingCycle(int cycle);
 void HLE_sceCtrlSetSamplingCycle(int32_t arg0)
 {
+int32_t prev=ctrl_cycle;
 	debug("HLE_sceCtrlSetSamplingCycle(cycle:%08x) ",arg0);
-	HLE_RETURN_INT(0);
+	ctrl_cycle=arg0;
+	HLE_RETURN_INT(prev);
 }
 
 /**
@@ -114,6 +124,7 @@ void HLE_sceCtrlSetSamplingCycle(int32_t arg0)
 void HLE_sceCtrlGetSamplingCycle(int32_t arg0)
 {
 	debug("HLE_sceCtrlGetSamplingCycle(pcycle:%08x) ",arg0);
+	store_32bit_word(hle_cpu, arg0, ctrl_cycle);
 	HLE_RETURN_INT(0);
 }
 
@@ -127,8 +138,10 @@ void HLE_sceCtrlGetSamplingCycle(int32_t arg0)
 //int sceCtrlSetSamplingMode(int mode);
 void HLE_sceCtrlSetSamplingMode(int32_t arg0)
 {
+int32_t prev=ctrl_mode;
 	debug("HLE_sceCtrlSetSamplingMode(mode:%08x) ",arg0);
-	HLE_RETURN_INT(0);
+	ctrl_mode=arg0;
+	HLE_RETURN_INT(prev);
 }
 
 /**
@@ -142,35 +155,67 @@ void HLE_sceCtrlSetSamplingMode(int32_t arg0)
 void HLE_sceCtrlGetSamplingMode(int32_t arg0)
 {
 	debug("HLE_sceCtrlGetSamplingMode(pmode:%08x) ",arg0);
+	store_32bit_word(hle_cpu, arg0, ctrl_mode);
 	HLE_RETURN_INT(0);
 }
 
 
 
 
+/*
+	no pad is attached: every sample reports no buttons and a centred stick.
+	The buttons still go through the replay log, so that input can be
+	replayed once there is a host pad.
+*/
+static void PSP_ctrl_fill(int32_t pad_data,int32_t count,uint32_t buttons)
+{
+uint32_t timestamp=(uint32_t)PSP_systime_usec();
+int i;
+	buttons^=(uint32_t)replay_event(hle_cpu->machine,REPLAY_CTRL_BUTTONS,0);
+	for(i=0;i<count;i++)
+	{
+		store_32bit_word(hle_cpu, pad_data+i*16, timestamp);
+		store_32bit_word(hle_cpu, pad_data+i*16+4, buttons);
+		store_32bit_word(hle_cpu, pad_data+i*16+8, 0x00008080);
+		store_32bit_word(hle_cpu, pad_data+i*16+12, 0x00000000);
+	}
+}
+
 //int sceCtrlPeekBufferPositive(SceCtrlData *pad_data, int count);
+//int sceCtrlReadBufferPositive(SceCtrlData *pad_data, int count);
 void HLE_sceCtrlPeekBufferPositive(int32_t arg0,int32_t arg1)
 {
 	debug("HLE_sceCtrlPeekBufferPositive(pad_data:%08x count:%08x) ",arg0,arg1);
-	store_32bit_word(hle_cpu, arg0, 0x00000000);
-	store_32bit_word(hle_cpu, arg0+4, 0x00000000);
-	store_32bit_word(hle_cpu, arg0+8, 0x00000000);
-	store_32bit_word(hle_cpu, arg0+12, 0x00000000);
-	HLE_RETURN_INT(0);
+	if(arg1<1)
+	{
+		HLE_RETURN_INT(0);
+		return;
+	}
+	PSP_ctrl_fill(arg0,arg1,0x00000000);
+	HLE_RETURN_INT(arg1);
 }
 //int sceCtrlPeekBufferNegative(SceCtrlData *pad_data, int count);
+//int sceCtrlReadBufferNegative(SceCtrlData *pad_data, int count);
+void HLE_sceCtrlPeekBufferNegative(int32_t arg0,int32_t arg1)
+{
+	debug("HLE_sceCtrlPeekBufferNegative(pad_data:%08x count:%08x) ",arg0,arg1);
+	if(arg1<1)
+	{
+		HLE_RETURN_INT(0);
+		return;
+	}
+	PSP_ctrl_fill(arg0,arg1,0xffffffff);
+	HLE_RETURN_INT(arg1);
+}
 
-void HLE_sceCtrlReadBufferPositive(int32_t arg0,int32_t arg1)
+//int sceCtrlPeekLatch(SceCtrlLatch *latch_data);
+//int sceCtrlReadLatch(SceCtrlLatch *latch_data);
+void HLE_sceCtrlPeekLatch(int32_t arg0)
 {
-	debug("HLE_sceCtrlReadBufferPositive(pad_data:%08x count:%08x) ",arg0,arg1);
+	debug("HLE_sceCtrlPeekLatch(latch_data:%08x) ",arg0);
 	store_32bit_word(hle_cpu, arg0, 0x00000000);
 	store_32bit_word(hle_cpu, arg0+4, 0x00000000);
 	store_32bit_word(hle_cpu, arg0+8, 0x00000000);
 	store_32bit_word(hle_cpu, arg0+12, 0x00000000);
 	HLE_RETURN_INT(0);
 }
-
-//int sceCtrlReadBufferNegative(SceCtrlData *pad_data, int count);
-//int sceCtrlPeekLatch(SceCtrlLatch *latch_data);
-//int sceCtrlReadLatch(SceCtrlLatch *latch_data);
- 
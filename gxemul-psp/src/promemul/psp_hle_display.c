@@ -1,20 +1,20 @@
 #include "psp_hle.h"
 
 SYSCALL(0x212c,0x0e20f177,0x00000000,"sceDisplaySetMode",HLE_sceDisplaySetMode,3);
-SYSCALL(0x212d,0xdea197d4,0x00000000,"sceDisplayGetMode",HLE_unknown,4);
+SYSCALL(0x212d,0xdea197d4,0x00000000,"sceDisplayGetMode",HLE_sceDisplayGetMode,3);
 SYSCALL(0x212e,0xdba6c4c4,0x00000000,"sceDisplayGetFramePerSec",HLE_unknown,4);
 SYSCALL(0x212f,0x7ed59bc4,0x00000000,"sceDisplaySetHoldMode",HLE_unknown,4);
 SYSCALL(0x2130,0xa544c486,0x00000000,"sceDisplaySetResumeMode",HLE_unknown,4);
 SYSCALL(0x2131,0x289d82fe,0x00000000,"sceDisplaySetFrameBuf",HLE_sceDisplaySetFrameBuf,4);
-SYSCALL(0x2132,0xeeda2e54,0x00000000,"sceDisplayGetFrameBuf",HLE_unknown,4);
+SYSCALL(0x2132,0xeeda2e54,0x00000000,"sceDisplayGetFrameBuf",HLE_sceDisplayGetFrameBuf,4);
 SYSCALL(0x2133,0xb4f378fa,0x00000000,"sceDisplayIsForeground",HLE_unknown,4);
 SYSCALL(0x2134,0x31c4baa8,0x00000000,"sceDisplayGetBrightness",HLE_unknown,4);
-SYSCALL(0x2135,0x9c6eaad7,0x00000000,"sceDisplayGetVcount",HLE_unknown,4);
-SYSCALL(0x2136,0x4d4e10ec,0x00000000,"sceDisplayIsVblank",HLE_unknown,4);
-SYSCALL(0x2137,0x36cdfade,0x00000000,"sceDisplayWaitVblank",HLE_unknown,4);
-SYSCALL(0x2138,0x8eb9ec49,0x00000000,"sceDisplayWaitVblankCB",HLE_unknown,4);
+SYSCALL(0x2135,0x9c6eaad7,0x00000000,"sceDisplayGetVcount",HLE_sceDisplayGetVcount,0);
+SYSCALL(0x2136,0x4d4e10ec,0x00000000,"sceDisplayIsVblank",HLE_sceDisplayIsVblank,0);
+SYSCALL(0x2137,0x36cdfade,0x00000000,"sceDisplayWaitVblank",HLE_sceDisplayWaitVblankStart,0);
+SYSCALL(0x2138,0x8eb9ec49,0x00000000,"sceDisplayWaitVblankCB",HLE_sceDisplayWaitVblankStart,0);
 SYSCALL(0x2139,0x984c27e7,0x00000000,"sceDisplayWaitVblankStart",HLE_sceDisplayWaitVblankStart,0);
-SYSCALL(0x213a,0x46f186c3,0x00000000,"sceDisplayWaitVblankStartCB",HLE_unknown,4);
+SYSCALL(0x213a,0x46f186c3,0x00000000,"sceDisplayWaitVblankStartCB",HLE_sceDisplayWaitVblankStart,0);
 SYSCALL(0x213b,0x773dd3a3,0x00000000,"sceDisplayGetCurrentHcount",HLE_unknown,4);
 SYSCALL(0x213c,0x210eab3a,0x00000000,"sceDisplayGetAccumulatedHcount",HLE_unknown,4);
 
@@ -40,30 +40,83 @@ enum PspDisplaySetBufSync {
 #include <devices.h>
 extern struct vfb_data *HLE_dev_fb;
 
+/* display state as last set by the program, reported back by the getters */
+static int32_t display_mode=0, display_width=480, display_height=272;
+static int32_t display_topaddr=0, display_bufferwidth=512, display_pixelformat=PSP_DISPLAY_PIXEL_FORMAT_8888;
+static uint32_t display_vcount=0;
+
+void PSP_display_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,display_mode);
+	SNAPSHOT_VAR(s,display_width);
+	SNAPSHOT_VAR(s,display_height);
+	SNAPSHOT_VAR(s,display_topaddr);
+	SNAPSHOT_VAR(s,display_bufferwidth);
+	SNAPSHOT_VAR(s,display_pixelformat);
+	SNAPSHOT_VAR(s,display_vcount);
+}
+
 void HLE_sceDisplaySetMode(int mode, int width, int height)
 {
 	debug("HLE_sceDisplaySetMode(mode:%08x width:%d height:%d) ",mode,width,height);
+	display_mode=mode;
+	display_width=width;
+	display_height=height;
+	HLE_RETURN_INT(0);
+}
+//int sceDisplayGetMode(int *pmode, int *pwidth, int *pheight);
+void HLE_sceDisplayGetMode(int32_t arg0,int32_t arg1,int32_t arg2)
+{
+	debug("HLE_sceDisplayGetMode(pmode:%08x pwidth:%08x pheight:%08x) ",arg0,arg1,arg2);
+	if(arg0) store_32bit_word(hle_cpu, arg0, display_mode);
+	if(arg1) store_32bit_word(hle_cpu, arg1, display_width);
+	if(arg2) store_32bit_word(hle_cpu, arg2, display_height);
 	HLE_RETURN_INT(0);
 }
 //void sceDisplaySetFrameBuf(void *topaddr, int bufferwidth, int pixelformat, int sync);
 void HLE_sceDisplaySetFrameBuf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
 {
 	debug("HLE_sceDisplaySetFrameBuf(topaddr:%08x bufferwidth:%08x pixelformat:%08x sync:%08x) ",arg0,arg1,arg2,arg3);
-	if(arg2==PSP_DISPLAY_PIXEL_FORMAT_8888)
-	{
-		HLE_dev_fb->bit_depth = 32;
-		HLE_dev_fb->bytes_per_line = HLE_dev_fb->xsize * HLE_dev_fb->bit_depth / 8;
-	}
-	else
+	display_topaddr=arg0;
+	display_bufferwidth=arg1;
+	display_pixelformat=arg2;
+	/* no framebuffer device when running headless */
+	if(HLE_dev_fb!=NULL)
 	{
-		HLE_dev_fb->bit_depth = 16;
+		if(arg2==PSP_DISPLAY_PIXEL_FORMAT_8888)
+			HLE_dev_fb->bit_depth = 32;
+		else
+			HLE_dev_fb->bit_depth = 16;
 		HLE_dev_fb->bytes_per_line = HLE_dev_fb->xsize * HLE_dev_fb->bit_depth / 8;
 	}
 	HLE_RETURN_INT(0);
 }
- 
+//int sceDisplayGetFrameBuf(void **topaddr, int *bufferwidth, int *pixelformat, int sync);
+void HLE_sceDisplayGetFrameBuf(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
+{
+	debug("HLE_sceDisplayGetFrameBuf(topaddr:%08x bufferwidth:%08x pixelformat:%08x sync:%08x) ",arg0,arg1,arg2,arg3);
+	if(arg0) store_32bit_word(hle_cpu, arg0, display_topaddr);
+	if(arg1) store_32bit_word(hle_cpu, arg1, display_bufferwidth);
+	if(arg2) store_32bit_word(hle_cpu, arg2, display_pixelformat);
+	HLE_RETURN_INT(0);
+}
+//unsigned int sceDisplayGetVcount(void);
+void HLE_sceDisplayGetVcount(void)
+{
+	debug("HLE_sceDisplayGetVcount() ");
+	HLE_RETURN_INT(display_vcount);
+}
+//int sceDisplayIsVblank(void);
+void HLE_sceDisplayIsVblank(void)
+{
+	debug("HLE_sceDisplayIsVblank() ");
+	HLE_RETURN_INT(0);
+}
+
+/* there is no real vblank to wait for, every wait just starts the next frame */
 void HLE_sceDisplayWaitVblankStart(void)
 {
 	debug("HLE_sceDisplayWaitVblankStart() ");
+	display_vcount++;
 	HLE_RETURN_INT(0);
 }
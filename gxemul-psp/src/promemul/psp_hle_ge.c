@@ -1,22 +1,33 @@
 #include "psp_hle.h"
 
-SYSCALL(0x20e5,0x1f6752ad,0x00000000,"sceGeEdramGetSize",HLE_unknown,4);
+SYSCALL(0x20e5,0x1f6752ad,0x00000000,"sceGeEdramGetSize",HLE_sceGeEdramGetSize,0);
 SYSCALL(0x20e6,0xe47e40e4,0x00000000,"sceGeEdramGetAddr",HLE_sceGeEdramGetAddr,0);
 SYSCALL(0x20e7,0xb77905ea,0x00000000,"sceGeEdramSetAddrTranslation",HLE_unknown,4);
-SYSCALL(0x20e8,0xdc93cfef,0x00000000,"sceGeGetCmd",HLE_unknown,4);
-SYSCALL(0x20e9,0x57c8945b,0x00000000,"sceGeGetMtx",HLE_unknown,4);
+SYSCALL(0x20e8,0xdc93cfef,0x00000000,"sceGeGetCmd",HLE_sceGeGetCmd,1);
+SYSCALL(0x20e9,0x57c8945b,0x00000000,"sceGeGetMtx",HLE_sceGeGetMtx,2);
 SYSCALL(0x20ea,0x438a385a,0x00000000,"sceGeSaveContext",HLE_unknown,4);
 SYSCALL(0x20eb,0x0bf608fb,0x00000000,"sceGeRestoreContext",HLE_unknown,4);
-SYSCALL(0x20ec,0xab49e76a,0x00000000,"sceGeListEnQueue",HLE_unknown,4);
-SYSCALL(0x20ed,0x1c0d95a6,0x00000000,"sceGeListEnQueueHead",HLE_unknown,4);
-SYSCALL(0x20ee,0x5fb86ab0,0x00000000,"sceGeListDeQueue",HLE_unknown,4);
-SYSCALL(0x20ef,0xe0d68148,0x00000000,"sceGeListUpdateStallAddr",HLE_unknown,4);
-SYSCALL(0x20f0,0x03444eb4,0x00000000,"sceGeListSync",HLE_unknown,4);
-SYSCALL(0x20f1,0xb287bd61,0x00000000,"sceGeDrawSync",HLE_unknown,4);
+SYSCALL(0x20ec,0xab49e76a,0x00000000,"sceGeListEnQueue",HLE_sceGeListEnQueue,4);
+SYSCALL(0x20ed,0x1c0d95a6,0x00000000,"sceGeListEnQueueHead",HLE_sceGeListEnQueueHead,4);
+SYSCALL(0x20ee,0x5fb86ab0,0x00000000,"sceGeListDeQueue",HLE_sceGeListDeQueue,1);
+SYSCALL(0x20ef,0xe0d68148,0x00000000,"sceGeListUpdateStallAddr",HLE_sceGeListUpdateStallAddr,2);
+SYSCALL(0x20f0,0x03444eb4,0x00000000,"sceGeListSync",HLE_sceGeListSync,2);
+SYSCALL(0x20f1,0xb287bd61,0x00000000,"sceGeDrawSync",HLE_sceGeDrawSync,1);
 SYSCALL(0x20f2,0xb448ec0d,0x00000000,"sceGeBreak",HLE_unknown,4);
 SYSCALL(0x20f3,0x4c06e472,0x00000000,"sceGeContinue",HLE_unknown,4);
-SYSCALL(0x20f4,0xa4fc06a4,0x00000000,"sceGeSetCallback",HLE_unknown,4);
-SYSCALL(0x20f5,0x05db22ce,0x00000000,"sceGeUnsetCallback",HLE_unknown,4);
+SYSCALL(0x20f4,0xa4fc06a4,0x00000000,"sceGeSetCallback",HLE_sceGeSetCallback,1);
+SYSCALL(0x20f5,0x05db22ce,0x00000000,"sceGeUnsetCallback",HLE_sceGeUnsetCallback,1);
+
+#include "devices.h"
+
+/* ge callbacks are recorded but, like other callbacks, never called */
+#define	GE_MAX_CALLBACKS	16
+static int32_t ge_callbacks[GE_MAX_CALLBACKS];
+
+void PSP_ge_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,ge_callbacks);
+}
 
 void HLE_sceGeEdramGetAddr(void)
 {
@@ -24,4 +35,93 @@ void HLE_sceGeEdramGetAddr(void)
 
 	HLE_RETURN_INT(0x04000000);
 }
+
+void HLE_sceGeEdramGetSize(void)
+{
+	debug("HLE_sceGeEdramGetSize() ");
+
+	HLE_RETURN_INT(0x00200000);
+}
+//unsigned int sceGeGetCmd(int cmd);
+void HLE_sceGeGetCmd(int32_t arg0)
+{
+	debug("HLE_sceGeGetCmd(cmd:%08x) ",arg0);
+	HLE_RETURN_INT(dev_psp_ge_get_cmd(arg0));
+}
+//int sceGeGetMtx(int type, void *matrix);
+void HLE_sceGeGetMtx(int32_t arg0,int32_t arg1)
+{
+	union { float f; uint32_t i; } u;
+	float m[16];
+	int i,n;
+
+	debug("HLE_sceGeGetMtx(type:%08x matrix:%08x) ",arg0,arg1);
+	n=dev_psp_ge_get_matrix(arg0,m);
+	if(n==0) { HLE_RETURN_INT(-1); return; }
+	for(i=0;i<n;i++)
+	{
+		u.f=m[i];
+		store_32bit_word(hle_cpu, arg1+i*4, u.i);
+	}
+	HLE_RETURN_INT(0);
+}
+//int sceGeListEnQueue(const void *list, void *stall, int cbid, PspGeListArgs *arg);
+void HLE_sceGeListEnQueue(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
+{
+	debug("HLE_sceGeListEnQueue(list:%08x stall:%08x cbid:%08x arg:%08x) ",arg0,arg1,arg2,arg3);
+	HLE_RETURN_INT(dev_psp_ge_enqueue(arg0,arg1,0));
+}
+//int sceGeListEnQueueHead(const void *list, void *stall, int cbid, PspGeListArgs *arg);
+void HLE_sceGeListEnQueueHead(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
+{
+	debug("HLE_sceGeListEnQueueHead(list:%08x stall:%08x cbid:%08x arg:%08x) ",arg0,arg1,arg2,arg3);
+	HLE_RETURN_INT(dev_psp_ge_enqueue(arg0,arg1,1));
+}
+//int sceGeListDeQueue(int qid);
+void HLE_sceGeListDeQueue(int32_t arg0)
+{
+	debug("HLE_sceGeListDeQueue(qid:%08x) ",arg0);
+	HLE_RETURN_INT(dev_psp_ge_dequeue(arg0));
+}
+//int sceGeListUpdateStallAddr(int qid, void *stall);
+void HLE_sceGeListUpdateStallAddr(int32_t arg0,int32_t arg1)
+{
+	debug("HLE_sceGeListUpdateStallAddr(qid:%08x stall:%08x) ",arg0,arg1);
+	HLE_RETURN_INT(dev_psp_ge_update_stall(arg0,arg1));
+}
+//int sceGeListSync(int qid, int syncType);
+void HLE_sceGeListSync(int32_t arg0,int32_t arg1)
+{
+	debug("HLE_sceGeListSync(qid:%08x syncType:%08x) ",arg0,arg1);
+	HLE_RETURN_INT(dev_psp_ge_list_sync(arg0));
+}
+//int sceGeDrawSync(int syncType);
+void HLE_sceGeDrawSync(int32_t arg0)
+{
+	debug("HLE_sceGeDrawSync(syncType:%08x) ",arg0);
+	HLE_RETURN_INT(dev_psp_ge_draw_sync());
+}
+//int sceGeSetCallback(PspGeCallbackData *cb);
+void HLE_sceGeSetCallback(int32_t arg0)
+{
+	int i;
+
+	debug("HLE_sceGeSetCallback(cb:%08x) ",arg0);
+	for(i=0;i<GE_MAX_CALLBACKS;i++)
+		if(ge_callbacks[i]==0)
+		{
+			ge_callbacks[i]=arg0;
+			HLE_RETURN_INT(i);
+			return;
+		}
+	HLE_RETURN_INT(-1);
+}
+//int sceGeUnsetCallback(int cbid);
+void HLE_sceGeUnsetCallback(int32_t arg0)
+{
+	debug("HLE_sceGeUnsetCallback(cbid:%08x) ",arg0);
+	if(arg0>=0 && arg0<GE_MAX_CALLBACKS)
+		ge_callbacks[arg0]=0;
+	HLE_RETURN_INT(0);
+}
  
@@ -15,23 +15,23 @@ SYSCALL(0x2091,0x6a638d83,0x00000000,"sceIoRead",HLE_sceIoRead,3);
 SYSCALL(0x2092,0xa0b5a7c2,0x00000000,"sceIoReadAsync",HLE_unknown,4);
 SYSCALL(0x2093,0x42ec03ac,0x00000000,"sceIoWrite",HLE_sceIoWrite,3);
 SYSCALL(0x2094,0x0facab19,0x00000000,"sceIoWriteAsync",HLE_unknown,4);
-SYSCALL(0x2095,0x27eb27b8,0x00000000,"sceIoLseek",HLE_unknown,4);
+SYSCALL(0x2095,0x27eb27b8,0x00000000,"sceIoLseek",HLE_sceIoLseek,5);
 SYSCALL(0x2096,0x71b19e77,0x00000000,"sceIoLseekAsync",HLE_unknown,4);
-SYSCALL(0x2097,0x68963324,0x00000000,"sceIoLseek32",HLE_unknown,4);
+SYSCALL(0x2097,0x68963324,0x00000000,"sceIoLseek32",HLE_sceIoLseek32,3);
 SYSCALL(0x2098,0x1b385d8f,0x00000000,"sceIoLseek32Async",HLE_unknown,4);
 SYSCALL(0x2099,0x63632449,0x00000000,"sceIoIoctl",HLE_unknown,4);
 SYSCALL(0x209a,0xe95a012b,0x00000000,"sceIoIoctlAsync",HLE_unknown,4);
 SYSCALL(0x209b,0xb29ddf9c,0x00000000,"sceIoDopen",HLE_sceIoDopen,1);
 SYSCALL(0x209c,0xe3eb004c,0x00000000,"sceIoDread",HLE_sceIoDread,2);
 SYSCALL(0x209d,0xeb092469,0x00000000,"sceIoDclose",HLE_sceIoDclose,1);
-SYSCALL(0x209e,0xf27a9c51,0x00000000,"sceIoRemove",HLE_unknown,4);
-SYSCALL(0x209f,0x06a70004,0x00000000,"sceIoMkdir",HLE_unknown,4);
-SYSCALL(0x20a0,0x1117c65f,0x00000000,"sceIoRmdir",HLE_unknown,4);
+SYSCALL(0x209e,0xf27a9c51,0x00000000,"sceIoRemove",HLE_sceIoRemove,1);
+SYSCALL(0x209f,0x06a70004,0x00000000,"sceIoMkdir",HLE_sceIoMkdir,2);
+SYSCALL(0x20a0,0x1117c65f,0x00000000,"sceIoRmdir",HLE_sceIoRmdir,1);
 SYSCALL(0x20a1,0x55f4717d,0x00000000,"sceIoChdir",HLE_sceIoChdir,1);
 SYSCALL(0x20a2,0xab96437f,0x00000000,"sceIoSync",HLE_unknown,4);
 SYSCALL(0x20a3,0xace946e8,0x00000000,"sceIoGetstat",HLE_sceIoGetstat,2);
 SYSCALL(0x20a4,0xb8a740f4,0x00000000,"sceIoChstat",HLE_unknown,4);
-SYSCALL(0x20a5,0x779103a0,0x00000000,"sceIoRename",HLE_unknown,4);
+SYSCALL(0x20a5,0x779103a0,0x00000000,"sceIoRename",HLE_sceIoRename,2);
 SYSCALL(0x20a6,0x54f5fb11,0x00000000,"sceIoDevctl",HLE_unknown,4);
 SYSCALL(0x20a7,0x08bd7374,0x00000000,"sceIoGetDevType",HLE_unknown,4);
 SYSCALL(0x20a8,0xb2a628c1,0x00000000,"sceIoAssign",HLE_unknown,4);
@@ -63,81 +63,428 @@ SYSCALL(0x21f9,0x84f370bc, 0x00000000,"Kprintf",HLE_Kprintf,9);
 SYSCALL(0x21fa,0xd636b827, 0x00000000,"sceKernelRemoveByDebugSection",HLE_unknown,4);
 SYSCALL(0x2215,0x7CEB2C09, 0x00000000,"sceKernelRegisterKprintfHandler",HLE_sceKernelRegisterKprintfHandler,2);
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+	Files are opened on the host. A path with a device prefix
+	("ms0:/PSP/GAME/x", "host0:x", "umd0:/...") is looked up below
+	PSP_HOSTROOT, a path without one (for example argv[0], which is the
+	host path of the ELF) is used as it is.
+*/
+#define PSP_HOSTROOT	"."
+#define PSP_MAXFILES	64
+
 typedef struct
 {
 	char *name;
-	FILE *local_fd;
+	int local_fd;		// -1: unused
+	DIR *local_dir;
+	int flags;		// host open() flags, for reopening
+	int dir_pos;		// entries read from local_dir
 } PSP_File;
-PSP_File pspfiles[10];
-int        numfiles=3;	// 0,1,2 are stdin,out,err
+PSP_File pspfiles[PSP_MAXFILES];	// 0,1,2 are stdin,out,err
+
+char _cwd[0x400];
+
+/* PSP errno errors are 0x80010000|errno */
+#define SCE_ERROR_ERRNO(_e)	(0x80010000|(_e))
+
+static char *PSP_io_hostpath(char *name)
+{
+char *full,*dev,*host;
+	full=malloc(strlen(_cwd)+strlen(name)+2);
+	if((strchr(name,':')!=NULL)|(name[0]=='/')|(_cwd[0]==0))
+		strcpy(full,name);
+	else
+		sprintf(full,"%s/%s",_cwd,name);
+
+	dev=strchr(full,':');
+	if(dev==NULL)
+		return full;
+
+	host=malloc(strlen(PSP_HOSTROOT)+strlen(dev)+2);
+	sprintf(host,"%s%s%s",PSP_HOSTROOT,(dev[1]=='/')?"":"/",dev+1);
+	free(full);
+	return host;
+}
+
+static void PSP_io_init(void)
+{
+static int done=0;
+int fd;
+	if(done) return;
+	for(fd=0;fd<PSP_MAXFILES;fd++)
+	{
+		pspfiles[fd].local_fd=(fd<3)?fd:-1;
+	}
+	done=1;
+}
+
+static int PSP_io_getfd(void)
+{
+int fd;
+	PSP_io_init();
+	for(fd=3;fd<PSP_MAXFILES;fd++)
+	{
+		if((pspfiles[fd].local_fd==-1)&(pspfiles[fd].local_dir==NULL))
+		{
+			return fd;
+		}
+	}
+	return -1;
+}
+
+static int PSP_io_valid(int32_t fd)
+{
+	PSP_io_init();
+	return (fd>=0)&(fd<PSP_MAXFILES)&&(pspfiles[fd].local_fd!=-1);
+}
+
+/* SceIoStat: mode, attr, size, ctime, atime, mtime, private[6] */
+static void PSP_io_storestat(uint32_t addr,struct stat *st)
+{
+uint32_t mode,attr;
+time_t t[3];
+int i;
+	mode=st->st_mode&0777;
+	attr=(st->st_mode>>6)&7;
+	if(S_ISDIR(st->st_mode))
+	{
+		mode|=0x1000; attr|=0x10;
+	}
+	else
+	{
+		mode|=0x2000; attr|=0x20;
+	}
+	store_32bit_word(hle_cpu, addr+0x00, mode);
+	store_32bit_word(hle_cpu, addr+0x04, attr);
+	store_32bit_word(hle_cpu, addr+0x08, (uint32_t)st->st_size);
+	store_32bit_word(hle_cpu, addr+0x0c, (uint32_t)((uint64_t)st->st_size>>32));
+	t[0]=st->st_ctime; t[1]=st->st_atime; t[2]=st->st_mtime;
+	for(i=0;i<3;i++)
+	{
+		struct tm *tm=localtime(&t[i]);
+		uint32_t a=addr+0x10+(i*0x10);
+		store_32bit_word(hle_cpu, a+0, (tm->tm_year+1900)|((tm->tm_mon+1)<<16));
+		store_32bit_word(hle_cpu, a+4, tm->tm_mday|(tm->tm_hour<<16));
+		store_32bit_word(hle_cpu, a+8, tm->tm_min|(tm->tm_sec<<16));
+		store_32bit_word(hle_cpu, a+12, 0);
+	}
+	for(i=0;i<6;i++)
+	{
+		store_32bit_word(hle_cpu, addr+0x40+(i*4), 0);
+	}
+}
 
 /**
 	IoFileMgrForKernel
 */
+//SceUID sceIoOpen(const char *file, int flags, SceMode mode);
 void HLE_sceIoOpen(int32_t arg0,int32_t arg1,int32_t arg2)
 {
-char *name;
+char *name,*host;
+int fd,flags;
 	name=get_userland_string(hle_cpu, arg0);
 	debug("HLE_sceIoOpen(Name:%s Mode:%08x Perm:%08x) ",name,arg1,arg2);
-	pspfiles[numfiles].name=name;
-	numfiles++;
-	HLE_RETURN_INT(numfiles-1);
+
+	fd=PSP_io_getfd();
+	if(fd<0)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EMFILE));
+		return;
+	}
+
+	switch(arg1&3)
+	{
+		case 2:	 flags=O_WRONLY; break;
+		case 3:	 flags=O_RDWR; break;
+		default: flags=O_RDONLY; break;
+	}
+	if(arg1&0x0100) flags|=O_APPEND;
+	if(arg1&0x0200) flags|=O_CREAT;
+	if(arg1&0x0400) flags|=O_TRUNC;
+	if(arg1&0x0800) flags|=O_EXCL;
+
+	host=PSP_io_hostpath(name);
+	pspfiles[fd].local_fd=open(host,flags,arg2?(arg2&0777):0666);
+	free(host);
+	if(pspfiles[fd].local_fd==-1)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(errno));
+		return;
+	}
+	pspfiles[fd].name=name;
+	pspfiles[fd].flags=flags;
+	HLE_RETURN_INT(fd);
 }
 void HLE_sceIoClose(int32_t arg0)
 {
-	debug("HLE_sceIoClose(fd: %08x - Name:%s) ",arg0,pspfiles[arg0].name);
+	debug("HLE_sceIoClose(fd: %08x) ",arg0);
+	if((arg0<3)|!PSP_io_valid(arg0))
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	close(pspfiles[arg0].local_fd);
+	pspfiles[arg0].local_fd=-1;
 	free(pspfiles[arg0].name);
+	pspfiles[arg0].name=NULL;
 	HLE_RETURN_INT(0);
 }
+//int sceIoRead(SceUID fd, void *data, SceSize size);
 void HLE_sceIoRead(int32_t arg0,int32_t arg1,int32_t arg2)
 {
+unsigned char *b;
+ssize_t len;
 	debug("HLE_sceIoRead(fd:%08x buf:%08x len:%08x) ",arg0,arg1,arg2);
-	HLE_RETURN_INT(0);
+	if(!PSP_io_valid(arg0)|(arg2<0))
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	b=malloc(arg2?arg2:1);
+	len=read(pspfiles[arg0].local_fd,b,arg2);
+	if(len>0)
+	{
+		put_userland_buf(hle_cpu,arg1,b,len);
+	}
+	free(b);
+	HLE_RETURN_INT((len<0)?SCE_ERROR_ERRNO(errno):len);
 }
+/*
+	where stdout/stderr go: the host's, or with -f prefix the files
+	prefix.stdout and prefix.stderr, opened on the first write
+*/
+static FILE *PSP_io_console(int fd)
+{
+static FILE *capture[3];
+static int opened[3];
+	if(!opened[fd])
+	{
+		capture[fd]=machine_output_file(hle_cpu->machine,(fd==1)?"stdout":"stderr");
+		opened[fd]=1;
+	}
+	if(capture[fd]!=NULL)
+		return capture[fd];
+	return (fd==1)?stdout:stderr;
+}
+
+//int sceIoWrite(SceUID fd, const void *data, SceSize size);
 void HLE_sceIoWrite(int32_t arg0,int32_t arg1,int32_t arg2)
 {
+unsigned char *b;
+ssize_t len;
 	debug("HLE_sceIoWrite(fd:%08x buf:%08x len:%08x) ",arg0,arg1,arg2);
+	if(!PSP_io_valid(arg0)|(arg2<0))
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	b=get_userland_buf(hle_cpu,arg1,arg2);
 	if((arg0==1)|(arg0==2)) // stdout/stderr
 	{
-		char *b;
-		int i;
-		b=get_userland_buf(hle_cpu,arg1,arg2);
-		for(i=0;i<arg2;i++)
-		{
-			debug("'%c' ",b[i]);
-		}
-		free(b);
+		FILE *out=PSP_io_console(arg0);
+		len=fwrite(b,1,arg2,out);
+		fflush(out);
+	}
+	else
+	{
+		len=write(pspfiles[arg0].local_fd,b,arg2);
+	}
+	free(b);
+	HLE_RETURN_INT((len<0)?SCE_ERROR_ERRNO(errno):len);
+}
+
+//SceOff sceIoLseek(SceUID fd, SceOff offset, int whence);
+// the 64 bit offset is passed in the aligned pair a2/a3, whence in t0
+void HLE_sceIoLseek(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4)
+{
+int64_t offs=((int64_t)arg3<<32)|(uint32_t)arg2;
+off_t pos;
+	debug("HLE_sceIoLseek(fd:%08x offset:%016llx whence:%d) ",arg0,(long long)offs,arg4);
+	if(!PSP_io_valid(arg0))
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		hle_cpu->cd.mips.gpr[MIPS_GPR_V1]=-1;
+		return;
+	}
+	pos=lseek(pspfiles[arg0].local_fd,offs,arg4);
+	if(pos==(off_t)-1)
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(errno));
+		hle_cpu->cd.mips.gpr[MIPS_GPR_V1]=-1;
+		return;
 	}
-	HLE_RETURN_INT(arg2);
+	hle_cpu->cd.mips.gpr[MIPS_GPR_V0]=(int32_t)pos;
+	hle_cpu->cd.mips.gpr[MIPS_GPR_V1]=(int32_t)((int64_t)pos>>32);
+}
+//int sceIoLseek32(SceUID fd, int offset, int whence);
+void HLE_sceIoLseek32(int32_t arg0,int32_t arg1,int32_t arg2)
+{
+off_t pos;
+	debug("HLE_sceIoLseek32(fd:%08x offset:%08x whence:%d) ",arg0,arg1,arg2);
+	if(!PSP_io_valid(arg0))
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	pos=lseek(pspfiles[arg0].local_fd,arg1,arg2);
+	HLE_RETURN_INT((pos==(off_t)-1)?SCE_ERROR_ERRNO(errno):(int32_t)pos);
+}
+
+//int sceIoRemove(const char *file);
+void HLE_sceIoRemove(int32_t arg0)
+{
+char *name,*host;
+int res;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceIoRemove(Name:%s) ",name);
+	host=PSP_io_hostpath(name);
+	res=unlink(host);
+	free(host); free(name);
+	HLE_RETURN_INT(res?SCE_ERROR_ERRNO(errno):0);
+}
+//int sceIoMkdir(const char *dir, SceMode mode);
+void HLE_sceIoMkdir(int32_t arg0,int32_t arg1)
+{
+char *name,*host;
+int res;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceIoMkdir(Name:%s Mode:%08x) ",name,arg1);
+	host=PSP_io_hostpath(name);
+	res=mkdir(host,0777);
+	free(host); free(name);
+	HLE_RETURN_INT(res?SCE_ERROR_ERRNO(errno):0);
+}
+//int sceIoRmdir(const char *path);
+void HLE_sceIoRmdir(int32_t arg0)
+{
+char *name,*host;
+int res;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceIoRmdir(Name:%s) ",name);
+	host=PSP_io_hostpath(name);
+	res=rmdir(host);
+	free(host); free(name);
+	HLE_RETURN_INT(res?SCE_ERROR_ERRNO(errno):0);
+}
+//int sceIoRename(const char *oldname, const char *newname);
+void HLE_sceIoRename(int32_t arg0,int32_t arg1)
+{
+char *from,*to,*hostfrom,*hostto;
+int res;
+	from=get_userland_string(hle_cpu, arg0);
+	to=get_userland_string(hle_cpu, arg1);
+	debug("HLE_sceIoRename(Old:%s New:%s) ",from,to);
+	hostfrom=PSP_io_hostpath(from);
+	hostto=PSP_io_hostpath(to);
+	res=rename(hostfrom,hostto);
+	free(hostfrom); free(hostto); free(from); free(to);
+	HLE_RETURN_INT(res?SCE_ERROR_ERRNO(errno):0);
 }
 
 //int sceIoGetstat(const char *file, SceIoStat *stat);
 void HLE_sceIoGetstat(int32_t arg0,int32_t arg1)
 {
-char *name;
+char *name,*host;
+struct stat st;
+int res;
 	name=get_userland_string(hle_cpu, arg0);
 	debug("HLE_sceIoGetstat(Name:%s stat:%08x) ",name,arg1);
+	host=PSP_io_hostpath(name);
+	res=stat(host,&st);
+	free(host); free(name);
+	if(res)
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(errno));
+		return;
+	}
+	PSP_io_storestat(arg1,&st);
 	HLE_RETURN_INT(0);
 }
 
 // SceUID sceIoDopen(const char *dirname);
 void HLE_sceIoDopen(int32_t arg0)
 {
-char *name;
+char *name,*host;
+int fd;
 	name=get_userland_string(hle_cpu, arg0);
 	debug("HLE_sceIoDopen(Name:%s) ",name);
-	HLE_RETURN_INT(1);
+	fd=PSP_io_getfd();
+	if(fd<0)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EMFILE));
+		return;
+	}
+	host=PSP_io_hostpath(name);
+	pspfiles[fd].local_dir=opendir(host);
+	free(host);
+	if(pspfiles[fd].local_dir==NULL)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(errno));
+		return;
+	}
+	pspfiles[fd].name=name;
+	pspfiles[fd].dir_pos=0;
+	HLE_RETURN_INT(fd);
 }
 void HLE_sceIoDclose(int32_t arg0)
 {
 	debug("HLE_sceIoDclose(fd:%08x) ",arg0);
+	if((arg0<3)|(arg0>=PSP_MAXFILES)||pspfiles[arg0].local_dir==NULL)
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	closedir(pspfiles[arg0].local_dir);
+	pspfiles[arg0].local_dir=NULL;
+	free(pspfiles[arg0].name);
+	pspfiles[arg0].name=NULL;
 	HLE_RETURN_INT(0);
 }
 //int sceIoDread(SceUID fd, SceIoDirent *dir);
+// returns 1 while there are entries left, 0 at the end
 void HLE_sceIoDread(int32_t arg0,int32_t arg1)
 {
+struct dirent *de;
+struct stat st;
+char *path;
 	debug("HLE_sceIoDread(fd:%08x dirent:%08x) ",arg0,arg1);
-	HLE_RETURN_INT(0);
+	if((arg0<3)|(arg0>=PSP_MAXFILES)||pspfiles[arg0].local_dir==NULL)
+	{
+		HLE_RETURN_INT(SCE_ERROR_ERRNO(EBADF));
+		return;
+	}
+	de=readdir(pspfiles[arg0].local_dir);
+	if(de==NULL)
+	{
+		HLE_RETURN_INT(0);
+		return;
+	}
+	pspfiles[arg0].dir_pos++;
+	path=malloc(strlen(pspfiles[arg0].name)+strlen(de->d_name)+2);
+	sprintf(path,"%s/%s",pspfiles[arg0].name,de->d_name);
+	{
+		char *host=PSP_io_hostpath(path);
+		memset(&st,0,sizeof(st));
+		stat(host,&st);
+		free(host);
+	}
+	free(path);
+	PSP_io_storestat(arg1,&st);
+	put_userland_buf(hle_cpu,arg1+0x58,(unsigned char *)de->d_name,strlen(de->d_name)+1);
+	HLE_RETURN_INT(1);
 }
 
 void HLE_sceIoChdir(int32_t arg0)
@@ -145,6 +492,8 @@ void HLE_sceIoChdir(int32_t arg0)
 char *name;
 	name=get_userland_string(hle_cpu, arg0);
 	debug("HLE_sceIoChdir(Name:%s) ",name);
+	strncpy(_cwd,name,sizeof(_cwd)-1);
+	free(name);
 	HLE_RETURN_INT(0);
 }
 
@@ -208,7 +557,6 @@ char *format;
 	chdir to path
 	ret: 0:ok -1:error
 */
-char _cwd[0x400];
 void HLE_chdir(int32_t arg0)
 {
 char *path;
@@ -236,3 +584,69 @@ char *path;
 }
 
 
+
+/*
+	open files in snapshots: on restore, the host files are opened again
+	by name (relative to the restored cwd, without O_CREAT, O_TRUNC and
+	O_EXCL) and seeked to where they were
+*/
+static void PSP_io_reopen(int fd,int kind,int64_t pos)
+{
+char *host;
+int i;
+	host=PSP_io_hostpath(pspfiles[fd].name);
+	if(kind==1)
+	{
+		pspfiles[fd].local_fd=open(host,pspfiles[fd].flags&~(O_CREAT|O_TRUNC|O_EXCL));
+		if(pspfiles[fd].local_fd!=-1)
+			lseek(pspfiles[fd].local_fd,(off_t)pos,SEEK_SET);
+	}
+	else
+	{
+		pspfiles[fd].local_dir=opendir(host);
+		for(i=0;(i<pspfiles[fd].dir_pos)&&(pspfiles[fd].local_dir!=NULL);i++)
+			readdir(pspfiles[fd].local_dir);
+	}
+	if((pspfiles[fd].local_fd==-1)&&(pspfiles[fd].local_dir==NULL))
+	{
+		fprintf(stderr,"snapshot: can't reopen %s (fd %d)\n",host,fd);
+		free(pspfiles[fd].name);
+		pspfiles[fd].name=NULL;
+	}
+	free(host);
+}
+
+void PSP_io_snapshot(struct snapshot *s,void *extra)
+{
+int fd;
+	PSP_io_init();
+	snapshot_data(s,_cwd,sizeof(_cwd));
+	SNAPSHOT_VAR(s,HLE_KprintfHandler);
+	for(fd=3;fd<PSP_MAXFILES;fd++)
+	{
+		PSP_File *f=&pspfiles[fd];
+		int32_t kind=0;		// 0: unused, 1: file, 2: directory
+		int64_t pos=0;
+		if(snapshot_restoring(s))
+		{
+			if(f->local_fd!=-1) close(f->local_fd);
+			if(f->local_dir!=NULL) closedir(f->local_dir);
+			f->local_fd=-1;
+			f->local_dir=NULL;
+		}
+		else if(f->local_fd!=-1)
+		{
+			kind=1;
+			pos=lseek(f->local_fd,0,SEEK_CUR);
+		}
+		else if(f->local_dir!=NULL)
+			kind=2;
+		SNAPSHOT_VAR(s,kind);
+		snapshot_string(s,&f->name);
+		SNAPSHOT_VAR(s,f->flags);
+		SNAPSHOT_VAR(s,f->dir_pos);
+		SNAPSHOT_VAR(s,pos);
+		if(snapshot_restoring(s)&&(kind!=0))
+			PSP_io_reopen(fd,kind,pos);
+	}
+}
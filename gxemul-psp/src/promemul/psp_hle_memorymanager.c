@@ -10,28 +10,142 @@ SYSCALL(0x20da,0x9d9a5ba1,0x00000000,"sceKernelGetBlockHeadAddr",HLE_sceKernelGe
 	pspsysmem.h
 */
 
+/*
+	The user partition, handed out first-fit from a table of blocks sorted
+	by address. It starts above the loaded image (hle_partition_base is
+	set by the ELF loader) and ends below the stack that
+	useremul__psp_setup() places at the top of RAM.
+*/
+#define PSP_PARTITION_USER	2
+#define PSP_PARTITION_END	0x09e00000
+#define PSP_MAXBLOCKS		256
+
+enum PspSysMemBlockTypes {
+	PSP_SMEM_Low = 0,
+	PSP_SMEM_High,
+	PSP_SMEM_Addr
+};
+
+typedef struct
+{
+	int32_t uid;
+	uint32_t addr;
+	uint32_t size;
+} PSP_MemBlock;
+
+uint32_t     hle_partition_base=0x08900000;
+PSP_MemBlock memblocks[PSP_MAXBLOCKS];
+int          nummemblocks=0;
+int32_t      memblock_nextuid=0x4000;
+
+void PSP_mem_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,hle_partition_base);
+	SNAPSHOT_VAR(s,memblocks);
+	SNAPSHOT_VAR(s,nummemblocks);
+	SNAPSHOT_VAR(s,memblock_nextuid);
+}
+
+/* start of the i:th free gap, and its size */
+static uint32_t PSP_mem_gapstart(int i)
+{
+	return (i==0)?hle_partition_base:(memblocks[i-1].addr+memblocks[i-1].size);
+}
+static uint32_t PSP_mem_gapsize(int i)
+{
+	return ((i==nummemblocks)?PSP_PARTITION_END:memblocks[i].addr)-PSP_mem_gapstart(i);
+}
+
 //SceSize sceKernelMaxFreeMemSize(void);
 void HLE_sceKernelMaxFreeMemSize(void)
 {
+uint32_t max=0;
+int i;
 	debug("HLE_sceKernelMaxFreeMemSize() ");
-	HLE_RETURN_INT(0x00100000); // hack
+	for(i=0;i<=nummemblocks;i++)
+	{
+		if(PSP_mem_gapsize(i)>max) max=PSP_mem_gapsize(i);
+	}
+	HLE_RETURN_INT(max);
 }
 
-//SceSize sceKernelMaxFreeMemSize(void);
+//SceSize sceKernelTotalFreeMemSize(void);
 void HLE_sceKernelTotalFreeMemSize(void)
 {
+uint32_t total=0;
+int i;
 	debug("HLE_sceKernelTotalFreeMemSize() ");
-	HLE_RETURN_INT(0x00100000); // hack
+	for(i=0;i<=nummemblocks;i++)
+	{
+		total+=PSP_mem_gapsize(i);
+	}
+	HLE_RETURN_INT(total);
 }
 
 //SceUID sceKernelAllocPartitionMemory(SceUID partitionid, const char *name, int type, SceSize size, void *addr);
 void HLE_sceKernelAllocPartitionMemory(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4)
 {
 char *name;
+uint32_t size=((uint32_t)arg3+0xff)&~0xff;
+uint32_t addr=0;
+int i,gap=-1;
 	name=get_userland_string(hle_cpu, arg1);
 	debug("HLE_sceKernelAllocPartitionMemory(partitionid:%08x name:%s type:%08x size:%08x addr:%08x) ",
 		arg0,name,arg2,arg3,arg4);
-	HLE_RETURN_INT(1); // hack
+	free(name);
+
+	if(arg0!=PSP_PARTITION_USER)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_ILLEGAL_PARTITION);
+		return;
+	}
+	if(nummemblocks==PSP_MAXBLOCKS)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NO_MEMORY);
+		return;
+	}
+
+	for(i=0;i<=nummemblocks;i++)
+	{
+		uint32_t start=PSP_mem_gapstart(i),len=PSP_mem_gapsize(i);
+		switch(arg2)
+		{
+			case PSP_SMEM_Low:
+				if(len>=size&&gap==-1)
+				{
+					gap=i; addr=start;
+				}
+			break;
+			case PSP_SMEM_High:
+				if(len>=size)
+				{
+					gap=i; addr=start+len-size;
+				}
+			break;
+			case PSP_SMEM_Addr:
+				if(((uint32_t)arg4>=start)&&((uint32_t)arg4+size<=start+len))
+				{
+					gap=i; addr=arg4;
+				}
+			break;
+			default:
+				HLE_RETURN_INT(SCE_KERNEL_ERROR_ILLEGAL_MEMBLOCK_ALLOC_TYPE);
+				return;
+		}
+	}
+	if((gap==-1)|(size==0))
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_FAILED_ALLOC_MEMBLOCK);
+		return;
+	}
+
+	memmove(&memblocks[gap+1],&memblocks[gap],(nummemblocks-gap)*sizeof(PSP_MemBlock));
+	memblocks[gap].uid=memblock_nextuid++;
+	memblocks[gap].addr=addr;
+	memblocks[gap].size=size;
+	nummemblocks++;
+	debug("(at %08x) ",addr);
+	HLE_RETURN_INT(memblocks[gap].uid);
 }
 
 /**
@@ -44,8 +158,19 @@ char *name;
 //int sceKernelFreePartitionMemory(SceUID blockid);
 void HLE_sceKernelFreePartitionMemory(int32_t arg0)
 {
+int i;
 	debug("HLE_sceKernelFreePartitionMemory(blockid:%08x) ",arg0);
-	HLE_RETURN_INT(0); // hack
+	for(i=0;i<nummemblocks;i++)
+	{
+		if(memblocks[i].uid==arg0)
+		{
+			nummemblocks--;
+			memmove(&memblocks[i],&memblocks[i+1],(nummemblocks-i)*sizeof(PSP_MemBlock));
+			HLE_RETURN_INT(0);
+			return;
+		}
+	}
+	HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_UID);
 }
 
 /**
@@ -58,6 +183,15 @@ void HLE_sceKernelFreePartitionMemory(int32_t arg0)
 //void * sceKernelGetBlockHeadAddr(SceUID blockid);
 void HLE_sceKernelGetBlockHeadAddr(int32_t arg0)
 {
+int i;
 	debug("HLE_sceKernelGetBlockHeadAddr(blockid:%08x) ",arg0);
-	HLE_RETURN_INT(0xffffffff8a000000); // hack
+	for(i=0;i<nummemblocks;i++)
+	{
+		if(memblocks[i].uid==arg0)
+		{
+			HLE_RETURN_PTR(memblocks[i].addr);
+			return;
+		}
+	}
+	HLE_RETURN_PTR(0);
 }
@@ -1,5 +1,6 @@
 
 #include "psp_hle.h"
+#include "devices.h"
 
 SYSCALL(0x2000,0xca04a2b9,0x00000000,"sceKernelRegisterSubIntrHandler",HLE_unknown,4);
 SYSCALL(0x2001,0xd61e6961,0x00000000,"sceKernelReleaseSubIntrHandler",HLE_unknown,4);
@@ -14,40 +15,40 @@ SYSCALL(0x2009,0x6e9ea350,0x00000000,"_sceKernelReturnFromCallback",HLE_unknown,
 SYSCALL(0x200a,0x0c106e53,0x00000000,"sceKernelRegisterThreadEventHandler",HLE_unknown,4);
 SYSCALL(0x200b,0x72f3c145,0x00000000,"sceKernelReleaseThreadEventHandler",HLE_unknown,4);
 SYSCALL(0x200c,0x369eeb6b,0x00000000,"sceKernelReferThreadEventHandlerStatus",HLE_unknown,4);
-SYSCALL(0x200d,0xe81caf8f,0x00000000,"sceKernelCreateCallback",HLE_unknown,4);
-SYSCALL(0x200e,0xedba5844,0x00000000,"sceKernelDeleteCallback",HLE_unknown,4);
+SYSCALL(0x200d,0xe81caf8f,0x00000000,"sceKernelCreateCallback",HLE_sceKernelCreateCallback,3);
+SYSCALL(0x200e,0xedba5844,0x00000000,"sceKernelDeleteCallback",HLE_sceKernelDeleteCallback,1);
 SYSCALL(0x200f,0xc11ba8c4,0x00000000,"sceKernelNotifyCallback",HLE_unknown,4);
 SYSCALL(0x2010,0xba4051d6,0x00000000,"sceKernelCancelCallback",HLE_unknown,4);
 SYSCALL(0x2011,0x2a3d44ff,0x00000000,"sceKernelGetCallbackCount",HLE_unknown,4);
-SYSCALL(0x2012,0x349d6d6c,0x00000000,"sceKernelCheckCallback",HLE_unknown,4);
+SYSCALL(0x2012,0x349d6d6c,0x00000000,"sceKernelCheckCallback",HLE_sceKernelCheckCallback,0);
 SYSCALL(0x2013,0x730ed8bc,0x00000000,"sceKernelReferCallbackStatus",HLE_unknown,4);
-SYSCALL(0x2014,0x9ace131e,0x00000000,"sceKernelSleepThread",HLE_unknown,4);
-SYSCALL(0x2015,0x82826f70,0x00000000,"sceKernelSleepThreadCB",HLE_unknown,4);
-SYSCALL(0x2016,0xd59ead2f,0x00000000,"sceKernelWakeupThread",HLE_unknown,4);
+SYSCALL(0x2014,0x9ace131e,0x00000000,"sceKernelSleepThread",HLE_sceKernelSleepThread,0);
+SYSCALL(0x2015,0x82826f70,0x00000000,"sceKernelSleepThreadCB",HLE_sceKernelSleepThread,0);
+SYSCALL(0x2016,0xd59ead2f,0x00000000,"sceKernelWakeupThread",HLE_sceKernelWakeupThread,1);
 SYSCALL(0x2017,0xfccfad26,0x00000000,"sceKernelCancelWakeupThread",HLE_unknown,4);
 SYSCALL(0x2018,0x9944f31f,0x00000000,"sceKernelSuspendThread",HLE_unknown,4);
 SYSCALL(0x2019,0x75156e8f,0x00000000,"sceKernelResumeThread",HLE_unknown,4);
-SYSCALL(0x201a,0x278c0df5,0x00000000,"sceKernelWaitThreadEnd",HLE_unknown,4);
-SYSCALL(0x201b,0x840e8133,0x00000000,"sceKernelWaitThreadEndCB",HLE_unknown,4);
-SYSCALL(0x201c,0xceadeb47,0x00000000,"sceKernelDelayThread",HLE_unknown,4);
-SYSCALL(0x201d,0x68da9e36,0x00000000,"sceKernelDelayThreadCB",HLE_unknown,4);
+SYSCALL(0x201a,0x278c0df5,0x00000000,"sceKernelWaitThreadEnd",HLE_sceKernelWaitThreadEnd,2);
+SYSCALL(0x201b,0x840e8133,0x00000000,"sceKernelWaitThreadEndCB",HLE_sceKernelWaitThreadEnd,2);
+SYSCALL(0x201c,0xceadeb47,0x00000000,"sceKernelDelayThread",HLE_sceKernelDelayThread,1);
+SYSCALL(0x201d,0x68da9e36,0x00000000,"sceKernelDelayThreadCB",HLE_sceKernelDelayThread,1);
 SYSCALL(0x201e,0xbd123d9e,0x00000000,"sceKernelDelaySysClockThread",HLE_unknown,4);
 SYSCALL(0x201f,0x1181e963,0x00000000,"sceKernelDelaySysClockThreadCB",HLE_unknown,4);
-SYSCALL(0x2020,0xd6da4ba1,0x00000000,"sceKernelCreateSema",HLE_unknown,4);
-SYSCALL(0x2021,0x28b6489c,0x00000000,"sceKernelDeleteSema",HLE_unknown,4);
-SYSCALL(0x2022,0x3f53e640,0x00000000,"sceKernelSignalSema",HLE_unknown,4);
-SYSCALL(0x2023,0x4e3a1105,0x00000000,"sceKernelWaitSema",HLE_unknown,4);
-SYSCALL(0x2024,0x6d212bac,0x00000000,"sceKernelWaitSemaCB",HLE_unknown,4);
-SYSCALL(0x2025,0x58b1f937,0x00000000,"sceKernelPollSema",HLE_unknown,4);
+SYSCALL(0x2020,0xd6da4ba1,0x00000000,"sceKernelCreateSema",HLE_sceKernelCreateSema,5);
+SYSCALL(0x2021,0x28b6489c,0x00000000,"sceKernelDeleteSema",HLE_sceKernelDeleteSema,1);
+SYSCALL(0x2022,0x3f53e640,0x00000000,"sceKernelSignalSema",HLE_sceKernelSignalSema,2);
+SYSCALL(0x2023,0x4e3a1105,0x00000000,"sceKernelWaitSema",HLE_sceKernelWaitSema,3);
+SYSCALL(0x2024,0x6d212bac,0x00000000,"sceKernelWaitSemaCB",HLE_sceKernelWaitSema,3);
+SYSCALL(0x2025,0x58b1f937,0x00000000,"sceKernelPollSema",HLE_sceKernelPollSema,2);
 SYSCALL(0x2026,0x8ffdf9a2,0x00000000,"sceKernelCancelSema",HLE_unknown,4);
-SYSCALL(0x2027,0xbc6febc5,0x00000000,"sceKernelReferSemaStatus",HLE_unknown,4);
-SYSCALL(0x2028,0x55c20a00,0x00000000,"sceKernelCreateEventFlag",HLE_unknown,4);
-SYSCALL(0x2029,0xef9e4c70,0x00000000,"sceKernelDeleteEventFlag",HLE_unknown,4);
-SYSCALL(0x202a,0x1fb15a32,0x00000000,"sceKernelSetEventFlag",HLE_unknown,4);
-SYSCALL(0x202b,0x812346e4,0x00000000,"sceKernelClearEventFlag",HLE_unknown,4);
-SYSCALL(0x202c,0x402fcf22,0x00000000,"sceKernelWaitEventFlag",HLE_unknown,4);
-SYSCALL(0x202d,0x328c546a,0x00000000,"sceKernelWaitEventFlagCB",HLE_unknown,4);
-SYSCALL(0x202e,0x30fd48f0,0x00000000,"sceKernelPollEventFlag",HLE_unknown,4);
+SYSCALL(0x2027,0xbc6febc5,0x00000000,"sceKernelReferSemaStatus",HLE_sceKernelReferSemaStatus,2);
+SYSCALL(0x2028,0x55c20a00,0x00000000,"sceKernelCreateEventFlag",HLE_sceKernelCreateEventFlag,4);
+SYSCALL(0x2029,0xef9e4c70,0x00000000,"sceKernelDeleteEventFlag",HLE_sceKernelDeleteEventFlag,1);
+SYSCALL(0x202a,0x1fb15a32,0x00000000,"sceKernelSetEventFlag",HLE_sceKernelSetEventFlag,2);
+SYSCALL(0x202b,0x812346e4,0x00000000,"sceKernelClearEventFlag",HLE_sceKernelClearEventFlag,2);
+SYSCALL(0x202c,0x402fcf22,0x00000000,"sceKernelWaitEventFlag",HLE_sceKernelWaitEventFlag,5);
+SYSCALL(0x202d,0x328c546a,0x00000000,"sceKernelWaitEventFlagCB",HLE_sceKernelWaitEventFlag,5);
+SYSCALL(0x202e,0x30fd48f0,0x00000000,"sceKernelPollEventFlag",HLE_sceKernelPollEventFlag,4);
 SYSCALL(0x202f,0xcd203292,0x00000000,"sceKernelCancelEventFlag",HLE_unknown,4);
 SYSCALL(0x2030,0xa66b0120,0x00000000,"sceKernelReferEventFlagStatus",HLE_unknown,4);
 SYSCALL(0x2031,0x8125221d,0x00000000,"sceKernelCreateMbx",HLE_unknown,4);
@@ -89,9 +90,9 @@ SYSCALL(0x2054,0x110dec9a,0x00000000,"sceKernelUSec2SysClock",HLE_unknown,4);
 SYSCALL(0x2055,0xc8cd158c,0x00000000,"sceKernelUSec2SysClockWide",HLE_unknown,4);
 SYSCALL(0x2056,0xba6b92e2,0x00000000,"sceKernelSysClock2USec",HLE_unknown,4);
 SYSCALL(0x2057,0xe1619d7c,0x00000000,"sceKernelSysClock2USecWide",HLE_unknown,4);
-SYSCALL(0x2058,0xdb738f35,0x00000000,"sceKernelGetSystemTime",HLE_unknown,4);
-SYSCALL(0x2059,0x82bc5777,0x00000000,"sceKernelGetSystemTimeWide",HLE_unknown,4);
-SYSCALL(0x205a,0x369ed59d,0x00000000,"sceKernelGetSystemTimeLow",HLE_unknown,4);
+SYSCALL(0x2058,0xdb738f35,0x00000000,"sceKernelGetSystemTime",HLE_sceKernelGetSystemTime,1);
+SYSCALL(0x2059,0x82bc5777,0x00000000,"sceKernelGetSystemTimeWide",HLE_sceKernelGetSystemTimeWide,0);
+SYSCALL(0x205a,0x369ed59d,0x00000000,"sceKernelGetSystemTimeLow",HLE_sceKernelGetSystemTimeLow,0);
 SYSCALL(0x205b,0x6652b8ca,0x00000000,"sceKernelSetAlarm",HLE_unknown,4);
 SYSCALL(0x205c,0xb2c25152,0x00000000,"sceKernelSetSysClockAlarm",HLE_unknown,4);
 SYSCALL(0x205d,0x7e65b999,0x00000000,"sceKernelCancelAlarm",HLE_unknown,4);
@@ -112,7 +113,7 @@ SYSCALL(0x206b,0xd2d615ef,0x00000000,"sceKernelCancelVTimerHandler",HLE_unknown,
 SYSCALL(0x206c,0x5f32beaa,0x00000000,"sceKernelReferVTimerStatus",HLE_unknown,4);
 
 
-SYSCALL(0x20b4,0xbfa98062,0x00000000,"sceKernelDcacheInvalidateRange",HLE_unknown,4);
+SYSCALL(0x20b4,0xbfa98062,0x00000000,"sceKernelDcacheInvalidateRange",HLE_sceKernelCacheNop,0);
 SYSCALL(0x20b5,0xc8186a58,0x00000000,"sceKernelUtilsMd5Digest",HLE_unknown,4);
 SYSCALL(0x20b6,0x9e5c5086,0x00000000,"sceKernelUtilsMd5BlockInit",HLE_unknown,4);
 SYSCALL(0x20b7,0x61e1e525,0x00000000,"sceKernelUtilsMd5BlockUpdate",HLE_unknown,4);
@@ -125,13 +126,13 @@ SYSCALL(0x20bd,0xe860e75e,0x00000000,"sceKernelUtilsMt19937Init",HLE_unknown,4);
 SYSCALL(0x20be,0x06fb8a63,0x00000000,"sceKernelUtilsMt19937UInt",HLE_unknown,4);
 SYSCALL(0x20bf,0x37fb5c42,0x00000000,"sceKernelGetGPI",HLE_unknown,4);
 SYSCALL(0x20c0,0x6ad345d7,0x00000000,"sceKernelSetGPO",HLE_unknown,4);
-SYSCALL(0x20c1,0x91e4f6a7,0x00000000,"sceKernelLibcClock",HLE_unknown,4);
-SYSCALL(0x20c2,0x27cc57f0,0x00000000,"sceKernelLibcTime",HLE_unknown,4);
-SYSCALL(0x20c3,0x71ec4271,0x00000000,"sceKernelLibcGettimeofday",HLE_unknown,4);
-SYSCALL(0x20c4,0x79d1c3fa,0x00000000,"sceKernelDcacheWritebackAll",HLE_unknown,4);
-SYSCALL(0x20c5,0xb435dec5,0x00000000,"sceKernelDcacheWritebackInvalidateAll",HLE_unknown,4);
-SYSCALL(0x20c6,0x3ee30821,0x00000000,"sceKernelDcacheWritebackRange",HLE_unknown,4);
-SYSCALL(0x20c7,0x34b9fa9e,0x00000000,"sceKernelDcacheWritebackInvalidateRange",HLE_unknown,4);
+SYSCALL(0x20c1,0x91e4f6a7,0x00000000,"sceKernelLibcClock",HLE_sceKernelLibcClock,0);
+SYSCALL(0x20c2,0x27cc57f0,0x00000000,"sceKernelLibcTime",HLE_sceKernelLibcTime,1);
+SYSCALL(0x20c3,0x71ec4271,0x00000000,"sceKernelLibcGettimeofday",HLE_sceKernelLibcGettimeofday,2);
+SYSCALL(0x20c4,0x79d1c3fa,0x00000000,"sceKernelDcacheWritebackAll",HLE_sceKernelCacheNop,0);
+SYSCALL(0x20c5,0xb435dec5,0x00000000,"sceKernelDcacheWritebackInvalidateAll",HLE_sceKernelCacheNop,0);
+SYSCALL(0x20c6,0x3ee30821,0x00000000,"sceKernelDcacheWritebackRange",HLE_sceKernelCacheNop,0);
+SYSCALL(0x20c7,0x34b9fa9e,0x00000000,"sceKernelDcacheWritebackInvalidateRange",HLE_sceKernelCacheNop,0);
 SYSCALL(0x20c8,0x80001c4c,0x00000000,"sceKernelDcacheProbe",HLE_unknown,4);
 SYSCALL(0x20c9,0x16641d70,0x00000000,"sceKernelDcacheReadTag",HLE_unknown,4);
 SYSCALL(0x20ca,0x4fd31c9d,0x00000000,"sceKernelIcacheProbe",HLE_unknown,4);
@@ -144,9 +145,9 @@ SYSCALL(0x20dc,0xeadb1bd7,0x00000000,"sceKernelPowerLock",HLE_unknown,4);
 SYSCALL(0x20dd,0x3aee7261,0x00000000,"sceKernelPowerUnlock",HLE_unknown,4);
 SYSCALL(0x20de,0x090ccb3f,0x00000000,"sceKernelPowerTick",HLE_unknown,4);
 SYSCALL(0x20df,0xbd2f1094,0x00000000,"sceKernelLoadExec",HLE_unknown,4);
-SYSCALL(0x20e0,0x2ac9954b,0x00000000,"sceKernelExitGameWithStatus",HLE_unknown,4);
-SYSCALL(0x20e1,0x05572a5f,0x00000000,"sceKernelExitGame",HLE_unknown,4);
-SYSCALL(0x20e2,0x4ac57943,0x00000000,"sceKernelRegisterExitCallback",HLE_unknown,4);
+SYSCALL(0x20e0,0x2ac9954b,0x00000000,"sceKernelExitGameWithStatus",HLE_sceKernelExitGameWithStatus,1);
+SYSCALL(0x20e1,0x05572a5f,0x00000000,"sceKernelExitGame",HLE_sceKernelExitGame,0);
+SYSCALL(0x20e2,0x4ac57943,0x00000000,"sceKernelRegisterExitCallback",HLE_sceKernelRegisterExitCallback,1);
 SYSCALL(0x20e3,0x617f3fe6,0x00000000,"sceDmacMemcpy",HLE_unknown,4);
 SYSCALL(0x20e4,0xd97f94d8,0x00000000,"sceDmacTryMemcpy",HLE_unknown,4);
 
@@ -248,3 +249,72 @@ SYSCALL(0x220d,0x588845da, 0x00000000,"sceHprmEnd",HLE_unknown,4);
 // ModuleMgrForKernel
 SYSCALL(0x220e,0x644395E2, 0x00000000,"sceKernelGetModuleIdList",HLE_sceKernelGetModuleIdList,3);
 // highest atm: 0x2215 
+
+/**
+	LoadExecForUser
+*/
+
+//void sceKernelExitGame(void);
+void HLE_sceKernelExitGame(void)
+{
+	debug("HLE_sceKernelExitGame() ");
+	PSP_syscall_halt(0);
+}
+//void sceKernelExitGameWithStatus(int status);
+void HLE_sceKernelExitGameWithStatus(int32_t arg0)
+{
+	debug("HLE_sceKernelExitGameWithStatus(status:%08x) ",arg0);
+	PSP_syscall_halt(arg0);
+}
+//int sceKernelRegisterExitCallback(int cbid);
+void HLE_sceKernelRegisterExitCallback(int32_t arg0)
+{
+	debug("HLE_sceKernelRegisterExitCallback(cbid:%08x) ",arg0);
+	HLE_RETURN_INT(0);
+}
+
+/**
+	UtilsForUser
+*/
+
+// there are no caches to write back, the cpu and the HLE layer see the same memory;
+// but the Media Engine (if any) needs to see code written by this cpu
+void HLE_sceKernelCacheNop(void)
+{
+	debug("HLE_sceKernelCacheNop() ");
+	dev_psp_me_cache_sync(hle_cpu);
+	HLE_RETURN_INT(0);
+}
+
+//clock_t sceKernelLibcClock(void);
+void HLE_sceKernelLibcClock(void)
+{
+	debug("HLE_sceKernelLibcClock() ");
+	HLE_RETURN_INT((uint32_t)PSP_systime_usec());
+}
+//time_t sceKernelLibcTime(time_t *t);
+void HLE_sceKernelLibcTime(int32_t arg0)
+{
+uint32_t t=(uint32_t)(PSP_hosttime_usec()/1000000);
+	debug("HLE_sceKernelLibcTime(t:%08x) ",arg0);
+	if(arg0!=0)
+		store_32bit_word(hle_cpu, arg0, t);
+	HLE_RETURN_INT(t);
+}
+//int sceKernelLibcGettimeofday(struct timeval *tp, struct timezone *tzp);
+void HLE_sceKernelLibcGettimeofday(int32_t arg0,int32_t arg1)
+{
+uint64_t t=PSP_hosttime_usec();
+	debug("HLE_sceKernelLibcGettimeofday(tp:%08x tzp:%08x) ",arg0,arg1);
+	if(arg0!=0)
+	{
+		store_32bit_word(hle_cpu, arg0, (uint32_t)(t/1000000));
+		store_32bit_word(hle_cpu, arg0+4, (uint32_t)(t%1000000));
+	}
+	if(arg1!=0)
+	{
+		store_32bit_word(hle_cpu, arg1, 0);
+		store_32bit_word(hle_cpu, arg1+4, 0);
+	}
+	HLE_RETURN_INT(0);
+}
@@ -14,6 +14,11 @@ SYSCALL(0x20d5,0x748cbed9,0x00000000,"sceKernelQueryModuleInfo",HLE_unknown,4);
 
 int        nummodules=0;
 
+void PSP_module_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,nummodules);
+}
+
 //SceUID sceKernelLoadModule(const char *path, int flags, SceKernelLMOption *option);
 void HLE_sceKernelLoadModule(int32_t arg0,int32_t arg1,int32_t arg2)
 {
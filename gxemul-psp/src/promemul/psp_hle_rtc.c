@@ -1,16 +1,17 @@
 
 #include "psp_hle.h"
+#include <time.h>
 
-SYSCALL(0x20f6,0xc41c2853,0x00000000,"sceRtcGetTickResolution",HLE_unknown,4);
-SYSCALL(0x20f7,0x3f7ad767,0x00000000,"sceRtcGetCurrentTick",HLE_unknown,4);
+SYSCALL(0x20f6,0xc41c2853,0x00000000,"sceRtcGetTickResolution",HLE_sceRtcGetTickResolution,0);
+SYSCALL(0x20f7,0x3f7ad767,0x00000000,"sceRtcGetCurrentTick",HLE_sceRtcGetCurrentTick,1);
 SYSCALL(0x20f8,0x029ca3b3,0x00000000,"sceRtc_029CA3B3",HLE_unknown,4);
-SYSCALL(0x20f9,0x4cfa57b0,0x00000000,"sceRtcGetCurrentClock",HLE_unknown,4);
-SYSCALL(0x20fa,0xe7c27d1b,0x00000000,"sceRtcGetCurrentClockLocalTime",HLE_unknown,4);
+SYSCALL(0x20f9,0x4cfa57b0,0x00000000,"sceRtcGetCurrentClock",HLE_sceRtcGetCurrentClock,2);
+SYSCALL(0x20fa,0xe7c27d1b,0x00000000,"sceRtcGetCurrentClockLocalTime",HLE_sceRtcGetCurrentClockLocalTime,1);
 SYSCALL(0x20fb,0x34885e0d,0x00000000,"sceRtcConvertUtcToLocalTime",HLE_unknown,4);
 SYSCALL(0x20fc,0x779242a2,0x00000000,"sceRtcConvertLocalTimeToUTC",HLE_unknown,4);
-SYSCALL(0x20fd,0x42307a17,0x00000000,"sceRtcIsLeapYear",HLE_unknown,4);
-SYSCALL(0x20fe,0x05ef322c,0x00000000,"sceRtcGetDaysInMonth",HLE_unknown,4);
-SYSCALL(0x20ff,0x57726bc1,0x00000000,"sceRtcGetDayOfWeek",HLE_unknown,4);
+SYSCALL(0x20fd,0x42307a17,0x00000000,"sceRtcIsLeapYear",HLE_sceRtcIsLeapYear,1);
+SYSCALL(0x20fe,0x05ef322c,0x00000000,"sceRtcGetDaysInMonth",HLE_sceRtcGetDaysInMonth,2);
+SYSCALL(0x20ff,0x57726bc1,0x00000000,"sceRtcGetDayOfWeek",HLE_sceRtcGetDayOfWeek,3);
 SYSCALL(0x2100,0x4b1b5e82,0x00000000,"sceRtcCheckValid",HLE_unknown,4);
 SYSCALL(0x2101,0x3a807cc8,0x00000000,"sceRtcSetTime_t",HLE_unknown,4);
 SYSCALL(0x2102,0x27c4594c,0x00000000,"sceRtcGetTime_t",HLE_unknown,4);
@@ -18,8 +19,8 @@ SYSCALL(0x2103,0xf006f264,0x00000000,"sceRtcSetDosTime",HLE_unknown,4);
 SYSCALL(0x2104,0x36075567,0x00000000,"sceRtcGetDosTime",HLE_unknown,4);
 SYSCALL(0x2105,0x7ace4c04,0x00000000,"sceRtcSetWin32FileTime",HLE_unknown,4);
 SYSCALL(0x2106,0xcf561893,0x00000000,"sceRtcGetWin32FileTime",HLE_unknown,4);
-SYSCALL(0x2107,0x7ed29e40,0x00000000,"sceRtcSetTick",HLE_unknown,4);
-SYSCALL(0x2108,0x6ff40acc,0x00000000,"sceRtcGetTick",HLE_unknown,4);
+SYSCALL(0x2107,0x7ed29e40,0x00000000,"sceRtcSetTick",HLE_sceRtcSetTick,2);
+SYSCALL(0x2108,0x6ff40acc,0x00000000,"sceRtcGetTick",HLE_sceRtcGetTick,2);
 SYSCALL(0x2109,0x9ed0ae87,0x00000000,"sceRtcCompareTick",HLE_unknown,4);
 SYSCALL(0x210a,0x44f45e05,0x00000000,"sceRtcTickAddTicks",HLE_unknown,4);
 SYSCALL(0x210b,0x26d25a5d,0x00000000,"sceRtcTickAddMicroseconds",HLE_unknown,4);
@@ -37,3 +38,133 @@ SYSCALL(0x2116,0x27f98543,0x00000000,"sceRtcFormatRFC3339LocalTime",HLE_unknown,
 SYSCALL(0x2117,0xdfbc5f16,0x00000000,"sceRtcParseDateTime",HLE_unknown,4);
 SYSCALL(0x2118,0x28e1e988,0x00000000,"sceRtcParseRFC3339",HLE_unknown,4);
  
+
+/**
+	(psprtc.h)
+
+	ticks are microseconds since 0001-01-01 00:00:00 UTC
+*/
+#define PSP_RTC_UNIX_EPOCH	62135596800ULL	// seconds from 0001-01-01 to 1970-01-01
+
+static uint64_t PSP_rtc_now(void)
+{
+	return PSP_hosttime_usec()+PSP_RTC_UNIX_EPOCH*1000000;
+}
+
+/* pspTime: u16 year, month, day, hour, minutes, seconds; u32 microseconds */
+static void PSP_rtc_storetime(uint32_t addr,uint64_t tick)
+{
+time_t t=(time_t)(tick/1000000-PSP_RTC_UNIX_EPOCH);
+struct tm tm;
+	gmtime_r(&t,&tm);
+	store_32bit_word(hle_cpu, addr+0, (tm.tm_year+1900)|((tm.tm_mon+1)<<16));
+	store_32bit_word(hle_cpu, addr+4, tm.tm_mday|(tm.tm_hour<<16));
+	store_32bit_word(hle_cpu, addr+8, tm.tm_min|(tm.tm_sec<<16));
+	store_32bit_word(hle_cpu, addr+12, tick%1000000);
+}
+
+static uint64_t PSP_rtc_loadtime(uint32_t addr)
+{
+uint32_t w0,w1,w2,w3;
+struct tm tm;
+	w0=load_32bit_word(hle_cpu, addr+0);
+	w1=load_32bit_word(hle_cpu, addr+4);
+	w2=load_32bit_word(hle_cpu, addr+8);
+	w3=load_32bit_word(hle_cpu, addr+12);
+	memset(&tm,0,sizeof(tm));
+	tm.tm_year=(w0&0xffff)-1900;
+	tm.tm_mon=(w0>>16)-1;
+	tm.tm_mday=w1&0xffff;
+	tm.tm_hour=w1>>16;
+	tm.tm_min=w2&0xffff;
+	tm.tm_sec=w2>>16;
+	return ((uint64_t)(timegm(&tm)+PSP_RTC_UNIX_EPOCH))*1000000+w3;
+}
+
+static void PSP_rtc_storetick(uint32_t addr,uint64_t tick)
+{
+	store_32bit_word(hle_cpu, addr, (uint32_t)tick);
+	store_32bit_word(hle_cpu, addr+4, (uint32_t)(tick>>32));
+}
+
+//u32 sceRtcGetTickResolution();
+void HLE_sceRtcGetTickResolution(void)
+{
+	debug("HLE_sceRtcGetTickResolution() ");
+	HLE_RETURN_INT(1000000);
+}
+//int sceRtcGetCurrentTick(u64 *tick);
+void HLE_sceRtcGetCurrentTick(int32_t arg0)
+{
+	debug("HLE_sceRtcGetCurrentTick(tick:%08x) ",arg0);
+	PSP_rtc_storetick(arg0,PSP_rtc_now());
+	HLE_RETURN_INT(0);
+}
+//int sceRtcGetCurrentClock(pspTime *time, int tz);
+void HLE_sceRtcGetCurrentClock(int32_t arg0,int32_t arg1)
+{
+	debug("HLE_sceRtcGetCurrentClock(time:%08x tz:%d) ",arg0,arg1);
+	PSP_rtc_storetime(arg0,PSP_rtc_now()+(int64_t)arg1*60*1000000);
+	HLE_RETURN_INT(0);
+}
+//int sceRtcGetCurrentClockLocalTime(pspTime *time);
+void HLE_sceRtcGetCurrentClockLocalTime(int32_t arg0)
+{
+uint64_t now=PSP_rtc_now();
+time_t t=(time_t)(now/1000000-PSP_RTC_UNIX_EPOCH);
+struct tm tm;
+	debug("HLE_sceRtcGetCurrentClockLocalTime(time:%08x) ",arg0);
+	localtime_r(&t,&tm);
+	PSP_rtc_storetime(arg0,now+(int64_t)tm.tm_gmtoff*1000000);
+	HLE_RETURN_INT(0);
+}
+//int sceRtcIsLeapYear(int year);
+void HLE_sceRtcIsLeapYear(int32_t arg0)
+{
+	debug("HLE_sceRtcIsLeapYear(year:%d) ",arg0);
+	HLE_RETURN_INT(((arg0%4==0)&&(arg0%100!=0))||(arg0%400==0));
+}
+//int sceRtcGetDaysInMonth(int year, int month);
+void HLE_sceRtcGetDaysInMonth(int32_t arg0,int32_t arg1)
+{
+static const int days[12]={31,28,31,30,31,30,31,31,30,31,30,31};
+int leap=((arg0%4==0)&&(arg0%100!=0))||(arg0%400==0);
+	debug("HLE_sceRtcGetDaysInMonth(year:%d month:%d) ",arg0,arg1);
+	if((arg1<1)|(arg1>12))
+	{
+		HLE_RETURN_INT(0x80000102);	// SCE_ERROR_INVALID_VALUE
+		return;
+	}
+	HLE_RETURN_INT(days[arg1-1]+((arg1==2)&leap));
+}
+//int sceRtcGetDayOfWeek(int year, int month, int day);
+void HLE_sceRtcGetDayOfWeek(int32_t arg0,int32_t arg1,int32_t arg2)
+{
+struct tm tm;
+time_t t;
+	debug("HLE_sceRtcGetDayOfWeek(year:%d month:%d day:%d) ",arg0,arg1,arg2);
+	memset(&tm,0,sizeof(tm));
+	tm.tm_year=arg0-1900;
+	tm.tm_mon=arg1-1;
+	tm.tm_mday=arg2;
+	t=timegm(&tm);
+	gmtime_r(&t,&tm);
+	HLE_RETURN_INT(tm.tm_wday);
+}
+//int sceRtcGetTick(const pspTime *date, u64 *tick);
+void HLE_sceRtcGetTick(int32_t arg0,int32_t arg1)
+{
+	debug("HLE_sceRtcGetTick(date:%08x tick:%08x) ",arg0,arg1);
+	PSP_rtc_storetick(arg1,PSP_rtc_loadtime(arg0));
+	HLE_RETURN_INT(0);
+}
+//int sceRtcSetTick(pspTime *date, const u64 *tick);
+void HLE_sceRtcSetTick(int32_t arg0,int32_t arg1)
+{
+uint64_t tick;
+	debug("HLE_sceRtcSetTick(date:%08x tick:%08x) ",arg0,arg1);
+	tick=(uint32_t)load_32bit_word(hle_cpu, arg1)|
+		((uint64_t)(uint32_t)load_32bit_word(hle_cpu, arg1+4)<<32);
+	PSP_rtc_storetime(arg0,tick);
+	HLE_RETURN_INT(0);
+}
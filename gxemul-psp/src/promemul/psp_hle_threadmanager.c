@@ -1,10 +1,10 @@
 #include "psp_hle.h"
 
 SYSCALL(0x206d,0x446d8de6,0x00000000,"sceKernelCreateThread",HLE_sceKernelCreateThread,4);
-SYSCALL(0x206e,0x9fa03cd3,0x00000000,"sceKernelDeleteThread",HLE_unknown,4);
+SYSCALL(0x206e,0x9fa03cd3,0x00000000,"sceKernelDeleteThread",HLE_sceKernelDeleteThread,1);
 SYSCALL(0x206f,0xf475845d,0x00000000,"sceKernelStartThread",HLE_sceKernelStartThread,3);
-SYSCALL(0x2070,0x532a522e,0x00000000,"_sceKernelExitThread",HLE_unknown,4);
-SYSCALL(0x2071,0xaa73c935,0x00000000,"sceKernelExitThread",HLE_unknown,4);
+SYSCALL(0x2070,0x532a522e,0x00000000,"_sceKernelExitThread",HLE_sceKernelExitThread,1);
+SYSCALL(0x2071,0xaa73c935,0x00000000,"sceKernelExitThread",HLE_sceKernelExitThread,1);
 SYSCALL(0x2072,0x809ce29b,0x00000000,"sceKernelExitDeleteThread",HLE_sceKernelExitDeleteThread,1);
 SYSCALL(0x2073,0x616403ba,0x00000000,"sceKernelTerminateThread",HLE_unknown,4);
 SYSCALL(0x2074,0x383f7bcc,0x00000000,"sceKernelTerminateDeleteThread",HLE_unknown,4);
@@ -14,7 +14,7 @@ SYSCALL(0x2077,0xea748e31,0x00000000,"sceKernelChangeCurrentThreadAttr",HLE_unkn
 SYSCALL(0x2078,0x71bc9871,0x00000000,"sceKernelChangeThreadPriority",HLE_unknown,4);
 SYSCALL(0x2079,0x912354a7,0x00000000,"sceKernelRotateThreadReadyQueue",HLE_unknown,4);
 SYSCALL(0x207a,0x2c34e053,0x00000000,"sceKernelReleaseWaitThread",HLE_unknown,4);
-SYSCALL(0x207b,0x293b45b8,0x00000000,"sceKernelGetThreadId",HLE_unknown,4);
+SYSCALL(0x207b,0x293b45b8,0x00000000,"sceKernelGetThreadId",HLE_sceKernelGetThreadId,0);
 SYSCALL(0x207c,0x94aa61ee,0x00000000,"sceKernelGetThreadCurrentPriority",HLE_unknown,4);
 SYSCALL(0x207d,0x3b183e26,0x00000000,"sceKernelGetThreadExitStatus",HLE_unknown,4);
 SYSCALL(0x207e,0xd13bde95,0x00000000,"sceKernelCheckThreadStack",HLE_unknown,4);
@@ -27,53 +27,378 @@ SYSCALL(0x2084,0x57cf62dd,0x00000000,"sceKernelGetThreadmanIdType",HLE_unknown,4
 SYSCALL(0x2085,0x64d4540e,0x00000000,"sceKernelReferThreadProfiler",HLE_unknown,4);
 SYSCALL(0x2086,0x8218b4dd,0x00000000,"sceKernelReferGlobalProfiler",HLE_unknown,4);
 
+#include <sys/time.h>
+
+/*
+	Threads are run to completion, or until they block: sceKernelStartThread
+	saves the registers of the calling thread and jumps to the new thread,
+	which starts on the stack of the caller. When the new thread exits, or
+	does something that would block (sleeping, waiting on a semaphore or
+	event flag that isn't ready), the caller is resumed with the saved
+	registers and the new thread is dropped. The same thing happening in
+	the first thread halts the emulation, as there is nothing left to run.
+
+	That covers the usual homebrew pattern (a main thread started from
+	module_start, callback threads that just sleep) without a scheduler.
+*/
+#define PSP_MAXTHREADS		32
+#define PSP_MAXFRAMES		16
+#define PSP_MAXSEMAS		64
+#define PSP_MAXEVENTFLAGS	64
+#define PSP_MAXCALLBACKS	32
+
+#define PSP_THREAD_UID(_i)	(0x1000+(_i))
+#define PSP_SEMA_UID(_i)	(0x2000+(_i))
+#define PSP_EVENTFLAG_UID(_i)	(0x3000+(_i))
+#define PSP_CALLBACK_UID(_i)	(0x4800+(_i))
+
+/* threads return here, into a call to _sceKernelExitThread (the kernel
+   partition is not used by anything else under HLE) */
+#define PSP_THREAD_RETURN	0x08000000
+
+enum PspThreadStatus
+{
+	PSP_THREAD_RUNNING = 1,
+	PSP_THREAD_READY   = 2,
+	PSP_THREAD_WAITING = 4,
+	PSP_THREAD_SUSPEND = 8,
+	PSP_THREAD_STOPPED = 16,
+	PSP_THREAD_KILLED  = 32,
+};
+
 typedef struct
 {
 	char *name;
 	int32_t func;
 	int32_t prio;
 	int32_t stacksize;
+	int32_t status;
+	int32_t exitstatus;
 } PSP_Thread; 
 
-PSP_Thread threads[10];
-int        numthreads=0;
+/* registers of a thread that started another one */
+typedef struct
+{
+	int32_t thid;
+	uint64_t gpr[32];
+	uint64_t hi,lo;
+} PSP_ThreadFrame;
+
+typedef struct
+{
+	char *name;
+	int32_t init;
+	int32_t count;
+	int32_t max;
+} PSP_Sema;
+
+typedef struct
+{
+	char *name;
+	uint32_t bits;
+} PSP_EventFlag;
+
+typedef struct
+{
+	char *name;
+	int32_t func;
+	int32_t arg;
+} PSP_Callback;
+
+PSP_Thread      threads[PSP_MAXTHREADS];
+int             numthreads=0;
+PSP_ThreadFrame threadframes[PSP_MAXFRAMES];
+int             numthreadframes=0;
+int32_t         currentthread=0;
+PSP_Sema        semas[PSP_MAXSEMAS];
+int             numsemas=0;
+PSP_EventFlag   eventflags[PSP_MAXEVENTFLAGS];
+int             numeventflags=0;
+PSP_Callback    callbacks[PSP_MAXCALLBACKS];
+int             numcallbacks=0;
+
+static struct timeval systime_base;
+
+static uint64_t PSP_systime_host(void)
+{
+struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return (uint64_t)(tv.tv_sec-systime_base.tv_sec)*1000000+
+		(tv.tv_usec-systime_base.tv_usec);
+}
+
+/* microseconds since the emulation started (recorded/replayed, see snapshot.c) */
+uint64_t PSP_systime_usec(void)
+{
+	return replay_event(hle_cpu->machine,REPLAY_SYSTIME,PSP_systime_host());
+}
+
+/* microseconds since 1970, for the libc and rtc clocks */
+uint64_t PSP_hosttime_usec(void)
+{
+struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return replay_event(hle_cpu->machine,REPLAY_HOSTTIME,
+		(uint64_t)tv.tv_sec*1000000+tv.tv_usec);
+}
+
+/* thread manager state for snapshots; the time base is kept relative */
+void PSP_thread_snapshot(struct snapshot *s,void *extra)
+{
+uint64_t systime=PSP_systime_host();
+int i;
+	for(i=0;i<PSP_MAXTHREADS;i++)
+	{
+		snapshot_string(s,&threads[i].name);
+		SNAPSHOT_VAR(s,threads[i].func);
+		SNAPSHOT_VAR(s,threads[i].prio);
+		SNAPSHOT_VAR(s,threads[i].stacksize);
+		SNAPSHOT_VAR(s,threads[i].status);
+		SNAPSHOT_VAR(s,threads[i].exitstatus);
+	}
+	SNAPSHOT_VAR(s,numthreads);
+	SNAPSHOT_VAR(s,threadframes);
+	SNAPSHOT_VAR(s,numthreadframes);
+	SNAPSHOT_VAR(s,currentthread);
+	for(i=0;i<PSP_MAXSEMAS;i++)
+	{
+		snapshot_string(s,&semas[i].name);
+		SNAPSHOT_VAR(s,semas[i].init);
+		SNAPSHOT_VAR(s,semas[i].count);
+		SNAPSHOT_VAR(s,semas[i].max);
+	}
+	SNAPSHOT_VAR(s,numsemas);
+	for(i=0;i<PSP_MAXEVENTFLAGS;i++)
+	{
+		snapshot_string(s,&eventflags[i].name);
+		SNAPSHOT_VAR(s,eventflags[i].bits);
+	}
+	SNAPSHOT_VAR(s,numeventflags);
+	for(i=0;i<PSP_MAXCALLBACKS;i++)
+	{
+		snapshot_string(s,&callbacks[i].name);
+		SNAPSHOT_VAR(s,callbacks[i].func);
+		SNAPSHOT_VAR(s,callbacks[i].arg);
+	}
+	SNAPSHOT_VAR(s,numcallbacks);
+	SNAPSHOT_VAR(s,systime);
+	if(snapshot_restoring(s))
+	{
+		struct timeval tv;
+		gettimeofday(&tv,NULL);
+		tv.tv_sec-=systime/1000000;
+		tv.tv_usec-=systime%1000000;
+		if(tv.tv_usec<0)
+		{
+			tv.tv_usec+=1000000;
+			tv.tv_sec--;
+		}
+		systime_base=tv;
+	}
+}
+
+/*
+	called from useremul__psp_setup(): the program's entry point is
+	thread 0, returning from it exits the thread
+*/
+void PSP_thread_setup(struct cpu *cpu)
+{
+	gettimeofday(&systime_base,NULL);
+
+	store_32bit_word(cpu, PSP_THREAD_RETURN+0, 0x00402021);	// move a0,v0
+	store_32bit_word(cpu, PSP_THREAD_RETURN+4,
+		(PSP_findsyscall_byname("_sceKernelExitThread")<<6)|0x0c);
+	store_32bit_word(cpu, PSP_THREAD_RETURN+8, 0x00000000);	// nop
+	add_symbol_name(&cpu->machine->symbol_context,PSP_THREAD_RETURN,12, "hle_thread_return", 0, 0);
+
+	threads[0].name=strdup("user_main");
+	threads[0].func=cpu->pc;
+	threads[0].prio=0x20;
+	threads[0].status=PSP_THREAD_RUNNING;
+	numthreads=1;
+	currentthread=0;
+
+	cpu->cd.mips.gpr[MIPS_GPR_RA]=PSP_THREAD_RETURN;
+}
+
+static void PSP_thread_jump(uint32_t addr)
+{
+	hle_cpu->cd.mips.delay_jmpaddr=addr;
+	hle_cpu->pc=(int32_t)addr;
+}
+
+static int PSP_thread_index(int32_t thid)
+{
+	if(thid==0) return currentthread;	// 0 is the calling thread
+	thid-=PSP_THREAD_UID(0);
+	if((thid<0)|(thid>=numthreads)) return -1;
+	return thid;
+}
+
+/*
+	leave the current thread: resume the thread that started it, or halt
+	if it is the first one
+*/
+static void PSP_thread_leave(int32_t status,int32_t exitstatus,char *why)
+{
+PSP_ThreadFrame *f;
+	threads[currentthread].status=status;
+	threads[currentthread].exitstatus=exitstatus;
+
+	if(numthreadframes==0)
+	{
+		if(status!=PSP_THREAD_STOPPED)
+		{
+			fatal("[ psp hle: %s in thread %s, with no other thread to run ]\n",
+				why,threads[currentthread].name);
+		}
+		PSP_syscall_halt(exitstatus);
+		return;
+	}
+
+	debug("(%s, back to %s) ",why,threads[threadframes[numthreadframes-1].thid].name);
+	f=&threadframes[--numthreadframes];
+	memcpy(hle_cpu->cd.mips.gpr,f->gpr,sizeof(f->gpr));
+	hle_cpu->cd.mips.hi=f->hi;
+	hle_cpu->cd.mips.lo=f->lo;
+	currentthread=f->thid;
+	threads[currentthread].status=PSP_THREAD_RUNNING;
 
+	HLE_RETURN_INT(0);	// what sceKernelStartThread returns
+	PSP_thread_jump(hle_cpu->cd.mips.gpr[MIPS_GPR_RA]);
+}
 
+//SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int initPriority, int stackSize, SceUInt attr, SceKernelThreadOptParam *option);
 void HLE_sceKernelCreateThread(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
 {
 char *name;
 	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceKernelCreateThread(Name:%s Func:%08x Priority:%08x Stacksize:%08x) ",
+		name,arg1,arg2,arg3);
+	if(numthreads==PSP_MAXTHREADS)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NO_MEMORY);
+		return;
+	}
 	threads[numthreads].name=name;
 	threads[numthreads].func=arg1;
 	threads[numthreads].prio=arg2;
 	threads[numthreads].stacksize=arg3;
-	debug("HLE_sceKernelCreateThread(Name:%s Func:%08x Priority:%08x Stacksize:%08x) ",
-		threads[numthreads].name,threads[numthreads].
-		func,threads[numthreads].prio,threads[numthreads].stacksize);
+	threads[numthreads].status=PSP_THREAD_STOPPED;	// dormant
+	threads[numthreads].exitstatus=0;
 	numthreads++;
-	HLE_RETURN_INT(numthreads-1);
-//	free(name);
+	HLE_RETURN_INT(PSP_THREAD_UID(numthreads-1));
 }
+
+//int sceKernelStartThread(SceUID thid, SceSize arglen, void *argp);
 void HLE_sceKernelStartThread(int32_t thid,int32_t args,int32_t argp)
 {
+int i=PSP_thread_index(thid);
+uint32_t sp;
 	debug("HLE_sceKernelStartThread(thid:%08x args:%08x argp:%08x) ",thid,args,argp);
-	if(thid==0)
+	if((thid==0)|(i<0))
 	{
-		hle_cpu->pc=threads[0].func;
-		hle_cpu->cd.mips.pc_last=threads[0].func;
-		hle_cpu->cd.mips.gpr[MIPS_GPR_RA]=threads[0].func;
-		hle_cpu->cd.mips.delay_jmpaddr=threads[0].func;
-	
-		hle_cpu->cd.mips.gpr[MIPS_GPR_A0]=args;
-		hle_cpu->cd.mips.gpr[MIPS_GPR_A1]=argp;
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_THID);
+		return;
 	}
-	HLE_RETURN_INT(0);
+	if((threads[i].status!=PSP_THREAD_STOPPED)|(numthreadframes==PSP_MAXFRAMES))
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NOT_DORMANT);
+		return;
+	}
+
+	threadframes[numthreadframes].thid=currentthread;
+	memcpy(threadframes[numthreadframes].gpr,hle_cpu->cd.mips.gpr,sizeof(threadframes[0].gpr));
+	threadframes[numthreadframes].hi=hle_cpu->cd.mips.hi;
+	threadframes[numthreadframes].lo=hle_cpu->cd.mips.lo;
+	numthreadframes++;
+	threads[currentthread].status=PSP_THREAD_READY;
+
+	// the arguments are copied to the top of the new thread's stack
+	sp=(hle_cpu->cd.mips.gpr[MIPS_GPR_SP]-0x100-args)&~0x3f;
+	if((args>0)&(argp!=0))
+	{
+		unsigned char *b=get_userland_buf(hle_cpu,argp,args);
+		put_userland_buf(hle_cpu,sp,b,args);
+		free(b);
+		argp=sp;
+	}
+	hle_cpu->cd.mips.gpr[MIPS_GPR_SP]=(int32_t)(sp-0x40);
+	hle_cpu->cd.mips.gpr[MIPS_GPR_RA]=PSP_THREAD_RETURN;
+
+	currentthread=i;
+	threads[i].status=PSP_THREAD_RUNNING;
+	HLE_RETURN_CALL3ARGS(threads[i].func,args,argp,0);
 }
  
+//int sceKernelExitThread(int status);
+void HLE_sceKernelExitThread(int32_t arg0)
+{
+	debug("HLE_sceKernelExitThread(status:%08x) ",arg0);
+	PSP_thread_leave(PSP_THREAD_STOPPED,arg0,"exit");
+}
+
 //int sceKernelExitDeleteThread(int status);
 void HLE_sceKernelExitDeleteThread(int32_t arg0)
 {
 	debug("HLE_sceKernelExitDeleteThread(status:%08x) ",arg0);
+	PSP_thread_leave(PSP_THREAD_STOPPED,arg0,"exit");
+}
+
+//int sceKernelDeleteThread(SceUID thid);
+void HLE_sceKernelDeleteThread(int32_t arg0)
+{
+int i=PSP_thread_index(arg0);
+	debug("HLE_sceKernelDeleteThread(thid:%08x) ",arg0);
+	if((arg0==0)|(i<0))
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_THID);
+		return;
+	}
+	threads[i].status=PSP_THREAD_KILLED;
+	HLE_RETURN_INT(0);
+}
+
+//SceUID sceKernelGetThreadId(void);
+void HLE_sceKernelGetThreadId(void)
+{
+	debug("HLE_sceKernelGetThreadId() ");
+	HLE_RETURN_INT(PSP_THREAD_UID(currentthread));
+}
+
+//int sceKernelSleepThread(void);
+void HLE_sceKernelSleepThread(void)
+{
+	debug("HLE_sceKernelSleepThread() ");
+	PSP_thread_leave(PSP_THREAD_WAITING,0,"sleep");
+}
+
+//int sceKernelWakeupThread(SceUID thid);
+void HLE_sceKernelWakeupThread(int32_t arg0)
+{
+	debug("HLE_sceKernelWakeupThread(thid:%08x) ",arg0);
+	HLE_RETURN_INT((PSP_thread_index(arg0)<0)?SCE_KERNEL_ERROR_UNKNOWN_THID:0);
+}
+
+//int sceKernelWaitThreadEnd(SceUID thid, SceUInt *timeout);
+void HLE_sceKernelWaitThreadEnd(int32_t arg0,int32_t arg1)
+{
+int i=PSP_thread_index(arg0);
+	debug("HLE_sceKernelWaitThreadEnd(thid:%08x timeout:%08x) ",arg0,arg1);
+	if(i<0)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_THID);
+		return;
+	}
+	// a started thread has either ended or will never run again
+	HLE_RETURN_INT(threads[i].exitstatus);
+}
+
+//int sceKernelDelayThread(SceUInt delay);
+void HLE_sceKernelDelayThread(int32_t arg0)
+{
+	debug("HLE_sceKernelDelayThread(delay:%d) ",arg0);
 	HLE_RETURN_INT(0);
 }
 
@@ -83,5 +408,337 @@ void HLE_sceKernelGetThreadmanIdList(int32_t arg0,int32_t arg1,int32_t arg2,int3
 	debug("HLE_sceKernelGetThreadmanIdList(SceKernelIdListType:%08x readbuf:%08x readbufsize:%08x idcount:%08x) ",
 		arg0,arg1,arg2,arg3);
 	HLE_RETURN_INT(0);
-//	free(name);
+}
+
+/**
+	callbacks, they are never called, as nothing here sleeps with callbacks
+*/
+
+//int sceKernelCreateCallback(const char *name, SceKernelCallbackFunction func, void *arg);
+void HLE_sceKernelCreateCallback(int32_t arg0,int32_t arg1,int32_t arg2)
+{
+char *name;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceKernelCreateCallback(Name:%s Func:%08x Arg:%08x) ",name,arg1,arg2);
+	if(numcallbacks==PSP_MAXCALLBACKS)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NO_MEMORY);
+		return;
+	}
+	callbacks[numcallbacks].name=name;
+	callbacks[numcallbacks].func=arg1;
+	callbacks[numcallbacks].arg=arg2;
+	numcallbacks++;
+	HLE_RETURN_INT(PSP_CALLBACK_UID(numcallbacks-1));
+}
+void HLE_sceKernelDeleteCallback(int32_t arg0)
+{
+	debug("HLE_sceKernelDeleteCallback(cb:%08x) ",arg0);
+	HLE_RETURN_INT(0);
+}
+void HLE_sceKernelCheckCallback(void)
+{
+	debug("HLE_sceKernelCheckCallback() ");
+	HLE_RETURN_INT(0);
+}
+
+/**
+	semaphores
+*/
+
+static PSP_Sema *PSP_sema(int32_t semid)
+{
+	semid-=PSP_SEMA_UID(0);
+	if((semid<0)|(semid>=numsemas)) return NULL;
+	if(semas[semid].name==NULL) return NULL;	// deleted
+	return &semas[semid];
+}
+
+//SceUID sceKernelCreateSema(const char *name, SceUInt attr, int initVal, int maxVal, SceKernelSemaOptParam *option);
+void HLE_sceKernelCreateSema(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4)
+{
+char *name;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceKernelCreateSema(Name:%s attr:%08x init:%d max:%d) ",name,arg1,arg2,arg3);
+	if(numsemas==PSP_MAXSEMAS)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NO_MEMORY);
+		return;
+	}
+	semas[numsemas].name=name;
+	semas[numsemas].init=arg2;
+	semas[numsemas].count=arg2;
+	semas[numsemas].max=arg3;
+	numsemas++;
+	HLE_RETURN_INT(PSP_SEMA_UID(numsemas-1));
+}
+//int sceKernelDeleteSema(SceUID semaid);
+void HLE_sceKernelDeleteSema(int32_t arg0)
+{
+PSP_Sema *s=PSP_sema(arg0);
+	debug("HLE_sceKernelDeleteSema(semid:%08x) ",arg0);
+	if(s==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_SEMID);
+		return;
+	}
+	free(s->name);
+	s->name=NULL;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelSignalSema(SceUID semaid, int signal);
+void HLE_sceKernelSignalSema(int32_t arg0,int32_t arg1)
+{
+PSP_Sema *s=PSP_sema(arg0);
+	debug("HLE_sceKernelSignalSema(semid:%08x signal:%d) ",arg0,arg1);
+	if(s==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_SEMID);
+		return;
+	}
+	if(s->count+arg1>s->max)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_SEMA_OVF);
+		return;
+	}
+	s->count+=arg1;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelWaitSema(SceUID semaid, int signal, SceUInt *timeout);
+void HLE_sceKernelWaitSema(int32_t arg0,int32_t arg1,int32_t arg2)
+{
+PSP_Sema *s=PSP_sema(arg0);
+	debug("HLE_sceKernelWaitSema(semid:%08x signal:%d timeout:%08x) ",arg0,arg1,arg2);
+	if(s==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_SEMID);
+		return;
+	}
+	if(s->count>=arg1)
+	{
+		s->count-=arg1;
+		HLE_RETURN_INT(0);
+		return;
+	}
+	// nobody else can signal it
+	if(arg2!=0)
+	{
+		store_32bit_word(hle_cpu, arg2, 0);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_WAIT_TIMEOUT);
+		return;
+	}
+	PSP_thread_leave(PSP_THREAD_WAITING,0,"semaphore wait");
+}
+//int sceKernelPollSema(SceUID semaid, int signal);
+void HLE_sceKernelPollSema(int32_t arg0,int32_t arg1)
+{
+PSP_Sema *s=PSP_sema(arg0);
+	debug("HLE_sceKernelPollSema(semid:%08x signal:%d) ",arg0,arg1);
+	if(s==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_SEMID);
+		return;
+	}
+	if(s->count<arg1)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_SEMA_ZERO);
+		return;
+	}
+	s->count-=arg1;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelReferSemaStatus(SceUID semaid, SceKernelSemaInfo *info);
+void HLE_sceKernelReferSemaStatus(int32_t arg0,int32_t arg1)
+{
+PSP_Sema *s=PSP_sema(arg0);
+unsigned char name[32];
+	debug("HLE_sceKernelReferSemaStatus(semid:%08x info:%08x) ",arg0,arg1);
+	if(s==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_SEMID);
+		return;
+	}
+	memset(name,0,sizeof(name));
+	strncpy((char *)name,s->name,sizeof(name)-1);
+	store_32bit_word(hle_cpu, arg1+0x00, 0x38);	// size
+	put_userland_buf(hle_cpu, arg1+0x04, name, sizeof(name));
+	store_32bit_word(hle_cpu, arg1+0x24, 0);	// attr
+	store_32bit_word(hle_cpu, arg1+0x28, s->init);
+	store_32bit_word(hle_cpu, arg1+0x2c, s->count);
+	store_32bit_word(hle_cpu, arg1+0x30, s->max);
+	store_32bit_word(hle_cpu, arg1+0x34, 0);	// numWaitThreads
+	HLE_RETURN_INT(0);
+}
+
+/**
+	event flags
+*/
+
+enum PspEventFlagWaitTypes
+{
+	PSP_EVENT_WAITAND = 0,
+	PSP_EVENT_WAITOR  = 1,
+	PSP_EVENT_WAITCLEARALL = 0x10,
+	PSP_EVENT_WAITCLEAR = 0x20
+};
+
+static PSP_EventFlag *PSP_eventflag(int32_t evid)
+{
+	evid-=PSP_EVENTFLAG_UID(0);
+	if((evid<0)|(evid>=numeventflags)) return NULL;
+	if(eventflags[evid].name==NULL) return NULL;	// deleted
+	return &eventflags[evid];
+}
+
+/* returns 1 if the wait condition holds, and then clears as asked to */
+static int PSP_eventflag_match(PSP_EventFlag *e,uint32_t bits,int32_t wait,int32_t outbits)
+{
+int match;
+	if(wait&PSP_EVENT_WAITOR)
+		match=(e->bits&bits)!=0;
+	else
+		match=(e->bits&bits)==bits;
+	if(outbits!=0)
+		store_32bit_word(hle_cpu, outbits, e->bits);
+	if(match)
+	{
+		if(wait&PSP_EVENT_WAITCLEARALL) e->bits=0;
+		if(wait&PSP_EVENT_WAITCLEAR) e->bits&=~bits;
+	}
+	return match;
+}
+
+//SceUID sceKernelCreateEventFlag(const char *name, int attr, int bits, SceKernelEventFlagOptParam *opt);
+void HLE_sceKernelCreateEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
+{
+char *name;
+	name=get_userland_string(hle_cpu, arg0);
+	debug("HLE_sceKernelCreateEventFlag(Name:%s attr:%08x bits:%08x) ",name,arg1,arg2);
+	if(numeventflags==PSP_MAXEVENTFLAGS)
+	{
+		free(name);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_NO_MEMORY);
+		return;
+	}
+	eventflags[numeventflags].name=name;
+	eventflags[numeventflags].bits=arg2;
+	numeventflags++;
+	HLE_RETURN_INT(PSP_EVENTFLAG_UID(numeventflags-1));
+}
+//int sceKernelDeleteEventFlag(int evid);
+void HLE_sceKernelDeleteEventFlag(int32_t arg0)
+{
+PSP_EventFlag *e=PSP_eventflag(arg0);
+	debug("HLE_sceKernelDeleteEventFlag(evid:%08x) ",arg0);
+	if(e==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_EVFID);
+		return;
+	}
+	free(e->name);
+	e->name=NULL;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelSetEventFlag(SceUID evid, u32 bits);
+void HLE_sceKernelSetEventFlag(int32_t arg0,int32_t arg1)
+{
+PSP_EventFlag *e=PSP_eventflag(arg0);
+	debug("HLE_sceKernelSetEventFlag(evid:%08x bits:%08x) ",arg0,arg1);
+	if(e==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_EVFID);
+		return;
+	}
+	e->bits|=arg1;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelClearEventFlag(SceUID evid, u32 bits);
+// (clears the bits that are NOT set in bits)
+void HLE_sceKernelClearEventFlag(int32_t arg0,int32_t arg1)
+{
+PSP_EventFlag *e=PSP_eventflag(arg0);
+	debug("HLE_sceKernelClearEventFlag(evid:%08x bits:%08x) ",arg0,arg1);
+	if(e==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_EVFID);
+		return;
+	}
+	e->bits&=arg1;
+	HLE_RETURN_INT(0);
+}
+//int sceKernelWaitEventFlag(int evid, u32 bits, u32 wait, u32 *outBits, SceUInt *timeout);
+void HLE_sceKernelWaitEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3,int32_t arg4)
+{
+PSP_EventFlag *e=PSP_eventflag(arg0);
+	debug("HLE_sceKernelWaitEventFlag(evid:%08x bits:%08x wait:%08x outBits:%08x timeout:%08x) ",arg0,arg1,arg2,arg3,arg4);
+	if(e==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_EVFID);
+		return;
+	}
+	if(arg1==0)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_EVF_ILPAT);
+		return;
+	}
+	if(PSP_eventflag_match(e,arg1,arg2,arg3))
+	{
+		HLE_RETURN_INT(0);
+		return;
+	}
+	// nobody else can set it
+	if(arg4!=0)
+	{
+		store_32bit_word(hle_cpu, arg4, 0);
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_WAIT_TIMEOUT);
+		return;
+	}
+	PSP_thread_leave(PSP_THREAD_WAITING,0,"event flag wait");
+}
+//int sceKernelPollEventFlag(int evid, u32 bits, u32 wait, u32 *outBits);
+void HLE_sceKernelPollEventFlag(int32_t arg0,int32_t arg1,int32_t arg2,int32_t arg3)
+{
+PSP_EventFlag *e=PSP_eventflag(arg0);
+	debug("HLE_sceKernelPollEventFlag(evid:%08x bits:%08x wait:%08x outBits:%08x) ",arg0,arg1,arg2,arg3);
+	if(e==NULL)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_UNKNOWN_EVFID);
+		return;
+	}
+	if(arg1==0)
+	{
+		HLE_RETURN_INT(SCE_KERNEL_ERROR_EVF_ILPAT);
+		return;
+	}
+	HLE_RETURN_INT(PSP_eventflag_match(e,arg1,arg2,arg3)?0:SCE_KERNEL_ERROR_EVF_COND);
+}
+
+/**
+	system time
+*/
+
+//int sceKernelGetSystemTime(SceKernelSysClock *time);
+void HLE_sceKernelGetSystemTime(int32_t arg0)
+{
+uint64_t t=PSP_systime_usec();
+	debug("HLE_sceKernelGetSystemTime(time:%08x) ",arg0);
+	store_32bit_word(hle_cpu, arg0, (uint32_t)t);
+	store_32bit_word(hle_cpu, arg0+4, (uint32_t)(t>>32));
+	HLE_RETURN_INT(0);
+}
+//SceInt64 sceKernelGetSystemTimeWide(void);
+void HLE_sceKernelGetSystemTimeWide(void)
+{
+uint64_t t=PSP_systime_usec();
+	debug("HLE_sceKernelGetSystemTimeWide() ");
+	hle_cpu->cd.mips.gpr[MIPS_GPR_V0]=(int32_t)t;
+	hle_cpu->cd.mips.gpr[MIPS_GPR_V1]=(int32_t)(t>>32);
+}
+//SceUInt32 sceKernelGetSystemTimeLow(void);
+void HLE_sceKernelGetSystemTimeLow(void)
+{
+	debug("HLE_sceKernelGetSystemTimeLow() ");
+	HLE_RETURN_INT((uint32_t)PSP_systime_usec());
 }
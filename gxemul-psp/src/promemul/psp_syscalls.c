@@ -66,17 +66,43 @@ int32_t PSP_syscall_getargn(int32_t idx)
 	return pspsyscalls[idx-0x2000].argn;
 }
 
+/*
+	NID lookup, used when binding the import stubs of a module.
+	pspsyscalls[] is sorted by syscall index, so a second table
+	sorted by NID is built on first use and searched with bsearch()
+*/
+#define NUMSYSCALLS	(sizeof(pspsyscalls)/sizeof(PSP_Syscall))
+
+static PSP_Syscall *pspsyscalls_bynid[NUMSYSCALLS];
+static int pspsyscalls_bynid_ready=0;
+
+static int PSP_syscall_cmpnid(const void *a,const void *b)
+{
+uint32_t na=(*(PSP_Syscall **)a)->nid;
+uint32_t nb=(*(PSP_Syscall **)b)->nid;
+	return (na>nb)-(na<nb);
+}
+
 int32_t PSP_findsyscall_bynid(int32_t nid)
 {
+PSP_Syscall key,*keyp=&key,**found;
 int i;
-	for(i=0;i<(sizeof(pspsyscalls)/sizeof(PSP_Syscall));i++)
+	if(!pspsyscalls_bynid_ready)
 	{
-		if(nid==pspsyscalls[i].nid)
+		for(i=0;i<NUMSYSCALLS;i++)
 		{
-			return pspsyscalls[i].idx;
+			pspsyscalls_bynid[i]=&pspsyscalls[i];
 		}
+		qsort(pspsyscalls_bynid,NUMSYSCALLS,sizeof(PSP_Syscall *),PSP_syscall_cmpnid);
+		pspsyscalls_bynid_ready=1;
 	}
-	return 0;
+	key.nid=nid;
+	found=bsearch(&keyp,pspsyscalls_bynid,NUMSYSCALLS,sizeof(PSP_Syscall *),PSP_syscall_cmpnid);
+	if(found==NULL)
+	{
+		return 0;
+	}
+	return (*found)->idx;
 }
 int32_t PSP_findsyscall_byname(char *s)
 {
@@ -91,6 +117,51 @@ int i;
 	return 0;
 }
 
+/*
+	stop emulation, used by sceKernelExitGame and friends
+	an ME running in lockstep (not on its own host thread) is stopped
+	too, the machine doesn't count cycles without cpu0 so it would
+	never halt otherwise
+	the status becomes the emulator's exit code
+*/
+int32_t hle_exit_status=0;
+
+void PSP_syscall_halt(int32_t status)
+{
+struct machine *machine=hle_cpu->machine;
+int i;
+	debug("HLE: halting (status:%08x) ",status);
+	hle_exit_status=status;
+	machine->exit_status=status;
+	hle_cpu->running=0;
+	if(!machine->threaded_cpus)
+	{
+		for(i=0;i<machine->ncpus;i++)
+			machine->cpus[i]->running=0;
+	}
+}
+
+static void PSP_syscall_snapshot(struct snapshot *s,void *extra)
+{
+	SNAPSHOT_VAR(s,hle_exit_status);
+}
+
+/*
+	register the HLE state for snapshots (see snapshot.c), everything
+	else in the HLE is set up again from the program on each run
+*/
+void PSP_snapshot_setup(struct machine *machine)
+{
+	snapshot_register(machine,"hle_syscalls",PSP_syscall_snapshot,NULL);
+	snapshot_register(machine,"hle_threadman",PSP_thread_snapshot,NULL);
+	snapshot_register(machine,"hle_memory",PSP_mem_snapshot,NULL);
+	snapshot_register(machine,"hle_modules",PSP_module_snapshot,NULL);
+	snapshot_register(machine,"hle_io",PSP_io_snapshot,NULL);
+	snapshot_register(machine,"hle_ctrl",PSP_ctrl_snapshot,NULL);
+	snapshot_register(machine,"hle_display",PSP_display_snapshot,NULL);
+	snapshot_register(machine,"hle_ge",PSP_ge_snapshot,NULL);
+}
+
 void PSP_syscall_hle(int32_t idx)
 {
 
@@ -102,7 +173,7 @@ void PSP_syscall_hle(int32_t idx)
 //	debug("HLE PC:%08x (syscall %04x) ",hle_cpu->pc,idx);
 	debug("HLE RA:%08x (syscall %04x) ",hle_cpu->cd.mips.gpr[MIPS_GPR_RA],idx);
 
-	if((idx>=0x2000)&(idx<(0x2000+(sizeof(pspsyscalls)/sizeof(PSP_Syscall)))))
+	if((idx>=0x2000)&(idx<(0x2000+NUMSYSCALLS)))
 	{
 
 		hle_numargs=pspsyscalls[idx-0x2000].argn;
@@ -230,6 +301,9 @@ void useremul__psp_setup(struct cpu *cpu, int argc, char **host_argv)
 	add_symbol_name(&cpu->machine->symbol_context,func_stackframe,func_stacksize, "func_stackframe", 0, 0);
 	add_symbol_name(&cpu->machine->symbol_context,thread_stackframe,thread_stacksize, "thread_stackframe", 0, 0);
 
+	PSP_thread_setup(cpu);
+
+	PSP_snapshot_setup(cpu->machine);
 	hookemul__psp_registerhooksymbols(cpu);
 	hookemul__psp_setup(cpu);
 
@@ -383,6 +457,7 @@ void useremul__psp_loadexecpayload_setup(struct cpu *cpu, int argc, char **host_
 	add_symbol_name(&cpu->machine->symbol_context,func_stackframe,func_stacksize, "func_stackframe", 0, 0);
 	add_symbol_name(&cpu->machine->symbol_context,thread_stackframe,thread_stacksize, "thread_stackframe", 0, 0);
 
+	PSP_snapshot_setup(cpu->machine);
 	hookemul__psp_registerhooksymbols(cpu);
 	hookemul__psp_setup(cpu);
 /*
@@ -462,6 +537,7 @@ void useremul__psp_iplbootstrap_setup(struct cpu *cpu, int argc, char **host_arg
 	add_symbol_name(&cpu->machine->symbol_context,func_stackframe,func_stacksize, "func_stackframe", 0, 0);
 	add_symbol_name(&cpu->machine->symbol_context,thread_stackframe,thread_stacksize, "thread_stackframe", 0, 0);
 
+	PSP_snapshot_setup(cpu->machine);
 	hookemul__psp_registerhooksymbols(cpu);
 	hookemul__psp_setup(cpu);
 
@@ -0,0 +1,966 @@
+/*
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Machine snapshots, and record/replay of external events.
+ *
+ *  A snapshot file is a header followed by any number of records. Each
+ *  record is a list of chunks: pages of RAM (or of a region registered
+ *  with snapshot_register_memory(), such as VRAM), and the state of the
+ *  machine, of each CPU, and of everything registered with
+ *  snapshot_register(). A record ends with an END chunk, so a record
+ *  that was cut short (the emulator crashing while writing it) is
+ *  simply ignored.
+ *
+ *  The first record written to a file is a full one, containing every
+ *  page which isn't all zeroes. A copy of everything written is kept
+ *  in memory (the "shadow"), and later records written to the same file
+ *  only contain the 4 KB pages which differ from it. Comparing 32 MB of
+ *  RAM is a few milliseconds of work, so a checkpoint every few seconds
+ *  (-k) costs very little, both in time and in file size.
+ *
+ *  Restoring record n clears RAM and the registered regions, applies the
+ *  pages of the last full record at or before n and of every record
+ *  after it up to n, and then the state chunks of record n only.
+ *
+ *  The file contents are in host byte order and use host struct layouts,
+ *  so a snapshot can only be restored by the same binary on the same
+ *  host type.
+ *
+ *  Record/replay: everything the emulated machine can see which does not
+ *  come from the machine itself (host time, controller input) goes
+ *  through replay_event(). With -L, each such value is appended to a log,
+ *  and with -l, the values are read back from the log instead, so that a
+ *  run can be repeated exactly, also after restoring a snapshot (the log
+ *  position is part of the snapshot).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "cpu.h"
+#include "machine.h"
+#include "memory.h"
+#include "misc.h"
+#include "snapshot.h"
+
+
+#define	SNAPSHOT_MAGIC		"GXSNAP\0\1"
+#define	SNAPSHOT_PAGESIZE	4096
+
+#define	SNAPSHOT_CHUNK_RECORD	1	/*  offset = nr, region = full  */
+#define	SNAPSHOT_CHUNK_PAGE	2	/*  region 0 = RAM, 1.. = regions  */
+#define	SNAPSHOT_CHUNK_STATE	3	/*  data = name + '\0' + state  */
+#define	SNAPSHOT_CHUNK_END	4
+
+struct snapshot_header {
+	char		magic[8];
+	uint32_t	pagesize;
+	uint32_t	ncpus;
+	uint64_t	ram_start;
+	uint64_t	ram_len;
+};
+
+struct snapshot_chunk {
+	uint32_t	type;
+	uint32_t	region;
+	uint64_t	offset;
+	uint64_t	len;
+};
+
+struct snapshot {
+	struct machine	*machine;
+	int		restoring;
+	int		error;
+
+	unsigned char	*buf;
+	size_t		len;
+	size_t		size;
+	size_t		pos;
+};
+
+/*  What the last record written to a file contained:  */
+struct snapshot_shadow {
+	char		*filename;
+	int		n_records;
+	unsigned char	**ram;		/*  one per memblock, or NULL  */
+	unsigned char	*region[MAX_SNAPSHOT_REGIONS];
+};
+
+#define	N_MEMBLOCKS		(1 << BITS_PER_PAGETABLE)
+#define	MEMBLOCK_SIZE		(1 << BITS_PER_MEMBLOCK)
+
+#define	REPLAY_MAGIC		"GXREPLAY"
+
+struct replay_record {
+	int64_t		ncycles;
+	uint32_t	type;
+	uint32_t	pad;
+	uint64_t	value;
+};
+
+struct replay_log {
+	FILE		*f;
+	int64_t		n_events;
+	int		diverged;
+};
+
+
+static unsigned char zero_page[SNAPSHOT_PAGESIZE];
+
+
+/*
+ *  snapshot_restoring():
+ *
+ *  Returns non-zero if the handler is being called to restore its state.
+ */
+int snapshot_restoring(struct snapshot *s)
+{
+	return s->restoring;
+}
+
+
+/*
+ *  snapshot_data():
+ *
+ *  Save len bytes at p, or restore them. A handler which asks for more
+ *  data than it saved gets zeroes, and the restore is reported as failed.
+ */
+void snapshot_data(struct snapshot *s, void *p, size_t len)
+{
+	if (s->restoring) {
+		if (s->pos + len > s->len) {
+			s->error = 1;
+			memset(p, 0, len);
+			return;
+		}
+		memcpy(p, s->buf + s->pos, len);
+		s->pos += len;
+		return;
+	}
+
+	if (s->len + len > s->size) {
+		while (s->len + len > s->size)
+			s->size = s->size? s->size * 2 : 4096;
+		s->buf = realloc(s->buf, s->size);
+		if (s->buf == NULL) {
+			fprintf(stderr, "out of memory in snapshot_data()\n");
+			exit(1);
+		}
+	}
+	memcpy(s->buf + s->len, p, len);
+	s->len += len;
+}
+
+
+/*
+ *  snapshot_string():
+ *
+ *  Save or restore a string, which may be NULL. When restoring, the old
+ *  string (which must be NULL or malloc()ed) is freed.
+ */
+void snapshot_string(struct snapshot *s, char **strp)
+{
+	uint32_t len = 0xffffffff;
+
+	if (!s->restoring) {
+		if (*strp != NULL)
+			len = strlen(*strp);
+		SNAPSHOT_VAR(s, len);
+		if (*strp != NULL)
+			snapshot_data(s, *strp, len);
+		return;
+	}
+
+	SNAPSHOT_VAR(s, len);
+	free(*strp);
+	*strp = NULL;
+	if (len == 0xffffffff || s->error)
+		return;
+	if (s->pos + len > s->len) {
+		s->error = 1;
+		return;
+	}
+	*strp = malloc(len + 1);
+	if (*strp == NULL) {
+		fprintf(stderr, "out of memory in snapshot_string()\n");
+		exit(1);
+	}
+	snapshot_data(s, *strp, len);
+	(*strp)[len] = '\0';
+}
+
+
+/*
+ *  snapshot_register():
+ *
+ *  Register a function which saves and restores some state. name is used
+ *  to find the state again in a snapshot, so it must be unique within the
+ *  machine.
+ */
+void snapshot_register(struct machine *machine, char *name,
+	void (*func)(struct snapshot *, void *), void *extra)
+{
+	int n = machine->n_snapshot_entries;
+
+	if (n >= MAX_SNAPSHOT_ENTRIES) {
+		fprintf(stderr, "snapshot_register(): too many entries\n");
+		exit(1);
+	}
+
+	machine->snapshot_name[n] = name;
+	machine->snapshot_func[n] = func;
+	machine->snapshot_extra[n] = extra;
+	machine->n_snapshot_entries ++;
+}
+
+
+/*
+ *  snapshot_register_memory():
+ *
+ *  Register memory which is not RAM, but should be saved page by page
+ *  like RAM (for example a framebuffer).
+ */
+void snapshot_register_memory(struct machine *machine, char *name,
+	unsigned char *data, size_t len)
+{
+	int n = machine->n_snapshot_regions;
+
+	if (n >= MAX_SNAPSHOT_REGIONS) {
+		fprintf(stderr, "snapshot_register_memory(): too many "
+		    "regions\n");
+		exit(1);
+	}
+
+	machine->snapshot_region_name[n] = name;
+	machine->snapshot_region_data[n] = data;
+	machine->snapshot_region_len[n] = len;
+	machine->n_snapshot_regions ++;
+}
+
+
+/*
+ *  snapshot_machine():
+ *
+ *  The machine's own state: the cycle counter, the hardware tick
+ *  counters, and the position in the replay log.
+ */
+static void snapshot_machine(struct snapshot *s, void *extra)
+{
+	struct machine *machine = extra;
+	int64_t n_events = 0;
+	int n = machine->n_tick_entries;
+
+	SNAPSHOT_VAR(s, machine->ncycles);
+	SNAPSHOT_VAR(s, n);
+	if (n != machine->n_tick_entries) {
+		s->error = 1;
+		return;
+	}
+	snapshot_data(s, machine->ticks_till_next, n * sizeof(int));
+
+	if (machine->replay_log != NULL)
+		n_events = machine->replay_log->n_events;
+	SNAPSHOT_VAR(s, n_events);
+
+	if (!s->restoring)
+		return;
+
+	machine->ncycles_show = machine->ncycles_flush = machine->ncycles;
+
+	if (machine->replay_log != NULL) {
+		struct replay_log *log = machine->replay_log;
+		off_t ofs = strlen(REPLAY_MAGIC) +
+		    n_events * sizeof(struct replay_record);
+
+		/*  Recording continues from here, replacing the rest:  */
+		fflush(log->f);
+		if (machine->replay_mode == REPLAY_RECORD &&
+		    ftruncate(fileno(log->f), ofs) != 0)
+			perror("ftruncate");
+		fseeko(log->f, ofs, SEEK_SET);
+		log->n_events = n_events;
+		log->diverged = 0;
+	}
+}
+
+
+/*
+ *  snapshot_cpu():
+ *
+ *  Generic CPU state, and the CPU family's. Everything translated or
+ *  cached by the CPU is thrown away on restore.
+ */
+static void snapshot_cpu(struct snapshot *s, void *extra)
+{
+	struct cpu *cpu = extra;
+	struct cpu_family *fp = cpu->machine->cpu_family;
+
+	SNAPSHOT_VAR(s, cpu->pc);
+	SNAPSHOT_VAR(s, cpu->running);
+	SNAPSHOT_VAR(s, cpu->dead);
+
+	if (fp == NULL || fp->snapshot == NULL) {
+		fatal("snapshot_cpu(): no snapshot support for this cpu\n");
+		s->error = 1;
+		return;
+	}
+	fp->snapshot(cpu, s);
+
+	if (!s->restoring)
+		return;
+
+	if (cpu->translation_cache != NULL)
+		cpu_create_or_reset_tc(cpu);
+	if (cpu->invalidate_translation_caches != NULL)
+		cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
+}
+
+
+/*****************************************************************************/
+
+
+static int snapshot_write_chunk(FILE *f, int type, int region,
+	uint64_t offset, void *data, uint64_t len)
+{
+	struct snapshot_chunk c;
+
+	memset(&c, 0, sizeof(c));
+	c.type = type;
+	c.region = region;
+	c.offset = offset;
+	c.len = len;
+	if (fwrite(&c, sizeof(c), 1, f) != 1)
+		return 0;
+	if (len > 0 && fwrite(data, len, 1, f) != 1)
+		return 0;
+	return 1;
+}
+
+
+/*
+ *  snapshot_write_pages():
+ *
+ *  Write the pages of len bytes at data which differ from the shadow
+ *  copy, and update the shadow copy.
+ */
+static int snapshot_write_pages(FILE *f, int region, uint64_t base,
+	unsigned char *data, unsigned char *shadow, size_t len, int64_t *n)
+{
+	size_t ofs, plen;
+
+	for (ofs = 0; ofs < len; ofs += SNAPSHOT_PAGESIZE) {
+		plen = len - ofs;
+		if (plen > SNAPSHOT_PAGESIZE)
+			plen = SNAPSHOT_PAGESIZE;
+
+		if (memcmp(data + ofs, shadow != NULL? shadow + ofs :
+		    zero_page, plen) == 0)
+			continue;
+
+		if (!snapshot_write_chunk(f, SNAPSHOT_CHUNK_PAGE, region,
+		    base + ofs, data + ofs, plen))
+			return 0;
+		if (shadow != NULL)
+			memcpy(shadow + ofs, data + ofs, plen);
+		(*n) ++;
+	}
+
+	return 1;
+}
+
+
+static int snapshot_write_state(FILE *f, struct machine *machine, char *name,
+	void (*func)(struct snapshot *, void *), void *extra)
+{
+	struct snapshot s;
+	size_t namelen = strlen(name) + 1;
+	int res;
+
+	memset(&s, 0, sizeof(s));
+	s.machine = machine;
+	snapshot_data(&s, name, namelen);
+	func(&s, extra);
+
+	res = snapshot_write_chunk(f, SNAPSHOT_CHUNK_STATE, 0, 0,
+	    s.buf, s.len);
+	free(s.buf);
+	return res;
+}
+
+
+/*
+ *  snapshot_index():
+ *
+ *  Find the complete records in a snapshot file. Returns the number of
+ *  records, with their file offsets and full flags in *offsetsp and
+ *  *fullp (to be freed by the caller), or -1 if this is not a snapshot
+ *  file for this machine.
+ */
+static int snapshot_index(FILE *f, struct machine *machine,
+	off_t **offsetsp, int **fullp)
+{
+	struct snapshot_header h;
+	struct snapshot_chunk c;
+	off_t *offsets = NULL, rec_ofs = 0;
+	int *full = NULL, n = 0, rec_full = 0, in_record = 0;
+
+	fseeko(f, 0, SEEK_SET);
+	if (fread(&h, sizeof(h), 1, f) != 1 ||
+	    memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) != 0 ||
+	    h.pagesize != SNAPSHOT_PAGESIZE ||
+	    h.ncpus != (uint32_t)machine->ncpus ||
+	    h.ram_len != (uint64_t)machine->physical_ram_in_mb << 20)
+		return -1;
+
+	for (;;) {
+		off_t ofs = ftello(f);
+		if (fread(&c, sizeof(c), 1, f) != 1)
+			break;
+		switch (c.type) {
+		case SNAPSHOT_CHUNK_RECORD:
+			in_record = 1;
+			rec_ofs = ofs;
+			rec_full = c.region;
+			break;
+		case SNAPSHOT_CHUNK_END:
+			if (!in_record)
+				break;
+			offsets = realloc(offsets, (n+1) * sizeof(off_t));
+			full = realloc(full, (n+1) * sizeof(int));
+			if (offsets == NULL || full == NULL) {
+				fprintf(stderr, "out of memory in "
+				    "snapshot_index()\n");
+				exit(1);
+			}
+			offsets[n] = rec_ofs;
+			full[n] = rec_full;
+			n ++;
+			in_record = 0;
+			break;
+		}
+		if (fseeko(f, c.len, SEEK_CUR) != 0)
+			break;
+	}
+
+	*offsetsp = offsets;
+	*fullp = full;
+	return n;
+}
+
+
+static void snapshot_free_shadow(struct machine *machine)
+{
+	struct snapshot_shadow *sh = machine->snapshot_shadow;
+	int i;
+
+	if (sh == NULL)
+		return;
+
+	for (i=0; i<N_MEMBLOCKS; i++)
+		if (sh->ram[i] != NULL)
+			munmap(sh->ram[i], MEMBLOCK_SIZE);
+	munmap(sh->ram, N_MEMBLOCKS * sizeof(unsigned char *));
+	for (i=0; i<MAX_SNAPSHOT_REGIONS; i++)
+		if (sh->region[i] != NULL)
+			munmap(sh->region[i],
+			    machine->snapshot_region_len[i]);
+	free(sh->filename);
+	free(sh);
+	machine->snapshot_shadow = NULL;
+}
+
+
+/*
+ *  snapshot_save():
+ *
+ *  Append a record to a snapshot file. Returns the record number, or -1
+ *  on failure.
+ */
+int snapshot_save(struct machine *machine, char *filename)
+{
+	struct snapshot_shadow *sh = machine->snapshot_shadow;
+	struct memory *mem = machine->memory;
+	void **table = mem->pagetable;
+	struct timeval t0, t1;
+	int64_t npages = 0;
+	int i, nr, full = 0, ok = 1;
+	FILE *f;
+
+	if (machine->cpu_threads != NULL) {
+		fatal("snapshot_save(): not possible while CPUs are running "
+		    "on their own host threads\n");
+		return -1;
+	}
+
+	gettimeofday(&t0, NULL);
+
+	if (sh == NULL || strcmp(sh->filename, filename) != 0) {
+		off_t *offsets;
+		int *fulls;
+
+		snapshot_free_shadow(machine);
+
+		f = fopen(filename, "r+b");
+		if (f == NULL) {
+			struct snapshot_header h;
+
+			f = fopen(filename, "w+b");
+			if (f == NULL) {
+				perror(filename);
+				return -1;
+			}
+			memset(&h, 0, sizeof(h));
+			memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+			h.pagesize = SNAPSHOT_PAGESIZE;
+			h.ncpus = machine->ncpus;
+			h.ram_start = (uint64_t)machine->memory_offset_in_mb
+			    << 20;
+			h.ram_len = (uint64_t)machine->physical_ram_in_mb
+			    << 20;
+			fwrite(&h, sizeof(h), 1, f);
+			nr = 0;
+		} else {
+			nr = snapshot_index(f, machine, &offsets, &fulls);
+			if (nr < 0) {
+				fatal("snapshot_save(): %s is not a snapshot"
+				    " of this machine\n", filename);
+				fclose(f);
+				return -1;
+			}
+			free(offsets);
+			free(fulls);
+		}
+		fclose(f);
+
+		sh = malloc(sizeof(struct snapshot_shadow));
+		if (sh == NULL) {
+			fprintf(stderr, "out of memory in snapshot_save()\n");
+			exit(1);
+		}
+		memset(sh, 0, sizeof(struct snapshot_shadow));
+		sh->filename = strdup(filename);
+		sh->n_records = nr;
+		sh->ram = zeroed_alloc(N_MEMBLOCKS * sizeof(unsigned char *));
+		for (i=0; i<machine->n_snapshot_regions; i++)
+			sh->region[i] = zeroed_alloc(
+			    machine->snapshot_region_len[i]);
+		machine->snapshot_shadow = sh;
+		full = 1;
+	}
+
+	f = fopen(filename, "ab");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	nr = sh->n_records;
+	ok &= snapshot_write_chunk(f, SNAPSHOT_CHUNK_RECORD, full, nr,
+	    NULL, 0);
+
+	/*  RAM, one memblock at a time:  */
+	for (i=0; i<N_MEMBLOCKS && ok; i++) {
+		if (table[i] == NULL)
+			continue;
+		if (sh->ram[i] == NULL)
+			sh->ram[i] = zeroed_alloc(MEMBLOCK_SIZE);
+		ok &= snapshot_write_pages(f, 0,
+		    (uint64_t)i << BITS_PER_MEMBLOCK, table[i], sh->ram[i],
+		    MEMBLOCK_SIZE, &npages);
+	}
+
+	for (i=0; i<machine->n_snapshot_regions && ok; i++)
+		ok &= snapshot_write_pages(f, i + 1, 0,
+		    machine->snapshot_region_data[i], sh->region[i],
+		    machine->snapshot_region_len[i], &npages);
+
+	if (ok)
+		ok &= snapshot_write_state(f, machine, "machine",
+		    snapshot_machine, machine);
+
+	for (i=0; i<machine->ncpus && ok; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "cpu%i", i);
+		ok &= snapshot_write_state(f, machine, name,
+		    snapshot_cpu, machine->cpus[i]);
+	}
+
+	for (i=0; i<machine->n_snapshot_entries && ok; i++)
+		ok &= snapshot_write_state(f, machine,
+		    machine->snapshot_name[i], machine->snapshot_func[i],
+		    machine->snapshot_extra[i]);
+
+	if (ok)
+		ok &= snapshot_write_chunk(f, SNAPSHOT_CHUNK_END, 0, 0,
+		    NULL, 0);
+
+	if (fclose(f) != 0)
+		ok = 0;
+
+	if (!ok) {
+		/*  The shadow no longer matches the file:  */
+		perror(filename);
+		snapshot_free_shadow(machine);
+		return -1;
+	}
+
+	sh->n_records ++;
+
+	gettimeofday(&t1, NULL);
+	debug("[ snapshot %i (%s) written to %s: %lli pages, %i ms ]\n",
+	    nr, full? "full" : "incremental", filename, (long long)npages,
+	    (int)((t1.tv_sec - t0.tv_sec) * 1000 +
+	    (t1.tv_usec - t0.tv_usec) / 1000));
+
+	return nr;
+}
+
+
+/*
+ *  snapshot_restore_state():
+ *
+ *  Hand a state chunk to whoever saved it.
+ */
+static int snapshot_restore_state(struct machine *machine,
+	unsigned char *buf, size_t len)
+{
+	struct snapshot s;
+	char *name = (char *) buf;
+	size_t namelen = strnlen(name, len) + 1;
+	int i;
+
+	if (namelen > len)
+		return 0;
+
+	memset(&s, 0, sizeof(s));
+	s.machine = machine;
+	s.restoring = 1;
+	s.buf = buf;
+	s.len = len;
+	s.pos = namelen;
+
+	if (strcmp(name, "machine") == 0) {
+		snapshot_machine(&s, machine);
+		return !s.error;
+	}
+
+	for (i=0; i<machine->ncpus; i++) {
+		char cpuname[16];
+		snprintf(cpuname, sizeof(cpuname), "cpu%i", i);
+		if (strcmp(name, cpuname) == 0) {
+			snapshot_cpu(&s, machine->cpus[i]);
+			return !s.error;
+		}
+	}
+
+	for (i=0; i<machine->n_snapshot_entries; i++)
+		if (strcmp(name, machine->snapshot_name[i]) == 0) {
+			machine->snapshot_func[i](&s,
+			    machine->snapshot_extra[i]);
+			if (s.error || s.pos != s.len) {
+				fatal("snapshot_restore(): bad state for "
+				    "'%s'\n", name);
+				return 0;
+			}
+			return 1;
+		}
+
+	fatal("snapshot_restore(): unknown state '%s' ignored\n", name);
+	return 1;
+}
+
+
+/*
+ *  snapshot_restore():
+ *
+ *  Restore record nr from a snapshot file, or the last record if nr is
+ *  negative. Returns the record number, or -1 on failure (in which case
+ *  the machine may be left half restored, if the file was damaged).
+ */
+int snapshot_restore(struct machine *machine, char *filename, int nr)
+{
+	struct memory *mem = machine->memory;
+	void **table = mem->pagetable;
+	struct snapshot_chunk c;
+	off_t *offsets;
+	int *fulls, n, i, base, r, ok = 1;
+	unsigned char *buf = NULL;
+	FILE *f;
+
+	if (machine->cpu_threads != NULL) {
+		fatal("snapshot_restore(): not possible while CPUs are "
+		    "running on their own host threads\n");
+		return -1;
+	}
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	n = snapshot_index(f, machine, &offsets, &fulls);
+	if (n < 0) {
+		fatal("snapshot_restore(): %s is not a snapshot of this "
+		    "machine\n", filename);
+		fclose(f);
+		return -1;
+	}
+	if (nr < 0)
+		nr = n - 1;
+	if (nr < 0 || nr >= n) {
+		fatal("snapshot_restore(): %s has %i snapshot(s)\n",
+		    filename, n);
+		free(offsets);
+		free(fulls);
+		fclose(f);
+		return -1;
+	}
+
+	for (base = nr; base > 0 && !fulls[base]; base --)
+		;
+
+	/*  Start from an empty machine:  */
+	for (i=0; i<N_MEMBLOCKS; i++)
+		if (table[i] != NULL)
+			memset(table[i], 0, MEMBLOCK_SIZE);
+	for (i=0; i<machine->n_snapshot_regions; i++)
+		memset(machine->snapshot_region_data[i], 0,
+		    machine->snapshot_region_len[i]);
+
+	for (r = base; r <= nr && ok; r++) {
+		fseeko(f, offsets[r], SEEK_SET);
+		while (ok && fread(&c, sizeof(c), 1, f) == 1 &&
+		    c.type != SNAPSHOT_CHUNK_END) {
+			unsigned char *p = NULL;
+
+			switch (c.type) {
+			case SNAPSHOT_CHUNK_PAGE:
+				if (c.len > SNAPSHOT_PAGESIZE) {
+					ok = 0;
+					break;
+				}
+				if (c.region == 0) {
+					p = memory_paddr_to_hostaddr(mem,
+					    c.offset, MEM_WRITE);
+					p += c.offset & (MEMBLOCK_SIZE - 1);
+				} else if (c.region <= (uint32_t)machine->
+				    n_snapshot_regions && c.offset + c.len <=
+				    machine->snapshot_region_len[c.region-1])
+					p = machine->snapshot_region_data[
+					    c.region - 1] + c.offset;
+				if (p == NULL || fread(p, c.len, 1, f) != 1)
+					ok = 0;
+				break;
+			case SNAPSHOT_CHUNK_STATE:
+				if (r != nr) {
+					fseeko(f, c.len, SEEK_CUR);
+					break;
+				}
+				buf = realloc(buf, c.len + 1);
+				if (buf == NULL) {
+					fprintf(stderr, "out of memory in "
+					    "snapshot_restore()\n");
+					exit(1);
+				}
+				buf[c.len] = '\0';
+				if (fread(buf, c.len, 1, f) != 1 ||
+				    !snapshot_restore_state(machine, buf,
+				    c.len))
+					ok = 0;
+				break;
+			default:
+				fseeko(f, c.len, SEEK_CUR);
+			}
+		}
+	}
+
+	free(buf);
+	free(offsets);
+	free(fulls);
+	fclose(f);
+
+	/*  The next snapshot is a full one:  */
+	snapshot_free_shadow(machine);
+
+	if (!ok) {
+		fatal("snapshot_restore(): %s is damaged\n", filename);
+		return -1;
+	}
+
+	debug("[ snapshot %i restored from %s ]\n", nr, filename);
+	return nr;
+}
+
+
+/*
+ *  snapshot_checkpoint():
+ *
+ *  Called regularly from the main loop. Writes a snapshot to the -k file
+ *  every checkpoint_interval seconds.
+ */
+void snapshot_checkpoint(struct machine *machine)
+{
+	struct timeval tv;
+
+	if (machine->checkpoint_filename == NULL)
+		return;
+
+	gettimeofday(&tv, NULL);
+	if (machine->checkpoint_last.tv_sec != 0 &&
+	    tv.tv_sec - machine->checkpoint_last.tv_sec <
+	    machine->checkpoint_interval)
+		return;
+
+	machine->checkpoint_last = tv;
+	if (snapshot_save(machine, machine->checkpoint_filename) < 0) {
+		fatal("checkpointing disabled\n");
+		machine->checkpoint_filename = NULL;
+	}
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  replay_init():
+ *
+ *  Open the -L (record) or -l (replay) log.
+ */
+void replay_init(struct machine *machine)
+{
+	struct replay_log *log;
+	char magic[8];
+
+	if (machine->replay_mode == REPLAY_NONE || machine->replay_log != NULL)
+		return;
+
+	log = malloc(sizeof(struct replay_log));
+	if (log == NULL) {
+		fprintf(stderr, "out of memory in replay_init()\n");
+		exit(1);
+	}
+	memset(log, 0, sizeof(struct replay_log));
+
+	if (machine->replay_mode == REPLAY_RECORD) {
+		log->f = fopen(machine->replay_filename, "w+b");
+		if (log->f != NULL)
+			fwrite(REPLAY_MAGIC, strlen(REPLAY_MAGIC), 1, log->f);
+	} else {
+		log->f = fopen(machine->replay_filename, "rb");
+		if (log->f != NULL && (fread(magic, sizeof(magic), 1,
+		    log->f) != 1 || memcmp(magic, REPLAY_MAGIC,
+		    sizeof(magic)) != 0)) {
+			fprintf(stderr, "%s is not a replay log\n",
+			    machine->replay_filename);
+			exit(1);
+		}
+	}
+
+	if (log->f == NULL) {
+		perror(machine->replay_filename);
+		exit(1);
+	}
+
+	machine->replay_log = log;
+}
+
+
+void replay_deinit(struct machine *machine)
+{
+	struct replay_log *log = machine->replay_log;
+
+	if (log == NULL)
+		return;
+
+	if (machine->replay_mode == REPLAY_PLAY)
+		debug("[ replay: %lli events replayed%s ]\n",
+		    (long long)log->n_events, log->diverged?
+		    ", DIVERGED" : "");
+	else
+		debug("[ replay: %lli events recorded ]\n",
+		    (long long)log->n_events);
+
+	fclose(log->f);
+	free(log);
+	machine->replay_log = NULL;
+}
+
+
+/*
+ *  replay_event():
+ *
+ *  value is what the host says right now. When recording, it is logged
+ *  and returned; when replaying, the logged value is returned instead.
+ *
+ *  If the replayed run asks for a different kind of event than the
+ *  recorded one did, it has diverged (different program, options, or
+ *  host files); live values are used from then on. The cycle count is
+ *  only shown as a hint of where that happened, since it is only exact
+ *  at chunk boundaries.
+ */
+uint64_t replay_event(struct machine *machine, int type, uint64_t value)
+{
+	struct replay_log *log = machine->replay_log;
+	struct replay_record rec;
+
+	if (log == NULL || log->diverged)
+		return value;
+
+	if (machine->replay_mode == REPLAY_RECORD) {
+		memset(&rec, 0, sizeof(rec));
+		rec.ncycles = machine->ncycles;
+		rec.type = type;
+		rec.value = value;
+		fwrite(&rec, sizeof(rec), 1, log->f);
+		fflush(log->f);
+		log->n_events ++;
+		return value;
+	}
+
+	if (fread(&rec, sizeof(rec), 1, log->f) != 1) {
+		fatal("[ replay: end of log after %lli events, using live "
+		    "values ]\n", (long long)log->n_events);
+		log->diverged = 1;
+		return value;
+	}
+
+	if (rec.type != (uint32_t)type) {
+		fatal("[ replay: DIVERGED at event %lli (type %i, recorded "
+		    "type %i at cycle %lli, now at cycle %lli) ]\n",
+		    (long long)log->n_events, type, (int)rec.type,
+		    (long long)rec.ncycles, (long long)machine->ncycles);
+		log->diverged = 1;
+		return value;
+	}
+
+	log->n_events ++;
+	return rec.value;
+}
@@ -172,7 +172,7 @@ unsigned char *get_userland_string(struct cpu *cpu, uint64_t baseaddr)
 unsigned char *get_userland_buf(struct cpu *cpu,	uint64_t baseaddr, uint64_t len)
 {
 	unsigned char *charbuf;
-	size_t i;
+	size_t i, chunk;
 
 	charbuf = malloc(len);
 	if (charbuf == NULL) {
@@ -182,17 +182,39 @@ unsigned char *get_userland_buf(struct cpu *cpu,	uint64_t baseaddr, uint64_t len
 	}
 
 	/*  TODO: address validity check  */
-	for (i=0; i<len; i++) {
-		cpu->memory_rw(cpu, cpu->mem, baseaddr+i, charbuf+i, 1,
+	for (i=0; i<len; i+=chunk) {
+		chunk = 0x1000 - ((baseaddr + i) & 0xfff);
+		if (chunk > len - i)
+			chunk = len - i;
+		cpu->memory_rw(cpu, cpu->mem, baseaddr+i, charbuf+i, chunk,
 		    MEM_READ, CACHE_DATA);
-		/*  debug(" %02x", charbuf[i]);  */
 	}
-	/* debug("\n"); */
 
 	return charbuf;
 }
 
 
+/*
+ *  put_userland_buf():
+ *
+ *  The opposite of get_userland_buf(): copies len bytes from a host buffer
+ *  into emulated memory. Accesses are split at 4 KB page boundaries.
+ */
+void put_userland_buf(struct cpu *cpu, uint64_t baseaddr,
+	unsigned char *buf, uint64_t len)
+{
+	size_t i, chunk;
+
+	for (i=0; i<len; i+=chunk) {
+		chunk = 0x1000 - ((baseaddr + i) & 0xfff);
+		if (chunk > len - i)
+			chunk = len - i;
+		cpu->memory_rw(cpu, cpu->mem, baseaddr+i, buf+i, chunk,
+		    MEM_WRITE, CACHE_DATA);
+	}
+}
+
+
 /*
  *  useremul_syscall():
  *
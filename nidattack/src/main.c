@@ -12,100 +12,16 @@ No License, public domain, do as you want, no warranties
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
-
-typedef char s8;
-typedef short s16;
-typedef int s32;
-typedef unsigned char u8;
-typedef unsigned short u16;
-typedef unsigned int u32;
-
-/*
-SHA-1 based on Steve Reid SHA1 code <steve@edmweb.com>
-*/
-
-// this was originally 64, but since ps3 adds 16 bytes
-// to every hash buffer it may need to be increased.
-// Note: The '128' size does not currently work -
-// would anyone like to fix it? :)
-#define MAX_HASH_BUFF		64
-//#define MAX_HASH_BUFF		128
-
-#define LITTLE_ENDIAN
-
-#define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
-
-/* blk0() and blk() perform the initial expand. */
-/* I got the idea of expanding during the round function from SSLeay */
-#ifdef LITTLE_ENDIAN
-#define blk0(i) (block[i] = (rol(block[i],24)&0xFF00FF00) \
-    |(rol(block[i],8)&0x00FF00FF))
-#else
-#define blk0(i) block[i]
-#endif
-#define blk(i) (block[i&15] = rol(block[(i+13)&15]^block[(i+8)&15] \
-    ^block[(i+2)&15]^block[i&15],1))
-
-/* (R0+R1), R2, R3, R4 are the different operations used in SHA1 */
-#define R0(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk0(i)+0x5A827999+rol(v,5);w=rol(w,30);
-#define R1(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk(i)+0x5A827999+rol(v,5);w=rol(w,30);
-#define R2(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0x6ED9EBA1+rol(v,5);w=rol(w,30);
-#define R3(v,w,x,y,z,i) z+=(((w|x)&y)|(w&x))+blk(i)+0x8F1BBCDC+rol(v,5);w=rol(w,30);
-#define R4(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0xCA62C1D6+rol(v,5);w=rol(w,30);
-
-u32 fastSHA1(unsigned char *buffer,int len) {
-    u8 buf[MAX_HASH_BUFF];
-    s32 i;
-    u32 a, b, c, d, e;
-    u32 *block;
-
-    memcpy(buf, buffer, len);
-    block=(u32 *)buf;
-
-    for(i=len+1; i<MAX_HASH_BUFF-1; i++) {
-      buf[i]=0x00;
-    }
-
-    buf[len]=0x80;
-    buf[MAX_HASH_BUFF-2]=(len*8)>>8;
-    buf[MAX_HASH_BUFF-1]=(len*8)&0xff;
-
-    a = 0x67452301;
-    b = 0xEFCDAB89;
-    c = 0x98BADCFE;
-    d = 0x10325476;
-    e = 0xC3D2E1F0;
-
-    /* 4 rounds of 20 operations each. Loop unrolled. */
-    R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
-    R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
-    R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9); R0(a,b,c,d,e,10); R0(e,a,b,c,d,11);
-    R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14); R0(a,b,c,d,e,15);
-    R1(e,a,b,c,d,16); R1(d,e,a,b,c,17); R1(c,d,e,a,b,18); R1(b,c,d,e,a,19);
-    R2(a,b,c,d,e,20); R2(e,a,b,c,d,21); R2(d,e,a,b,c,22); R2(c,d,e,a,b,23);
-    R2(b,c,d,e,a,24); R2(a,b,c,d,e,25); R2(e,a,b,c,d,26); R2(d,e,a,b,c,27);
-    R2(c,d,e,a,b,28); R2(b,c,d,e,a,29); R2(a,b,c,d,e,30); R2(e,a,b,c,d,31);
-    R2(d,e,a,b,c,32); R2(c,d,e,a,b,33); R2(b,c,d,e,a,34); R2(a,b,c,d,e,35);
-    R2(e,a,b,c,d,36); R2(d,e,a,b,c,37); R2(c,d,e,a,b,38); R2(b,c,d,e,a,39);
-    R3(a,b,c,d,e,40); R3(e,a,b,c,d,41); R3(d,e,a,b,c,42); R3(c,d,e,a,b,43);
-    R3(b,c,d,e,a,44); R3(a,b,c,d,e,45); R3(e,a,b,c,d,46); R3(d,e,a,b,c,47);
-    R3(c,d,e,a,b,48); R3(b,c,d,e,a,49); R3(a,b,c,d,e,50); R3(e,a,b,c,d,51);
-    R3(d,e,a,b,c,52); R3(c,d,e,a,b,53); R3(b,c,d,e,a,54); R3(a,b,c,d,e,55);
-    R3(e,a,b,c,d,56); R3(d,e,a,b,c,57); R3(c,d,e,a,b,58); R3(b,c,d,e,a,59);
-    R4(a,b,c,d,e,60); R4(e,a,b,c,d,61); R4(d,e,a,b,c,62); R4(c,d,e,a,b,63);
-    R4(b,c,d,e,a,64); R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67);
-    R4(c,d,e,a,b,68); R4(b,c,d,e,a,69); R4(a,b,c,d,e,70); R4(e,a,b,c,d,71);
-    R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74); R4(a,b,c,d,e,75);
-    R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
-
-    a+=0x67452301;     
-    return (a>>24)|((a>>8)&0xff00)|((a<<8)&0xff0000)|((a<<24));
-}
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "types.h"
+#include "sha1.h"
 
 #define CUARTO_ORDEN
 
 char **dict;
-char *dict_member_length;
+int *dict_member_length;
 int dict_count;
 unsigned int *hash;
 int hash_count;
@@ -130,39 +46,76 @@ printf("hash_count = %d\n", hash_count);
 	return 0;
 }
 
+// Dictionary words already loaded, an open addressed table of indices into
+// dict, used to drop duplicate words as they are read
+int *word_set;
+unsigned int word_set_mask;
+
+unsigned int hash_string(const char *str)
+{
+	unsigned int h = 2166136261U;
+
+	while (*str)
+		h = (h ^ (unsigned char) *str++) * 16777619U;
+
+	return h;
+}
+
+// Add word i of the dictionary to the set, returns 0 if it was already there
+int word_set_add(int i)
+{
+	unsigned int pos = hash_string(dict[i]) & word_set_mask;
+
+	while (word_set[pos] != -1) {
+		if (strcmp(dict[word_set[pos]], dict[i]) == 0)
+			return 0;
+		pos = (pos + 1) & word_set_mask;
+	}
+	word_set[pos] = i;
+
+	return 1;
+}
+
 int load_dictionary(char *filename)
 {
 	int i;
+	unsigned int size;
 	char buffer[0x200];
 	FILE *fp;
 	printf("Reading dictionary file '%s'\n", filename);
 	if ((fp = fopen(filename, "rt")) == NULL)
 		return -1;
 	dict_count = 0;
-	while (fscanf(fp, "%s\n", buffer) != EOF)
+	while (fscanf(fp, "%511s\n", buffer) != EOF)
 		dict_count++;
 printf("dict_count = %d\n", dict_count);
 	fseek(fp, 0, SEEK_SET);
 	dict = (char **) malloc(dict_count * sizeof(char *));
-	dict_member_length = malloc(dict_count);
+	dict_member_length = malloc(dict_count * sizeof(int));
+	// Keep the set at most half full
+	size = 16;
+	while (size < (unsigned int) dict_count * 2)
+		size *= 2;
+	word_set = malloc(size * sizeof(int));
+	memset(word_set, 0xff, size * sizeof(int));
+	word_set_mask = size - 1;
 	i = 0;
-	while (fscanf(fp, "%s\n", buffer) == 1) {
+	while ((i < dict_count) && (fscanf(fp, "%511s\n", buffer) == 1)) {
 		if ((buffer[0] == '-') || (buffer[0] == '/')) {	// This handles comments in the dic file
 		} else {				// Not a comment, so do duplicate check
-			int count;
-			int found = 0;
-			for (count = 0; count < (i - 1); count++)
-				if (strcmp(buffer, dict[count]) == 0)
-					found = 1;
-			if (found == 0) {	// If not already in dictionary, then add
-				dict_member_length[i] = strlen(buffer);
-				dict[i] = malloc(dict_member_length[i] + 1);
-				strcpy(dict[i], buffer);
+			dict_member_length[i] = strlen(buffer);
+			dict[i] = malloc(dict_member_length[i] + 1);
+			strcpy(dict[i], buffer);
+			if (word_set_add(i)) {	// If not already in dictionary, then keep it
 				i++;
+			} else {
+				free(dict[i]);
 			}
 		}
 	}
 	dict_count = i;
+	free(word_set);
+	word_set = NULL;
 	fclose(fp);
 	return 0;
 }
@@ -171,169 +124,841 @@ FILE *fout;
 
 // Hash seems to be where the program spends most of its time, so we need to speedup the
 // search somehow
-// 32 bit value, 4 bytes
-// what we do, is pre-sort the hashlist, so they are in order AABBCCDD
-// Then index each byte into the list, hence cutting down the search space considerably
-#define VER2_SIZE  256
-// midsearch should hopefully fit in cache, so will
-// help quite a lot with rejection testing.
-int midsearch[VER2_SIZE*VER2_SIZE];
-// bigsearch is really a cop out, will not fit in cache, but still quicker
-// than checking many elements.
-int bigsearch[VER2_SIZE*VER2_SIZE*VER2_SIZE];
+// The hashlist is sorted, then two tables sized to the hash count are built from
+// it. prefilter is a bitset of the top bits of every hash, at 16 bits per hash it
+// rejects all but 1 in 16 misses with one access and stays in cache for lists of
+// 100k hashes. buckets holds where each value of the top bits starts in the sorted
+// list, so the few candidates that get through only compare against a hash or two.
+unsigned int *prefilter;
+int prefilter_shift;
+unsigned int *buckets;
+int bucket_shift;
+
+int compare_hash(const void *a, const void *b)
+{
+  unsigned int x = *(const unsigned int *) a;
+  unsigned int y = *(const unsigned int *) b;
+
+  return (x > y) - (x < y);
+}
 
 void fillsearchtable()
 {
-  unsigned int searchval;
-  int hashpos,hashpos2,hashpos3;
-  int count,count2,count3;
-  // Firstly Sort the hashlist, order AABBCCDD
-  int found = 1;
+  int bits;
+  int count;
+  unsigned int value;
+  int hashpos;
+
   printf("Sorting Hashlist\n");
-  while (found == 1)
-  {
-    found = 0;
-    for (count=0;count<(hash_count-1);count++)
-    {
-      if (hash[count] > hash[count+1])
-      { //  swap entries if wrong way around
-        unsigned int temp = hash[count+1];
-        hash[count+1] = hash[count];
-        hash[count] = temp;
-        found = 1;
-      }
-    }
-  }
-  printf("Clearing Search Tree\n");
-  // Really lazy slow clear array, but who cares only done once
-  for (count=0;count<(VER2_SIZE*VER2_SIZE);count++)
+  qsort(hash, hash_count, sizeof(unsigned int), compare_hash);
+
+  printf("Building Search Tree\n");
+  bits = 12;
+  while ((bits < 28) && ((1 << bits) < hash_count * 16))
+    bits++;
+  prefilter_shift = 32 - bits;
+  prefilter = calloc((1 << bits) / 32, sizeof(unsigned int));
+  for (count=0;count<hash_count;count++)
   {
-    midsearch[count] = -1;
+    value = hash[count] >> prefilter_shift;
+    prefilter[value >> 5] |= 1U << (value & 31);
   }
-  for (count=0;count<(VER2_SIZE*VER2_SIZE*VER2_SIZE);count++)
+
+  // Around one hash per bucket
+  bits = 1;
+  while ((bits < 24) && ((1 << bits) < hash_count))
+    bits++;
+  bucket_shift = 32 - bits;
+  buckets = malloc(((1 << bits) + 1) * sizeof(unsigned int));
+  hashpos = 0;
+  for (count=0;count<=(1 << bits);count++)
   {
-    bigsearch[count] = -1;
-  }
-  printf("Building Search Tree\n");
-  // Now build the toplevel (first) byte
-  for (count=0;count<256;count++)
-  { //  Find the first firstbyte in the hashlist that matches this value
-    hashpos = 0;
-    searchval = (count<<24);
-    while ((hash[hashpos]&0xff000000) < searchval &&
-	   hashpos < hash_count - 1) hashpos++;
-    if ((hash[hashpos]&0xff000000) == searchval)
-    { 
-      // Now Search for a twobyte combo
-      for (count2=0;count2<256;count2++)
-      { //  Find the first secondbyte in the hashlist from this pos
-        hashpos2 = hashpos;
-        searchval = (count<<24) | (count2<<16);
-        while ((hash[hashpos2]&0xffff0000) < searchval &&
-	       hashpos2 < hash_count - 1) hashpos2++;
-        if ((hash[hashpos2]&0xffff0000) == searchval)
-        { //  Add this entry
-          midsearch[(count<<8)+count2] = hashpos2;
-
-          // Now Search for a threebyte combo
-          for (count3=0;count3<256;count3++)
-          { //  Find the first thirdbyte in the hashlist from this pos
-            hashpos3 = hashpos2;
-            searchval = (count<<24) | (count2<<16) | (count3<<8);
-            while ((hash[hashpos3]&0xffffff00) < searchval &&
-		   hashpos3 < hash_count - 1) hashpos3++;
-            if ((hash[hashpos3]&0xffffff00) == searchval)
-            { //  Add this entry
-              bigsearch[(count<<16)+(count2<<8)+count3] = hashpos2;
-            }
-          }
-        }
-      }
-    }
+    while ((hashpos < hash_count) && ((hash[hashpos] >> bucket_shift) < (unsigned int) count))
+      hashpos++;
+    buckets[count] = hashpos;
   }
 }
 
-int findhash(char *buffer, int size, int isPS3)
-{
-  int h;
-  unsigned int hashvalue;
-  unsigned int index1;
-  unsigned int index2;
-  unsigned int index3;
-  u8 int_buff[MAX_HASH_BUFF];
-  u8* buff_ptr;
-  const u8 ps3_key[16] = {
-  	0x67, 0x59, 0x65, 0x99, 0x04, 0x25, 0x04, 0x90,
-  	0x56, 0x64, 0x27, 0x49, 0x94, 0x89, 0x74, 0x1A };
-  
-  if(isPS3)
-  {
-  	buff_ptr = int_buff;
-  	memcpy(int_buff, buffer, size);
-  	memcpy(int_buff+size, ps3_key, 16);
-  	size += 16;
-  }
-  else
-  {
-  	buff_ptr = buffer;
-  }
-  
-  //fastSHA1 doesn't support strings larger than MAX_HASH_BUFF-1 bytes
-  //and chances are unlikely that function names are that
-  //long anyway so reject them before doing processing
-  if (size > MAX_HASH_BUFF-1)
-  	return 0;
-  hashvalue = fastSHA1(buff_ptr, size);
-  index1 = (hashvalue & 0xff000000)>>24;
-  index2 = (hashvalue & 0x00ff0000)>>16;
-  index3 = (hashvalue & 0x0000ff00)>>8;
-  int pos;
-  //  Not sure if this really helps or not, should do.. on early rejection
-  //  memory accesses if nothing else
-  pos = midsearch[(index1<<8)+index2];
-  if (pos != -1)
+const u8 ps3_key[16] = {
+	0x67, 0x59, 0x65, 0x99, 0x04, 0x25, 0x04, 0x90,
+	0x56, 0x64, 0x27, 0x49, 0x94, 0x89, 0x74, 0x1A };
+
+char *prefix = "";
+int prefixlen = 0;
+int is_ps3_flag = 0;
+const sha1_kernel *kernel;
+
+int checkhash(unsigned int hashvalue)
+{
+  unsigned int value;
+  unsigned int pos;
+  unsigned int end;
+
+  //  Early rejection, most candidates stop here
+  value = hashvalue >> prefilter_shift;
+  if ((prefilter[value >> 5] & (1U << (value & 31))) == 0)
+    return 0;
+
+  value = hashvalue >> bucket_shift;
+  end = buckets[value + 1];
+  for (pos = buckets[value]; pos < end; pos++)
   {
-    // Get threebyte position
-    pos = bigsearch[(index1<<16)+(index2<<8)+index3];
-    if (pos != -1)
-    { // Found a position, so search from here
-      for(h=pos; h<hash_count; h++) 
-      {
-        if (hashvalue >= hash[h])
-          if(hashvalue == hash[h]) 
-          { //  If equal, found
-            printf("Found : 0x%08x  %s  \n",hashvalue,buffer);
-            fprintf(fout,"<FUNC><NID>0x%08x</NID><NAME>%s</NAME></FUNC>\n",hashvalue,buffer);
-            return 1;
-          } 
-          else  //  If not, reject as above
-            return 0;
-      }
-    }
+    if (hash[pos] == hashvalue)
+      return 1;
   }
   return 0;
 }
 
-int main(int argc, char **argv)
+// The search space is every combination of up to four dictionary words after the
+// prefix, numbered in the order the nested loops below visit them by a single 64
+// bit counter, so a run can cover any range of it. The combinations of first word
+// x are split into units, one for each second word y plus one for the word on its
+// own (y == dict_count). Threads search whole units, the hits are kept until all
+// earlier units are done so they come out in order.
+u64 square_size;	// combinations of a unit with a second word, dict_count^2 + 1
+u64 word_size;		// combinations of each first word
+u64 total_count;	// combinations in the whole search
+
+// Range of the counter this shard covers, and the part of it this run searches
+u64 shard_begin;
+u64 search_begin;
+u64 search_end;
+u64 first_unit;
+u64 last_unit;
+
+int init_search_space(void)
 {
-	int i; // , j, h;
-	int x, y, z, zz; // , z2;
-	char buffer[0x200];
-	time_t start, end;
-	int colisiones;
-	int is_ps3_flag = 0;
-	
+	u64 d = dict_count;
+
+	// Four words from more than 2^16 would not fit the counter
+	if (d > 65535) {
+		fprintf(stderr, "dictionary too large, the limit is 65535 words\n");
+		return -1;
+	}
+
+	square_size = (d * d) + 1;
+	// Every second word but the first word itself, then x x, then x alone
+	word_size = ((d - 1) * square_size) + 2;
+	total_count = d * word_size;
+
+	return 0;
+}
+
+u64 unit_start(u64 unit)
+{
+	u64 x = unit / (dict_count + 1);
+	u64 y = unit % (dict_count + 1);
+	u64 start = (x * word_size) + (y * square_size);
+
+	// The unit with y == x only holds x x
+	if (y > x)
+		start -= square_size - 1;
+
+	return start;
+}
+
+u64 unit_size(u64 unit)
+{
+	u64 x = unit / (dict_count + 1);
+	u64 y = unit % (dict_count + 1);
+
+	if ((y == x) || (y == (u64) dict_count))
+		return 1;
+
+	return square_size;
+}
+
+// Find the unit a combination is in
+u64 find_unit(u64 counter)
+{
+	u64 x = counter / word_size;
+	u64 pos = counter % word_size;
+	u64 y;
+
+	if (pos < (x * square_size)) {
+		y = pos / square_size;
+	} else {
+		pos -= x * square_size;
+		if (pos == 0) {
+			y = x;
+		} else {
+			y = x + 1 + ((pos - 1) / square_size);
+			if (y > (u64) dict_count)
+				y = dict_count;
+		}
+	}
+
+	return (x * (dict_count + 1)) + y;
+}
+
+typedef struct
+{
+	unsigned int hashvalue;
+	// Position of the candidate in its unit
+	u64 seq;
+	char *name;
+} found_entry;
+
+typedef struct
+{
+	int done;
+	int count;
+	int max;
+	found_entry *found;
+} unit_result;
+
+// Candidates waiting to be hashed, one per kernel lane. Each queue holds
+// candidates which pad out to the same number of blocks.
+typedef struct
+{
+	int used;
+	u32 *words;
+	// Message of each lane, blocks*64 bytes apiece
+	u8 *text;
+	int textlen[SHA1_MAX_LANES];
+	u64 seq[SHA1_MAX_LANES];
+} candidate_queue;
+
+typedef struct
+{
+	pthread_t thread;
+	char *buffer;
+	unit_result *result;
+	// Position in the current unit, and the part of it which is searched
+	u64 seq;
+	u64 lo;
+	u64 hi;
+	// queues[i] holds the candidates of i+1 blocks
+	int queue_count;
+	candidate_queue *queues;
+	u32 out[SHA1_MAX_LANES];
+} worker;
+
+pthread_mutex_t search_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t unit_done = PTHREAD_COND_INITIALIZER;
+// Results of the units being searched, unit n is in results[n % result_slots]
+unit_result *results;
+int result_slots;
+u64 next_unit;
+u64 next_print;
+
+// Progress is saved to the checkpoint file this often, in seconds
+#define CHECKPOINT_INTERVAL	60
+
+char *checkpoint_name;
+time_t checkpoint_time;
+u64 job_key;
+// XML library to write the results into, NULL for the <FUNC> lines
+char *xml_library;
+
+void add_found(unit_result *result, unsigned int hashvalue, u64 seq, const u8 *text, int len)
+{
+	found_entry *entry;
+
+	if (result->count == result->max) {
+		result->max = result->max ? result->max * 2 : 16;
+		result->found = realloc(result->found, result->max * sizeof(found_entry));
+	}
+
+	entry = &result->found[result->count++];
+	entry->hashvalue = hashvalue;
+	entry->seq = seq;
+	entry->name = malloc(len + 1);
+	memcpy(entry->name, text, len);
+	entry->name[len] = 0;
+}
+
+void init_worker(worker *w, int maxlen)
+{
+	int i;
+
+	w->buffer = malloc(maxlen + 1);
+	strcpy(w->buffer, prefix);
+	if (is_ps3_flag)
+		maxlen += 16;
+	w->queue_count = SHA1_BLOCKS(maxlen);
+	w->queues = calloc(w->queue_count, sizeof(candidate_queue));
+	for (i = 0; i < w->queue_count; i++) {
+		w->queues[i].words = malloc((i + 1) * 64 * kernel->lanes);
+		w->queues[i].text = malloc((i + 1) * 64 * kernel->lanes);
+	}
+}
+
+void free_worker(worker *w)
+{
+	int i;
+
+	for (i = 0; i < w->queue_count; i++) {
+		free(w->queues[i].words);
+		free(w->queues[i].text);
+	}
+	free(w->queues);
+	free(w->buffer);
+}
+
+void flush_queue(worker *w, int blocks)
+{
+	candidate_queue *q = &w->queues[blocks-1];
+	int lane;
+
+	if (q->used == 0)
+		return;
+
+	kernel->hash(q->words, blocks, w->out);
+	for (lane = 0; lane < q->used; lane++) {
+		if (checkhash(w->out[lane]))
+			add_found(w->result, w->out[lane], q->seq[lane], q->text + (lane * blocks * 64), q->textlen[lane]);
+	}
+	q->used = 0;
+}
+
+void findhash(worker *w, char *buffer, int size)
+{
+  candidate_queue *q;
+  u8 *text;
+  int lane;
+  int blocks;
+  int len = size;
+  u64 seq = w->seq++;
+
+  // Outside the range being searched
+  if ((seq < w->lo) || (seq >= w->hi))
+    return;
+
+  if (is_ps3_flag)
+    len += 16;
+
+  blocks = SHA1_BLOCKS(len);
+  q = &w->queues[blocks-1];
+  lane = q->used++;
+  text = q->text + (lane * blocks * 64);
+  memcpy(text, buffer, size);
+  if (is_ps3_flag)
+    memcpy(text+size, ps3_key, 16);
+  q->textlen[lane] = size;
+  q->seq[lane] = seq;
+  sha1_pad_message(q->words+lane, kernel->lanes, text, len);
+
+  if (q->used == kernel->lanes)
+    flush_queue(w, blocks);
+}
+
+void search_unit(worker *w, int x, int y)
+{
+	int i;
+	int z, zz; // , z2;
+	u64 size;
+	char *buffer = w->buffer;
 	char *ptr, *ptr0, *ptr1, *ptr2, *ptr3; // , *ptr4;
 
-	char *prefix = "";
-	int prefixlen = 0;
+	ptr = buffer + prefixlen;
+	// First Word
+	ptr0 = ptr;
+	for (i = 0; i < dict_member_length[x]; i++) {
+		*(ptr0++) = dict[x][i];
+	}
+	*(ptr0) = 0;
+	if (y == dict_count) {
+		findhash(w, buffer, ptr0 - buffer);
+		return;
+	}
+
+	// Second word
+	ptr1 = ptr0;
+	for (i = 0; i < dict_member_length[y]; i++) {
+		*(ptr1++) = dict[y][i];
+	}
+	*(ptr1) = 0;
+
+	// Only do next loop if first and second dont match
+	if (x != y) {
+		// Third Word
+		for (z = 0; z < dict_count; z++) {
+			// Skip over the third words wholly outside the range
+			size = (y != z) ? dict_count + 1 : 1;
+			if ((w->seq >= w->hi) || ((w->seq + size) <= w->lo)) {
+				w->seq += size;
+				continue;
+			}
+
+			ptr2 = ptr1;
+			for (i = 0; i < dict_member_length[z]; i++) {
+				*(ptr2++) = dict[z][i];
+			}
+			// Only do next loop if second and third dont match
+			if (y != z) {
+				// Fourth Word
+				for (zz = 0; zz < dict_count; zz++) {
+					ptr3 = ptr2;
+					for (i = 0; i < dict_member_length[zz]; i++) {
+						*(ptr3++) = dict[zz][i];
+					}
+#if 0
+					// Only do next loop if third and fourth dont match
+					if (strcmp(dict[z], dict[zz]) != 0) {
+						// Fifth Word
+						for (z2 = 0; z2 < dict_count; z2++) {
+							ptr4 = ptr3;
+							for (i = 0; i < dict_member_length[z2]; i++) {
+								*(ptr4++) = dict[z2][i];
+							}
+							*(ptr4) = 0x00;
+							findhash(w, buffer, ptr4 - buffer);
+						}
+					}
+#endif
+					*(ptr3) = 0x00;
+					findhash(w, buffer, ptr3 - buffer);
+				}
+			}
+			*(ptr2) = 0x00;
+			findhash(w, buffer, ptr2 - buffer);
+		}
+	}
+	*(ptr1) = 0x00;
+	findhash(w, buffer, ptr1 - buffer);
+}
+
+int compare_found(const void *a, const void *b)
+{
+	u64 x = ((const found_entry *) a)->seq;
+	u64 y = ((const found_entry *) b)->seq;
+
+	return (x > y) - (x < y);
+}
+
+// Mix a block of data into the 64 bit FNV-1a hash identifying the job
+u64 key_add(u64 key, const void *data, int size)
+{
+	const u8 *p = (const u8 *) data;
+
+	while (size-- > 0)
+		key = (key ^ *p++) * 1099511628211ULL;
+
+	return key;
+}
+
+// Identify the job from everything which decides the search space and the output
+u64 make_job_key(void)
+{
+	u64 key = 14695981039346656037ULL;
+	int i;
+
+	for (i = 0; i < dict_count; i++)
+		key = key_add(key, dict[i], dict_member_length[i] + 1);
+	key = key_add(key, hash, hash_count * sizeof(unsigned int));
+	key = key_add(key, prefix, prefixlen + 1);
+	key = key_add(key, &is_ps3_flag, sizeof(is_ps3_flag));
+	if (xml_library != NULL)
+		key = key_add(key, xml_library, strlen(xml_library) + 1);
+
+	return key;
+}
+
+// Save the progress, everything below done is searched and its results are in
+// the output file. Written to a temporary file first so it is never left half written.
+void write_checkpoint(u64 done)
+{
+	char tmpname[1024];
+	FILE *fp;
+
+	if (checkpoint_name == NULL)
+		return;
+
+	fflush(fout);
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", checkpoint_name);
+	fp = fopen(tmpname, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "can't write the checkpoint file %s\n", tmpname);
+		return;
+	}
+	fprintf(fp, "nidattack checkpoint 1\n");
+	fprintf(fp, "job %016llx\n", job_key);
+	fprintf(fp, "range %llu %llu\n", shard_begin, search_end);
+	fprintf(fp, "done %llu\n", done);
+	fprintf(fp, "output %ld\n", ftell(fout));
+	if ((fclose(fp) != 0) || (rename(tmpname, checkpoint_name) != 0))
+		fprintf(stderr, "can't write the checkpoint file %s\n", checkpoint_name);
+	time(&checkpoint_time);
+}
+
+// Read a checkpoint for this job, returns 1 and the progress if there is one,
+// 0 if there is none and -1 if it is for a different job
+int read_checkpoint(u64 *done, long *output)
+{
+	unsigned long long key, begin, end, d;
+	int version;
+	FILE *fp;
+
+	fp = fopen(checkpoint_name, "r");
+	if (fp == NULL)
+		return 0;
+
+	if ((fscanf(fp, "nidattack checkpoint %d\n", &version) != 1) || (version != 1) ||
+	    (fscanf(fp, "job %llx\n", &key) != 1) || (fscanf(fp, "range %llu %llu\n", &begin, &end) != 2) ||
+	    (fscanf(fp, "done %llu\n", &d) != 1) || (fscanf(fp, "output %ld\n", output) != 1)) {
+		fprintf(stderr, "checkpoint file %s is corrupt\n", checkpoint_name);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	if ((key != job_key) || (begin != shard_begin) || (end != search_end)) {
+		fprintf(stderr, "checkpoint file %s is for a different job\n", checkpoint_name);
+		return -1;
+	}
+
+	*done = d;
+	return 1;
+}
+
+void write_xml_header(void)
+{
+	fprintf(fout, "<?xml version=\"1.0\" ?>\n");
+	fprintf(fout, "<PSPLIBDOC>\n\t<PRXFILES>\n\t\t<PRXFILE>\n");
+	fprintf(fout, "\t\t<PRX>nidattack.prx</PRX>\n\t\t<PRXNAME>nidattack</PRXNAME>\n");
+	fprintf(fout, "\t\t<LIBRARIES>\n\t\t\t<LIBRARY>\n");
+	fprintf(fout, "\t\t\t\t<NAME>%s</NAME>\n\t\t\t\t<FLAGS>0x00000000</FLAGS>\n", xml_library);
+	fprintf(fout, "\t\t\t\t<FUNCTIONS>\n");
+}
+
+void write_xml_footer(void)
+{
+	fprintf(fout, "\t\t\t\t</FUNCTIONS>\n\t\t\t</LIBRARY>\n\t\t</LIBRARIES>\n");
+	fprintf(fout, "\t\t</PRXFILE>\n\t</PRXFILES>\n</PSPLIBDOC>\n");
+}
+
+// Print the results of all the units which are done and have no earlier
+// unit still being searched. Called with search_lock held.
+void print_results(void)
+{
+	unit_result *result;
+	u64 x;
+	int i;
+
+	while ((next_print < last_unit) && (results[next_print % result_slots].done)) {
+		result = &results[next_print % result_slots];
+		// The queues hash candidates out of order, put them back in order
+		qsort(result->found, result->count, sizeof(found_entry), compare_found);
+		x = next_print / (dict_count + 1);
+		if ((next_print == first_unit) || ((next_print % (dict_count + 1)) == 0)) {
+			printf("// processing word: %s%s\n", prefix, dict[x]);
+			fflush(stdout);
+		}
+		for (i = 0; i < result->count; i++) {
+			printf("Found : 0x%08x  %s  \n",result->found[i].hashvalue,result->found[i].name);
+			if (xml_library != NULL)
+				fprintf(fout,"\t\t\t\t\t<FUNCTION>\n\t\t\t\t\t\t<NID>0x%08X</NID>\n\t\t\t\t\t\t<NAME>%s</NAME>\n\t\t\t\t\t</FUNCTION>\n",
+					result->found[i].hashvalue,result->found[i].name);
+			else
+				fprintf(fout,"<FUNC><NID>0x%08x</NID><NAME>%s</NAME></FUNC>\n",result->found[i].hashvalue,result->found[i].name);
+			free(result->found[i].name);
+		}
+		free(result->found);
+		memset(result, 0, sizeof(unit_result));
+		next_print++;
+	}
+
+	if ((checkpoint_name != NULL) && (next_print < last_unit) && (time(NULL) - checkpoint_time >= CHECKPOINT_INTERVAL)) {
+		u64 done = unit_start(next_print);
+
+		write_checkpoint(done > search_begin ? done : search_begin);
+	}
+}
+
+void *search_thread(void *arg)
+{
+	worker *w = (worker *) arg;
+	u64 unit;
+	u64 start;
+	u64 size;
+	int i;
+
+	while (1) {
+		pthread_mutex_lock(&search_lock);
+		// Don't get more than result_slots ahead of the results being printed
+		while ((next_unit < last_unit) && (next_unit >= next_print + result_slots))
+			pthread_cond_wait(&unit_done, &search_lock);
+		unit = next_unit++;
+		pthread_mutex_unlock(&search_lock);
+		if (unit >= last_unit)
+			break;
+
+		start = unit_start(unit);
+		size = unit_size(unit);
+		w->result = &results[unit % result_slots];
+		w->seq = 0;
+		w->lo = (search_begin > start) ? search_begin - start : 0;
+		w->hi = (search_end < start + size) ? search_end - start : size;
+		search_unit(w, unit / (dict_count + 1), unit % (dict_count + 1));
+		for (i = 1; i <= w->queue_count; i++)
+			flush_queue(w, i);
+
+		pthread_mutex_lock(&search_lock);
+		w->result->done = 1;
+		print_results();
+		pthread_cond_broadcast(&unit_done);
+		pthread_mutex_unlock(&search_lock);
+	}
+
+	return NULL;
+}
+
+int get_cpu_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (count > 0)
+		return count;
+#endif
+	return 1;
+}
+
+double get_seconds(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + (tv.tv_usec / 1000000.0);
+}
+
+// Number of hashes each thread does per benchmark run
+#define BENCH_HASHES	(1 << 22)
+
+typedef struct
+{
+	pthread_t thread;
+	const sha1_kernel *kernel;
+	u32 sink;
+} bench_thread_state;
+
+void *bench_thread(void *arg)
+{
+	bench_thread_state *b = (bench_thread_state *) arg;
+	u32 words[16*SHA1_MAX_LANES];
+	u32 out[SHA1_MAX_LANES];
+	u32 sink = 0;
+	int i;
+
+	for (i = 0; i < 16*SHA1_MAX_LANES; i++)
+		words[i] = i * 0x9E3779B1;
+
+	for (i = 0; i < BENCH_HASHES; i += b->kernel->lanes) {
+		words[0] = i;
+		b->kernel->hash(words, 1, out);
+		sink ^= out[0];
+	}
+	b->sink = sink;
+
+	return NULL;
+}
+
+// Longest message the kernels are checked with
+#define BENCH_VERIFY_LEN	200
+
+// Check a kernel gives the same nids as the scalar one for random messages of
+// every length up to a few blocks
+int bench_verify(const sha1_kernel *k)
+{
+	u32 *words;
+	u32 out[SHA1_MAX_LANES];
+	u8 msg[BENCH_VERIFY_LEN];
+	u8 *buf;
+	int lane, len, i;
+	int ok = 1;
+
+	words = malloc(SHA1_BLOCKS(BENCH_VERIFY_LEN) * 64 * k->lanes);
+	buf = malloc(SHA1_BLOCKS(BENCH_VERIFY_LEN) * 64);
+	srand(1);
+	for (len = 1; len < BENCH_VERIFY_LEN; len++) {
+		for (i = 0; i < len; i++)
+			msg[i] = rand();
+		for (lane = 0; lane < k->lanes; lane++) {
+			msg[0] += lane;
+			memcpy(buf, msg, len);
+			sha1_pad_message(words+lane, k->lanes, buf, len);
+		}
+		k->hash(words, SHA1_BLOCKS(len), out);
+		for (lane = k->lanes - 1; lane >= 0; lane--) {
+			if (out[lane] != fastSHA1(msg, len))
+				ok = 0;
+			msg[0] -= lane;
+		}
+	}
+	free(buf);
+	free(words);
+
+	return ok;
+}
+
+// Number of lookups timed by the search table benchmark
+#define BENCH_PROBES		(1 << 24)
+// Size of the made up hash list used when no list is given
+#define BENCH_RANDOM_HASHES	(1 << 17)
+
+// Time building the search table and loading the dictionary, then how fast the
+// table rejects random values and finds ones in the list
+int run_lookup_benchmark(char *hashfile, char *dictfile)
+{
+	double start, secs;
+	unsigned int value = 2463534242U;
+	unsigned int pos;
+	int hits;
+	int i;
+
+	if (hashfile != NULL) {
+		if (load_hash_list(hashfile) < 0) {
+			fprintf(stderr, "can't open the hash file %s\n", hashfile);
+			return 2;
+		}
+	} else {
+		hash_count = BENCH_RANDOM_HASHES;
+		hash = malloc(hash_count * sizeof(unsigned int));
+		for (i = 0; i < hash_count; i++) {
+			value ^= value << 13; value ^= value >> 17; value ^= value << 5;
+			hash[i] = value;
+		}
+	}
+
+	start = get_seconds();
+	fillsearchtable();
+	secs = get_seconds() - start;
+	printf("search table : %d hashes in %.2f ms, %d KB prefilter, %d KB buckets\n", hash_count, secs * 1000.0,
+		(1 << (32 - prefilter_shift)) / 8192, ((1 << (32 - bucket_shift)) + 1) * 4 / 1024);
+
+	if (dictfile != NULL) {
+		start = get_seconds();
+		if (load_dictionary(dictfile) < 0) {
+			fprintf(stderr, "can't open the dictionary file %s\n", dictfile);
+			return 3;
+		}
+		secs = get_seconds() - start;
+		printf("dictionary   : %d words in %.2f ms\n", dict_count, secs * 1000.0);
+	}
+
+	hits = 0;
+	start = get_seconds();
+	for (i = 0; i < BENCH_PROBES; i++) {
+		value ^= value << 13; value ^= value >> 17; value ^= value << 5;
+		hits += checkhash(value);
+	}
+	secs = get_seconds() - start;
+	printf("probes       : %12.0f/sec for random values, %d found\n", BENCH_PROBES / secs, hits);
+
+	hits = 0;
+	start = get_seconds();
+	pos = 0;
+	for (i = 0; i < BENCH_PROBES; i++) {
+		hits += checkhash(hash[pos]);
+		pos = (pos + 7919) % hash_count;
+	}
+	secs = get_seconds() - start;
+	printf("probes       : %12.0f/sec for values in the list, %d of %d found\n\n", BENCH_PROBES / secs, hits, BENCH_PROBES);
+
+	return 0;
+}
+
+// Report the raw SHA1 throughput of each kernel for a range of thread counts
+int run_benchmark(int max_threads)
+{
+	const sha1_kernel *kernels[8];
+	bench_thread_state *state;
+	int kernel_count;
+	int threads;
+	int k, i;
+	double start, secs;
+
+	kernel_count = sha1_get_kernels(kernels, 8);
+
+	// "abc" and a two block message, from FIPS 180-1
+	if ((fastSHA1((const u8 *) "abc", 3) != 0x363e99a9) ||
+	    (fastSHA1((const u8 *) "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56) != 0x443e9884)) {
+		printf("scalar   : FAILED, wrong digest for the test vectors\n");
+		return 1;
+	}
+
+	if (max_threads < 1)
+		max_threads = 1;
+	state = malloc(max_threads * sizeof(bench_thread_state));
+
+	printf("%d hashes per thread\n\n", BENCH_HASHES);
+	for (k = 0; k < kernel_count; k++) {
+		if (!bench_verify(kernels[k])) {
+			printf("%-8s : FAILED, does not match the scalar kernel\n", kernels[k]->name);
+			continue;
+		}
+
+		threads = 1;
+		while (1) {
+			start = get_seconds();
+			for (i = 0; i < threads; i++) {
+				state[i].kernel = kernels[k];
+				pthread_create(&state[i].thread, NULL, bench_thread, &state[i]);
+			}
+			for (i = 0; i < threads; i++)
+				pthread_join(state[i].thread, NULL);
+			secs = get_seconds() - start;
+
+			printf("%-8s %2d lanes %3d threads : %12.0f hashes/sec\n", kernels[k]->name,
+				kernels[k]->lanes, threads, ((double) BENCH_HASHES * threads) / secs);
+			fflush(stdout);
+
+			if (threads == max_threads)
+				break;
+			threads *= 2;
+			if (threads > max_threads)
+				threads = max_threads;
+		}
+	}
+
+	free(state);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+	char c;
+	time_t start, end;
+	int maxlen;
+	int thread_count = 0;
+	char *simd = NULL;
+	char *outname = "results.xml";
+	char *opt;
+	unsigned int shard = 0;
+	unsigned int shard_count = 1;
+	u64 done;
+	long output_size = 0;
+	int resume = 0;
+	worker *workers;
 
 	printf("SHA1 hash dictionary attack v2.1 by adresd\n");
 	printf("based on the original by djhuevo\n");
 	printf("PS3 support added by xorloser\n");
 
+	if ((argc > 1) && !strcmp("-bench", argv[1])) {
+		if ((argc > 2) && ((sscanf(argv[2], "%d%c", &i, &c) != 1) || (i < 1))) {
+			fprintf(stderr, "bad thread count %s, should be a number >= 1\n", argv[2]);
+			return 4;
+		}
+		i = run_lookup_benchmark(argc > 3 ? argv[3] : NULL, argc > 4 ? argv[4] : NULL);
+		if (i == 0)
+			i = run_benchmark(argc > 2 ? atoi(argv[2]) : get_cpu_count());
+		return i;
+	}
+
 	if (argc < 3) {
-		printf("usage:\n\t%s <hash_list> <dictionary> [-ps3] [prefix]\n", argv[0]);
+		printf("usage:\n\t%s <hash_list> <dictionary> [options] [prefix]\n", argv[0]);
+		printf("\t%s -bench [max threads] [hash_list] [dictionary]\n", argv[0]);
+		printf("options:\n");
+		printf("\t-ps3                 add the PS3 salt to every name\n");
+		printf("\t-threads n           number of search threads, default one per cpu\n");
+		printf("\t-simd name           SHA1 kernel, scalar, sse2, avx2 or avx512\n");
+		printf("\t-shard i/n           only search part i of n, 0 <= i < n\n");
+		printf("\t-checkpoint file     save progress to file, resuming from it if it exists\n");
+		printf("\t-o file              results file, default results.xml\n");
+		printf("\t-xml library         write the results as a library in prxtool's XML format\n");
 		return 1;
 	}
 
@@ -347,19 +972,31 @@ int main(int argc, char **argv)
 		return 3;
 	}
 
-	if (argc > 3) {
-		if( !strcmp("-ps3", argv[3]) ) {
+	for (i = 3; i < argc; i++) {
+		// Take --option as well as -option
+		opt = argv[i];
+		if ((opt[0] == '-') && (opt[1] == '-'))
+			opt++;
+
+		if (!strcmp("-ps3", opt)) {
 			is_ps3_flag = 1;
-			if (argc > 4) {
-				prefix = argv[4];
-				strcpy(buffer, prefix);
-				prefixlen = strlen(prefix);
+		} else if (!strcmp("-threads", opt) && (i + 1 < argc)) {
+			thread_count = atoi(argv[++i]);
+		} else if (!strcmp("-simd", opt) && (i + 1 < argc)) {
+			simd = argv[++i];
+		} else if (!strcmp("-shard", opt) && (i + 1 < argc)) {
+			if ((sscanf(argv[++i], "%u/%u", &shard, &shard_count) != 2) || (shard >= shard_count)) {
+				fprintf(stderr, "bad shard %s, should be i/n with 0 <= i < n\n", argv[i]);
+				return 4;
 			}
-		}
-		else
-		{
-			prefix = argv[3];
-			strcpy(buffer, prefix);
+		} else if (!strcmp("-checkpoint", opt) && (i + 1 < argc)) {
+			checkpoint_name = argv[++i];
+		} else if (!strcmp("-o", opt) && (i + 1 < argc)) {
+			outname = argv[++i];
+		} else if (!strcmp("-xml", opt) && (i + 1 < argc)) {
+			xml_library = argv[++i];
+		} else {
+			prefix = argv[i];
 			prefixlen = strlen(prefix);
 		}
 	}
@@ -370,9 +1007,13 @@ int main(int argc, char **argv)
 		return 4;
 	}
 
-	if ((fout = fopen("results.xml", "wba")) <= 0) {
-		printf("Failed to open output file\n");
-		exit(1);
+	if (init_search_space() < 0)
+		return 4;
+
+	kernel = sha1_find_kernel(simd);
+	if (kernel == NULL) {
+		fprintf(stderr, "unknown simd kernel %s\n", simd);
+		return 5;
 	}
 
 	printf("\nprefix : '%s'\n", prefix != "" ? prefix : "<None>");
@@ -381,78 +1022,89 @@ int main(int argc, char **argv)
 
 	fillsearchtable();
 
-	printf("\nsearching...\n\n");
-	fflush(stdout);
-	time(&start);
-	ptr = buffer + prefixlen;
-	colisiones = 0;
-	// First Word
-	for (x = 0; x < dict_count; x++) {
-		ptr0 = ptr;
-		for (i = 0; i < dict_member_length[x]; i++) {
-			*(ptr0++) = dict[x][i];
+	// Split the counter evenly, without overflowing total_count * shard
+	shard_begin = ((total_count / shard_count) * shard) + (((total_count % shard_count) * shard) / shard_count);
+	search_end = ((total_count / shard_count) * (shard + 1)) + (((total_count % shard_count) * (shard + 1)) / shard_count);
+	done = shard_begin;
+	job_key = make_job_key();
+
+	if (checkpoint_name != NULL) {
+		resume = read_checkpoint(&done, &output_size);
+		if (resume < 0)
+			return 6;
+		if (resume && (done >= search_end)) {
+			printf("\nshard %u/%u is already finished\n", shard, shard_count);
+			return 0;
 		}
-		*(ptr0) = 0;
-		printf("// processing word: %s\n", buffer);
-		fflush(stdout);
-		// Second word
-		for (y = 0; y < dict_count; y++) {
-			ptr1 = ptr0;
-			for (i = 0; i < dict_member_length[y]; i++) {
-				*(ptr1++) = dict[y][i];
-			}
-			*(ptr1) = 0;
-			//printf("// processing word: %s\n",buffer);
-
-			// Only do next loop if first and second dont match
-			if (strcmp(dict[x], dict[y]) != 0) {
-				// Third Word
-				for (z = 0; z < dict_count; z++) {
-					ptr2 = ptr1;
-					for (i = 0; i < dict_member_length[z]; i++) {
-						*(ptr2++) = dict[z][i];
-					}
-					// Only do next loop if second and third dont match
-					if (strcmp(dict[y], dict[z]) != 0) {
-						// Fourth Word
-						for (zz = 0; zz < dict_count; zz++) {
-							ptr3 = ptr2;
-							for (i = 0; i < dict_member_length[zz]; i++) {
-								*(ptr3++) = dict[zz][i];
-							}
-#if 0
-							// Only do next loop if third and fourth dont match
-							if (strcmp(dict[z], dict[zz]) != 0) {
-								// Fifth Word
-								for (z2 = 0; z2 < dict_count; z2++) {
-									ptr4 = ptr3;
-									for (i = 0; i < dict_member_length[z2]; i++) {
-										*(ptr4++) = dict[z2][i];
-									}
-									*(ptr4) = 0x00;
-									findhash(buffer, ptr4 - buffer, is_ps3_flag);
-								}
-							}
-#endif
-							*(ptr3) = 0x00;
-							findhash(buffer, ptr3 - buffer, is_ps3_flag);
-						}
-					}
-					*(ptr2) = 0x00;
-					findhash(buffer, ptr2 - buffer, is_ps3_flag);
-				}
-			}
-			*(ptr1) = 0x00;
-			findhash(buffer, ptr1 - buffer, is_ps3_flag);
+	}
+
+	// Carry on after the results saved with the checkpoint, dropping any found since
+	if (resume) {
+		if ((truncate(outname, output_size) != 0) || ((fout = fopen(outname, "ab")) == NULL)) {
+			printf("Failed to open output file\n");
+			exit(1);
 		}
-		*(ptr0) = 0x00;
-		findhash(buffer, ptr0 - buffer, is_ps3_flag);
+	} else {
+		if ((fout = fopen(outname, "wb")) == NULL) {
+			printf("Failed to open output file\n");
+			exit(1);
+		}
+		if (xml_library != NULL)
+			write_xml_header();
+	}
+
+	if ((shard_count > 1) || resume) {
+		printf("\ncombinations : %llu to %llu of %llu, shard %u/%u\n", done, search_end, total_count, shard, shard_count);
+		if (resume)
+			printf("resuming from %s\n", checkpoint_name);
+	}
+
+	// Each thread needs room for the prefix and four of the longest word
+	maxlen = 0;
+	for (i = 0; i < dict_count; i++) {
+		if (dict_member_length[i] > maxlen)
+			maxlen = dict_member_length[i];
 	}
+
+	search_begin = done;
+	first_unit = find_unit(search_begin);
+	last_unit = (search_end > search_begin) ? find_unit(search_end - 1) + 1 : first_unit;
+	next_unit = first_unit;
+	next_print = first_unit;
+
+	if (thread_count < 1)
+		thread_count = get_cpu_count();
+	if ((u64) thread_count > last_unit - first_unit)
+		thread_count = (last_unit > first_unit) ? last_unit - first_unit : 1;
+
+	result_slots = thread_count * 4;
+	results = calloc(result_slots, sizeof(unit_result));
+	workers = calloc(thread_count, sizeof(worker));
+	for (i = 0; i < thread_count; i++)
+		init_worker(&workers[i], prefixlen + (maxlen * 4));
+
+	printf("\nsearching...\n\n");
+	fflush(stdout);
+	time(&start);
+	time(&checkpoint_time);
+	for (i = 0; i < thread_count; i++)
+		pthread_create(&workers[i].thread, NULL, search_thread, &workers[i]);
+	for (i = 0; i < thread_count; i++)
+		pthread_join(workers[i].thread, NULL);
 	time(&end);
 	printf("\n\nhash count : %d\n", hash_count);
 	printf("dictionary words: %d\n\n", dict_count);
 	printf("\n\ntime : %f seconds.\n", difftime(end, start));
 
+	if (xml_library != NULL)
+		write_xml_footer();
+	write_checkpoint(search_end);
+
+	for (i = 0; i < thread_count; i++)
+		free_worker(&workers[i]);
+	free(workers);
+	free(results);
+
 	fclose(fout);
 	return 0;
 }
@@ -0,0 +1,314 @@
+/*
+SHA1 dictionary attack program v2.0 (c) 2005 adresd
+
+Multi-buffer SHA1 kernels, these hash several candidates per call
+using whatever SIMD instruction set the cpu has.
+
+No License, public domain, do as you want, no warranties
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sha1.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+// Compiler can build functions for other instruction sets and check the cpu at runtime
+#define SHA1_X86
+#include <immintrin.h>
+#endif
+
+/*
+SHA-1 based on Steve Reid SHA1 code <steve@edmweb.com>
+*/
+
+#define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
+
+/* blk0() and blk() perform the initial expand. */
+/* I got the idea of expanding during the round function from SSLeay */
+/* The blocks are already in big endian words, see sha1_pad_message */
+#define blk0(i) block[i]
+#define blk(i) (block[i&15] = rol(block[(i+13)&15]^block[(i+8)&15] \
+    ^block[(i+2)&15]^block[i&15],1))
+
+/* (R0+R1), R2, R3, R4 are the different operations used in SHA1 */
+#define R0(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk0(i)+0x5A827999+rol(v,5);w=rol(w,30);
+#define R1(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk(i)+0x5A827999+rol(v,5);w=rol(w,30);
+#define R2(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0x6ED9EBA1+rol(v,5);w=rol(w,30);
+#define R3(v,w,x,y,z,i) z+=(((w|x)&y)|(w&x))+blk(i)+0x8F1BBCDC+rol(v,5);w=rol(w,30);
+#define R4(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0xCA62C1D6+rol(v,5);w=rol(w,30);
+
+static void sha1_scalar_block(u32 *state, const u32 *words)
+{
+    u32 block[16];
+    u32 a, b, c, d, e;
+
+    memcpy(block, words, sizeof(block));
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    /* 4 rounds of 20 operations each. Loop unrolled. */
+    R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
+    R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
+    R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9); R0(a,b,c,d,e,10); R0(e,a,b,c,d,11);
+    R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14); R0(a,b,c,d,e,15);
+    R1(e,a,b,c,d,16); R1(d,e,a,b,c,17); R1(c,d,e,a,b,18); R1(b,c,d,e,a,19);
+    R2(a,b,c,d,e,20); R2(e,a,b,c,d,21); R2(d,e,a,b,c,22); R2(c,d,e,a,b,23);
+    R2(b,c,d,e,a,24); R2(a,b,c,d,e,25); R2(e,a,b,c,d,26); R2(d,e,a,b,c,27);
+    R2(c,d,e,a,b,28); R2(b,c,d,e,a,29); R2(a,b,c,d,e,30); R2(e,a,b,c,d,31);
+    R2(d,e,a,b,c,32); R2(c,d,e,a,b,33); R2(b,c,d,e,a,34); R2(a,b,c,d,e,35);
+    R2(e,a,b,c,d,36); R2(d,e,a,b,c,37); R2(c,d,e,a,b,38); R2(b,c,d,e,a,39);
+    R3(a,b,c,d,e,40); R3(e,a,b,c,d,41); R3(d,e,a,b,c,42); R3(c,d,e,a,b,43);
+    R3(b,c,d,e,a,44); R3(a,b,c,d,e,45); R3(e,a,b,c,d,46); R3(d,e,a,b,c,47);
+    R3(c,d,e,a,b,48); R3(b,c,d,e,a,49); R3(a,b,c,d,e,50); R3(e,a,b,c,d,51);
+    R3(d,e,a,b,c,52); R3(c,d,e,a,b,53); R3(b,c,d,e,a,54); R3(a,b,c,d,e,55);
+    R3(e,a,b,c,d,56); R3(d,e,a,b,c,57); R3(c,d,e,a,b,58); R3(b,c,d,e,a,59);
+    R4(a,b,c,d,e,60); R4(e,a,b,c,d,61); R4(d,e,a,b,c,62); R4(c,d,e,a,b,63);
+    R4(b,c,d,e,a,64); R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67);
+    R4(c,d,e,a,b,68); R4(b,c,d,e,a,69); R4(a,b,c,d,e,70); R4(e,a,b,c,d,71);
+    R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74); R4(a,b,c,d,e,75);
+    R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
+
+    state[0]+=a;
+    state[1]+=b;
+    state[2]+=c;
+    state[3]+=d;
+    state[4]+=e;
+}
+
+static void sha1_scalar(const u32 *words, int blocks, u32 *out)
+{
+    u32 state[5];
+    u32 h0;
+
+    state[0] = 0x67452301;
+    state[1] = 0xEFCDAB89;
+    state[2] = 0x98BADCFE;
+    state[3] = 0x10325476;
+    state[4] = 0xC3D2E1F0;
+
+    for(; blocks>0; blocks--, words+=16) {
+      sha1_scalar_block(state, words);
+    }
+
+    h0 = state[0];
+    *out = (h0>>24)|((h0>>8)&0xff00)|((h0<<8)&0xff0000)|((h0<<24));
+}
+
+#ifdef SHA1_X86
+
+/* SSE2, 4 lanes */
+#define SHA1X_NAME      sha1_sse2
+#define SHA1X_BLOCK     sha1_sse2_block
+#define SHA1X_TARGET    __attribute__((target("sse2")))
+#define SHA1X_LANES     4
+#define V               __m128i
+#define V_LOAD(p)       _mm_loadu_si128((const __m128i *) (p))
+#define V_STORE(p, v)   _mm_storeu_si128((__m128i *) (p), v)
+#define V_SET1(x)       _mm_set1_epi32((int) (x))
+#define V_ADD           _mm_add_epi32
+#define V_AND           _mm_and_si128
+#define V_XOR           _mm_xor_si128
+#define V_ROL(v, bits)  _mm_or_si128(_mm_slli_epi32(v, bits), _mm_srli_epi32(v, 32-(bits)))
+#define V_CH(w,x,y)     V_XOR(V_AND(w, V_XOR(x, y)), y)
+#define V_PARITY(w,x,y) V_XOR(V_XOR(w, x), y)
+#define V_MAJ(w,x,y)    _mm_or_si128(V_AND(_mm_or_si128(w, x), y), V_AND(w, x))
+#include "sha1_simd.h"
+#undef SHA1X_NAME
+#undef SHA1X_BLOCK
+#undef SHA1X_TARGET
+#undef SHA1X_LANES
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_AND
+#undef V_XOR
+#undef V_ROL
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+
+/* AVX2, 8 lanes */
+#define SHA1X_NAME      sha1_avx2
+#define SHA1X_BLOCK     sha1_avx2_block
+#define SHA1X_TARGET    __attribute__((target("avx2")))
+#define SHA1X_LANES     8
+#define V               __m256i
+#define V_LOAD(p)       _mm256_loadu_si256((const __m256i *) (p))
+#define V_STORE(p, v)   _mm256_storeu_si256((__m256i *) (p), v)
+#define V_SET1(x)       _mm256_set1_epi32((int) (x))
+#define V_ADD           _mm256_add_epi32
+#define V_AND           _mm256_and_si256
+#define V_XOR           _mm256_xor_si256
+#define V_ROL(v, bits)  _mm256_or_si256(_mm256_slli_epi32(v, bits), _mm256_srli_epi32(v, 32-(bits)))
+#define V_CH(w,x,y)     V_XOR(V_AND(w, V_XOR(x, y)), y)
+#define V_PARITY(w,x,y) V_XOR(V_XOR(w, x), y)
+#define V_MAJ(w,x,y)    _mm256_or_si256(V_AND(_mm256_or_si256(w, x), y), V_AND(w, x))
+#include "sha1_simd.h"
+#undef SHA1X_NAME
+#undef SHA1X_BLOCK
+#undef SHA1X_TARGET
+#undef SHA1X_LANES
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_AND
+#undef V_XOR
+#undef V_ROL
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+
+/* AVX-512, 16 lanes with native rotates and three input logic ops */
+#define SHA1X_NAME      sha1_avx512
+#define SHA1X_BLOCK     sha1_avx512_block
+#define SHA1X_TARGET    __attribute__((target("avx512f")))
+#define SHA1X_LANES     16
+#define V               __m512i
+#define V_LOAD(p)       _mm512_loadu_si512((const void *) (p))
+#define V_STORE(p, v)   _mm512_storeu_si512((void *) (p), v)
+#define V_SET1(x)       _mm512_set1_epi32((int) (x))
+#define V_ADD           _mm512_add_epi32
+#define V_AND           _mm512_and_si512
+#define V_XOR           _mm512_xor_si512
+#define V_ROL(v, bits)  _mm512_rol_epi32(v, bits)
+#define V_CH(w,x,y)     _mm512_ternarylogic_epi32(w, x, y, 0xCA)
+#define V_PARITY(w,x,y) _mm512_ternarylogic_epi32(w, x, y, 0x96)
+#define V_MAJ(w,x,y)    _mm512_ternarylogic_epi32(w, x, y, 0xE8)
+#include "sha1_simd.h"
+#undef SHA1X_NAME
+#undef SHA1X_BLOCK
+#undef SHA1X_TARGET
+#undef SHA1X_LANES
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_SET1
+#undef V_ADD
+#undef V_AND
+#undef V_XOR
+#undef V_ROL
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+
+#endif
+
+typedef struct
+{
+	sha1_kernel kernel;
+	// cpu feature the kernel needs, NULL if none
+	const char *feature;
+} sha1_kernel_entry;
+
+static const sha1_kernel_entry kernel_list[] = {
+	{ { "scalar", 1, sha1_scalar }, NULL },
+#ifdef SHA1_X86
+	{ { "sse2", 4, sha1_sse2 }, "sse2" },
+	{ { "avx2", 8, sha1_avx2 }, "avx2" },
+	{ { "avx512", 16, sha1_avx512 }, "avx512f" },
+#endif
+};
+
+static int kernel_supported(const sha1_kernel_entry *entry)
+{
+	if (entry->feature == NULL)
+		return 1;
+#ifdef SHA1_X86
+	// __builtin_cpu_supports only takes a string literal
+	if (strcmp(entry->feature, "sse2") == 0)
+		return __builtin_cpu_supports("sse2");
+	if (strcmp(entry->feature, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+	if (strcmp(entry->feature, "avx512f") == 0)
+		return __builtin_cpu_supports("avx512f");
+#endif
+	return 0;
+}
+
+int sha1_pad_message(u32 *words, int stride, u8 *buf, int len)
+{
+	int blocks = SHA1_BLOCKS(len);
+	int used = (len >> 2) + 1;
+	int i;
+
+	/* Only the words holding the message and the 0x80 come from the buffer */
+	buf[len]=0x80;
+	for(i=len+1; i<used*4; i++) {
+	  buf[i]=0x00;
+	}
+
+	for(i=0; i<used; i++) {
+	  words[i*stride] = (buf[i*4]<<24) | (buf[i*4+1]<<16) | (buf[i*4+2]<<8) | buf[i*4+3];
+	}
+	for(; i<blocks*16; i++) {
+	  words[i*stride] = 0;
+	}
+
+	/* 64 bit big endian bit count at the end of the last block */
+	words[((blocks*16)-2)*stride] = ((u32) len) >> 29;
+	words[((blocks*16)-1)*stride] = ((u32) len) << 3;
+
+	return blocks;
+}
+
+u32 fastSHA1(const u8 *buffer, int len)
+{
+	u8 *buf;
+	u32 *words;
+	u32 out;
+	int blocks;
+
+	blocks = SHA1_BLOCKS(len);
+	buf = malloc(blocks * 64);
+	words = malloc(blocks * 64);
+	memcpy(buf, buffer, len);
+	sha1_pad_message(words, 1, buf, len);
+	sha1_scalar(words, blocks, &out);
+	free(words);
+	free(buf);
+
+	return out;
+}
+
+int sha1_get_kernels(const sha1_kernel **kernels, int max)
+{
+	int count = 0;
+	int i;
+
+#ifdef SHA1_X86
+	__builtin_cpu_init();
+#endif
+	for (i = 0; i < (int) (sizeof(kernel_list) / sizeof(kernel_list[0])); i++) {
+		if ((count < max) && kernel_supported(&kernel_list[i]))
+			kernels[count++] = &kernel_list[i].kernel;
+	}
+
+	return count;
+}
+
+const sha1_kernel *sha1_find_kernel(const char *name)
+{
+	const sha1_kernel *kernels[sizeof(kernel_list) / sizeof(kernel_list[0])];
+	int count;
+	int i;
+
+	count = sha1_get_kernels(kernels, sizeof(kernels) / sizeof(kernels[0]));
+	if (name == NULL)
+		return kernels[count - 1];
+
+	for (i = 0; i < count; i++) {
+		if (strcmp(kernels[i]->name, name) == 0)
+			return kernels[i];
+	}
+
+	return NULL;
+}
@@ -0,0 +1,48 @@
+/*
+SHA1 dictionary attack program v2.0 (c) 2005 adresd
+
+Multi-buffer SHA1 kernels, these hash several candidates per call
+using whatever SIMD instruction set the cpu has.
+
+No License, public domain, do as you want, no warranties
+*/
+
+#ifndef __SHA1_H__
+#define __SHA1_H__
+
+#include "types.h"
+
+// Number of 64 byte blocks a message of len bytes pads out to
+#define SHA1_BLOCKS(len)	((((len) + 8) / 64) + 1)
+
+// The most candidates any kernel hashes in one call
+#define SHA1_MAX_LANES		16
+
+// Hash a batch of padded messages which are all the same number of blocks.
+// Word i of lane l is at words[i*lanes + l], counting on through the later
+// blocks, and out[l] gets the nid of the lane, ie the first 4 bytes of the
+// digest read as a little endian value.
+typedef void (*sha1_kernel_fn)(const u32 *words, int blocks, u32 *out);
+
+typedef struct
+{
+	const char *name;
+	int lanes;
+	sha1_kernel_fn hash;
+} sha1_kernel;
+
+// Pad the message at the start of buf out to SHA1_BLOCKS(len) blocks, writing
+// word i to words[i*stride]. buf holds SHA1_BLOCKS(len)*64 bytes, the bytes
+// after the message may be overwritten. Returns the number of blocks.
+int sha1_pad_message(u32 *words, int stride, u8 *buf, int len);
+
+// Hash a single message of any length with the scalar kernel.
+u32 fastSHA1(const u8 *buffer, int len);
+
+// Get the kernels this cpu can run, fastest last. The scalar kernel is always first.
+int sha1_get_kernels(const sha1_kernel **kernels, int max);
+
+// Get the fastest kernel, or the named one if name is not NULL.
+const sha1_kernel *sha1_find_kernel(const char *name);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+SHA1 dictionary attack program v2.0 (c) 2005 adresd
+
+Body of a multi-buffer SHA1 kernel, included by sha1.c once for each
+instruction set. The includer defines:
+
+  SHA1X_NAME      name of the function
+  SHA1X_BLOCK     name of the function hashing a single block
+  SHA1X_TARGET    function attributes enabling the instruction set
+  SHA1X_LANES     number of 32 bit lanes in a vector
+  V               the vector type
+  V_LOAD(p)       aligned load, V_STORE(p, v) aligned store
+  V_SET1(x)       broadcast a constant
+  V_ADD, V_AND, V_XOR, V_ROL(v, bits)
+  V_CH, V_PARITY, V_MAJ   the three SHA1 round functions
+
+No License, public domain, do as you want, no warranties
+*/
+
+#define XBLK(i) (block[(i)&15] = V_ROL(V_XOR(V_XOR(block[((i)+13)&15], block[((i)+8)&15]), \
+    V_XOR(block[((i)+2)&15], block[(i)&15])), 1))
+
+#define XR(f,k,v,w,x,y,z,blk) z=V_ADD(V_ADD(z,f(w,x,y)),V_ADD(V_ADD(blk,k),V_ROL(v,5)));w=V_ROL(w,30);
+#define XR0(v,w,x,y,z,i) XR(V_CH,k0,v,w,x,y,z,block[i])
+#define XR1(v,w,x,y,z,i) XR(V_CH,k0,v,w,x,y,z,XBLK(i))
+#define XR2(v,w,x,y,z,i) XR(V_PARITY,k1,v,w,x,y,z,XBLK(i))
+#define XR3(v,w,x,y,z,i) XR(V_MAJ,k2,v,w,x,y,z,XBLK(i))
+#define XR4(v,w,x,y,z,i) XR(V_PARITY,k3,v,w,x,y,z,XBLK(i))
+
+static SHA1X_TARGET void SHA1X_BLOCK(V *state, const u32 *words)
+{
+    V block[16];
+    V a, b, c, d, e;
+    V k0, k1, k2, k3;
+    int i;
+
+    for(i=0; i<16; i++) {
+      block[i]=V_LOAD(words+(i*SHA1X_LANES));
+    }
+
+    k0 = V_SET1(0x5A827999);
+    k1 = V_SET1(0x6ED9EBA1);
+    k2 = V_SET1(0x8F1BBCDC);
+    k3 = V_SET1(0xCA62C1D6);
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    /* 4 rounds of 20 operations each. Loop unrolled. */
+    XR0(a,b,c,d,e, 0); XR0(e,a,b,c,d, 1); XR0(d,e,a,b,c, 2); XR0(c,d,e,a,b, 3);
+    XR0(b,c,d,e,a, 4); XR0(a,b,c,d,e, 5); XR0(e,a,b,c,d, 6); XR0(d,e,a,b,c, 7);
+    XR0(c,d,e,a,b, 8); XR0(b,c,d,e,a, 9); XR0(a,b,c,d,e,10); XR0(e,a,b,c,d,11);
+    XR0(d,e,a,b,c,12); XR0(c,d,e,a,b,13); XR0(b,c,d,e,a,14); XR0(a,b,c,d,e,15);
+    XR1(e,a,b,c,d,16); XR1(d,e,a,b,c,17); XR1(c,d,e,a,b,18); XR1(b,c,d,e,a,19);
+    XR2(a,b,c,d,e,20); XR2(e,a,b,c,d,21); XR2(d,e,a,b,c,22); XR2(c,d,e,a,b,23);
+    XR2(b,c,d,e,a,24); XR2(a,b,c,d,e,25); XR2(e,a,b,c,d,26); XR2(d,e,a,b,c,27);
+    XR2(c,d,e,a,b,28); XR2(b,c,d,e,a,29); XR2(a,b,c,d,e,30); XR2(e,a,b,c,d,31);
+    XR2(d,e,a,b,c,32); XR2(c,d,e,a,b,33); XR2(b,c,d,e,a,34); XR2(a,b,c,d,e,35);
+    XR2(e,a,b,c,d,36); XR2(d,e,a,b,c,37); XR2(c,d,e,a,b,38); XR2(b,c,d,e,a,39);
+    XR3(a,b,c,d,e,40); XR3(e,a,b,c,d,41); XR3(d,e,a,b,c,42); XR3(c,d,e,a,b,43);
+    XR3(b,c,d,e,a,44); XR3(a,b,c,d,e,45); XR3(e,a,b,c,d,46); XR3(d,e,a,b,c,47);
+    XR3(c,d,e,a,b,48); XR3(b,c,d,e,a,49); XR3(a,b,c,d,e,50); XR3(e,a,b,c,d,51);
+    XR3(d,e,a,b,c,52); XR3(c,d,e,a,b,53); XR3(b,c,d,e,a,54); XR3(a,b,c,d,e,55);
+    XR3(e,a,b,c,d,56); XR3(d,e,a,b,c,57); XR3(c,d,e,a,b,58); XR3(b,c,d,e,a,59);
+    XR4(a,b,c,d,e,60); XR4(e,a,b,c,d,61); XR4(d,e,a,b,c,62); XR4(c,d,e,a,b,63);
+    XR4(b,c,d,e,a,64); XR4(a,b,c,d,e,65); XR4(e,a,b,c,d,66); XR4(d,e,a,b,c,67);
+    XR4(c,d,e,a,b,68); XR4(b,c,d,e,a,69); XR4(a,b,c,d,e,70); XR4(e,a,b,c,d,71);
+    XR4(d,e,a,b,c,72); XR4(c,d,e,a,b,73); XR4(b,c,d,e,a,74); XR4(a,b,c,d,e,75);
+    XR4(e,a,b,c,d,76); XR4(d,e,a,b,c,77); XR4(c,d,e,a,b,78); XR4(b,c,d,e,a,79);
+
+    state[0] = V_ADD(state[0], a);
+    state[1] = V_ADD(state[1], b);
+    state[2] = V_ADD(state[2], c);
+    state[3] = V_ADD(state[3], d);
+    state[4] = V_ADD(state[4], e);
+}
+
+static SHA1X_TARGET void SHA1X_NAME(const u32 *words, int blocks, u32 *out)
+{
+    V state[5];
+    V h0;
+
+    state[0] = V_SET1(0x67452301);
+    state[1] = V_SET1(0xEFCDAB89);
+    state[2] = V_SET1(0x98BADCFE);
+    state[3] = V_SET1(0x10325476);
+    state[4] = V_SET1(0xC3D2E1F0);
+
+    for(; blocks>0; blocks--, words+=(16*SHA1X_LANES)) {
+      SHA1X_BLOCK(state, words);
+    }
+
+    /* Only the first word is wanted, byte swapped into a nid */
+    h0 = state[0];
+    h0 = V_XOR(V_ROL(V_AND(h0, V_SET1(0x00FF00FF)), 24), V_ROL(V_AND(h0, V_SET1(0xFF00FF00)), 8));
+    V_STORE(out, h0);
+}
+
+#undef XBLK
+#undef XR
+#undef XR0
+#undef XR1
+#undef XR2
+#undef XR3
+#undef XR4
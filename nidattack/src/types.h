@@ -0,0 +1,18 @@
+/*
+SHA1 dictionary attack program v2.0 (c) 2005 adresd
+
+No License, public domain, do as you want, no warranties
+*/
+
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+typedef char s8;
+typedef short s16;
+typedef int s32;
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+#endif
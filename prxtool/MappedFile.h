@@ -0,0 +1,47 @@
+/***************************************************************
+ * PRXTool : Utility for PSP executables.
+ * (c) TyRaNiD 2k5
+ *
+ * MappedFile.h - Definition of a class to map a file read only
+ * into memory.
+ ***************************************************************/
+
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include "types.h"
+
+/** Read only view of a whole file, uses mmap where available and
+ *  falls back to reading the file into a heap buffer */
+class CMappedFile
+{
+	u8 *m_pData;
+	u32 m_iSize;
+	bool m_blMapped;
+	/* Descriptor kept open while mapped so ranges can be mapped again */
+	int m_iFd;
+
+	/* Not copyable, the view is owned by a single object */
+	CMappedFile(const CMappedFile &);
+	CMappedFile &operator=(const CMappedFile &);
+public:
+	CMappedFile();
+	~CMappedFile();
+	/** Map a file, any previously mapped file is closed. If blMap is false the file is always read */
+	bool Open(const char *szFilename, bool blMap = true);
+	/** Release the view */
+	void Close();
+	/** Get a pointer to the file data, NULL if not open */
+	const u8 *GetData() const;
+	/** Get the size of the file data */
+	u32 GetSize() const;
+	/** Indicates the data is a real mapping rather than a heap copy */
+	bool IsMapped() const;
+	/** Map part of the file copy-on-write at pDest, replacing whatever was mapped there.
+	 *  pDest, iOffset and iSize must be multiples of the page size */
+	bool MapCopy(u8 *pDest, u32 iOffset, u32 iSize) const;
+	/** Get the size of a page, 0 if pages cannot be mapped */
+	static u32 GetPageSize();
+};
+
+#endif
@@ -0,0 +1,105 @@
+/***************************************************************
+ * PRXTool : Utility for PSP executables.
+ * (c) TyRaNiD 2k5
+ *
+ * NidCache.h - Definition of the precompiled binary NID
+ * database format and a class to query it.
+ ***************************************************************/
+
+#ifndef __NIDCACHE_H__
+#define __NIDCACHE_H__
+
+#include <stdio.h>
+#include "types.h"
+#include "MappedFile.h"
+
+struct LibraryEntry;
+
+/* The layout is mirrored by pspdis/src/nidCache.h, keep the two in step */
+#define NIDCACHE_MAGIC    "PNDB"
+#define NIDCACHE_VERSION  2
+/* Extension appended to an XML filename to find its cache */
+#define NIDCACHE_EXT      ".ndb"
+
+/* The database contains a master NID table which overrides library names */
+#define NIDCACHE_FLAG_MASTER 1
+/* Set in the name field of a NID entry for variables */
+#define NIDCACHE_NAME_VAR    0x80000000
+
+/* All fields are little endian, offsets are relative to the start of the file */
+struct NidCacheHeader
+{
+	char magic[4];
+	u32 version;
+	u32 flags;
+	/* Size and modification time of the XML file this was built from */
+	u32 xmlsize;
+	u32 xmltime_lo;
+	u32 xmltime_hi;
+	/* Table of NidCacheLib, one per XML library, sorted by name. Libraries
+	 * with the same name stay in the order they appear in the XML */
+	u32 libcount;
+	u32 libofs;
+	/* Table of NidCacheNid, sorted by nid within each library. Duplicate
+	 * nids are all kept, in XML order with functions before variables */
+	u32 nidcount;
+	u32 nidofs;
+	/* String pool */
+	u32 strsize;
+	u32 strofs;
+};
+
+struct NidCacheLib
+{
+	/* Offsets into the string pool */
+	u32 name;
+	u32 prx_name;
+	u32 prx;
+	u32 flags;
+	/* Index of the first NID and the number of NIDs for this library */
+	u32 nidstart;
+	u32 nidcount;
+	u32 fcount;
+	u32 vcount;
+};
+
+struct NidCacheNid
+{
+	u32 nid;
+	/* Offset into the string pool, top bit indicates a variable */
+	u32 name;
+};
+
+/** Class to map a binary NID database and query it in place */
+class CNidCache
+{
+	CMappedFile m_file;
+	const NidCacheHeader *m_pHeader;
+	const NidCacheLib *m_pLibs;
+	const NidCacheNid *m_pNids;
+	const char *m_pStrings;
+	u32 m_iLibCount;
+	u32 m_iStrSize;
+	s32 m_iMasterLib;
+
+	bool Validate();
+	bool FindLibRange(const char *lib, u32 &iStart, u32 &iEnd) const;
+	const char *FindNidInLib(u32 iLib, u32 nid) const;
+	const char *GetString(u32 ofs) const;
+public:
+	CNidCache();
+	~CNidCache();
+	/** Map a cache file. If szXml is set the cache is rejected when it is older than the XML */
+	bool Open(const char *szFilename, const char *szXml);
+	void Close();
+	/** Find the name of a nid in a library, NULL if not present */
+	const char *FindName(const char *lib, u32 nid) const;
+	/** Find the filename of the module containing a library */
+	const char *FindDependancy(const char *lib) const;
+	/** Check whether a file starts with the cache magic */
+	static bool IsCacheFile(const char *szFilename);
+	/** Write a cache for a library list, as loaded from szXml */
+	static bool Compile(LibraryEntry *pHead, LibraryEntry *pMaster, const char *szXml, FILE *fp);
+};
+
+#endif
@@ -0,0 +1,72 @@
+/***************************************************************
+ * PRXTool : Utility for PSP executables.
+ * (c) TyRaNiD 2k5
+ *
+ * NidIndex.h - Definition of a hashed (library, nid) to name
+ * index with interned library names.
+ ***************************************************************/
+
+#ifndef __NIDINDEX_H__
+#define __NIDINDEX_H__
+
+#include "types.h"
+#include <vector>
+
+/** Returned by FindLib when the library name is not interned */
+#define NID_INDEX_NOLIB 0xFFFFFFFF
+
+/** Single slot of the open addressed nid table, empty when name is NULL */
+struct NidSlot
+{
+	u32 nid;
+	u32 lib;
+	const char *name;
+};
+
+/** Open addressed hash index mapping (library, nid) pairs to symbol names */
+class CNidIndex
+{
+	/** Table of nid slots, size is always a power of 2 */
+	std::vector<NidSlot> m_nids;
+	/** Number of used nid slots */
+	u32 m_iNidCount;
+	/** Table of library slots, holds the library id + 1 or 0 if empty */
+	std::vector<u32> m_libSlots;
+	/** Interned library names indexed by library id */
+	std::vector<const char *> m_libNames;
+	/** Library specific data indexed by library id */
+	std::vector<const void *> m_libData;
+	/** Chunks of memory backing the interned strings */
+	std::vector<char *> m_pool;
+	/** Next free byte in the current pool chunk */
+	char *m_pPoolPos;
+	/** Free space left in the current pool chunk */
+	u32 m_iPoolFree;
+
+	static u32 HashString(const char *str);
+	static u32 HashNid(u32 lib, u32 nid);
+	const char *InternString(const char *str);
+	void GrowNids();
+	void GrowLibs();
+public:
+	CNidIndex();
+	~CNidIndex();
+	/** Remove all entries and release the string pool */
+	void Clear();
+	/** Make room for at least iCount nids without rehashing */
+	void Reserve(u32 iCount);
+	/** Intern a library name, returns its id. pData is only set on first insertion */
+	u32 AddLib(const char *lib, const void *pData);
+	/** Find the id of an interned library, NID_INDEX_NOLIB if not present */
+	u32 FindLib(const char *lib) const;
+	/** Get the data associated with a library id */
+	const void *GetLibData(u32 lib) const;
+	/** Insert a nid, the first name inserted for a (lib, nid) pair wins */
+	bool AddNid(u32 lib, u32 nid, const char *name);
+	/** Find the name of a nid, NULL if not present */
+	const char *FindNid(u32 lib, u32 nid) const;
+	/** Get the number of nids in the index */
+	u32 GetNidCount() const;
+};
+
+#endif
@@ -10,6 +10,8 @@
 #define __NIDMGR_H__
 
 #include "types.h"
+#include "NidIndex.h"
+#include "NidCache.h"
 #include <tinyxml/tinyxml.h>
 #include <vector>
 
@@ -20,6 +22,9 @@
 #define FUNCTION_ARGS_MAX   128
 #define FUNCTION_RET_MAX    64
 
+/* Name of the library which maps NIDs regardless of the library name */
+#define MASTER_NID_MAPPER "MasterNidMapper"
+
 struct LibraryEntry;
 
 /** Structure to hold a single library nid */
@@ -73,15 +78,20 @@ class CNidMgr
 	LibraryEntry *m_pLibHead;
 	/** Mapping of function names to prototypes */
 	FunctionVect  m_funcMap;
-	/** A buffer to store a pre-generated symbol name so it can be passed to the caller */
-	char m_szCurrName[LIB_SYMBOL_NAME_MAX];
 	/** Indicator that we have loaded a master NID file */
 	LibraryEntry *m_pMasterNids;
-	/** Generate a name */
+	/** Hashed index of the loaded libraries, rebuilt after each XML file */
+	CNidIndex m_index;
+	/** Hashed index of the builtin system library names */
+	CNidIndex m_sysIndex;
+	/** Mapped binary NID databases, searched after the XML libraries */
+	std::vector<CNidCache *> m_caches;
+	/** Generate a name, the result is only valid until the next call on the same thread */
 	const char *GenName(const char *lib, u32 nid);
 	/** Search the loaded libs for a symbol */
 	const char *SearchLibs(const char *lib, u32 nid);
 	void FreeMemory();
+	void BuildIndex();
 	const char* ReadNid(TiXmlElement *pElement, u32 &nid);
 	int CountNids(TiXmlElement *pElement, const char *name);
 	void ProcessLibrary(TiXmlElement *pLibrary, const char *prx_name, const char *prx);
@@ -92,7 +102,9 @@ public:
 	const char *FindLibName(const char *lib, u32 nid);
 	const char *FindDependancy(const char *lib);
 	bool AddXmlFile(const char *szFilename);
+	bool AddNidFile(const char *szFilename);
 	LibraryEntry *GetLibraries(void);
+	LibraryEntry *GetMasterLibrary(void);
 	bool AddFunctionFile(const char *szFilename);
 	FunctionType *FindFunctionType(const char *name);
 };
@@ -10,6 +10,7 @@
 
 #include "types.h"
 #include "elftypes.h"
+#include "MappedFile.h"
 
 class CProcessElf
 {
@@ -21,6 +22,14 @@ protected:
 	u32 m_iBinSize;
 	bool m_blElfLoaded;
 
+	/* Read only view of the file, m_pElf points into it */
+	CMappedFile m_file;
+	/* Anonymous mapping holding the binary image, NULL if it is on the heap */
+	u8 *m_pBinMap;
+	u32 m_iBinMapSize;
+	/* Indicates files and images should be mapped rather than copied */
+	static bool m_blUseMmap;
+
 	char m_szFilename[MAXPATH];
 
 	/* List of sections */
@@ -48,9 +57,12 @@ protected:
 	void ElfLoadHeader(const Elf32_Ehdr* pHeader);
 	bool ElfValidateHeader();
 	void ElfDumpHeader();
+	bool AllocBinaryImage(u32 iSize, u32 iAlignOfs);
+	void CopyToImage(u32 iImgOfs, u32 iFileOfs, u32 iSize);
+	void FreeBinaryImage();
 	bool BuildBinaryImage();
 	bool BuildFakeSections(unsigned int dwDataBase);
-	u8* LoadFileToMem(const char *szFilename, u32 &lSize);
+	bool LoadFileToMem(const char *szFilename, u32 iMinSize);
 	bool LoadPrograms();
 	bool FillSection(ElfSection& elfSect, const Elf32_Shdr *pSection);
 	void ElfDumpSections();
@@ -82,6 +94,8 @@ public:
 	ElfSection* ElfGetSections(u32 &iSHCount);
 	/** Get the file name of the loaded elf */
 	const char* GetElfName();
+	/** Select whether files are mapped (the default) or read into memory */
+	static void SetUseMmap(bool blUse);
 };
 
 #endif
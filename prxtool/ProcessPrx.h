@@ -26,11 +26,15 @@ class CProcessPrx : public CProcessElf
 	ElfReloc  *m_pElfRelocs;
 	/* Number of relocations */
 	int m_iRelocCount;
-	ImmMap m_imms;
-	SymbolMap m_syms;
+	CImmIndex m_imms;
+	CSymbolIndex m_syms;
 	u32 m_dwBase;
 	u32 m_stubBottom;
 	bool m_blXmlDump;
+	/* Print the time taken by each phase of BuildMaps */
+	static bool m_blTiming;
+	/* Disassembler options and symbols for the current dump */
+	DisasmContext m_disctx;
 
 	bool FillModule(u8 *pData, u32 iAddr);
 	bool CreateFakeSections();
@@ -44,21 +48,19 @@ class CProcessPrx : public CProcessElf
 	int  LoadRelocsTypeB(struct ElfReloc *pRelocs);
 	bool LoadRelocs();
 	bool BuildMaps();
-	void BuildSymbols(SymbolMap &syms, u32 dwBase);
-	void FreeSymbols(SymbolMap &syms);
-	void FreeImms(ImmMap &imms);
-	void FixupRelocs(u32 dwBase, ImmMap &imms);
+	void BuildSymbols(CSymbolIndex &syms, u32 dwBase);
+	void FixupRelocs(u32 dwBase, CImmIndex &imms);
 	bool ReadString(u32 dwAddr, std::string &str, bool unicode, u32 *dwRet);
 	void DumpStrings(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData);
 	void PrintRow(FILE *fp, const u32* row, s32 row_size, u32 addr);
 	void DumpData(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData);
-	void Disasm(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData, ImmMap &imms, u32 dwBase);
-	void DisasmXML(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData, ImmMap &imms, u32 dwBase);
+	void Disasm(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData, const CImmIndex &imms, u32 dwBase);
+	void DisasmXML(FILE *fp, u32 dwAddr, u32 iSize, unsigned char *pData, const CImmIndex &imms, u32 dwBase);
 	void CalcElfSize(size_t &iTotal, size_t &iSectCount, size_t &iStrSize);
 	bool OutputElfHeader(FILE *fp, size_t iSectCount);
 	bool OutputSections(FILE *fp, size_t iElfHeadSize, size_t iSectCount, size_t iStrSize);
-	int  FindFuncExtent(u32 dwStart, u8 *pTouchMap);
-	void MapFuncExtents(SymbolMap &syms);
+	int  FindFuncExtent(u32 dwStart);
+	void MapFuncExtents(CSymbolIndex &syms);
 public:
 	CProcessPrx(u32 dwBase);
 	virtual ~CProcessPrx();
@@ -68,6 +70,8 @@ public:
 	bool PrxToElf(FILE *fp);
 
 	void SetXmlDump();
+	/** Select whether the time taken to build the symbol maps is printed */
+	static void SetTiming(bool blTiming);
 	PspModule* GetModuleInfo();
 	ElfReloc* GetRelocs(int &iCount);
 	ElfSymbol* GetSymbols(int &iCount);
@@ -77,6 +81,8 @@ public:
 	void Dump(FILE *fp, const char *disopts);
 	void DumpXML(FILE *fp, const char *disopts);
 	SymbolEntry *GetSymbolEntryFromAddr(u32 dwAddr);
+	/** Find the function containing an address, dwEnd receives the end of its extent */
+	SymbolEntry *GetFunctionFromAddr(u32 dwAddr, u32 &dwEnd);
 };
 
 #endif
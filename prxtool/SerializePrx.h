@@ -62,6 +62,9 @@ public:
 	virtual ~CSerializePrx();
 	bool Begin();
 	bool SerializePrx(CProcessPrx &prx, u32 iSMask);
+	/** Serialize a prx without starting or ending the file, used when the
+	 *  output is assembled from parts written by separate serializers */
+	bool SerializeFragment(CProcessPrx &prx, u32 iSMask);
 	bool End();
 };
 
@@ -0,0 +1,137 @@
+/***************************************************************
+ * PRXTool : Utility for PSP executables.
+ * (c) TyRaNiD 2k5
+ *
+ * SymbolIndex.h - Definition of flat address indexes for
+ * symbols and relocated immediates.
+ ***************************************************************/
+
+#ifndef __SYMBOLINDEX_H__
+#define __SYMBOLINDEX_H__
+
+#include <string>
+#include <vector>
+#include "prxtypes.h"
+
+enum SymbolType
+{
+	SYMBOL_NOSYM = 0,
+	SYMBOL_UNK,
+	SYMBOL_FUNC,
+	SYMBOL_LOCAL,
+	SYMBOL_DATA,
+};
+
+typedef std::vector<unsigned int> RefMap;
+typedef std::vector<std::string> AliasMap;
+
+struct SymbolEntry
+{
+	unsigned int addr;
+	SymbolType type;
+	unsigned int size;
+	std::string name;
+	RefMap refs;
+	AliasMap alias;
+	std::vector<PspLibExport *> exported;
+	std::vector<PspLibImport *> imported;
+};
+
+struct ImmEntry
+{
+	unsigned int addr;
+	unsigned int target;
+	/* Does this entry point to a text section ? */
+	int text;
+};
+
+/** Node of the search tree, the address and its position in sorted order */
+struct AddrNode
+{
+	u32 addr;
+	u32 pos;
+};
+
+/** Sorted address search laid out in Eytzinger (breadth first) order,
+ *  so the top levels of every search share the same few cache lines */
+class CAddrSearch
+{
+	/** Tree nodes, m_nodes[0] is unused and the children of n are 2n and 2n+1 */
+	std::vector<AddrNode> m_nodes;
+
+	void Fill(const u32 *pAddrs, u32 &iPos, u32 iNode);
+public:
+	/** Build the tree from a sorted list of addresses */
+	void Build(const u32 *pAddrs, u32 iCount);
+	void Clear();
+	/** Find the position of the first address >= addr, the address count if none */
+	u32 LowerBound(u32 addr) const;
+};
+
+/** Address index of symbols. Symbols are added to a hash table while the maps
+ *  are built, Build then sorts them into a flat array for searching and walking */
+class CSymbolIndex
+{
+	/** Symbols sorted by address, valid once built */
+	std::vector<SymbolEntry *> m_syms;
+	/** Search tree over m_syms */
+	CAddrSearch m_search;
+	/** Open addressed table keyed on the symbol address, used until built */
+	std::vector<SymbolEntry *> m_slots;
+	/** Number of used slots */
+	u32 m_iSlotCount;
+	bool m_blBuilt;
+
+	SymbolEntry **FindSlot(u32 addr);
+	void Grow();
+	void Unbuild();
+
+	/* Not copyable, the index owns its symbols */
+	CSymbolIndex(const CSymbolIndex &);
+	CSymbolIndex &operator=(const CSymbolIndex &);
+public:
+	CSymbolIndex();
+	~CSymbolIndex();
+	/** Delete all the symbols */
+	void Clear();
+	/** Add a symbol, any symbol already at the same address is deleted */
+	void Add(SymbolEntry *s);
+	/** Sort the symbols for searching once they have all been added */
+	void Build();
+	/** Find the symbol at an address, NULL if there is none */
+	SymbolEntry *Find(u32 addr) const;
+	/** Get the number of symbols, only valid once built */
+	u32 GetCount() const;
+	/** Get a symbol by its position in address order */
+	SymbolEntry *Get(u32 iPos) const;
+	/** Get the position of the first symbol at or above addr, GetCount() if none */
+	u32 LowerBound(u32 addr) const;
+	/** Find the function containing addr. The extent ends at the function size if it
+	 *  is known, otherwise at the next function or dwLimit */
+	SymbolEntry *FindFunction(u32 addr, u32 dwLimit, u32 &dwEnd) const;
+};
+
+/** Address index of relocated immediates, sorted by the address of the instruction */
+class CImmIndex
+{
+	std::vector<ImmEntry> m_imms;
+	CAddrSearch m_search;
+	bool m_blBuilt;
+public:
+	CImmIndex();
+	void Clear();
+	/** Add an entry, a later entry for the same address replaces an earlier one */
+	void Add(const ImmEntry &imm);
+	/** Sort the entries for searching once they have all been added */
+	void Build();
+	/** Find the entry for an address, NULL if there is none */
+	const ImmEntry *Find(u32 addr) const;
+	/** Get the number of entries, only valid once built */
+	u32 GetCount() const;
+	/** Get an entry by its position in address order */
+	const ImmEntry *Get(u32 iPos) const;
+	/** Get the position of the first entry at or above addr, GetCount() if none */
+	u32 LowerBound(u32 addr) const;
+};
+
+#endif
@@ -7,46 +7,10 @@
 #ifndef __DISASM_H__
 #define __DISASM_H__
 
-#include <map>
 #include <string>
 #include <vector>
 #include "prxtypes.h"
-
-enum SymbolType
-{
-	SYMBOL_NOSYM = 0,
-	SYMBOL_UNK,
-	SYMBOL_FUNC,
-	SYMBOL_LOCAL,
-	SYMBOL_DATA,
-};
-
-typedef std::vector<unsigned int> RefMap;
-typedef std::vector<std::string> AliasMap;
-
-struct SymbolEntry
-{
-	unsigned int addr;
-	SymbolType type;
-	unsigned int size;
-	std::string name;
-	RefMap refs;
-	AliasMap alias;
-	std::vector<PspLibExport *> exported;
-	std::vector<PspLibImport *> imported;
-};
-
-typedef std::map<unsigned int, SymbolEntry*> SymbolMap;
-
-struct ImmEntry
-{
-	unsigned int addr;
-	unsigned int target;
-	/* Does this entry point to a text section ? */
-	int text;
-};
-
-typedef std::map<unsigned int, ImmEntry *> ImmMap;
+#include "SymbolIndex.h"
 
 #define DISASM_OPT_MAX       8
 #define DISASM_OPT_HEXINTS   'x'
@@ -63,6 +27,104 @@ typedef std::map<unsigned int, ImmEntry *> ImmMap;
 #define INSTR_TYPE_JUMP   4
 #define INSTR_TYPE_JAL    8
 
+/* Size of the text buffers passed to the format functions */
+#define DISASM_TEXT_MAX      1024
+#define DISASM_MAX_OPERANDS  6
+/* Id of an opcode which is not in the instruction tables */
+#define DISASM_ID_UNKNOWN    -1
+/* Target of an instruction which is not a branch, or branches through a register */
+#define DISASM_NO_TARGET     0xFFFFFFFF
+
+/* Options and symbols for a disassembly, each thread should have its own */
+struct DisasmContext
+{
+	int hexints;
+	int mregs;
+	int symaddr;
+	int macroon;
+	int printreal;
+	int printregs;
+	int printswap;
+	int signedhex;
+	int xmloutput;
+	CSymbolIndex *syms;
+	/* CPU registers printed by the last format call, when printregs is set */
+	unsigned int regmask;
+};
+
+enum DisasmOperandType
+{
+	DISASM_OPERAND_GPR = 1,
+	DISASM_OPERAND_FPR,
+	DISASM_OPERAND_COP0,
+	/* FPU control register */
+	DISASM_OPERAND_COP1,
+	/* VFPU control register */
+	DISASM_OPERAND_COP2,
+	/* Numbered coprocessor register */
+	DISASM_OPERAND_COPREG,
+	DISASM_OPERAND_DEBUGREG,
+	/* VFPU register, sub is the size (s, p, t, q, m, n, o) */
+	DISASM_OPERAND_VFPUREG,
+	DISASM_OPERAND_IMM,
+	/* Memory reference, value is the offset from the base register */
+	DISASM_OPERAND_MEM,
+	/* Branch or jump target address */
+	DISASM_OPERAND_TARGET,
+	/* break and syscall code */
+	DISASM_OPERAND_CODE,
+	/* VFPU constant, half float, rotator, prefix or condition, value is the raw field */
+	DISASM_OPERAND_VFPUSPECIAL,
+};
+
+struct DisasmOperand
+{
+	/* One of DisasmOperandType */
+	char type;
+	/* Format code the operand was decoded from and its qualifier, see disasm.C */
+	char fmt;
+	char sub;
+	/* Register number, immediate or address */
+	int value;
+	/* Base register of a memory reference */
+	int base;
+};
+
+/* A decoded instruction, filled in by disasmDecode without any allocation or formatting */
+struct DisasmInst
+{
+	unsigned int opcode;
+	unsigned int PC;
+	/* Mnemonic id, DISASM_ID_UNKNOWN if the opcode is not recognised */
+	int id;
+	const char *name;
+	/* INSTR_TYPE flags */
+	int type;
+	/* Branch target or DISASM_NO_TARGET */
+	unsigned int target;
+	/* Masks of the CPU registers read and written */
+	unsigned int regread;
+	unsigned int regwrite;
+	int opcount;
+	DisasmOperand ops[DISASM_MAX_OPERANDS];
+};
+
+/* Clear a context, all options off and no symbols */
+void disasmContextInit(DisasmContext *ctx);
+/* Set or clear options, + and - in the string switch between the two */
+void disasmContextSetOpts(DisasmContext *ctx, const char *opts, int set);
+void disasmContextPrintOpts(DisasmContext *ctx);
+SymbolEntry* disasmContextFindSymbol(const DisasmContext *ctx, unsigned int PC);
+/* Decode an opcode, returns 0 if it is not recognised */
+int disasmDecode(const DisasmContext *ctx, unsigned int opcode, unsigned int PC, DisasmInst *inst);
+/* Format a decoded instruction into buf, returns buf */
+const char *disasmFormat(DisasmContext *ctx, const DisasmInst *inst, unsigned int *realregs, int noaddr, char *buf, int len);
+const char *disasmFormatXML(DisasmContext *ctx, const DisasmInst *inst, char *buf, int len);
+/* Get the mnemonic for an id, NULL if the id is invalid */
+const char *disasmGetName(int id);
+
+/* The functions below work on a default context private to the calling thread */
+
 /* Enable hexadecimal integers for immediates */
 void disasmSetHexInts(int hexints);
 /* Enable mnemonic MIPS registers */
@@ -78,11 +140,16 @@ void disasmPrintOpts(void);
 const char *disasmInstruction(unsigned int opcode, unsigned int PC, unsigned int *realregs, unsigned int *regmask, int noaddr);
 const char *disasmInstructionXML(unsigned int opcode, unsigned int PC);
 
-void disasmSetSymbols(SymbolMap *syms);
-void disasmAddBranchSymbols(unsigned int opcode, unsigned int PC, SymbolMap &syms);
+void disasmSetSymbols(CSymbolIndex *syms);
+void disasmAddBranchSymbols(unsigned int opcode, unsigned int PC, CSymbolIndex &syms);
 SymbolType disasmResolveSymbol(unsigned int PC, char *name, int namelen);
 SymbolEntry* disasmFindSymbol(unsigned int PC);
 int disasmIsBranch(unsigned int opcode, unsigned int PC, unsigned int *dwTarget);
+/* Check the decode tables pick the same entries as the previous linear search for every
+ * 32 bit opcode, returns the number of mismatches and the first one in pFirstBad */
+unsigned int disasmCheckDecoderAll(unsigned int *pFirstBad);
+/* Check the register masks of a few known opcodes, returns the number of mismatches */
+int disasmCheckRegs(void);
 void disasmSetXmlOutput();
 
 #endif
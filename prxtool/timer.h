@@ -0,0 +1,13 @@
+/***************************************************************
+ * PRXTool : Utility for PSP executables.
+ * (c) TyRaNiD 2k5
+ *
+ * timer.h - Wall clock time for the timing and benchmark modes
+ ***************************************************************/
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/* Get the current time in seconds */
+double get_time(void);
+
+#endif
@@ -159,4 +159,11 @@ inline void sh_be(u16 *data, u16 val)
 #define MAXPATH 256
 #endif
 
+/* Storage class for state which has to be private to each worker thread */
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL thread_local
+#endif
+
 #endif
@@ -0,0 +1,186 @@
+/*                          ____  _     
+#         ____  _________  / __ \(_)____
+#        / __ \/ ___/ __ \/ / / / / ___/
+#       / /_/ (__  ) /_/ / /_/ / (__  ) 
+#      / .___/____/ .___/_____/_/____/  
+#     /_/        /_/
+#     
+# Copyright 2005, pspdev - http://www.pspdev.org
+# File:         nidCache.cc
+# Description:  Read only access to a binary NID database as written
+#               by "prxtool --nidcache psplibdoc.xml".
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "nidCache.h"
+
+nidCache::nidCache() : data(NULL), dataSize(0), mapped(false), header(NULL),
+	libs(NULL), nids(NULL), strings(NULL), libCount(0), strSize(0) {
+}
+
+nidCache::~nidCache() {
+	close();
+}
+
+void nidCache::close() {
+	if (data) {
+		if (mapped)
+			munmap(data, dataSize);
+		else
+			free(data);
+	}
+	data = NULL;
+	dataSize = 0;
+	mapped = false;
+	header = NULL;
+	libs = NULL;
+	nids = NULL;
+	strings = NULL;
+	libCount = 0;
+	strSize = 0;
+}
+
+bool nidCache::open(std::string filename, std::string xmlFilename) {
+	struct stat st;
+	int fd;
+
+	close();
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(nidCacheHeader)) {
+		::close(fd);
+		return false;
+	}
+	dataSize = st.st_size;
+
+	data = (u8*)mmap(NULL, dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data != (u8*)MAP_FAILED) {
+		mapped = true;
+	} else {
+		// no mapping available, fall back to a plain read
+		data = (u8*)malloc(dataSize);
+		if (!data || read(fd, data, dataSize) != (ssize_t)dataSize) {
+			free(data);
+			data = NULL;
+		}
+	}
+	::close(fd);
+
+	if (!data || !validate()) {
+		close();
+		return false;
+	}
+
+	// a cache older than its XML is stale, if the XML is gone use the cache
+	if (stat(xmlFilename.c_str(), &st) == 0) {
+		unsigned long long mtime = (unsigned long long)st.st_mtime;
+		if (LW(header->xmlSize) != (u32)st.st_size || LW(header->xmlTimeLo) != (u32)mtime
+			|| LW(header->xmlTimeHi) != (u32)(mtime >> 32)) {
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool nidCache::validate() {
+	u32 i, nidCount, libOffset, nidOffset, strOffset;
+
+	header = (const nidCacheHeader*)data;
+	if (memcmp(header->magic, NIDCACHE_MAGIC, 4) != 0 || LW(header->version) != NIDCACHE_VERSION)
+		return false;
+	libCount = LW(header->libCount);
+	libOffset = LW(header->libOffset);
+	nidCount = LW(header->nidCount);
+	nidOffset = LW(header->nidOffset);
+	strSize = LW(header->strSize);
+	strOffset = LW(header->strOffset);
+	if (libOffset > dataSize || libCount > (dataSize - libOffset) / sizeof(nidCacheLib)
+		|| nidOffset > dataSize || nidCount > (dataSize - nidOffset) / sizeof(nidCacheNid)
+		|| strOffset > dataSize || strSize > dataSize - strOffset
+		|| strSize == 0 || data[strOffset + strSize - 1] != 0)
+		return false;
+
+	libs = (const nidCacheLib*)&data[libOffset];
+	nids = (const nidCacheNid*)&data[nidOffset];
+	strings = (const char*)&data[strOffset];
+
+	for (i = 0; i < libCount; i++) {
+		u32 start = LW(libs[i].nidStart);
+		if (LW(libs[i].name) >= strSize || start > nidCount || LW(libs[i].nidCount) > nidCount - start)
+			return false;
+	}
+	for (i = 0; i < nidCount; i++) {
+		if ((LW(nids[i].name) & ~NIDCACHE_NAME_VAR) >= strSize)
+			return false;
+	}
+	return true;
+}
+
+// find the entries for a library name, there is one per XML library
+bool nidCache::findLibs(const char *libName, u32 *first, u32 *last) const {
+	u32 low = 0, high = libCount;
+
+	while (low < high) {
+		u32 mid = (low + high) / 2;
+		if (strcmp(&strings[LW(libs[mid].name)], libName) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	*first = low;
+
+	high = libCount;
+	while (low < high) {
+		u32 mid = (low + high) / 2;
+		if (strcmp(&strings[LW(libs[mid].name)], libName) <= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	*last = low;
+
+	return *first < *last;
+}
+
+// the last entry for a nid in one library, as later ones overwrite earlier ones in the XML path
+const nidCacheNid *nidCache::findNid(u32 lib, u32 nid) const {
+	const nidCacheNid *libNids = &nids[LW(libs[lib].nidStart)];
+	u32 low = 0, high = LW(libs[lib].nidCount);
+
+	while (low < high) {
+		u32 mid = (low + high) / 2;
+		if (LW(libNids[mid].nid) <= nid)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low > 0 && LW(libNids[low - 1].nid) == nid)
+		return &libNids[low - 1];
+	return NULL;
+}
+
+const char *nidCache::resolveNid(const char *libName, u32 nid, bool *isVariable) const {
+	const nidCacheNid *entry = NULL;
+	u32 first, last;
+
+	if (!header || !findLibs(libName, &first, &last))
+		return NULL;
+
+	//later libraries of the same name win, like the XML path
+	while (last > first && !entry)
+		entry = findNid(--last, nid);
+	if (!entry)
+		return NULL;
+
+	if (isVariable)
+		*isVariable = (LW(entry->name) & NIDCACHE_NAME_VAR) != 0;
+	return &strings[LW(entry->name) & ~NIDCACHE_NAME_VAR];
+}
@@ -0,0 +1,90 @@
+/*                          ____  _     
+#         ____  _________  / __ \(_)____
+#        / __ \/ ___/ __ \/ / / / / ___/
+#       / /_/ (__  ) /_/ / /_/ / (__  ) 
+#      / .___/____/ .___/_____/_/____/  
+#     /_/        /_/
+#     
+# Copyright 2005, pspdev - http://www.pspdev.org
+# File:         nidCache.h
+# Description:  Read only access to a binary NID database as written
+#               by "prxtool --nidcache psplibdoc.xml". The layout must
+#               match prxtool/NidCache.h. Lookups give the same results
+#               as nidDb's XML path.
+*/
+#ifndef _NIDCACHE_H_
+#define _NIDCACHE_H_
+
+#include <string>
+#include "util.h"
+
+#define NIDCACHE_MAGIC		"PNDB"
+#define NIDCACHE_VERSION	2
+#define NIDCACHE_EXT		".ndb"
+// prxtool maps every nid through MasterNidMapper when this is set, the XML
+// path has no master table so it is ignored here
+#define NIDCACHE_FLAG_MASTER	1
+#define NIDCACHE_NAME_VAR	0x80000000
+
+// all fields little endian, offsets from the start of the file. There is
+// one library entry per XML library, sorted by name and otherwise in XML
+// order, and each library keeps all of its nids, sorted by nid and
+// otherwise in XML order
+typedef struct {
+	char magic[4];
+	u32 version;
+	u32 flags;
+	u32 xmlSize;
+	u32 xmlTimeLo;
+	u32 xmlTimeHi;
+	u32 libCount;
+	u32 libOffset;
+	u32 nidCount;
+	u32 nidOffset;
+	u32 strSize;
+	u32 strOffset;
+} nidCacheHeader;
+
+typedef struct {
+	u32 name;
+	u32 prxName;
+	u32 prx;
+	u32 flags;
+	u32 nidStart;
+	u32 nidCount;
+	u32 fCount;
+	u32 vCount;
+} nidCacheLib;
+
+typedef struct {
+	u32 nid;
+	u32 name;
+} nidCacheNid;
+
+class nidCache {
+public:
+	nidCache();
+	~nidCache();
+	bool open(std::string filename, std::string xmlFilename);
+	void close();
+	bool isOpen() const { return header != NULL; }
+	// returns NULL if the nid isn't in the database
+	const char *resolveNid(const char *libName, u32 nid, bool *isVariable) const;
+
+private:
+	bool validate();
+	bool findLibs(const char *libName, u32 *first, u32 *last) const;
+	const nidCacheNid *findNid(u32 lib, u32 nid) const;
+
+	u8 *data;
+	size_t dataSize;
+	bool mapped;
+	const nidCacheHeader *header;
+	const nidCacheLib *libs;
+	const nidCacheNid *nids;
+	const char *strings;
+	u32 libCount;
+	u32 strSize;
+};
+
+#endif
@@ -22,6 +22,10 @@ nidDb::~nidDb() {
 }
 
 const char* nidDb::resolveNid(char *libName, u32 nid) {
+	if (cache.isOpen()) {
+		const char *name = cache.resolveNid(libName, nid, NULL);
+		return name ? name : "";
+	}
 	return db[libName][nid].name.c_str();
 }
 
@@ -31,6 +35,13 @@ const char* nidDb::resolveNid(char *libName, char* txtNid) {
 }
 
 const nidType nidDb::getNidType(char *libName, u32 nid){
+	if (cache.isOpen()) {
+		bool isVariable = false;
+		//unknown nids default to a function, as they do in the map
+		if (cache.resolveNid(libName, nid, &isVariable) && isVariable)
+			return nidType_Variable;
+		return nidType_Function;
+	}
 	return db[libName][nid].type;
 }
 
@@ -39,7 +50,11 @@ const nidType nidDb::getNidType(char *libName, char* txtNid){
 	return getNidType(libName, nid);
 }
 
-bool nidDb::loadFromXml(std::string filename) {
+bool nidDb::loadFromXml(std::string filename, bool useCache) {
+	//use the precompiled database if there is an up to date one
+	if (useCache && cache.open(filename + NIDCACHE_EXT, filename))
+		return true;
+
 	TiXmlDocument doc(filename.c_str());
 
 	if(doc.LoadFile()) {
@@ -82,7 +97,6 @@ void nidDb::parseLibraryElement(TiXmlElement *elemLibrary) {
 	TiXmlElement *elemFunction;
 	TiXmlElement *elemVariable;
 	u32 nid;
-	nidInfo info;
 	
 	//get library name
 	libName = libHandle.FirstChild("NAME").FirstChild().Text();
@@ -95,7 +109,7 @@ void nidDb::parseLibraryElement(TiXmlElement *elemLibrary) {
 
 		//load Functions
 		while(elemFunction != NULL) {
-			//memset(&info, 0, sizeof(info));
+			nidInfo info;
 			nid = readNidInfo(elemFunction, info);
 			if(info.name.length() > 0) {
 				db[libName->Value()][nid] = info;
@@ -106,7 +120,7 @@ void nidDb::parseLibraryElement(TiXmlElement *elemLibrary) {
 		
 		//load Variables
 		while(elemVariable != NULL) {
-			//memset(&info, 0, sizeof(info));
+			nidInfo info;
 			nid = readNidInfo(elemVariable, info);
 			if(info.name.length() > 0) {
 				db[libName->Value()][nid] = info;
@@ -21,6 +21,7 @@
 #include <string>
 #include <tinyxml/tinyxml.h>
 #include "util.h"
+#include "nidCache.h"
 
 #define MAX_SYMBOL_LEN	128
 #define MAX_LIBNAME_LEN	64
@@ -47,7 +48,9 @@ class nidDb {
 public:
 	nidDb();
 	~nidDb();
-	bool loadFromXml(std::string filename);
+	// useCache=false always parses the XML, even if there is an up to date cache
+	bool loadFromXml(std::string filename, bool useCache = true);
+	bool isCached() const { return cache.isOpen(); }
 	const char *resolveNid(char* libName, u32 nid);
 	const char *resolveNid(char* libName, char* txtNid);
 	const nidType getNidType(char* libName, u32 nid);
@@ -58,6 +61,7 @@ private:
 	void parseLibraryElement(TiXmlElement *elemLibrary);
 	const u32 readNidInfo(TiXmlElement *elemNidEntry, nidInfo &entry);
 	libMap db;
+	nidCache cache;
 };
 
 #endif
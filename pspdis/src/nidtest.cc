@@ -0,0 +1,109 @@
+/*                          ____  _     
+#         ____  _________  / __ \(_)____
+#        / __ \/ ___/ __ \/ / / / / ___/
+#       / /_/ (__  ) /_/ / /_/ / (__  ) 
+#      / .___/____/ .___/_____/_/____/  
+#     /_/        /_/
+#     
+# Copyright 2005, pspdev - http://www.pspdev.org
+# File:         nidtest.cc
+# Description:  Loads a NID database from its XML and from the cache
+#               written by "prxtool --nidcache" and checks that every
+#               nid in the XML, and some that aren't, resolve the same
+#               way through both.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <tinyxml/tinyxml.h>
+#include "nidDb.h"
+
+typedef struct {
+	std::string libName;
+	u32 nid;
+} nidRef;
+
+static void collectNids(TiXmlElement *elem, const char *entryName, const char *libName, std::vector<nidRef> &refs) {
+	while (elem) {
+		TiXmlText *nidTxt = TiXmlHandle(elem).FirstChild("NID").FirstChild().Text();
+		if (nidTxt) {
+			nidRef ref;
+			ref.libName = libName;
+			ref.nid = strtoul(nidTxt->Value(), NULL, 16);
+			refs.push_back(ref);
+		}
+		elem = elem->NextSiblingElement(entryName);
+	}
+}
+
+// every library/nid pair in the XML, including entries the loaders skip
+static bool collectRefs(const char *filename, std::vector<nidRef> &refs) {
+	TiXmlDocument doc(filename);
+	TiXmlElement *elmPrxfile, *elmLibrary;
+
+	if (!doc.LoadFile())
+		return false;
+
+	elmPrxfile = TiXmlHandle(&doc).FirstChild("PSPLIBDOC").FirstChild("PRXFILES").FirstChild("PRXFILE").Element();
+	for (; elmPrxfile; elmPrxfile = elmPrxfile->NextSiblingElement("PRXFILE")) {
+		elmLibrary = TiXmlHandle(elmPrxfile).FirstChild("LIBRARIES").FirstChild("LIBRARY").Element();
+		for (; elmLibrary; elmLibrary = elmLibrary->NextSiblingElement("LIBRARY")) {
+			TiXmlHandle libHandle(elmLibrary);
+			TiXmlText *libName = libHandle.FirstChild("NAME").FirstChild().Text();
+			if (!libName)
+				continue;
+			collectNids(libHandle.FirstChild("FUNCTIONS").FirstChild("FUNCTION").Element(), "FUNCTION", libName->Value(), refs);
+			collectNids(libHandle.FirstChild("VARIABLES").FirstChild("VARIABLE").Element(), "VARIABLE", libName->Value(), refs);
+		}
+	}
+	return true;
+}
+
+static int compareNid(nidDb &xml, nidDb &cached, const std::string &libName, u32 nid) {
+	char lib[MAX_LIBNAME_LEN];
+	std::string xmlName, cachedName;
+	nidType xmlType, cachedType;
+
+	snprintf(lib, sizeof(lib), "%s", libName.c_str());
+	xmlName = xml.resolveNid(lib, nid);
+	cachedName = cached.resolveNid(lib, nid);
+	xmlType = xml.getNidType(lib, nid);
+	cachedType = cached.getNidType(lib, nid);
+	if (xmlName == cachedName && xmlType == cachedType)
+		return 0;
+
+	printf("%s 0x%08X: xml \"%s\" (%d), cache \"%s\" (%d)\n", lib, nid,
+		xmlName.c_str(), xmlType, cachedName.c_str(), cachedType);
+	return 1;
+}
+
+int main(int argc, char **argv) {
+	std::vector<nidRef> refs;
+	nidDb xml, cached;
+	int errors = 0, checked = 0;
+	size_t i;
+
+	if (argc != 2) {
+		printf("usage: %s psplibdoc.xml\n", argv[0]);
+		return 1;
+	}
+
+	if (!collectRefs(argv[1], refs) || !xml.loadFromXml(argv[1], false))
+		return 1;
+	if (!cached.loadFromXml(argv[1]) || !cached.isCached()) {
+		printf("no up to date cache for %s, run \"prxtool --nidcache %s\"\n", argv[1], argv[1]);
+		return 1;
+	}
+
+	for (i = 0; i < refs.size(); i++) {
+		//the nid itself, a nid that is probably missing and an unknown library
+		errors += compareNid(xml, cached, refs[i].libName, refs[i].nid);
+		errors += compareNid(xml, cached, refs[i].libName, ~refs[i].nid);
+		errors += compareNid(xml, cached, refs[i].libName + "_missing", refs[i].nid);
+		checked += 3;
+	}
+
+	printf("%d lookups, %d mismatches\n", checked, errors);
+	return errors ? 1 : 0;
+}
@@ -38,6 +38,13 @@ typedef uint32_t u32;
 
 void hexdump(const u8* data, size_t length);
 
+// read a little endian word whatever the host byte order and alignment
+static inline u32 lw_le(const void *ptr) {
+	const u8 *p = (const u8*)ptr;
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+#define LW(x) lw_le(&(x))
+
 #ifdef __cplusplus
 }
 #endif